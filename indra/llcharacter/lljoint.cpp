@@ -57,8 +57,12 @@ JointKey JointKey::construct( std::string aName )
 }
 // </FS:ND>
 
-S32 LLJoint::sNumUpdates = 0;
-S32 LLJoint::sNumTouches = 0;
+// <FS> Parallel avatar animation
+//S32 LLJoint::sNumUpdates = 0;
+//S32 LLJoint::sNumTouches = 0;
+thread_local S32 LLJoint::sNumUpdates = 0;
+thread_local S32 LLJoint::sNumTouches = 0;
+// </FS>
 
 template <class T> 
 bool attachment_map_iter_compare_key(const T& a, const T& b)
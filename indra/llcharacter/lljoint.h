@@ -175,8 +175,12 @@ public:
 	joints_t mChildren;
 
 	// debug statics
-	static S32		sNumTouches;
-	static S32		sNumUpdates;
+	// <FS> Parallel avatar animation: skeletons are also updated on worker threads, count per thread
+	//static S32		sNumTouches;
+	//static S32		sNumUpdates;
+	static thread_local S32	sNumTouches;
+	static thread_local S32	sNumUpdates;
+	// </FS>
     typedef std::set<std::string> debug_joint_name_t;
     static debug_joint_name_t s_debugJointNames;
     static void setDebugJointNames(const debug_joint_name_t& names);
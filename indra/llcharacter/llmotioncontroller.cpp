@@ -141,6 +141,8 @@ LLMotionController::LLMotionController()
 	  mTimeStepCount(0),
 	  mLastInterp(0.f),
 	  mIsSelf(FALSE),
+	  mDeferPoseBlend(false), // <FS> Parallel avatar animation
+	  mPoseBlendPending(false), // <FS> Parallel avatar animation
 	  mLastCountAfterPurge(0)
 {
 }
@@ -833,6 +835,11 @@ void LLMotionController::updateMotions(bool force_update)
     // Currently setting mTimeStep to nonzero is disabled elsewhere.
 	BOOL use_quantum = (mTimeStep != 0.f);
 
+	// <FS> Parallel avatar animation
+	// A blend deferred by a batch that never got to apply it belongs to the last frame.
+	applyPendingPoseBlend();
+	// </FS>
+
 	// Always update mPrevTimerElapsed
 	F32 cur_time = mTimer.getElapsedTimeF32();
 	F32 delta_time = cur_time - mPrevTimerElapsed;
@@ -906,6 +913,12 @@ void LLMotionController::updateMotions(bool force_update)
 		{
 			mPoseBlender.blendAndCache(TRUE);
 		}
+		// <FS> Parallel avatar animation
+		else if (mDeferPoseBlend)
+		{
+			mPoseBlendPending = true;
+		}
+		// </FS>
 		else
 		{
 			mPoseBlender.blendAndApply();
@@ -916,6 +929,21 @@ void LLMotionController::updateMotions(bool force_update)
 //	LL_INFOS() << "Motion controller time " << motionTimer.getElapsedTimeF32() << LL_ENDL;
 }
 
+// <FS> Parallel avatar animation
+//-----------------------------------------------------------------------------
+// applyPendingPoseBlend()
+//-----------------------------------------------------------------------------
+void LLMotionController::applyPendingPoseBlend()
+{
+	if (mPoseBlendPending)
+	{
+		LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+		mPoseBlender.blendAndApply();
+		mPoseBlendPending = false;
+	}
+}
+// </FS>
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
@@ -137,6 +137,16 @@ public:
 
 	void clearBlenders() { mPoseBlender.clearBlenders(); }
 
+	// <FS> Parallel avatar animation
+	// While set, updateMotions() leaves the final pose blend pending instead of
+	// applying it, so it can be applied later, possibly on another thread.
+	void setDeferPoseBlend(bool defer) { mDeferPoseBlend = defer; }
+	bool hasPendingPoseBlend() const { return mPoseBlendPending; }
+	// Applies a pending pose blend to the skeleton. Only touches this
+	// controller's blenders and the joints of its character.
+	void applyPendingPoseBlend();
+	// </FS>
+
 	// flush motions
 	// releases all motion instances
 	void flushAllMotions();
@@ -232,6 +242,11 @@ protected:
 	F32					mLastInterp;
 
 	U8					mJointSignature[2][LL_CHARACTER_MAX_ANIMATED_JOINTS];
+
+	// <FS> Parallel avatar animation
+	bool				mDeferPoseBlend;
+	bool				mPoseBlendPending;
+	// </FS>
 private:
 	U32					mLastCountAfterPurge; //for logging and debugging purposes
 };
@@ -0,0 +1,408 @@
+/**
+ * @file llposeblender_test.cpp
+ * @brief Pose blending and skeleton updates of many synthetic avatars,
+ * one after another and spread over a thread pool.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lljoint.h"
+#include "../lljointstate.h"
+#include "../llmotion.h"
+#include "../llpose.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../../llcommon/llparalleljobs.h"
+#include "../../llcommon/lltimer.h"
+#include "../../llcommon/threadpool.h"
+#include "../test/lltut.h"
+
+namespace
+{
+	const F32 CLIP_FPS = 30.f;
+
+	// Joint rotations and pelvis offsets sampled at CLIP_FPS, the way a
+	// keyframe motion holds them after loading
+	struct CapturedClip
+	{
+		U32							mFrameCount;
+		U32							mJointCount;
+		std::vector<LLQuaternion>	mRotations;		// mJointCount per frame
+		std::vector<LLVector3>		mPelvisOffsets;	// one per frame
+	};
+
+	CapturedClip capture_clip(U32 seed, U32 joint_count, U32 frame_count, F32 amplitude)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<F32> phase(0.f, F_TWO_PI);
+		std::uniform_real_distribution<F32> cycles(1.f, 3.f);
+
+		CapturedClip clip;
+		clip.mFrameCount = frame_count;
+		clip.mJointCount = joint_count;
+		for (U32 j = 0; j < joint_count; j++)
+		{
+			const F32 roll_phase = phase(random), pitch_phase = phase(random), yaw_phase = phase(random);
+			const F32 speed = cycles(random) * F_TWO_PI / (F32)frame_count;
+			for (U32 f = 0; f < frame_count; f++)
+			{
+				const F32 t = speed * (F32)f;
+				LLQuaternion rot;
+				rot.setEulerAngles(amplitude * sinf(t + roll_phase),
+								   amplitude * sinf(t + pitch_phase),
+								   amplitude * 0.5f * sinf(t + yaw_phase));
+				clip.mRotations.push_back(rot);
+			}
+		}
+		for (U32 f = 0; f < frame_count; f++)
+		{
+			const F32 t = F_TWO_PI * (F32)f / (F32)frame_count;
+			clip.mPelvisOffsets.push_back(LLVector3(0.f, 0.02f * sinf(t), 0.05f * sinf(2.f * t)));
+		}
+		return clip;
+	}
+
+	// Loops a captured clip on the bones of one avatar
+	class LLClipMotion : public LLMotion
+	{
+	public:
+		LLClipMotion(const CapturedClip& clip, const std::vector<LLJoint*>& bones,
+					 LLJoint::JointPriority priority, LLMotionBlendType blend_type, F32 weight)
+		:	LLMotion(LLUUID::null),
+			mClip(clip),
+			mPriority(priority),
+			mBlendType(blend_type)
+		{
+			for (U32 j = 0; j < mClip.mJointCount; j++)
+			{
+				LLPointer<LLJointState> state = new LLJointState(bones[j]);
+				state->setUsage(j == 0 ? LLJointState::POS | LLJointState::ROT : LLJointState::ROT);
+				state->setWeight(weight);
+				addJointState(state);
+				mStates.push_back(state);
+			}
+		}
+
+		BOOL getLoop() { return TRUE; }
+		F32 getDuration() { return (F32)mClip.mFrameCount / CLIP_FPS; }
+		F32 getEaseInDuration() { return 0.f; }
+		F32 getEaseOutDuration() { return 0.f; }
+		LLJoint::JointPriority getPriority() { return mPriority; }
+		LLMotionBlendType getBlendType() { return mBlendType; }
+		F32 getMinPixelArea() { return 0.f; }
+		LLMotionInitStatus onInitialize(LLCharacter*) { return STATUS_SUCCESS; }
+		BOOL onActivate() { return TRUE; }
+		void onDeactivate() {}
+
+		BOOL onUpdate(F32 time, U8* joint_mask)
+		{
+			const F32 frame = fmodf(time * CLIP_FPS, (F32)mClip.mFrameCount);
+			const U32 f0 = (U32)frame;
+			const U32 f1 = (f0 + 1) % mClip.mFrameCount;
+			const F32 u = frame - (F32)f0;
+
+			for (U32 j = 0; j < mClip.mJointCount; j++)
+			{
+				const LLQuaternion* rotations = &mClip.mRotations[j * mClip.mFrameCount];
+				mStates[j]->setRotation(nlerp(u, rotations[f0], rotations[f1]));
+			}
+			mStates[0]->setPosition(lerp(mClip.mPelvisOffsets[f0], mClip.mPelvisOffsets[f1], u));
+			return TRUE;
+		}
+
+	private:
+		const CapturedClip&					mClip;
+		LLJoint::JointPriority				mPriority;
+		LLMotionBlendType					mBlendType;
+		std::vector<LLPointer<LLJointState> > mStates;
+	};
+
+	// A reduced Bento skeleton: the animated bones, plus one collision
+	// volume or attachment point under every bone, which only follow.
+	struct SyntheticAvatar
+	{
+		// Parent of each bone, -1 for the pelvis
+		static std::vector<S32> boneParents()
+		{
+			std::vector<S32> parents(1, -1);
+			const auto chain = [&parents](S32 parent, U32 length)
+			{
+				for (U32 i = 0; i < length; i++)
+				{
+					parents.push_back(parent);
+					parent = (S32)parents.size() - 1;
+				}
+				return parent;
+			};
+			const S32 chest = chain(0, 4);
+			const S32 head = chain(chest, 2);
+			chain(head, 1);						// left eye
+			chain(head, 1);						// right eye
+			for (U32 side = 0; side < 2; side++)
+			{
+				const S32 wrist = chain(chest, 4);	// collar, shoulder, elbow, wrist
+				for (U32 finger = 0; finger < 5; finger++)
+				{
+					chain(wrist, 3);
+				}
+				chain(0, 5);					// hip, knee, ankle, foot, toe
+			}
+			return parents;
+		}
+
+		SyntheticAvatar(const std::vector<CapturedClip>& clips, F32 time_offset)
+		:	mTimeOffset(time_offset)
+		{
+			const std::vector<S32> parents = boneParents();
+			mRoot = new LLJoint(-1);
+			mRoot->setup("mRoot");
+			mJoints.push_back(mRoot);
+			for (U32 i = 0; i < parents.size(); i++)
+			{
+				LLJoint* bone = new LLJoint((S32)i);
+				bone->setup("bone" + std::to_string(i), parents[i] < 0 ? mRoot : mBones[parents[i]]);
+				bone->setPosition(LLVector3(0.f, 0.f, 0.1f));
+				mBones.push_back(bone);
+				mJoints.push_back(bone);
+			}
+			for (U32 i = 0; i < parents.size(); i++)
+			{
+				LLJoint* follower = new LLJoint(-1);
+				follower->setup("follower" + std::to_string(i), mBones[i]);
+				follower->setPosition(LLVector3(0.05f, 0.f, 0.f));
+				mJoints.push_back(follower);
+			}
+
+			// Two full body base motions blended at the same priority, and
+			// an additive one, like a stand and a walk with breathing on top
+			mMotions.push_back(new LLClipMotion(clips[0], mBones, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 0.7f));
+			mMotions.push_back(new LLClipMotion(clips[1], mBones, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 0.3f));
+			mMotions.push_back(new LLClipMotion(clips[2], mBones, LLJoint::ADDITIVE_PRIORITY, LLMotion::ADDITIVE_BLEND, 1.f));
+		}
+
+		~SyntheticAvatar()
+		{
+			mBlender.clearBlenders();
+			for (LLMotion* motion : mMotions)
+			{
+				delete motion;
+			}
+			for (auto it = mJoints.rbegin(); it != mJoints.rend(); ++it)
+			{
+				delete *it;
+			}
+		}
+
+		// What LLMotionController::updateMotions() does on the main thread
+		void evaluateMotions(F32 time)
+		{
+			for (LLMotion* motion : mMotions)
+			{
+				motion->onUpdate(time + mTimeOffset, NULL);
+				mBlender.addMotion(motion);
+			}
+		}
+
+		// What a deferred pose blend and the skeleton update do on any thread
+		void updateSkeleton()
+		{
+			mBlender.blendAndApply();
+			mRoot->updateWorldMatrixChildren();
+		}
+
+		F32						mTimeOffset;
+		LLJoint*				mRoot;
+		std::vector<LLJoint*>	mBones;
+		std::vector<LLJoint*>	mJoints;	// all of them, parents first
+		std::vector<LLMotion*>	mMotions;
+		LLPoseBlender			mBlender;
+	};
+
+	typedef std::vector<std::unique_ptr<SyntheticAvatar> > avatar_list_t;
+
+	// What FSAvatarAnimationBatch::run() does with the skeleton updates of
+	// the batched avatars
+	void update_skeletons_threaded(const std::string& queue_name, const avatar_list_t& avatars)
+	{
+		LL::runParallelJobs((U32)avatars.size(), [&avatars](U32 i)
+			{
+				avatars[i]->updateSkeleton();
+			},
+			LL::PARALLEL_JOB_HELPERS, queue_name);
+	}
+}
+
+namespace tut
+{
+	struct llposeblender_data
+	{
+		static const U32 AVATAR_COUNT = 200;
+		static const U32 FRAME_COUNT = 30;
+		static const U32 HELPER_THREADS = LL::PARALLEL_JOB_HELPERS;
+
+		llposeblender_data()
+		{
+			const U32 bones = (U32)SyntheticAvatar::boneParents().size();
+			mClips.push_back(capture_clip(1, bones, 60, 0.3f));
+			mClips.push_back(capture_clip(2, bones, 32, 0.5f));
+			mClips.push_back(capture_clip(3, bones, 120, 0.05f));
+		}
+
+		void makeAvatars(avatar_list_t& avatars) const
+		{
+			for (U32 i = 0; i < AVATAR_COUNT; i++)
+			{
+				avatars.emplace_back(new SyntheticAvatar(mClips, 0.037f * (F32)i));
+			}
+		}
+
+		std::vector<CapturedClip> mClips;
+	};
+	typedef test_group<llposeblender_data> llposeblender_test;
+	typedef llposeblender_test::object llposeblender_object;
+	tut::llposeblender_test llposeblender_testcase("LLPoseBlender");
+
+	template<> template<>
+	void llposeblender_object::test<1>()
+	{
+		set_test_name("one full weight motion sets its rotations");
+
+		SyntheticAvatar avatar(mClips, 0.f);
+		// Only the first base motion
+		avatar.mMotions[0]->getPose()->setWeight(1.f);
+		avatar.mMotions[1]->getPose()->setWeight(0.f);
+		avatar.mMotions[2]->getPose()->setWeight(0.f);
+
+		avatar.evaluateMotions(0.5f);
+		avatar.updateSkeleton();
+
+		const U32 frame = 15;
+		for (U32 j = 0; j < avatar.mBones.size(); j++)
+		{
+			const LLQuaternion& expected = mClips[0].mRotations[j * mClips[0].mFrameCount + frame];
+			const LLQuaternion& rot = avatar.mBones[j]->getRotation();
+			for (U32 k = 0; k < 4; k++)
+			{
+				ensure_approximately_equals_range("bone rotation", rot.mQ[k], expected.mQ[k], 1e-5f);
+			}
+		}
+	}
+
+	template<> template<>
+	void llposeblender_object::test<2>()
+	{
+		set_test_name("threaded skeleton updates match serial ones");
+
+		avatar_list_t serial, threaded;
+		makeAvatars(serial);
+		makeAvatars(threaded);
+
+		LL::ThreadPool pool("LLPoseBlenderTest", HELPER_THREADS);
+		pool.start();
+
+		for (U32 f = 0; f < 3; f++)
+		{
+			const F32 time = (F32)f / CLIP_FPS;
+			for (U32 i = 0; i < AVATAR_COUNT; i++)
+			{
+				serial[i]->evaluateMotions(time);
+				serial[i]->updateSkeleton();
+				threaded[i]->evaluateMotions(time);
+			}
+			update_skeletons_threaded("LLPoseBlenderTest", threaded);
+		}
+		pool.close();
+
+		for (U32 i = 0; i < AVATAR_COUNT; i++)
+		{
+			for (U32 j = 0; j < serial[i]->mJoints.size(); j++)
+			{
+				const LLMatrix4& a = serial[i]->mJoints[j]->getWorldMatrix();
+				const LLMatrix4& b = threaded[i]->mJoints[j]->getWorldMatrix();
+				for (U32 r = 0; r < 4; r++)
+				{
+					for (U32 c = 0; c < 4; c++)
+					{
+						ensure_equals("world matrix", a.mMatrix[r][c], b.mMatrix[r][c]);
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void llposeblender_object::test<3>()
+	{
+		set_test_name("benchmark animating 200 avatars");
+
+		avatar_list_t avatars;
+		makeAvatars(avatars);
+
+		LL::ThreadPool pool("LLPoseBlenderBench", HELPER_THREADS);
+		pool.start();
+
+		F64 evaluate_time = 0.0, serial_time = 0.0, threaded_time = 0.0;
+		LLTimer timer;
+		for (U32 f = 0; f < FRAME_COUNT; f++)
+		{
+			const F32 time = (F32)f / CLIP_FPS;
+
+			timer.reset();
+			for (const auto& avatar : avatars)
+			{
+				avatar->evaluateMotions(time);
+			}
+			evaluate_time += timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (const auto& avatar : avatars)
+			{
+				avatar->updateSkeleton();
+			}
+			serial_time += timer.getElapsedTimeF64();
+
+			// The same work again, the skeletons only differ in their dirty joints
+			for (const auto& avatar : avatars)
+			{
+				avatar->evaluateMotions(time + 0.5f / CLIP_FPS);
+			}
+			timer.reset();
+			update_skeletons_threaded("LLPoseBlenderBench", avatars);
+			threaded_time += timer.getElapsedTimeF64();
+		}
+		pool.close();
+
+		ensure("skeletons updated", avatars[0]->mBones[1]->getWorldPosition() != LLVector3::zero);
+
+		LL_INFOS("LLPoseBlender") << AVATAR_COUNT << " avatars, " << avatars[0]->mJoints.size()
+								  << " joints each, per frame: motions " << evaluate_time * 1000.0 / FRAME_COUNT
+								  << " ms, blend and skeleton serial " << serial_time * 1000.0 / FRAME_COUNT
+								  << " ms, on " << HELPER_THREADS << " pool threads and the caller "
+								  << threaded_time * 1000.0 / FRAME_COUNT << " ms" << LL_ENDL;
+	}
+}
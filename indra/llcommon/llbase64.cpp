@@ -33,6 +33,10 @@
 
 #include "apr_base64.h"
 
+// <FS> SIMD base64
+#include <emmintrin.h>
+// </FS>
+
 
 // static
 std::string LLBase64::encode(const U8* input, size_t input_size)
@@ -41,21 +45,239 @@ std::string LLBase64::encode(const U8* input, size_t input_size)
 	if (input
 		&& input_size > 0)
 	{
-		// Yes, it returns int.
-		int b64_buffer_length = apr_base64_encode_len(input_size);
-		char* b64_buffer = new char[b64_buffer_length];
-		
-		// This is faster than apr_base64_encode() if you know
-		// you're not on an EBCDIC machine.  Also, the output is
-		// null terminated, even though the documentation doesn't
-		// specify.  See apr_base64.c for details. JC
-		b64_buffer_length = apr_base64_encode_binary(
-			b64_buffer,
-			input,
-			input_size);
-		output.assign(b64_buffer);
-		delete[] b64_buffer;
+		// <FS> SIMD base64
+		//// Yes, it returns int.
+		//int b64_buffer_length = apr_base64_encode_len(input_size);
+		//char* b64_buffer = new char[b64_buffer_length];
+		//
+		//// This is faster than apr_base64_encode() if you know
+		//// you're not on an EBCDIC machine.  Also, the output is
+		//// null terminated, even though the documentation doesn't
+		//// specify.  See apr_base64.c for details. JC
+		//b64_buffer_length = apr_base64_encode_binary(
+		//	b64_buffer,
+		//	input,
+		//	input_size);
+		//output.assign(b64_buffer);
+		//delete[] b64_buffer;
+		output.resize(encodeLength(input_size));
+		encode(input, input_size, &output[0]);
+		// </FS>
 	}
 	return output;
 }
 
+// <FS> SIMD base64
+// Same alphabet and padding as apr_base64. The SSE2 paths handle 12 bytes
+// (16 characters) at a time; SSE2 is the viewer's baseline, see llsimdmath.h.
+namespace
+{
+	const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	const S8 DECODE_INVALID = -1;
+	const S8 DECODE_SPACE = -2;
+
+	struct DecodeTable
+	{
+		DecodeTable()
+		{
+			memset(mValues, DECODE_INVALID, sizeof(mValues));
+			for (S32 i = 0; i < 64; ++i)
+			{
+				mValues[(U8)BASE64_CHARS[i]] = (S8)i;
+			}
+			// What boost's \s matched when the XML parser stripped whitespace with a regex
+			mValues[(U8)' '] = mValues[(U8)'\t'] = mValues[(U8)'\n'] = DECODE_SPACE;
+			mValues[(U8)'\v'] = mValues[(U8)'\f'] = mValues[(U8)'\r'] = DECODE_SPACE;
+		}
+
+		S8 mValues[256];
+	};
+
+	const DecodeTable& getDecodeTable()
+	{
+		static const DecodeTable table;
+		return table;
+	}
+
+	// Turns 16 six bit values into their base64 characters.
+	inline __m128i encodeChars(__m128i values)
+	{
+		// 'A' + value for 0..25, then correct the offset for each range above
+		__m128i offset = _mm_set1_epi8('A');
+		offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(25)),
+													_mm_set1_epi8('a' - 26 - 'A')));
+		offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(51)),
+													_mm_set1_epi8(('0' - 52) - ('a' - 26))));
+		offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(62)),
+													_mm_set1_epi8(('+' - 62) - ('0' - 52))));
+		offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpeq_epi8(values, _mm_set1_epi8(63)),
+													_mm_set1_epi8(('/' - 63) - ('0' - 52))));
+		return _mm_add_epi8(values, offset);
+	}
+
+	// 12 bytes in, 16 characters out.
+	inline void encodeBlock(const U8* in, char* out)
+	{
+		// One 24 bit group per lane, first byte highest
+		__m128i groups = _mm_set_epi32(
+			(in[9] << 16) | (in[10] << 8) | in[11],
+			(in[6] << 16) | (in[7] << 8) | in[8],
+			(in[3] << 16) | (in[4] << 8) | in[5],
+			(in[0] << 16) | (in[1] << 8) | in[2]);
+
+		// Spread the four six bit values of each group over the bytes of its lane
+		__m128i values = _mm_and_si128(_mm_srli_epi32(groups, 18), _mm_set1_epi32(0x0000003f));
+		values = _mm_or_si128(values, _mm_and_si128(_mm_srli_epi32(groups, 4), _mm_set1_epi32(0x00003f00)));
+		values = _mm_or_si128(values, _mm_and_si128(_mm_slli_epi32(groups, 10), _mm_set1_epi32(0x003f0000)));
+		values = _mm_or_si128(values, _mm_and_si128(_mm_slli_epi32(groups, 24), _mm_set1_epi32(0x3f000000)));
+
+		_mm_storeu_si128((__m128i*)out, encodeChars(values));
+	}
+
+	// 16 characters in, 12 bytes out. Returns false without writing anything
+	// if any of the characters is not base64.
+	inline bool decodeBlock(const char* in, U8* out)
+	{
+		const __m128i chars = _mm_loadu_si128((const __m128i*)in);
+
+		const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)),
+											_mm_cmplt_epi8(chars, _mm_set1_epi8('Z' + 1)));
+		const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)),
+											_mm_cmplt_epi8(chars, _mm_set1_epi8('z' + 1)));
+		const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+											_mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+		const __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+		const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+		const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+		if (_mm_movemask_epi8(valid) != 0xffff)
+		{
+			return false;
+		}
+
+		__m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+		shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+		shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+		shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+		shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+		const __m128i values = _mm_add_epi8(chars, shift);
+
+		// Pack the four six bit values of each lane into one 24 bit group
+		__m128i groups = _mm_slli_epi32(_mm_and_si128(values, _mm_set1_epi32(0x0000003f)), 18);
+		groups = _mm_or_si128(groups, _mm_slli_epi32(_mm_and_si128(values, _mm_set1_epi32(0x00003f00)), 4));
+		groups = _mm_or_si128(groups, _mm_srli_epi32(_mm_and_si128(values, _mm_set1_epi32(0x003f0000)), 10));
+		groups = _mm_or_si128(groups, _mm_srli_epi32(values, 24));
+
+		U32 lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, groups);
+		for (S32 i = 0; i < 4; ++i)
+		{
+			out[0] = (U8)(lanes[i] >> 16);
+			out[1] = (U8)(lanes[i] >> 8);
+			out[2] = (U8)lanes[i];
+			out += 3;
+		}
+		return true;
+	}
+}
+
+// static
+size_t LLBase64::encode(const U8* input, size_t input_size, char* output)
+{
+	const char* start = output;
+	while (input_size >= 12)
+	{
+		encodeBlock(input, output);
+		input += 12;
+		input_size -= 12;
+		output += 16;
+	}
+	while (input_size >= 3)
+	{
+		*output++ = BASE64_CHARS[input[0] >> 2];
+		*output++ = BASE64_CHARS[((input[0] & 0x03) << 4) | (input[1] >> 4)];
+		*output++ = BASE64_CHARS[((input[1] & 0x0f) << 2) | (input[2] >> 6)];
+		*output++ = BASE64_CHARS[input[2] & 0x3f];
+		input += 3;
+		input_size -= 3;
+	}
+	if (input_size > 0)
+	{
+		*output++ = BASE64_CHARS[input[0] >> 2];
+		if (input_size == 1)
+		{
+			*output++ = BASE64_CHARS[(input[0] & 0x03) << 4];
+			*output++ = '=';
+		}
+		else
+		{
+			*output++ = BASE64_CHARS[((input[0] & 0x03) << 4) | (input[1] >> 4)];
+			*output++ = BASE64_CHARS[(input[1] & 0x0f) << 2];
+		}
+		*output++ = '=';
+	}
+	return output - start;
+}
+
+// static
+void LLBase64::decode(const char* input, size_t input_size, std::vector<U8>& output)
+{
+	output.resize(input_size / 4 * 3 + 3);
+	U8* const begin = &output[0];
+	U8* out = begin;
+	const S8* table = getDecodeTable().mValues;
+
+	U32 group = 0;
+	S32 group_chars = 0;
+	// After a block that was not all base64 the next few characters go the
+	// slow way, so a line break does not make every position try a block.
+	size_t scalar_until = 0;
+	size_t i = 0;
+	while (i < input_size)
+	{
+		if (group_chars == 0 && i >= scalar_until && input_size - i >= 16)
+		{
+			if (decodeBlock(input + i, out))
+			{
+				i += 16;
+				out += 12;
+				continue;
+			}
+			scalar_until = i + 16;
+		}
+
+		const S8 value = table[(U8)input[i++]];
+		if (value < 0)
+		{
+			if (value == DECODE_SPACE)
+			{
+				continue;
+			}
+			// Padding or garbage ends it, as for apr_base64_decode_binary()
+			break;
+		}
+		group = (group << 6) | value;
+		if (++group_chars == 4)
+		{
+			*out++ = (U8)(group >> 16);
+			*out++ = (U8)(group >> 8);
+			*out++ = (U8)group;
+			group = 0;
+			group_chars = 0;
+		}
+	}
+
+	// A partial group still holds whole bytes; a single character does not
+	if (group_chars == 2)
+	{
+		*out++ = (U8)(group >> 4);
+	}
+	else if (group_chars == 3)
+	{
+		*out++ = (U8)(group >> 10);
+		*out++ = (U8)(group >> 2);
+	}
+	output.resize(out - begin);
+}
+// </FS>
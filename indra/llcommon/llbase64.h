@@ -28,10 +28,31 @@
 #ifndef LLBASE64_H
 #define LLBASE64_H
 
+// <FS> SIMD base64
+#include <vector>
+// </FS>
+
 class LL_COMMON_API LLBase64
 {
 public:
 	static std::string encode(const U8* input, size_t input_size);
+
+	// <FS> SIMD base64
+	// Number of characters encode() writes for input_size bytes, padding included.
+	static size_t encodeLength(size_t input_size)	{ return (input_size + 2) / 3 * 4; }
+	// Writes encodeLength(input_size) characters to output, without a
+	// terminating null, and returns how many that was.
+	static size_t encode(const U8* input, size_t input_size, char* output);
+
+	// Decodes up to the padding or the first character that is not base64.
+	// Whitespace in between is skipped, as it shows up in line wrapped
+	// base64 from other systems.
+	static void decode(const char* input, size_t input_size, std::vector<U8>& output);
+	static void decode(const std::string& input, std::vector<U8>& output)
+	{
+		decode(input.data(), input.size(), output);
+	}
+	// </FS>
 };
 
 #endif
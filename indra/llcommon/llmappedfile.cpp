@@ -0,0 +1,242 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Cross platform wrapper around a memory-mapped file.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llmappedfile.h"
+#include "llstring.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+:	mData(nullptr),
+	mSize(0),
+	mWritable(false),
+#if LL_WINDOWS
+	mFileHandle(INVALID_HANDLE_VALUE),
+	mMappingHandle(nullptr)
+#else
+	mFileDescriptor(-1)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+	close();
+}
+
+bool LLMappedFile::open(const std::string& filename, size_t min_size, bool writable)
+{
+	close();
+
+	mFilename = filename;
+	mWritable = writable;
+
+	size_t file_size = 0;
+#if LL_WINDOWS
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	HANDLE file = CreateFileW(utf16filename.c_str(),
+							  writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+							  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+							  nullptr,
+							  writable ? OPEN_ALWAYS : OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL,
+							  nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		LL_WARNS("LLMappedFile") << "Unable to open " << filename << " error: " << GetLastError() << LL_ENDL;
+		return false;
+	}
+	mFileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		LL_WARNS("LLMappedFile") << "Unable to get size of " << filename << " error: " << GetLastError() << LL_ENDL;
+		close();
+		return false;
+	}
+	file_size = (size_t)size.QuadPart;
+#else
+	mFileDescriptor = ::open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0600);
+	if (mFileDescriptor < 0)
+	{
+		LL_WARNS("LLMappedFile") << "Unable to open " << filename << " errno: " << errno << LL_ENDL;
+		return false;
+	}
+
+	struct stat file_stat;
+	if (fstat(mFileDescriptor, &file_stat) != 0)
+	{
+		LL_WARNS("LLMappedFile") << "Unable to get size of " << filename << " errno: " << errno << LL_ENDL;
+		close();
+		return false;
+	}
+	file_size = (size_t)file_stat.st_size;
+#endif
+
+	if (writable && file_size < min_size)
+	{
+		file_size = min_size;
+	}
+
+	if (!file_size || !map(file_size))
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void LLMappedFile::close()
+{
+	unmap();
+
+#if LL_WINDOWS
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle((HANDLE)mFileHandle);
+		mFileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mFileDescriptor >= 0)
+	{
+		::close(mFileDescriptor);
+		mFileDescriptor = -1;
+	}
+#endif
+
+	mWritable = false;
+}
+
+bool LLMappedFile::resize(size_t new_size)
+{
+	if (!mWritable || !new_size)
+	{
+		return false;
+	}
+
+	unmap();
+	return map(new_size);
+}
+
+bool LLMappedFile::flush()
+{
+	if (!mData || !mWritable)
+	{
+		return false;
+	}
+
+#if LL_WINDOWS
+	return FlushViewOfFile(mData, 0) != 0;
+#else
+	return msync(mData, mSize, MS_ASYNC) == 0;
+#endif
+}
+
+bool LLMappedFile::map(size_t size)
+{
+#if LL_WINDOWS
+	if (mWritable)
+	{
+		// Set the exact file size so shrinking works too; CreateFileMapping
+		// would only ever grow the file.
+		LARGE_INTEGER distance;
+		distance.QuadPart = (LONGLONG)size;
+		if (!SetFilePointerEx((HANDLE)mFileHandle, distance, nullptr, FILE_BEGIN) || !SetEndOfFile((HANDLE)mFileHandle))
+		{
+			LL_WARNS("LLMappedFile") << "Unable to resize " << mFilename << " to " << size << " bytes, error: " << GetLastError() << LL_ENDL;
+			return false;
+		}
+	}
+
+	mMappingHandle = CreateFileMappingW((HANDLE)mFileHandle, nullptr, mWritable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (!mMappingHandle)
+	{
+		LL_WARNS("LLMappedFile") << "CreateFileMapping failed for " << mFilename << " error: " << GetLastError() << LL_ENDL;
+		return false;
+	}
+
+	mData = (U8*)MapViewOfFile((HANDLE)mMappingHandle, mWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+	if (!mData)
+	{
+		LL_WARNS("LLMappedFile") << "MapViewOfFile failed for " << mFilename << " error: " << GetLastError() << LL_ENDL;
+		CloseHandle((HANDLE)mMappingHandle);
+		mMappingHandle = nullptr;
+		return false;
+	}
+#else
+	if (mWritable && ftruncate(mFileDescriptor, (off_t)size) != 0)
+	{
+		LL_WARNS("LLMappedFile") << "Unable to resize " << mFilename << " to " << size << " bytes, errno: " << errno << LL_ENDL;
+		return false;
+	}
+
+	void* address = ::mmap(nullptr, size, mWritable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, mFileDescriptor, 0);
+	if (address == MAP_FAILED)
+	{
+		LL_WARNS("LLMappedFile") << "mmap failed for " << mFilename << " errno: " << errno << LL_ENDL;
+		return false;
+	}
+	mData = (U8*)address;
+#endif
+
+	mSize = size;
+	return true;
+}
+
+void LLMappedFile::unmap()
+{
+#if LL_WINDOWS
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+	}
+	if (mMappingHandle)
+	{
+		CloseHandle((HANDLE)mMappingHandle);
+		mMappingHandle = nullptr;
+	}
+#else
+	if (mData)
+	{
+		::munmap(mData, mSize);
+	}
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+}
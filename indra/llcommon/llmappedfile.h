@@ -0,0 +1,85 @@
+/**
+ * @file llmappedfile.h
+ * @brief Cross platform wrapper around a memory-mapped file.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+
+/**
+ * Maps a whole file into the address space of the process. Used by the
+ * various viewer caches that keep fixed layout tables on disk and want to
+ * access them without parsing or rewriting the whole file.
+ *
+ * A writable mapping is shared with the file, so changes are persisted by
+ * the OS without explicit write calls; flush() only forces them out early.
+ * Any pointer obtained through getData() is invalidated by resize() and
+ * close().
+ */
+class LL_COMMON_API LLMappedFile : private boost::noncopyable
+{
+public:
+	LLMappedFile();
+	~LLMappedFile();
+
+	// Maps filename (UTF8). If writable, the file is created when missing
+	// and grown to min_size bytes when it is smaller than that. A read only
+	// mapping of a missing or empty file fails.
+	bool open(const std::string& filename, size_t min_size, bool writable);
+	void close();
+
+	// Grows or shrinks the underlying file and remaps it. Only valid for a
+	// writable mapping.
+	bool resize(size_t new_size);
+
+	// Schedules dirty pages to be written back to disk.
+	bool flush();
+
+	bool isOpen() const			{ return mData != nullptr; }
+	bool isWritable() const		{ return mWritable; }
+	U8* getData() const			{ return mData; }
+	size_t getSize() const		{ return mSize; }
+	const std::string& getFilename() const { return mFilename; }
+
+private:
+	bool map(size_t size);
+	void unmap();
+
+private:
+	std::string	mFilename;
+	U8*			mData;
+	size_t		mSize;
+	bool		mWritable;
+#if LL_WINDOWS
+	void*		mFileHandle;
+	void*		mMappingHandle;
+#else
+	int			mFileDescriptor;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
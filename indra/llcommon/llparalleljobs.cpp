@@ -0,0 +1,115 @@
+/**
+ * @file llparalleljobs.cpp
+ * @brief Runs a set of independent jobs on the calling thread and a pool.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llparalleljobs.h"
+
+#include "workqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+	// Outlives the call for helpers that start late. They find no job left
+	// and never look at mJob, which points into the caller's frame.
+	struct ParallelJobs
+	{
+		const std::function<void(U32)>*	mJob;
+		U32								mCount;
+		std::atomic<U32>				mNextJob;
+		std::atomic<U32>				mHelperJobs;
+
+		std::mutex						mDoneMutex;
+		std::condition_variable			mDoneCondition;
+		U32								mDoneJobs;
+	};
+
+	// Any thread. Claims jobs until there are none left.
+	void run_jobs(ParallelJobs& jobs, bool helper)
+	{
+		const U32 count = jobs.mCount;
+		for (U32 i = jobs.mNextJob++; i < count; i = jobs.mNextJob++)
+		{
+			(*jobs.mJob)(i);
+			if (helper)
+			{
+				++jobs.mHelperJobs;
+			}
+
+			std::lock_guard<std::mutex> lock(jobs.mDoneMutex);
+			if (++jobs.mDoneJobs == count)
+			{
+				jobs.mDoneCondition.notify_all();
+			}
+		}
+	}
+}
+
+U32 LL::runParallelJobs(U32 count, const std::function<void(U32)>& job, U32 max_helpers, const std::string& queue_name)
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	LL::WorkQueue::ptr_t queue = (count > 1 && max_helpers > 0) ? LL::WorkQueue::getInstance(queue_name) : nullptr;
+	if (!queue)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			job(i);
+		}
+		return 0;
+	}
+
+	std::shared_ptr<ParallelJobs> jobs = std::make_shared<ParallelJobs>();
+	jobs->mJob = &job;
+	jobs->mCount = count;
+	jobs->mNextJob = 0;
+	jobs->mHelperJobs = 0;
+	jobs->mDoneJobs = 0;
+
+	const U32 helpers = llmin(max_helpers, count - 1);
+	for (U32 i = 0; i < helpers; ++i)
+	{
+		if (!queue->tryPost([jobs]() { run_jobs(*jobs, true); }))
+		{
+			break;
+		}
+	}
+	run_jobs(*jobs, false);
+	{
+		std::unique_lock<std::mutex> lock(jobs->mDoneMutex);
+		jobs->mDoneCondition.wait(lock, [&jobs, count]() { return jobs->mDoneJobs == count; });
+	}
+
+	return jobs->mHelperJobs;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file llparalleljobs.h
+ * @brief Runs a set of independent jobs on the calling thread and a pool.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPARALLELJOBS_H
+#define LL_LLPARALLELJOBS_H
+
+#include "llpreprocessor.h"
+#include "stdtypes.h"
+
+#include <functional>
+#include <string>
+
+namespace LL
+{
+	// Most pool threads helping with one call, unless the caller asks otherwise
+	const U32 PARALLEL_JOB_HELPERS = 3;
+
+	/**
+	 * Calls job(0) to job(count - 1), each once, and returns when all of
+	 * them have returned. Up to max_helpers threads of the WorkQueue named
+	 * queue_name help, each claiming the next job not started yet.
+	 *
+	 * Helpers are posted with tryPost(), and the calling thread runs
+	 * whatever they do not pick up, so this never waits for a busy pool,
+	 * only for the jobs a helper is in the middle of. A helper that starts
+	 * after every job was claimed returns without calling job, so job may
+	 * refer to the caller's stack. With max_helpers 0, a single job, or no
+	 * such queue, everything runs on the calling thread.
+	 *
+	 * Returns the number of jobs the helpers ran.
+	 */
+	LL_COMMON_API U32 runParallelJobs(U32 count, const std::function<void(U32)>& job,
+									  U32 max_helpers = PARALLEL_JOB_HELPERS, const std::string& queue_name = "General");
+}
+
+#endif // LL_LLPARALLELJOBS_H
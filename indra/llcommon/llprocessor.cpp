@@ -123,6 +123,7 @@ namespace
         eSSE4_1_Features = 38,
         eSSE4_2_Features = 39,
         eSSE4a_Features = 40,
+        eAVX2_Features = 41, // <FS/> AVX2 detection
 	};
 
 	const char* cpu_feature_names[] =
@@ -170,6 +171,7 @@ namespace
         "SSE4.1 Instructions",
         "SSE4.2 Instructions",
         "SSE4a Instructions",
+        "AVX2 Instructions", // <FS/> AVX2 detection
 	};
 
 	std::string intel_CPUFamilyName(int composed_family) 
@@ -283,6 +285,13 @@ public:
         return hasExtension(cpu_feature_names[eSSE4a_Features]);
     }
 
+    // <FS> AVX2 detection
+    bool hasAVX2() const
+    {
+        return hasExtension(cpu_feature_names[eAVX2_Features]);
+    }
+    // </FS>
+
 	bool hasAltivec() const 
 	{
 		return hasExtension("Altivec"); 
@@ -512,6 +521,7 @@ private:
         {
             is_amd = true;
         }
+        bool os_saves_ymm = false; // <FS/> AVX2 detection
 
 		// Get the information associated with each valid Id
 		for(unsigned int i=0; i<=ids; ++i)
@@ -572,6 +582,13 @@ private:
                     setExtension(cpu_feature_names[eSSE4_2_Features]);
                 }
 
+                // <FS> AVX2 detection: AVX needs OSXSAVE and the OS saving the YMM registers
+                if ((cpu_info[2] & 0x18000000) == 0x18000000)
+                {
+                    os_saves_ymm = (_xgetbv(0) & 0x6) == 0x6;
+                }
+                // </FS>
+
 				unsigned int feature_info = (unsigned int) cpu_info[3];
 				for(unsigned int index = 0, bit = 1; index < eSSE3_Features; ++index, bit <<= 1)
 				{
@@ -581,6 +598,16 @@ private:
 					}
 				}
 			}
+			// <FS> AVX2 detection
+			else if (i == 7)
+			{
+				__cpuidex(cpu_info, 7, 0);
+				if ((cpu_info[1] & 0x20) && os_saves_ymm)
+				{
+					setExtension(cpu_feature_names[eAVX2_Features]);
+				}
+			}
+			// </FS>
 		}
 
 		// Calling __cpuid with 0x80000000 as the InfoType argument
@@ -789,6 +816,21 @@ private:
             // Not supposed to happen?
             setExtension(cpu_feature_names[eSSE4a_Features]);
         }
+
+        // <FS> AVX2 detection
+        char leaf7_features[1024];
+        len = sizeof(leaf7_features);
+        memset(leaf7_features, 0, len);
+        sysctlbyname("machdep.cpu.leaf7_features", (void*)leaf7_features, &len, NULL, 0);
+
+        std::string leaf7_features_str(leaf7_features);
+        leaf7_features_str = " " + leaf7_features_str + " ";
+
+        if (leaf7_features_str.find(" AVX2 ") != std::string::npos)
+        {
+            setExtension(cpu_feature_names[eAVX2_Features]);
+        }
+        // </FS>
 	}
 };
 
@@ -812,9 +854,16 @@ private:
 		LLFILE* cpuinfo_fp = LLFile::fopen(CPUINFO_FILE, "rb");
 		if(cpuinfo_fp)
 		{
-			char line[MAX_STRING];
-			memset(line, 0, MAX_STRING);
-			while(fgets(line, MAX_STRING, cpuinfo_fp))
+			// <FS> AVX2 detection: the flags line of current CPUs is far longer than MAX_STRING,
+			// a truncated line loses everything after sse4_2.
+			//char line[MAX_STRING];
+			//memset(line, 0, MAX_STRING);
+			//while(fgets(line, MAX_STRING, cpuinfo_fp))
+			const S32 MAX_CPUINFO_LINE = 8192;
+			std::vector<char> line_buffer(MAX_CPUINFO_LINE, 0);
+			char* line = line_buffer.data();
+			while(fgets(line, MAX_CPUINFO_LINE, cpuinfo_fp))
+			// </FS>
 			{
 				// /proc/cpuinfo on Linux looks like:
 				// name\t*: value\n
@@ -922,6 +971,12 @@ private:
         {
             setExtension(cpu_feature_names[eSSE4a_Features]);
         }
+
+        // <FS/> AVX2 detection; the kernel only reports it when the OS saves the YMM registers
+        if (flags.find(" avx2 ") != std::string::npos)
+        {
+            setExtension(cpu_feature_names[eAVX2_Features]);
+        }
 	}
 
 	std::string getCPUFeatureDescription() const 
@@ -985,6 +1040,7 @@ bool LLProcessorInfo::hasSSE3S() const { return mImpl->hasSSE3S(); }
 bool LLProcessorInfo::hasSSE41() const { return mImpl->hasSSE41(); }
 bool LLProcessorInfo::hasSSE42() const { return mImpl->hasSSE42(); }
 bool LLProcessorInfo::hasSSE4a() const { return mImpl->hasSSE4a(); }
+bool LLProcessorInfo::hasAVX2() const { return mImpl->hasAVX2(); } // <FS/> AVX2 detection
 bool LLProcessorInfo::hasAltivec() const { return mImpl->hasAltivec(); }
 std::string LLProcessorInfo::getCPUFamilyName() const { return mImpl->getCPUFamilyName(); }
 std::string LLProcessorInfo::getCPUBrandName() const { return mImpl->getCPUBrandName(); }
@@ -30,6 +30,8 @@
 #include "linden_common.h"
 #include "llsd.h"
 
+#include <atomic> // <FS/> Arena allocation
+
 #include "llerror.h"
 #include "../llmath/llmath.h"
 #include "llformat.h"
@@ -66,6 +68,143 @@ S32 sLLSDNetObjects = 0;
 #define	ALLOC_LLSD_OBJECT			{ llsd::sLLSDNetObjects++;	llsd::sLLSDAllocationCount++;	}
 #define	FREE_LLSD_OBJECT			{ llsd::sLLSDNetObjects--;									}
 
+// <FS> Arena allocation
+#ifdef NAME_UNNAMED_NAMESPACE
+namespace LLSDUnnamedNamespace 
+#else
+namespace 
+#endif
+{
+	// Impls made inside an LLSD::ArenaScope are carved out of these blocks
+	// back to back, each one behind a pointer to the block it lives in.
+	struct ArenaBlock
+	{
+		// Impls still alive in the block. While the owning thread is still
+		// handing out space from it this is offset by ARENA_OPEN_BIAS, so
+		// that frees on any thread can never take it to zero early.
+		std::atomic<U32>	mLive;
+		U32					mUsed;		// bytes handed out, header included
+		U32					mCount;		// Impls handed out, owning thread only
+		U32					mLastSlot;	// where the newest one starts, owning thread only
+	};
+
+	const U32 ARENA_BLOCK_SIZE = 64 * 1024;
+	const U32 ARENA_ALIGN = sizeof(ArenaBlock*);
+	const U32 ARENA_HEADER_SIZE = (sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	const U32 ARENA_OPEN_BIAS = 0x80000000;
+
+	struct ArenaState
+	{
+		ArenaBlock*	mBlock;
+		U32			mScopes;
+	};
+	thread_local ArenaState sArena = { NULL, 0 };
+
+	std::atomic<U32> sArenaBlockCount(0);
+	std::atomic<U64> sArenaBlockBytes(0);
+
+	void freeArenaBlock(ArenaBlock* block)
+	{
+		--sArenaBlockCount;
+		sArenaBlockBytes -= ARENA_BLOCK_SIZE;
+		block->~ArenaBlock();
+		::operator delete(block);
+	}
+
+	// The owning thread is done handing out space from the block: trade the
+	// bias for the number of Impls it holds. Whoever takes the count to zero,
+	// here or in releaseArenaImpl(), frees the block.
+	void closeArenaBlock(ArenaBlock* block)
+	{
+		const U32 delta = block->mCount - ARENA_OPEN_BIAS;
+		if (block->mLive.fetch_add(delta, std::memory_order_acq_rel) + delta == 0)
+		{
+			freeArenaBlock(block);
+		}
+	}
+
+	// Returns NULL when no arena is open on this thread.
+	void* allocateArenaImpl(size_t size)
+	{
+		ArenaState& arena = sArena;
+		if (!arena.mScopes)
+		{
+			return NULL;
+		}
+
+		const U32 slot = (U32)(ARENA_ALIGN + ((size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1)));
+		ArenaBlock* block = arena.mBlock;
+		if (!block || block->mUsed + slot > ARENA_BLOCK_SIZE)
+		{
+			if (block)
+			{
+				closeArenaBlock(block);
+			}
+			block = new (::operator new(ARENA_BLOCK_SIZE)) ArenaBlock;
+			block->mLive = ARENA_OPEN_BIAS;
+			block->mUsed = ARENA_HEADER_SIZE;
+			block->mCount = 0;
+			block->mLastSlot = 0;
+			++sArenaBlockCount;
+			sArenaBlockBytes += ARENA_BLOCK_SIZE;
+			arena.mBlock = block;
+		}
+
+		char* mem = reinterpret_cast<char*>(block) + block->mUsed;
+		block->mLastSlot = block->mUsed;
+		block->mUsed += slot;
+		++block->mCount;
+		*reinterpret_cast<ArenaBlock**>(mem) = block;
+		return mem + ARENA_ALIGN;
+	}
+
+	// Any thread.
+	void releaseArenaImpl(void* mem)
+	{
+		char* slot = reinterpret_cast<char*>(mem) - ARENA_ALIGN;
+		ArenaBlock* block = *reinterpret_cast<ArenaBlock**>(slot);
+
+		// The newest Impl of the block being filled, typically a temporary,
+		// gives its space back right away.
+		if (block == sArena.mBlock && block->mLastSlot
+			&& slot == reinterpret_cast<char*>(block) + block->mLastSlot)
+		{
+			block->mUsed = block->mLastSlot;
+			block->mLastSlot = 0;
+			--block->mCount;
+			return;
+		}
+
+		if (block->mLive.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			freeArenaBlock(block);
+		}
+	}
+}
+
+LLSD::ArenaScope::ArenaScope(bool enable)
+	: mEnabled(enable)
+{
+	if (mEnabled)
+	{
+		++sArena.mScopes;
+	}
+}
+
+LLSD::ArenaScope::~ArenaScope()
+{
+	if (mEnabled)
+	{
+		ArenaState& arena = sArena;
+		if (--arena.mScopes == 0 && arena.mBlock)
+		{
+			closeArenaBlock(arena.mBlock);
+			arena.mBlock = NULL;
+		}
+	}
+}
+// </FS>
+
 class LLSD::Impl
 	/**< This class is the abstract base class of the implementation of LLSD
 		 It provides the reference counting implementation, and the default
@@ -88,10 +227,19 @@ protected:
 	bool shared() const							{ return (mUseCount > 1) && (mUseCount != STATIC_USAGE_COUNT); }
 	
 	U32 mUseCount;
+	bool mInArena; // <FS/> Arena allocation
 
 public:
 	static void reset(Impl*& var, Impl* impl);
 		///< safely set var to refer to the new impl (possibly shared)
+
+	// <FS> Arena allocation
+	template<class T, typename... ARGS>
+	static T* create(ARGS&&... args);
+		///< new T(args), from this thread's arena if one is open
+	static void destroy(Impl* impl);
+		///< delete impl, however create() made it
+	// </FS>
 		
 	static       Impl& safe(      Impl*);
 	static const Impl& safe(const Impl*);
@@ -164,6 +312,46 @@ public:
 	static U32 sOutstandingCount;
 };
 
+// <FS> Arena allocation
+template<class T, typename... ARGS>
+// static
+T* LLSD::Impl::create(ARGS&&... args)
+{
+	static_assert(alignof(T) <= ARENA_ALIGN, "LLSD::Impl subclass is over aligned for the arena");
+
+	void* mem = allocateArenaImpl(sizeof(T));
+	if (!mem)
+	{
+		return new T(std::forward<ARGS>(args)...);
+	}
+
+	T* impl = NULL;
+	try
+	{
+		impl = new (mem) T(std::forward<ARGS>(args)...);
+	}
+	catch (...)
+	{
+		releaseArenaImpl(mem);
+		throw;
+	}
+	impl->mInArena = true;
+	return impl;
+}
+
+// static
+void LLSD::Impl::destroy(Impl* impl)
+{
+	if (!impl->mInArena)
+	{
+		delete impl;
+		return;
+	}
+	impl->~Impl();
+	releaseArenaImpl(impl);
+}
+// </FS>
+
 #ifdef NAME_UNNAMED_NAMESPACE
 namespace LLSDUnnamedNamespace 
 #else
@@ -365,6 +553,7 @@ namespace
 		
 	protected:
 		ImplMap(const DataMap& data) : mData(data) { }
+		friend class LLSD::Impl; // <FS/> Arena allocation, for create()
 		
 	public:
 		ImplMap() { }
@@ -403,7 +592,10 @@ namespace
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
 		if (shared())
 		{
-			ImplMap* i = new ImplMap(mData);
+			// <FS> Arena allocation
+			//ImplMap* i = new ImplMap(mData);
+			ImplMap* i = create<ImplMap>(mData);
+			// </FS>
 			Impl::assign(var, i);
 			return *i;
 		}
@@ -505,6 +697,7 @@ namespace
 		
 	protected:
 		ImplArray(const DataVector& data) : mData(data) { }
+		friend class LLSD::Impl; // <FS/> Arena allocation, for create()
 		
 	public:
 		ImplArray() { }
@@ -541,7 +734,10 @@ namespace
 	{
 		if (shared())
 		{
-			ImplArray* i = new ImplArray(mData);
+			// <FS> Arena allocation
+			//ImplArray* i = new ImplArray(mData);
+			ImplArray* i = create<ImplArray>(mData);
+			// </FS>
 			Impl::assign(var, i);
 			return *i;
 		}
@@ -648,6 +844,7 @@ namespace
 
 LLSD::Impl::Impl()
 	: mUseCount(0)
+	, mInArena(false) // <FS/> Arena allocation
 {
 	++sAllocationCount;
 	++sOutstandingCount;
@@ -655,6 +852,7 @@ LLSD::Impl::Impl()
 
 LLSD::Impl::Impl(StaticAllocationMarker)
 	: mUseCount(0)
+	, mInArena(false) // <FS/> Arena allocation
 {
 }
 
@@ -671,7 +869,10 @@ void LLSD::Impl::reset(Impl*& var, Impl* impl)
 	}
 	if (var  &&  var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
 	{
-		delete var;
+		// <FS> Arena allocation
+		//delete var;
+		destroy(var);
+		// </FS>
 	}
 	var = impl;
 }
@@ -691,14 +892,20 @@ const LLSD::Impl& LLSD::Impl::safe(const Impl* impl)
 ImplMap& LLSD::Impl::makeMap(Impl*& var)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-	ImplMap* im = new ImplMap;
+	// <FS> Arena allocation
+	//ImplMap* im = new ImplMap;
+	ImplMap* im = create<ImplMap>();
+	// </FS>
 	reset(var, im);
 	return *im;
 }
 
 ImplArray& LLSD::Impl::makeArray(Impl*& var)
 {
-	ImplArray* ia = new ImplArray;
+	// <FS> Arena allocation
+	//ImplArray* ia = new ImplArray;
+	ImplArray* ia = create<ImplArray>();
+	// </FS>
 	reset(var, ia);
 	return *ia;
 }
@@ -716,42 +923,66 @@ void LLSD::Impl::assignUndefined(Impl*& var)
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Boolean v)
 {
-	reset(var, new ImplBoolean(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplBoolean(v));
+	reset(var, create<ImplBoolean>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Integer v)
 {
-	reset(var, new ImplInteger(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplInteger(v));
+	reset(var, create<ImplInteger>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Real v)
 {
-	reset(var, new ImplReal(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplReal(v));
+	reset(var, create<ImplReal>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::String& v)
 {
-	reset(var, new ImplString(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplString(v));
+	reset(var, create<ImplString>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::UUID& v)
 {
-	reset(var, new ImplUUID(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplUUID(v));
+	reset(var, create<ImplUUID>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::Date& v)
 {
-	reset(var, new ImplDate(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplDate(v));
+	reset(var, create<ImplDate>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::URI& v)
 {
-	reset(var, new ImplURI(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplURI(v));
+	reset(var, create<ImplURI>(v));
+	// </FS>
 }
 
 void LLSD::Impl::assign(Impl*& var, const LLSD::Binary& v)
 {
-	reset(var, new ImplBinary(v));
+	// <FS> Arena allocation
+	//reset(var, new ImplBinary(v));
+	reset(var, create<ImplBinary>(v));
+	// </FS>
 }
 
 
@@ -994,6 +1225,11 @@ namespace llsd
 U32 allocationCount()								{ return LLSD::Impl::sAllocationCount; }
 U32 outstandingCount()								{ return LLSD::Impl::sOutstandingCount; }
 
+// <FS> Arena allocation
+U32 arenaBlockCount()								{ return sArenaBlockCount; }
+U64 arenaBlockBytes()								{ return sArenaBlockBytes; }
+// </FS>
+
 // Diagnostic dump of contents in an LLSD object
 void dumpStats(const LLSD& llsd)					{ LLSD::Impl::getImpl(llsd).dumpStats(); }
 
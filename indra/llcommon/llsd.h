@@ -406,6 +406,37 @@ private:
 		friend class LLSD::Impl;
 	//@}
 
+	// <FS> Arena allocation for documents built in one go
+public:
+	/** @name Arena Allocation */
+	//@{
+		/**
+		 * While an ArenaScope is alive, the values made on this thread take
+		 * their Impl from a large block shared with the other values made in
+		 * the scope, instead of one heap allocation each. A block goes back
+		 * to the heap in one piece when the last value in it is gone, so this
+		 * is meant for building a document that is dropped as a whole, like a
+		 * parse result; a single value kept from it keeps its block alive.
+		 * The values themselves behave exactly as usual and may be destroyed
+		 * on any thread. Scopes nest; only the outermost one starts an arena.
+		 */
+		class LL_COMMON_API ArenaScope
+		{
+		public:
+			/// enable = false makes a scope that does nothing, for callers
+			/// where the arena is optional
+			explicit ArenaScope(bool enable = true);
+			~ArenaScope();
+
+		private:
+			ArenaScope(const ArenaScope&);				// not implemented
+			ArenaScope& operator=(const ArenaScope&);	// not implemented
+
+			bool mEnabled;
+		};
+	//@}
+	// </FS>
+
 private:
 	/** @name Debugging Interface */
 	//@{
@@ -444,6 +475,12 @@ namespace llsd
 #endif
 //@}
 
+// <FS> Arena allocation statistics, accurate across threads
+	LL_COMMON_API U32 arenaBlockCount();	///< how many arena blocks are still allocated
+	LL_COMMON_API U64 arenaBlockBytes();	///< how many bytes those blocks take
+// </FS>
+
+
 } // namespace llsd
 
 /** QUESTIONS & TO DOS
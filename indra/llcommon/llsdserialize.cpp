@@ -324,8 +324,12 @@ static const char BINARY_FALSE_SERIAL = '0';
 /**
  * LLSDParser
  */
+// static
+std::atomic<bool> LLSDParser::sUseArena(false); // <FS/> Arena allocation
+
 LLSDParser::LLSDParser()
 	: mCheckLimits(true), mMaxBytesLeft(0), mParseLines(false)
+	, mVisitCount(0) // <FS/> Streaming parse
 {
 }
 
@@ -337,6 +341,7 @@ S32 LLSDParser::parse(std::istream& istr, LLSD& data, S32 max_bytes, S32 max_dep
 {
 	mCheckLimits = (LLSDSerialize::SIZE_UNLIMITED == max_bytes) ? false : true;
 	mMaxBytesLeft = max_bytes;
+	LLSD::ArenaScope arena(getUseArena()); // <FS/> Arena allocation
 	return doParse(istr, data, max_depth);
 }
 
@@ -346,9 +351,74 @@ S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
 {
 	mCheckLimits = false;
 	mParseLines = true;
+	LLSD::ArenaScope arena(getUseArena()); // <FS/> Arena allocation
 	return doParse(istr, data);
 }
 
+// <FS> Streaming parse
+S32 LLSDParser::visit(std::istream& istr, LLSDVisitor& visitor, S32 max_bytes, S32 max_depth)
+{
+	mCheckLimits = (LLSDSerialize::SIZE_UNLIMITED == max_bytes) ? false : true;
+	mMaxBytesLeft = max_bytes;
+	return doVisit(istr, visitor, max_depth);
+}
+
+// virtual
+S32 LLSDParser::doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	LLSD data;
+	S32 parse_count = doParse(istr, data, max_depth);
+	if (parse_count > 0)
+	{
+		visitor.walk(data);
+	}
+	return parse_count;
+}
+
+bool LLSDVisitor::walk(const LLSD& data)
+{
+	switch(data.type())
+	{
+	case LLSD::TypeMap:
+	{
+		if (!startMap(data.size())) return false;
+		LLSD::map_const_iterator iter = data.beginMap();
+		LLSD::map_const_iterator end = data.endMap();
+		for(; iter != end; ++iter)
+		{
+			if (!key((*iter).first) || !walk((*iter).second)) return false;
+		}
+		return endMap();
+	}
+
+	case LLSD::TypeArray:
+	{
+		if (!startArray(data.size())) return false;
+		LLSD::array_const_iterator iter = data.beginArray();
+		LLSD::array_const_iterator end = data.endArray();
+		for(; iter != end; ++iter)
+		{
+			if (!walk(*iter)) return false;
+		}
+		return endArray();
+	}
+
+	case LLSD::TypeBoolean:	return value(data.asBoolean());
+	case LLSD::TypeInteger:	return value(data.asInteger());
+	case LLSD::TypeReal:	return value(data.asReal());
+	case LLSD::TypeString:	return value(data.asStringRef());
+	case LLSD::TypeUUID:	return value(data.asUUID());
+	case LLSD::TypeDate:	return value(data.asDate());
+	case LLSD::TypeURI:		return value(data.asURI());
+	case LLSD::TypeBinary:	return value(data.asBinary());
+
+	case LLSD::TypeUndefined:
+	default:
+		return undefined();
+	}
+}
+// </FS>
+
 
 int LLSDParser::get(std::istream& istr) const
 {
@@ -876,6 +946,230 @@ bool LLSDNotationParser::parseBinary(std::istream& istr, LLSD& data) const
 }
 
 
+// <FS> Streaming parse
+// virtual
+S32 LLSDNotationParser::doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	mVisitCount = 0;
+	if (VISIT_FAILURE == visitValue(istr, visitor, max_depth))
+	{
+		return PARSE_FAILURE;
+	}
+	return mVisitCount;
+}
+
+LLSDParser::EVisitResult LLSDNotationParser::visitValue(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	// Same grammar as doParse()
+	char c;
+	c = istr.peek();
+	if (max_depth == 0)
+	{
+		return VISIT_FAILURE;
+	}
+	while(isspace(c))
+	{
+		// pop the whitespace.
+		c = get(istr);
+		c = istr.peek();
+	}
+	if(!istr.good())
+	{
+		return VISIT_CONTINUE;
+	}
+	++mVisitCount;
+
+	bool keep_going = true;
+	switch(c)
+	{
+	case '{':
+		return visitMap(istr, visitor, max_depth - 1);
+
+	case '[':
+		return visitArray(istr, visitor, max_depth - 1);
+
+	case '!':
+		c = get(istr);
+		keep_going = visitor.undefined();
+		break;
+
+	case '0':
+		c = get(istr);
+		keep_going = visitor.value(false);
+		break;
+
+	case '1':
+		c = get(istr);
+		keep_going = visitor.value(true);
+		break;
+
+	case 'F':
+	case 'f':
+	case 'T':
+	case 't':
+	{
+		const bool value = (c == 'T' || c == 't');
+		ignore(istr);
+		c = istr.peek();
+		if(isalpha(c))
+		{
+			LLSD data;
+			int cnt = deserialize_boolean(
+				istr,
+				data,
+				value ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL,
+				value);
+			if(PARSE_FAILURE == cnt) return VISIT_FAILURE;
+			account(cnt);
+		}
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(value);
+		break;
+	}
+
+	case 'i':
+	{
+		c = get(istr);
+		S32 integer = 0;
+		istr >> integer;
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(integer);
+		break;
+	}
+
+	case 'r':
+	{
+		c = get(istr);
+		F64 real = 0.0;
+		istr >> real;
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(real);
+		break;
+	}
+
+	case 'u':
+	{
+		c = get(istr);
+		LLUUID id;
+		istr >> id;
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(id);
+		break;
+	}
+
+	case '\"':
+	case '\'':
+	case 's':
+	{
+		std::string value;
+		int cnt = deserialize_string(istr, value, mMaxBytesLeft);
+		if((PARSE_FAILURE == cnt) || istr.fail()) return VISIT_FAILURE;
+		account(cnt);
+		keep_going = visitor.value(value);
+		break;
+	}
+
+	case 'l':
+	case 'd':
+	{
+		const bool is_uri = (c == 'l');
+		c = get(istr); // pop the 'l' or 'd'
+		c = get(istr); // pop the delimiter
+		std::string str;
+		int cnt = deserialize_string_delim(istr, str, c);
+		if((PARSE_FAILURE == cnt) || istr.fail()) return VISIT_FAILURE;
+		account(cnt);
+		keep_going = is_uri ? visitor.value(LLURI(str)) : visitor.value(LLDate(str));
+		break;
+	}
+
+	case 'b':
+	{
+		LLSD data;
+		if(!parseBinary(istr, data) || istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(data.asBinary());
+		break;
+	}
+
+	default:
+		LL_INFOS() << "Unrecognized character while parsing: int(" << (int)c
+			<< ")" << LL_ENDL;
+		return VISIT_FAILURE;
+	}
+	return keep_going ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+
+LLSDParser::EVisitResult LLSDNotationParser::visitMap(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	// map: { string:object, string:object }
+	char c = get(istr);
+	if(c != '{') return VISIT_FAILURE;
+	if(!visitor.startMap(-1)) return VISIT_STOPPED;
+
+	bool found_name = false;
+	std::string name;
+	c = get(istr);
+	while(c != '}' && istr.good())
+	{
+		if(!found_name)
+		{
+			if((c == '\"') || (c == '\'') || (c == 's'))
+			{
+				putback(istr, c);
+				found_name = true;
+				int count = deserialize_string(istr, name, mMaxBytesLeft);
+				if(PARSE_FAILURE == count) return VISIT_FAILURE;
+				account(count);
+				if(!visitor.key(name)) return VISIT_STOPPED;
+			}
+			c = get(istr);
+		}
+		else
+		{
+			if(isspace(c) || (c == ':'))
+			{
+				c = get(istr);
+				continue;
+			}
+			putback(istr, c);
+			const S32 visited = mVisitCount;
+			EVisitResult result = visitValue(istr, visitor, max_depth);
+			if(result != VISIT_CONTINUE) return result;
+			// There must be a value for every key.
+			if(mVisitCount == visited) return VISIT_FAILURE;
+			found_name = false;
+			c = get(istr);
+		}
+	}
+	if(c != '}') return VISIT_FAILURE;
+	return visitor.endMap() ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+
+LLSDParser::EVisitResult LLSDNotationParser::visitArray(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	// array: [ object, object, object ]
+	char c = get(istr);
+	if(c != '[') return VISIT_FAILURE;
+	if(!visitor.startArray(-1)) return VISIT_STOPPED;
+
+	c = get(istr);
+	while((c != ']') && istr.good())
+	{
+		if(isspace(c) || (c == ','))
+		{
+			c = get(istr);
+			continue;
+		}
+		putback(istr, c);
+		EVisitResult result = visitValue(istr, visitor, max_depth);
+		if(result != VISIT_CONTINUE) return result;
+		c = get(istr);
+	}
+	if(c != ']') return VISIT_FAILURE;
+	return visitor.endArray() ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+// </FS>
+
 /**
  * LLSDBinaryParser
  */
@@ -1093,19 +1387,580 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 		}
 		else
 		{
-			std::vector<U8> value;
-			if(size > 0)
-			{
-				value.resize(size);
-				account((int)fullread(istr, (char*)&value[0], size));
-			}
+			std::vector<U8> value;
+			if(size > 0)
+			{
+				value.resize(size);
+				account((int)fullread(istr, (char*)&value[0], size));
+			}
+			data = value;
+		}
+		if(istr.fail())
+		{
+			LL_INFOS() << "STREAM FAILURE reading binary." << LL_ENDL;
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	default:
+		parse_count = PARSE_FAILURE;
+		LL_INFOS() << "Unrecognized character while parsing: int(" << (int)c
+			<< ")" << LL_ENDL;
+		break;
+	}
+	if(PARSE_FAILURE == parse_count)
+	{
+		data.clear();
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map, S32 max_depth) const
+{
+	map = LLSD::emptyMap();
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	S32 parse_count = 0;
+	S32 count = 0;
+	char c = get(istr);
+	while(c != '}' && (count < size) && istr.good())
+	{
+		std::string name;
+		switch(c)
+		{
+		case 'k':
+			if(!parseString(istr, name))
+			{
+				return PARSE_FAILURE;
+			}
+			break;
+		case '\'':
+		case '"':
+		{
+			int cnt = deserialize_string_delim(istr, name, c);
+			if(PARSE_FAILURE == cnt) return PARSE_FAILURE;
+			account(cnt);
+			break;
+		}
+		}
+		LLSD child;
+		S32 child_count = doParse(istr, child, max_depth);
+		if(child_count > 0)
+		{
+			// There must be a value for every key, thus child_count
+			// must be greater than 0.
+			parse_count += child_count;
+			map.insert(name, child);
+		}
+		else
+		{
+			return PARSE_FAILURE;
+		}
+		++count;
+		c = get(istr);
+	}
+	if((c != '}') || (count < size))
+	{
+		// Make sure it is correctly terminated and we parsed as many
+		// as were said to be there.
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth) const
+{
+	array = LLSD::emptyArray();
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+
+	// *FIX: This would be a good place to reserve some space in the
+	// array...
+
+	S32 parse_count = 0;
+	S32 count = 0;
+	char c = istr.peek();
+	while((c != ']') && (count < size) && istr.good())
+	{
+		LLSD child;
+		S32 child_count = doParse(istr, child, max_depth);
+		if(PARSE_FAILURE == child_count)
+		{
+			return PARSE_FAILURE;
+		}
+		if(child_count)
+		{
+			parse_count += child_count;
+			array.append(child);
+		}
+		++count;
+		c = istr.peek();
+	}
+	c = get(istr);
+	if((c != ']') || (count < size))
+	{
+		// Make sure it is correctly terminated and we parsed as many
+		// as were said to be there.
+		return PARSE_FAILURE;
+	}
+	return parse_count;
+}
+
+bool LLSDBinaryParser::parseString(
+	std::istream& istr,
+	std::string& value) const
+{
+	// *FIX: This is memory inefficient.
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(mCheckLimits && (size > mMaxBytesLeft)) return false;
+	if(size < 0) return false;
+	std::vector<char> buf;
+	if(size)
+	{
+		buf.resize(size);
+		account((int)fullread(istr, &buf[0], size));
+		value.assign(buf.begin(), buf.end());
+	}
+	return true;
+}
+
+
+// <FS> Streaming parse
+// virtual
+S32 LLSDBinaryParser::doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	mVisitCount = 0;
+	if (VISIT_FAILURE == visitValue(istr, visitor, max_depth))
+	{
+		return PARSE_FAILURE;
+	}
+	return mVisitCount;
+}
+
+LLSDParser::EVisitResult LLSDBinaryParser::visitValue(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	// Same format as doParse()
+	char c;
+	c = get(istr);
+	if(!istr.good())
+	{
+		return VISIT_CONTINUE;
+	}
+	if (max_depth == 0)
+	{
+		return VISIT_FAILURE;
+	}
+	++mVisitCount;
+
+	bool keep_going = true;
+	switch(c)
+	{
+	case '{':
+		return visitMap(istr, visitor, max_depth - 1);
+
+	case '[':
+		return visitArray(istr, visitor, max_depth - 1);
+
+	case '!':
+		keep_going = visitor.undefined();
+		break;
+
+	case '0':
+		keep_going = visitor.value(false);
+		break;
+
+	case '1':
+		keep_going = visitor.value(true);
+		break;
+
+	case 'i':
+	{
+		U32 value_nbo = 0;
+		read(istr, (char*)&value_nbo, sizeof(U32));	 /*Flawfinder: ignore*/
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value((S32)ntohl(value_nbo));
+		break;
+	}
+
+	case 'r':
+	{
+		F64 real_nbo = 0.0;
+		read(istr, (char*)&real_nbo, sizeof(F64));	 /*Flawfinder: ignore*/
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(ll_ntohd(real_nbo));
+		break;
+	}
+
+	case 'u':
+	{
+		LLUUID id;
+		read(istr, (char*)(&id.mData), UUID_BYTES);	 /*Flawfinder: ignore*/
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(id);
+		break;
+	}
+
+	case '\'':
+	case '"':
+	{
+		std::string value;
+		int cnt = deserialize_string_delim(istr, value, c);
+		if((PARSE_FAILURE == cnt) || istr.fail()) return VISIT_FAILURE;
+		account(cnt);
+		keep_going = visitor.value(value);
+		break;
+	}
+
+	case 's':
+	case 'l':
+	{
+		std::string value;
+		if(!parseString(istr, value) || istr.fail()) return VISIT_FAILURE;
+		keep_going = (c == 's') ? visitor.value(value) : visitor.value(LLURI(value));
+		break;
+	}
+
+	case 'd':
+	{
+		F64 real = 0.0;
+		read(istr, (char*)&real, sizeof(F64));	 /*Flawfinder: ignore*/
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(LLDate(real));
+		break;
+	}
+
+	case 'b':
+	{
+		U32 size_nbo = 0;
+		read(istr, (char*)&size_nbo, sizeof(U32));	/*Flawfinder: ignore*/
+		S32 size = (S32)ntohl(size_nbo);
+		if(mCheckLimits && (size > mMaxBytesLeft)) return VISIT_FAILURE;
+		std::vector<U8> value;
+		if(size > 0)
+		{
+			value.resize(size);
+			account((int)fullread(istr, (char*)&value[0], size));
+		}
+		if(istr.fail()) return VISIT_FAILURE;
+		keep_going = visitor.value(value);
+		break;
+	}
+
+	default:
+		LL_INFOS() << "Unrecognized character while parsing: int(" << (int)c
+			<< ")" << LL_ENDL;
+		return VISIT_FAILURE;
+	}
+	return keep_going ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+
+LLSDParser::EVisitResult LLSDBinaryParser::visitMap(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(istr.fail()) return VISIT_FAILURE;
+	if(!visitor.startMap(size)) return VISIT_STOPPED;
+
+	S32 count = 0;
+	std::string name;
+	char c = get(istr);
+	while(c != '}' && (count < size) && istr.good())
+	{
+		name.clear();
+		switch(c)
+		{
+		case 'k':
+			if(!parseString(istr, name))
+			{
+				return VISIT_FAILURE;
+			}
+			break;
+		case '\'':
+		case '"':
+		{
+			int cnt = deserialize_string_delim(istr, name, c);
+			if(PARSE_FAILURE == cnt) return VISIT_FAILURE;
+			account(cnt);
+			break;
+		}
+		}
+		if(!visitor.key(name)) return VISIT_STOPPED;
+
+		const S32 visited = mVisitCount;
+		EVisitResult result = visitValue(istr, visitor, max_depth);
+		if(result != VISIT_CONTINUE) return result;
+		// There must be a value for every key.
+		if(mVisitCount == visited) return VISIT_FAILURE;
+		++count;
+		c = get(istr);
+	}
+	if((c != '}') || (count < size))
+	{
+		// Make sure it is correctly terminated and we parsed as many
+		// as were said to be there.
+		return VISIT_FAILURE;
+	}
+	return visitor.endMap() ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+
+LLSDParser::EVisitResult LLSDBinaryParser::visitArray(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const
+{
+	U32 value_nbo = 0;
+	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
+	S32 size = (S32)ntohl(value_nbo);
+	if(istr.fail()) return VISIT_FAILURE;
+	if(!visitor.startArray(size)) return VISIT_STOPPED;
+
+	S32 count = 0;
+	char c = istr.peek();
+	while((c != ']') && (count < size) && istr.good())
+	{
+		EVisitResult result = visitValue(istr, visitor, max_depth);
+		if(result != VISIT_CONTINUE) return result;
+		++count;
+		c = istr.peek();
+	}
+	c = get(istr);
+	if((c != ']') || (count < size))
+	{
+		// Make sure it is correctly terminated and we parsed as many
+		// as were said to be there.
+		return VISIT_FAILURE;
+	}
+	return visitor.endArray() ? VISIT_CONTINUE : VISIT_STOPPED;
+}
+// </FS>
+
+// <FS> Buffer parse
+struct LLSDBinaryParser::Buffer
+{
+	const U8* mPos;
+	const U8* mEnd;
+
+	size_t left() const		{ return mEnd - mPos; }
+
+	bool read(void* out, size_t bytes)
+	{
+		if (left() < bytes)
+		{
+			return false;
+		}
+		memcpy(out, mPos, bytes);
+		mPos += bytes;
+		return true;
+	}
+
+	bool readSize(S32& size)
+	{
+		U32 size_nbo = 0;
+		if (!read(&size_nbo, sizeof(U32)))
+		{
+			return false;
+		}
+		size = (S32)ntohl(size_nbo);
+		return true;
+	}
+
+	// Notation style strings are rare enough to go through the stream reader
+	bool readDelimited(std::string& value, char delim)
+	{
+		boost::iostreams::stream<boost::iostreams::array_source> istr((const char*)mPos, left());
+		int count = deserialize_string_delim(istr, value, delim);
+		if (PARSE_FAILURE == count)
+		{
+			return false;
+		}
+		mPos += count;
+		return true;
+	}
+};
+
+S32 LLSDBinaryParser::parseBuffer(const U8* data, size_t size, LLSD& sd, S32 max_depth, size_t* bytes_read)
+{
+	LLSD::ArenaScope arena(getUseArena()); // <FS/> Arena allocation
+	Buffer buffer = { data, data + size };
+	S32 parse_count = parseBufferValue(buffer, sd, max_depth);
+	if (bytes_read)
+	{
+		*bytes_read = buffer.mPos - data;
+	}
+	return parse_count;
+}
+
+S32 LLSDBinaryParser::parseBufferValue(Buffer& buffer, LLSD& data, S32 max_depth) const
+{
+	// Same format as doParse(). Every read is checked against the end of
+	// the buffer, which also takes the place of the max_bytes limit.
+	if (!buffer.left())
+	{
+		return 0;
+	}
+	if (max_depth == 0)
+	{
+		return PARSE_FAILURE;
+	}
+	const char c = (char)*buffer.mPos++;
+	S32 parse_count = 1;
+	switch(c)
+	{
+	case '{':
+	{
+		S32 child_count = parseBufferMap(buffer, data, max_depth - 1);
+		if(PARSE_FAILURE == child_count)
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		else
+		{
+			parse_count += child_count;
+		}
+		break;
+	}
+
+	case '[':
+	{
+		S32 child_count = parseBufferArray(buffer, data, max_depth - 1);
+		if(PARSE_FAILURE == child_count)
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		else
+		{
+			parse_count += child_count;
+		}
+		break;
+	}
+
+	case '!':
+		data.clear();
+		break;
+
+	case '0':
+		data = false;
+		break;
+
+	case '1':
+		data = true;
+		break;
+
+	case 'i':
+	{
+		U32 value_nbo = 0;
+		if(buffer.read(&value_nbo, sizeof(U32)))
+		{
+			data = (S32)ntohl(value_nbo);
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'r':
+	{
+		F64 real_nbo = 0.0;
+		if(buffer.read(&real_nbo, sizeof(F64)))
+		{
+			data = ll_ntohd(real_nbo);
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'u':
+	{
+		LLUUID id;
+		if(buffer.read(id.mData, UUID_BYTES))
+		{
+			data = id;
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case '\'':
+	case '"':
+	{
+		std::string value;
+		if(buffer.readDelimited(value, c))
+		{
+			data = value;
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 's':
+	{
+		std::string value;
+		if(parseBufferString(buffer, value))
+		{
+			data = value;
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'l':
+	{
+		std::string value;
+		if(parseBufferString(buffer, value))
+		{
+			data = LLURI(value);
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'd':
+	{
+		F64 real = 0.0;
+		if(buffer.read(&real, sizeof(F64)))
+		{
+			data = LLDate(real);
+		}
+		else
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		break;
+	}
+
+	case 'b':
+	{
+		S32 size = 0;
+		if(!buffer.readSize(size) || (size < 0) || ((size_t)size > buffer.left()))
+		{
+			parse_count = PARSE_FAILURE;
+		}
+		else
+		{
+			std::vector<U8> value(buffer.mPos, buffer.mPos + size);
+			buffer.mPos += size;
 			data = value;
 		}
-		if(istr.fail())
-		{
-			LL_INFOS() << "STREAM FAILURE reading binary." << LL_ENDL;
-			parse_count = PARSE_FAILURE;
-		}
 		break;
 	}
 
@@ -1122,119 +1977,101 @@ S32 LLSDBinaryParser::doParse(std::istream& istr, LLSD& data, S32 max_depth) con
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseMap(std::istream& istr, LLSD& map, S32 max_depth) const
+S32 LLSDBinaryParser::parseBufferMap(Buffer& buffer, LLSD& map, S32 max_depth) const
 {
 	map = LLSD::emptyMap();
-	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
-	S32 size = (S32)ntohl(value_nbo);
+	S32 size = 0;
+	if(!buffer.readSize(size))
+	{
+		return PARSE_FAILURE;
+	}
 	S32 parse_count = 0;
 	S32 count = 0;
-	char c = get(istr);
-	while(c != '}' && (count < size) && istr.good())
+	std::string name;
+	while((count < size) && buffer.left() && (*buffer.mPos != '}'))
 	{
-		std::string name;
+		const char c = (char)*buffer.mPos++;
+		name.clear();
 		switch(c)
 		{
 		case 'k':
-			if(!parseString(istr, name))
+			if(!parseBufferString(buffer, name))
 			{
 				return PARSE_FAILURE;
 			}
 			break;
 		case '\'':
 		case '"':
-		{
-			int cnt = deserialize_string_delim(istr, name, c);
-			if(PARSE_FAILURE == cnt) return PARSE_FAILURE;
-			account(cnt);
+			if(!buffer.readDelimited(name, c))
+			{
+				return PARSE_FAILURE;
+			}
 			break;
 		}
-		}
 		LLSD child;
-		S32 child_count = doParse(istr, child, max_depth);
-		if(child_count > 0)
-		{
-			// There must be a value for every key, thus child_count
-			// must be greater than 0.
-			parse_count += child_count;
-			map.insert(name, child);
-		}
-		else
+		S32 child_count = parseBufferValue(buffer, child, max_depth);
+		if(child_count <= 0)
 		{
+			// There must be a value for every key
 			return PARSE_FAILURE;
 		}
+		parse_count += child_count;
+		map.insert(name, child);
 		++count;
-		c = get(istr);
 	}
-	if((c != '}') || (count < size))
+	if(!buffer.left() || (*buffer.mPos++ != '}') || (count < size))
 	{
-		// Make sure it is correctly terminated and we parsed as many
-		// as were said to be there.
 		return PARSE_FAILURE;
 	}
 	return parse_count;
 }
 
-S32 LLSDBinaryParser::parseArray(std::istream& istr, LLSD& array, S32 max_depth) const
+S32 LLSDBinaryParser::parseBufferArray(Buffer& buffer, LLSD& array, S32 max_depth) const
 {
 	array = LLSD::emptyArray();
-	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
-	S32 size = (S32)ntohl(value_nbo);
-
-	// *FIX: This would be a good place to reserve some space in the
-	// array...
+	S32 size = 0;
+	if(!buffer.readSize(size))
+	{
+		return PARSE_FAILURE;
+	}
+	// Every value takes at least a byte, so a size that fits in what is
+	// left can be allocated up front and the values parsed in place.
+	if((size > 0) && ((size_t)size <= buffer.left()))
+	{
+		array[size - 1] = LLSD();
+	}
 
 	S32 parse_count = 0;
 	S32 count = 0;
-	char c = istr.peek();
-	while((c != ']') && (count < size) && istr.good())
+	while((count < size) && buffer.left() && (*buffer.mPos != ']'))
 	{
-		LLSD child;
-		S32 child_count = doParse(istr, child, max_depth);
+		S32 child_count = parseBufferValue(buffer, array[count], max_depth);
 		if(PARSE_FAILURE == child_count)
 		{
 			return PARSE_FAILURE;
 		}
-		if(child_count)
-		{
-			parse_count += child_count;
-			array.append(child);
-		}
+		parse_count += child_count;
 		++count;
-		c = istr.peek();
 	}
-	c = get(istr);
-	if((c != ']') || (count < size))
+	if(!buffer.left() || (*buffer.mPos++ != ']') || (count < size))
 	{
-		// Make sure it is correctly terminated and we parsed as many
-		// as were said to be there.
 		return PARSE_FAILURE;
 	}
 	return parse_count;
 }
 
-bool LLSDBinaryParser::parseString(
-	std::istream& istr,
-	std::string& value) const
+bool LLSDBinaryParser::parseBufferString(Buffer& buffer, std::string& value) const
 {
-	// *FIX: This is memory inefficient.
-	U32 value_nbo = 0;
-	read(istr, (char*)&value_nbo, sizeof(U32));		 /*Flawfinder: ignore*/
-	S32 size = (S32)ntohl(value_nbo);
-	if(mCheckLimits && (size > mMaxBytesLeft)) return false;
-	if(size < 0) return false;
-	std::vector<char> buf;
-	if(size)
+	S32 size = 0;
+	if(!buffer.readSize(size) || (size < 0) || ((size_t)size > buffer.left()))
 	{
-		buf.resize(size);
-		account((int)fullread(istr, &buf[0], size));
-		value.assign(buf.begin(), buf.end());
+		return false;
 	}
+	value.assign((const char*)buffer.mPos, size);
+	buffer.mPos += size;
 	return true;
 }
-
+// </FS>
 
 /**
  * LLSDFormatter
@@ -1593,6 +2430,370 @@ void LLSDBinaryFormatter::formatString(
 	ostr.write(string.c_str(), string.size());
 }
 
+// <FS> Streaming parse
+/**
+ * LLSDWriter
+ */
+LLSDWriter::LLSDWriter(std::ostream& ostr)
+	: mStream(ostr)
+	, mComplete(false)
+{
+}
+
+bool LLSDWriter::startValue()
+{
+	if (mComplete)
+	{
+		LL_WARNS() << "Value written after the end of the document" << LL_ENDL;
+		return false;
+	}
+	if (!mContainers.empty() && !mContainers.back().mIsMap)
+	{
+		++mContainers.back().mCount;
+	}
+	return true;
+}
+
+void LLSDWriter::endValue()
+{
+	if (mContainers.empty())
+	{
+		mComplete = true;
+	}
+}
+
+/**
+ * LLSDNotationWriter
+ */
+LLSDNotationWriter::LLSDNotationWriter(std::ostream& ostr)
+	: LLSDWriter(ostr)
+{
+}
+
+void LLSDNotationWriter::separate()
+{
+	if (!mContainers.empty() && !mContainers.back().mIsMap && mContainers.back().mCount > 1)
+	{
+		mStream << ",";
+	}
+}
+
+bool LLSDNotationWriter::startMap(S32 size)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "{";
+	Container map = { true, 0, size, -1 };
+	mContainers.push_back(map);
+	return true;
+}
+
+bool LLSDNotationWriter::key(const std::string& key)
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	if (++mContainers.back().mCount > 1)
+	{
+		mStream << ",";
+	}
+	mStream << '\'';
+	serialize_string(key, mStream);
+	mStream << "':";
+	return true;
+}
+
+bool LLSDNotationWriter::endMap()
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	mContainers.pop_back();
+	mStream << "}";
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::startArray(S32 size)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "[";
+	Container array = { false, 0, size, -1 };
+	mContainers.push_back(array);
+	return true;
+}
+
+bool LLSDNotationWriter::endArray()
+{
+	if (mContainers.empty() || mContainers.back().mIsMap) return false;
+	mContainers.pop_back();
+	mStream << "]";
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::undefined()
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "!";
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(LLSD::Boolean value)
+{
+	if (!startValue()) return false;
+	separate();
+	if (mStream.flags() & std::ios::boolalpha)
+	{
+		mStream << (value ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL);
+	}
+	else
+	{
+		mStream << (value ? 1 : 0);
+	}
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(LLSD::Integer value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "i" << value;
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(LLSD::Real value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "r" << value;
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(const LLSD::String& value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << '\'';
+	serialize_string(value, mStream);
+	mStream << '\'';
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(const LLSD::UUID& value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "u" << value;
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(const LLSD::Date& value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "d\"" << value << "\"";
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(const LLSD::URI& value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "l\"";
+	serialize_string(value.asString(), mStream);
+	mStream << "\"";
+	endValue();
+	return true;
+}
+
+bool LLSDNotationWriter::value(const LLSD::Binary& value)
+{
+	if (!startValue()) return false;
+	separate();
+	mStream << "b(" << value.size() << ")\"";
+	if (!value.empty())
+	{
+		mStream.write((const char*)&value[0], value.size());
+	}
+	mStream << "\"";
+	endValue();
+	return true;
+}
+
+/**
+ * LLSDBinaryWriter
+ */
+LLSDBinaryWriter::LLSDBinaryWriter(std::ostream& ostr)
+	: LLSDWriter(ostr)
+{
+}
+
+bool LLSDBinaryWriter::startContainer(bool is_map, S32 size)
+{
+	if (!startValue()) return false;
+	mStream.put(is_map ? '{' : '[');
+	Container container = { is_map, 0, size, mStream.tellp() };
+	mContainers.push_back(container);
+	U32 size_nbo = htonl(llmax(size, 0));
+	mStream.write((const char*)(&size_nbo), sizeof(U32));
+	return true;
+}
+
+bool LLSDBinaryWriter::endContainer()
+{
+	const Container& container = mContainers.back();
+	if (container.mCount != container.mSize)
+	{
+		// Go back and fix the size we wrote up front
+		if (container.mSizePos == std::streampos(-1))
+		{
+			LL_WARNS() << "Can't write the size of a binary LLSD map or array to this stream" << LL_ENDL;
+			return false;
+		}
+		std::streampos end = mStream.tellp();
+		mStream.seekp(container.mSizePos);
+		U32 size_nbo = htonl(container.mCount);
+		mStream.write((const char*)(&size_nbo), sizeof(U32));
+		mStream.seekp(end);
+	}
+	mStream.put(container.mIsMap ? '}' : ']');
+	mContainers.pop_back();
+	endValue();
+	return true;
+}
+
+void LLSDBinaryWriter::writeString(const std::string& string)
+{
+	U32 size_nbo = htonl(string.size());
+	mStream.write((const char*)(&size_nbo), sizeof(U32));
+	mStream.write(string.c_str(), string.size());
+}
+
+bool LLSDBinaryWriter::startMap(S32 size)
+{
+	return startContainer(true, size);
+}
+
+bool LLSDBinaryWriter::key(const std::string& key)
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	++mContainers.back().mCount;
+	mStream.put('k');
+	writeString(key);
+	return true;
+}
+
+bool LLSDBinaryWriter::endMap()
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	return endContainer();
+}
+
+bool LLSDBinaryWriter::startArray(S32 size)
+{
+	return startContainer(false, size);
+}
+
+bool LLSDBinaryWriter::endArray()
+{
+	if (mContainers.empty() || mContainers.back().mIsMap) return false;
+	return endContainer();
+}
+
+bool LLSDBinaryWriter::undefined()
+{
+	if (!startValue()) return false;
+	mStream.put('!');
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(LLSD::Boolean value)
+{
+	if (!startValue()) return false;
+	mStream.put(value ? BINARY_TRUE_SERIAL : BINARY_FALSE_SERIAL);
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(LLSD::Integer value)
+{
+	if (!startValue()) return false;
+	mStream.put('i');
+	U32 value_nbo = htonl(value);
+	mStream.write((const char*)(&value_nbo), sizeof(U32));
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(LLSD::Real value)
+{
+	if (!startValue()) return false;
+	mStream.put('r');
+	F64 value_nbo = ll_htond(value);
+	mStream.write((const char*)(&value_nbo), sizeof(F64));
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(const LLSD::String& value)
+{
+	if (!startValue()) return false;
+	mStream.put('s');
+	writeString(value);
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(const LLSD::UUID& value)
+{
+	if (!startValue()) return false;
+	mStream.put('u');
+	mStream.write((const char*)(&(value.mData)), UUID_BYTES);
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(const LLSD::Date& value)
+{
+	if (!startValue()) return false;
+	mStream.put('d');
+	F64 seconds = value.secondsSinceEpoch();
+	mStream.write((const char*)(&seconds), sizeof(F64));
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(const LLSD::URI& value)
+{
+	if (!startValue()) return false;
+	mStream.put('l');
+	writeString(value.asString());
+	endValue();
+	return true;
+}
+
+bool LLSDBinaryWriter::value(const LLSD::Binary& value)
+{
+	if (!startValue()) return false;
+	mStream.put('b');
+	U32 size_nbo = htonl(value.size());
+	mStream.write((const char*)(&size_nbo), sizeof(U32));
+	if (!value.empty())
+	{
+		mStream.write((const char*)&value[0], value.size());
+	}
+	endValue();
+	return true;
+}
+// </FS>
+
 /**
  * local functions
  */
@@ -2430,9 +3631,12 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
 	{
 		char* result_ptr = strip_deprecated_header((char*)result, cur_size);
 
-		boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-		
-		if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+		// <FS> Buffer parse
+		//boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
+		//
+		//if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+		if (!LLSDSerialize::fromBinary(data, (const U8*)result_ptr, cur_size, UNZIP_LLSD_MAX_DEPTH))
+		// </FS>
 		{
 			free(result);
 			return ZR_PARSE_ERROR;
@@ -29,11 +29,59 @@
 #ifndef LL_LLSDSERIALIZE_H
 #define LL_LLSDSERIALIZE_H
 
+#include <atomic> // <FS/> Arena allocation
 #include <iosfwd>
+#include <vector> // <FS/> Streaming parse
 #include "llpointer.h"
 #include "llrefcount.h"
 #include "llsd.h"
 
+// <FS> Streaming parse
+/** 
+ * @class LLSDVisitor
+ * @brief Receives a structured data stream one event at a time.
+ *
+ * LLSDParser::visit() calls these as it reads the stream instead of
+ * building an LLSD, so a caller that only needs a few fields, or wants
+ * to fill its own structures, never materializes the whole tree. A map
+ * reports each key() right before the value that belongs to it.
+ *
+ * Every method returns false to stop the parse right there; the
+ * defaults ignore the event and go on, so subclasses only override
+ * what they care about.
+ */
+class LL_COMMON_API LLSDVisitor
+{
+public:
+	virtual ~LLSDVisitor() {}
+
+	/// @param size The number of entries, or -1 if the format does not say.
+	virtual bool startMap(S32 size)					{ return true; }
+	virtual bool key(const std::string& key)		{ return true; }
+	virtual bool endMap()							{ return true; }
+	/// @param size The number of entries, or -1 if the format does not say.
+	virtual bool startArray(S32 size)				{ return true; }
+	virtual bool endArray()							{ return true; }
+
+	virtual bool undefined()						{ return true; }
+	virtual bool value(LLSD::Boolean value)			{ return true; }
+	virtual bool value(LLSD::Integer value)			{ return true; }
+	virtual bool value(LLSD::Real value)			{ return true; }
+	virtual bool value(const LLSD::String& value)	{ return true; }
+	virtual bool value(const LLSD::UUID& value)		{ return true; }
+	virtual bool value(const LLSD::Date& value)		{ return true; }
+	virtual bool value(const LLSD::URI& value)		{ return true; }
+	virtual bool value(const LLSD::Binary& value)	{ return true; }
+
+	/** 
+	 * @brief Sends an existing LLSD to this visitor, as a parse would.
+	 *
+	 * @return Returns false if the visitor stopped the walk.
+	 */
+	bool walk(const LLSD& data);
+};
+// </FS>
+
 /** 
  * @class LLSDParser
  * @brief Abstract base class for LLSD parsers.
@@ -90,6 +138,36 @@ public:
 	 */
 	void reset()	{ doReset();	};
 
+	// <FS> Streaming parse
+	/** 
+	 * @brief Parses the stream like parse(), but hands every value to a
+	 * visitor as it is read instead of building an LLSD.
+	 *
+	 * The visitor may stop the parse early, which leaves the stream in
+	 * the middle of the object. After a failure it has seen the events
+	 * up to the point where the stream went bad.
+	 * @param istr The input stream.
+	 * @param visitor Receives the events.
+	 * @param max_bytes The maximum number of bytes that will be in
+	 * the stream. Pass in LLSDSerialize::SIZE_UNLIMITED (-1) to set no
+	 * byte limit.
+	 * @return Returns the number of LLSD objects visited. Returns
+	 * PARSE_FAILURE (-1) on parse failure.
+	 */
+	S32 visit(std::istream& istr, LLSDVisitor& visitor, S32 max_bytes, S32 max_depth = -1);
+	// </FS>
+
+	// <FS> Arena allocation
+	/**
+	 * @brief Makes every parse build its result inside an LLSD::ArenaScope.
+	 *
+	 * Off by default. Worth it for large documents that are dropped as a
+	 * whole once read; see LLSD::ArenaScope.
+	 */
+	static void setUseArena(bool use_arena)	{ sUseArena.store(use_arena, std::memory_order_relaxed); }
+	static bool getUseArena()				{ return sUseArena.load(std::memory_order_relaxed); }
+	// </FS>
+
 
 protected:
 	/** 
@@ -115,6 +193,28 @@ protected:
 	 */
 	virtual void doReset()	{};
 
+	// <FS> Streaming parse
+	/** 
+	 * @brief Does the work of visit().
+	 *
+	 * The default parses an LLSD with doParse() and walks it, for
+	 * parsers that cannot report events as they go.
+	 * @return Returns the number of LLSD objects visited. Returns
+	 * PARSE_FAILURE (-1) on parse failure.
+	 */
+	virtual S32 doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth = -1) const;
+
+	/** 
+	 * @brief What the recursive visit helpers of the subclasses return.
+	 */
+	enum EVisitResult
+	{
+		VISIT_CONTINUE,
+		VISIT_STOPPED,		// The visitor asked to stop
+		VISIT_FAILURE
+	};
+	// </FS>
+
 	/* @name Simple istream helper methods 
 	 *
 	 * These helper methods exist to help correctly use the
@@ -211,6 +311,15 @@ protected:
 	 * @brief Use line-based reading to get text
 	 */
 	bool mParseLines;
+
+	// <FS> Streaming parse
+	/**
+	 * @brief The number of LLSD objects handed to the visitor by doVisit().
+	 */
+	mutable S32 mVisitCount;
+	// </FS>
+
+	static std::atomic<bool> sUseArena; // <FS/> Arena allocation
 };
 
 /** 
@@ -288,6 +397,19 @@ private:
 	 * @return Retuns true if a complete blob was parsed.
 	 */
 	bool parseBinary(std::istream& istr, LLSD& data) const;
+
+	// <FS> Streaming parse
+protected:
+	S32 doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth = -1) const override;
+
+private:
+	/** 
+	 * @brief Visitor counterparts of doParse(), parseMap() and parseArray().
+	 */
+	EVisitResult visitValue(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	EVisitResult visitMap(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	EVisitResult visitArray(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	// </FS>
 };
 
 /** 
@@ -332,6 +454,8 @@ protected:
 	 */
 	virtual void doReset();
 
+	S32 doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth = -1) const override; // <FS/> Streaming parse
+
 private:
 	class Impl;
 	Impl& impl;
@@ -358,6 +482,25 @@ public:
 	 */
 	LLSDBinaryParser();
 
+	// <FS> Buffer parse
+	/** 
+	 * @brief Parse one LLSD object straight from memory.
+	 *
+	 * Faster than parse() on a stream over the same bytes, for data
+	 * that is in one piece already: decompressed assets, mapped files,
+	 * a single block LLCore::BufferArray.
+	 * @param data The serialized LLSD, without the binary header.
+	 * @param size Bytes available at data, the parse never reads past.
+	 * @param sd[out] The newly parsed structured data.
+	 * @param max_depth Max depth parser will check before exiting
+	 *  with parse error, -1 - unlimited.
+	 * @param bytes_read[out] If not NULL, how many bytes the object used.
+	 * @return Returns the number of LLSD objects parsed into
+	 * data. Returns -1 on parse failure.
+	 */
+	S32 parseBuffer(const U8* data, size_t size, LLSD& sd, S32 max_depth = -1, size_t* bytes_read = NULL);
+	// </FS>
+
 protected:
 	/** 
 	 * @brief Call this method to parse a stream for LLSD.
@@ -406,6 +549,31 @@ private:
 	 * @return Retuns true if a complete string was parsed.
 	 */
 	bool parseString(std::istream& istr, std::string& value) const;
+
+	// <FS> Streaming parse
+protected:
+	S32 doVisit(std::istream& istr, LLSDVisitor& visitor, S32 max_depth = -1) const override;
+
+private:
+	/** 
+	 * @brief Visitor counterparts of doParse(), parseMap() and parseArray().
+	 */
+	EVisitResult visitValue(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	EVisitResult visitMap(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	EVisitResult visitArray(std::istream& istr, LLSDVisitor& visitor, S32 max_depth) const;
+	// </FS>
+
+	// <FS> Buffer parse
+	/** 
+	 * @brief Counterparts of doParse(), parseMap(), parseArray() and
+	 * parseString() reading from the Buffer of parseBuffer().
+	 */
+	struct Buffer;
+	S32 parseBufferValue(Buffer& buffer, LLSD& data, S32 max_depth) const;
+	S32 parseBufferMap(Buffer& buffer, LLSD& map, S32 max_depth) const;
+	S32 parseBufferArray(Buffer& buffer, LLSD& array, S32 max_depth) const;
+	bool parseBufferString(Buffer& buffer, std::string& value) const;
+	// </FS>
 };
 
 
@@ -663,6 +831,157 @@ protected:
 };
 
 
+// <FS> Streaming parse
+/** 
+ * @class LLSDWriter
+ * @brief Base class for visitors that write the events they get
+ * straight back out to a stream.
+ *
+ * Feeding a parser's visit() into a writer converts between formats
+ * without building an LLSD, and code that has its data in its own
+ * structures can write a document by calling the visitor methods
+ * itself. The output is what the matching formatter would write with
+ * OPTIONS_NONE. Write exactly one top level value per writer.
+ */
+class LL_COMMON_API LLSDWriter : public LLSDVisitor
+{
+public:
+	LLSDWriter(std::ostream& ostr);
+
+	/** 
+	 * @brief Returns true once a complete value has been written.
+	 */
+	bool isComplete() const	{ return mComplete; }
+
+protected:
+	/** 
+	 * @brief Call at the start of every value, map and array included;
+	 * counts it in its container. Returns false once the top level value
+	 * is complete.
+	 */
+	bool startValue();
+	/** 
+	 * @brief Call after every value, and after the end of a map or array.
+	 */
+	void endValue();
+
+	struct Container
+	{
+		bool				mIsMap;
+		S32					mCount;		// Entries written so far
+		S32					mSize;		// As passed to startMap()/startArray()
+		std::streampos		mSizePos;	// For formats that write the size up front
+	};
+	typedef std::vector<Container> container_stack_t;
+
+	std::ostream& mStream;
+	container_stack_t mContainers;
+	bool mComplete;
+};
+
+/** 
+ * @class LLSDNotationWriter
+ * @brief Writes visitor events as notation.
+ */
+class LL_COMMON_API LLSDNotationWriter : public LLSDWriter
+{
+public:
+	LLSDNotationWriter(std::ostream& ostr);
+
+	bool startMap(S32 size) override;
+	bool key(const std::string& key) override;
+	bool endMap() override;
+	bool startArray(S32 size) override;
+	bool endArray() override;
+
+	bool undefined() override;
+	bool value(LLSD::Boolean value) override;
+	bool value(LLSD::Integer value) override;
+	bool value(LLSD::Real value) override;
+	bool value(const LLSD::String& value) override;
+	bool value(const LLSD::UUID& value) override;
+	bool value(const LLSD::Date& value) override;
+	bool value(const LLSD::URI& value) override;
+	bool value(const LLSD::Binary& value) override;
+
+private:
+	// Writes the comma between array entries
+	void separate();
+};
+
+/** 
+ * @class LLSDBinaryWriter
+ * @brief Writes visitor events in the binary format.
+ *
+ * The binary format puts the size of a map or array in front of it.
+ * When startMap() or startArray() get -1 the writer fills it in when
+ * the container ends, which needs a seekable stream; it fails on
+ * anything else.
+ */
+class LL_COMMON_API LLSDBinaryWriter : public LLSDWriter
+{
+public:
+	LLSDBinaryWriter(std::ostream& ostr);
+
+	bool startMap(S32 size) override;
+	bool key(const std::string& key) override;
+	bool endMap() override;
+	bool startArray(S32 size) override;
+	bool endArray() override;
+
+	bool undefined() override;
+	bool value(LLSD::Boolean value) override;
+	bool value(LLSD::Integer value) override;
+	bool value(LLSD::Real value) override;
+	bool value(const LLSD::String& value) override;
+	bool value(const LLSD::UUID& value) override;
+	bool value(const LLSD::Date& value) override;
+	bool value(const LLSD::URI& value) override;
+	bool value(const LLSD::Binary& value) override;
+
+private:
+	bool startContainer(bool is_map, S32 size);
+	bool endContainer();
+	void writeString(const std::string& string);
+};
+
+/** 
+ * @class LLSDXMLWriter
+ * @brief Writes visitor events as XML, <llsd> element included.
+ */
+class LL_COMMON_API LLSDXMLWriter : public LLSDWriter
+{
+public:
+	LLSDXMLWriter(std::ostream& ostr);
+
+	bool startMap(S32 size) override;
+	bool key(const std::string& key) override;
+	bool endMap() override;
+	bool startArray(S32 size) override;
+	bool endArray() override;
+
+	bool undefined() override;
+	bool value(LLSD::Boolean value) override;
+	bool value(LLSD::Integer value) override;
+	bool value(LLSD::Real value) override;
+	bool value(const LLSD::String& value) override;
+	bool value(const LLSD::UUID& value) override;
+	bool value(const LLSD::Date& value) override;
+	bool value(const LLSD::URI& value) override;
+	bool value(const LLSD::Binary& value) override;
+
+private:
+	// Opens the document before the top level value, and writes the
+	// pending tag of an enclosing map or array that was still empty.
+	void open();
+	// Ends a value, and the document with it after the top level value.
+	void close();
+
+	std::streamsize mOldPrecision;
+	bool mPendingOpen;		// The innermost container has not written its tag yet
+};
+// </FS>
+
 /** 
  * @class LLSDNotationStreamFormatter
  * @brief Formatter which is specialized for use on streams which
@@ -846,6 +1165,34 @@ public:
 		(void)p->parse(str, sd, max_bytes, max_depth);
 		return sd;
 	}
+	// <FS> Buffer parse, see LLSDBinaryParser::parseBuffer()
+	static S32 fromBinary(LLSD& sd, const U8* data, size_t size, S32 max_depth = -1, size_t* bytes_read = NULL)
+	{
+		LLPointer<LLSDBinaryParser> p = new LLSDBinaryParser;
+		return p->parseBuffer(data, size, sd, max_depth, bytes_read);
+	}
+	// </FS>
+
+	// <FS> Streaming parse
+	/*
+	 * Visitor Methods, see LLSDParser::visit()
+	 */
+	static S32 visitNotation(LLSDVisitor& visitor, std::istream& str, S32 max_bytes)
+	{
+		LLPointer<LLSDNotationParser> p = new LLSDNotationParser;
+		return p->visit(str, visitor, max_bytes);
+	}
+	static S32 visitXML(LLSDVisitor& visitor, std::istream& str, bool emit_errors=true)
+	{
+		LLPointer<LLSDXMLParser> p = new LLSDXMLParser(emit_errors);
+		return p->visit(str, visitor, LLSDSerialize::SIZE_UNLIMITED);
+	}
+	static S32 visitBinary(LLSDVisitor& visitor, std::istream& str, S32 max_bytes, S32 max_depth = -1)
+	{
+		LLPointer<LLSDBinaryParser> p = new LLSDBinaryParser;
+		return p->visit(str, visitor, max_bytes, max_depth);
+	}
+	// </FS>
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
@@ -34,6 +34,11 @@
 #include <boost/regex.hpp>
 #include <stack>
 
+// <FS> SIMD base64 and XML escape
+#include <emmintrin.h>
+#include "llbase64.h"
+// </FS>
+
 extern "C"
 {
 #ifdef LL_USESYSTEMLIBS
@@ -197,14 +202,18 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 			// *FIX: memory inefficient.
 			// *TODO: convert to use LLBase64
 			ostr << pre << "<binary encoding=\"base64\">";
-			int b64_buffer_length = apr_base64_encode_len(buffer.size());
-			char* b64_buffer = new char[b64_buffer_length];
-			b64_buffer_length = apr_base64_encode_binary(
-				b64_buffer,
-				&buffer[0],
-				buffer.size());
-			ostr.write(b64_buffer, b64_buffer_length - 1);
-			delete[] b64_buffer;
+			// <FS> SIMD base64
+			//int b64_buffer_length = apr_base64_encode_len(buffer.size());
+			//char* b64_buffer = new char[b64_buffer_length];
+			//b64_buffer_length = apr_base64_encode_binary(
+			//	b64_buffer,
+			//	&buffer[0],
+			//	buffer.size());
+			//ostr.write(b64_buffer, b64_buffer_length - 1);
+			//delete[] b64_buffer;
+			std::vector<char> b64_buffer(LLBase64::encodeLength(buffer.size()));
+			ostr.write(&b64_buffer[0], LLBase64::encode(&buffer[0], buffer.size(), &b64_buffer[0]));
+			// </FS>
 			ostr << "</binary>" << post;
 		}
 		break;
@@ -217,46 +226,170 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
 	return format_count;
 }
 
+// <FS> SIMD XML escape
+namespace
+{
+	// Characters escapeString() replaces. Besides the markup characters that
+	// is most of the ones below 20 (not 0x20), which are not valid in XML.
+	inline bool needsEscape(char c)
+	{
+		switch (c)
+		{
+			case '<':
+			case '>':
+			case '&':
+			case '\'':
+			case '"':
+				return true;
+			default:
+				return c >= 0 && c < 20 && c != 0x09 && c != 0x0A && c != 0x0D;
+		}
+	}
+
+	// Bit i set for each of the 16 characters at p that needsEscape().
+	inline U32 escapeMask(const char* p)
+	{
+		const __m128i chars = _mm_loadu_si128((const __m128i*)p);
+
+		__m128i special = _mm_cmpeq_epi8(chars, _mm_set1_epi8('<'));
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('>')));
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('&')));
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('\'')));
+		special = _mm_or_si128(special, _mm_cmpeq_epi8(chars, _mm_set1_epi8('"')));
+
+		const __m128i control = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(-1)),
+											  _mm_cmplt_epi8(chars, _mm_set1_epi8(20)));
+		__m128i allowed = _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x09));
+		allowed = _mm_or_si128(allowed, _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x0A)));
+		allowed = _mm_or_si128(allowed, _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x0D)));
+		special = _mm_or_si128(special, _mm_andnot_si128(allowed, control));
+
+		return (U32)_mm_movemask_epi8(special);
+	}
+
+	inline U32 lowestSetBit(U32 mask)
+	{
+#if LL_WINDOWS
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (U32)index;
+#else
+		return (U32)__builtin_ctz(mask);
+#endif
+	}
+
+	inline void appendEscaped(std::string& out, char c)
+	{
+		switch (c)
+		{
+			case '<':
+				out += "&lt;";
+				break;
+			case '>':
+				out += "&gt;";
+				break;
+			case '&':
+				out += "&amp;";
+				break;
+			case '\'':
+				out += "&apos;";
+				break;
+			case '"':
+				out += "&quot;";
+				break;
+			default:
+				// Not valid in XML
+				out += '?';
+				break;
+		}
+	}
+}
+// </FS>
+
 // static
 std::string LLSDXMLFormatter::escapeString(const std::string& in)
 {
-	std::ostringstream out;
-	std::string::const_iterator it = in.begin();
-	std::string::const_iterator end = in.end();
-	for(; it != end; ++it)
+	// <FS> SIMD XML escape
+	//std::ostringstream out;
+	//std::string::const_iterator it = in.begin();
+	//std::string::const_iterator end = in.end();
+	//for(; it != end; ++it)
+	//{
+	//	// <FS:ND> Skip invalid characters. There a s few more, but those would need inspecting of the UTF-8 sequence.
+	//	// See http://en.wikipedia.org/wiki/Valid_characters_in_XML
+	//	if( *it >= 0 && *it < 20 && *it != 0x09 && *it != 0x0A && *it != 0x0D )
+	//	{
+	//		out << "?";
+	//		continue;
+	//	}
+	//	// </FS:ND>
+	//
+	//	switch((*it))
+	//	{
+	//	case '<':
+	//		out << "&lt;";
+	//		break;
+	//	case '>':
+	//		out << "&gt;";
+	//		break;
+	//	case '&':
+	//		out << "&amp;";
+	//		break;
+	//	case '\'':
+	//		out << "&apos;";
+	//		break;
+	//	case '"':
+	//		out << "&quot;";
+	//		break;
+	//	default:
+	//		out << (*it);
+	//		break;
+	//	}
+	//}
+	//return out.str();
+
+	// Copies the runs between the characters to escape; strings that have
+	// none, which is nearly all of them, come back as they are.
+	const char* const begin = in.data();
+	const char* const end = begin + in.size();
+	const char* run = begin;
+	const char* p = begin;
+	std::string out;
+
+	while (end - p >= 16)
 	{
-		// <FS:ND> Skip invalid characters. There a s few more, but those would need inspecting of the UTF-8 sequence.
-		// See http://en.wikipedia.org/wiki/Valid_characters_in_XML
-		if( *it >= 0 && *it < 20 && *it != 0x09 && *it != 0x0A && *it != 0x0D )
+		U32 mask = escapeMask(p);
+		while (mask)
 		{
-			out << "?";
-			continue;
+			const char* special = p + lowestSetBit(mask);
+			if (run == begin)
+			{
+				out.reserve(in.size() + 16);
+			}
+			out.append(run, special);
+			appendEscaped(out, *special);
+			run = special + 1;
+			mask &= mask - 1;
 		}
-		// </FS:ND>
-
-		switch((*it))
+		p += 16;
+	}
+	for (; p < end; ++p)
+	{
+		if (needsEscape(*p))
 		{
-		case '<':
-			out << "&lt;";
-			break;
-		case '>':
-			out << "&gt;";
-			break;
-		case '&':
-			out << "&amp;";
-			break;
-		case '\'':
-			out << "&apos;";
-			break;
-		case '"':
-			out << "&quot;";
-			break;
-		default:
-			out << (*it);
-			break;
+			out.append(run, p);
+			appendEscaped(out, *p);
+			run = p + 1;
 		}
 	}
-	return out.str();
+
+	if (run == begin)
+	{
+		return in;
+	}
+	out.append(run, end);
+	return out;
+	// </FS>
 }
 
 
@@ -274,6 +407,10 @@ public:
 	
 	void reset();
 
+	// <FS> Streaming parse
+	S32 visit(std::istream& input, LLSDVisitor& visitor, bool lines);
+	// </FS>
+
 private:
 	void startElementHandler(const XML_Char* name, const XML_Char** attributes);
 	void endElementHandler(const XML_Char* name);
@@ -328,11 +465,22 @@ private:
 	
 	std::string mCurrentKey;		// Current XML <tag>
 	std::string mCurrentContent;	// String data between <tag> and </tag>
+
+	// <FS> Streaming parse
+	// Counterparts of the tree building parts of the element handlers
+	void visitStartValue(Element element);
+	void visitEndValue(Element element);
+	void stopVisit();
+
+	LLSDVisitor* mVisitor;			// Set while visit() runs
+	std::vector<Element> mVisitStack;	// Values open while visiting, innermost last
+	// </FS>
 };
 
 
 LLSDXMLParser::Impl::Impl(bool emit_errors)
 	: mEmitErrors(emit_errors)
+	, mVisitor(NULL) // <FS/> Streaming parse
 {
 	mParser = XML_ParserCreate(NULL);
 	reset();
@@ -527,6 +675,8 @@ void LLSDXMLParser::Impl::reset()
 	mSkipping = false;
 	
 	mCurrentKey.clear();
+
+	mVisitStack.clear(); // <FS/> Streaming parse
 	
 	XML_ParserReset(mParser, "utf-8");
 	XML_SetUserData(mParser, this);
@@ -625,7 +775,11 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 			return;
 	
 		case ELEMENT_KEY:
-			if (mStack.empty()  ||  !(mStack.back()->isMap()))
+			// <FS> Streaming parse
+			//if (mStack.empty()  ||  !(mStack.back()->isMap()))
+			if (mVisitor ? (mVisitStack.empty() || mVisitStack.back() != ELEMENT_MAP)
+						 : (mStack.empty() || !(mStack.back()->isMap())))
+			// </FS>
 			{
 				mStackElements.pop();
 				return startSkipping();
@@ -654,6 +808,13 @@ void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Ch
 		mStackElements.pop();
 		return startSkipping();
 	}
+
+	// <FS> Streaming parse
+	if (mVisitor)
+	{
+		return visitStartValue(element);
+	}
+	// </FS>
 	
 	if (mStack.empty())
 	{
@@ -747,6 +908,15 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	
 	if (!mInLLSDElement) { return; }
 
+	// <FS> Streaming parse
+	if (mVisitor)
+	{
+		visitEndValue(element);
+		mCurrentContent.clear();
+		return;
+	}
+	// </FS>
+
 	LLSD& value = *mStack.back();
 	mStack.pop_back();
 	
@@ -815,14 +985,18 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 			// created by python and other non-linden systems - DEV-39358
 			// Fortunately we have very little binary passing now,
 			// so performance impact shold be negligible. + poppy 2009-09-04
-			boost::regex r;
-			r.assign("\\s");
-			std::string stripped = boost::regex_replace(mCurrentContent, r, "");
-			S32 len = apr_base64_decode_len(stripped.c_str());
+			// <FS> SIMD base64, skips the whitespace itself
+			//boost::regex r;
+			//r.assign("\\s");
+			//std::string stripped = boost::regex_replace(mCurrentContent, r, "");
+			//S32 len = apr_base64_decode_len(stripped.c_str());
+			//std::vector<U8> data;
+			//data.resize(len);
+			//len = apr_base64_decode_binary(&data[0], stripped.c_str());
+			//data.resize(len);
 			std::vector<U8> data;
-			data.resize(len);
-			len = apr_base64_decode_binary(&data[0], stripped.c_str());
-			data.resize(len);
+			LLBase64::decode(mCurrentContent, data);
+			// </FS>
 			value = data;
 			break;
 		}
@@ -839,6 +1013,154 @@ void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
 	mCurrentContent.clear();
 }
 
+// <FS> Streaming parse
+S32 LLSDXMLParser::Impl::visit(std::istream& input, LLSDVisitor& visitor, bool lines)
+{
+	mVisitor = &visitor;
+	mVisitStack.clear();
+
+	LLSD unused;
+	S32 parse_count = lines ? parseLines(input, unused) : parse(input, unused);
+
+	mVisitor = NULL;
+	return parse_count;
+}
+
+void LLSDXMLParser::Impl::stopVisit()
+{
+	// Looks like the end of the document to parse() and parseLines()
+	mGracefullStop = true;
+	XML_StopParser(mParser, false);
+}
+
+void LLSDXMLParser::Impl::visitStartValue(Element element)
+{
+	if (!mVisitStack.empty())
+	{
+		Element parent = mVisitStack.back();
+		if (parent == ELEMENT_MAP)
+		{
+			if (mCurrentKey.empty())
+			{
+				mStackElements.pop();
+				return startSkipping();
+			}
+			if (!mVisitor->key(mCurrentKey))
+			{
+				return stopVisit();
+			}
+			mCurrentKey.clear();
+		}
+		else if (parent != ELEMENT_ARRAY)
+		{
+			// improperly nested value in a non-structure
+			mStackElements.pop();
+			return startSkipping();
+		}
+	}
+
+	++mParseCount;
+	mVisitStack.push_back(element);
+
+	bool keep_going = true;
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			keep_going = mVisitor->startMap(-1);
+			break;
+
+		case ELEMENT_ARRAY:
+			keep_going = mVisitor->startArray(-1);
+			break;
+
+		default:
+			// all the other values are reported in the end element handler
+			;
+	}
+	if (!keep_going)
+	{
+		stopVisit();
+	}
+}
+
+void LLSDXMLParser::Impl::visitEndValue(Element element)
+{
+	if (mVisitStack.empty())
+	{
+		return;
+	}
+	mVisitStack.pop_back();
+
+	// Same conversions as endElementHandler()
+	bool keep_going = true;
+	switch (element)
+	{
+		case ELEMENT_MAP:
+			keep_going = mVisitor->endMap();
+			break;
+
+		case ELEMENT_ARRAY:
+			keep_going = mVisitor->endArray();
+			break;
+
+		case ELEMENT_UNDEF:
+		case ELEMENT_UNKNOWN:
+			keep_going = mVisitor->undefined();
+			break;
+
+		case ELEMENT_BOOL:
+			keep_going = mVisitor->value(mCurrentContent == "true" || mCurrentContent == "1");
+			break;
+
+		case ELEMENT_INTEGER:
+		{
+			S32 i;
+			if ( sscanf(mCurrentContent.c_str(), "%d", &i ) != 1 )
+			{
+				i = LLSD(mCurrentContent).asInteger();
+			}
+			keep_going = mVisitor->value(i);
+			break;
+		}
+
+		case ELEMENT_REAL:
+			keep_going = mVisitor->value(LLSD(mCurrentContent).asReal());
+			break;
+
+		case ELEMENT_STRING:
+			keep_going = mVisitor->value(mCurrentContent);
+			break;
+
+		case ELEMENT_UUID:
+			keep_going = mVisitor->value(LLUUID(mCurrentContent));
+			break;
+
+		case ELEMENT_DATE:
+			keep_going = mVisitor->value(LLDate(mCurrentContent));
+			break;
+
+		case ELEMENT_URI:
+			keep_going = mVisitor->value(LLURI(mCurrentContent));
+			break;
+
+		case ELEMENT_BINARY:
+		{
+			std::vector<U8> data;
+			LLBase64::decode(mCurrentContent, data);
+			keep_going = mVisitor->value(data);
+			break;
+		}
+
+		default:
+			break;
+	}
+	if (!keep_going)
+	{
+		stopVisit();
+	}
+}
+// </FS>
+
 void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
 {
 	#ifdef XML_PARSER_PERFORMANCE_TESTS
@@ -976,3 +1298,196 @@ void LLSDXMLParser::doReset()
 {
 	impl.reset();
 }
+
+// <FS> Streaming parse
+// virtual
+S32 LLSDXMLParser::doVisit(std::istream& input, LLSDVisitor& visitor, S32 max_depth) const
+{
+	return impl.visit(input, visitor, mParseLines);
+}
+
+/**
+ * LLSDXMLWriter
+ */
+LLSDXMLWriter::LLSDXMLWriter(std::ostream& ostr)
+	: LLSDWriter(ostr)
+	, mOldPrecision(0)
+	, mPendingOpen(false)
+{
+}
+
+void LLSDXMLWriter::open()
+{
+	if (mContainers.empty())
+	{
+		mOldPrecision = mStream.precision(25);
+		mStream << "<llsd>";
+	}
+	else if (mPendingOpen)
+	{
+		mStream << (mContainers.back().mIsMap ? "<map>" : "<array>");
+		mPendingOpen = false;
+	}
+}
+
+void LLSDXMLWriter::close()
+{
+	endValue();
+	if (isComplete())
+	{
+		mStream << "</llsd>\n";
+		mStream.precision(mOldPrecision);
+	}
+}
+
+bool LLSDXMLWriter::startMap(S32 size)
+{
+	if (!startValue()) return false;
+	open();
+	Container map = { true, 0, size, -1 };
+	mContainers.push_back(map);
+	mPendingOpen = true;
+	return true;
+}
+
+bool LLSDXMLWriter::key(const std::string& key)
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	++mContainers.back().mCount;
+	open();
+	mStream << "<key>" << LLSDXMLFormatter::escapeString(key) << "</key>";
+	return true;
+}
+
+bool LLSDXMLWriter::endMap()
+{
+	if (mContainers.empty() || !mContainers.back().mIsMap) return false;
+	mStream << (mPendingOpen ? "<map />" : "</map>");
+	mPendingOpen = false;
+	mContainers.pop_back();
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::startArray(S32 size)
+{
+	if (!startValue()) return false;
+	open();
+	Container array = { false, 0, size, -1 };
+	mContainers.push_back(array);
+	mPendingOpen = true;
+	return true;
+}
+
+bool LLSDXMLWriter::endArray()
+{
+	if (mContainers.empty() || mContainers.back().mIsMap) return false;
+	mStream << (mPendingOpen ? "<array />" : "</array>");
+	mPendingOpen = false;
+	mContainers.pop_back();
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::undefined()
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<undef />";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(LLSD::Boolean value)
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<boolean>";
+	if (mStream.flags() & std::ios::boolalpha)
+	{
+		mStream << (value ? "true" : "false");
+	}
+	else
+	{
+		mStream << (value ? 1 : 0);
+	}
+	mStream << "</boolean>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(LLSD::Integer value)
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<integer>" << value << "</integer>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(LLSD::Real value)
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<real>" << value << "</real>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(const LLSD::String& value)
+{
+	if (!startValue()) return false;
+	open();
+	if (value.empty()) mStream << "<string />";
+	else mStream << "<string>" << LLSDXMLFormatter::escapeString(value) << "</string>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(const LLSD::UUID& value)
+{
+	if (!startValue()) return false;
+	open();
+	if (value.isNull()) mStream << "<uuid />";
+	else mStream << "<uuid>" << value << "</uuid>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(const LLSD::Date& value)
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<date>" << value << "</date>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(const LLSD::URI& value)
+{
+	if (!startValue()) return false;
+	open();
+	mStream << "<uri>" << LLSDXMLFormatter::escapeString(value.asString()) << "</uri>";
+	close();
+	return true;
+}
+
+bool LLSDXMLWriter::value(const LLSD::Binary& value)
+{
+	if (!startValue()) return false;
+	open();
+	if (value.empty())
+	{
+		mStream << "<binary />";
+	}
+	else
+	{
+		mStream << "<binary encoding=\"base64\">";
+		std::vector<char> b64_buffer(LLBase64::encodeLength(value.size()));
+		mStream.write(&b64_buffer[0], LLBase64::encode(&value[0], value.size(), &b64_buffer[0]));
+		mStream << "</binary>";
+	}
+	close();
+	return true;
+}
+// </FS>
@@ -0,0 +1,342 @@
+/**
+ * @file lluuidflatmap.h
+ * @brief Open addressed hash map keyed by LLUUID.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDFLATMAP_H
+#define LL_LLUUIDFLATMAP_H
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "lluuid.h"
+
+/**
+ * Hash map from LLUUID to T with linear probing over one array of slots,
+ * for large tables that are mostly looked up: no node allocation per entry
+ * and a lookup usually touches a single cache line.
+ *
+ * Next to every slot is a control byte, 0 for an empty slot, otherwise a
+ * few hash bits, so probing rarely compares keys that do not match. Erase
+ * shifts the following entries back instead of leaving tombstones.
+ *
+ * The interface follows std::map where it is used, with these differences:
+ * - Iteration order is unspecified.
+ * - Any insert may move entries, which invalidates iterators, pointers and
+ *   references to them. erase() invalidates them as well. Keep values that
+ *   have to stay put on the heap and store pointers.
+ * - T must be default constructible; erased slots are reset to T().
+ */
+template <typename T>
+class LLUUIDFlatMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef T mapped_type;
+	typedef std::pair<LLUUID, T> value_type;
+	typedef size_t size_type;
+
+private:
+	template <typename MAP, typename VALUE>
+	class iterator_base
+	{
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef typename LLUUIDFlatMap::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef VALUE* pointer;
+		typedef VALUE& reference;
+
+		iterator_base() : mMap(NULL), mIndex(0) {}
+		iterator_base(MAP* map, size_t index) : mMap(map), mIndex(index) {}
+		// iterator to const_iterator
+		template <typename OTHER_MAP, typename OTHER_VALUE>
+		iterator_base(const iterator_base<OTHER_MAP, OTHER_VALUE>& other)
+			: mMap(other.mMap), mIndex(other.mIndex) {}
+
+		reference operator*() const		{ return mMap->mSlots[mIndex]; }
+		pointer operator->() const		{ return &mMap->mSlots[mIndex]; }
+
+		iterator_base& operator++()
+		{
+			mIndex = mMap->nextUsed(mIndex + 1);
+			return *this;
+		}
+		iterator_base operator++(int)
+		{
+			iterator_base old(*this);
+			++*this;
+			return old;
+		}
+
+		template <typename OTHER_MAP, typename OTHER_VALUE>
+		bool operator==(const iterator_base<OTHER_MAP, OTHER_VALUE>& other) const
+		{
+			return mIndex == other.mIndex;
+		}
+		template <typename OTHER_MAP, typename OTHER_VALUE>
+		bool operator!=(const iterator_base<OTHER_MAP, OTHER_VALUE>& other) const
+		{
+			return mIndex != other.mIndex;
+		}
+
+	private:
+		template <typename, typename> friend class iterator_base;
+		friend class LLUUIDFlatMap;
+
+		MAP* mMap;
+		size_t mIndex;
+	};
+
+public:
+	typedef iterator_base<LLUUIDFlatMap, value_type> iterator;
+	typedef iterator_base<const LLUUIDFlatMap, const value_type> const_iterator;
+
+	LLUUIDFlatMap() : mSize(0), mMask(0) {}
+
+	iterator begin()				{ return iterator(this, nextUsed(0)); }
+	iterator end()					{ return iterator(this, mSlots.size()); }
+	const_iterator begin() const	{ return const_iterator(this, nextUsed(0)); }
+	const_iterator end() const		{ return const_iterator(this, mSlots.size()); }
+
+	size_type size() const			{ return mSize; }
+	bool empty() const				{ return mSize == 0; }
+
+	iterator find(const LLUUID& key)
+	{
+		return iterator(this, findIndex(key));
+	}
+	const_iterator find(const LLUUID& key) const
+	{
+		return const_iterator(this, findIndex(key));
+	}
+	size_type count(const LLUUID& key) const
+	{
+		return findIndex(key) != mSlots.size() ? 1 : 0;
+	}
+
+	T& operator[](const LLUUID& key)
+	{
+		return mSlots[insertIndex(key).first].second;
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		std::pair<size_t, bool> result = insertIndex(value.first);
+		if (result.second)
+		{
+			mSlots[result.first].second = value.second;
+		}
+		return std::make_pair(iterator(this, result.first), result.second);
+	}
+
+	size_type erase(const LLUUID& key)
+	{
+		size_t index = findIndex(key);
+		if (index == mSlots.size())
+		{
+			return 0;
+		}
+		eraseIndex(index);
+		return 1;
+	}
+
+	void clear()
+	{
+		mSlots.clear();
+		mControl.clear();
+		mSize = 0;
+		mMask = 0;
+	}
+
+	// Makes room for count entries without growing again.
+	void reserve(size_type count)
+	{
+		size_t capacity = MIN_CAPACITY;
+		while (count * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM)
+		{
+			capacity *= 2;
+		}
+		if (capacity > mSlots.size())
+		{
+			rehash(capacity);
+		}
+	}
+
+	void swap(LLUUIDFlatMap& other)
+	{
+		mSlots.swap(other.mSlots);
+		mControl.swap(other.mControl);
+		std::swap(mSize, other.mSize);
+		std::swap(mMask, other.mMask);
+	}
+
+private:
+	static const size_t MIN_CAPACITY = 16;
+	// Grow past 7/10 full; linear probing gets slow much beyond that.
+	static const size_t MAX_LOAD_NUM = 7;
+	static const size_t MAX_LOAD_DEN = 10;
+
+	static U64 hashKey(const LLUUID& key)
+	{
+		// UUIDs are mostly random already, mix both halves anyway so
+		// that made up IDs with a common prefix spread as well.
+		U64 low, high;
+		memcpy(&low, key.mData, sizeof(U64));
+		memcpy(&high, key.mData + sizeof(U64), sizeof(U64));
+		U64 hash = (low ^ (high * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+		return hash ^ (hash >> 32);
+	}
+
+	// Top bit marks the slot used, the rest are hash bits the index does not use
+	static U8 controlFor(U64 hash)	{ return (U8)(0x80 | (hash >> 57)); }
+
+	size_t nextUsed(size_t index) const
+	{
+		const size_t capacity = mControl.size();
+		while (index < capacity && !mControl[index])
+		{
+			++index;
+		}
+		return index;
+	}
+
+	size_t findIndex(const LLUUID& key) const
+	{
+		if (!mSize)
+		{
+			return mSlots.size();
+		}
+		const U64 hash = hashKey(key);
+		const U8 control = controlFor(hash);
+		for (size_t index = hash & mMask; ; index = (index + 1) & mMask)
+		{
+			const U8 slot_control = mControl[index];
+			if (!slot_control)
+			{
+				return mSlots.size();
+			}
+			if (slot_control == control && mSlots[index].first == key)
+			{
+				return index;
+			}
+		}
+	}
+
+	// Index of the entry for key, and whether it was added.
+	std::pair<size_t, bool> insertIndex(const LLUUID& key)
+	{
+		if ((mSize + 1) * MAX_LOAD_DEN > mSlots.size() * MAX_LOAD_NUM)
+		{
+			rehash(mSlots.empty() ? MIN_CAPACITY : mSlots.size() * 2);
+		}
+		const U64 hash = hashKey(key);
+		const U8 control = controlFor(hash);
+		for (size_t index = hash & mMask; ; index = (index + 1) & mMask)
+		{
+			const U8 slot_control = mControl[index];
+			if (!slot_control)
+			{
+				mControl[index] = control;
+				mSlots[index].first = key;
+				++mSize;
+				return std::make_pair(index, true);
+			}
+			if (slot_control == control && mSlots[index].first == key)
+			{
+				return std::make_pair(index, false);
+			}
+		}
+	}
+
+	void eraseIndex(size_t index)
+	{
+		// Shift back every following entry of the probe sequence that
+		// would not be found anymore with a hole at index.
+		size_t hole = index;
+		for (size_t next = (hole + 1) & mMask; mControl[next]; next = (next + 1) & mMask)
+		{
+			const size_t home = hashKey(mSlots[next].first) & mMask;
+			const bool stays = (hole <= next) ? (hole < home && home <= next)
+											  : (hole < home || home <= next);
+			if (!stays)
+			{
+				mSlots[hole] = std::move(mSlots[next]);
+				mControl[hole] = mControl[next];
+				hole = next;
+			}
+		}
+		mControl[hole] = 0;
+		mSlots[hole] = value_type();
+		--mSize;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<value_type> old_slots(capacity);
+		std::vector<U8> old_control(capacity, 0);
+		old_slots.swap(mSlots);
+		old_control.swap(mControl);
+		mMask = capacity - 1;
+
+		for (size_t i = 0; i < old_control.size(); ++i)
+		{
+			if (!old_control[i])
+			{
+				continue;
+			}
+			size_t index = hashKey(old_slots[i].first) & mMask;
+			while (mControl[index])
+			{
+				index = (index + 1) & mMask;
+			}
+			mControl[index] = old_control[i];
+			mSlots[index] = std::move(old_slots[i]);
+		}
+	}
+
+	std::vector<value_type> mSlots;
+	std::vector<U8> mControl;
+	size_t mSize;
+	size_t mMask;
+};
+
+// Counterparts of the llstl.h helpers for std::map
+template <typename T>
+inline T* get_ptr_in_map(const LLUUIDFlatMap<T*>& inmap, const LLUUID& key)
+{
+	typename LLUUIDFlatMap<T*>::const_iterator iter = inmap.find(key);
+	return (iter == inmap.end()) ? NULL : iter->second;
+}
+
+template <typename T>
+inline bool is_in_map(const LLUUIDFlatMap<T>& inmap, const LLUUID& key)
+{
+	return inmap.find(key) != inmap.end();
+}
+
+#endif // LL_LLUUIDFLATMAP_H
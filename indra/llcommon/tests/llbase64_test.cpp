@@ -31,8 +31,10 @@
 
 #include "../llbase64.h"
 #include "../lluuid.h"
+#include "apr_base64.h" // <FS/> SIMD base64
 
 #include "../test/lltut.h"
+#include "stringize.h" // <FS/> SIMD base64
 
 namespace tut
 {
@@ -74,4 +76,55 @@ namespace tut
 				(result == "c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==") );
 	}
 
+	// <FS> SIMD base64
+	template<> template<>
+	void base64_object::test<3>()
+	{
+		// Every length around the 12 byte blocks, against apr
+		std::vector<U8> blob;
+		for (S32 size = 0; size < 100; ++size)
+		{
+			std::string result = LLBase64::encode(blob.empty() ? NULL : &blob[0], blob.size());
+			std::string expected;
+			if (!blob.empty())
+			{
+				std::vector<char> apr_buffer(apr_base64_encode_len(blob.size()));
+				apr_base64_encode_binary(&apr_buffer[0], &blob[0], blob.size());
+				expected = &apr_buffer[0];
+			}
+			ensure_equals(STRINGIZE("encode " << size << " bytes"), result, expected);
+			ensure_equals("encode length", result.size(), LLBase64::encodeLength(blob.size()));
+
+			std::vector<U8> decoded;
+			LLBase64::decode(result, decoded);
+			ensure(STRINGIZE("decode " << size << " bytes"), decoded == blob);
+
+			blob.push_back((U8)(size * 37 + 11));
+		}
+	}
+
+	template<> template<>
+	void base64_object::test<4>()
+	{
+		U8 blob[40] = { 115, 223, 172, 255, 140, 70, 49, 125, 236, 155, 45, 199, 101, 17, 164, 131, 230, 19, 80, 64, 112, 53, 135, 98, 237, 12, 26, 72, 126, 14, 145, 143, 118, 196, 11, 177, 132, 169, 195, 134 };
+		std::vector<U8> expected(blob, blob + 40);
+		std::vector<U8> decoded;
+
+		LLBase64::decode("c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==", decoded);
+		ensure("decode 40 bytes", decoded == expected);
+
+		LLBase64::decode("c9+s/4xGMX3smy3H\nZRGkg+YTUEBwNYdi\r\n 7QwaSH4O\tkY92xAuxhKnDhg==\n", decoded);
+		ensure("decode with whitespace", decoded == expected);
+
+		LLBase64::decode("c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg", decoded);
+		ensure("decode without padding", decoded == expected);
+
+		LLBase64::decode("c9+s/4xG*MX3smy3HZRGkg+YTUEBwNYdi", decoded);
+		ensure_equals("decode stops at garbage", decoded.size(), 6);
+
+		LLBase64::decode("", decoded);
+		ensure("decode nothing", decoded.empty());
+	}
+	// </FS>
+
 }
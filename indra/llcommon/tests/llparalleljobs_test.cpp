@@ -0,0 +1,133 @@
+/**
+ * @file   llparalleljobs_test.cpp
+ * @brief  Test for llparalleljobs.h.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llparalleljobs.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../threadpool.h"
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct paralleljobs_data
+	{
+	};
+	typedef test_group<paralleljobs_data> paralleljobs_test;
+	typedef paralleljobs_test::object paralleljobs_object;
+	tut::paralleljobs_test paralleljobs("LLParallelJobs");
+
+	template<> template<>
+	void paralleljobs_object::test<1>()
+	{
+		set_test_name("every job runs once");
+
+		LL::ThreadPool pool("ParallelJobsOnce", 3);
+		pool.start();
+
+		std::vector<std::atomic<U32> > runs(1000);
+		for (std::atomic<U32>& run : runs)
+		{
+			run = 0;
+		}
+		const U32 helper_jobs = LL::runParallelJobs((U32)runs.size(), [&runs](U32 i) { ++runs[i]; }, 3, "ParallelJobsOnce");
+		ensure("helper jobs counted", helper_jobs <= runs.size());
+		for (U32 i = 0; i < runs.size(); ++i)
+		{
+			ensure_equals(llformat("job %u", i), (U32)runs[i], 1U);
+		}
+
+		bool called = false;
+		ensure_equals("no jobs", LL::runParallelJobs(0, [&called](U32) { called = true; }, 3, "ParallelJobsOnce"), 0U);
+		ensure("no job called", !called);
+
+		pool.close();
+	}
+
+	template<> template<>
+	void paralleljobs_object::test<2>()
+	{
+		set_test_name("a helper runs a job while the caller runs another");
+
+		LL::ThreadPool pool("ParallelJobsHelper", 1);
+		pool.start();
+
+		// Whichever job comes first waits for the other one to start, which
+		// only happens if they run on different threads.
+		std::mutex mutex;
+		std::condition_variable condition;
+		U32 started = 0;
+		bool together = true;
+		const U32 helper_jobs = LL::runParallelJobs(2, [&](U32)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				++started;
+				condition.notify_all();
+				if (!condition.wait_for(lock, std::chrono::seconds(10), [&started]() { return started == 2; }))
+				{
+					together = false;
+				}
+			}, 3, "ParallelJobsHelper");
+		ensure("jobs ran at the same time", together);
+		ensure_equals("one job on the helper", helper_jobs, 1U);
+
+		pool.close();
+	}
+
+	template<> template<>
+	void paralleljobs_object::test<3>()
+	{
+		set_test_name("everything on the calling thread without helpers");
+
+		LL::ThreadPool pool("ParallelJobsSerial", 3);
+		pool.start();
+
+		const std::thread::id caller = std::this_thread::get_id();
+		bool on_caller = true;
+		U32 runs = 0;
+		auto job = [&](U32)
+			{
+				on_caller = on_caller && std::this_thread::get_id() == caller;
+				++runs;
+			};
+
+		ensure_equals("no helpers wanted", LL::runParallelJobs(100, job, 0, "ParallelJobsSerial"), 0U);
+		ensure_equals("no such queue", LL::runParallelJobs(100, job, 3, "ParallelJobsMissing"), 0U);
+		ensure_equals("single job", LL::runParallelJobs(1, job, 3, "ParallelJobsSerial"), 0U);
+		ensure("on the calling thread", on_caller);
+		ensure_equals("all ran", runs, 201U);
+
+		pool.close();
+	}
+}
@@ -57,6 +57,13 @@ using namespace boost::phoenix;
 #include "llsdutil.h"
 #include "../llformat.h"
 
+#include "../lltimer.h"
+// <FS> Buffer parse, SIMD base64 and XML escape
+#include "../llbase64.h"
+#include "apr_base64.h"
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+// </FS>
 #include "../test/lltut.h"
 #include "../test/namedtempfile.h"
 #include "stringize.h"
@@ -1911,4 +1918,657 @@ namespace tut
                       "lines.");
         
     }
+
+    // <FS> Arena allocation
+    struct TestLLSDArena
+    {
+        TestLLSDArena()
+        {
+            LLSDParser::setUseArena(false);
+        }
+        ~TestLLSDArena()
+        {
+            LLSDParser::setUseArena(false);
+        }
+
+        // Looks like an AIS folder listing: an array of item maps with
+        // nested permission and sale info maps.
+        static LLSD makeDocument(S32 items)
+        {
+            LLSD doc = LLSD::emptyArray();
+            for (S32 i = 0; i < items; ++i)
+            {
+                LLSD permissions;
+                permissions["creator_id"] = LLUUID::generateNewID();
+                permissions["owner_id"] = LLUUID::generateNewID();
+                permissions["group_id"] = LLUUID::null;
+                permissions["base_mask"] = 0x7fffffff;
+                permissions["owner_mask"] = 0x7fffffff;
+                permissions["everyone_mask"] = 0;
+                permissions["is_owner_group"] = false;
+
+                LLSD sale_info;
+                sale_info["sale_price"] = 10;
+                sale_info["sale_type"] = 0;
+
+                LLSD item;
+                item["item_id"] = LLUUID::generateNewID();
+                item["parent_id"] = LLUUID::generateNewID();
+                item["asset_id"] = LLUUID::generateNewID();
+                item["name"] = STRINGIZE("Inventory item number " << i);
+                item["desc"] = "(No Description)";
+                item["type"] = i % 20;
+                item["inv_type"] = i % 18;
+                item["flags"] = i;
+                item["created_at"] = 1600000000 + i;
+                item["permissions"] = permissions;
+                item["sale_info"] = sale_info;
+                doc.append(item);
+            }
+            return doc;
+        }
+    };
+    typedef tut::test_group<TestLLSDArena> TestLLSDArenaGroup;
+    typedef TestLLSDArenaGroup::object TestLLSDArenaObject;
+    TestLLSDArenaGroup gTestLLSDArenaGroup("llsd arena allocation");
+
+    template<> template<>
+    void TestLLSDArenaObject::test<1>()
+    {
+        set_test_name("values outlive their scope and free their blocks");
+
+        ensure_equals("no arena blocks to start with", llsd::arenaBlockCount(), 0U);
+        LLSD kept;
+        {
+            LLSD doc;
+            {
+                LLSD::ArenaScope arena;
+                doc = makeDocument(500);
+            }
+            ensure("document built in blocks", llsd::arenaBlockCount() > 1);
+            ensure_equals("arena document is intact", doc.size(), 500);
+            ensure_equals(doc[499]["sale_info"]["sale_price"].asInteger(), 10);
+
+            // Changing a value built in the arena outside of it
+            doc[0]["name"] = "renamed";
+            doc[0]["flags"] = LLSD::emptyMap();
+            ensure_equals(doc[0]["name"].asString(), "renamed");
+
+            kept = doc[250]["name"];
+        }
+        ensure_equals("one value keeps its block", llsd::arenaBlockCount(), 1U);
+        ensure_equals(kept.asString(), "Inventory item number 250");
+
+        kept.clear();
+        ensure_equals("all blocks freed", llsd::arenaBlockCount(), 0U);
+        ensure_equals(llsd::arenaBlockBytes(), (U64)0);
+
+        LLSD::ArenaScope disabled(false);
+        LLSD value = LLSD::emptyMap();
+        ensure_equals("disabled scope uses the heap", llsd::arenaBlockCount(), 0U);
+    }
+
+    template<> template<>
+    void TestLLSDArenaObject::test<2>()
+    {
+        set_test_name("arena parse matches heap parse");
+
+        LLSD doc = makeDocument(300);
+        std::ostringstream xml;
+        LLSDSerialize::toXML(doc, xml);
+        std::ostringstream binary;
+        LLSDSerialize::toBinary(doc, binary);
+        std::ostringstream notation;
+        LLSDSerialize::toNotation(doc, notation);
+
+        LLSDParser::setUseArena(true);
+        LLSD parsed;
+        std::istringstream xml_in(xml.str());
+        ensure("xml parse", LLSDSerialize::fromXML(parsed, xml_in) > 0);
+        ensure("xml in arena", llsd::arenaBlockCount() > 0);
+        ensure("xml matches", llsd_equals(doc, parsed));
+
+        std::istringstream binary_in(binary.str());
+        ensure("binary parse", LLSDSerialize::fromBinary(parsed, binary_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure("binary matches", llsd_equals(doc, parsed));
+
+        std::istringstream notation_in(notation.str());
+        ensure("notation parse", LLSDSerialize::fromNotation(parsed, notation_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure("notation matches", llsd_equals(doc, parsed));
+
+        parsed.clear();
+        ensure_equals("all blocks freed", llsd::arenaBlockCount(), 0U);
+    }
+
+    template<> template<>
+    void TestLLSDArenaObject::test<3>()
+    {
+        set_test_name("benchmark arena parse of a large document");
+
+        const S32 ITEMS = 20000;
+        const S32 PASSES = 3;
+
+        std::ostringstream xml_out;
+        std::ostringstream binary_out;
+        {
+            LLSD doc = makeDocument(ITEMS);
+            LLSDSerialize::toXML(doc, xml_out);
+            LLSDSerialize::toBinary(doc, binary_out);
+        }
+        const std::string xml = xml_out.str();
+        const std::string binary = binary_out.str();
+
+        for (S32 use_arena = 0; use_arena < 2; ++use_arena)
+        {
+            LLSDParser::setUseArena(use_arena != 0);
+
+            F64 xml_time = 0.0;
+            F64 binary_time = 0.0;
+            U64 arena_bytes = 0;
+            for (S32 pass = 0; pass < PASSES; ++pass)
+            {
+                LLSD parsed;
+                std::istringstream xml_in(xml);
+                LLTimer timer;
+                ensure("xml parse", LLSDSerialize::fromXML(parsed, xml_in) > 0);
+                xml_time += timer.getElapsedTimeF64();
+                ensure_equals(parsed.size(), ITEMS);
+                arena_bytes = llmax(arena_bytes, llsd::arenaBlockBytes());
+
+                std::istringstream binary_in(binary);
+                timer.reset();
+                ensure("binary parse", LLSDSerialize::fromBinary(parsed, binary_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+                binary_time += timer.getElapsedTimeF64();
+                ensure_equals(parsed.size(), ITEMS);
+            }
+            ensure_equals("all blocks freed", llsd::arenaBlockCount(), 0U);
+
+            LL_INFOS("LLSDArena") << (use_arena ? "arena" : "heap ") << ": xml "
+                                  << xml.size() / 1024 << " KB in " << xml_time * 1000.0 / PASSES
+                                  << " ms, binary " << binary.size() / 1024 << " KB in "
+                                  << binary_time * 1000.0 / PASSES << " ms, peak arena blocks "
+                                  << arena_bytes / 1024 << " KB" << LL_ENDL;
+        }
+    }
+    // </FS>
+
+    // <FS> Streaming parse
+    // Builds the LLSD back up from the events, the way the tree parsers would
+    class LLSDTreeBuilder : public LLSDVisitor
+    {
+    public:
+        LLSD mResult;
+
+        bool startMap(S32 size) override     { return push(LLSD::emptyMap()); }
+        bool key(const std::string& key) override { mKey = key; return true; }
+        bool endMap() override               { mStack.pop_back(); return true; }
+        bool startArray(S32 size) override   { return push(LLSD::emptyArray()); }
+        bool endArray() override             { mStack.pop_back(); return true; }
+
+        bool undefined() override                       { add(LLSD()); return true; }
+        bool value(LLSD::Boolean value) override        { add(value); return true; }
+        bool value(LLSD::Integer value) override        { add(value); return true; }
+        bool value(LLSD::Real value) override           { add(value); return true; }
+        bool value(const LLSD::String& value) override  { add(value); return true; }
+        bool value(const LLSD::UUID& value) override    { add(value); return true; }
+        bool value(const LLSD::Date& value) override    { add(value); return true; }
+        bool value(const LLSD::URI& value) override     { add(value); return true; }
+        bool value(const LLSD::Binary& value) override  { add(value); return true; }
+
+    private:
+        LLSD& add(const LLSD& value)
+        {
+            if (mStack.empty())
+            {
+                mResult = value;
+                return mResult;
+            }
+            LLSD& parent = *mStack.back();
+            if (parent.isMap())
+            {
+                return parent[mKey] = value;
+            }
+            parent.append(value);
+            return parent[parent.size() - 1];
+        }
+
+        bool push(const LLSD& container)
+        {
+            mStack.push_back(&add(container));
+            return true;
+        }
+
+        std::vector<LLSD*> mStack;
+        std::string mKey;
+    };
+
+    // Collects the item ids of an AIS style listing and nothing else
+    class LLSDItemIdCollector : public LLSDVisitor
+    {
+    public:
+        LLSDItemIdCollector(S32 max_ids = -1) : mMaxIDs(max_ids), mWantValue(false) {}
+
+        bool key(const std::string& key) override
+        {
+            mWantValue = (key == "item_id");
+            return true;
+        }
+        bool value(const LLSD::UUID& value) override
+        {
+            if (mWantValue)
+            {
+                mIDs.push_back(value);
+                mWantValue = false;
+            }
+            return mMaxIDs < 0 || (S32)mIDs.size() < mMaxIDs;
+        }
+
+        std::vector<LLUUID> mIDs;
+
+    private:
+        S32 mMaxIDs;
+        bool mWantValue;
+    };
+
+    struct TestLLSDVisitor
+    {
+        static LLSD makeDocument(S32 items)
+        {
+            LLSD doc = TestLLSDArena::makeDocument(items);
+            // Cover the types the listing does not use
+            LLSD extra;
+            extra["undef"] = LLSD();
+            extra["real"] = 3.25;
+            extra["true"] = true;
+            extra["empty_string"] = "";
+            extra["escaped"] = "a'b\"c<d>&e\\f\n";
+            extra["date"] = LLDate(1600000000.5);
+            extra["uri"] = LLURI("http://example.com/a?b=c&d=e");
+            extra["empty_map"] = LLSD::emptyMap();
+            extra["empty_array"] = LLSD::emptyArray();
+            std::vector<U8> binary;
+            for (U8 i = 0; i < 40; ++i) binary.push_back(i * 7);
+            extra["binary"] = binary;
+            extra["empty_binary"] = LLSD::Binary();
+            doc.append(extra);
+            return doc;
+        }
+    };
+    typedef tut::test_group<TestLLSDVisitor> TestLLSDVisitorGroup;
+    typedef TestLLSDVisitorGroup::object TestLLSDVisitorObject;
+    TestLLSDVisitorGroup gTestLLSDVisitorGroup("llsd streaming parse");
+
+    template<> template<>
+    void TestLLSDVisitorObject::test<1>()
+    {
+        set_test_name("visiting rebuilds the document in every format");
+
+        LLSD doc = makeDocument(50);
+
+        std::ostringstream xml_out;
+        LLSDSerialize::toXML(doc, xml_out);
+        std::istringstream xml_in(xml_out.str());
+        LLSDTreeBuilder xml_builder;
+        ensure("xml visit", LLSDSerialize::visitXML(xml_builder, xml_in) > 0);
+        ensure("xml matches", llsd_equals(doc, xml_builder.mResult));
+
+        std::ostringstream binary_out;
+        LLSDSerialize::toBinary(doc, binary_out);
+        std::istringstream binary_in(binary_out.str());
+        LLSDTreeBuilder binary_builder;
+        ensure("binary visit", LLSDSerialize::visitBinary(binary_builder, binary_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure("binary matches", llsd_equals(doc, binary_builder.mResult));
+
+        std::ostringstream notation_out;
+        LLSDSerialize::toNotation(doc, notation_out);
+        std::istringstream notation_in(notation_out.str());
+        LLSDTreeBuilder notation_builder;
+        ensure("notation visit", LLSDSerialize::visitNotation(notation_builder, notation_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure("notation matches", llsd_equals(doc, notation_builder.mResult));
+
+        std::istringstream bad_in("[i1,i2");
+        LLSDTreeBuilder bad_builder;
+        ensure_equals("truncated notation fails",
+                      LLSDSerialize::visitNotation(bad_builder, bad_in, LLSDSerialize::SIZE_UNLIMITED),
+                      LLSDParser::PARSE_FAILURE);
+    }
+
+    template<> template<>
+    void TestLLSDVisitorObject::test<2>()
+    {
+        set_test_name("writers match the formatters");
+
+        LLSD doc = makeDocument(20);
+
+        std::ostringstream xml_expected, xml_written;
+        LLSDSerialize::toXML(doc, xml_expected);
+        LLSDXMLWriter xml_writer(xml_written);
+        ensure("xml walk", xml_writer.walk(doc));
+        ensure("xml complete", xml_writer.isComplete());
+        ensure_equals("xml", xml_written.str(), xml_expected.str());
+
+        std::ostringstream binary_expected, binary_written;
+        LLSDSerialize::toBinary(doc, binary_expected);
+        LLSDBinaryWriter binary_writer(binary_written);
+        ensure("binary walk", binary_writer.walk(doc));
+        ensure_equals("binary", binary_written.str(), binary_expected.str());
+
+        std::ostringstream notation_expected, notation_written;
+        LLSDSerialize::toNotation(doc, notation_expected);
+        LLSDNotationWriter notation_writer(notation_written);
+        ensure("notation walk", notation_writer.walk(doc));
+        ensure_equals("notation", notation_written.str(), notation_expected.str());
+
+        // Binary sizes written up front get patched when they were unknown
+        std::ostringstream unsized_written;
+        LLSDBinaryWriter unsized_writer(unsized_written);
+        unsized_writer.startArray(-1);
+        unsized_writer.value(LLSD::Integer(1));
+        unsized_writer.startMap(-1);
+        unsized_writer.key("a");
+        unsized_writer.value(LLSD::String("b"));
+        unsized_writer.endMap();
+        unsized_writer.endArray();
+        LLSD small = llsd::array(1, llsd::map("a", "b"));
+        std::ostringstream small_expected;
+        LLSDSerialize::toBinary(small, small_expected);
+        ensure_equals("patched sizes", unsized_written.str(), small_expected.str());
+
+        // Converting between formats without building an LLSD
+        std::istringstream xml_in(xml_expected.str());
+        std::ostringstream converted;
+        LLSDNotationWriter converter(converted);
+        ensure("convert", LLSDSerialize::visitXML(converter, xml_in) > 0);
+        ensure_equals("converted", converted.str(), notation_expected.str());
+    }
+
+    template<> template<>
+    void TestLLSDVisitorObject::test<3>()
+    {
+        set_test_name("visitor stops the parse");
+
+        LLSD doc = TestLLSDArena::makeDocument(100);
+        std::ostringstream xml_out, binary_out, notation_out;
+        LLSDSerialize::toXML(doc, xml_out);
+        LLSDSerialize::toBinary(doc, binary_out);
+        LLSDSerialize::toNotation(doc, notation_out);
+
+        std::istringstream xml_in(xml_out.str());
+        LLSDItemIdCollector xml_ids(3);
+        ensure("xml stop", LLSDSerialize::visitXML(xml_ids, xml_in) > 0);
+        ensure_equals("xml ids", xml_ids.mIDs.size(), 3);
+        ensure_equals("xml first id", xml_ids.mIDs[0], doc[0]["item_id"].asUUID());
+
+        std::istringstream binary_in(binary_out.str());
+        LLSDItemIdCollector binary_ids(3);
+        ensure("binary stop", LLSDSerialize::visitBinary(binary_ids, binary_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure_equals("binary ids", binary_ids.mIDs.size(), 3);
+        ensure_equals("binary third id", binary_ids.mIDs[2], doc[2]["item_id"].asUUID());
+
+        std::istringstream notation_in(notation_out.str());
+        LLSDItemIdCollector notation_ids(3);
+        ensure("notation stop", LLSDSerialize::visitNotation(notation_ids, notation_in, LLSDSerialize::SIZE_UNLIMITED) > 0);
+        ensure_equals("notation ids", notation_ids.mIDs.size(), 3);
+    }
+
+    template<> template<>
+    void TestLLSDVisitorObject::test<4>()
+    {
+        set_test_name("benchmark field extraction against tree parse");
+
+        const S32 ITEMS = 20000;
+        const S32 PASSES = 3;
+
+        LLSD doc = TestLLSDArena::makeDocument(ITEMS);
+        std::ostringstream xml_out, binary_out;
+        LLSDSerialize::toXML(doc, xml_out);
+        LLSDSerialize::toBinary(doc, binary_out);
+        doc.clear();
+        const std::string xml = xml_out.str();
+        const std::string binary = binary_out.str();
+
+        F64 xml_tree_time = 0.0, xml_visit_time = 0.0;
+        F64 binary_tree_time = 0.0, binary_visit_time = 0.0;
+        for (S32 pass = 0; pass < PASSES; ++pass)
+        {
+            LLTimer timer;
+            {
+                std::istringstream xml_in(xml);
+                LLSD parsed;
+                LLSDSerialize::fromXML(parsed, xml_in);
+                std::vector<LLUUID> ids;
+                for (LLSD::array_const_iterator it = parsed.beginArray(); it != parsed.endArray(); ++it)
+                {
+                    ids.push_back((*it)["item_id"].asUUID());
+                }
+                ensure_equals(ids.size(), ITEMS);
+            }
+            xml_tree_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            {
+                std::istringstream xml_in(xml);
+                LLSDItemIdCollector ids;
+                LLSDSerialize::visitXML(ids, xml_in);
+                ensure_equals(ids.mIDs.size(), ITEMS);
+            }
+            xml_visit_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            {
+                std::istringstream binary_in(binary);
+                LLSD parsed;
+                LLSDSerialize::fromBinary(parsed, binary_in, LLSDSerialize::SIZE_UNLIMITED);
+                std::vector<LLUUID> ids;
+                for (LLSD::array_const_iterator it = parsed.beginArray(); it != parsed.endArray(); ++it)
+                {
+                    ids.push_back((*it)["item_id"].asUUID());
+                }
+                ensure_equals(ids.size(), ITEMS);
+            }
+            binary_tree_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            {
+                std::istringstream binary_in(binary);
+                LLSDItemIdCollector ids;
+                LLSDSerialize::visitBinary(ids, binary_in, LLSDSerialize::SIZE_UNLIMITED);
+                ensure_equals(ids.mIDs.size(), ITEMS);
+            }
+            binary_visit_time += timer.getElapsedTimeF64();
+        }
+
+        LL_INFOS("LLSDVisitor") << ITEMS << " item ids: xml tree " << xml_tree_time * 1000.0 / PASSES
+                                << " ms, visit " << xml_visit_time * 1000.0 / PASSES
+                                << " ms; binary tree " << binary_tree_time * 1000.0 / PASSES
+                                << " ms, visit " << binary_visit_time * 1000.0 / PASSES << " ms" << LL_ENDL;
+    }
+    // </FS>
+
+    // <FS> Buffer parse, SIMD base64 and XML escape
+    struct TestLLSDBuffer
+    {
+        // The stream based escape as it was, for comparison
+        static std::string escapeReference(const std::string& in)
+        {
+            std::ostringstream out;
+            for (std::string::const_iterator it = in.begin(); it != in.end(); ++it)
+            {
+                if (*it >= 0 && *it < 20 && *it != 0x09 && *it != 0x0A && *it != 0x0D)
+                {
+                    out << "?";
+                    continue;
+                }
+                switch (*it)
+                {
+                    case '<': out << "&lt;"; break;
+                    case '>': out << "&gt;"; break;
+                    case '&': out << "&amp;"; break;
+                    case '\'': out << "&apos;"; break;
+                    case '"': out << "&quot;"; break;
+                    default: out << *it; break;
+                }
+            }
+            return out.str();
+        }
+    };
+    typedef tut::test_group<TestLLSDBuffer> TestLLSDBufferGroup;
+    typedef TestLLSDBufferGroup::object TestLLSDBufferObject;
+    TestLLSDBufferGroup gTestLLSDBufferGroup("llsd buffer parse and escaping");
+
+    template<> template<>
+    void TestLLSDBufferObject::test<1>()
+    {
+        set_test_name("buffer parse matches stream parse");
+
+        LLSD doc = TestLLSDVisitor::makeDocument(50);
+        std::ostringstream binary_out;
+        LLSDSerialize::toBinary(doc, binary_out);
+        const std::string binary = binary_out.str();
+
+        LLSD parsed;
+        size_t bytes_read = 0;
+        S32 count = LLSDSerialize::fromBinary(parsed, (const U8*)binary.data(), binary.size(), -1, &bytes_read);
+        ensure("buffer parse", count > 0);
+        ensure("matches", llsd_equals(doc, parsed));
+        ensure_equals("whole buffer read", bytes_read, binary.size());
+
+        LLSD stream_parsed;
+        std::istringstream binary_in(binary);
+        ensure_equals("same count", LLSDSerialize::fromBinary(stream_parsed, binary_in, LLSDSerialize::SIZE_UNLIMITED), count);
+
+        // Notation style strings and keys are allowed in binary
+        const char mixed[] = "{\0\0\0\x02'a'\"x\\\"y\"k\0\0\0\x01" "bi\0\0\0\x07}trailing";
+        bytes_read = 0;
+        ensure("mixed parse", LLSDSerialize::fromBinary(parsed, (const U8*)mixed, sizeof(mixed) - 1, -1, &bytes_read) > 0);
+        ensure_equals("mixed a", parsed["a"].asString(), "x\"y");
+        ensure_equals("mixed b", parsed["b"].asInteger(), 7);
+        ensure_equals("stops after the object", bytes_read, sizeof(mixed) - 1 - strlen("trailing"));
+
+        // Never reads past the end, and a cut short document never parses
+        for (size_t size = 1; size < 400; ++size)
+        {
+            ensure_equals(STRINGIZE("truncated at " << size),
+                          LLSDSerialize::fromBinary(parsed, (const U8*)binary.data(), size),
+                          LLSDParser::PARSE_FAILURE);
+        }
+
+        ensure_equals("depth limit", LLSDSerialize::fromBinary(parsed, (const U8*)binary.data(), binary.size(), 1),
+                      LLSDParser::PARSE_FAILURE);
+    }
+
+    template<> template<>
+    void TestLLSDBufferObject::test<2>()
+    {
+        set_test_name("escapeString matches the stream based escape");
+
+        const char specials[] = { '<', '>', '&', '\'', '"', '\t', '\n', '\r', '\x01', '\x13', '\x14', ' ', 'a', '\xc3', '\xa9' };
+        std::string text;
+        U32 seed = 1;
+        for (S32 i = 0; i < 2000; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            text += specials[(seed >> 16) % sizeof(specials)];
+            ensure_equals(STRINGIZE("escape " << text.size() << " characters"),
+                          LLSDXMLFormatter::escapeString(text), escapeReference(text));
+        }
+        std::string plain(100, 'x');
+        ensure_equals("nothing to escape", LLSDXMLFormatter::escapeString(plain), plain);
+    }
+
+    template<> template<>
+    void TestLLSDBufferObject::test<3>()
+    {
+        set_test_name("benchmark buffer parse, base64 and escaping");
+
+        const S32 PASSES = 5;
+
+        // Binary parse of a large document from memory
+        std::ostringstream binary_out;
+        LLSDSerialize::toBinary(TestLLSDArena::makeDocument(20000), binary_out);
+        const std::string binary = binary_out.str();
+        F64 stream_time = 0.0, buffer_time = 0.0;
+        for (S32 pass = 0; pass < PASSES; ++pass)
+        {
+            LLTimer timer;
+            {
+                LLSD parsed;
+                boost::iostreams::stream<boost::iostreams::array_source> istr(binary.data(), binary.size());
+                ensure("stream parse", LLSDSerialize::fromBinary(parsed, istr, binary.size()) > 0);
+            }
+            stream_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            {
+                LLSD parsed;
+                ensure("buffer parse", LLSDSerialize::fromBinary(parsed, (const U8*)binary.data(), binary.size()) > 0);
+            }
+            buffer_time += timer.getElapsedTimeF64();
+        }
+        LL_INFOS("LLSDBuffer") << "binary parse of " << binary.size() / 1024 << " KB: stream "
+                               << stream_time * 1000.0 / PASSES << " ms, buffer "
+                               << buffer_time * 1000.0 / PASSES << " ms" << LL_ENDL;
+
+        // Base64 of 4 MB
+        std::vector<U8> blob(4 * 1024 * 1024);
+        for (size_t i = 0; i < blob.size(); ++i)
+        {
+            blob[i] = (U8)(i * 2654435761U >> 13);
+        }
+        std::vector<char> apr_encoded(apr_base64_encode_len(blob.size()));
+        std::vector<U8> apr_decoded(blob.size() + 3);
+        std::string encoded;
+        std::vector<U8> decoded;
+        F64 apr_encode_time = 0.0, apr_decode_time = 0.0, encode_time = 0.0, decode_time = 0.0;
+        for (S32 pass = 0; pass < PASSES; ++pass)
+        {
+            LLTimer timer;
+            apr_base64_encode_binary(&apr_encoded[0], &blob[0], blob.size());
+            apr_encode_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            apr_base64_decode_binary(&apr_decoded[0], &apr_encoded[0]);
+            apr_decode_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            encoded = LLBase64::encode(&blob[0], blob.size());
+            encode_time += timer.getElapsedTimeF64();
+
+            timer.reset();
+            LLBase64::decode(encoded, decoded);
+            decode_time += timer.getElapsedTimeF64();
+        }
+        ensure("base64 round trip", decoded == blob);
+        const F64 megabytes = blob.size() / (1024.0 * 1024.0) * PASSES;
+        LL_INFOS("LLSDBuffer") << "base64 MB/s: apr encode " << megabytes / apr_encode_time
+                               << ", decode " << megabytes / apr_decode_time
+                               << "; LLBase64 encode " << megabytes / encode_time
+                               << ", decode " << megabytes / decode_time << LL_ENDL;
+
+        // Escaping typical inventory names and descriptions
+        std::vector<std::string> names;
+        for (S32 i = 0; i < 100000; ++i)
+        {
+            names.push_back(i % 10 ? STRINGIZE("Inventory item number " << i)
+                                   : STRINGIZE("Shirt <" << i << "> & \"pants\""));
+        }
+        size_t total = 0;
+        LLTimer timer;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            total += escapeReference(names[i]).size();
+        }
+        F64 reference_time = timer.getElapsedTimeF64();
+        timer.reset();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            total -= LLSDXMLFormatter::escapeString(names[i]).size();
+        }
+        F64 escape_time = timer.getElapsedTimeF64();
+        ensure_equals("same escaped length", total, 0);
+        LL_INFOS("LLSDBuffer") << "escape " << names.size() << " names: stream "
+                               << reference_time * 1000.0 << " ms, SIMD " << escape_time * 1000.0
+                               << " ms" << LL_ENDL;
+    }
+    // </FS>
 }
@@ -0,0 +1,355 @@
+/**
+ * @file   lluuidflatmap_test.cpp
+ * @brief  Test for lluuidflatmap.h, with an inventory sized benchmark.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lluuidflatmap.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+#include "../llstl.h"
+#include "../lltimer.h"
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct uuidflatmap_data
+	{
+		// Deterministic ids, so failures reproduce
+		static LLUUID makeID(std::mt19937& random)
+		{
+			LLUUID id;
+			for (S32 i = 0; i < UUID_BYTES; i += 4)
+			{
+				U32 bits = random();
+				memcpy(id.mData + i, &bits, 4);
+			}
+			return id;
+		}
+	};
+	typedef test_group<uuidflatmap_data> uuidflatmap_test;
+	typedef uuidflatmap_test::object uuidflatmap_object;
+	tut::uuidflatmap_test uuidflatmap("LLUUIDFlatMap");
+
+	template<> template<>
+	void uuidflatmap_object::test<1>()
+	{
+		set_test_name("random inserts and erases match std::map");
+
+		std::mt19937 random(1);
+		std::vector<LLUUID> ids;
+		for (S32 i = 0; i < 3000; ++i)
+		{
+			ids.push_back(makeID(random));
+		}
+
+		LLUUIDFlatMap<S32> flat;
+		std::map<LLUUID, S32> reference;
+		for (S32 step = 0; step < 100000; ++step)
+		{
+			const LLUUID& id = ids[random() % ids.size()];
+			switch (random() % 4)
+			{
+				case 0:
+				case 1:
+					flat[id] = step;
+					reference[id] = step;
+					break;
+				case 2:
+					ensure_equals("erase", flat.erase(id), reference.erase(id));
+					break;
+				default:
+				{
+					LLUUIDFlatMap<S32>::const_iterator found = flat.find(id);
+					std::map<LLUUID, S32>::const_iterator expected = reference.find(id);
+					ensure_equals("find", found == flat.end(), expected == reference.end());
+					if (expected != reference.end())
+					{
+						ensure_equals("value", found->second, expected->second);
+					}
+					break;
+				}
+			}
+			ensure_equals("size", flat.size(), reference.size());
+		}
+
+		// Iteration sees every entry once
+		std::map<LLUUID, S32> seen;
+		for (LLUUIDFlatMap<S32>::iterator it = flat.begin(); it != flat.end(); ++it)
+		{
+			ensure("unique", seen.insert(*it).second);
+		}
+		ensure("all entries", seen == reference);
+	}
+
+	template<> template<>
+	void uuidflatmap_object::test<2>()
+	{
+		set_test_name("std::map style helpers");
+
+		LLUUIDFlatMap<S32*> flat;
+		S32 value = 5;
+		LLUUID id;
+		id.generate();
+		ensure("empty", flat.empty());
+		ensure("not in empty map", !is_in_map(flat, id));
+		ensure("null from empty map", get_ptr_in_map(flat, id) == NULL);
+
+		ensure("insert", flat.insert(std::make_pair(id, &value)).second);
+		ensure("insert existing", !flat.insert(std::make_pair(id, (S32*)NULL)).second);
+		ensure_equals("get_ptr_in_map", get_ptr_in_map(flat, id), &value);
+		ensure("is_in_map", is_in_map(flat, id));
+		ensure("null key missing", !flat.count(LLUUID::null));
+
+		flat.reserve(1000);
+		ensure_equals("reserve keeps entries", get_ptr_in_map(flat, id), &value);
+
+		LLUUIDFlatMap<S32*> other;
+		other.swap(flat);
+		ensure("swapped out", flat.empty());
+		ensure_equals("swapped in", other.size(), 1);
+		other.clear();
+		ensure("cleared", other.find(id) == other.end());
+	}
+
+	template<> template<>
+	void uuidflatmap_object::test<3>()
+	{
+		set_test_name("erase keeps probe sequences intact");
+
+		// Eleven entries in the smallest table, 16 slots, leave long runs
+		// of used slots that often wrap past the end. Erasing them one by
+		// one in random order must leave every other entry reachable.
+		std::mt19937 random(3);
+		for (S32 round = 0; round < 2000; ++round)
+		{
+			std::vector<LLUUID> ids;
+			LLUUIDFlatMap<S32> flat;
+			for (S32 i = 0; i < 11; ++i)
+			{
+				ids.push_back(makeID(random));
+				flat[ids.back()] = i;
+			}
+			std::vector<S32> order(ids.size());
+			for (S32 i = 0; i < (S32)order.size(); ++i)
+			{
+				order[i] = i;
+			}
+			std::shuffle(order.begin(), order.end(), random);
+
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				ensure_equals("erased", flat.erase(ids[order[i]]), 1);
+				ensure_equals("erased twice", flat.erase(ids[order[i]]), 0);
+				ensure_equals("size", flat.size(), order.size() - i - 1);
+				for (size_t j = i + 1; j < order.size(); ++j)
+				{
+					LLUUIDFlatMap<S32>::const_iterator found = flat.find(ids[order[j]]);
+					ensure("still found", found != flat.end());
+					ensure_equals("value", found->second, order[j]);
+				}
+			}
+			ensure("empty", flat.empty());
+			ensure("nothing to iterate", flat.begin() == flat.end());
+		}
+	}
+
+	template<> template<>
+	void uuidflatmap_object::test<4>()
+	{
+		set_test_name("reserve and rehash");
+
+		std::mt19937 random(4);
+		std::vector<LLUUID> ids;
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			ids.push_back(makeID(random));
+		}
+
+		// Values do not move while the map stays within what was reserved
+		LLUUIDFlatMap<S32> flat;
+		flat.reserve(1000);
+		flat[ids[0]] = 0;
+		const S32* first = &flat[ids[0]];
+		for (S32 i = 1; i < 1000; ++i)
+		{
+			flat[ids[i]] = i;
+		}
+		ensure("no rehash within reserve", first == &flat[ids[0]]);
+
+		// Growing well past it rehashes several times and keeps everything,
+		// including entries erased and inserted again on the way
+		for (S32 i = 1000; i < (S32)ids.size(); ++i)
+		{
+			flat[ids[i]] = i;
+			if (i % 3 == 0)
+			{
+				flat.erase(ids[i / 2]);
+				flat[ids[i / 2]] = i / 2;
+			}
+		}
+		ensure_equals("size", flat.size(), ids.size());
+		for (S32 i = 0; i < (S32)ids.size(); ++i)
+		{
+			LLUUIDFlatMap<S32>::const_iterator found = flat.find(ids[i]);
+			ensure("found after growing", found != flat.end());
+			ensure_equals("value after growing", found->second, i);
+		}
+
+		// Reserving less than the size is a no-op
+		flat.reserve(10);
+		ensure_equals("size after small reserve", flat.size(), ids.size());
+		ensure("found after small reserve", is_in_map(flat, ids[4999]));
+	}
+
+	// Just enough of LLInventoryModel to time it with either kind of map:
+	// object tables by id and a child array per folder.
+	template <template <typename> class MAP>
+	struct SkeletonModel
+	{
+		typedef std::vector<LLUUID> child_array_t;
+
+		MAP<LLUUID> mCategoryParents;			// folder -> parent
+		MAP<LLUUID> mItemParents;				// item -> parent
+		MAP<child_array_t*> mChildCategories;
+		MAP<child_array_t*> mChildItems;
+
+		~SkeletonModel()
+		{
+			std::for_each(mChildCategories.begin(), mChildCategories.end(), DeletePairedPointer());
+			std::for_each(mChildItems.begin(), mChildItems.end(), DeletePairedPointer());
+		}
+
+		void addCategory(const LLUUID& id, const LLUUID& parent_id)
+		{
+			mCategoryParents[id] = parent_id;
+			mChildCategories[id] = new child_array_t;
+			mChildItems[id] = new child_array_t;
+			get_ptr_in_map(mChildCategories, parent_id)->push_back(id);
+		}
+
+		void addItem(const LLUUID& id, const LLUUID& parent_id)
+		{
+			mItemParents[id] = parent_id;
+			get_ptr_in_map(mChildItems, parent_id)->push_back(id);
+		}
+
+		// As collectDescendentsIf() walks the tree
+		void collectDescendents(const LLUUID& id, std::vector<LLUUID>& items) const
+		{
+			const child_array_t* cats = get_ptr_in_map(mChildCategories, id);
+			const child_array_t* child_items = get_ptr_in_map(mChildItems, id);
+			if (child_items)
+			{
+				for (child_array_t::const_iterator it = child_items->begin(); it != child_items->end(); ++it)
+				{
+					if (is_in_map(mItemParents, *it))
+					{
+						items.push_back(*it);
+					}
+				}
+			}
+			if (cats)
+			{
+				for (child_array_t::const_iterator it = cats->begin(); it != cats->end(); ++it)
+				{
+					if (is_in_map(mCategoryParents, *it))
+					{
+						collectDescendents(*it, items);
+					}
+				}
+			}
+		}
+	};
+
+	template <typename T>
+	using std_map_t = std::map<LLUUID, T>;
+
+	template <template <typename> class MAP>
+	static void timeSkeleton(const char* name, const std::vector<LLUUID>& folders,
+							 const std::vector<LLUUID>& items, const std::vector<LLUUID>& lookups)
+	{
+		LLTimer timer;
+		SkeletonModel<MAP> model;
+		model.mChildCategories[LLUUID::null] = new typename SkeletonModel<MAP>::child_array_t;
+		model.mChildItems[LLUUID::null] = new typename SkeletonModel<MAP>::child_array_t;
+		for (size_t i = 0; i < folders.size(); ++i)
+		{
+			// A tree about four levels deep
+			model.addCategory(folders[i], i < 8 ? LLUUID::null : folders[i / 8]);
+		}
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			model.addItem(items[i], folders[(i * 7919) % folders.size()]);
+		}
+		F64 load_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		size_t found = 0;
+		for (size_t i = 0; i < lookups.size(); ++i)
+		{
+			found += model.mItemParents.count(lookups[i]);
+		}
+		F64 lookup_time = timer.getElapsedTimeF64();
+		ensure_equals("every item found", found, lookups.size());
+
+		timer.reset();
+		std::vector<LLUUID> descendents;
+		model.collectDescendents(LLUUID::null, descendents);
+		F64 collect_time = timer.getElapsedTimeF64();
+		ensure_equals("every item collected", descendents.size(), items.size());
+
+		LL_INFOS("LLUUIDFlatMap") << name << ": load " << load_time * 1000.0 << " ms, "
+								  << lookups.size() << " lookups " << lookup_time * 1000.0
+								  << " ms, collect descendents " << collect_time * 1000.0 << " ms" << LL_ENDL;
+	}
+
+	template<> template<>
+	void uuidflatmap_object::test<5>()
+	{
+		set_test_name("benchmark a 200k item inventory skeleton");
+
+		std::mt19937 random(2);
+		std::vector<LLUUID> folders;
+		std::vector<LLUUID> items;
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			folders.push_back(makeID(random));
+		}
+		for (S32 i = 0; i < 200000; ++i)
+		{
+			items.push_back(makeID(random));
+		}
+		std::vector<LLUUID> lookups(items);
+		std::shuffle(lookups.begin(), lookups.end(), random);
+
+		timeSkeleton<std_map_t>("std::map", folders, items, lookups);
+		timeSkeleton<LLUUIDFlatMap>("LLUUIDFlatMap", folders, items, lookups);
+	}
+}
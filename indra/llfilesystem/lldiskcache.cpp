@@ -37,23 +37,52 @@
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 #include <chrono>
+#include <set>
 
 #include "lldiskcache.h"
 
 // <FS:Ansariel> Optimize asset simple disk cache
 static const char* subdirs = "0123456789abcdef";
 
+// <FS> In-memory LRU access index
+/**
+ * Threshold in time_t units that is used to decide if the last access time
+ * time of the file is updated or not. Added as a precaution for the concern
+ * outlined in SL-14582  about frequent writes on older SSDs reducing their
+ * lifespan. I think this is the right place for the threshold value - rather
+ * than it being a pref - do comment on that Jira if you disagree...
+ *
+ * Let's start with 1 hour in time_t units and see how that unfolds
+ */
+static const std::time_t ACCESS_TIME_THRESHOLD = 1 * 60 * 60;
+// </FS>
+
 LLDiskCache::LLDiskCache(const std::string cache_dir,
                          const uintmax_t max_size_bytes,
-                         const bool enable_cache_debug_info) :
+                         const bool enable_cache_debug_info,
+                         const bool use_packed_store) :
     mCacheDir(cache_dir),
     mMaxSizeBytes(max_size_bytes),
-    mEnableCacheDebugInfo(enable_cache_debug_info)
+    mEnableCacheDebugInfo(enable_cache_debug_info),
+    mAccessTotalBytes(0),       // <FS/> In-memory LRU access index
+    mAccessIndexReady(false)    // <FS/> In-memory LRU access index
 {
     mCacheFilenamePrefix = "sl_cache";
 
     LLFile::mkdir(cache_dir);
 
+    // <FS> Packed asset store
+    if (use_packed_store)
+    {
+        mPackedStore = std::make_unique<LLDiskCacheStore>(cache_dir + gDirUtilp->getDirDelimiter() + "packed", enable_cache_debug_info);
+        if (!mPackedStore->isValid())
+        {
+            LL_WARNS("LLDiskCache") << "Unable to open packed asset store, falling back to one file per asset" << LL_ENDL;
+            mPackedStore.reset();
+        }
+    }
+    // </FS>
+
     // <FS:Ansariel> Optimize asset simple disk cache
     for (S32 i = 0; i < 16; i++)
     {
@@ -98,6 +127,33 @@ LLDiskCache::LLDiskCache(const std::string cache_dir,
 // asset will have to be re-requested.
 void LLDiskCache::purge()
 {
+    // <FS> Packed asset store
+    if (mPackedStore)
+    {
+        // The index knows every entry's size and access time, so there is no
+        // need to walk the directory. Entries of the skip list are protected.
+        std::vector<LLUUID> protected_ids;
+        protected_ids.reserve(mSkipList.size());
+        for (const std::string& uuid_as_string : mSkipList)
+        {
+            protected_ids.emplace_back(uuid_as_string);
+        }
+
+        LL_INFOS() << "Purging packed cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+        mPackedStore->purge(mMaxSizeBytes, protected_ids);
+        mPackedStore->compact();
+        return;
+    }
+
+    // Once the access index has been seeded, there is no need to look
+    // at the files at all.
+    if (mAccessIndexReady)
+    {
+        purgeFromAccessIndex();
+        return;
+    }
+    // </FS>
+
     if (mEnableCacheDebugInfo)
     {
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
@@ -331,16 +387,8 @@ const std::string LLDiskCache::metaDataToFilepath(const std::string& id,
 void LLDiskCache::updateFileAccessTime(const std::string& file_path)
 // </FS:Ansariel>
 {
-    /**
-     * Threshold in time_t units that is used to decide if the last access time
-     * time of the file is updated or not. Added as a precaution for the concern
-     * outlined in SL-14582  about frequent writes on older SSDs reducing their
-     * lifespan. I think this is the right place for the threshold value - rather
-     * than it being a pref - do comment on that Jira if you disagree...
-     *
-     * Let's start with 1 hour in time_t units and see how that unfolds
-     */
-    const std::time_t time_threshold = 1 * 60 * 60;
+    // <FS> In-memory LRU access index; moved up to be shared with flushAccessTimes()
+    const std::time_t time_threshold = ACCESS_TIME_THRESHOLD;
 
     // current time
     const std::time_t cur_time = std::time(nullptr);
@@ -395,7 +443,24 @@ const std::string LLDiskCache::getCacheInfo()
     std::ostringstream cache_info;
 
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0 * 1024.0);
-    F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    // <FS> Packed asset store
+    //F32 percent_used = ((F32)dirFileSize(mCacheDir) / (F32)mMaxSizeBytes) * 100.0;
+    uintmax_t used_bytes = 0;
+    if (mPackedStore)
+    {
+        used_bytes = mPackedStore->getLiveBytes();
+    }
+    else if (!mAccessIndexReady)
+    {
+        used_bytes = dirFileSize(mCacheDir);
+    }
+    if (!mPackedStore && mAccessIndexReady)
+    {
+        LLMutexLock lock(&mAccessMutex);
+        used_bytes = mAccessTotalBytes;
+    }
+    F32 percent_used = ((F32)used_bytes / (F32)mMaxSizeBytes) * 100.0;
+    // </FS>
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -428,7 +493,11 @@ void LLDiskCache::prepopulateCacheWithStatic()
                 // we store static assets as UUID.asset_type the asset_type is not used in the current simple cache format
                 auto uuid_as_string{ gDirUtilp->getBaseFileName(from_asset_file, true) };
                 auto to_asset_file = metaDataToFilepath(uuid_as_string, LLAssetType::AT_UNKNOWN, std::string());
-                if (!gDirUtilp->fileExists(to_asset_file))
+                if (mPackedStore)
+                {
+                    copyStaticToPackedStore(from_asset_file, LLUUID(uuid_as_string));
+                }
+                else if (!gDirUtilp->fileExists(to_asset_file))
                 {
                     if (mEnableCacheDebugInfo)
                     {
@@ -438,6 +507,16 @@ void LLDiskCache::prepopulateCacheWithStatic()
                     {
                         LL_WARNS("LLDiskCache") << "Failed to copy " << from_asset_file << " to " << to_asset_file << LL_ENDL;
                     }
+                    // <FS> In-memory LRU access index
+                    else
+                    {
+                        llstat file_stat;
+                        if (LLFile::stat(to_asset_file, &file_stat) == 0)
+                        {
+                            noteFileWrite(LLUUID(uuid_as_string), file_stat.st_size);
+                        }
+                    }
+                    // </FS>
                 }
                 if (std::find(mSkipList.begin(), mSkipList.end(), uuid_as_string) == mSkipList.end())
                 {
@@ -453,9 +532,61 @@ void LLDiskCache::prepopulateCacheWithStatic()
 }
 // </FS:Beq>
 
+// <FS> Packed asset store
+void LLDiskCache::copyStaticToPackedStore(const std::string& from_asset_file, const LLUUID& asset_id)
+{
+    if (mPackedStore->exists(asset_id))
+    {
+        return;
+    }
+
+    if (mEnableCacheDebugInfo)
+    {
+        LL_INFOS("LLDiskCache") << "Copying static asset " << from_asset_file << " to packed cache" << LL_ENDL;
+    }
+
+    LLUniqueFile file = LLFile::fopen(from_asset_file, "rb");
+    if (!file)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to open static asset " << from_asset_file << LL_ENDL;
+        return;
+    }
+
+    std::vector<U8> buffer;
+    U8 chunk[16384];
+    size_t bytes_read = 0;
+    while ((bytes_read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        buffer.insert(buffer.end(), chunk, chunk + bytes_read);
+    }
+
+    if (buffer.empty() || mPackedStore->write(asset_id, LLAssetType::AT_UNKNOWN, 0, &buffer[0], (S32)buffer.size(), true) < 0)
+    {
+        LL_WARNS("LLDiskCache") << "Failed to copy static asset " << from_asset_file << " to packed cache" << LL_ENDL;
+    }
+}
+// </FS>
+
 void LLDiskCache::clearCache()
 {
     LL_INFOS() << "clearing cache " << mCacheDir << LL_ENDL;
+
+    // <FS> Packed asset store
+    if (mPackedStore)
+    {
+        mPackedStore->clear();
+    }
+    // </FS>
+
+    // <FS> In-memory LRU access index
+    {
+        LLMutexLock lock(&mAccessMutex);
+        mAccessLRU.clear();
+        mAccessMap.clear();
+        mDirtyAccess.clear();
+        mAccessTotalBytes = 0;
+    }
+    // </FS>
     /**
      * See notes on performance in dirFileSize(..) - there may be
      * a quicker way to do this by operating on the parent dir vs
@@ -587,6 +718,347 @@ uintmax_t LLDiskCache::dirFileSize(const std::string dir)
     return total_file_size;
 }
 
+// <FS> In-memory LRU access index
+void LLDiskCache::noteFileAccess(const LLUUID& id)
+{
+    if (mPackedStore)
+    {
+        return;
+    }
+
+    LLMutexLock lock(&mAccessMutex);
+    access_map_t::iterator iter = mAccessMap.find(id);
+    if (iter == mAccessMap.end())
+    {
+        if (mAccessIndexReady)
+        {
+            // Not a file in the cache
+            return;
+        }
+
+        // Seeding will fill in the size, or drop the entry if there is
+        // no such file after all
+        mAccessLRU.push_front(id);
+        AccessEntry& entry = mAccessMap[id];
+        entry.mLRUIter = mAccessLRU.begin();
+        entry.mSize = SIZE_UNKNOWN;
+        entry.mAccessTime = std::time(nullptr);
+        entry.mDiskTime = 0;
+        entry.mDirty = true;
+        mDirtyAccess.push_back(id);
+        return;
+    }
+
+    AccessEntry& entry = iter->second;
+    mAccessLRU.splice(mAccessLRU.begin(), mAccessLRU, entry.mLRUIter);
+    entry.mAccessTime = std::time(nullptr);
+    if (!entry.mDirty)
+    {
+        entry.mDirty = true;
+        mDirtyAccess.push_back(id);
+    }
+}
+
+void LLDiskCache::noteFileWrite(const LLUUID& id, uintmax_t file_size)
+{
+    if (mPackedStore)
+    {
+        return;
+    }
+
+    const std::time_t now = std::time(nullptr);
+
+    LLMutexLock lock(&mAccessMutex);
+    access_map_t::iterator iter = mAccessMap.find(id);
+    if (iter == mAccessMap.end())
+    {
+        mAccessLRU.push_front(id);
+        AccessEntry& entry = mAccessMap[id];
+        entry.mLRUIter = mAccessLRU.begin();
+        entry.mSize = file_size;
+        entry.mDirty = false;
+        entry.mAccessTime = now;
+        entry.mDiskTime = now;
+        mAccessTotalBytes += file_size;
+        return;
+    }
+
+    AccessEntry& entry = iter->second;
+    mAccessLRU.splice(mAccessLRU.begin(), mAccessLRU, entry.mLRUIter);
+    if (entry.mSize != SIZE_UNKNOWN)
+    {
+        mAccessTotalBytes -= entry.mSize;
+    }
+    entry.mSize = file_size;
+    mAccessTotalBytes += file_size;
+    // Writing the file has updated its time on disk
+    entry.mAccessTime = now;
+    entry.mDiskTime = now;
+}
+
+void LLDiskCache::noteFileRemove(const LLUUID& id)
+{
+    if (mPackedStore)
+    {
+        return;
+    }
+
+    LLMutexLock lock(&mAccessMutex);
+    access_map_t::iterator iter = mAccessMap.find(id);
+    if (iter != mAccessMap.end())
+    {
+        if (iter->second.mSize != SIZE_UNKNOWN)
+        {
+            mAccessTotalBytes -= iter->second.mSize;
+        }
+        mAccessLRU.erase(iter->second.mLRUIter);
+        mAccessMap.erase(iter);
+    }
+}
+
+void LLDiskCache::seedAccessIndex()
+{
+    if (mPackedStore || mAccessIndexReady)
+    {
+        return;
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    struct seed_info_t
+    {
+        std::time_t mTime;
+        uintmax_t mSize;
+        LLUUID mID;
+    };
+    std::vector<seed_info_t> file_info;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
+#else
+    std::string cache_path(mCacheDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        for (auto& entry : boost::make_iterator_range(boost::filesystem::recursive_directory_iterator(cache_path, ec), {}))
+        {
+            if (ec.failed() || !boost::filesystem::is_regular_file(entry, ec) || ec.failed())
+            {
+                continue;
+            }
+
+            // sl_cache_<uuid>_<extra>.asset
+            const std::string filename = entry.path().filename().string();
+            if (filename.compare(0, mCacheFilenamePrefix.size(), mCacheFilenamePrefix) != 0 ||
+                filename.size() < mCacheFilenamePrefix.size() + 1 + UUID_STR_LENGTH - 1)
+            {
+                continue;
+            }
+
+            const std::string uuid_as_string = filename.substr(mCacheFilenamePrefix.size() + 1, UUID_STR_LENGTH - 1);
+            if (!LLUUID::validate(uuid_as_string))
+            {
+                continue;
+            }
+
+            seed_info_t info;
+            info.mSize = boost::filesystem::file_size(entry, ec);
+            if (ec.failed())
+            {
+                continue;
+            }
+            info.mTime = boost::filesystem::last_write_time(entry, ec);
+            if (ec.failed())
+            {
+                continue;
+            }
+            info.mID.set(uuid_as_string);
+            file_info.push_back(info);
+        }
+    }
+
+    // Newest first so they can simply be appended to the LRU list
+    std::sort(file_info.begin(), file_info.end(), [](const seed_info_t& x, const seed_info_t& y)
+    {
+        return x.mTime > y.mTime;
+    });
+
+    LLMutexLock lock(&mAccessMutex);
+    for (const seed_info_t& info : file_info)
+    {
+        access_map_t::iterator iter = mAccessMap.find(info.mID);
+        if (iter != mAccessMap.end())
+        {
+            // Used or written while we were walking, which makes it newer
+            // than anything on disk; keep its place.
+            AccessEntry& entry = iter->second;
+            if (entry.mSize == SIZE_UNKNOWN)
+            {
+                entry.mSize = info.mSize;
+                entry.mDiskTime = info.mTime;
+                mAccessTotalBytes += info.mSize;
+            }
+            continue;
+        }
+
+        mAccessLRU.push_back(info.mID);
+        AccessEntry& entry = mAccessMap[info.mID];
+        entry.mLRUIter = std::prev(mAccessLRU.end());
+        entry.mSize = info.mSize;
+        entry.mAccessTime = info.mTime;
+        entry.mDiskTime = info.mTime;
+        entry.mDirty = false;
+        mAccessTotalBytes += info.mSize;
+    }
+
+    // Anything still without a size was read before seeding but doesn't exist
+    for (access_map_t::iterator iter = mAccessMap.begin(); iter != mAccessMap.end(); )
+    {
+        if (iter->second.mSize == SIZE_UNKNOWN)
+        {
+            mAccessLRU.erase(iter->second.mLRUIter);
+            iter = mAccessMap.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    mAccessIndexReady = true;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    LL_INFOS("LLDiskCache") << "Access index seeded with " << mAccessMap.size() << " files, " << mAccessTotalBytes
+                            << " bytes in " << execute_time << " ms" << LL_ENDL;
+}
+
+void LLDiskCache::purgeFromAccessIndex()
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    std::set<LLUUID> skip_ids;
+    for (const std::string& uuid_as_string : mSkipList)
+    {
+        skip_ids.emplace(uuid_as_string);
+    }
+
+    std::vector<std::string> files_to_remove;
+    S32 skip{ 0 };
+    {
+        LLMutexLock lock(&mAccessMutex);
+        const std::time_t now = std::time(nullptr);
+        // Every pass either removes an entry or moves a protected one to the
+        // front, so one pass per entry is enough to go round the list once.
+        const size_t limit = mAccessMap.size();
+        size_t checked = 0;
+        while (mAccessTotalBytes > mMaxSizeBytes && !mAccessLRU.empty() && checked++ < limit)
+        {
+            const LLUUID id = mAccessLRU.back();
+            AccessEntry& entry = mAccessMap[id];
+
+            if (skip_ids.find(id) != skip_ids.end())
+            {
+                // this is one of our protected items so no purging, move it to the front
+                mAccessLRU.splice(mAccessLRU.begin(), mAccessLRU, entry.mLRUIter);
+                entry.mAccessTime = now;
+                if (!entry.mDirty)
+                {
+                    entry.mDirty = true;
+                    mDirtyAccess.push_back(id);
+                }
+                ++skip;
+                continue;
+            }
+
+            files_to_remove.push_back(metaDataToFilepath(id.asString(), LLAssetType::AT_UNKNOWN, std::string()));
+            mAccessTotalBytes -= entry.mSize;
+            mAccessMap.erase(id);
+            mAccessLRU.pop_back();
+        }
+    }
+
+    boost::system::error_code ec;
+    for (const std::string& file_path : files_to_remove)
+    {
+#if LL_WINDOWS
+        boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
+#else
+        boost::filesystem::remove(file_path, ec);
+#endif
+        if (ec.failed())
+        {
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
+        }
+        else if (mEnableCacheDebugInfo)
+        {
+            LL_INFOS() << "DELETE  " << file_path << LL_ENDL;
+        }
+    }
+
+    flushAccessTimes();
+
+    if (mEnableCacheDebugInfo)
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        LL_INFOS() << "Cache purge took " << execute_time << " ms. Deleted: " << files_to_remove.size()
+                   << " Skipped: " << skip << " Total: " << mAccessTotalBytes << "/" << mMaxSizeBytes << LL_ENDL;
+    }
+}
+
+void LLDiskCache::flushAccessTimes()
+{
+    if (mPackedStore)
+    {
+        mPackedStore->flush();
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::time_t>> to_write;
+    {
+        LLMutexLock lock(&mAccessMutex);
+        for (const LLUUID& id : mDirtyAccess)
+        {
+            access_map_t::iterator iter = mAccessMap.find(id);
+            if (iter == mAccessMap.end() || !iter->second.mDirty)
+            {
+                continue;
+            }
+
+            AccessEntry& entry = iter->second;
+            entry.mDirty = false;
+            if (entry.mSize != SIZE_UNKNOWN && entry.mAccessTime - entry.mDiskTime > ACCESS_TIME_THRESHOLD)
+            {
+                to_write.emplace_back(metaDataToFilepath(id.asString(), LLAssetType::AT_UNKNOWN, std::string()), entry.mAccessTime);
+                entry.mDiskTime = entry.mAccessTime;
+            }
+        }
+        mDirtyAccess.clear();
+    }
+
+    boost::system::error_code ec;
+    for (const auto& file_time : to_write)
+    {
+#if LL_WINDOWS
+        boost::filesystem::last_write_time(utf8str_to_utf16str(file_time.first), file_time.second, ec);
+#else
+        boost::filesystem::last_write_time(file_time.first, file_time.second, ec);
+#endif
+        if (ec.failed())
+        {
+            LL_WARNS() << "Failed to update last write time for cache file " << file_time.first << ": " << ec.message() << LL_ENDL;
+        }
+    }
+
+    if (mEnableCacheDebugInfo && !to_write.empty())
+    {
+        LL_INFOS() << "Updated the last write time of " << to_write.size() << " cache files" << LL_ENDL;
+    }
+}
+// </FS>
+
 LLPurgeDiskCacheThread::LLPurgeDiskCacheThread() :
     LLThread("PurgeDiskCacheThread", nullptr)
 {
@@ -596,8 +1068,17 @@ void LLPurgeDiskCacheThread::run()
 {
     constexpr std::chrono::seconds CHECK_INTERVAL{60};
 
+    // <FS> In-memory LRU access index
+    // Walk the cache once here rather than on the main thread, after which
+    // purges only look at the access index.
+    LLDiskCache::instance().seedAccessIndex();
+    LLDiskCache::instance().purge();
+    // </FS>
+
     while (LLApp::instance()->sleep(CHECK_INTERVAL))
     {
         LLDiskCache::instance().purge();
     }
+
+    LLDiskCache::instance().flushAccessTimes(); // <FS/> In-memory LRU access index
 }
@@ -28,6 +28,11 @@
  *    directory, sorts them by date of last access (write) and then
  *    deletes any files based on age until the total size of all
  *    the files is less than the maximum size specified.
+ *    <FS> Since walking a large cache is slow, this is only done once
+ *    at startup on the purge thread to seed an in-memory LRU list of
+ *    the files. Reads and writes then only update that list and
+ *    purges remove files from its tail. Access times are written back
+ *    to the files in batches.</FS>
  * 4/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
  * 5/ Performance on my modest system seems very acceptable. For
@@ -63,6 +68,11 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "lldiskcachestore.h"
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
 
 class LLDiskCache :
     public LLParamSingleton<LLDiskCache>
@@ -92,7 +102,15 @@ class LLDiskCache :
                      * if there are bugs, we can ask uses to enable this
                      * setting and send us their logs
                      */
-                    const bool enable_cache_debug_info);
+                    const bool enable_cache_debug_info,
+                    // <FS> Packed asset store
+                    /**
+                     * Store assets in the packed, indexed segment files of
+                     * LLDiskCacheStore instead of one file per asset. Defined
+                     * by the setting at 'FSDiskCachePackedStore'
+                     */
+                    const bool use_packed_store);
+                    // </FS>
 
         virtual ~LLDiskCache() = default;
 
@@ -136,6 +154,33 @@ class LLDiskCache :
          */
         void purge();
 
+        // <FS> In-memory LRU access index
+        /**
+         * Record that the asset with the given id was read, written (giving
+         * its new size) or removed. These only touch the in-memory access
+         * index; the last access times are written to the files in batches
+         * by flushAccessTimes().
+         */
+        void noteFileAccess(const LLUUID& id);
+        void noteFileWrite(const LLUUID& id, uintmax_t file_size);
+        void noteFileRemove(const LLUUID& id);
+
+        /**
+         * Walk the cache directory once and build the access index from the
+         * files' last write times. Called by LLPurgeDiskCacheThread before
+         * its first purge; until it is done, purge() falls back to walking
+         * the whole directory.
+         */
+        void seedAccessIndex();
+
+        /**
+         * Write the access times recorded since the last flush to the files
+         * so the LRU order survives a restart. Like the old per-read update,
+         * a file is only touched if its time on disk is over an hour old.
+         */
+        void flushAccessTimes();
+        // </FS>
+
         // <FS:Beq>
         // copy from distribution into cache to replace static content
         void prepopulateCacheWithStatic();
@@ -158,6 +203,15 @@ class LLDiskCache :
         // <FS:Ansariel> Better asset cache size control
         void setMaxSizeBytes(uintmax_t size) { mMaxSizeBytes = size; }
 
+        // <FS> Packed asset store
+        /**
+         * The packed store holding the assets, or nullptr if the cache
+         * uses the one file per asset layout. LLFileSystem dispatches
+         * on this.
+         */
+        LLDiskCacheStore* getPackedStore() const { return mPackedStore.get(); }
+        // </FS>
+
     private:
         /**
          * Utility function to gather the total size the files in a given
@@ -172,6 +226,22 @@ class LLDiskCache :
          */
         const std::string assetTypeToString(LLAssetType::EType at);
 
+        // <FS> In-memory LRU access index
+        /**
+         * Remove files from the tail of the access index until the cache is
+         * within mMaxSizeBytes. Only costs O(files removed).
+         */
+        void purgeFromAccessIndex();
+        // </FS>
+
+        // <FS> Packed asset store
+        /**
+         * Copies a static asset from the distribution into the packed
+         * store unless it is already there.
+         */
+        void copyStaticToPackedStore(const std::string& from_asset_file, const LLUUID& asset_id);
+        // </FS>
+
     private:
         /**
          * The maximum size of the cache in bytes. After purge is called, the
@@ -205,6 +275,38 @@ class LLDiskCache :
         bool mEnableCacheDebugInfo;
         
         std::vector<std::string> mSkipList;  // <FS:Beq/> Vector of "static" untouchable assets that should never be purged
+
+        std::unique_ptr<LLDiskCacheStore> mPackedStore; // <FS/> Packed asset store
+
+        // <FS> In-memory LRU access index
+        /**
+         * Every cache file we know of, ordered by last access with the most
+         * recently used at the front of mAccessLRU. The map holds what we
+         * know about each file; an unknown size (before seeding has found
+         * the file) is stored as SIZE_UNKNOWN and not counted in
+         * mAccessTotalBytes. All of it is guarded by mAccessMutex since it is
+         * used from the main thread and LLPurgeDiskCacheThread.
+         */
+        typedef std::list<LLUUID> access_lru_t;
+        struct AccessEntry
+        {
+            access_lru_t::iterator mLRUIter;
+            uintmax_t mSize;
+            std::time_t mAccessTime;    // last access as far as we know
+            std::time_t mDiskTime;      // last write time of the file
+            bool mDirty;                // queued in mDirtyAccess
+        };
+        typedef std::unordered_map<LLUUID, AccessEntry, FSUUIDHash> access_map_t;
+
+        static const uintmax_t SIZE_UNKNOWN = (uintmax_t)-1;
+
+        LLMutex mAccessMutex;
+        access_lru_t mAccessLRU;
+        access_map_t mAccessMap;
+        std::vector<LLUUID> mDirtyAccess;
+        uintmax_t mAccessTotalBytes;
+        std::atomic<bool> mAccessIndexReady;
+        // </FS>
 };
 
 class LLPurgeDiskCacheThread : public LLThread
@@ -0,0 +1,818 @@
+/**
+ * @file lldiskcachestore.cpp
+ * @brief Packed, indexed storage backend for the disk cache.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lldir.h"
+
+#include "lldiskcachestore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+static const U32 INDEX_MAGIC = 0x53434c4c; // "LLCS"
+static const U32 INDEX_VERSION = 1;
+// Must be a power of two
+static const U32 INDEX_INITIAL_CAPACITY = 16384;
+static const std::string INDEX_FILENAME = "index.dat";
+static const std::string SEGMENT_MASK = "segment_*.dat";
+
+// A segment is closed and a new one started once it grows past this size.
+static const U32 SEGMENT_MAX_BYTES = 64 * 1024 * 1024;
+
+LLDiskCacheStore::LLDiskCacheStore(const std::string& store_dir, bool enable_cache_debug_info) :
+	mStoreDir(store_dir),
+	mEnableCacheDebugInfo(enable_cache_debug_info)
+{
+	LLFile::mkdir(mStoreDir);
+
+	LLMutexLock lock(&mMutex);
+	if (openIndex())
+	{
+		loadSegments();
+	}
+}
+
+LLDiskCacheStore::~LLDiskCacheStore()
+{
+	LLMutexLock lock(&mMutex);
+	closeSegments();
+	mIndex.flush();
+	mIndex.close();
+}
+
+bool LLDiskCacheStore::openIndex()
+{
+	const std::string index_filename = gDirUtilp->add(mStoreDir, INDEX_FILENAME);
+	const size_t initial_size = sizeof(IndexHeader) + INDEX_INITIAL_CAPACITY * sizeof(IndexSlot);
+	if (!mIndex.open(index_filename, initial_size, true))
+	{
+		LL_WARNS("LLDiskCache") << "Unable to map packed cache index " << index_filename << LL_ENDL;
+		return false;
+	}
+
+	const IndexHeader* header = getHeader();
+	const U32 capacity = header->mCapacity;
+	if (header->mMagic != INDEX_MAGIC ||
+		header->mVersion != INDEX_VERSION ||
+		capacity < INDEX_INITIAL_CAPACITY ||
+		(capacity & (capacity - 1)) != 0 ||
+		mIndex.getSize() != sizeof(IndexHeader) + capacity * sizeof(IndexSlot))
+	{
+		// A fresh file, an old version or a crash in the middle of growIndex()
+		LL_INFOS("LLDiskCache") << "Packed cache index is missing or invalid, starting a new one" << LL_ENDL;
+		gDirUtilp->deleteFilesInDir(mStoreDir, SEGMENT_MASK);
+		resetIndex(INDEX_INITIAL_CAPACITY);
+	}
+
+	return mIndex.isOpen();
+}
+
+void LLDiskCacheStore::resetIndex(U32 capacity)
+{
+	if (!mIndex.resize(sizeof(IndexHeader) + capacity * sizeof(IndexSlot)))
+	{
+		mIndex.close();
+		return;
+	}
+
+	memset(mIndex.getData(), 0, mIndex.getSize());
+
+	IndexHeader* header = getHeader();
+	header->mMagic = INDEX_MAGIC;
+	header->mVersion = INDEX_VERSION;
+	header->mCapacity = capacity;
+}
+
+void LLDiskCacheStore::loadSegments()
+{
+	IndexHeader* header = getHeader();
+	IndexSlot* slots = getSlots();
+
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	// The index may be ahead of the segment data if we crashed while
+	// writing, so drop anything that points past the end of its segment.
+	U32 dropped = 0;
+	header->mLiveBytes = 0;
+	for (U32 i = 0; i < header->mCapacity; ++i)
+	{
+		IndexSlot& slot = slots[i];
+		if (slot.mState != SLOT_USED)
+		{
+			continue;
+		}
+
+		Segment* segment = getSegment(slot.mSegment, false);
+		if (!segment || (U64)slot.mOffset + slot.mSize > segment->mEndOffset)
+		{
+			releaseSlot(&slot);
+			++dropped;
+			continue;
+		}
+
+		segment->mLiveBytes += slot.mSize;
+		header->mLiveBytes += slot.mSize;
+	}
+
+	// Segments without any live data left are leftovers from an interrupted
+	// compaction.
+	for (const std::string& filename : gDirUtilp->getFilesInDir(mStoreDir))
+	{
+		U32 segment_id = 0;
+		if (sscanf(filename.c_str(), "segment_%u.dat", &segment_id) != 1 || segment_id == header->mCurrentSegment)
+		{
+			continue;
+		}
+
+		segment_map_t::iterator iter = mSegments.find(segment_id);
+		if (iter == mSegments.end() || !iter->second.mLiveBytes)
+		{
+			if (iter != mSegments.end())
+			{
+				LLFile::close(iter->second.mFile);
+				mSegments.erase(iter);
+			}
+			LLFile::remove(gDirUtilp->add(mStoreDir, filename));
+		}
+	}
+
+	if (mEnableCacheDebugInfo)
+	{
+		auto end_time = std::chrono::high_resolution_clock::now();
+		auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+		LL_INFOS("LLDiskCache") << "Loaded packed cache index with " << header->mCount << " entries, "
+								<< header->mLiveBytes << " bytes in " << mSegments.size() << " segments ("
+								<< dropped << " stale entries dropped) in " << execute_time << " ms" << LL_ENDL;
+	}
+}
+
+void LLDiskCacheStore::closeSegments()
+{
+	for (segment_map_t::value_type& entry : mSegments)
+	{
+		LLFile::close(entry.second.mFile);
+	}
+	mSegments.clear();
+}
+
+std::string LLDiskCacheStore::getSegmentFilename(U32 segment) const
+{
+	return gDirUtilp->add(mStoreDir, llformat("segment_%05u.dat", segment));
+}
+
+LLDiskCacheStore::Segment* LLDiskCacheStore::getSegment(U32 segment_id, bool create)
+{
+	segment_map_t::iterator iter = mSegments.find(segment_id);
+	if (iter != mSegments.end())
+	{
+		return &iter->second;
+	}
+
+	const std::string filename = getSegmentFilename(segment_id);
+	LLFILE* file = LLFile::fopen(filename, "r+b");
+	if (!file && create)
+	{
+		file = LLFile::fopen(filename, "w+b");
+	}
+	if (!file)
+	{
+		return nullptr;
+	}
+
+	Segment& segment = mSegments[segment_id];
+	segment.mFile = file;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		segment.mEndOffset = (U32)ftell(file);
+	}
+	return &segment;
+}
+
+U32 LLDiskCacheStore::getAppendSegment(U32 bytes)
+{
+	IndexHeader* header = getHeader();
+	Segment* segment = getSegment(header->mCurrentSegment, true);
+	if (segment && segment->mEndOffset > 0 && (U64)segment->mEndOffset + bytes > SEGMENT_MAX_BYTES)
+	{
+		do
+		{
+			++header->mCurrentSegment;
+		}
+		while (mSegments.find(header->mCurrentSegment) != mSegments.end());
+
+		// Make sure we start with an empty file
+		LLFile::remove(getSegmentFilename(header->mCurrentSegment), ENOENT);
+		getSegment(header->mCurrentSegment, true);
+	}
+	return header->mCurrentSegment;
+}
+
+bool LLDiskCacheStore::readData(const IndexSlot& slot, U32 offset, U8* buffer, U32 bytes)
+{
+	Segment* segment = getSegment(slot.mSegment, false);
+	if (!segment || fseek(segment->mFile, slot.mOffset + offset, SEEK_SET) != 0)
+	{
+		return false;
+	}
+	return fread(buffer, 1, bytes, segment->mFile) == bytes;
+}
+
+bool LLDiskCacheStore::writeData(U32 segment_id, U32 offset, const U8* buffer, U32 bytes)
+{
+	Segment* segment = getSegment(segment_id, true);
+	if (!segment || fseek(segment->mFile, offset, SEEK_SET) != 0)
+	{
+		return false;
+	}
+
+	bool success = fwrite(buffer, 1, bytes, segment->mFile) == bytes;
+	// Make sure the data is with the OS before the index refers to it
+	fflush(segment->mFile);
+	return success;
+}
+
+LLDiskCacheStore::IndexSlot* LLDiskCacheStore::findSlot(const LLUUID& id) const
+{
+	if (!mIndex.isOpen())
+	{
+		return nullptr;
+	}
+
+	const IndexHeader* header = getHeader();
+	IndexSlot* slots = getSlots();
+	const U32 mask = header->mCapacity - 1;
+
+	U32 pos = (U32)FSUUIDHash()(id) & mask;
+	for (U32 probe = 0; probe < header->mCapacity; ++probe)
+	{
+		IndexSlot& slot = slots[pos];
+		if (slot.mState == SLOT_EMPTY)
+		{
+			break;
+		}
+		if (slot.mState == SLOT_USED && slot.mID == id)
+		{
+			return &slot;
+		}
+		pos = (pos + 1) & mask;
+	}
+
+	return nullptr;
+}
+
+LLDiskCacheStore::IndexSlot* LLDiskCacheStore::findOrInsertSlot(const LLUUID& id)
+{
+	IndexSlot* slot = findSlot(id);
+	if (slot || !mIndex.isOpen())
+	{
+		return slot;
+	}
+
+	// Keep the load factor including tombstones below 70%
+	IndexHeader* header = getHeader();
+	if ((U64)(header->mCount + header->mTombstones + 1) * 10 > (U64)header->mCapacity * 7)
+	{
+		growIndex();
+		if (!mIndex.isOpen())
+		{
+			return nullptr;
+		}
+		header = getHeader();
+	}
+
+	IndexSlot* slots = getSlots();
+	const U32 mask = header->mCapacity - 1;
+	U32 pos = (U32)FSUUIDHash()(id) & mask;
+	while (slots[pos].mState == SLOT_USED)
+	{
+		pos = (pos + 1) & mask;
+	}
+
+	slot = &slots[pos];
+	if (slot->mState == SLOT_DELETED)
+	{
+		--header->mTombstones;
+	}
+	*slot = IndexSlot();
+	slot->mID = id;
+	slot->mState = SLOT_USED;
+	++header->mCount;
+
+	return slot;
+}
+
+void LLDiskCacheStore::growIndex()
+{
+	IndexHeader* header = getHeader();
+
+	std::vector<IndexSlot> used_slots;
+	used_slots.reserve(header->mCount);
+	const IndexSlot* slots = getSlots();
+	for (U32 i = 0; i < header->mCapacity; ++i)
+	{
+		if (slots[i].mState == SLOT_USED)
+		{
+			used_slots.push_back(slots[i]);
+		}
+	}
+
+	// If the table is mostly tombstones, rehashing in place is enough
+	U32 capacity = header->mCapacity;
+	if ((U64)used_slots.size() * 10 > (U64)capacity * 3)
+	{
+		capacity *= 2;
+	}
+
+	const U32 current_segment = header->mCurrentSegment;
+	const U64 live_bytes = header->mLiveBytes;
+
+	// Invalidate the header first so a crash half way through rehashing
+	// results in an empty cache rather than a corrupt one.
+	header->mMagic = 0;
+	resetIndex(capacity);
+	if (!mIndex.isOpen())
+	{
+		LL_WARNS("LLDiskCache") << "Unable to grow packed cache index to " << capacity << " entries" << LL_ENDL;
+		return;
+	}
+	header = getHeader();
+	header->mMagic = 0;
+	header->mCurrentSegment = current_segment;
+	header->mLiveBytes = live_bytes;
+	header->mCount = (U32)used_slots.size();
+
+	IndexSlot* new_slots = getSlots();
+	const U32 mask = capacity - 1;
+	for (const IndexSlot& slot : used_slots)
+	{
+		U32 pos = (U32)FSUUIDHash()(slot.mID) & mask;
+		while (new_slots[pos].mState != SLOT_EMPTY)
+		{
+			pos = (pos + 1) & mask;
+		}
+		new_slots[pos] = slot;
+	}
+
+	header->mMagic = INDEX_MAGIC;
+
+	if (mEnableCacheDebugInfo)
+	{
+		LL_INFOS("LLDiskCache") << "Packed cache index rehashed to " << capacity << " slots for " << header->mCount << " entries" << LL_ENDL;
+	}
+}
+
+void LLDiskCacheStore::releaseSlot(IndexSlot* slot)
+{
+	IndexHeader* header = getHeader();
+	slot->mState = SLOT_DELETED;
+	--header->mCount;
+	++header->mTombstones;
+}
+
+// static
+U32 LLDiskCacheStore::getNow()
+{
+	return (U32)std::time(nullptr);
+}
+
+bool LLDiskCacheStore::exists(const LLUUID& id)
+{
+	LLMutexLock lock(&mMutex);
+	const IndexSlot* slot = findSlot(id);
+	return slot && slot->mSize > 0;
+}
+
+S32 LLDiskCacheStore::getSize(const LLUUID& id)
+{
+	LLMutexLock lock(&mMutex);
+	const IndexSlot* slot = findSlot(id);
+	return slot ? (S32)slot->mSize : 0;
+}
+
+S32 LLDiskCacheStore::read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes)
+{
+	LLMutexLock lock(&mMutex);
+	const IndexSlot* slot = findSlot(id);
+	if (!slot || offset < 0 || bytes <= 0 || (U32)offset >= slot->mSize)
+	{
+		return 0;
+	}
+
+	const U32 to_read = llmin((U32)bytes, slot->mSize - (U32)offset);
+	return readData(*slot, (U32)offset, buffer, to_read) ? (S32)to_read : 0;
+}
+
+S32 LLDiskCacheStore::write(const LLUUID& id, LLAssetType::EType type, S32 offset, const U8* buffer, S32 bytes, bool truncate)
+{
+	LLMutexLock lock(&mMutex);
+	if (!mIndex.isOpen() || offset < 0 || bytes < 0)
+	{
+		return -1;
+	}
+
+	IndexHeader* header = getHeader();
+	IndexSlot* slot = findSlot(id);
+	const U32 old_size = slot ? slot->mSize : 0;
+	if ((U32)offset > old_size)
+	{
+		// Would leave a hole in the asset
+		return -1;
+	}
+	const U32 start = (U32)offset;
+	const U32 end = start + (U32)bytes;
+	const U32 new_size = truncate ? end : llmax(old_size, end);
+
+	// If the asset is the last thing in the current segment, which is the
+	// case while a download is being appended, write it in place.
+	if (slot && slot->mSegment == header->mCurrentSegment)
+	{
+		// An append that would take the segment past its limit moves the
+		// asset to a new segment below instead.
+		Segment* segment = getSegment(slot->mSegment, false);
+		if (segment && slot->mOffset + old_size == segment->mEndOffset &&
+			(U64)slot->mOffset + new_size <= SEGMENT_MAX_BYTES)
+		{
+			if (!writeData(slot->mSegment, slot->mOffset + start, buffer, bytes))
+			{
+				return -1;
+			}
+			segment->mEndOffset = slot->mOffset + new_size;
+			segment->mLiveBytes = segment->mLiveBytes - old_size + new_size;
+			header->mLiveBytes = header->mLiveBytes - old_size + new_size;
+			slot->mSize = new_size;
+			slot->mType = type;
+			slot->mAccessTime = getNow();
+			return (S32)new_size;
+		}
+	}
+
+	// Otherwise the complete new contents go to the end of the current
+	// segment. Whole asset writes don't need to merge with the old data.
+	std::vector<U8> merged;
+	const U8* data = buffer;
+	if (slot && (start > 0 || new_size > end))
+	{
+		merged.resize(new_size);
+		if ((start > 0 && !readData(*slot, 0, &merged[0], start)) ||
+			(new_size > end && !readData(*slot, end, &merged[end], new_size - end)))
+		{
+			return -1;
+		}
+		if (bytes > 0)
+		{
+			memcpy(&merged[start], buffer, bytes);
+		}
+		data = &merged[0];
+	}
+
+	const U32 segment_id = getAppendSegment(new_size);
+	Segment* segment = getSegment(segment_id, true);
+	if (!segment)
+	{
+		return -1;
+	}
+	const U32 data_offset = segment->mEndOffset;
+	if (new_size > 0 && !writeData(segment_id, data_offset, data, new_size))
+	{
+		return -1;
+	}
+	segment->mEndOffset += new_size;
+	segment->mLiveBytes += new_size;
+	header->mLiveBytes += new_size;
+
+	if (slot)
+	{
+		Segment* old_segment = getSegment(slot->mSegment, false);
+		if (old_segment)
+		{
+			old_segment->mLiveBytes -= old_size;
+		}
+		header->mLiveBytes -= old_size;
+	}
+
+	// May grow the index, so header and slot pointers are refetched
+	slot = findOrInsertSlot(id);
+	if (!slot)
+	{
+		return -1;
+	}
+	slot->mType = type;
+	slot->mSegment = segment_id;
+	slot->mOffset = data_offset;
+	slot->mSize = new_size;
+	slot->mAccessTime = getNow();
+
+	return (S32)new_size;
+}
+
+bool LLDiskCacheStore::remove(const LLUUID& id)
+{
+	LLMutexLock lock(&mMutex);
+	IndexSlot* slot = findSlot(id);
+	if (!slot)
+	{
+		return false;
+	}
+
+	Segment* segment = getSegment(slot->mSegment, false);
+	if (segment)
+	{
+		segment->mLiveBytes -= slot->mSize;
+	}
+	getHeader()->mLiveBytes -= slot->mSize;
+	releaseSlot(slot);
+
+	return true;
+}
+
+bool LLDiskCacheStore::rename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_type)
+{
+	LLMutexLock lock(&mMutex);
+	IndexSlot* slot = findSlot(old_id);
+	if (!slot)
+	{
+		return false;
+	}
+	if (old_id == new_id)
+	{
+		slot->mType = new_type;
+		return true;
+	}
+
+	IndexSlot entry = *slot;
+	releaseSlot(slot);
+
+	// Rename replaces whatever is stored under the new id
+	IndexSlot* existing = findSlot(new_id);
+	if (existing)
+	{
+		Segment* segment = getSegment(existing->mSegment, false);
+		if (segment)
+		{
+			segment->mLiveBytes -= existing->mSize;
+		}
+		getHeader()->mLiveBytes -= existing->mSize;
+		releaseSlot(existing);
+	}
+
+	IndexSlot* new_slot = findOrInsertSlot(new_id);
+	if (!new_slot)
+	{
+		return false;
+	}
+	new_slot->mType = new_type;
+	new_slot->mSegment = entry.mSegment;
+	new_slot->mOffset = entry.mOffset;
+	new_slot->mSize = entry.mSize;
+	new_slot->mAccessTime = entry.mAccessTime;
+
+	return true;
+}
+
+void LLDiskCacheStore::updateAccessTime(const LLUUID& id)
+{
+	LLMutexLock lock(&mMutex);
+	IndexSlot* slot = findSlot(id);
+	if (slot)
+	{
+		slot->mAccessTime = getNow();
+	}
+}
+
+U32 LLDiskCacheStore::purge(uintmax_t max_size_bytes, const std::vector<LLUUID>& protected_ids)
+{
+	auto start_time = std::chrono::high_resolution_clock::now();
+
+	typedef std::pair<U32, LLUUID> entry_t;
+	std::vector<entry_t> entries;
+	{
+		LLMutexLock lock(&mMutex);
+		if (!mIndex.isOpen() || getHeader()->mLiveBytes <= max_size_bytes)
+		{
+			return 0;
+		}
+
+		const IndexHeader* header = getHeader();
+		const IndexSlot* slots = getSlots();
+		entries.reserve(header->mCount);
+		for (U32 i = 0; i < header->mCapacity; ++i)
+		{
+			if (slots[i].mState == SLOT_USED)
+			{
+				entries.emplace_back(slots[i].mAccessTime, slots[i].mID);
+			}
+		}
+	}
+
+	// Sort outside the lock, newest first
+	std::sort(entries.begin(), entries.end(), [](const entry_t& x, const entry_t& y)
+	{
+		return x.first > y.first;
+	});
+
+	U32 removed = 0;
+	U32 kept_static = 0;
+	uintmax_t size_total = 0;
+
+	LLMutexLock lock(&mMutex);
+	IndexHeader* header = getHeader();
+	const U32 now = getNow();
+	for (const entry_t& entry : entries)
+	{
+		IndexSlot* slot = findSlot(entry.second);
+		if (!slot)
+		{
+			continue;
+		}
+
+		size_total += slot->mSize;
+		if (size_total <= max_size_bytes || slot->mAccessTime != entry.first)
+		{
+			// Within budget, or used while we were sorting
+			continue;
+		}
+
+		if (std::find(protected_ids.begin(), protected_ids.end(), entry.second) != protected_ids.end())
+		{
+			slot->mAccessTime = now;
+			++kept_static;
+			continue;
+		}
+
+		Segment* segment = getSegment(slot->mSegment, false);
+		if (segment)
+		{
+			segment->mLiveBytes -= slot->mSize;
+		}
+		header->mLiveBytes -= slot->mSize;
+		size_total -= slot->mSize;
+		releaseSlot(slot);
+		++removed;
+	}
+
+	if (mEnableCacheDebugInfo)
+	{
+		auto end_time = std::chrono::high_resolution_clock::now();
+		auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+		LL_INFOS("LLDiskCache") << "Packed cache purge took " << execute_time << " ms for " << entries.size() << " entries. Deleted: "
+								<< removed << " Skipped: " << kept_static << " Live bytes: " << header->mLiveBytes << LL_ENDL;
+	}
+
+	return removed;
+}
+
+void LLDiskCacheStore::compact()
+{
+	std::vector<U32> candidates;
+	{
+		LLMutexLock lock(&mMutex);
+		if (!mIndex.isOpen())
+		{
+			return;
+		}
+
+		const U32 current_segment = getHeader()->mCurrentSegment;
+		for (const segment_map_t::value_type& entry : mSegments)
+		{
+			// Compact once more than half of a segment is dead space
+			if (entry.first != current_segment && entry.second.mLiveBytes * 2 < entry.second.mEndOffset)
+			{
+				candidates.push_back(entry.first);
+			}
+		}
+	}
+
+	std::vector<U8> buffer;
+	for (U32 segment_id : candidates)
+	{
+		std::vector<LLUUID> ids;
+		{
+			LLMutexLock lock(&mMutex);
+			const IndexHeader* header = getHeader();
+			const IndexSlot* slots = getSlots();
+			for (U32 i = 0; i < header->mCapacity; ++i)
+			{
+				if (slots[i].mState == SLOT_USED && slots[i].mSegment == segment_id)
+				{
+					ids.push_back(slots[i].mID);
+				}
+			}
+		}
+
+		// Move one asset at a time so readers are only ever blocked briefly
+		for (const LLUUID& id : ids)
+		{
+			LLMutexLock lock(&mMutex);
+			IndexSlot* slot = findSlot(id);
+			if (!slot || slot->mSegment != segment_id)
+			{
+				continue;
+			}
+
+			const U32 size = slot->mSize;
+			buffer.resize(llmax(size, 1U));
+			if (!readData(*slot, 0, &buffer[0], size))
+			{
+				continue;
+			}
+
+			const U32 new_segment_id = getAppendSegment(size);
+			Segment* new_segment = getSegment(new_segment_id, true);
+			if (!new_segment || !writeData(new_segment_id, new_segment->mEndOffset, &buffer[0], size))
+			{
+				continue;
+			}
+
+			Segment* old_segment = getSegment(segment_id, false);
+			if (old_segment)
+			{
+				old_segment->mLiveBytes -= size;
+			}
+			slot->mSegment = new_segment_id;
+			slot->mOffset = new_segment->mEndOffset;
+			new_segment->mEndOffset += size;
+			new_segment->mLiveBytes += size;
+		}
+
+		LLMutexLock lock(&mMutex);
+		segment_map_t::iterator iter = mSegments.find(segment_id);
+		if (iter != mSegments.end() && !iter->second.mLiveBytes)
+		{
+			LLFile::close(iter->second.mFile);
+			mSegments.erase(iter);
+			LLFile::remove(getSegmentFilename(segment_id));
+
+			if (mEnableCacheDebugInfo)
+			{
+				LL_INFOS("LLDiskCache") << "Compacted packed cache segment " << segment_id << LL_ENDL;
+			}
+		}
+	}
+
+	flush();
+}
+
+void LLDiskCacheStore::clear()
+{
+	LLMutexLock lock(&mMutex);
+	closeSegments();
+	gDirUtilp->deleteFilesInDir(mStoreDir, SEGMENT_MASK);
+	if (mIndex.isOpen())
+	{
+		resetIndex(INDEX_INITIAL_CAPACITY);
+	}
+}
+
+void LLDiskCacheStore::flush()
+{
+	LLMutexLock lock(&mMutex);
+	mIndex.flush();
+}
+
+uintmax_t LLDiskCacheStore::getLiveBytes()
+{
+	LLMutexLock lock(&mMutex);
+	return mIndex.isOpen() ? getHeader()->mLiveBytes : 0;
+}
+
+uintmax_t LLDiskCacheStore::getDiskBytes()
+{
+	LLMutexLock lock(&mMutex);
+	uintmax_t total = mIndex.getSize();
+	for (const segment_map_t::value_type& entry : mSegments)
+	{
+		total += entry.second.mEndOffset;
+	}
+	return total;
+}
+
+U32 LLDiskCacheStore::getEntryCount()
+{
+	LLMutexLock lock(&mMutex);
+	return mIndex.isOpen() ? getHeader()->mCount : 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * @file lldiskcachestore.h
+ * @brief Packed, indexed storage backend for the disk cache.
+ *
+ * @Description:
+ * Instead of storing every asset as its own file, the packed store keeps
+ * asset data in a small number of large append-only segment files and
+ * tracks where each asset lives in a memory-mapped index:
+ * 1/ The index is an open-addressed hash table keyed by asset UUID. Each
+ *    slot records the segment, offset, size, asset type and the time of
+ *    last access. Since the table is mapped, a lookup or an access time
+ *    update is a plain memory access - no stat() or utime() calls.
+ * 2/ Writes always go to the tail of the current segment. Overwritten or
+ *    removed data becomes dead space in its segment.
+ * 3/ Purging sorts the (in memory) index by access time and drops the
+ *    oldest entries; no directory walk is needed.
+ * 4/ Segments that are mostly dead space are compacted in the background
+ *    by moving the live entries to the current segment and deleting the
+ *    old segment file.
+ * 5/ The store is a cache: if the index is found to be corrupt or of a
+ *    different version, everything is thrown away and started afresh.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDISKCACHESTORE_H
+#define LL_LLDISKCACHESTORE_H
+
+#include "llassettype.h"
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <map>
+
+class LLDiskCacheStore
+{
+public:
+	/**
+	 * Opens (or creates) a packed store in store_dir. The directory is
+	 * created if it does not exist.
+	 */
+	LLDiskCacheStore(const std::string& store_dir, bool enable_cache_debug_info);
+	~LLDiskCacheStore();
+
+	bool isValid() const { return mIndex.isOpen(); }
+
+	bool exists(const LLUUID& id);
+	S32 getSize(const LLUUID& id);
+
+	/**
+	 * Copies up to bytes from offset of the stored asset into buffer.
+	 * Returns the number of bytes read; 0 if the asset is not stored.
+	 */
+	S32 read(const LLUUID& id, S32 offset, U8* buffer, S32 bytes);
+
+	/**
+	 * Writes bytes at offset of the stored asset, creating it if needed.
+	 * If truncate is set, the asset ends after the written data, else it
+	 * keeps any existing data past it. Returns the new asset size or -1
+	 * on failure, including an offset past the end of the asset.
+	 */
+	S32 write(const LLUUID& id, LLAssetType::EType type, S32 offset, const U8* buffer, S32 bytes, bool truncate);
+
+	bool remove(const LLUUID& id);
+	bool rename(const LLUUID& old_id, const LLUUID& new_id, LLAssetType::EType new_type);
+
+	/**
+	 * Marks the asset as used now. Only touches the mapped index.
+	 */
+	void updateAccessTime(const LLUUID& id);
+
+	/**
+	 * Drops the least recently used assets until the live data is no bigger
+	 * than max_size_bytes. Protected ids are never dropped; their access
+	 * time is refreshed instead. Returns the number of assets removed.
+	 */
+	U32 purge(uintmax_t max_size_bytes, const std::vector<LLUUID>& protected_ids);
+
+	/**
+	 * Moves the live data out of segments that are mostly dead space and
+	 * deletes them. The store lock is only held while moving one asset at
+	 * a time, so this can run on a background thread.
+	 */
+	void compact();
+
+	/**
+	 * Removes every asset and every segment file.
+	 */
+	void clear();
+
+	void flush();
+
+	uintmax_t getLiveBytes();
+	uintmax_t getDiskBytes();
+	U32 getEntryCount();
+
+private:
+	struct IndexHeader
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mCapacity;
+		U32 mCount;
+		U32 mTombstones;
+		U32 mCurrentSegment;
+		U64 mLiveBytes;
+		U8  mPadding[32];
+	};
+
+	enum ESlotState
+	{
+		SLOT_EMPTY = 0,
+		SLOT_USED,
+		SLOT_DELETED
+	};
+
+	struct IndexSlot
+	{
+		LLUUID mID;
+		S32 mType;
+		U32 mState;
+		U32 mSegment;
+		U32 mOffset;
+		U32 mSize;
+		U32 mAccessTime;
+	};
+
+	struct Segment
+	{
+		Segment() : mFile(nullptr), mEndOffset(0), mLiveBytes(0) {}
+
+		LLFILE* mFile;
+		U32 mEndOffset;
+		U64 mLiveBytes;
+	};
+	typedef std::map<U32, Segment> segment_map_t;
+
+	bool openIndex();
+	void resetIndex(U32 capacity);
+	void loadSegments();
+	void closeSegments();
+
+	IndexHeader* getHeader() const { return (IndexHeader*)mIndex.getData(); }
+	IndexSlot* getSlots() const { return (IndexSlot*)(mIndex.getData() + sizeof(IndexHeader)); }
+
+	// Returns the slot holding id, or nullptr. Caller holds mMutex.
+	IndexSlot* findSlot(const LLUUID& id) const;
+	// Returns the slot holding id or a free slot to insert it into, growing
+	// the table if needed. Caller holds mMutex.
+	IndexSlot* findOrInsertSlot(const LLUUID& id);
+	void growIndex();
+	void releaseSlot(IndexSlot* slot);
+
+	std::string getSegmentFilename(U32 segment) const;
+	Segment* getSegment(U32 segment, bool create);
+	// Picks the segment to append bytes to, starting a new one when the
+	// current one is full.
+	U32 getAppendSegment(U32 bytes);
+
+	bool readData(const IndexSlot& slot, U32 offset, U8* buffer, U32 bytes);
+	bool writeData(U32 segment, U32 offset, const U8* buffer, U32 bytes);
+
+	static U32 getNow();
+
+private:
+	LLMutex mMutex;
+	std::string mStoreDir;
+	LLMappedFile mIndex;
+	segment_map_t mSegments;
+	bool mEnableCacheDebugInfo;
+};
+
+#endif // LL_LLDISKCACHESTORE_H
@@ -41,6 +41,15 @@ const S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSystem:
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
+// <FS> Packed asset store
+// Returns the packed store if the disk cache uses one, nullptr if assets
+// are kept as one file each.
+static LLDiskCacheStore* get_packed_store()
+{
+    return LLDiskCache::getInstance()->getPackedStore();
+}
+// </FS>
+
 LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode)
 {
     mFileType = file_type;
@@ -52,23 +61,37 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // This block of code was originally called in the read() method but after comments here:
     // https://bitbucket.org/lindenlab/viewer/commits/e28c1b46e9944f0215a13cab8ee7dded88d7fc90#comment-10537114
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
-    if (mode == LLFileSystem::READ)
+    // <FS> Packed asset store
+    //if (mode == LLFileSystem::READ)
+    if (mode == LLFileSystem::READ && get_packed_store())
     {
-        // build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
-        std::string id;
-        mFileID.toString(id);
-        const std::string extra_info = "";
-        const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
-
-        // update the last access time for the file if it exists - this is required
-        // even though we are reading and not writing because this is the
-        // way the cache works - it relies on a valid "last accessed time" for
-        // each file so it knows how to remove the oldest, unused files
-        bool exists = gDirUtilp->fileExists(filename);
-        if (exists)
-        {
-            LLDiskCache::getInstance()->updateFileAccessTime(filename);
-        }
+        // only touches the mapped index, no filesystem timestamp write
+        get_packed_store()->updateAccessTime(mFileID);
+    }
+    else if (mode == LLFileSystem::READ)
+    // </FS>
+    {
+        // <FS> In-memory LRU access index
+        // The last access time is kept in memory now and written to the
+        // file in batches by the purge thread, so there is no stat() and no
+        // timestamp write per read any more.
+        //// build the filename (TODO: we do this in a few places - perhaps we should factor into a single function)
+        //std::string id;
+        //mFileID.toString(id);
+        //const std::string extra_info = "";
+        //const std::string filename = LLDiskCache::getInstance()->metaDataToFilepath(id, mFileType, extra_info);
+
+        //// update the last access time for the file if it exists - this is required
+        //// even though we are reading and not writing because this is the
+        //// way the cache works - it relies on a valid "last accessed time" for
+        //// each file so it knows how to remove the oldest, unused files
+        //bool exists = gDirUtilp->fileExists(filename);
+        //if (exists)
+        //{
+        //    LLDiskCache::getInstance()->updateFileAccessTime(filename);
+        //}
+        LLDiskCache::getInstance()->noteFileAccess(mFileID);
+        // </FS>
     }
 }
 
@@ -80,6 +103,12 @@ LLFileSystem::~LLFileSystem()
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        return store->exists(file_id);
+    }
+    // </FS>
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -106,12 +135,20 @@ bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType fil
 bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType file_type, int suppress_error /*= 0*/)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        store->remove(file_id);
+        return true;
+    }
+    // </FS>
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
     const std::string filename =  LLDiskCache::getInstance()->metaDataToFilepath(id_str, file_type, extra_info);
 
     LLFile::remove(filename.c_str(), suppress_error);
+    LLDiskCache::getInstance()->noteFileRemove(file_id); // <FS/> In-memory LRU access index
 
     return true;
 }
@@ -121,6 +158,17 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
                               const LLUUID& new_file_id, const LLAssetType::EType new_file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        if (!store->rename(old_file_id, new_file_id, new_file_type))
+        {
+            LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " reason: not in packed cache" << LL_ENDL;
+        }
+        // See below for why this always succeeds
+        return TRUE;
+    }
+    // </FS>
     std::string old_id_str;
     old_file_id.toString(old_id_str);
     const std::string extra_info = "";
@@ -141,6 +189,13 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return FALSE;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_id_str << " reason: "  << strerror(errno) << LL_ENDL;
     }
+    // <FS> In-memory LRU access index
+    else
+    {
+        LLDiskCache::getInstance()->noteFileRemove(old_file_id);
+        LLDiskCache::getInstance()->noteFileWrite(new_file_id, getFileSize(new_file_id, new_file_type));
+    }
+    // </FS>
 
     return TRUE;
 }
@@ -149,6 +204,12 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
 S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        return store->getSize(file_id);
+    }
+    // </FS>
     std::string id_str;
     file_id.toString(id_str);
     const std::string extra_info = "";
@@ -177,6 +238,15 @@ BOOL LLFileSystem::read(U8* buffer, S32 bytes)
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
     BOOL success = FALSE;
 
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        mBytesRead = store->read(mFileID, mPosition, buffer, bytes);
+        mPosition += mBytesRead;
+        return mBytesRead ? TRUE : FALSE;
+    }
+    // </FS>
+
     std::string id;
     mFileID.toString(id);
     const std::string extra_info = "";
@@ -244,6 +314,37 @@ BOOL LLFileSystem::eof()
 BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Packed asset store
+    if (LLDiskCacheStore* store = get_packed_store())
+    {
+        // Same semantics as the file modes below: APPEND adds to the end,
+        // READ_WRITE overwrites at the current position and WRITE replaces
+        // the whole asset.
+        S32 new_size = -1;
+        if (mMode == APPEND)
+        {
+            new_size = store->write(mFileID, mFileType, store->getSize(mFileID), buffer, bytes, false);
+            if (new_size >= 0)
+            {
+                mPosition = new_size;
+            }
+        }
+        else if (mMode == READ_WRITE)
+        {
+            new_size = store->write(mFileID, mFileType, mPosition, buffer, bytes, false);
+            if (new_size >= 0)
+            {
+                mPosition += bytes;
+            }
+        }
+        else
+        {
+            new_size = store->write(mFileID, mFileType, 0, buffer, bytes, true);
+            mPosition = bytes;
+        }
+        return new_size >= 0 ? TRUE : FALSE;
+    }
+    // </FS>
     std::string id_str;
     mFileID.toString(id_str);
     const std::string extra_info = "";
@@ -310,6 +411,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             mPosition = ftell(ofs);
             fclose(ofs);
             success = (bytes_written == bytes);
+            LLDiskCache::getInstance()->noteFileWrite(mFileID, mPosition); // <FS/> In-memory LRU access index
         }
     }
     else if (mMode == READ_WRITE)
@@ -336,6 +438,14 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
                 success = (bytes_written == bytes);
             }
         }
+
+        // <FS> In-memory LRU access index
+        if (success)
+        {
+            // Overwriting in the middle doesn't tell us the file size
+            LLDiskCache::getInstance()->noteFileWrite(mFileID, getFileSize(mFileID, mFileType));
+        }
+        // </FS>
     }
     else
     {
@@ -346,6 +456,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             mPosition = ftell(ofs);
             fclose(ofs);
             success = (bytes_written == bytes);
+            LLDiskCache::getInstance()->noteFileWrite(mFileID, mPosition); // <FS/> In-memory LRU access index
         }
     }
     // </FS:Ansariel>
@@ -0,0 +1,291 @@
+/**
+ * @file lldiskcachestore_test.cpp
+ * @brief LLDiskCacheStore test cases and comparison with the one file per
+ *        asset cache layout.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "../lldiskcachestore.h"
+
+#include "../test/lltut.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <chrono>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock bench_clock_t;
+
+	F64 elapsed_ms(const bench_clock_t::time_point& start)
+	{
+		return std::chrono::duration<F64, std::milli>(bench_clock_t::now() - start).count();
+	}
+
+	std::vector<U8> make_asset(U32 seed, U32 size)
+	{
+		std::vector<U8> data(size);
+		for (U32 i = 0; i < size; ++i)
+		{
+			data[i] = (U8)((seed * 31 + i) & 0xff);
+		}
+		return data;
+	}
+}
+
+namespace tut
+{
+	struct diskcachestore_data
+	{
+		diskcachestore_data()
+		{
+			mDir = gDirUtilp->add(LLFile::tmpdir(), llformat("lldiskcachestore_test_%s", LLUUID::generateNewID().asString().c_str()));
+			LLFile::mkdir(mDir);
+		}
+
+		~diskcachestore_data()
+		{
+			removeDir(gDirUtilp->add(mDir, "packed"));
+			removeDir(gDirUtilp->add(mDir, "files"));
+			LLFile::rmdir(mDir);
+		}
+
+		void removeDir(const std::string& dir)
+		{
+			if (LLFile::isdir(dir))
+			{
+				boost::system::error_code ec;
+				boost::filesystem::remove_all(dir, ec);
+			}
+		}
+
+		std::string mDir;
+	};
+	typedef test_group<diskcachestore_data> diskcachestore_test;
+	typedef diskcachestore_test::object diskcachestore_object;
+	tut::diskcachestore_test diskcachestore("LLDiskCacheStore");
+
+	template<> template<>
+	void diskcachestore_object::test<1>()
+	{
+		set_test_name("read, write, append and remove");
+
+		LLDiskCacheStore store(gDirUtilp->add(mDir, "packed"), false);
+		ensure("store opened", store.isValid());
+
+		LLUUID id = LLUUID::generateNewID();
+		ensure("not stored yet", !store.exists(id));
+
+		std::vector<U8> data = make_asset(1, 1000);
+		ensure_equals("write", store.write(id, LLAssetType::AT_TEXTURE, 0, &data[0], 1000, true), 1000);
+		ensure("exists", store.exists(id));
+		ensure_equals("size", store.getSize(id), 1000);
+
+		// Append while this is the tail of the segment (in place)
+		std::vector<U8> more = make_asset(2, 500);
+		ensure_equals("append", store.write(id, LLAssetType::AT_TEXTURE, store.getSize(id), &more[0], 500, false), 1500);
+
+		// Write another asset so the first one is not the tail any more
+		LLUUID other = LLUUID::generateNewID();
+		ensure_equals("write other", store.write(other, LLAssetType::AT_SOUND, 0, &data[0], 100, true), 100);
+		ensure_equals("append relocated", store.write(id, LLAssetType::AT_TEXTURE, store.getSize(id), &more[0], 500, false), 2000);
+
+		std::vector<U8> expected = data;
+		expected.insert(expected.end(), more.begin(), more.end());
+		expected.insert(expected.end(), more.begin(), more.end());
+
+		std::vector<U8> buffer(3000);
+		ensure_equals("read all", store.read(id, 0, &buffer[0], 3000), 2000);
+		buffer.resize(2000);
+		ensure("read back matches", buffer == expected);
+
+		// Partial overwrite in the middle keeps the rest
+		U8 patch[4] = { 9, 9, 9, 9 };
+		ensure_equals("overwrite", store.write(id, LLAssetType::AT_TEXTURE, 10, patch, 4, false), 2000);
+		ensure_equals("read patched", store.read(id, 8, &buffer[0], 8), 8);
+		ensure_equals("before patch", buffer[1], expected[9]);
+		ensure_equals("patch", buffer[2], 9);
+		ensure_equals("after patch", buffer[6], expected[14]);
+
+		// Writing past the end fails and leaves the asset alone
+		ensure_equals("write past end", store.write(id, LLAssetType::AT_TEXTURE, 2001, patch, 4, false), -1);
+		ensure_equals("write past end of missing", store.write(LLUUID::generateNewID(), LLAssetType::AT_TEXTURE, 1, patch, 4, false), -1);
+		ensure_equals("size after write past end", store.getSize(id), 2000);
+
+		ensure_equals("live bytes", (S32)store.getLiveBytes(), 2100);
+		ensure("remove", store.remove(id));
+		ensure("removed", !store.exists(id));
+		ensure_equals("read removed", store.read(id, 0, &buffer[0], 10), 0);
+		ensure_equals("live bytes after remove", (S32)store.getLiveBytes(), 100);
+	}
+
+	template<> template<>
+	void diskcachestore_object::test<2>()
+	{
+		set_test_name("rename and persistence");
+
+		const std::string dir = gDirUtilp->add(mDir, "packed");
+		LLUUID id = LLUUID::generateNewID();
+		LLUUID new_id = LLUUID::generateNewID();
+		std::vector<U8> data = make_asset(3, 4096);
+		{
+			LLDiskCacheStore store(dir, false);
+			store.write(id, LLAssetType::AT_TEXTURE, 0, &data[0], 4096, true);
+			ensure("rename", store.rename(id, new_id, LLAssetType::AT_MESH));
+			ensure("old id gone", !store.exists(id));
+			ensure("new id present", store.exists(new_id));
+		}
+
+		LLDiskCacheStore store(dir, false);
+		ensure_equals("entries after reopen", store.getEntryCount(), 1U);
+		std::vector<U8> buffer(4096);
+		ensure_equals("read after reopen", store.read(new_id, 0, &buffer[0], 4096), 4096);
+		ensure("contents after reopen", buffer == data);
+	}
+
+	template<> template<>
+	void diskcachestore_object::test<3>()
+	{
+		set_test_name("purge, compaction and index growth");
+
+		LLDiskCacheStore store(gDirUtilp->add(mDir, "packed"), false);
+
+		// Enough entries to force the index to grow past its initial size
+		const U32 count = 20000;
+		std::vector<LLUUID> ids;
+		std::vector<U8> data = make_asset(4, 256);
+		for (U32 i = 0; i < count; ++i)
+		{
+			ids.push_back(LLUUID::generateNewID());
+			store.write(ids.back(), LLAssetType::AT_OBJECT, 0, &data[0], 256, true);
+		}
+		ensure_equals("entries", store.getEntryCount(), count);
+		for (U32 i = 0; i < count; i += 997)
+		{
+			ensure("lookup after growth", store.exists(ids[i]));
+		}
+
+		std::vector<LLUUID> protected_ids;
+		protected_ids.push_back(ids[0]);
+		store.purge(256 * 1000, protected_ids);
+		ensure("under budget", store.getLiveBytes() <= 256 * 1001);
+		ensure("protected entry kept", store.exists(ids[0]));
+
+		const uintmax_t disk_before = store.getDiskBytes();
+		store.compact();
+		ensure("compaction keeps live data", store.getLiveBytes() <= 256 * 1001);
+		ensure("compaction never grows disk use", store.getDiskBytes() <= disk_before);
+	}
+
+	template<> template<>
+	void diskcachestore_object::test<4>()
+	{
+		set_test_name("compare with one file per asset");
+
+		const U32 count = 2000;
+		const U32 size = 16 * 1024;
+		std::vector<LLUUID> ids;
+		for (U32 i = 0; i < count; ++i)
+		{
+			ids.push_back(LLUUID::generateNewID());
+		}
+		std::vector<U8> data = make_asset(5, size);
+
+		// The original layout: <dir>/<first uuid char>/sl_cache_<uuid>_0.asset
+		const std::string files_dir = gDirUtilp->add(mDir, "files");
+		LLFile::mkdir(files_dir);
+		for (const char* c = "0123456789abcdef"; *c; ++c)
+		{
+			LLFile::mkdir(gDirUtilp->add(files_dir, std::string(1, *c)));
+		}
+		auto filename = [&](const LLUUID& id)
+		{
+			const std::string id_str = id.asString();
+			return gDirUtilp->add(files_dir, std::string(1, id_str[0]), "sl_cache_" + id_str + "_0.asset");
+		};
+
+		bench_clock_t::time_point start = bench_clock_t::now();
+		for (const LLUUID& id : ids)
+		{
+			LLUniqueFile file = LLFile::fopen(filename(id), "wb");
+			fwrite(&data[0], 1, size, file);
+		}
+		const F64 files_write = elapsed_ms(start);
+
+		start = bench_clock_t::now();
+		S32 found = 0;
+		for (const LLUUID& id : ids)
+		{
+			llstat file_stat;
+			found += (LLFile::stat(filename(id), &file_stat) == 0 && file_stat.st_size > 0) ? 1 : 0;
+		}
+		const F64 files_lookup = elapsed_ms(start);
+		ensure_equals("files found", found, (S32)count);
+
+		// Same walk + sort that LLDiskCache::purge() does
+		start = bench_clock_t::now();
+		std::vector<std::pair<std::time_t, uintmax_t>> file_info;
+		boost::system::error_code ec;
+		for (auto& entry : boost::make_iterator_range(boost::filesystem::recursive_directory_iterator(files_dir, ec), {}))
+		{
+			if (boost::filesystem::is_regular_file(entry, ec))
+			{
+				file_info.emplace_back(boost::filesystem::last_write_time(entry, ec), boost::filesystem::file_size(entry, ec));
+			}
+		}
+		std::sort(file_info.begin(), file_info.end());
+		const F64 files_purge = elapsed_ms(start);
+		ensure_equals("files walked", file_info.size(), (size_t)count);
+
+		LLDiskCacheStore store(gDirUtilp->add(mDir, "packed"), false);
+		start = bench_clock_t::now();
+		for (const LLUUID& id : ids)
+		{
+			store.write(id, LLAssetType::AT_TEXTURE, 0, &data[0], size, true);
+		}
+		const F64 store_write = elapsed_ms(start);
+
+		start = bench_clock_t::now();
+		found = 0;
+		for (const LLUUID& id : ids)
+		{
+			found += store.exists(id) ? 1 : 0;
+		}
+		const F64 store_lookup = elapsed_ms(start);
+		ensure_equals("store found", found, (S32)count);
+
+		start = bench_clock_t::now();
+		store.purge((uintmax_t)size * count / 2, std::vector<LLUUID>());
+		const F64 store_purge = elapsed_ms(start);
+		ensure("store purged", store.getLiveBytes() <= (uintmax_t)size * count / 2);
+
+		LL_INFOS("LLDiskCache") << count << " assets of " << size << " bytes" << LL_ENDL;
+		LL_INFOS("LLDiskCache") << "write:  files " << files_write << " ms, packed " << store_write << " ms" << LL_ENDL;
+		LL_INFOS("LLDiskCache") << "lookup: files " << files_lookup << " ms, packed " << store_lookup << " ms" << LL_ENDL;
+		LL_INFOS("LLDiskCache") << "purge:  files " << files_purge << " ms (walk and sort only), packed " << store_purge << " ms" << LL_ENDL;
+	}
+}
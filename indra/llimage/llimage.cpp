@@ -40,6 +40,8 @@
 #include "llimagedxt.h"
 #include "llmemory.h"
 
+// <FS> SIMD image kernels, the scaling templates moved to llimagekernels.cpp
+#if 0
 #include <boost/preprocessor.hpp>
 
 //..................................................................................
@@ -578,6 +580,9 @@ static void bilinear_scale(const U8 *src, U32 srcW, U32 srcH, U32 srcCh, U32 src
 	}
 
 }
+#endif
+#include "llimagekernels.h"
+// </FS>
 
 //---------------------------------------------------------------------------
 // LLImage
@@ -595,6 +600,7 @@ void LLImage::initClass(bool use_new_byte_range, S32 minimal_reverse_byte_range_
 	sUseNewByteRange = use_new_byte_range;
     sMinimalReverseByteRangePercent = minimal_reverse_byte_range_percent;
 	sMutex = new LLMutex();
+	LLImageKernels::initClass(); // <FS/> SIMD image kernels
 }
 
 //static
@@ -1181,30 +1187,33 @@ void LLImageRaw::compositeUnscaled4onto3( LLImageRaw* src )
 		return;
 	}
 	// </FS:Beq>
-	while( pixels-- )
-	{
-		U8 alpha = src_data[3];
-		if( alpha )
-		{
-			if( 255 == alpha )
-			{
-				dst_data[0] = src_data[0];
-				dst_data[1] = src_data[1];
-				dst_data[2] = src_data[2];
-			}
-			else
-			{
-
-				U8 transparency = 255 - alpha;
-				dst_data[0] = fastFractionalMult( dst_data[0], transparency ) + fastFractionalMult( src_data[0], alpha );
-				dst_data[1] = fastFractionalMult( dst_data[1], transparency ) + fastFractionalMult( src_data[1], alpha );
-				dst_data[2] = fastFractionalMult( dst_data[2], transparency ) + fastFractionalMult( src_data[2], alpha );
-			}
-		}
-
-		src_data += 4;
-		dst_data += 3;
-	}
+	// <FS> SIMD image kernels, the loop moved to llimagekernels.cpp
+	//while( pixels-- )
+	//{
+		//U8 alpha = src_data[3];
+		//if( alpha )
+		//{
+			//if( 255 == alpha )
+			//{
+				//dst_data[0] = src_data[0];
+				//dst_data[1] = src_data[1];
+				//dst_data[2] = src_data[2];
+			//}
+			//else
+			//{
+
+				//U8 transparency = 255 - alpha;
+				//dst_data[0] = fastFractionalMult( dst_data[0], transparency ) + fastFractionalMult( src_data[0], alpha );
+				//dst_data[1] = fastFractionalMult( dst_data[1], transparency ) + fastFractionalMult( src_data[1], alpha );
+				//dst_data[2] = fastFractionalMult( dst_data[2], transparency ) + fastFractionalMult( src_data[2], alpha );
+			//}
+		//}
+
+		//src_data += 4;
+		//dst_data += 3;
+	//}
+	LLImageKernels::compositeUnscaled4onto3(src_data, dst_data, pixels);
+	// </FS>
 }
 
 
@@ -1431,10 +1440,17 @@ void LLImageRaw::copyScaled( LLImageRaw* src )
 		return;
 	}
 
-	bilinear_scale(
+	// <FS> SIMD image kernels
+	//bilinear_scale(
+	//		src->getData(), src->getWidth(), src->getHeight(), src->getComponents(), src->getWidth()*src->getComponents()
+	//	,	dst->getData(), dst->getWidth(), dst->getHeight(), dst->getComponents(), dst->getWidth()*dst->getComponents()
+	//);
+	llassert(src->getComponents() == dst->getComponents());
+	LLImageKernels::bilinearScale(
 			src->getData(), src->getWidth(), src->getHeight(), src->getComponents(), src->getWidth()*src->getComponents()
-		,	dst->getData(), dst->getWidth(), dst->getHeight(), dst->getComponents(), dst->getWidth()*dst->getComponents()
+		,	dst->getData(), dst->getWidth(), dst->getHeight(), dst->getWidth()*dst->getComponents()
 	);
+	// </FS>
 
 	/*
 	S32 temp_data_size = src->getWidth() * dst->getHeight() * getComponents();
@@ -1493,7 +1509,10 @@ bool LLImageRaw::scale( S32 new_width, S32 new_height, bool scale_image_data )
                 return false; 
             }
 
-            bilinear_scale(getData(), old_width, old_height, components, old_width*components, new_data, new_width, new_height, components, new_width*components);
+            // <FS> SIMD image kernels
+            //bilinear_scale(getData(), old_width, old_height, components, old_width*components, new_data, new_width, new_height, components, new_width*components);
+            LLImageKernels::bilinearScale(getData(), old_width, old_height, components, old_width*components, new_data, new_width, new_height, new_width*components);
+            // </FS>
             setDataAndSize(new_data, new_width, new_height, components); 
 		}
 	}
@@ -1582,7 +1601,10 @@ LLPointer<LLImageRaw> LLImageRaw::scaled(S32 new_width, S32 new_height)
                 LL_WARNS() << "Failed to allocate new image" << LL_ENDL;
                 return result;
             }
-            bilinear_scale(getData(), old_width, old_height, components, old_width*components, result->getData(), new_width, new_height, components, new_width*components);
+            // <FS> SIMD image kernels
+            //bilinear_scale(getData(), old_width, old_height, components, old_width*components, result->getData(), new_width, new_height, components, new_width*components);
+            LLImageKernels::bilinearScale(getData(), old_width, old_height, components, old_width*components, result->getData(), new_width, new_height, new_width*components);
+            // </FS>
         }
     }
 
@@ -1591,213 +1613,219 @@ LLPointer<LLImageRaw> LLImageRaw::scaled(S32 new_width, S32 new_height)
 
 void LLImageRaw::copyLineScaled( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step )
 {
-	const S32 components = getComponents();
-	llassert( components >= 1 && components <= 4 );
-
-	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
-	const F32 norm_factor = 1.f / ratio;
-
-	S32 goff = components >= 2 ? 1 : 0;
-	S32 boff = components >= 3 ? 2 : 0;
-	for( S32 x = 0; x < out_pixel_len; x++ )
-	{
-		// Sample input pixels in range from sample0 to sample1.
-		// Avoid floating point accumulation error... don't just add ratio each time.  JC
-		const F32 sample0 = x * ratio;
-		const F32 sample1 = (x+1) * ratio;
-		const S32 index0 = llfloor(sample0);			// left integer (floor)
-		const S32 index1 = llfloor(sample1);			// right integer (floor)
-		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
-		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
-
-		if( index0 == index1 )
-		{
-			// Interval is embedded in one input pixel
-			S32 t0 = x * out_pixel_step * components;
-			S32 t1 = index0 * in_pixel_step * components;
-			U8* outp = out + t0;
-			U8* inp = in + t1;
-			for (S32 i = 0; i < components; ++i)
-			{
-				*outp = *inp;
-				++outp;
-				++inp;
-			}
-		}
-		else
-		{
-			// Left straddle
-			S32 t1 = index0 * in_pixel_step * components;
-			F32 r = in[t1 + 0] * fract0;
-			F32 g = in[t1 + goff] * fract0;
-			F32 b = in[t1 + boff] * fract0;
-			F32 a = 0;
-			if( components == 4)
-			{
-				a = in[t1 + 3] * fract0;
-			}
-		
-			// Central interval
-			if (components < 4)
-			{
-				for( S32 u = index0 + 1; u < index1; u++ )
-				{
-					S32 t2 = u * in_pixel_step * components;
-					r += in[t2 + 0];
-					g += in[t2 + goff];
-					b += in[t2 + boff];
-				}
-			}
-			else
-			{
-				for( S32 u = index0 + 1; u < index1; u++ )
-				{
-					S32 t2 = u * in_pixel_step * components;
-					r += in[t2 + 0];
-					g += in[t2 + 1];
-					b += in[t2 + 2];
-					a += in[t2 + 3];
-				}
-			}
-
-			// right straddle
-			// Watch out for reading off of end of input array.
-			if( fract1 && index1 < in_pixel_len )
-			{
-				S32 t3 = index1 * in_pixel_step * components;
-				if (components < 4)
-				{
-					U8 in0 = in[t3 + 0];
-					U8 in1 = in[t3 + goff];
-					U8 in2 = in[t3 + boff];
-					r += in0 * fract1;
-					g += in1 * fract1;
-					b += in2 * fract1;
-				}
-				else
-				{
-					U8 in0 = in[t3 + 0];
-					U8 in1 = in[t3 + 1];
-					U8 in2 = in[t3 + 2];
-					U8 in3 = in[t3 + 3];
-					r += in0 * fract1;
-					g += in1 * fract1;
-					b += in2 * fract1;
-					a += in3 * fract1;
-				}
-			}
-
-			r *= norm_factor;
-			g *= norm_factor;
-			b *= norm_factor;
-			a *= norm_factor;  // skip conditional
-
-			S32 t4 = x * out_pixel_step * components;
-			out[t4 + 0] = U8(ll_round(r));
-			if (components >= 2)
-				out[t4 + 1] = U8(ll_round(g));
-			if (components >= 3)
-				out[t4 + 2] = U8(ll_round(b));
-			if( components == 4)
-				out[t4 + 3] = U8(ll_round(a));
-		}
-	}
+	// <FS> SIMD image kernels, the loop moved to llimagekernels.cpp
+	//const S32 components = getComponents();
+	//llassert( components >= 1 && components <= 4 );
+
+	//const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	//const F32 norm_factor = 1.f / ratio;
+
+	//S32 goff = components >= 2 ? 1 : 0;
+	//S32 boff = components >= 3 ? 2 : 0;
+	//for( S32 x = 0; x < out_pixel_len; x++ )
+	//{
+		//// Sample input pixels in range from sample0 to sample1.
+		//// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		//const F32 sample0 = x * ratio;
+		//const F32 sample1 = (x+1) * ratio;
+		//const S32 index0 = llfloor(sample0);			// left integer (floor)
+		//const S32 index1 = llfloor(sample1);			// right integer (floor)
+		//const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		//const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		//if( index0 == index1 )
+		//{
+			//// Interval is embedded in one input pixel
+			//S32 t0 = x * out_pixel_step * components;
+			//S32 t1 = index0 * in_pixel_step * components;
+			//U8* outp = out + t0;
+			//U8* inp = in + t1;
+			//for (S32 i = 0; i < components; ++i)
+			//{
+				//*outp = *inp;
+				//++outp;
+				//++inp;
+			//}
+		//}
+		//else
+		//{
+			//// Left straddle
+			//S32 t1 = index0 * in_pixel_step * components;
+			//F32 r = in[t1 + 0] * fract0;
+			//F32 g = in[t1 + goff] * fract0;
+			//F32 b = in[t1 + boff] * fract0;
+			//F32 a = 0;
+			//if( components == 4)
+			//{
+				//a = in[t1 + 3] * fract0;
+			//}
+
+			//// Central interval
+			//if (components < 4)
+			//{
+				//for( S32 u = index0 + 1; u < index1; u++ )
+				//{
+					//S32 t2 = u * in_pixel_step * components;
+					//r += in[t2 + 0];
+					//g += in[t2 + goff];
+					//b += in[t2 + boff];
+				//}
+			//}
+			//else
+			//{
+				//for( S32 u = index0 + 1; u < index1; u++ )
+				//{
+					//S32 t2 = u * in_pixel_step * components;
+					//r += in[t2 + 0];
+					//g += in[t2 + 1];
+					//b += in[t2 + 2];
+					//a += in[t2 + 3];
+				//}
+			//}
+
+			//// right straddle
+			//// Watch out for reading off of end of input array.
+			//if( fract1 && index1 < in_pixel_len )
+			//{
+				//S32 t3 = index1 * in_pixel_step * components;
+				//if (components < 4)
+				//{
+					//U8 in0 = in[t3 + 0];
+					//U8 in1 = in[t3 + goff];
+					//U8 in2 = in[t3 + boff];
+					//r += in0 * fract1;
+					//g += in1 * fract1;
+					//b += in2 * fract1;
+				//}
+				//else
+				//{
+					//U8 in0 = in[t3 + 0];
+					//U8 in1 = in[t3 + 1];
+					//U8 in2 = in[t3 + 2];
+					//U8 in3 = in[t3 + 3];
+					//r += in0 * fract1;
+					//g += in1 * fract1;
+					//b += in2 * fract1;
+					//a += in3 * fract1;
+				//}
+			//}
+
+			//r *= norm_factor;
+			//g *= norm_factor;
+			//b *= norm_factor;
+			//a *= norm_factor;  // skip conditional
+
+			//S32 t4 = x * out_pixel_step * components;
+			//out[t4 + 0] = U8(ll_round(r));
+			//if (components >= 2)
+				//out[t4 + 1] = U8(ll_round(g));
+			//if (components >= 3)
+				//out[t4 + 2] = U8(ll_round(b));
+			//if( components == 4)
+				//out[t4 + 3] = U8(ll_round(a));
+		//}
+	//}
+	LLImageKernels::copyLineScaled(in, out, getComponents(), in_pixel_len, out_pixel_len, in_pixel_step, out_pixel_step);
+	// </FS>
 }
 
 void LLImageRaw::compositeRowScaled4onto3( U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len )
 {
 	llassert( getComponents() == 3 );
 
-	const S32 IN_COMPONENTS = 4;
-	const S32 OUT_COMPONENTS = 3;
-
-	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
-	const F32 norm_factor = 1.f / ratio;
-
-	for( S32 x = 0; x < out_pixel_len; x++ )
-	{
-		// Sample input pixels in range from sample0 to sample1.
-		// Avoid floating point accumulation error... don't just add ratio each time.  JC
-		const F32 sample0 = x * ratio;
-		const F32 sample1 = (x+1) * ratio;
-		const S32 index0 = S32(sample0);			// left integer (floor)
-		const S32 index1 = S32(sample1);			// right integer (floor)
-		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
-		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
-
-		U8 in_scaled_r;
-		U8 in_scaled_g;
-		U8 in_scaled_b;
-		U8 in_scaled_a;
-
-		if( index0 == index1 )
-		{
-			// Interval is embedded in one input pixel
-			S32 t1 = index0 * IN_COMPONENTS;
-			in_scaled_r = in[t1 + 0];
-			in_scaled_g = in[t1 + 0];
-			in_scaled_b = in[t1 + 0];
-			in_scaled_a = in[t1 + 0];
-		}
-		else
-		{
-			// Left straddle
-			S32 t1 = index0 * IN_COMPONENTS;
-			F32 r = in[t1 + 0] * fract0;
-			F32 g = in[t1 + 1] * fract0;
-			F32 b = in[t1 + 2] * fract0;
-			F32 a = in[t1 + 3] * fract0;
-		
-			// Central interval
-			for( S32 u = index0 + 1; u < index1; u++ )
-			{
-				S32 t2 = u * IN_COMPONENTS;
-				r += in[t2 + 0];
-				g += in[t2 + 1];
-				b += in[t2 + 2];
-				a += in[t2 + 3];
-			}
-
-			// right straddle
-			// Watch out for reading off of end of input array.
-			if( fract1 && index1 < in_pixel_len )
-			{
-				S32 t3 = index1 * IN_COMPONENTS;
-				r += in[t3 + 0] * fract1;
-				g += in[t3 + 1] * fract1;
-				b += in[t3 + 2] * fract1;
-				a += in[t3 + 3] * fract1;
-			}
-
-			r *= norm_factor;
-			g *= norm_factor;
-			b *= norm_factor;
-			a *= norm_factor;
-
-			in_scaled_r = U8(ll_round(r));
-			in_scaled_g = U8(ll_round(g));
-			in_scaled_b = U8(ll_round(b));
-			in_scaled_a = U8(ll_round(a));
-		}
-
-		if( in_scaled_a )
-		{
-			if( 255 == in_scaled_a )
-			{
-				out[0] = in_scaled_r;
-				out[1] = in_scaled_g;
-				out[2] = in_scaled_b;
-			}
-			else
-			{
-				U8 transparency = 255 - in_scaled_a;
-				out[0] = fastFractionalMult( out[0], transparency ) + fastFractionalMult( in_scaled_r, in_scaled_a );
-				out[1] = fastFractionalMult( out[1], transparency ) + fastFractionalMult( in_scaled_g, in_scaled_a );
-				out[2] = fastFractionalMult( out[2], transparency ) + fastFractionalMult( in_scaled_b, in_scaled_a );
-			}
-		}
-		out += OUT_COMPONENTS;
-	}
+	// <FS> SIMD image kernels, the loop moved to llimagekernels.cpp
+	//const S32 IN_COMPONENTS = 4;
+	//const S32 OUT_COMPONENTS = 3;
+
+	//const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	//const F32 norm_factor = 1.f / ratio;
+
+	//for( S32 x = 0; x < out_pixel_len; x++ )
+	//{
+		//// Sample input pixels in range from sample0 to sample1.
+		//// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		//const F32 sample0 = x * ratio;
+		//const F32 sample1 = (x+1) * ratio;
+		//const S32 index0 = S32(sample0);			// left integer (floor)
+		//const S32 index1 = S32(sample1);			// right integer (floor)
+		//const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		//const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		//U8 in_scaled_r;
+		//U8 in_scaled_g;
+		//U8 in_scaled_b;
+		//U8 in_scaled_a;
+
+		//if( index0 == index1 )
+		//{
+			//// Interval is embedded in one input pixel
+			//S32 t1 = index0 * IN_COMPONENTS;
+			//in_scaled_r = in[t1 + 0];
+			//in_scaled_g = in[t1 + 0];
+			//in_scaled_b = in[t1 + 0];
+			//in_scaled_a = in[t1 + 0];
+		//}
+		//else
+		//{
+			//// Left straddle
+			//S32 t1 = index0 * IN_COMPONENTS;
+			//F32 r = in[t1 + 0] * fract0;
+			//F32 g = in[t1 + 1] * fract0;
+			//F32 b = in[t1 + 2] * fract0;
+			//F32 a = in[t1 + 3] * fract0;
+
+			//// Central interval
+			//for( S32 u = index0 + 1; u < index1; u++ )
+			//{
+				//S32 t2 = u * IN_COMPONENTS;
+				//r += in[t2 + 0];
+				//g += in[t2 + 1];
+				//b += in[t2 + 2];
+				//a += in[t2 + 3];
+			//}
+
+			//// right straddle
+			//// Watch out for reading off of end of input array.
+			//if( fract1 && index1 < in_pixel_len )
+			//{
+				//S32 t3 = index1 * IN_COMPONENTS;
+				//r += in[t3 + 0] * fract1;
+				//g += in[t3 + 1] * fract1;
+				//b += in[t3 + 2] * fract1;
+				//a += in[t3 + 3] * fract1;
+			//}
+
+			//r *= norm_factor;
+			//g *= norm_factor;
+			//b *= norm_factor;
+			//a *= norm_factor;
+
+			//in_scaled_r = U8(ll_round(r));
+			//in_scaled_g = U8(ll_round(g));
+			//in_scaled_b = U8(ll_round(b));
+			//in_scaled_a = U8(ll_round(a));
+		//}
+
+		//if( in_scaled_a )
+		//{
+			//if( 255 == in_scaled_a )
+			//{
+				//out[0] = in_scaled_r;
+				//out[1] = in_scaled_g;
+				//out[2] = in_scaled_b;
+			//}
+			//else
+			//{
+				//U8 transparency = 255 - in_scaled_a;
+				//out[0] = fastFractionalMult( out[0], transparency ) + fastFractionalMult( in_scaled_r, in_scaled_a );
+				//out[1] = fastFractionalMult( out[1], transparency ) + fastFractionalMult( in_scaled_g, in_scaled_a );
+				//out[2] = fastFractionalMult( out[2], transparency ) + fastFractionalMult( in_scaled_b, in_scaled_a );
+			//}
+		//}
+		//out += OUT_COMPONENTS;
+	//}
+	LLImageKernels::compositeRowScaled4onto3(in, out, in_pixel_len, out_pixel_len);
+	// </FS>
 }
 
 bool LLImageRaw::validateSrcAndDst(std::string func, LLImageRaw* src, LLImageRaw* dst)
@@ -2278,26 +2306,28 @@ S8 LLImageFormatted::getCodec() const
 	return mCodec;
 }
 
-static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
-	dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
-}
+// <FS> SIMD image kernels, moved to llimagekernels.cpp
+//static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+//{
+	//dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	//dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	//dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+	//dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
+//}
 
-static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
-}
+//static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+//{
+	//dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	//dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	//dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+//}
 
-static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
-{
-	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
-	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
-}
+//static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+//{
+	//dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	//dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+//}
+// </FS>
 
 void LLImageBase::setDataAndSize(U8 *data, S32 size)
 { 
@@ -2310,35 +2340,38 @@ void LLImageBase::setDataAndSize(U8 *data, S32 size)
 void LLImageBase::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
 {
 	llassert(width > 0 && height > 0);
-	U8* data = mipdata;
-	S32 in_width = width*2;
-	for (S32 h=0; h<height; h++)
-	{
-		for (S32 w=0; w<width; w++)
-		{
-			switch(nchannels)
-			{
-			  case 4:
-				avg4_colors4(indata, indata+4, indata+4*in_width, indata+4*in_width+4, data);
-				break;
-			  case 3:
-				avg4_colors3(indata, indata+3, indata+3*in_width, indata+3*in_width+3, data);
-				break;
-			  case 2:
-				avg4_colors2(indata, indata+2, indata+2*in_width, indata+2*in_width+2, data);
-				break;
-			  case 1:
-				*(U8*)data = (U8)(((U32)(indata[0]) + indata[1] + indata[in_width] + indata[in_width+1])>>2);
-				break;
-			  default:
-				LL_WARNS() << "generateMmip called with bad num channels: " << nchannels << LL_ENDL;
-				return;
-			}
-			indata += nchannels*2;
-			data += nchannels;
-		}
-		indata += nchannels*in_width; // skip odd lines
-	}
+	// <FS> SIMD image kernels, the loop moved to llimagekernels.cpp
+	//U8* data = mipdata;
+	//S32 in_width = width*2;
+	//for (S32 h=0; h<height; h++)
+	//{
+		//for (S32 w=0; w<width; w++)
+		//{
+			//switch(nchannels)
+			//{
+			  //case 4:
+				//avg4_colors4(indata, indata+4, indata+4*in_width, indata+4*in_width+4, data);
+				//break;
+			  //case 3:
+				//avg4_colors3(indata, indata+3, indata+3*in_width, indata+3*in_width+3, data);
+				//break;
+			  //case 2:
+				//avg4_colors2(indata, indata+2, indata+2*in_width, indata+2*in_width+2, data);
+				//break;
+			  //case 1:
+				//*(U8*)data = (U8)(((U32)(indata[0]) + indata[1] + indata[in_width] + indata[in_width+1])>>2);
+				//break;
+			  //default:
+				//LL_WARNS() << "generateMmip called with bad num channels: " << nchannels << LL_ENDL;
+				//return;
+			//}
+			//indata += nchannels*2;
+			//data += nchannels;
+		//}
+		//indata += nchannels*in_width; // skip odd lines
+	//}
+	LLImageKernels::generateMip(indata, mipdata, width, height, nchannels);
+	// </FS>
 }
 
 
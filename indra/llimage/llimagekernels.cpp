@@ -0,0 +1,1597 @@
+/**
+ * @file llimagekernels.cpp
+ * @brief Pixel kernels for mip generation, scaling and compositing.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llmath.h"
+#include "llprocessor.h"
+
+#include <boost/preprocessor.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LL_IMAGE_KERNELS_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+
+// AVX2 kernels are compiled for AVX2 on their own and only run when the CPU has it
+#if LL_MSVC
+#define LL_TARGET_AVX2
+#else
+#define LL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+//static
+LLImageKernels::ELevel LLImageKernels::sLevel = LLImageKernels::LEVEL_SCALAR;
+//static
+LLImageKernels::ELevel LLImageKernels::sMaxLevel = LLImageKernels::LEVEL_SCALAR;
+
+//============================================================================
+// Scalar kernels. These are the reference the vector kernels must match.
+//============================================================================
+
+
+//..................................................................................
+//..................................................................................
+// Helper macrose's for generate cycle unwrap templates
+//..................................................................................
+#define _UNROL_GEN_TPL_arg_0(arg)
+#define _UNROL_GEN_TPL_arg_1(arg) arg
+
+#define _UNROL_GEN_TPL_comma_0
+#define _UNROL_GEN_TPL_comma_1 BOOST_PP_COMMA()
+//..................................................................................
+#define _UNROL_GEN_TPL_ARGS_macro(z,n,seq) \
+	BOOST_PP_CAT(_UNROL_GEN_TPL_arg_, BOOST_PP_MOD(n, 2))(BOOST_PP_SEQ_ELEM(n, seq)) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
+
+#define _UNROL_GEN_TPL_ARGS(seq) \
+	BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_ARGS_macro, seq)
+//..................................................................................
+
+#define _UNROL_GEN_TPL_TYPE_ARGS_macro(z,n,seq) \
+	BOOST_PP_SEQ_ELEM(n, seq) BOOST_PP_CAT(_UNROL_GEN_TPL_comma_, BOOST_PP_AND(BOOST_PP_MOD(n, 2), BOOST_PP_NOT_EQUAL(BOOST_PP_INC(n), BOOST_PP_SEQ_SIZE(seq))))
+
+#define _UNROL_GEN_TPL_TYPE_ARGS(seq) \
+	BOOST_PP_REPEAT(BOOST_PP_SEQ_SIZE(seq), _UNROL_GEN_TPL_TYPE_ARGS_macro, seq)
+//..................................................................................
+#define _UNROLL_GEN_TPL_foreach_ee(z, n, seq) \
+	executor<n>(_UNROL_GEN_TPL_ARGS(seq));
+
+#define _UNROLL_GEN_TPL(name, args_seq, operation, spec) \
+	template<> struct name<spec> { \
+	private: \
+		template<S32 _idx> inline void executor(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
+			BOOST_PP_SEQ_ENUM(operation) ; \
+		} \
+	public: \
+		inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { \
+			BOOST_PP_REPEAT(spec, _UNROLL_GEN_TPL_foreach_ee, args_seq) \
+		} \
+};
+//..................................................................................
+#define _UNROLL_GEN_TPL_foreach_seq_macro(r, data, elem) \
+	_UNROLL_GEN_TPL(BOOST_PP_SEQ_ELEM(0, data), BOOST_PP_SEQ_ELEM(1, data), BOOST_PP_SEQ_ELEM(2, data), elem)
+
+#define UNROLL_GEN_TPL(name, args_seq, operation, spec_seq) \
+	/*general specialization - should not be implemented!*/ \
+	template<U8> struct name { inline void operator()(_UNROL_GEN_TPL_TYPE_ARGS(args_seq)) { /*static_assert(!"Should not be instantiated.");*/  } }; \
+	BOOST_PP_SEQ_FOR_EACH(_UNROLL_GEN_TPL_foreach_seq_macro, (name)(args_seq)(operation), spec_seq)
+//..................................................................................
+//..................................................................................
+
+
+//..................................................................................
+// Generated unrolling loop templates with specializations
+//..................................................................................
+//example: for(c = 0; c < ch; ++c) comp[c] = cx[0] = 0;
+UNROLL_GEN_TPL(uroll_zeroze_cx_comp, (S32 *)(cx)(S32 *)(comp), (cx[_idx] = comp[_idx] = 0), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] >>= 4;
+UNROLL_GEN_TPL(uroll_comp_rshftasgn_constval, (S32 *)(comp)(const S32)(cval), (comp[_idx] >>= cval), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
+UNROLL_GEN_TPL(uroll_comp_asgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] = (cx[_idx] >> cval) * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
+UNROLL_GEN_TPL(uroll_comp_plusasgn_cx_rshft_cval_all_mul_val, (S32 *)(comp)(S32 *)(cx)(const S32)(cval)(S32)(val), (comp[_idx] += (cx[_idx] >> cval) * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
+UNROLL_GEN_TPL(uroll_inp_plusasgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] += pix[_idx] * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
+UNROLL_GEN_TPL(uroll_inp_asgn_pix_mul_val, (S32 *)(comp)(const U8 *)(pix)(S32)(val), (comp[_idx] = pix[_idx] * val), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
+UNROLL_GEN_TPL(uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r, (S32 *)(comp)(S32 *)(cx)(S32)(apoint), (comp[_idx] = ((cx[_idx] * apoint) + (comp[_idx] * (256 - apoint))) >> 16), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
+UNROLL_GEN_TPL(uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r, (S32 *)(comp)(const U8 *)(pix)(S32)(apoint), (comp[_idx] = (comp[_idx] + pix[_idx] * apoint) >> 8), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
+UNROLL_GEN_TPL(uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r, (S32 *)(comp)(S32)(apoint)(S32 *)(cx), (comp[_idx] = ((comp[_idx] * (256-apoint)) + (cx[_idx] * apoint)) >> 12), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = comp[c]&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_and_ff, (U8 *&)(dptr)(S32 *)(comp), (*dptr++ = comp[_idx]&0xff), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff, (U8 *&)(dptr)(const U8 *)(sptr)(S32)(apoint), (*dptr++ = sptr[apoint + _idx]&0xff), (1)(3)(4));
+//example: for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+UNROLL_GEN_TPL(uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff, (U8 *&)(dptr)(S32 *)(comp)(const S32)(cval), (*dptr++ = (comp[_idx]>>cval)&0xff), (1)(3)(4));
+//..................................................................................
+
+
+template<U8 ch>
+struct scale_info 
+{
+public:
+	std::vector<S32> xpoints;
+	std::vector<const U8*> ystrides;
+	std::vector<S32> xapoints, yapoints;
+	S32 xup_yup;
+
+public:
+	//unrolling loop types declaration
+	typedef uroll_zeroze_cx_comp<ch>														uroll_zeroze_cx_comp_t;
+	typedef uroll_comp_rshftasgn_constval<ch>												uroll_comp_rshftasgn_constval_t;
+	typedef uroll_comp_asgn_cx_rshft_cval_all_mul_val<ch>									uroll_comp_asgn_cx_rshft_cval_all_mul_val_t;
+	typedef uroll_comp_plusasgn_cx_rshft_cval_all_mul_val<ch>								uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t;
+	typedef uroll_inp_plusasgn_pix_mul_val<ch>												uroll_inp_plusasgn_pix_mul_val_t;
+	typedef uroll_inp_asgn_pix_mul_val<ch>													uroll_inp_asgn_pix_mul_val_t;
+	typedef uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r<ch>		uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t;
+	typedef uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r<ch>						uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t;
+	typedef uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r<ch>		uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t;
+	typedef uroll_uref_dptr_inc_asgn_comp_and_ff<ch>										uroll_uref_dptr_inc_asgn_comp_and_ff_t;
+	typedef uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff<ch>						uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t;
+	typedef uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff<ch>								uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t;
+
+public:
+	scale_info(const U8 *src, U32 srcW, U32 srcH, U32 dstW, U32 dstH, U32 srcStride)
+		: xup_yup((dstW >= srcW) + ((dstH >= srcH) << 1))
+	{
+		calc_x_points(srcW, dstW);
+		calc_y_strides(src, srcStride, srcH, dstH);
+		calc_aa_points(srcW, dstW, xup_yup&1, xapoints);
+		calc_aa_points(srcH, dstH, xup_yup&2, yapoints);
+	}
+
+private:
+	//...........................................................................................
+	void calc_x_points(U32 srcW, U32 dstW)
+	{
+		xpoints.resize(dstW+1);
+
+		S32 val = dstW >= srcW ? 0x8000 * srcW / dstW - 0x8000 : 0;
+		S32 inc = (srcW << 16) / dstW;
+
+		for(U32 i = 0, j = 0; i < dstW; ++i, ++j, val += inc)
+		{
+			xpoints[j] = llmax(0, val >> 16);
+		}
+	}
+	//...........................................................................................
+	void calc_y_strides(const U8 *src, U32 srcStride, U32 srcH, U32 dstH)
+	{
+		ystrides.resize(dstH+1);
+
+		S32 val = dstH >= srcH ? 0x8000 * srcH / dstH - 0x8000 : 0;
+		S32 inc = (srcH << 16) / dstH;
+
+		for(U32 i = 0, j = 0; i < dstH; ++i, ++j, val += inc)
+		{
+			ystrides[j] = src + llmax(0, val >> 16) * srcStride;
+		}
+	}
+	//...........................................................................................
+	void calc_aa_points(U32 srcSz, U32 dstSz, bool scale_up, std::vector<S32> &vp)
+	{
+		vp.resize(dstSz);
+
+		if(scale_up)
+		{
+			S32 val = 0x8000 * srcSz / dstSz - 0x8000;
+			S32 inc = (srcSz << 16) / dstSz;
+			U32 pos;
+
+			for(U32 i = 0, j = 0; i < dstSz; ++i, ++j, val += inc)
+			{
+				pos = val >> 16;
+
+				if (pos >= (srcSz - 1))
+					vp[j] = 0;
+				else
+					vp[j] = (val >> 8) - ((val >> 8) & 0xffffff00);
+			}
+		}
+		else
+		{ 
+			S32 inc = (srcSz << 16) / dstSz;
+			S32 Cp = ((dstSz << 14) / srcSz) + 1;
+			S32 ap;
+
+			for(U32 i = 0, j = 0, val = 0; i < dstSz; ++i, ++j, val += inc)
+			{
+				ap = ((0x100 - ((val >> 8) & 0xff)) * Cp) >> 8;
+				vp[j] = ap | (Cp << 16);
+			}
+		}
+	}
+};
+
+
+template<U8 ch>
+inline void bilinear_scale(
+	const U8 *src, U32 srcW, U32 srcH, U32 srcStride
+	, U8 *dst, U32 dstW, U32 dstH, U32 dstStride
+	)
+{
+	typedef scale_info<ch> scale_info_t;
+
+	scale_info_t info(src, srcW, srcH, dstW, dstH, srcStride);
+
+	const U8 *sptr;
+	U8 *dptr;
+	U32 x, y;
+	const U8 *pix;
+
+	S32 cx[ch], comp[ch];
+
+
+	if(3 == info.xup_yup)
+	{ //scale x/y - up
+		for(y = 0; y < dstH; ++y)
+		{
+			dptr = dst + (y * dstStride);
+			sptr = info.ystrides[y];
+
+			if(0 < info.yapoints[y])
+			{
+				for(x = 0; x < dstW; ++x)
+				{
+					//for(c = 0; c < ch; ++c) cx[c] = comp[c] = 0;
+					typename scale_info_t::uroll_zeroze_cx_comp_t()(cx, comp);
+
+					if(0 < info.xapoints[x])
+					{
+						pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+						//for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.xapoints[x]);
+						typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
+
+						pix += ch;
+
+						//for(c = 0; c < ch; ++c) comp[c] += pix[c] * info.xapoints[x];
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, info.xapoints[x]);
+
+						pix += srcStride;
+
+						//for(c = 0; c < ch; ++c) cx[c] = pix[c] * info.xapoints[x];
+						typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, info.xapoints[x]);
+
+						pix -= ch;
+
+						//for(c = 0; c < ch; ++c) { 
+						//	cx[c] += pix[c] * (256 - info.xapoints[x]);
+						//	comp[c] = ((cx[c] * info.yapoints[y]) + (comp[c] * (256 - info.yapoints[y]))) >> 16;
+						//	*dptr++ = comp[c]&0xff;
+						//}
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, 256 - info.xapoints[x]);
+						typename scale_info_t::uroll_comp_asgn_cx_mul_apoint_plus_comp_mul_inv_apoint_allshifted_16_r_t()(comp, cx, info.yapoints[y]);
+						typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+					}
+					else
+					{
+						pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+						//for(c = 0; c < ch; ++c) comp[c] = pix[c] * (256 - info.yapoints[y]);
+						typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256-info.yapoints[y]);
+
+						pix += srcStride;
+
+						//for(c = 0; c < ch; ++c) { 
+						//	comp[c] = (comp[c] + pix[c] * info.yapoints[y]) >> 8;
+						//	*dptr++ = comp[c]&0xff;
+						//}
+						typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.yapoints[y]);
+						typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+					}
+				}
+			}
+			else
+			{
+				for(x = 0; x < dstW; ++x)
+				{
+					if(0 < info.xapoints[x])
+					{
+						pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+						//for(c = 0; c < ch; ++c) {
+						//	comp[c] = pix[c] * (256 - info.xapoints[x]);
+						//	comp[c] = (comp[c] + pix[c] * info.xapoints[x]) >> 8;
+						//	*dptr++ = comp[c]&0xff;
+						//}
+						typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, 256 - info.xapoints[x]);
+						typename scale_info_t::uroll_comp_asgn_comp_plus_pix_mul_apoint_allshifted_8_r_t()(comp, pix, info.xapoints[x]);
+						typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_and_ff_t()(dptr, comp);
+					}
+					else 
+					{
+						//for(c = 0; c < ch; ++c) *dptr++ = (sptr[info.xpoints[x]*ch + c])&0xff;
+						typename scale_info_t::uroll_uref_dptr_inc_asgn_sptr_apoint_plus_idx_alland_ff_t()(dptr, sptr, info.xpoints[x]*ch);
+					}
+				}
+			}
+		}
+	}
+	else if(info.xup_yup == 1)
+	{ //scaling down vertically
+		S32 Cy, j;
+		S32 yap;
+
+		for(y = 0; y < dstH; y++)
+		{
+			Cy = info.yapoints[y] >> 16;
+			yap = info.yapoints[y] & 0xffff;
+
+			dptr = dst + (y * dstStride);
+
+			for(x = 0; x < dstW; x++)
+			{
+				pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+				//for(c = 0; c < ch; ++c) comp[c] = pix[c] * yap;
+				typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, yap);
+
+				pix += srcStride;
+
+				for(j = (1 << 14) - yap; j > Cy; j -= Cy, pix += srcStride)
+				{
+					//for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cy;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cy);
+				}
+
+				if(j > 0)
+				{
+					//for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
+				}
+
+				if(info.xapoints[x] > 0)
+				{
+					pix = info.ystrides[y] + info.xpoints[x]*ch + ch;
+					//for(c = 0; c < ch; ++c) cx[c] = pix[c] * yap;
+					typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, yap);
+
+					pix += srcStride;
+					for(j = (1 << 14) - yap; j > Cy; j -= Cy)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cy;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cy);
+						pix += srcStride;
+					}
+
+					if(j > 0)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
+					}
+
+					//for(c = 0; c < ch; ++c) comp[c] = ((comp[c]*(256 - info.xapoints[x])) + ((cx[c] * info.xapoints[x]))) >> 12;
+					typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.xapoints[x], cx);
+				}
+				else
+				{
+					//for(c = 0; c < ch; ++c) comp[c] >>= 4;
+					typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
+				}
+
+				//for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+				typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
+			}
+		}
+	}
+	else if(info.xup_yup == 2)
+	{ // scaling down horizontally
+		S32 Cx, j;
+		S32 xap;
+
+		for(y = 0; y < dstH; y++)
+		{
+			dptr = dst + (y * dstStride);
+
+			for(x = 0; x < dstW; x++)
+			{
+				Cx = info.xapoints[x] >> 16;
+				xap = info.xapoints[x] & 0xffff;
+
+				pix = info.ystrides[y] + info.xpoints[x] * ch;
+
+				//for(c = 0; c < ch; ++c) comp[c] = pix[c] * xap;
+				typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(comp, pix, xap);
+
+				pix+=ch;
+				for(j = (1 << 14) - xap; j > Cx; j -= Cx)
+				{
+					//for(c = 0; c < ch; ++c) comp[c] += pix[c] * Cx;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, Cx);
+					pix+=ch;
+				}
+
+				if(j > 0)
+				{
+					//for(c = 0; c < ch; ++c) comp[c] += pix[c] * j;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(comp, pix, j);
+				}
+
+				if(info.yapoints[y] > 0)
+				{
+					pix = info.ystrides[y] + info.xpoints[x]*ch + srcStride;
+					//for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+					typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+					pix+=ch;
+					for(j = (1 << 14) - xap; j > Cx; j -= Cx)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+						pix+=ch;
+					}
+
+					if(j > 0)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * j;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, j);
+					}
+
+					//for(c = 0; c < ch; ++c) comp[c] = ((comp[c] * (256 - info.yapoints[y])) + ((cx[c] * info.yapoints[y]))) >> 12;
+					typename scale_info_t::uroll_comp_asgn_comp_mul_inv_apoint_plus_cx_mul_apoint_allshifted_12_r_t()(comp, info.yapoints[y], cx);
+				}
+				else
+				{
+					//for(c = 0; c < ch; ++c) comp[c] >>= 4;
+					typename scale_info_t::uroll_comp_rshftasgn_constval_t()(comp, 4);
+				}
+
+				//for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>10)&0xff;
+				typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 10);
+			}
+		}
+	}
+	else 
+	{ //scale x/y - down
+		S32 Cx, Cy, i, j;
+		S32 xap, yap;
+
+		for(y = 0; y < dstH; y++)
+		{
+			Cy = info.yapoints[y] >> 16;
+			yap = info.yapoints[y] & 0xffff;
+
+			dptr = dst + (y * dstStride);
+			for(x = 0; x < dstW; x++)
+			{
+				Cx = info.xapoints[x] >> 16;
+				xap = info.xapoints[x] & 0xffff;
+
+				sptr = info.ystrides[y] + info.xpoints[x] * ch;
+				pix = sptr;
+				sptr += srcStride;
+
+				//for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+				typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+				pix+=ch;
+				for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+				{
+					//for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+					pix+=ch;
+				}
+
+				if(i > 0)
+				{
+					//for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+					typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+				}
+
+				//for(c = 0; c < ch; ++c) comp[c] = (cx[c] >> 5) * yap;
+				typename scale_info_t::uroll_comp_asgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, yap);
+
+				for(j = (1 << 14) - yap; j > Cy; j -= Cy)
+				{
+					pix = sptr;
+					sptr += srcStride;
+
+					//for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+					typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+					pix+=ch;
+					for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+						pix+=ch;
+					}
+
+					if(i > 0)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+					}
+
+					//for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * Cy;
+					typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, Cy);
+				}
+
+				if(j > 0)
+				{
+					pix = sptr;
+					sptr += srcStride;
+
+					//for(c = 0; c < ch; ++c) cx[c] = pix[c] * xap;
+					typename scale_info_t::uroll_inp_asgn_pix_mul_val_t()(cx, pix, xap);
+
+					pix+=ch;
+					for(i = (1 << 14) - xap; i > Cx; i -= Cx)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * Cx;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, Cx);
+						pix+=ch;
+					}
+
+					if(i > 0)
+					{
+						//for(c = 0; c < ch; ++c) cx[c] += pix[c] * i;
+						typename scale_info_t::uroll_inp_plusasgn_pix_mul_val_t()(cx, pix, i);
+					}
+
+					//for(c = 0; c < ch; ++c) comp[c] += (cx[c] >> 5) * j;
+					typename scale_info_t::uroll_comp_plusasgn_cx_rshft_cval_all_mul_val_t()(comp, cx, 5, j);
+				}
+
+				//for(c = 0; c < ch; ++c) *dptr++ = (comp[c]>>23)&0xff;
+				typename scale_info_t::uroll_uref_dptr_inc_asgn_comp_rshft_cval_and_ff_t()(dptr, comp, 23);
+			}
+		}
+	} //else
+}
+
+//wrapper
+static void bilinear_scale_scalar(const U8 *src, U32 srcW, U32 srcH, U32 ch, U32 srcStride, U8 *dst, U32 dstW, U32 dstH, U32 dstStride)
+{
+	switch(ch)
+	{
+	case 1:
+		bilinear_scale<1>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		break;
+	case 3:
+		bilinear_scale<3>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		break;
+	case 4:
+		bilinear_scale<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+		break;
+	default:
+		llassert(!"Implement if need");
+		break;
+	}
+}
+
+static void avg4_colors4(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+	dst[3] = (U8)(((U32)(a[3]) + b[3] + c[3] + d[3])>>2);
+}
+
+static void avg4_colors3(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+	dst[2] = (U8)(((U32)(a[2]) + b[2] + c[2] + d[2])>>2);
+}
+
+static void avg4_colors2(const U8* a, const U8* b, const U8* c, const U8* d, U8* dst)
+{
+	dst[0] = (U8)(((U32)(a[0]) + b[0] + c[0] + d[0])>>2);
+	dst[1] = (U8)(((U32)(a[1]) + b[1] + c[1] + d[1])>>2);
+}
+
+static void generate_mip_scalar(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
+{
+	U8* data = mipdata;
+	S32 in_width = width*2;
+	for (S32 h=0; h<height; h++)
+	{
+		for (S32 w=0; w<width; w++)
+		{
+			switch(nchannels)
+			{
+			  case 4:
+				avg4_colors4(indata, indata+4, indata+4*in_width, indata+4*in_width+4, data);
+				break;
+			  case 3:
+				avg4_colors3(indata, indata+3, indata+3*in_width, indata+3*in_width+3, data);
+				break;
+			  case 2:
+				avg4_colors2(indata, indata+2, indata+2*in_width, indata+2*in_width+2, data);
+				break;
+			  case 1:
+				*(U8*)data = (U8)(((U32)(indata[0]) + indata[1] + indata[in_width] + indata[in_width+1])>>2);
+				break;
+			  default:
+				LL_WARNS() << "generateMmip called with bad num channels: " << nchannels << LL_ENDL;
+				return;
+			}
+			indata += nchannels*2;
+			data += nchannels;
+		}
+		indata += nchannels*in_width; // skip odd lines
+	}
+}
+
+static void copy_line_scaled_scalar(const U8* in, U8* out, S32 components, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step)
+{
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	S32 goff = components >= 2 ? 1 : 0;
+	S32 boff = components >= 3 ? 2 : 0;
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		// Sample input pixels in range from sample0 to sample1.
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);			// left integer (floor)
+		const S32 index1 = llfloor(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			S32 t0 = x * out_pixel_step * components;
+			S32 t1 = index0 * in_pixel_step * components;
+			U8* outp = out + t0;
+			const U8* inp = in + t1;
+			for (S32 i = 0; i < components; ++i)
+			{
+				*outp = *inp;
+				++outp;
+				++inp;
+			}
+		}
+		else
+		{
+			// Left straddle
+			S32 t1 = index0 * in_pixel_step * components;
+			F32 r = in[t1 + 0] * fract0;
+			F32 g = in[t1 + goff] * fract0;
+			F32 b = in[t1 + boff] * fract0;
+			F32 a = 0;
+			if( components == 4)
+			{
+				a = in[t1 + 3] * fract0;
+			}
+		
+			// Central interval
+			if (components < 4)
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + goff];
+					b += in[t2 + boff];
+				}
+			}
+			else
+			{
+				for( S32 u = index0 + 1; u < index1; u++ )
+				{
+					S32 t2 = u * in_pixel_step * components;
+					r += in[t2 + 0];
+					g += in[t2 + 1];
+					b += in[t2 + 2];
+					a += in[t2 + 3];
+				}
+			}
+
+			// right straddle
+			// Watch out for reading off of end of input array.
+			if( fract1 && index1 < in_pixel_len )
+			{
+				S32 t3 = index1 * in_pixel_step * components;
+				if (components < 4)
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + goff];
+					U8 in2 = in[t3 + boff];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+				}
+				else
+				{
+					U8 in0 = in[t3 + 0];
+					U8 in1 = in[t3 + 1];
+					U8 in2 = in[t3 + 2];
+					U8 in3 = in[t3 + 3];
+					r += in0 * fract1;
+					g += in1 * fract1;
+					b += in2 * fract1;
+					a += in3 * fract1;
+				}
+			}
+
+			r *= norm_factor;
+			g *= norm_factor;
+			b *= norm_factor;
+			a *= norm_factor;  // skip conditional
+
+			S32 t4 = x * out_pixel_step * components;
+			out[t4 + 0] = U8(ll_round(r));
+			if (components >= 2)
+				out[t4 + 1] = U8(ll_round(g));
+			if (components >= 3)
+				out[t4 + 2] = U8(ll_round(b));
+			if( components == 4)
+				out[t4 + 3] = U8(ll_round(a));
+		}
+	}
+}
+
+// Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
+inline U8 fast_fractional_mult( U8 a, U8 b )
+{
+	U32 i = a * b + 128;
+	return U8((i + (i>>8)) >> 8);
+}
+
+inline void composite_px_4onto3(U8 r, U8 g, U8 b, U8 alpha, U8* out)
+{
+	if( alpha )
+	{
+		if( 255 == alpha )
+		{
+			out[0] = r;
+			out[1] = g;
+			out[2] = b;
+		}
+		else
+		{
+			U8 transparency = 255 - alpha;
+			out[0] = fast_fractional_mult( out[0], transparency ) + fast_fractional_mult( r, alpha );
+			out[1] = fast_fractional_mult( out[1], transparency ) + fast_fractional_mult( g, alpha );
+			out[2] = fast_fractional_mult( out[2], transparency ) + fast_fractional_mult( b, alpha );
+		}
+	}
+}
+
+static void composite_row_scaled_4onto3_scalar(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+	const S32 IN_COMPONENTS = 4;
+	const S32 OUT_COMPONENTS = 3;
+
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	for( S32 x = 0; x < out_pixel_len; x++ )
+	{
+		// Sample input pixels in range from sample0 to sample1.
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = S32(sample0);			// left integer (floor)
+		const S32 index1 = S32(sample1);			// right integer (floor)
+		const F32 fract0 = 1.f - (sample0 - F32(index0));	// spill over on left
+		const F32 fract1 = sample1 - F32(index1);			// spill-over on right
+
+		U8 in_scaled_r;
+		U8 in_scaled_g;
+		U8 in_scaled_b;
+		U8 in_scaled_a;
+
+		if( index0 == index1 )
+		{
+			// Interval is embedded in one input pixel
+			S32 t1 = index0 * IN_COMPONENTS;
+			in_scaled_r = in[t1 + 0];
+			in_scaled_g = in[t1 + 0];
+			in_scaled_b = in[t1 + 0];
+			in_scaled_a = in[t1 + 0];
+		}
+		else
+		{
+			// Left straddle
+			S32 t1 = index0 * IN_COMPONENTS;
+			F32 r = in[t1 + 0] * fract0;
+			F32 g = in[t1 + 1] * fract0;
+			F32 b = in[t1 + 2] * fract0;
+			F32 a = in[t1 + 3] * fract0;
+		
+			// Central interval
+			for( S32 u = index0 + 1; u < index1; u++ )
+			{
+				S32 t2 = u * IN_COMPONENTS;
+				r += in[t2 + 0];
+				g += in[t2 + 1];
+				b += in[t2 + 2];
+				a += in[t2 + 3];
+			}
+
+			// right straddle
+			// Watch out for reading off of end of input array.
+			if( fract1 && index1 < in_pixel_len )
+			{
+				S32 t3 = index1 * IN_COMPONENTS;
+				r += in[t3 + 0] * fract1;
+				g += in[t3 + 1] * fract1;
+				b += in[t3 + 2] * fract1;
+				a += in[t3 + 3] * fract1;
+			}
+
+			r *= norm_factor;
+			g *= norm_factor;
+			b *= norm_factor;
+			a *= norm_factor;
+
+			in_scaled_r = U8(ll_round(r));
+			in_scaled_g = U8(ll_round(g));
+			in_scaled_b = U8(ll_round(b));
+			in_scaled_a = U8(ll_round(a));
+		}
+
+		composite_px_4onto3(in_scaled_r, in_scaled_g, in_scaled_b, in_scaled_a, out);
+		out += OUT_COMPONENTS;
+	}
+}
+
+static void composite_unscaled_4onto3_scalar(const U8* src_data, U8* dst_data, S32 pixels)
+{
+	while( pixels-- )
+	{
+		composite_px_4onto3(src_data[0], src_data[1], src_data[2], src_data[3], dst_data);
+
+		src_data += 4;
+		dst_data += 3;
+	}
+}
+
+#if LL_IMAGE_KERNELS_X86
+//============================================================================
+// SSE2 kernels
+//============================================================================
+
+// Box filter of two rows of 16 bytes into 8 bytes of mip, for 1, 2 or 4 channels
+template<S32 N>
+inline __m128i mip_block_sse2(__m128i row0, __m128i row1)
+{
+	const __m128i zero = _mm_setzero_si128();
+	// Vertical sums as 16 bit lanes, then add horizontal neighbours
+	__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+	__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+	__m128i sum;
+	if (N == 4)
+	{
+		lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+		hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+		sum = _mm_unpacklo_epi64(lo, hi);
+	}
+	else if (N == 2)
+	{
+		lo = _mm_add_epi16(_mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 3, 1)));
+		hi = _mm_add_epi16(_mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 3, 1)));
+		sum = _mm_unpacklo_epi64(lo, hi);
+	}
+	else
+	{
+		const __m128i ones = _mm_set1_epi16(1);
+		sum = _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones));
+	}
+	sum = _mm_srli_epi16(sum, 2);
+	return _mm_packus_epi16(sum, sum);
+}
+
+template<S32 N>
+static void generate_mip_sse2(const U8* indata, U8* mipdata, S32 width, S32 height)
+{
+	const S32 in_row = width * 2 * N;
+	const S32 out_row = width * N;
+	for (S32 h = 0; h < height; ++h)
+	{
+		const U8* row0 = indata + h * 2 * in_row;
+		const U8* row1 = row0 + in_row;
+		U8* out = mipdata + h * out_row;
+
+		// x counts mip bytes, the matching source bytes start at 2 * x
+		S32 x = 0;
+		for (; x + 8 <= out_row; x += 8)
+		{
+			__m128i mip = mip_block_sse2<N>(_mm_loadu_si128((const __m128i*)(row0 + 2 * x)),
+											_mm_loadu_si128((const __m128i*)(row1 + 2 * x)));
+			_mm_storel_epi64((__m128i*)(out + x), mip);
+		}
+		for (; x < out_row; x += N)
+		{
+			for (S32 c = 0; c < N; ++c)
+			{
+				out[x + c] = (U8)(((U32)row0[2 * x + c] + row0[2 * x + N + c] + row1[2 * x + c] + row1[2 * x + N + c]) >> 2);
+			}
+		}
+	}
+}
+
+// Three channel pixels don't line up with the registers: 4 source pixels
+// (12 of the 16 bytes loaded) make 2 mip pixels per pass.
+static void generate_mip3_sse2(const U8* indata, U8* mipdata, S32 width, S32 height)
+{
+	const S32 in_row = width * 2 * 3;
+	const S32 out_row = width * 3;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb_mask = _mm_setr_epi16(-1, -1, -1, 0, 0, 0, 0, 0);
+	for (S32 h = 0; h < height; ++h)
+	{
+		const U8* row0 = indata + h * 2 * in_row;
+		const U8* row1 = row0 + in_row;
+		U8* out = mipdata + h * out_row;
+
+		S32 x = 0;
+		for (; x + 8 <= out_row; x += 6)
+		{
+			__m128i r0 = _mm_loadu_si128((const __m128i*)(row0 + 2 * x));
+			__m128i r1 = _mm_loadu_si128((const __m128i*)(row1 + 2 * x));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+			// Pixels 0 + 1 from lo, pixels 2 + 3 straddle lo and hi
+			__m128i sum01 = _mm_add_epi16(lo, _mm_srli_si128(lo, 6));
+			__m128i px23 = _mm_or_si128(_mm_srli_si128(lo, 12), _mm_slli_si128(hi, 4));
+			__m128i sum23 = _mm_add_epi16(px23, _mm_srli_si128(px23, 6));
+			__m128i sum = _mm_or_si128(_mm_and_si128(sum01, rgb_mask), _mm_slli_si128(_mm_and_si128(sum23, rgb_mask), 6));
+			sum = _mm_srli_epi16(sum, 2);
+			sum = _mm_packus_epi16(sum, sum);
+
+			S32 first = _mm_cvtsi128_si32(sum);
+			U16 last = (U16)_mm_extract_epi16(sum, 2);
+			memcpy(out + x, &first, 4);
+			memcpy(out + x + 4, &last, 2);
+		}
+		for (; x < out_row; x += 3)
+		{
+			for (S32 c = 0; c < 3; ++c)
+			{
+				out[x + c] = (U8)(((U32)row0[2 * x + c] + row0[2 * x + 3 + c] + row1[2 * x + c] + row1[2 * x + 3 + c]) >> 2);
+			}
+		}
+	}
+}
+
+// One pixel of 3 or 4 channels as 32 bit lanes
+template<U8 ch>
+inline __m128i load_px_sse2(const U8* pix)
+{
+	if (ch == 4)
+	{
+		S32 bytes;
+		memcpy(&bytes, pix, 4);
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+	}
+	return _mm_setr_epi32(pix[0], pix[1], pix[2], 0);
+}
+
+// Low byte of each lane, like the (U8) casts of the scalar code
+template<U8 ch>
+inline void store_px_sse2(U8* pix, __m128i value)
+{
+	value = _mm_and_si128(value, _mm_set1_epi32(0xff));
+	value = _mm_packs_epi32(value, value);
+	value = _mm_packus_epi16(value, value);
+	S32 bytes = _mm_cvtsi128_si32(value);
+	memcpy(pix, &bytes, ch);
+}
+
+// Pixel lanes (0 - 255) times a weight (0 - 32767)
+inline __m128i mul_px_sse2(__m128i pix, S32 weight)
+{
+	return _mm_madd_epi16(pix, _mm_set1_epi32(weight));
+}
+
+// Low 32 bits of lanes times a weight, as S32 math does
+inline __m128i mul32_sse2(__m128i value, S32 weight)
+{
+	const __m128i w = _mm_set1_epi32(weight);
+	__m128i even = _mm_mul_epu32(value, w);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(value, 32), w);
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Weighted sum of the pixels a down-scaled sample covers, stepping by step bytes
+template<U8 ch>
+inline __m128i sum_span_sse2(const U8* pix, S32 step, S32 ap, S32 Cp)
+{
+	__m128i sum = mul_px_sse2(load_px_sse2<ch>(pix), ap);
+	pix += step;
+	S32 j;
+	for (j = (1 << 14) - ap; j > Cp; j -= Cp)
+	{
+		sum = _mm_add_epi32(sum, mul_px_sse2(load_px_sse2<ch>(pix), Cp));
+		pix += step;
+	}
+	if (j > 0)
+	{
+		sum = _mm_add_epi32(sum, mul_px_sse2(load_px_sse2<ch>(pix), j));
+	}
+	return sum;
+}
+
+// bilinear_scale<ch> with the channels of a pixel in one register
+template<U8 ch>
+static void bilinear_scale_sse2(const U8 *src, U32 srcW, U32 srcH, U32 srcStride, U8 *dst, U32 dstW, U32 dstH, U32 dstStride)
+{
+	scale_info<ch> info(src, srcW, srcH, dstW, dstH, srcStride);
+
+	const U8 *sptr;
+	U8 *dptr;
+	U32 x, y;
+	const U8 *pix;
+	__m128i cx, comp;
+
+	if(3 == info.xup_yup)
+	{ //scale x/y - up
+		for(y = 0; y < dstH; ++y)
+		{
+			dptr = dst + (y * dstStride);
+			sptr = info.ystrides[y];
+			const S32 yap = info.yapoints[y];
+
+			if(0 < yap)
+			{
+				for(x = 0; x < dstW; ++x, dptr += ch)
+				{
+					const S32 xap = info.xapoints[x];
+					pix = sptr + info.xpoints[x] * ch;
+					if(0 < xap)
+					{
+						comp = mul_px_sse2(load_px_sse2<ch>(pix), 256 - xap);
+						comp = _mm_add_epi32(comp, mul_px_sse2(load_px_sse2<ch>(pix + ch), xap));
+						cx = mul_px_sse2(load_px_sse2<ch>(pix + srcStride + ch), xap);
+						cx = _mm_add_epi32(cx, mul_px_sse2(load_px_sse2<ch>(pix + srcStride), 256 - xap));
+						comp = _mm_srai_epi32(_mm_add_epi32(mul32_sse2(cx, yap), mul32_sse2(comp, 256 - yap)), 16);
+					}
+					else
+					{
+						comp = mul_px_sse2(load_px_sse2<ch>(pix), 256 - yap);
+						comp = _mm_srai_epi32(_mm_add_epi32(comp, mul_px_sse2(load_px_sse2<ch>(pix + srcStride), yap)), 8);
+					}
+					store_px_sse2<ch>(dptr, comp);
+				}
+			}
+			else
+			{
+				for(x = 0; x < dstW; ++x, dptr += ch)
+				{
+					const S32 xap = info.xapoints[x];
+					pix = sptr + info.xpoints[x] * ch;
+					if(0 < xap)
+					{
+						// Matches the scalar code, which weighs the same pixel twice here
+						comp = mul_px_sse2(load_px_sse2<ch>(pix), 256 - xap);
+						comp = _mm_srai_epi32(_mm_add_epi32(comp, mul_px_sse2(load_px_sse2<ch>(pix), xap)), 8);
+						store_px_sse2<ch>(dptr, comp);
+					}
+					else
+					{
+						memcpy(dptr, pix, ch);
+					}
+				}
+			}
+		}
+	}
+	else if(info.xup_yup == 1)
+	{ //scaling down vertically
+		for(y = 0; y < dstH; y++)
+		{
+			const S32 Cy = info.yapoints[y] >> 16;
+			const S32 yap = info.yapoints[y] & 0xffff;
+
+			dptr = dst + (y * dstStride);
+
+			for(x = 0; x < dstW; x++, dptr += ch)
+			{
+				pix = info.ystrides[y] + info.xpoints[x] * ch;
+				comp = sum_span_sse2<ch>(pix, srcStride, yap, Cy);
+
+				const S32 xap = info.xapoints[x];
+				if(xap > 0)
+				{
+					cx = sum_span_sse2<ch>(pix + ch, srcStride, yap, Cy);
+					comp = _mm_srai_epi32(_mm_add_epi32(mul32_sse2(comp, 256 - xap), mul32_sse2(cx, xap)), 12);
+				}
+				else
+				{
+					comp = _mm_srai_epi32(comp, 4);
+				}
+
+				store_px_sse2<ch>(dptr, _mm_srai_epi32(comp, 10));
+			}
+		}
+	}
+	else if(info.xup_yup == 2)
+	{ // scaling down horizontally
+		for(y = 0; y < dstH; y++)
+		{
+			dptr = dst + (y * dstStride);
+			const S32 yap = info.yapoints[y];
+
+			for(x = 0; x < dstW; x++, dptr += ch)
+			{
+				const S32 Cx = info.xapoints[x] >> 16;
+				const S32 xap = info.xapoints[x] & 0xffff;
+
+				pix = info.ystrides[y] + info.xpoints[x] * ch;
+				comp = sum_span_sse2<ch>(pix, ch, xap, Cx);
+
+				if(yap > 0)
+				{
+					cx = sum_span_sse2<ch>(pix + srcStride, ch, xap, Cx);
+					comp = _mm_srai_epi32(_mm_add_epi32(mul32_sse2(comp, 256 - yap), mul32_sse2(cx, yap)), 12);
+				}
+				else
+				{
+					comp = _mm_srai_epi32(comp, 4);
+				}
+
+				store_px_sse2<ch>(dptr, _mm_srai_epi32(comp, 10));
+			}
+		}
+	}
+	else
+	{ //scale x/y - down
+		for(y = 0; y < dstH; y++)
+		{
+			const S32 Cy = info.yapoints[y] >> 16;
+			const S32 yap = info.yapoints[y] & 0xffff;
+
+			dptr = dst + (y * dstStride);
+			for(x = 0; x < dstW; x++, dptr += ch)
+			{
+				const S32 Cx = info.xapoints[x] >> 16;
+				const S32 xap = info.xapoints[x] & 0xffff;
+
+				sptr = info.ystrides[y] + info.xpoints[x] * ch;
+				cx = sum_span_sse2<ch>(sptr, ch, xap, Cx);
+				comp = mul32_sse2(_mm_srai_epi32(cx, 5), yap);
+				sptr += srcStride;
+
+				S32 j;
+				for(j = (1 << 14) - yap; j > Cy; j -= Cy)
+				{
+					cx = sum_span_sse2<ch>(sptr, ch, xap, Cx);
+					comp = _mm_add_epi32(comp, mul32_sse2(_mm_srai_epi32(cx, 5), Cy));
+					sptr += srcStride;
+				}
+
+				if(j > 0)
+				{
+					cx = sum_span_sse2<ch>(sptr, ch, xap, Cx);
+					comp = _mm_add_epi32(comp, mul32_sse2(_mm_srai_epi32(cx, 5), j));
+				}
+
+				store_px_sse2<ch>(dptr, _mm_srai_epi32(comp, 23));
+			}
+		}
+	}
+}
+
+template<U8 ch>
+inline __m128 load_px_ps_sse2(const U8* pix)
+{
+	return _mm_cvtepi32_ps(load_px_sse2<ch>(pix));
+}
+
+// Box average of in[index0 .. index1] with partial end pixels, rounded like ll_round()
+template<U8 ch>
+inline __m128i average_span_sse2(const U8* in, S32 in_step, S32 in_pixel_len, S32 index0, S32 index1, F32 fract0, F32 fract1, F32 norm_factor)
+{
+	// Same operations in the same order as the scalar code, so the sums round the same way
+	__m128 sum = _mm_mul_ps(load_px_ps_sse2<ch>(in + index0 * in_step), _mm_set1_ps(fract0));
+	for (S32 u = index0 + 1; u < index1; u++)
+	{
+		sum = _mm_add_ps(sum, load_px_ps_sse2<ch>(in + u * in_step));
+	}
+	if (fract1 && index1 < in_pixel_len)
+	{
+		sum = _mm_add_ps(sum, _mm_mul_ps(load_px_ps_sse2<ch>(in + index1 * in_step), _mm_set1_ps(fract1)));
+	}
+	sum = _mm_mul_ps(sum, _mm_set1_ps(norm_factor));
+	// Sums are never negative, so truncating x + 0.5 is llfloor(x + 0.5)
+	return _mm_cvttps_epi32(_mm_add_ps(sum, _mm_set1_ps(0.5f)));
+}
+
+template<U8 ch>
+static void copy_line_scaled_sse2(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step)
+{
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+	const S32 in_step = in_pixel_step * ch;
+	const S32 out_step = out_pixel_step * ch;
+
+	for (S32 x = 0; x < out_pixel_len; x++)
+	{
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = llfloor(sample0);
+		const S32 index1 = llfloor(sample1);
+		const F32 fract0 = 1.f - (sample0 - F32(index0));
+		const F32 fract1 = sample1 - F32(index1);
+
+		if (index0 == index1)
+		{
+			memcpy(out + x * out_step, in + index0 * in_step, ch);
+		}
+		else
+		{
+			store_px_sse2<ch>(out + x * out_step, average_span_sse2<ch>(in, in_step, in_pixel_len, index0, index1, fract0, fract1, norm_factor));
+		}
+	}
+}
+
+static void composite_row_scaled_4onto3_sse2(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+	const F32 ratio = F32(in_pixel_len) / out_pixel_len; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	for (S32 x = 0; x < out_pixel_len; x++, out += 3)
+	{
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		const S32 index0 = S32(sample0);
+		const S32 index1 = S32(sample1);
+		const F32 fract0 = 1.f - (sample0 - F32(index0));
+		const F32 fract1 = sample1 - F32(index1);
+
+		if (index0 == index1)
+		{
+			// The scalar code takes the first channel for all four here
+			const U8 value = in[index0 * 4];
+			composite_px_4onto3(value, value, value, value, out);
+		}
+		else
+		{
+			U8 scaled[4];
+			store_px_sse2<4>(scaled, average_span_sse2<4>(in, 4, in_pixel_len, index0, index1, fract0, fract1, norm_factor));
+			composite_px_4onto3(scaled[0], scaled[1], scaled[2], scaled[3], out);
+		}
+	}
+}
+
+// fast_fractional_mult() on 16 bit lanes
+inline __m128i fractional_mult_sse2(__m128i a, __m128i b)
+{
+	__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+}
+
+// Two RGBA source and two RGBx destination pixels as 16 bit lanes. The blend
+// is exact for alpha 0 and 255, so it needs no branches.
+inline __m128i composite_px_sse2(__m128i src, __m128i dst)
+{
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m128i transparency = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+	__m128i blend = _mm_add_epi16(fractional_mult_sse2(dst, transparency), fractional_mult_sse2(src, alpha));
+	return _mm_and_si128(blend, _mm_set1_epi16(0xff));
+}
+
+static void composite_unscaled_4onto3_sse2(const U8* src, U8* dst, S32 pixels)
+{
+	const __m128i zero = _mm_setzero_si128();
+	U8 rgbx[16];
+	for (; pixels >= 4; pixels -= 4, src += 16, dst += 12)
+	{
+		for (S32 i = 0; i < 4; ++i)
+		{
+			rgbx[i * 4 + 0] = dst[i * 3 + 0];
+			rgbx[i * 4 + 1] = dst[i * 3 + 1];
+			rgbx[i * 4 + 2] = dst[i * 3 + 2];
+			rgbx[i * 4 + 3] = 0;
+		}
+		__m128i s = _mm_loadu_si128((const __m128i*)src);
+		__m128i d = _mm_loadu_si128((const __m128i*)rgbx);
+		__m128i lo = composite_px_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+		__m128i hi = composite_px_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+		_mm_storeu_si128((__m128i*)rgbx, _mm_packus_epi16(lo, hi));
+		for (S32 i = 0; i < 4; ++i)
+		{
+			dst[i * 3 + 0] = rgbx[i * 4 + 0];
+			dst[i * 3 + 1] = rgbx[i * 4 + 1];
+			dst[i * 3 + 2] = rgbx[i * 4 + 2];
+		}
+	}
+	composite_unscaled_4onto3_scalar(src, dst, pixels);
+}
+
+//============================================================================
+// AVX2 kernels. Only the ones that gain from the wider registers; the
+// per-pixel scale kernels run the SSE2 code at this level too.
+//============================================================================
+
+template<S32 N>
+LL_TARGET_AVX2 static void generate_mip_avx2(const U8* indata, U8* mipdata, S32 width, S32 height)
+{
+	const S32 in_row = width * 2 * N;
+	const S32 out_row = width * N;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i ones = _mm256_set1_epi16(1);
+	for (S32 h = 0; h < height; ++h)
+	{
+		const U8* row0 = indata + h * 2 * in_row;
+		const U8* row1 = row0 + in_row;
+		U8* out = mipdata + h * out_row;
+
+		S32 x = 0;
+		for (; x + 16 <= out_row; x += 16)
+		{
+			__m256i r0 = _mm256_loadu_si256((const __m256i*)(row0 + 2 * x));
+			__m256i r1 = _mm256_loadu_si256((const __m256i*)(row1 + 2 * x));
+			// Everything stays within the 128 bit lanes: lane 0 holds source bytes 0 - 15, lane 1 bytes 16 - 31
+			__m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(r0, zero), _mm256_unpacklo_epi8(r1, zero));
+			__m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(r0, zero), _mm256_unpackhi_epi8(r1, zero));
+			__m256i sum;
+			if (N == 4)
+			{
+				lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+				hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+				sum = _mm256_unpacklo_epi64(lo, hi);
+			}
+			else if (N == 2)
+			{
+				lo = _mm256_add_epi16(_mm256_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_epi32(lo, _MM_SHUFFLE(3, 1, 3, 1)));
+				hi = _mm256_add_epi16(_mm256_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_epi32(hi, _MM_SHUFFLE(3, 1, 3, 1)));
+				sum = _mm256_unpacklo_epi64(lo, hi);
+			}
+			else
+			{
+				sum = _mm256_packs_epi32(_mm256_madd_epi16(lo, ones), _mm256_madd_epi16(hi, ones));
+			}
+			sum = _mm256_srli_epi16(sum, 2);
+			sum = _mm256_packus_epi16(sum, sum);
+			// The 8 result bytes of each lane are in its low half
+			sum = _mm256_permute4x64_epi64(sum, _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storeu_si128((__m128i*)(out + x), _mm256_castsi256_si128(sum));
+		}
+		for (; x < out_row; x += N)
+		{
+			for (S32 c = 0; c < N; ++c)
+			{
+				out[x + c] = (U8)(((U32)row0[2 * x + c] + row0[2 * x + N + c] + row1[2 * x + c] + row1[2 * x + N + c]) >> 2);
+			}
+		}
+	}
+}
+
+LL_TARGET_AVX2 static void composite_unscaled_4onto3_avx2(const U8* src, U8* dst, S32 pixels)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c255 = _mm256_set1_epi16(255);
+	const __m256i c128 = _mm256_set1_epi16(128);
+	const __m256i low_byte = _mm256_set1_epi16(0xff);
+	const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m256i compress = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+											  0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	// 8 pixels per pass. The second destination load reads 4 bytes past the
+	// 24 in use, so stop while 2 pixels remain.
+	for (; pixels >= 10; pixels -= 8, src += 32, dst += 24)
+	{
+		__m256i s = _mm256_loadu_si256((const __m256i*)src);
+		__m128i d0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)dst), expand);
+		__m128i d1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(dst + 12)), expand);
+		__m256i d = _mm256_inserti128_si256(_mm256_castsi128_si256(d0), d1, 1);
+
+		__m256i result[2];
+		for (S32 half = 0; half < 2; ++half)
+		{
+			__m256i sp = half ? _mm256_unpackhi_epi8(s, zero) : _mm256_unpacklo_epi8(s, zero);
+			__m256i dp = half ? _mm256_unpackhi_epi8(d, zero) : _mm256_unpacklo_epi8(d, zero);
+			__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sp, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m256i transparency = _mm256_sub_epi16(c255, alpha);
+			__m256i i0 = _mm256_add_epi16(_mm256_mullo_epi16(dp, transparency), c128);
+			__m256i i1 = _mm256_add_epi16(_mm256_mullo_epi16(sp, alpha), c128);
+			i0 = _mm256_srli_epi16(_mm256_add_epi16(i0, _mm256_srli_epi16(i0, 8)), 8);
+			i1 = _mm256_srli_epi16(_mm256_add_epi16(i1, _mm256_srli_epi16(i1, 8)), 8);
+			result[half] = _mm256_and_si256(_mm256_add_epi16(i0, i1), low_byte);
+		}
+		__m256i packed = _mm256_shuffle_epi8(_mm256_packus_epi16(result[0], result[1]), compress);
+
+		// 12 bytes from each lane
+		__m128i lane0 = _mm256_castsi256_si128(packed);
+		__m128i lane1 = _mm256_extracti128_si256(packed, 1);
+		S32 tail0 = _mm_cvtsi128_si32(_mm_srli_si128(lane0, 8));
+		S32 tail1 = _mm_cvtsi128_si32(_mm_srli_si128(lane1, 8));
+		_mm_storel_epi64((__m128i*)dst, lane0);
+		memcpy(dst + 8, &tail0, 4);
+		_mm_storel_epi64((__m128i*)(dst + 12), lane1);
+		memcpy(dst + 20, &tail1, 4);
+	}
+	composite_unscaled_4onto3_sse2(src, dst, pixels);
+}
+#endif // LL_IMAGE_KERNELS_X86
+
+//============================================================================
+// LLImageKernels
+//============================================================================
+
+//static
+void LLImageKernels::initClass()
+{
+#if LL_IMAGE_KERNELS_X86
+	// SSE2 is part of the baseline these kernels are built for
+	LLProcessorInfo proc_info;
+	sMaxLevel = proc_info.hasAVX2() ? LEVEL_AVX2 : LEVEL_SSE2;
+#else
+	sMaxLevel = LEVEL_SCALAR;
+#endif
+	sLevel = sMaxLevel;
+	LL_INFOS("ImageKernels") << "Using " << getLevelName(sLevel) << " image kernels" << LL_ENDL;
+}
+
+//static
+LLImageKernels::ELevel LLImageKernels::setLevel(ELevel level)
+{
+	sLevel = (ELevel)llclamp((S32)level, (S32)LEVEL_SCALAR, (S32)sMaxLevel);
+	return sLevel;
+}
+
+//static
+const char* LLImageKernels::getLevelName(ELevel level)
+{
+	switch (level)
+	{
+	case LEVEL_AVX2:
+		return "AVX2";
+	case LEVEL_SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
+
+//static
+void LLImageKernels::generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels)
+{
+	llassert(width > 0 && height > 0);
+#if LL_IMAGE_KERNELS_X86
+	if (sLevel >= LEVEL_AVX2)
+	{
+		switch (nchannels)
+		{
+		case 4:
+			generate_mip_avx2<4>(indata, mipdata, width, height);
+			return;
+		case 2:
+			generate_mip_avx2<2>(indata, mipdata, width, height);
+			return;
+		case 1:
+			generate_mip_avx2<1>(indata, mipdata, width, height);
+			return;
+		default:
+			break;
+		}
+	}
+	if (sLevel >= LEVEL_SSE2)
+	{
+		switch (nchannels)
+		{
+		case 4:
+			generate_mip_sse2<4>(indata, mipdata, width, height);
+			return;
+		case 3:
+			generate_mip3_sse2(indata, mipdata, width, height);
+			return;
+		case 2:
+			generate_mip_sse2<2>(indata, mipdata, width, height);
+			return;
+		case 1:
+			generate_mip_sse2<1>(indata, mipdata, width, height);
+			return;
+		default:
+			break;
+		}
+	}
+#endif
+	generate_mip_scalar(indata, mipdata, width, height, nchannels);
+}
+
+//static
+void LLImageKernels::bilinearScale(const U8* src, U32 srcW, U32 srcH, U32 ch, U32 srcStride,
+								   U8* dst, U32 dstW, U32 dstH, U32 dstStride)
+{
+#if LL_IMAGE_KERNELS_X86
+	// One channel images gain nothing from a register per pixel
+	if (sLevel >= LEVEL_SSE2)
+	{
+		if (ch == 4)
+		{
+			bilinear_scale_sse2<4>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+			return;
+		}
+		if (ch == 3)
+		{
+			bilinear_scale_sse2<3>(src, srcW, srcH, srcStride, dst, dstW, dstH, dstStride);
+			return;
+		}
+	}
+#endif
+	bilinear_scale_scalar(src, srcW, srcH, ch, srcStride, dst, dstW, dstH, dstStride);
+}
+
+//static
+void LLImageKernels::copyLineScaled(const U8* in, U8* out, S32 components,
+									S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step)
+{
+	llassert( components >= 1 && components <= 4 );
+#if LL_IMAGE_KERNELS_X86
+	if (sLevel >= LEVEL_SSE2)
+	{
+		if (components == 4)
+		{
+			copy_line_scaled_sse2<4>(in, out, in_pixel_len, out_pixel_len, in_pixel_step, out_pixel_step);
+			return;
+		}
+		if (components == 3)
+		{
+			copy_line_scaled_sse2<3>(in, out, in_pixel_len, out_pixel_len, in_pixel_step, out_pixel_step);
+			return;
+		}
+	}
+#endif
+	copy_line_scaled_scalar(in, out, components, in_pixel_len, out_pixel_len, in_pixel_step, out_pixel_step);
+}
+
+//static
+void LLImageKernels::compositeRowScaled4onto3(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len)
+{
+#if LL_IMAGE_KERNELS_X86
+	if (sLevel >= LEVEL_SSE2)
+	{
+		composite_row_scaled_4onto3_sse2(in, out, in_pixel_len, out_pixel_len);
+		return;
+	}
+#endif
+	composite_row_scaled_4onto3_scalar(in, out, in_pixel_len, out_pixel_len);
+}
+
+//static
+void LLImageKernels::compositeUnscaled4onto3(const U8* src, U8* dst, S32 pixels)
+{
+#if LL_IMAGE_KERNELS_X86
+	if (sLevel >= LEVEL_AVX2)
+	{
+		composite_unscaled_4onto3_avx2(src, dst, pixels);
+		return;
+	}
+	if (sLevel >= LEVEL_SSE2)
+	{
+		composite_unscaled_4onto3_sse2(src, dst, pixels);
+		return;
+	}
+#endif
+	composite_unscaled_4onto3_scalar(src, dst, pixels);
+}
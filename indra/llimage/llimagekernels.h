@@ -0,0 +1,83 @@
+/**
+ * @file llimagekernels.h
+ * @brief Pixel kernels for mip generation, scaling and compositing.
+ *
+ * @Description:
+ * The per-pixel loops behind LLImageBase::generateMip(), LLImageRaw::scale(),
+ * LLImageRaw::copyLineScaled() and the alpha composite functions. Every
+ * kernel has a scalar reference version plus SSE2 and, where the wider
+ * registers pay off, AVX2 versions. The version used is picked at run time
+ * from what LLProcessorInfo reports, so one binary runs everywhere.
+ * All vector versions produce the same bytes as the scalar ones.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLIMAGEKERNELS_H
+#define LL_LLIMAGEKERNELS_H
+
+#include "stdtypes.h"
+
+class LLImageKernels
+{
+public:
+	typedef enum e_level
+	{
+		LEVEL_SCALAR = 0,
+		LEVEL_SSE2,
+		LEVEL_AVX2
+	} ELevel;
+
+	// Picks the best level this CPU supports. Until it is called the
+	// scalar kernels are used.
+	static void initClass();
+
+	static ELevel getLevel() { return sLevel; }
+	static ELevel getMaxLevel() { return sMaxLevel; }
+	// Clamped to what the CPU supports, returns the level now in use.
+	static ELevel setLevel(ELevel level);
+	static const char* getLevelName(ELevel level);
+
+	// 2x2 box filter. width and height are those of the mip.
+	static void generateMip(const U8* indata, U8* mipdata, S32 width, S32 height, S32 nchannels);
+
+	// Bilinear up-scale / area averaging down-scale of a 1, 3 or 4 channel image.
+	static void bilinearScale(const U8* src, U32 srcW, U32 srcH, U32 ch, U32 srcStride,
+							  U8* dst, U32 dstW, U32 dstH, U32 dstStride);
+
+	// Box resample of one line of pixels; the steps are in pixels.
+	static void copyLineScaled(const U8* in, U8* out, S32 components,
+							   S32 in_pixel_len, S32 out_pixel_len, S32 in_pixel_step, S32 out_pixel_step);
+
+	// Box resample a line of 4 channel pixels and alpha composite it onto a line of 3 channel pixels.
+	static void compositeRowScaled4onto3(const U8* in, U8* out, S32 in_pixel_len, S32 out_pixel_len);
+
+	// Alpha composite 4 channel pixels onto as many 3 channel pixels.
+	static void compositeUnscaled4onto3(const U8* src, U8* dst, S32 pixels);
+
+private:
+	static ELevel sLevel;
+	static ELevel sMaxLevel;
+};
+
+#endif // LL_LLIMAGEKERNELS_H
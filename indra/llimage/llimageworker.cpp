@@ -32,52 +32,296 @@
 #include "boost/thread.hpp"
 std::atomic< U32 > s_ChildThreads;
 
-class PoolWorkerThread : public LLThread
+// <FS> Work-stealing decode pool
+#include "threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+// Decode requests are spread over one queue per pool thread, each kept in
+// priority order.  A thread decodes the best request of its own queue and
+// steals the best one of another queue when its own runs dry, so a large
+// decode only ever holds up its own queue.  Requests can be reprioritized
+// or cancelled until a thread takes them.
+class LLImageDecodePool : public LL::ThreadPool
 {
 public:
-	PoolWorkerThread(std::string name) : LLThread(name),
-		mCurrentRequest(NULL)
+	typedef LLImageDecodeThread::handle_t handle_t;
+	typedef LLImageDecodeThread::ImageRequest ImageRequest;
+
+	LLImageDecodePool(const std::string& name, U32 threads);
+	~LLImageDecodePool();
+
+	// Threads:  T*
+	void submit(ImageRequest* req);
+	bool setPriority(handle_t handle, U32 priority);
+	bool cancel(handle_t handle);
+	S32 getPending() const { return mPending; }
+
+	// Stops the threads and drops any requests still queued.
+	// Threads:  Tmain
+	void shutdown();
+
+	/*virtual*/ void run();
+
+private:
+	struct Queue
+	{
+		LLMutex mMutex;
+		std::deque<ImageRequest*> mRequests;	// highest priority first
+	};
+
+	static void insertSorted(std::deque<ImageRequest*>& requests, ImageRequest* req);
+	ImageRequest* popFront(U32 index);
+	ImageRequest* take(U32 index);
+	bool withQueued(handle_t handle, const std::function<void(Queue&, std::deque<ImageRequest*>::iterator)>& func);
+	void runRequest(ImageRequest* req);
+	void forget(ImageRequest* req);
+
+	std::vector<std::unique_ptr<Queue> > mQueues;
+	std::atomic<U32> mNextQueue;
+	std::atomic<U32> mNextThread;
+	std::atomic<S32> mQueued;		// waiting in a queue
+	std::atomic<S32> mPending;		// queued or decoding
+	std::atomic<bool> mQuitting;
+
+	std::mutex mWaitMutex;
+	std::condition_variable mWaitCondition;
+
+	LLMutex mHandleMutex;
+	std::unordered_map<handle_t, ImageRequest*> mHandles;	// guarded by mHandleMutex
+};
+
+LLImageDecodePool::LLImageDecodePool(const std::string& name, U32 threads)
+	: LL::ThreadPool(name, threads),
+	  mNextQueue(0),
+	  mNextThread(0),
+	  mQueued(0),
+	  mPending(0),
+	  mQuitting(false)
+{
+	for (U32 i = 0; i < threads; ++i)
 	{
+		mQueues.emplace_back(new Queue);
 	}
-	virtual void run()
+}
+
+LLImageDecodePool::~LLImageDecodePool()
+{
+	shutdown();
+}
+
+void LLImageDecodePool::shutdown()
+{
 	{
-		while (!isQuitting())
-		{
-			auto *pReq = mCurrentRequest.exchange(nullptr);
+		std::lock_guard<std::mutex> lock(mWaitMutex);
+		mQuitting = true;
+	}
+	mWaitCondition.notify_all();
+	close();
 
-			if (pReq)
-				pReq->processRequestIntern();
-			checkPause();
+	// Like LLQueuedThread on shutdown, whatever did not run yet is dropped
+	for (auto& queue : mQueues)
+	{
+		LLMutexLock lock(&queue->mMutex);
+		for (ImageRequest* req : queue->mRequests)
+		{
+			req->mPoolState = ImageRequest::POOL_CANCELLED;
+			forget(req);
+			req->setStatus(LLQueuedThread::STATUS_ABORTED);
+			req->deleteRequest();
+			--mQueued;
+			--mPending;
 		}
+		queue->mRequests.clear();
+	}
+}
+
+// static
+void LLImageDecodePool::insertSorted(std::deque<ImageRequest*>& requests, ImageRequest* req)
+{
+	// Behind requests of the same priority, so equal ones stay in order
+	auto iter = std::upper_bound(requests.begin(), requests.end(), req,
+								 [](const ImageRequest* lhs, const ImageRequest* rhs)
+								 {
+									 return lhs->getPriority() > rhs->getPriority();
+								 });
+	requests.insert(iter, req);
+}
+
+void LLImageDecodePool::submit(ImageRequest* req)
+{
+	{
+		LLMutexLock lock(&mHandleMutex);
+		mHandles[req->getHashKey()] = req;
+	}
+
+	++mPending;
+	U32 index = mNextQueue++ % (U32)mQueues.size();
+	{
+		Queue& queue = *mQueues[index];
+		LLMutexLock lock(&queue.mMutex);
+		req->mPoolQueue = index;
+		req->mPoolState = ImageRequest::POOL_QUEUED;
+		insertSorted(queue.mRequests, req);
+		++mQueued;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWaitMutex);
+	}
+	mWaitCondition.notify_one();
+}
+
+// Runs func on a request still waiting in a queue, with that queue locked.
+bool LLImageDecodePool::withQueued(handle_t handle, const std::function<void(Queue&, std::deque<ImageRequest*>::iterator)>& func)
+{
+	// Requests stay alive while they are in mHandles
+	LLMutexLock handle_lock(&mHandleMutex);
+	auto found = mHandles.find(handle);
+	if (found == mHandles.end())
+	{
+		return false;
 	}
-	bool isBusy()
+	ImageRequest* req = found->second;
+	if (req->mPoolState != ImageRequest::POOL_QUEUED)
 	{
-		auto *pReq = mCurrentRequest.load();
-		if (!pReq)
-			return false;
+		return false;
+	}
+
+	Queue& queue = *mQueues[req->mPoolQueue];
+	LLMutexLock lock(&queue.mMutex);
+	if (req->mPoolState != ImageRequest::POOL_QUEUED)
+	{
+		return false; // taken meanwhile
+	}
+	auto iter = std::find(queue.mRequests.begin(), queue.mRequests.end(), req);
+	if (iter == queue.mRequests.end())
+	{
+		return false;
+	}
+	func(queue, iter);
+	return true;
+}
 
-		auto status = pReq->getStatus();
+bool LLImageDecodePool::setPriority(handle_t handle, U32 priority)
+{
+	return withQueued(handle, [priority](Queue& queue, std::deque<ImageRequest*>::iterator iter)
+		{
+			ImageRequest* req = *iter;
+			if (req->getPriority() != priority)
+			{
+				queue.mRequests.erase(iter);
+				req->setPriority(priority);
+				insertSorted(queue.mRequests, req);
+			}
+		});
+}
 
-		return status  == LLQueuedThread::STATUS_QUEUED || status == LLQueuedThread::STATUS_INPROGRESS;
+bool LLImageDecodePool::cancel(handle_t handle)
+{
+	ImageRequest* cancelled = NULL;
+	bool res = withQueued(handle, [&cancelled](Queue& queue, std::deque<ImageRequest*>::iterator iter)
+		{
+			cancelled = *iter;
+			cancelled->mPoolState = ImageRequest::POOL_CANCELLED;
+			queue.mRequests.erase(iter);
+		});
+	if (cancelled)
+	{
+		--mQueued;
+		forget(cancelled);
+		cancelled->setStatus(LLQueuedThread::STATUS_ABORTED);
+		cancelled->deleteRequest();
+		--mPending;
 	}
+	return res;
+}
 
-	bool runCondition()
+LLImageDecodePool::ImageRequest* LLImageDecodePool::popFront(U32 index)
+{
+	Queue& queue = *mQueues[index];
+	LLMutexLock lock(&queue.mMutex);
+	if (queue.mRequests.empty())
 	{
-		return mCurrentRequest != NULL;
+		return NULL;
 	}
+	ImageRequest* req = queue.mRequests.front();
+	queue.mRequests.pop_front();
+	req->mPoolState = ImageRequest::POOL_RUNNING;
+	--mQueued;
+	return req;
+}
 
-	bool setRequest(LLImageDecodeThread::ImageRequest* req)
+LLImageDecodePool::ImageRequest* LLImageDecodePool::take(U32 index)
+{
+	ImageRequest* req = popFront(index);
+	if (req || mQueued <= 0)
 	{
-		LLImageDecodeThread::ImageRequest* pOld{ nullptr };
-		bool bSuccess = mCurrentRequest.compare_exchange_strong(pOld, req);
-		wake();
+		return req;
+	}
 
-		return bSuccess;
+	// Own queue is empty: steal the best request any other queue has
+	const U32 count = (U32)mQueues.size();
+	U32 victim = index;
+	U32 best_priority = 0;
+	for (U32 i = 1; i < count; ++i)
+	{
+		U32 other = (index + i) % count;
+		Queue& queue = *mQueues[other];
+		LLMutexLock lock(&queue.mMutex);
+		if (!queue.mRequests.empty() &&
+			(victim == index || queue.mRequests.front()->getPriority() > best_priority))
+		{
+			victim = other;
+			best_priority = queue.mRequests.front()->getPriority();
+		}
 	}
+	return (victim != index) ? popFront(victim) : NULL;
+}
 
-private:
-	std::atomic< LLImageDecodeThread::ImageRequest * > mCurrentRequest;
-};
+void LLImageDecodePool::forget(ImageRequest* req)
+{
+	LLMutexLock lock(&mHandleMutex);
+	mHandles.erase(req->getHashKey());
+}
+
+void LLImageDecodePool::runRequest(ImageRequest* req)
+{
+	req->setStatus(LLQueuedThread::STATUS_INPROGRESS);
+	req->processRequestIntern();
+	req->setStatus(LLQueuedThread::STATUS_COMPLETE);
+	req->finishRequest(true);
+	forget(req);
+	req->deleteRequest();
+	--mPending;
+}
+
+void LLImageDecodePool::run()
+{
+	const U32 index = mNextThread++ % (U32)mQueues.size();
+	while (!mQuitting && !getQueue().isClosed())
+	{
+		ImageRequest* req = take(index);
+		if (req)
+		{
+			runRequest(req);
+			continue;
+		}
+
+		// Also wakes up now and then to notice ThreadPool::close() on
+		// application shutdown, which doesn't know about this condition.
+		std::unique_lock<std::mutex> lock(mWaitMutex);
+		mWaitCondition.wait_for(lock, std::chrono::milliseconds(100),
+								[this]() { return mQueued > 0 || mQuitting; });
+	}
+}
+// </FS>
 // </FS:ND>
 
 //----------------------------------------------------------------------------
@@ -111,22 +355,44 @@ LLImageDecodeThread::LLImageDecodeThread(bool threaded, U32 aSubThreads)
 	}
 	else if (aSubThreads == 1) // Disable if only 1
 		aSubThreads = 0;
+	// <FS> Work-stealing decode pool: a non threaded instance decodes in update()
+	if (!threaded)
+		aSubThreads = 0;
+	// </FS>
 
 	s_ChildThreads = aSubThreads;
-	for (U32 i = 0; i < aSubThreads; ++i)
+	// <FS> Work-stealing decode pool
+	//for (U32 i = 0; i < aSubThreads; ++i)
+	//{
+	//	std::stringstream strm;
+	//	strm << "imagedecodethread" << (i + 1);
+
+	//	mThreadPool.push_back(std::make_shared< PoolWorkerThread>(strm.str()));
+	//	mThreadPool[i]->start();
+	//}
+	if (aSubThreads > 0)
 	{
-		std::stringstream strm;
-		strm << "imagedecodethread" << (i + 1);
-
-		mThreadPool.push_back(std::make_shared< PoolWorkerThread>(strm.str()));
-		mThreadPool[i]->start();
+		// Pool requests bypass the queued thread entirely, so the pool
+		// also takes over the core it used to decode on. Names must be
+		// unique per ThreadPool instance.
+		static std::atomic<U32> s_PoolCount(0);
+		mPool.reset(new LLImageDecodePool(llformat("ImageDecode%u", ++s_PoolCount), aSubThreads + 1));
+		mPool->start();
 	}
+	// </FS>
 	// </FS:ND>
 }
 
 //virtual 
 LLImageDecodeThread::~LLImageDecodeThread()
 {
+	// <FS> Work-stealing decode pool
+	if (mPool)
+	{
+		mPool->shutdown();
+		mPool.reset();
+	}
+	// </FS>
 	delete mCreationMutex ;
 }
 
@@ -182,18 +448,29 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(LLImageFormatted*
 	// If we have a thread pool dispatch this directly.
 	// Note: addRequest could cause the handling to take place on the fetch thread, this is unlikely to be an issue. 
 	// if this is an actual problem we move the fallback to here and place the unfulfilled request into the legacy queue
-	if (s_ChildThreads > 0)
+	// <FS> Work-stealing decode pool
+	//if (s_ChildThreads > 0)
+	if (mPool)
+	// </FS>
 	{
 		LL_PROFILE_ZONE_NAMED_COLOR("DecodeDecoupled", tracy::Color::Orange); // <FS:Beq> instrument the image decode pipeline
-		ImageRequest* req = new ImageRequest(handle, image,
-			priority, discard, needs_aux,
-			responder, this);
-		bool res = addRequest(req);
-		if (!res)
+		// <FS> Work-stealing decode pool
+		//ImageRequest* req = new ImageRequest(handle, image,
+		//	priority, discard, needs_aux,
+		//	responder, this);
+		//bool res = addRequest(req);
+		//if (!res)
+		if (isQuitting())
+		// </FS>
 		{
 			LL_WARNS() << "Decode request not added because we are exiting." << LL_ENDL;
 			return 0;
 		}
+		// <FS> Work-stealing decode pool
+		mPool->submit(new ImageRequest(handle, image,
+			priority, discard, needs_aux,
+			responder, this));
+		// </FS>
 	}
 	else
 	{
@@ -205,6 +482,74 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(LLImageFormatted*
 	return handle;
 }
 
+// <FS> Work-stealing decode pool
+bool LLImageDecodeThread::setDecodePriority(handle_t handle, U32 priority)
+{
+	if (mPool)
+	{
+		return mPool->setPriority(handle, priority);
+	}
+
+	{
+		LLMutexLock lock(mCreationMutex);
+		for (creation_info& info : mCreationList)
+		{
+			if (info.handle == handle)
+			{
+				info.priority = priority;
+				return true;
+			}
+		}
+	}
+
+	// Requests queued on this thread are resorted by LLQueuedThread
+	if (getRequestStatus(handle) != STATUS_QUEUED)
+	{
+		return false;
+	}
+	setPriority(handle, priority);
+	return true;
+}
+
+bool LLImageDecodeThread::cancelDecode(handle_t handle)
+{
+	if (mPool)
+	{
+		return mPool->cancel(handle);
+	}
+
+	{
+		LLMutexLock lock(mCreationMutex);
+		for (creation_list_t::iterator iter = mCreationList.begin(); iter != mCreationList.end(); ++iter)
+		{
+			if (iter->handle == handle)
+			{
+				mCreationList.erase(iter);
+				return true;
+			}
+		}
+	}
+
+	if (getRequestStatus(handle) != STATUS_QUEUED)
+	{
+		return false;
+	}
+	abortRequest(handle, true);
+	return true;
+}
+
+// virtual
+S32 LLImageDecodeThread::getPending()
+{
+	S32 res = LLQueuedThread::getPending();
+	if (mPool)
+	{
+		res += mPool->getPending();
+	}
+	return res;
+}
+// </FS>
+
 // Used by unit test only
 // Returns the size of the mutex guarded list as an indication of sanity
 S32 LLImageDecodeThread::tut_size()
@@ -231,7 +576,11 @@ LLImageDecodeThread::ImageRequest::ImageRequest(handle_t handle, LLImageFormatte
 	  mDecodedRaw(FALSE),
 	  mDecodedAux(FALSE),
 	  mResponder(responder),
-      mQueue( aQueue ) // <FS:ND/> Image thread pool from CoolVL
+      mQueue( aQueue ), // <FS:ND/> Image thread pool from CoolVL
+	  // <FS> Work-stealing decode pool
+	  mPoolState(POOL_QUEUED),
+	  mPoolQueue(0)
+	  // </FS>
 {
 	//<FS:ND> Image thread pool from CoolVL
 	if (s_ChildThreads > 0)
@@ -254,14 +603,18 @@ bool LLImageDecodeThread::ImageRequest::processRequest()
 {
 	// <FS:ND> Image thread pool from CoolVL
 
-	// If not async, decode using this thread
-	if ((mFlags & FLAG_ASYNC) == 0)
-		return processRequestIntern();
-
-	// Try to dispatch to a new thread, if this isn't possible decode on this thread
-	if (!mQueue->enqueRequest(this))
-		return processRequestIntern();
-	return true;
+	// <FS> Work-stealing decode pool
+	// Pool requests never reach the queued thread, see LLImageDecodePool
+	//// If not async, decode using this thread
+	//if ((mFlags & FLAG_ASYNC) == 0)
+	//	return processRequestIntern();
+
+	//// Try to dispatch to a new thread, if this isn't possible decode on this thread
+	//if (!mQueue->enqueRequest(this))
+	//	return processRequestIntern();
+	//return true;
+	return processRequestIntern();
+	// </FS>
 	// </FS:ND>
 }
 
@@ -336,13 +689,15 @@ bool LLImageDecodeThread::ImageRequest::processRequestIntern()
 	}
 	// </FS:Beq>
 	//<FS:ND> Image thread pool from CoolVL
-	if (mFlags & FLAG_ASYNC)
-	{
-		setStatus(STATUS_COMPLETE);
-		finishRequest(true);
-		// always autocomplete
-		mQueue->completeRequest(mHashKey);
-	}
+	// <FS> Work-stealing decode pool completes its requests itself
+	//if (mFlags & FLAG_ASYNC)
+	//{
+	//	setStatus(STATUS_COMPLETE);
+	//	finishRequest(true);
+	//	// always autocomplete
+	//	mQueue->completeRequest(mHashKey);
+	//}
+	// </FS>
 	// </FS:ND>
 	return done;
 }
@@ -365,15 +720,17 @@ bool LLImageDecodeThread::ImageRequest::tut_isOK()
 	return mResponder.notNull();
 }
 
-bool LLImageDecodeThread::enqueRequest(ImageRequest * req)
-{
-	for (auto &pThread : mThreadPool)
-	{
-		if (!pThread->isBusy())
-		{
-			if( pThread->setRequest(req) )
-				return true;
-		}
-	}
-	return false;
-}
+// <FS> Work-stealing decode pool
+//bool LLImageDecodeThread::enqueRequest(ImageRequest * req)
+//{
+//	for (auto &pThread : mThreadPool)
+//	{
+//		if (!pThread->isBusy())
+//		{
+//			if( pThread->setRequest(req) )
+//				return true;
+//		}
+//	}
+//	return false;
+//}
+// </FS>
@@ -31,8 +31,14 @@
 #include "llpointer.h"
 #include "llworkerthread.h"
 
+#include <atomic> // <FS/> Work-stealing decode pool
+#include <memory> // <FS/> Work-stealing decode pool
+
  // <FS:ND/> Image thread pool
-class PoolWorkerThread;
+// <FS> Work-stealing decode pool
+//class PoolWorkerThread;
+class LLImageDecodePool;
+// </FS>
 
 class LLImageDecodeThread : public LLQueuedThread
 {
@@ -47,6 +53,8 @@ public:
 
 	class ImageRequest : public LLQueuedThread::QueuedRequest
 	{
+		friend class LLImageDecodePool; // <FS/> Work-stealing decode pool
+
 	protected:
 		virtual ~ImageRequest(); // use deleteRequest()
 		
@@ -74,6 +82,19 @@ public:
 		BOOL mDecodedRaw;
 		BOOL mDecodedAux;
 		LLPointer<LLImageDecodeThread::Responder> mResponder;
+
+		// <FS> Work-stealing decode pool
+		enum e_pool_state
+		{
+			POOL_QUEUED,
+			POOL_RUNNING,
+			POOL_CANCELLED
+		};
+		// Both are only changed while holding the mutex of the pool queue
+		// the request sits in.
+		std::atomic<U32> mPoolState;
+		std::atomic<U32> mPoolQueue;
+		// </FS>
 	};
 	
 public:
@@ -89,6 +110,22 @@ public:
 						 Responder* responder);
 	S32 update(F32 max_time_ms);
 
+	// <FS> Work-stealing decode pool
+	// Changes the priority of a request that has not started decoding yet.
+	// Returns false if it already started or is unknown.
+	bool setDecodePriority(handle_t handle, U32 priority);
+
+	// Drops a request that has not started decoding yet.  Without the pool
+	// its responder still reports a failure, which callers must ignore.
+	// Returns false if it already started or is unknown.
+	bool cancelDecode(handle_t handle);
+
+	// True when requests go to the work-stealing pool rather than this thread.
+	bool usesDecodePool() const { return mPool != nullptr; }
+
+	/*virtual*/ S32 getPending();
+	// </FS>
+
 	// Used by unit tests to check the consistency of the thread instance
 	S32 tut_size();
 	
@@ -110,8 +147,11 @@ private:
 	LLMutex* mCreationMutex;
 
 	// <FS:ND> Image thread pool from CoolVL
-	std::vector< std::shared_ptr< PoolWorkerThread > > mThreadPool;
-	bool enqueRequest(ImageRequest*);
+	// <FS> Work-stealing decode pool
+	//std::vector< std::shared_ptr< PoolWorkerThread > > mThreadPool;
+	//bool enqueRequest(ImageRequest*);
+	std::unique_ptr<LLImageDecodePool> mPool;
+	// </FS>
 	// <FS:ND>
 };
 
@@ -0,0 +1,217 @@
+/**
+ * @file llimagekernels_test.cpp
+ * @brief Checks the SIMD image kernels against the scalar ones.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+// Class to test
+#include "../llimagekernels.h"
+// For timer class
+#include "../llcommon/lltimer.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct imagekernels_test
+	{
+		U32 mSeed;
+
+		imagekernels_test()
+		:	mSeed(0x1234567)
+		{
+			LLImageKernels::initClass();
+		}
+
+		~imagekernels_test()
+		{
+			LLImageKernels::setLevel(LLImageKernels::getMaxLevel());
+		}
+
+		// Repeatable pixel noise. Alpha gets 0 and 255 often, those take their own paths.
+		void fill(std::vector<U8>& data)
+		{
+			for (size_t i = 0; i < data.size(); ++i)
+			{
+				mSeed = mSeed * 1103515245 + 12345;
+				U8 value = (U8)(mSeed >> 16);
+				if ((value & 0x30) == 0x30)
+				{
+					value = (value & 1) ? 255 : 0;
+				}
+				data[i] = value;
+			}
+		}
+
+		// Runs a kernel at every level the CPU has and checks each against the scalar result
+		template<typename KERNEL>
+		void check_levels(const std::string& what, const std::vector<U8>& initial, KERNEL kernel)
+		{
+			std::vector<U8> expected(initial);
+			LLImageKernels::setLevel(LLImageKernels::LEVEL_SCALAR);
+			kernel(expected);
+
+			for (S32 level = LLImageKernels::LEVEL_SCALAR + 1; level <= LLImageKernels::getMaxLevel(); ++level)
+			{
+				LLImageKernels::setLevel((LLImageKernels::ELevel)level);
+				std::vector<U8> result(initial);
+				kernel(result);
+				ensure(what + " " + LLImageKernels::getLevelName((LLImageKernels::ELevel)level) + " differs from scalar",
+					   result == expected);
+			}
+		}
+	};
+
+	typedef test_group<imagekernels_test> imagekernels_t;
+	typedef imagekernels_t::object imagekernels_object_t;
+	tut::imagekernels_t tut_imagekernels("LLImageKernels");
+
+	template<> template<>
+	void imagekernels_object_t::test<1>()
+	{
+		// Odd widths exercise the scalar tails of the vector loops
+		const S32 sizes[] = { 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 33, 64, 127 };
+		for (S32 nchannels = 1; nchannels <= 4; ++nchannels)
+		{
+			for (S32 width : sizes)
+			{
+				const S32 height = 3;
+				std::vector<U8> src(width * 2 * height * 2 * nchannels);
+				fill(src);
+				std::vector<U8> mip(width * height * nchannels);
+				check_levels(llformat("generateMip %dx%dx%d", width, height, nchannels), mip,
+							 [&](std::vector<U8>& out) { LLImageKernels::generateMip(src.data(), out.data(), width, height, nchannels); });
+			}
+		}
+	}
+
+	template<> template<>
+	void imagekernels_object_t::test<2>()
+	{
+		// Up, down and mixed scaling in both directions
+		const U32 sizes[][4] = {
+			{ 16, 16, 32, 32 }, { 32, 32, 16, 16 }, { 37, 21, 64, 9 }, { 9, 64, 37, 21 },
+			{ 128, 128, 27, 31 }, { 5, 3, 128, 96 }, { 1, 1, 7, 7 }, { 300, 7, 299, 8 }
+		};
+		const U32 channels[] = { 1, 3, 4 };
+		for (U32 ch : channels)
+		{
+			for (const U32* size : sizes)
+			{
+				std::vector<U8> src(size[0] * size[1] * ch);
+				fill(src);
+				std::vector<U8> dst(size[2] * size[3] * ch);
+				check_levels(llformat("bilinearScale %ux%u -> %ux%u (%u)", size[0], size[1], size[2], size[3], ch), dst,
+							 [&](std::vector<U8>& out) { LLImageKernels::bilinearScale(src.data(), size[0], size[1], ch, size[0] * ch, out.data(), size[2], size[3], size[2] * ch); });
+			}
+		}
+	}
+
+	template<> template<>
+	void imagekernels_object_t::test<3>()
+	{
+		const S32 lengths[][2] = { { 64, 32 }, { 33, 10 }, { 10, 33 }, { 7, 7 }, { 255, 2 }, { 3, 200 } };
+		for (S32 components = 1; components <= 4; ++components)
+		{
+			for (const S32* len : lengths)
+			{
+				// A column of a 3 pixel wide image, so the steps matter
+				std::vector<U8> src(len[0] * 3 * components);
+				fill(src);
+				std::vector<U8> dst(len[1] * 2 * components);
+				check_levels(llformat("copyLineScaled %d -> %d (%d)", len[0], len[1], components), dst,
+							 [&](std::vector<U8>& out) { LLImageKernels::copyLineScaled(src.data() + components, out.data(), components, len[0], len[1], 3, 2); });
+			}
+		}
+	}
+
+	template<> template<>
+	void imagekernels_object_t::test<4>()
+	{
+		const S32 lengths[][2] = { { 64, 32 }, { 33, 10 }, { 10, 33 }, { 7, 7 }, { 255, 2 } };
+		for (const S32* len : lengths)
+		{
+			std::vector<U8> src(len[0] * 4);
+			fill(src);
+			std::vector<U8> dst(len[1] * 3);
+			fill(dst);
+			check_levels(llformat("compositeRowScaled4onto3 %d -> %d", len[0], len[1]), dst,
+						 [&](std::vector<U8>& out) { LLImageKernels::compositeRowScaled4onto3(src.data(), out.data(), len[0], len[1]); });
+		}
+	}
+
+	template<> template<>
+	void imagekernels_object_t::test<5>()
+	{
+		const S32 counts[] = { 0, 1, 3, 4, 5, 9, 10, 11, 16, 17, 33, 1000 };
+		for (S32 pixels : counts)
+		{
+			std::vector<U8> src(pixels * 4);
+			fill(src);
+			std::vector<U8> dst(pixels * 3);
+			fill(dst);
+			check_levels(llformat("compositeUnscaled4onto3 %d", pixels), dst,
+						 [&](std::vector<U8>& out) { LLImageKernels::compositeUnscaled4onto3(src.data(), out.data(), pixels); });
+		}
+	}
+
+	template<> template<>
+	void imagekernels_object_t::test<6>()
+	{
+		// Not a pass/fail test: reports how the levels compare on a 1024x1024 RGBA image
+		const S32 size = 1024;
+		std::vector<U8> src(size * size * 4);
+		fill(src);
+		std::vector<U8> dst(size * size * 4);
+
+		for (S32 level = LLImageKernels::LEVEL_SCALAR; level <= LLImageKernels::getMaxLevel(); ++level)
+		{
+			LLImageKernels::setLevel((LLImageKernels::ELevel)level);
+
+			LLTimer timer;
+			for (S32 i = 0; i < 10; ++i)
+			{
+				LLImageKernels::generateMip(src.data(), dst.data(), size / 2, size / 2, 4);
+			}
+			F32 mip_time = timer.getElapsedTimeAndResetF32();
+			for (S32 i = 0; i < 10; ++i)
+			{
+				LLImageKernels::bilinearScale(src.data(), size, size, 4, size * 4, dst.data(), 700, 700, 700 * 4);
+			}
+			F32 scale_time = timer.getElapsedTimeAndResetF32();
+			for (S32 i = 0; i < 10; ++i)
+			{
+				LLImageKernels::compositeUnscaled4onto3(src.data(), dst.data(), size * size);
+			}
+			F32 composite_time = timer.getElapsedTimeF32();
+
+			LL_INFOS("ImageKernels") << LLImageKernels::getLevelName((LLImageKernels::ELevel)level)
+									 << ": generateMip " << mip_time * 100.f << " ms, bilinearScale " << scale_time * 100.f
+									 << " ms, compositeUnscaled4onto3 " << composite_time * 100.f << " ms" << LL_ENDL;
+		}
+	}
+}
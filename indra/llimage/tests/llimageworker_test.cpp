@@ -36,6 +36,10 @@
 // Tut header
 #include "../test/lltut.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 // -------------------------------------------------------------------------------------------
 // Stubbing: Declarations required to link and run the class being tested
 // Notes: 
@@ -66,8 +70,24 @@ LLImageRaw::~LLImageRaw() { }
 void LLImageRaw::deleteData() { }
 U8* LLImageRaw::allocateData(S32 size) { return NULL; }
 U8* LLImageRaw::reallocateData(S32 size) { return NULL; }
-const U8* LLImageBase::getData() const { return NULL; }
-U8* LLImageBase::getData() { return NULL; }
+// The decode pool tests need some non-NULL raw buffer, nothing is ever written into it
+static U8 stub_raw_data[4];
+const U8* LLImageBase::getData() const { return stub_raw_data; }
+U8* LLImageBase::getData() { return stub_raw_data; }
+void LLImageBase::setSize(S32 width, S32 height, S32 ncomponents) { mWidth = width; mHeight = height; mComponents = ncomponents; }
+
+LLImageFormatted::LLImageFormatted(S8 codec) : mCodec(codec), mDecoding(0), mDecoded(0), mDiscardLevel(-1), mLevels(0) { }
+LLImageFormatted::~LLImageFormatted() { }
+void LLImageFormatted::deleteData() { }
+U8* LLImageFormatted::allocateData(S32 size) { return NULL; }
+U8* LLImageFormatted::reallocateData(S32 size) { return NULL; }
+void LLImageFormatted::dump() { }
+void LLImageFormatted::sanityCheck() { }
+S32 LLImageFormatted::calcDataSize(S32 discard_level) { return 0; }
+S32 LLImageFormatted::calcDiscardLevelBytes(S32 bytes) { return 0; }
+bool LLImageFormatted::decodeChannels(LLImageRaw* raw_image, F32 decode_time, S32 first_channel, S32 max_channel) { return true; }
+void LLImageFormatted::resetLastError() { }
+void LLImageFormatted::setLastError(const std::string& message, const std::string& filename) { }
 
 // End Stubbing
 // -------------------------------------------------------------------------------------------
@@ -109,6 +129,66 @@ namespace tut
 			bool* done;
 	};
 
+	// Simulator of a J2C image for the decode pool tests: decoding burns CPU
+	// time in proportion to the pixel count, as the real decoder roughly does,
+	// and can be held back by a gate to keep the pool threads busy.
+	class decode_test_image : public LLImageFormatted
+	{
+		public:
+			decode_test_image(U16 size, F64 ns_per_pixel, const std::atomic<bool>* gate = NULL)
+				: LLImageFormatted(IMG_CODEC_J2C),
+				  mCost(std::chrono::nanoseconds((S64)(ns_per_pixel * size * size))),
+				  mGate(gate)
+			{
+				setSize(size, size, 4);
+			}
+			/*virtual*/ std::string getExtension() { return "j2c"; }
+			/*virtual*/ bool updateData() { return true; }
+			/*virtual*/ bool encode(const LLImageRaw* raw_image, F32 encode_time) { return false; }
+			/*virtual*/ bool decode(LLImageRaw* raw_image, F32 decode_time)
+			{
+				while (mGate && !mGate->load())
+				{
+					ms_sleep(1);
+				}
+				const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + mCost;
+				while (std::chrono::steady_clock::now() < end)
+				{
+				}
+				return true;
+			}
+		private:
+			std::chrono::nanoseconds mCost;
+			const std::atomic<bool>* mGate;
+	};
+
+	// Records when a decode request completed
+	class responder_timed : public LLImageDecodeThread::Responder
+	{
+		public:
+			responder_timed(std::chrono::steady_clock::time_point* completed, std::atomic<S32>* count)
+				: mCompleted(completed), mCount(count)
+			{
+			}
+			virtual void completed(bool success, LLImageRaw* raw, LLImageRaw* aux)
+			{
+				*mCompleted = std::chrono::steady_clock::now();
+				++*mCount;
+			}
+		private:
+			std::chrono::steady_clock::time_point* mCompleted;
+			std::atomic<S32>* mCount;
+	};
+
+	bool wait_for_count(const std::atomic<S32>& count, S32 expected)
+	{
+		for (U32 waited = 0; count < expected && waited < 30000; waited += 10)
+		{
+			ms_sleep(10);
+		}
+		return count >= expected;
+	}
+
 	// Test wrapper declaration : decode thread
 	struct imagedecodethread_test
 	{
@@ -142,7 +222,7 @@ namespace tut
 
 			mRequest = new LLImageDecodeThread::ImageRequest(0, 0,
 											 LLQueuedThread::PRIORITY_NORMAL, 0, FALSE,
-											 new responder_test(&done));
+											 new responder_test(&done), NULL);
 		}
 		~imagerequest_test()
 		{
@@ -215,7 +295,8 @@ namespace tut
 	void imagedecodethread_object_t::test<2>()
 	{
 		// Test a *threaded* instance of the class
-		mThread = new LLImageDecodeThread(true);
+		// Without the decode pool (1 sub thread disables it) requests wait for update()
+		mThread = new LLImageDecodeThread(true, 1);
 		ensure("LLImageDecodeThread: threaded constructor failed", mThread != NULL);
 		// Test that we start with an empty list right at creation
 		ensure("LLImageDecodeThread: threaded init state incorrect", mThread->tut_size() == 0);
@@ -243,6 +324,101 @@ namespace tut
 		ensure("LLImageDecodeThread: threaded work unit not processed", done == true);
 	}
 
+	template<> template<>
+	void imagedecodethread_object_t::test<3>()
+	{
+		// Reprioritizing and cancelling requests queued on the decode pool
+		mThread = new LLImageDecodeThread(true, 2);
+		const S32 pool_threads = 3; // sub threads + the one of the queued thread
+
+		// Keep every pool thread busy so the following requests stay queued
+		std::atomic<bool> gate(false);
+		std::atomic<S32> count(0);
+		std::vector<std::chrono::steady_clock::time_point> completed(pool_threads + 3);
+		for (S32 i = 0; i < pool_threads; ++i)
+		{
+			mThread->decodeImage(new decode_test_image(32, 0.0, &gate), LLQueuedThread::PRIORITY_NORMAL, 0, FALSE,
+								 new responder_timed(&completed[i], &count));
+		}
+		// Let the pool threads pick those up
+		ms_sleep(200);
+
+		LLImageDecodeThread::handle_t keep = mThread->decodeImage(new decode_test_image(32, 0.0), LLQueuedThread::PRIORITY_LOW, 0, FALSE,
+																  new responder_timed(&completed[pool_threads], &count));
+		LLImageDecodeThread::handle_t drop = mThread->decodeImage(new decode_test_image(32, 0.0), LLQueuedThread::PRIORITY_LOW, 0, FALSE,
+																  new responder_timed(&completed[pool_threads + 1], &count));
+		ensure_equals("LLImageDecodeThread: pending requests", mThread->getPending(), pool_threads + 2);
+		ensure("LLImageDecodeThread: reprioritize queued request", mThread->setDecodePriority(keep, LLQueuedThread::PRIORITY_HIGH));
+		ensure("LLImageDecodeThread: cancel queued request", mThread->cancelDecode(drop));
+		ensure("LLImageDecodeThread: cancel twice", !mThread->cancelDecode(drop));
+		ensure("LLImageDecodeThread: cancel unknown handle", !mThread->cancelDecode(drop + 1000));
+		ensure_equals("LLImageDecodeThread: pending after cancel", mThread->getPending(), pool_threads + 1);
+
+		gate = true;
+		ensure("LLImageDecodeThread: pool requests not processed", wait_for_count(count, pool_threads + 1));
+		ms_sleep(100);
+		ensure_equals("LLImageDecodeThread: cancelled responder called", count.load(), pool_threads + 1);
+		ensure("LLImageDecodeThread: reprioritize finished request", !mThread->setDecodePriority(keep, LLQueuedThread::PRIORITY_LOW));
+		ensure_equals("LLImageDecodeThread: pending when done", mThread->getPending(), 0);
+	}
+
+	template<> template<>
+	void imagedecodethread_object_t::test<4>()
+	{
+		// Benchmark: decode a corpus of simulated J2C images of typical sizes
+		// (UI icons to 2048x2048 textures) and report throughput and p99
+		// latency per priority class.
+		mThread = new LLImageDecodeThread(true);
+
+		struct corpus_class
+		{
+			const char* name;
+			U32 priority;
+			U16 sizes[2];
+		};
+		const corpus_class classes[] =
+		{
+			{ "high (UI icons)", LLQueuedThread::PRIORITY_HIGH, { 32, 64 } },
+			{ "normal (object textures)", LLQueuedThread::PRIORITY_NORMAL, { 256, 512 } },
+			{ "low (large textures)", LLQueuedThread::PRIORITY_LOW, { 1024, 2048 } }
+		};
+		const S32 num_classes = LL_ARRAY_SIZE(classes);
+		const S32 per_class = 40;
+		const F64 ns_per_pixel = 1.0;
+
+		const S32 total = num_classes * per_class;
+		std::vector<std::chrono::steady_clock::time_point> submitted(total), completed(total);
+		std::atomic<S32> count(0);
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		// Interleave the classes so that large decodes are queued ahead of icons
+		for (S32 i = 0; i < per_class; ++i)
+		{
+			for (S32 c = num_classes - 1; c >= 0; --c)
+			{
+				const S32 index = c * per_class + i;
+				submitted[index] = std::chrono::steady_clock::now();
+				mThread->decodeImage(new decode_test_image(classes[c].sizes[i % 2], ns_per_pixel), classes[c].priority, 0, FALSE,
+									 new responder_timed(&completed[index], &count));
+			}
+		}
+		ensure("LLImageDecodeThread: benchmark requests not processed", wait_for_count(count, total));
+		const F64 elapsed = std::chrono::duration<F64>(std::chrono::steady_clock::now() - start).count();
+
+		LL_INFOS("ImageDecode") << total << " decodes in " << elapsed << " s, " << (total / elapsed) << " decodes/s" << LL_ENDL;
+		for (S32 c = 0; c < num_classes; ++c)
+		{
+			std::vector<F64> latencies;
+			for (S32 i = 0; i < per_class; ++i)
+			{
+				const S32 index = c * per_class + i;
+				latencies.push_back(std::chrono::duration<F64, std::milli>(completed[index] - submitted[index]).count());
+			}
+			std::sort(latencies.begin(), latencies.end());
+			const F64 p99 = latencies[(latencies.size() * 99) / 100];
+			LL_INFOS("ImageDecode") << classes[c].name << ": p99 latency " << p99 << " ms, median " << latencies[latencies.size() / 2] << " ms" << LL_ENDL;
+		}
+	}
+
 	// ---------------------------------------------------------------------------------------
 	// Test the LLImageDecodeThread::ImageRequest interface
 	// ---------------------------------------------------------------------------------------
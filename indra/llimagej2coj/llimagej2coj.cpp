@@ -38,6 +38,8 @@
 
 #include "lltimer.h"
 
+#include <atomic> // <FS/> Decode session budget
+
 // [SL:KB] - Patch: Viewer-OpenJPEG2 | Checked: Catznip-5.3
 #ifdef OPENJPEG2
 class LLJp2StreamReader {
@@ -234,14 +236,188 @@ int ceildivpow2(int a, int b)
 }
 
 
+// <FS> Progressive decode
+namespace
+{
+	// Upper bound for the decoded pixel data idle decode sessions may hold
+	// across all images. Above it, a session is dropped once its decode is done.
+	const S64 DECODE_SESSION_BUDGET = 64 * 1024 * 1024;
+	std::atomic<S64> sDecodeSessionBytes(0);
+
+	// Fingerprint of a whole codestream, so a session is only reused for
+	// exactly the bytes it was opened on. Hashes eight bytes per step; that
+	// is noise next to the decode it guards.
+	U64 fingerprint_data(const U8* data, S32 size)
+	{
+		const U64 prime = 0x100000001b3ull;
+		U64 hash = 0xcbf29ce484222325ull ^ (U64)size;
+		S32 i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			U64 word;
+			memcpy(&word, data + i, sizeof(word));
+			hash = (hash ^ word) * prime;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; ++i)
+		{
+			hash = (hash ^ data[i]) * prime;
+		}
+		return hash;
+	}
+}
+
+#ifdef OPENJPEG2
+// OpenJPEG 2.3 keeps the compressed tile data of single tile images in the codec,
+// so opj_decode() can be run again at another resolution without rereading the stream.
+#if OPJ_VERSION_MAJOR > 2 || (OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 3)
+#define LL_OPJ_REDECODE 1
+#endif
+
+struct LLImageJ2COJ::DecodeSession
+{
+	DecodeSession(LLImageJ2C* image)
+		: mReader(image)
+		, mCodec(NULL)
+		, mStream(NULL)
+		, mImage(NULL)
+		, mDataSize(0)
+		, mFingerprint(0)
+		, mSingleTile(false)
+		, mDecodedReduce(-1)
+		, mRetainedBytes(0)
+	{
+	}
+
+	~DecodeSession()
+	{
+		setRetainedBytes(0);
+		if (mImage)
+		{
+			opj_image_destroy(mImage);
+		}
+		if (mStream)
+		{
+			if (mCodec && mDecodedReduce >= 0)
+			{
+				opj_end_decompress(mCodec, mStream);
+			}
+			opj_stream_destroy(mStream);
+		}
+		if (mCodec)
+		{
+			opj_destroy_codec(mCodec);
+		}
+	}
+
+	void setRetainedBytes(S64 bytes)
+	{
+		sDecodeSessionBytes += bytes - mRetainedBytes;
+		mRetainedBytes = bytes;
+	}
+
+	LLJp2StreamReader mReader;
+	opj_codec_t* mCodec;
+	opj_stream_t* mStream;
+	opj_image_t* mImage;	// Header image, refilled by every opj_decode()
+	S32 mDataSize;
+	U64 mFingerprint;
+	bool mSingleTile;
+	S32 mDecodedReduce;		// Reduce factor mImage holds, -1 before the first decode
+	S64 mRetainedBytes;
+};
+
+LLImageJ2COJ::DecodeSession* LLImageJ2COJ::acquireDecodeSession(LLImageJ2C &base)
+{
+	const S32 data_size = base.getDataSize();
+	const U64 fingerprint = fingerprint_data(base.getData(), data_size);
+	if (mDecodeSession)
+	{
+		if (mDecodeSession->mDataSize == data_size && mDecodeSession->mFingerprint == fingerprint)
+		{
+			return mDecodeSession;
+		}
+		// More bytes arrived: OpenJPEG can't resume a codestream it already consumed
+		releaseDecodeSession();
+	}
+
+	DecodeSession* session = new DecodeSession(&base);
+	session->mDataSize = data_size;
+	session->mFingerprint = fingerprint;
+
+	opj_dparameters_t parameters;
+	opj_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = base.getRawDiscardLevel();
+
+	session->mCodec = opj_create_decompress(OPJ_CODEC_J2K);
+	opj_set_error_handler(session->mCodec, error_callback, 0);
+	opj_set_warning_handler(session->mCodec, warning_callback, 0);
+	opj_set_info_handler(session->mCodec, info_callback, 0);
+	if (!opj_setup_decoder(session->mCodec, &parameters))
+	{
+		delete session;
+		return NULL;
+	}
+
+	/* allow multi-threading */
+	if (opj_has_thread_support())
+	{
+		opj_codec_set_threads(session->mCodec, opj_get_num_cpus());
+	}
+
+	session->mStream = opj_stream_default_create(OPJ_STREAM_READ);
+	opj_stream_set_read_function(session->mStream, LLJp2StreamReader::readStream);
+	opj_stream_set_skip_function(session->mStream, LLJp2StreamReader::skipStream);
+	opj_stream_set_seek_function(session->mStream, LLJp2StreamReader::seekStream);
+	opj_stream_set_user_data(session->mStream, &session->mReader, nullptr);
+	opj_stream_set_user_data_length(session->mStream, data_size);
+
+	if (!opj_read_header(session->mStream, session->mCodec, &session->mImage))
+	{
+		delete session;
+		return NULL;
+	}
+
+#ifdef LL_OPJ_REDECODE
+	opj_codestream_info_v2_t* info = opj_get_cstr_info(session->mCodec);
+	if (info)
+	{
+		session->mSingleTile = (info->tw == 1 && info->th == 1);
+		opj_destroy_cstr_info(&info);
+	}
+#endif
+
+	mDecodeSession = session;
+	return session;
+}
+#else
+struct LLImageJ2COJ::DecodeSession
+{
+};
+
+LLImageJ2COJ::DecodeSession* LLImageJ2COJ::acquireDecodeSession(LLImageJ2C &base)
+{
+	return NULL;
+}
+#endif
+
+void LLImageJ2COJ::releaseDecodeSession()
+{
+	delete mDecodeSession;
+	mDecodeSession = NULL;
+}
+// </FS>
+
 LLImageJ2COJ::LLImageJ2COJ()
 	: LLImageJ2CImpl()
+	, mDecodeSession(NULL) // <FS/> Progressive decode
 {
 }
 
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
+	releaseDecodeSession(); // <FS/> Progressive decode
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
@@ -321,6 +497,22 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
 	parameters.cp_reduce = base.getRawDiscardLevel();
 
+	// <FS> Progressive decode: image may belong to the decode session
+	bool image_retained = false;
+	auto free_image = [&]()
+	{
+		if (image_retained)
+		{
+			releaseDecodeSession();
+		}
+		else if (image)
+		{
+			opj_image_destroy(image);
+		}
+		image = NULL;
+	};
+	// </FS>
+
 	/* decode the code-stream */
 	/* ---------------------- */
 
@@ -328,42 +520,61 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
 #ifdef OPENJPEG2
 // [SL:KB] - Patch: Viewer-OpenJPEG2 | Checked: Catznip-5.3
-	/* get a decoder handle */
-	opj_codec_t* opj_decoder_p = opj_create_decompress(OPJ_CODEC_J2K);
-
-	/* catch events using our callbacks and give a local context */
-	opj_set_error_handler(opj_decoder_p, error_callback, 0);
-	opj_set_warning_handler(opj_decoder_p, warning_callback, 0);
-	opj_set_info_handler(opj_decoder_p, info_callback, 0);
-
-	/* setup the decoder decoding parameters using user parameters */
-	opj_setup_decoder(opj_decoder_p, &parameters);
-
-	/* allow multi-threading */
-	if (opj_has_thread_support())
+	// <FS> Progressive decode: reuse the codec and tile data of this texture while its bytes are unchanged
+	//opj_codec_t* opj_decoder_p = opj_create_decompress(OPJ_CODEC_J2K);
+	//...
+	//bool fSuccess = opj_read_header(opj_stream_p, opj_decoder_p, &image) &&
+	//                opj_decode(opj_decoder_p, opj_stream_p, image) &&
+	//				opj_end_decompress(opj_decoder_p, opj_stream_p);
+	const S32 reduce = base.getRawDiscardLevel();
+	bool fSuccess = false;
+	DecodeSession* session = acquireDecodeSession(base);
+	if (session && session->mDecodedReduce >= 0 && session->mDecodedReduce != reduce && !session->mSingleTile)
 	{
-		opj_codec_set_threads(opj_decoder_p, opj_get_num_cpus());
+		// The codec dropped the tile data after the first decode, start over at the new level
+		releaseDecodeSession();
+		session = acquireDecodeSession(base);
 	}
 
-	/* open a byte stream */
-	LLJp2StreamReader streamReader(&base);
-	opj_stream_t* opj_stream_p = opj_stream_default_create(OPJ_STREAM_READ);
-	opj_stream_set_read_function(opj_stream_p, LLJp2StreamReader::readStream);
-	opj_stream_set_skip_function(opj_stream_p, LLJp2StreamReader::skipStream);
-	opj_stream_set_seek_function(opj_stream_p, LLJp2StreamReader::seekStream);
-	opj_stream_set_user_data(opj_stream_p, &streamReader, nullptr);
-	opj_stream_set_user_data_length(opj_stream_p, base.getDataSize());
-
-	/* decode the stream and fill the image structure */
-	bool fSuccess = opj_read_header(opj_stream_p, opj_decoder_p, &image) &&
-	                opj_decode(opj_decoder_p, opj_stream_p, image) &&
-					opj_end_decompress(opj_decoder_p, opj_stream_p);
-
-	/* close the byte stream */
-	opj_stream_destroy(opj_stream_p);
+	if (session)
+	{
+		if (session->mDecodedReduce == reduce)
+		{
+			// Same bytes at the same level (e.g. the aux channel pass): already decoded
+			fSuccess = true;
+		}
+		else if (session->mDecodedReduce < 0)
+		{
+			fSuccess = opj_decode(session->mCodec, session->mStream, session->mImage);
+		}
+#ifdef LL_OPJ_REDECODE
+		else
+		{
+			fSuccess = opj_set_decoded_resolution_factor(session->mCodec, reduce) &&
+			           opj_set_decode_area(session->mCodec, session->mImage, 0, 0, 0, 0) &&
+			           opj_decode(session->mCodec, session->mStream, session->mImage);
+			if (!fSuccess)
+			{
+				LL_DEBUGS("Texture") << "Re-decode at discard " << reduce << " failed, decoding from scratch" << LL_ENDL;
+				releaseDecodeSession();
+				session = acquireDecodeSession(base);
+				fSuccess = session && opj_decode(session->mCodec, session->mStream, session->mImage);
+			}
+		}
+#endif
+	}
 
-	/* free remaining structures */
-	opj_destroy_codec(opj_decoder_p);
+	if (fSuccess)
+	{
+		session->mDecodedReduce = reduce;
+		image = session->mImage;
+		image_retained = true;
+	}
+	else
+	{
+		releaseDecodeSession();
+	}
+	// </FS>
 #else
 	/* get a decoder handle */
 	dinfo = opj_create_decompress(CODEC_J2K);
@@ -403,10 +614,13 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 // [/SL:KB]
 	{
 		LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image!" << LL_ENDL;
-		if (image)
-		{
-			opj_image_destroy(image);
-		}
+		// <FS> Progressive decode
+		//if (image)
+		//{
+		//	opj_image_destroy(image);
+		//}
+		free_image();
+		// </FS>
 
 // [SL:KB] - Patch: Viewer-OpenJPEG2 | Checked: Catznip-5.3
 		base.decodeFailed();
@@ -433,10 +647,13 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	if(image->numcomps <= first_channel)
 	{
 		LL_WARNS() << "trying to decode more channels than are present in image: numcomps: " << image->numcomps << " first_channel: " << first_channel << LL_ENDL;
-		if (image)
-		{
-			opj_image_destroy(image);
-		}
+		// <FS> Progressive decode
+		//if (image)
+		//{
+		//	opj_image_destroy(image);
+		//}
+		free_image();
+		// </FS>
 
 // [SN:SG] - Patch: Import-MiscOpenJPEG
 		base.decodeFailed();
@@ -471,7 +688,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	{
 		base.setLastError("Memory error");
 		base.decodeFailed();
-		opj_image_destroy(image);
+		free_image(); // <FS/> Progressive decode
 		return true; // done
 	}
 	// <FS:Ansariel>
@@ -497,7 +714,7 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 		else // Some rare OpenJPEG versions have this bug.
 		{
 			LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image! (NULL comp data - OpenJPEG bug)" << LL_ENDL;
-			opj_image_destroy(image);
+			free_image(); // <FS/> Progressive decode
 
 // [SN:SG] - Patch: Import-MiscOpenJPEG
 			base.decodeFailed();
@@ -507,7 +724,32 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	}
 
 	/* free image data structure */
-	opj_image_destroy(image);
+	// <FS> Progressive decode: keep the session while a later pass can reuse it
+	//opj_image_destroy(image);
+	if (image_retained)
+	{
+		S64 retained_bytes = base.getDataSize();
+		for (U32 comp = 0; comp < image->numcomps; ++comp)
+		{
+			retained_bytes += (S64)image->comps[comp].w * image->comps[comp].h * sizeof(OPJ_INT32);
+		}
+
+		// Nothing left to refine once full resolution is out and the last channels were copied
+		bool last_pass = (f == 0) && (first_channel + channels >= img_components);
+		if (last_pass || (sDecodeSessionBytes + retained_bytes - mDecodeSession->mRetainedBytes > DECODE_SESSION_BUDGET))
+		{
+			releaseDecodeSession();
+		}
+		else
+		{
+			mDecodeSession->setRetainedBytes(retained_bytes);
+		}
+	}
+	else
+	{
+		opj_image_destroy(image);
+	}
+	// </FS>
 
 	return true; // done
 }
@@ -42,6 +42,16 @@ protected:
 	virtual bool initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level = -1, int* region = NULL);
 	virtual bool initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size = -1, int precincts_size = -1, int levels = 0);
     virtual std::string getEngineInfo() const;
+
+	// <FS> Progressive decode: the codec, parsed header and last decoded image
+	// of this texture are kept between decodes of the same bytes, so the aux
+	// channel pass and discard level changes don't restart from scratch.
+	struct DecodeSession;
+	DecodeSession* acquireDecodeSession(LLImageJ2C &base);
+	void releaseDecodeSession();
+
+	DecodeSession* mDecodeSession;
+	// </FS>
 };
 
 #endif
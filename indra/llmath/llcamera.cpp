@@ -296,6 +296,73 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
 	return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+// <FS> SoA frustum culling
+void LLCamera::AABBInFrustum4(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes)
+{
+	AABBInFrustumLanes(center, radius, res, planes, false);
+}
+
+void LLCamera::AABBInFrustumNoFarClip4(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes)
+{
+	AABBInFrustumLanes(center, radius, res, planes, true);
+}
+
+//same plane tests as AABBInFrustum(...), with one box per vector lane
+//instead of x, y and z per lane.
+void LLCamera::AABBInFrustumLanes(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes, bool no_far_clip)
+{
+	if(!planes)
+	{
+		//use agent space
+		planes = mAgentPlanes;
+	}
+
+	U32 outside = 0;
+	U32 partial = 0;
+	LLVector4a normal, scaler, rscale, minp, maxp, min_dot, max_dot, d;
+	U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);		// mAgentPlanes[] size is 7
+	for (U32 i = 0; i < max_planes && outside != 0xf; i++)
+	{
+		U8 mask = mPlaneMask[i];
+		if ((no_far_clip && i == 5) || mask >= PLANE_MASK_NUM)
+		{
+			continue;
+		}
+
+		const LLPlane& p(planes[i]);
+		for (U32 j = 0; j < 3; j++)
+		{
+			normal.splat(p[j]);
+			scaler.splat(sFrustumScaler[mask][j]);
+			rscale.setMul(radius[j], scaler);
+			minp.setSub(center[j], rscale);
+			maxp.setAdd(center[j], rscale);
+			minp.mul(normal);
+			maxp.mul(normal);
+			if (j == 0)
+			{
+				min_dot = minp;
+				max_dot = maxp;
+			}
+			else
+			{
+				min_dot.add(minp);
+				max_dot.add(maxp);
+			}
+		}
+
+		d.splat(-p[3]);
+		outside |= min_dot.greaterThan(d).getGatheredBits();
+		partial |= max_dot.greaterThan(d).getGatheredBits();
+	}
+
+	for (U32 i = 0; i < 4; i++)
+	{
+		res[i] = (outside & (1 << i)) ? 0 : ((partial & (1 << i)) ? 1 : 2);
+	}
+}
+// </FS>
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius) 
 {
 	LLVector3 dist = sphere_center-mFrustCenter;
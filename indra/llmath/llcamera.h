@@ -208,6 +208,13 @@ public:
 	S32 AABBInRegionFrustum(const LLVector4a& center, const LLVector4a& radius);
 	S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
 	S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
+	// <FS> SoA frustum culling
+	// AABBInFrustum() and AABBInFrustumNoFarClip() for four boxes at once.
+	// center[0] holds the x of the four centers, center[1] the y and
+	// center[2] the z, radius likewise. Writes the four results to res.
+	void AABBInFrustum4(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes = NULL);
+	void AABBInFrustumNoFarClip4(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes = NULL);
+	// </FS>
 
 	//does a quick 'n dirty sphere-sphere check
 	S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius); 
@@ -228,6 +235,7 @@ protected:
 	void calculateFrustumPlanes(F32 left, F32 right, F32 top, F32 bottom);
 	void calculateFrustumPlanesFromWindow(F32 x1, F32 y1, F32 x2, F32 y2);
 	void calculateWorldFrustumPlanes();
+	void AABBInFrustumLanes(const LLVector4a* center, const LLVector4a* radius, S32* res, const LLPlane* planes, bool no_far_clip); // <FS/> SoA frustum culling
 } LL_ALIGN_POSTFIX(16);
 
 
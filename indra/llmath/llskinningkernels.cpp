@@ -0,0 +1,117 @@
+/**
+ * @file llskinningkernels.cpp
+ * @brief Vertex kernels for CPU skinning of rigged meshes.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llskinningkernels.h"
+
+namespace
+{
+	// res += w * (position transformed by m), the position splatted to x, y and z
+	LL_FORCE_INLINE void add_joint(const LLMatrix4a& m, const LLVector4a& x, const LLVector4a& y, const LLVector4a& z,
+								   const LLVector4a& w, LLVector4a& res)
+	{
+		LLVector4a p, t;
+		p.setMul(x, m.mMatrix[0]);
+		t.setMul(y, m.mMatrix[1]);
+		p.add(t);
+		t.setMul(z, m.mMatrix[2]);
+		t.add(m.mMatrix[3]);
+		p.add(t);
+		p.mul(w);
+		res.add(p);
+	}
+}
+
+// static
+void LLSkinningKernels::applyBindShapeMatrix(LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape)
+{
+	for (U32 i = 0; i < count; ++i)
+	{
+		matMul(bind_shape, mat[i], mat[i]);
+	}
+}
+
+// static
+void LLSkinningKernels::skinPositions(const LLVector4a* positions, const LLVector4a* weights, U32 count,
+									  const LLMatrix4a* mat, U32 joint_count,
+									  LLVector4a* out, LLVector4a* extents)
+{
+	if (!count)
+	{
+		return;
+	}
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max_index = _mm_set1_epi32((S32)joint_count - 1);
+
+	LLVector4a min, max;
+	min.splat(F32_MAX);
+	max.splat(-F32_MAX);
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		// Indices are small and positive, so the 16 bit min and max clamp
+		// them as well as 32 bit ones would.
+		const __m128 packed = weights[i];
+		__m128i index = _mm_cvttps_epi32(packed);
+		LLVector4a weight = _mm_sub_ps(packed, _mm_cvtepi32_ps(index));
+		index = _mm_max_epi16(_mm_min_epi16(index, max_index), zero);
+		LL_ALIGN_16(S32 joint[4]);
+		_mm_store_si128((__m128i*)joint, index);
+
+		LLVector4a scale = _mm_add_ps(weight, _mm_movehl_ps(weight, weight));
+		scale = _mm_add_ss(scale, _mm_shuffle_ps(scale, scale, 1));
+		scale = _mm_shuffle_ps(scale, scale, 0);
+		weight.div(scale);
+
+		// Transform by each joint and blend the results, which is the same
+		// as transforming by the blended matrix.
+		const LLVector4a& v = positions[i];
+		const LLVector4a x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+		const LLVector4a y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+		const LLVector4a z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+
+		LLVector4a w0, w1, w2, w3;
+		w0.splat<0>(weight);
+		w1.splat<1>(weight);
+		w2.splat<2>(weight);
+		w3.splat<3>(weight);
+
+		LLVector4a res;
+		res.clear();
+		add_joint(mat[joint[0]], x, y, z, w0, res);
+		add_joint(mat[joint[1]], x, y, z, w1, res);
+		add_joint(mat[joint[2]], x, y, z, w2, res);
+		add_joint(mat[joint[3]], x, y, z, w3, res);
+
+		out[i] = res;
+		min.setMin(min, res);
+		max.setMax(max, res);
+	}
+
+	extents[0] = min;
+	extents[1] = max;
+}
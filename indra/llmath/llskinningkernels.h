@@ -0,0 +1,57 @@
+/**
+ * @file llskinningkernels.h
+ * @brief Vertex kernels for CPU skinning of rigged meshes.
+ *
+ * @Description:
+ * CPU skinning used to blend four joint matrices per vertex and then run
+ * the position through the bind shape matrix and the blended matrix. Here
+ * the bind shape matrix is folded into the joint matrices once per palette,
+ * and each vertex is transformed by its four joints and blended, in one pass
+ * over the streams that also collects the extents.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSKINNINGKERNELS_H
+#define LL_LLSKINNINGKERNELS_H
+
+#include "llmath.h"
+#include "llmatrix4a.h"
+
+class LLSkinningKernels
+{
+public:
+	// Makes each of the count palette matrices apply bind_shape first.
+	static void applyBindShapeMatrix(LLMatrix4a* mat, U32 count, const LLMatrix4a& bind_shape);
+
+	// Skins count positions into out. weights are packed as in
+	// LLVolumeFace::mWeights: joint index in the integer part, weight in the
+	// fraction. Joint indices are clamped to joint_count - 1, which must be
+	// at least 0. mat is the palette after applyBindShapeMatrix(). Sets
+	// extents to the bounds of the skinned positions if count is not 0.
+	static void skinPositions(const LLVector4a* positions, const LLVector4a* weights, U32 count,
+							  const LLMatrix4a* mat, U32 joint_count,
+							  LLVector4a* out, LLVector4a* extents);
+};
+
+#endif // LL_LLSKINNINGKERNELS_H
@@ -2781,6 +2781,244 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 }
 
 
+// <FS> Decoded mesh cache
+namespace
+{
+	const U32 OPTIMIZED_FACES_MAGIC = 0x464d5346; // "FSMF"
+
+	enum
+	{
+		OPTIMIZED_FACE_HAS_WEIGHTS = 0x1,
+		OPTIMIZED_FACE_HAS_TANGENTS = 0x2,
+		OPTIMIZED_FACE_OPTIMIZED = 0x4
+	};
+
+	struct OptimizedFacesHeader
+	{
+		U32 mMagic;
+		U32 mVersion;
+		U32 mFaceCount;
+		U32 mPad;
+	};
+
+	// Plain floats so the header can be copied in and out of the buffer
+	// with memcpy, LLVector4a and LLVector2 are not trivially copyable.
+	struct OptimizedFaceHeader
+	{
+		F32 mExtents[2][4];
+		F32 mTexCoordExtents[2][2];
+		S32 mNumVertices;
+		S32 mNumIndices;
+		U32 mFlags;
+		U32 mPad;
+	};
+
+	inline size_t align16(size_t size)
+	{
+		return (size + 0xF) & ~(size_t)0xF;
+	}
+
+	// Same layout as LLVolumeFace::resizeVertices(): positions, normals, then padded texcoords
+	inline size_t vertex_block_size(S32 num_verts)
+	{
+		return sizeof(LLVector4a) * 2 * num_verts + align16(num_verts * sizeof(LLVector2));
+	}
+}
+
+bool LLVolume::packOptimizedFaces(std::vector<U8>& out) const
+{
+	out.clear();
+	if (mVolumeFaces.empty())
+	{
+		return false;
+	}
+
+	size_t total = sizeof(OptimizedFacesHeader);
+	for (const LLVolumeFace& face : mVolumeFaces)
+	{
+		if (face.mNumVertices > 0 && !face.mPositions)
+		{
+			return false;
+		}
+		total += sizeof(OptimizedFaceHeader) + vertex_block_size(face.mNumVertices) + align16(face.mNumIndices * sizeof(U16));
+		if (face.mWeights)
+		{
+			total += sizeof(LLVector4a) * face.mNumVertices;
+		}
+		if (face.mTangents)
+		{
+			total += sizeof(LLVector4a) * face.mNumVertices;
+		}
+	}
+
+	out.resize(total, 0);
+	U8* dst = out.data();
+
+	OptimizedFacesHeader* header = (OptimizedFacesHeader*)dst;
+	header->mMagic = OPTIMIZED_FACES_MAGIC;
+	header->mVersion = OPTIMIZED_FACES_VERSION;
+	header->mFaceCount = (U32)mVolumeFaces.size();
+	dst += sizeof(OptimizedFacesHeader);
+
+	for (const LLVolumeFace& face : mVolumeFaces)
+	{
+		OptimizedFaceHeader face_header = {};
+		for (S32 i = 0; i < 2; ++i)
+		{
+			memcpy(face_header.mExtents[i], face.mExtents[i].getF32ptr(), sizeof(face_header.mExtents[i]));
+			face_header.mTexCoordExtents[i][0] = face.mTexCoordExtents[i].mV[VX];
+			face_header.mTexCoordExtents[i][1] = face.mTexCoordExtents[i].mV[VY];
+		}
+		face_header.mNumVertices = face.mNumVertices;
+		face_header.mNumIndices = face.mNumIndices;
+		face_header.mFlags = (face.mWeights ? OPTIMIZED_FACE_HAS_WEIGHTS : 0) |
+							 (face.mTangents ? OPTIMIZED_FACE_HAS_TANGENTS : 0) |
+							 (face.mOptimized ? OPTIMIZED_FACE_OPTIMIZED : 0);
+		memcpy(dst, &face_header, sizeof(OptimizedFaceHeader));
+		dst += sizeof(OptimizedFaceHeader);
+
+		// The texcoord padding may be uninitialized in the face, only copy what is used
+		memcpy(dst, face.mPositions, sizeof(LLVector4a) * 2 * face.mNumVertices + sizeof(LLVector2) * face.mNumVertices);
+		dst += vertex_block_size(face.mNumVertices);
+
+		memcpy(dst, face.mIndices, sizeof(U16) * face.mNumIndices);
+		dst += align16(face.mNumIndices * sizeof(U16));
+
+		if (face.mWeights)
+		{
+			memcpy(dst, face.mWeights, sizeof(LLVector4a) * face.mNumVertices);
+			dst += sizeof(LLVector4a) * face.mNumVertices;
+		}
+		if (face.mTangents)
+		{
+			memcpy(dst, face.mTangents, sizeof(LLVector4a) * face.mNumVertices);
+			dst += sizeof(LLVector4a) * face.mNumVertices;
+		}
+	}
+
+	llassert(dst == out.data() + out.size());
+	return true;
+}
+
+bool LLVolume::unpackOptimizedFaces(const U8* data, size_t size)
+{
+	if (!data || size < sizeof(OptimizedFacesHeader) || ((uintptr_t)data & 0xF))
+	{
+		return false;
+	}
+
+	OptimizedFacesHeader header;
+	memcpy(&header, data, sizeof(OptimizedFacesHeader));
+	if (header.mMagic != OPTIMIZED_FACES_MAGIC || header.mVersion != OPTIMIZED_FACES_VERSION || header.mFaceCount == 0 ||
+		header.mFaceCount > (size - sizeof(OptimizedFacesHeader)) / sizeof(OptimizedFaceHeader))
+	{
+		return false;
+	}
+
+	const U8* src = data + sizeof(OptimizedFacesHeader);
+	const U8* end = data + size;
+
+	std::vector<LLVolumeFace> faces(header.mFaceCount);
+	for (LLVolumeFace& face : faces)
+	{
+		if ((size_t)(end - src) < sizeof(OptimizedFaceHeader))
+		{
+			return false;
+		}
+		OptimizedFaceHeader face_header;
+		memcpy(&face_header, src, sizeof(OptimizedFaceHeader));
+		src += sizeof(OptimizedFaceHeader);
+
+		const S32 num_verts = face_header.mNumVertices;
+		const S32 num_indices = face_header.mNumIndices;
+		if (num_verts < 0 || num_verts > 65536 || num_indices < 0 || num_indices % 3)
+		{
+			return false;
+		}
+
+		const size_t vert_size = vertex_block_size(num_verts);
+		const size_t index_size = align16(num_indices * sizeof(U16));
+		const size_t extra_size = sizeof(LLVector4a) * num_verts;
+		size_t needed = vert_size + index_size;
+		if (face_header.mFlags & OPTIMIZED_FACE_HAS_WEIGHTS)
+		{
+			needed += extra_size;
+		}
+		if (face_header.mFlags & OPTIMIZED_FACE_HAS_TANGENTS)
+		{
+			needed += extra_size;
+		}
+		if ((size_t)(end - src) < needed)
+		{
+			return false;
+		}
+
+		face.resizeVertices(num_verts);
+		face.resizeIndices(num_indices);
+		if ((num_verts && !face.mPositions) || (num_indices && !face.mIndices))
+		{
+			LL_WARNS() << "Out of memory unpacking cached mesh faces" << LL_ENDL;
+			return false;
+		}
+
+		if (num_verts)
+		{
+			LLVector4a::memcpyNonAliased16((F32*)face.mPositions, (const F32*)src, vert_size);
+		}
+		src += vert_size;
+
+		const U16* indices = (const U16*)src;
+		for (S32 i = 0; i < num_indices; ++i)
+		{
+			if (indices[i] >= num_verts)
+			{
+				return false;
+			}
+		}
+		memcpy(face.mIndices, indices, sizeof(U16) * num_indices);
+		src += index_size;
+
+		if (face_header.mFlags & OPTIMIZED_FACE_HAS_WEIGHTS)
+		{
+			face.allocateWeights(num_verts);
+			if (num_verts && !face.mWeights)
+			{
+				return false;
+			}
+			LLVector4a::memcpyNonAliased16((F32*)face.mWeights, (const F32*)src, extra_size);
+			src += extra_size;
+		}
+		if (face_header.mFlags & OPTIMIZED_FACE_HAS_TANGENTS)
+		{
+			face.allocateTangents(num_verts);
+			if (num_verts && !face.mTangents)
+			{
+				return false;
+			}
+			LLVector4a::memcpyNonAliased16((F32*)face.mTangents, (const F32*)src, extra_size);
+			src += extra_size;
+		}
+
+		for (S32 i = 0; i < 2; ++i)
+		{
+			face.mExtents[i].loadua(face_header.mExtents[i]);
+			face.mTexCoordExtents[i].set(face_header.mTexCoordExtents[i][0], face_header.mTexCoordExtents[i][1]);
+		}
+		face.mOptimized = (face_header.mFlags & OPTIMIZED_FACE_OPTIMIZED) ? TRUE : FALSE;
+	}
+
+	if (src != end)
+	{
+		return false;
+	}
+
+	mVolumeFaces.swap(faces);
+	mSculptLevel = 0;  // success!
+
+	return true;
+}
+// </FS>
+
 BOOL LLVolume::isMeshAssetLoaded()
 {
 	return mIsMeshAssetLoaded;
@@ -1121,6 +1121,15 @@ private:
 
 public:
 // </FS:Beq pp Rye>
+	// <FS> Decoded mesh cache
+	// Raw dump of the unpacked and cache optimized faces, so a later load
+	// can skip zlib, LLSD parsing and optimization. Sections in the blob are
+	// 16 byte aligned; the format is only meant for a local cache and is
+	// tied to OPTIMIZED_FACES_VERSION and the endianness of the machine.
+	static const U32 OPTIMIZED_FACES_VERSION = 1;
+	bool packOptimizedFaces(std::vector<U8>& out) const;
+	bool unpackOptimizedFaces(const U8* data, size_t size);
+	// </FS>
 	virtual void setMeshAssetLoaded(BOOL loaded);
 	virtual BOOL isMeshAssetLoaded();
 
@@ -0,0 +1,248 @@
+/**
+ * @file   llcamera_test.cpp
+ * @brief  Test for the four box frustum checks of llcamera.cpp, with a culling benchmark.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llcamera.h"
+
+#include <random>
+
+#include "../llvector4a.h"
+#include "../../llcommon/lltimer.h"
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct llcamera_data
+	{
+		llcamera_data()
+		{
+			// Looking down +x from the origin, 90 degrees wide, 10 to 100 out
+			LLVector3 frust[8];
+			const F32 distances[2] = { 10.f, 100.f };
+			for (U32 i = 0; i < 2; i++)
+			{
+				const F32 d = distances[i];
+				frust[i * 4 + 0].set(d,  d, -d);
+				frust[i * 4 + 1].set(d, -d, -d);
+				frust[i * 4 + 2].set(d, -d,  d);
+				frust[i * 4 + 3].set(d,  d,  d);
+			}
+			mCamera.calcAgentFrustumPlanes(frust);
+		}
+
+		// Deterministic boxes around the frustum, so failures reproduce
+		void makeBoxes(U32 count, std::vector<LLVector4a>& centers, std::vector<LLVector4a>& radii)
+		{
+			std::mt19937 random(1);
+			std::uniform_real_distribution<F32> position(-150.f, 150.f);
+			std::uniform_real_distribution<F32> size(0.f, 40.f);
+			for (U32 i = 0; i < count; i++)
+			{
+				centers.push_back(LLVector4a(position(random), position(random), position(random)));
+				radii.push_back(LLVector4a(size(random), size(random), size(random)));
+			}
+		}
+
+		// Boxes i to i + 3 with one box per lane
+		static void toLanes(const std::vector<LLVector4a>& boxes, U32 i, LLVector4a* lanes)
+		{
+			for (U32 j = 0; j < 3; j++)
+			{
+				lanes[j].set(boxes[i][j], boxes[i + 1][j], boxes[i + 2][j], boxes[i + 3][j]);
+			}
+		}
+
+		LLCamera mCamera;
+	};
+	typedef test_group<llcamera_data> llcamera_test;
+	typedef llcamera_test::object llcamera_object;
+	tut::llcamera_test llcamera("LLCamera");
+
+	template<> template<>
+	void llcamera_object::test<1>()
+	{
+		set_test_name("four box checks match the single box checks");
+
+		std::vector<LLVector4a> centers, radii;
+		makeBoxes(40000, centers, radii);
+
+		U32 counts[3] = { 0, 0, 0 };
+		for (U32 i = 0; i < centers.size(); i += 4)
+		{
+			LL_ALIGN_16(LLVector4a center[3]);
+			LL_ALIGN_16(LLVector4a radius[3]);
+			toLanes(centers, i, center);
+			toLanes(radii, i, radius);
+
+			S32 res[4], res_no_far_clip[4];
+			mCamera.AABBInFrustum4(center, radius, res);
+			mCamera.AABBInFrustumNoFarClip4(center, radius, res_no_far_clip);
+			for (U32 j = 0; j < 4; j++)
+			{
+				ensure_equals("AABBInFrustum4", res[j], mCamera.AABBInFrustum(centers[i + j], radii[i + j]));
+				ensure_equals("AABBInFrustumNoFarClip4", res_no_far_clip[j],
+							  mCamera.AABBInFrustumNoFarClip(centers[i + j], radii[i + j]));
+				counts[res[j]]++;
+			}
+		}
+
+		ensure("some boxes outside", counts[0] > 0);
+		ensure("some boxes partly inside", counts[1] > 0);
+		ensure("some boxes inside", counts[2] > 0);
+	}
+
+	// Octree stand in with the nodes spread over the heap, as LLOctreeNode
+	// and its listeners are
+	struct CullNode
+	{
+		LL_ALIGN_16(LLVector4a mBounds[2]);
+		// mBounds of the children, laid out as LLViewerOctreeGroup keeps them
+		LL_ALIGN_16(LLVector4a mChildBounds[2][2][3]);
+		std::vector<CullNode*> mChildren;
+	};
+
+	// Frustum checks the way LLViewerOctreeCull walks the tree, returns
+	// the number of nodes that are at least partly inside
+	U32 cull_one_by_one(LLCamera& camera, const CullNode* node, S32 res)
+	{
+		U32 visible = 0;
+		for (const CullNode* child : node->mChildren)
+		{
+			S32 child_res = res == 2 ? 2 : camera.AABBInFrustumNoFarClip(child->mBounds[0], child->mBounds[1]);
+			if (child_res)
+			{
+				visible += 1 + cull_one_by_one(camera, child, child_res);
+			}
+		}
+		return visible;
+	}
+
+	U32 cull_four_at_once(LLCamera& camera, const CullNode* node, S32 res)
+	{
+		S32 child_res[8] = { 2, 2, 2, 2, 2, 2, 2, 2 };
+		const U32 count = (U32)node->mChildren.size();
+		if (res != 2)
+		{
+			for (U32 i = 0; i < count; i += 4)
+			{
+				camera.AABBInFrustumNoFarClip4(node->mChildBounds[i / 4][0], node->mChildBounds[i / 4][1], child_res + i);
+			}
+		}
+
+		U32 visible = 0;
+		for (U32 i = 0; i < count; i++)
+		{
+			if (child_res[i])
+			{
+				visible += 1 + cull_four_at_once(camera, node->mChildren[i], child_res[i]);
+			}
+		}
+		return visible;
+	}
+
+	template<> template<>
+	void llcamera_object::test<2>()
+	{
+		set_test_name("benchmark culling a 100k node octree");
+
+		const U32 NODE_COUNT = 100000;
+		std::mt19937 random(2);
+		std::vector<CullNode*> nodes;
+		nodes.reserve(NODE_COUNT);
+		// Padding between the nodes, so the walk misses the cache as it does
+		// in the viewer
+		std::vector<char*> padding;
+		std::uniform_int_distribution<U32> pad(64, 1024);
+
+		CullNode* root = new CullNode;
+		root->mBounds[0].set(50.f, 0.f, 0.f);
+		root->mBounds[1].set(256.f, 256.f, 256.f);
+		nodes.push_back(root);
+		for (U32 parent = 0; nodes.size() < NODE_COUNT; parent++)
+		{
+			CullNode* node = nodes[parent];
+			for (U32 octant = 0; octant < 8 && nodes.size() < NODE_COUNT; octant++)
+			{
+				padding.push_back(new char[pad(random)]);
+				CullNode* child = new CullNode;
+				LLVector4a offset((octant & 1) ? 0.5f : -0.5f, (octant & 2) ? 0.5f : -0.5f, (octant & 4) ? 0.5f : -0.5f);
+				offset.mul(node->mBounds[1]);
+				child->mBounds[0].setAdd(node->mBounds[0], offset);
+				child->mBounds[1].setMul(node->mBounds[1], 0.5f);
+				node->mChildren.push_back(child);
+				nodes.push_back(child);
+			}
+		}
+		for (CullNode* node : nodes)
+		{
+			for (U32 i = 0; i < node->mChildren.size(); i++)
+			{
+				for (U32 j = 0; j < 2; j++)
+				{
+					for (U32 k = 0; k < 3; k++)
+					{
+						node->mChildBounds[i / 4][j][k].getF32ptr()[i % 4] = node->mChildren[i]->mBounds[j][k];
+					}
+				}
+			}
+		}
+
+		const U32 ROUNDS = 20;
+		LLTimer timer;
+		U32 visible_one_by_one = 0;
+		for (U32 i = 0; i < ROUNDS; i++)
+		{
+			visible_one_by_one = cull_one_by_one(mCamera, root, 1);
+		}
+		F64 one_by_one_time = timer.getElapsedTimeF64() / ROUNDS;
+
+		timer.reset();
+		U32 visible_four_at_once = 0;
+		for (U32 i = 0; i < ROUNDS; i++)
+		{
+			visible_four_at_once = cull_four_at_once(mCamera, root, 1);
+		}
+		F64 four_at_once_time = timer.getElapsedTimeF64() / ROUNDS;
+
+		ensure_equals("same nodes visible", visible_four_at_once, visible_one_by_one);
+		ensure("some nodes culled", visible_one_by_one + 1 < NODE_COUNT);
+
+		LL_INFOS("LLCamera") << NODE_COUNT << " nodes, " << visible_one_by_one << " visible: one by one "
+							 << one_by_one_time * 1000.0 << " ms, four at once "
+							 << four_at_once_time * 1000.0 << " ms" << LL_ENDL;
+
+		for (CullNode* node : nodes)
+		{
+			delete node;
+		}
+		for (char* pad_block : padding)
+		{
+			delete[] pad_block;
+		}
+	}
+}
@@ -0,0 +1,219 @@
+/**
+ * @file llskinningkernels_test.cpp
+ * @brief Tests and benchmark for the CPU skinning kernels.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llskinningkernels.h"
+
+#include <random>
+#include <vector>
+
+#include "../../llcommon/lltimer.h"
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct llskinningkernels_data
+	{
+		// Roughly a Bento skeleton and a detailed mesh body
+		static const U32 JOINT_COUNT = 110;
+		static const U32 VERTEX_COUNT = 50000;
+
+		// Deterministic palette, bind shape and vertices, so failures reproduce
+		llskinningkernels_data()
+		:	mRandom(1),
+			mPalette(JOINT_COUNT)
+		{
+			for (LLMatrix4a& m : mPalette)
+			{
+				makeAffine(m);
+			}
+			makeAffine(mBindShape);
+
+			std::uniform_real_distribution<F32> coord(-1.f, 1.f);
+			std::uniform_int_distribution<U32> joint(0, JOINT_COUNT - 1);
+			std::uniform_real_distribution<F32> weight(0.f, 0.999f);
+			for (U32 i = 0; i < VERTEX_COUNT; i++)
+			{
+				mPositions.push_back(LLVector4a(coord(mRandom), coord(mRandom), coord(mRandom), 1.f));
+
+				// Packed like LLVolumeFace::mWeights, some with unused slots
+				LLVector4a w;
+				for (U32 k = 0; k < 4; k++)
+				{
+					const F32 fraction = (k > 0 && (i + k) % 3 == 0) ? 0.f : weight(mRandom);
+					w.getF32ptr()[k] = (F32)joint(mRandom) + fraction;
+				}
+				if (w[0] - floorf(w[0]) == 0.f)
+				{
+					w.getF32ptr()[0] += 0.5f;
+				}
+				mWeights.push_back(w);
+			}
+		}
+
+		void makeAffine(LLMatrix4a& m)
+		{
+			std::uniform_real_distribution<F32> value(-2.f, 2.f);
+			for (U32 row = 0; row < 4; row++)
+			{
+				m.mMatrix[row].set(value(mRandom), value(mRandom), value(mRandom), row == 3 ? 1.f : 0.f);
+			}
+		}
+
+		// The way LLRiggedVolume::update() skinned before the kernels:
+		// blend the joint matrices, then transform by the bind shape matrix
+		// and the blended matrix.
+		void skinReference(LLVector4a* out)
+		{
+			for (U32 i = 0; i < VERTEX_COUNT; i++)
+			{
+				const F32* packed = mWeights[i].getF32ptr();
+				S32 joint[4];
+				F32 weight[4];
+				F32 scale = 0.f;
+				for (U32 k = 0; k < 4; k++)
+				{
+					joint[k] = llclamp((S32)floorf(packed[k]), 0, (S32)JOINT_COUNT - 1);
+					weight[k] = packed[k] - floorf(packed[k]);
+					scale += weight[k];
+				}
+
+				LLMatrix4a final_mat;
+				final_mat.clear();
+				for (U32 k = 0; k < 4; k++)
+				{
+					LLMatrix4a src;
+					src.setMul(mPalette[joint[k]], weight[k] / scale);
+					final_mat.add(src);
+				}
+
+				LLVector4a t;
+				mBindShape.affineTransform(mPositions[i], t);
+				final_mat.affineTransform(t, out[i]);
+			}
+		}
+
+		std::mt19937 mRandom;
+		std::vector<LLMatrix4a> mPalette;
+		LLMatrix4a mBindShape;
+		std::vector<LLVector4a> mPositions;
+		std::vector<LLVector4a> mWeights;
+	};
+	typedef test_group<llskinningkernels_data> llskinningkernels_test;
+	typedef llskinningkernels_test::object llskinningkernels_object;
+	tut::llskinningkernels_test llskinningkernels("LLSkinningKernels");
+
+	template<> template<>
+	void llskinningkernels_object::test<1>()
+	{
+		set_test_name("skinned positions and extents match the blended matrix path");
+
+		std::vector<LLVector4a> expected(VERTEX_COUNT);
+		skinReference(&expected[0]);
+
+		std::vector<LLMatrix4a> palette(mPalette);
+		LLSkinningKernels::applyBindShapeMatrix(&palette[0], JOINT_COUNT, mBindShape);
+		std::vector<LLVector4a> skinned(VERTEX_COUNT);
+		LLVector4a extents[2];
+		LLSkinningKernels::skinPositions(&mPositions[0], &mWeights[0], VERTEX_COUNT, &palette[0], JOINT_COUNT,
+										 &skinned[0], extents);
+
+		LLVector4a min, max;
+		min.splat(F32_MAX);
+		max.splat(-F32_MAX);
+		for (U32 i = 0; i < VERTEX_COUNT; i++)
+		{
+			for (U32 j = 0; j < 3; j++)
+			{
+				// Same math in another order, the values are up to about 50
+				ensure_approximately_equals_range("skinned position", skinned[i][j], expected[i][j], 1e-3f);
+			}
+			min.setMin(min, skinned[i]);
+			max.setMax(max, skinned[i]);
+		}
+		for (U32 j = 0; j < 3; j++)
+		{
+			ensure_equals("extents min", extents[0][j], min[j]);
+			ensure_equals("extents max", extents[1][j], max[j]);
+		}
+	}
+
+	template<> template<>
+	void llskinningkernels_object::test<2>()
+	{
+		set_test_name("out of range joint indices are clamped");
+
+		// Joint 200 does not exist, the last joint stands in for it
+		const LLVector4a position(0.5f, -0.25f, 1.f, 1.f);
+		const LLVector4a weight(200.5f, 0.f, 0.f, 0.f);
+		LLVector4a skinned, extents[2];
+		LLSkinningKernels::skinPositions(&position, &weight, 1, &mPalette[0], JOINT_COUNT, &skinned, extents);
+
+		LLVector4a expected;
+		mPalette[JOINT_COUNT - 1].affineTransform(position, expected);
+		for (U32 j = 0; j < 3; j++)
+		{
+			ensure_approximately_equals_range("clamped joint", skinned[j], expected[j], 1e-5f);
+			ensure_equals("extents of one position", extents[0][j], skinned[j]);
+			ensure_equals("extents of one position", extents[1][j], skinned[j]);
+		}
+	}
+
+	template<> template<>
+	void llskinningkernels_object::test<3>()
+	{
+		set_test_name("benchmark skinning a 50k vertex body");
+
+		const U32 ROUNDS = 20;
+		std::vector<LLVector4a> skinned(VERTEX_COUNT);
+
+		LLTimer timer;
+		for (U32 i = 0; i < ROUNDS; i++)
+		{
+			skinReference(&skinned[0]);
+		}
+		F64 reference_time = timer.getElapsedTimeF64() / ROUNDS;
+
+		timer.reset();
+		LLVector4a extents[2];
+		for (U32 i = 0; i < ROUNDS; i++)
+		{
+			std::vector<LLMatrix4a> palette(mPalette);
+			LLSkinningKernels::applyBindShapeMatrix(&palette[0], JOINT_COUNT, mBindShape);
+			LLSkinningKernels::skinPositions(&mPositions[0], &mWeights[0], VERTEX_COUNT, &palette[0], JOINT_COUNT,
+											 &skinned[0], extents);
+		}
+		F64 kernel_time = timer.getElapsedTimeF64() / ROUNDS;
+
+		ensure("extents set", extents[0][0] <= extents[1][0]);
+
+		LL_INFOS("LLSkinningKernels") << VERTEX_COUNT << " vertices, " << JOINT_COUNT << " joints: blended matrix "
+									  << reference_time * 1000.0 << " ms, kernel "
+									  << kernel_time * 1000.0 << " ms" << LL_ENDL;
+	}
+}
@@ -0,0 +1,188 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief Tests for the optimized face cache format of LLVolume.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llvolume.h"
+
+#include <vector>
+
+#include "../test/lltut.h"
+
+namespace tut
+{
+	struct llvolume_data
+	{
+		llvolume_data()
+		{
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+			params.setBeginAndEndS(0.f, 1.f);
+			params.setBeginAndEndT(0.f, 1.f);
+			params.setRatio(1.f, 1.f);
+			params.setShear(0.f, 0.f);
+			mVolume = new LLVolume(params, 1.f);
+
+			// One face with weights and tangents, so every optional block is written
+			LLVolumeFace& face = mVolume->getVolumeFace(0);
+			face.allocateWeights(face.mNumVertices);
+			face.allocateTangents(face.mNumVertices);
+			for (S32 i = 0; i < face.mNumVertices; ++i)
+			{
+				face.mWeights[i].set(1.5f, 2.25f, (F32)i, 0.f);
+				face.mTangents[i].set(0.f, 1.f, 0.f, -1.f);
+			}
+			face.mTexCoordExtents[0].set(0.25f, 0.5f);
+			face.mTexCoordExtents[1].set(0.75f, 1.f);
+			face.mOptimized = TRUE;
+
+			ensure("packed", mVolume->packOptimizedFaces(mPacked));
+		}
+
+		// unpackOptimizedFaces() wants 16 byte aligned data
+		bool unpack(LLVolume* volume, const std::vector<U8>& data)
+		{
+			U8* buffer = (U8*)ll_aligned_malloc_16(data.size() + 16);
+			if (!data.empty())
+			{
+				memcpy(buffer, data.data(), data.size());
+			}
+			const bool result = volume->unpackOptimizedFaces(buffer, data.size());
+			ll_aligned_free_16(buffer);
+			return result;
+		}
+
+		LLPointer<LLVolume> makeTarget()
+		{
+			LLVolumeParams params;
+			params.setType(LL_PCODE_PROFILE_SQUARE, LL_PCODE_PATH_LINE);
+			return new LLVolume(params, 0.f);
+		}
+
+		LLPointer<LLVolume> mVolume;
+		std::vector<U8> mPacked;
+	};
+	typedef test_group<llvolume_data> llvolume_test;
+	typedef llvolume_test::object llvolume_object;
+	tut::llvolume_test llvolume("LLVolume");
+
+	template<> template<>
+	void llvolume_object::test<1>()
+	{
+		set_test_name("optimized faces round trip");
+
+		LLPointer<LLVolume> target = makeTarget();
+		ensure("unpacked", unpack(target, mPacked));
+		ensure_equals("face count", target->getNumVolumeFaces(), mVolume->getNumVolumeFaces());
+
+		for (S32 f = 0; f < mVolume->getNumVolumeFaces(); ++f)
+		{
+			const LLVolumeFace& src = mVolume->getVolumeFace(f);
+			const LLVolumeFace& dst = target->getVolumeFace(f);
+			ensure_equals("vertices", dst.mNumVertices, src.mNumVertices);
+			ensure_equals("indices", dst.mNumIndices, src.mNumIndices);
+			ensure_equals("optimized", dst.mOptimized, src.mOptimized);
+			ensure_equals("weights", dst.mWeights != NULL, src.mWeights != NULL);
+			ensure_equals("tangents", dst.mTangents != NULL, src.mTangents != NULL);
+			for (S32 i = 0; i < 2; ++i)
+			{
+				ensure("extents", dst.mExtents[i].equals3(src.mExtents[i]));
+				ensure("texcoord extents", dst.mTexCoordExtents[i] == src.mTexCoordExtents[i]);
+			}
+			for (S32 i = 0; i < src.mNumVertices; ++i)
+			{
+				ensure("position", dst.mPositions[i].equals4(src.mPositions[i]));
+				ensure("normal", dst.mNormals[i].equals4(src.mNormals[i]));
+				ensure("texcoord", dst.mTexCoords[i] == src.mTexCoords[i]);
+				if (src.mWeights)
+				{
+					ensure("weight", dst.mWeights[i].equals4(src.mWeights[i]));
+				}
+				if (src.mTangents)
+				{
+					ensure("tangent", dst.mTangents[i].equals4(src.mTangents[i]));
+				}
+			}
+			ensure("index data", !memcmp(dst.mIndices, src.mIndices, sizeof(U16) * src.mNumIndices));
+		}
+
+		// Packing the unpacked volume gives the same bytes again
+		std::vector<U8> repacked;
+		ensure("repacked", target->packOptimizedFaces(repacked));
+		ensure("same bytes", repacked == mPacked);
+	}
+
+	template<> template<>
+	void llvolume_object::test<2>()
+	{
+		set_test_name("truncated or corrupt data is rejected");
+
+		LLPointer<LLVolume> target = makeTarget();
+		const S32 face_count = target->getNumVolumeFaces();
+
+		// Every truncation, down to an empty buffer
+		for (size_t size = 0; size < mPacked.size(); size += (size < 64 ? 1 : 16))
+		{
+			std::vector<U8> truncated(mPacked.begin(), mPacked.begin() + size);
+			ensure(llformat("truncated to %u", (U32)size), !unpack(target, truncated));
+		}
+
+		// Trailing garbage
+		std::vector<U8> longer(mPacked);
+		longer.resize(longer.size() + 16, 0xAB);
+		ensure("trailing data", !unpack(target, longer));
+
+		// Header fields: magic, version, face count
+		for (size_t offset = 0; offset < 12; offset += 4)
+		{
+			std::vector<U8> corrupt(mPacked);
+			corrupt[offset] ^= 0xFF;
+			ensure(llformat("header word %u", (U32)offset / 4), !unpack(target, corrupt));
+		}
+
+		// First face header: vertex count past the data, then an index past the vertices
+		const size_t face_header = 16;
+		const size_t num_vertices = face_header + 48;
+		std::vector<U8> corrupt(mPacked);
+		S32 vertices = 0;
+		memcpy(&vertices, &corrupt[num_vertices], sizeof(S32));
+		vertices += 1000;
+		memcpy(&corrupt[num_vertices], &vertices, sizeof(S32));
+		ensure("vertex count", !unpack(target, corrupt));
+
+		const LLVolumeFace& face = mVolume->getVolumeFace(0);
+		const size_t vertex_block = sizeof(LLVector4a) * 2 * face.mNumVertices + ((face.mNumVertices * sizeof(LLVector2) + 15) & ~(size_t)15);
+		corrupt = mPacked;
+		U16 index = (U16)face.mNumVertices;
+		memcpy(&corrupt[face_header + 64 + vertex_block], &index, sizeof(U16));
+		ensure("index out of range", !unpack(target, corrupt));
+
+		// A failed unpack leaves the volume alone
+		ensure_equals("faces kept", target->getNumVolumeFaces(), face_count);
+		ensure("still unpacks", unpack(target, mPacked));
+	}
+}
@@ -190,3 +190,34 @@ void LLMessageTemplate::banUdp()
 	}
 }
 
+
+// <FS> Compiled message accessors
+LLMessageSlot LLMessageTemplate::getSlot(char* blockname, char* varname) const
+{
+	LLMessageSlot slot;
+
+	message_block_map_t::const_iterator block_iter = mMemberBlocks.find(blockname);
+	if (block_iter == mMemberBlocks.end())
+	{
+		LL_WARNS("Messaging") << "Block " << (blockname ? blockname : "(null)") << " not in message " << mName << LL_ENDL;
+		return slot;
+	}
+
+	const LLMessageBlock* blockp = *block_iter;
+	LLMessageBlock::message_variable_map_t::const_iterator var_iter = blockp->mMemberVariables.find(varname);
+	if (var_iter == blockp->mMemberVariables.end())
+	{
+		LL_WARNS("Messaging") << "Variable " << (varname ? varname : "(null)") << " not in message " << mName
+							  << " block " << blockname << LL_ENDL;
+		return slot;
+	}
+
+	slot.mTemplate = this;
+	slot.mBlockName = blockname;
+	slot.mVarName = varname;
+	slot.mBlock = (S32)(block_iter - mMemberBlocks.begin());
+	slot.mVariable = (S32)(var_iter - blockp->mMemberVariables.begin());
+	slot.mNumVariables = (S32)blockp->mMemberVariables.size();
+	return slot;
+}
+// </FS>
@@ -266,6 +266,37 @@ enum EMsgDeprecation
 };
 
 
+// <FS> Compiled message accessors
+class LLMessageTemplate;
+
+// One variable of one message template, resolved to block and variable
+// indices so LLTemplateMessageReader can find its decoded data without
+// looking up the names on every read. Resolve these once, when the handler
+// is registered, with LLMessageSystem::getMessageSlotFast().
+class LLMessageSlot
+{
+public:
+	LLMessageSlot()
+	:	mTemplate(NULL),
+		mBlockName(NULL),
+		mVarName(NULL),
+		mBlock(-1),
+		mVariable(-1),
+		mNumVariables(0)
+	{
+	}
+
+	bool isValid() const { return mTemplate != NULL; }
+
+	const LLMessageTemplate*	mTemplate;
+	char*						mBlockName;		// canonical names, for messages that did not come through the template reader
+	char*						mVarName;
+	S32							mBlock;			// index in LLMessageTemplate::mMemberBlocks
+	S32							mVariable;		// index in LLMessageBlock::mMemberVariables
+	S32							mNumVariables;	// variables per instance of the block
+};
+// </FS>
+
 class LLMessageTemplate
 {
 public:
@@ -408,6 +439,11 @@ public:
 		return iter != mMemberBlocks.end()? *iter : NULL;
 	}
 
+	// <FS> Compiled message accessors
+	// Names must be canonical. Returns an invalid slot if there is no such variable.
+	LLMessageSlot getSlot(char* blockname, char* varname) const;
+	// </FS>
+
 public:
 	typedef LLIndexedVector<LLMessageBlock*, char*, 8> message_block_map_t;
 	message_block_map_t						mMemberBlocks;
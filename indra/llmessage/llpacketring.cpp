@@ -55,7 +55,15 @@ LLPacketRing::LLPacketRing () :
 	mInBufferLength(0),
 	mOutBufferLength(0),
 	mDropPercentage(0.0f),
-	mPacketsToDrop(0x0)
+	mPacketsToDrop(0x0),
+	// <FS> Batched receive
+	mReceiveBatchSize(0),
+	mBatchCount(0),
+	mBatchNext(0),
+	mBatchesReceived(0),
+	mBatchPacketsReceived(0),
+	mBatchSeconds(0.0)
+	// </FS>
 {
 }
 
@@ -83,6 +91,11 @@ void LLPacketRing::cleanup ()
 		delete packetp;
 		mSendQueue.pop();
 	}
+
+	// <FS> Batched receive
+	mBatchCount = 0;
+	mBatchNext = 0;
+	// </FS>
 }
 
 ///////////////////////////////////////////////////////////
@@ -116,6 +129,85 @@ void LLPacketRing::setOutBandwidth(const F32 bps)
 {
 	mOutThrottle.setRate(bps);
 }
+
+// <FS> Batched receive
+// Room for the SOCKS header in front of a full sized packet
+static const S32 BATCH_SLOT_SIZE = NET_BUFFER_SIZE + SOCKS_HEADER_SIZE;
+
+void LLPacketRing::setReceiveBatchSize(S32 batch_size)
+{
+	batch_size = llclamp(batch_size, 0, MAX_RECEIVE_BATCH);
+	if (batch_size == mReceiveBatchSize)
+	{
+		return;
+	}
+
+	// Packets still waiting in the old batch are lost, like any other dropped UDP packet
+	mReceiveBatchSize = batch_size;
+	mBatchCount = 0;
+	mBatchNext = 0;
+	if (batch_size > 1)
+	{
+		mBatchData.resize(batch_size * BATCH_SLOT_SIZE);
+	}
+	else
+	{
+		std::vector<char>().swap(mBatchData);
+	}
+}
+
+void LLPacketRing::getAndResetBatchStats(U32& batches, U32& packets, F64& seconds)
+{
+	batches = mBatchesReceived;
+	packets = mBatchPacketsReceived;
+	seconds = mBatchSeconds;
+	mBatchesReceived = 0;
+	mBatchPacketsReceived = 0;
+	mBatchSeconds = 0.0;
+}
+
+S32 LLPacketRing::receiveFromBatch(S32 socket, char *datap)
+{
+	if (mBatchNext >= mBatchCount)
+	{
+		// Batch used up, drain the socket again
+		F64 start = LLTimer::getTotalSeconds();
+		mBatchCount = receive_packets(socket, &mBatchData[0], BATCH_SLOT_SIZE, mReceiveBatchSize,
+									  mBatchSizes, mBatchSenders, mBatchInterfaces);
+		mBatchNext = 0;
+		if (!mBatchCount)
+		{
+			return 0;
+		}
+		mBatchesReceived++;
+		mBatchPacketsReceived += mBatchCount;
+		mBatchSeconds += LLTimer::getTotalSeconds() - start;
+	}
+
+	const S32 slot = mBatchNext++;
+	const char* packet = &mBatchData[slot * BATCH_SLOT_SIZE];
+	S32 packet_size = llmin(mBatchSizes[slot], (S32)NET_BUFFER_SIZE);
+	mLastSender = mBatchSenders[slot];
+	mLastReceivingIF = mBatchInterfaces[slot];
+
+	if (LLProxy::isSOCKSProxyEnabled())
+	{
+		if (mBatchSizes[slot] <= SOCKS_HEADER_SIZE)
+		{
+			return 0;
+		}
+		// *FIX We are assuming ATYP is 0x01 (IPv4), not 0x03 (hostname) or 0x04 (IPv6)
+		const proxywrap_t* header = reinterpret_cast<const proxywrap_t*>(packet);
+		mLastSender.setAddress(header->addr);
+		mLastSender.setPort(ntohs(header->port));
+		packet += SOCKS_HEADER_SIZE;
+		packet_size = llmin(mBatchSizes[slot] - SOCKS_HEADER_SIZE, (S32)NET_BUFFER_SIZE);
+	}
+
+	memcpy(datap, packet, packet_size);	/*Flawfinder: ignore*/
+	return packet_size;
+}
+// </FS>
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
 {
@@ -224,6 +316,13 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 	else
 	{
 		// no delay, pull straight from net
+		// <FS> Batched receive
+		if (mReceiveBatchSize > 1)
+		{
+			packet_size = receiveFromBatch(socket, datap);
+		}
+		else
+		// </FS>
 		if (LLProxy::isSOCKSProxyEnabled())
 		{
 			U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
@@ -250,7 +349,13 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 			mLastSender = ::get_sender();
 		}
 
-		mLastReceivingIF = ::get_receiving_interface();
+		// <FS> Batched receive, the batch has set it already
+		//mLastReceivingIF = ::get_receiving_interface();
+		if (mReceiveBatchSize <= 1)
+		{
+			mLastReceivingIF = ::get_receiving_interface();
+		}
+		// </FS>
 
 		if (packet_size)  // did we actually get a packet?
 		{
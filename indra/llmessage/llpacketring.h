@@ -29,6 +29,7 @@
 #define LL_LLPACKETRING_H
 
 #include <queue>
+#include <vector>
 
 #include "llhost.h"
 #include "llpacketbuffer.h"
@@ -60,6 +61,17 @@ public:
 
 	S32 getAndResetActualInBits()				{ S32 bits = mActualBitsIn; mActualBitsIn = 0; return bits;}
 	S32 getAndResetActualOutBits()				{ S32 bits = mActualBitsOut; mActualBitsOut = 0; return bits;}
+
+	// <FS> Batched receive
+	// Drain up to batch_size waiting packets from the socket in one go and hand
+	// them out from memory until they run out. 0 or 1 reads one packet per call.
+	// Not used while the incoming throttle is on.
+	void setReceiveBatchSize(S32 batch_size);
+	S32  getReceiveBatchSize() const			{ return mReceiveBatchSize; }
+	// Number of non-empty batches, the packets in them and the time spent
+	// reading them since the last call.
+	void getAndResetBatchStats(U32& batches, U32& packets, F64& seconds);
+	// </FS>
 protected:
 	BOOL mUseInThrottle;
 	BOOL mUseOutThrottle;
@@ -83,8 +95,23 @@ protected:
 	LLHost mLastSender;
 	LLHost mLastReceivingIF;
 
+	// <FS> Batched receive
+	S32 mReceiveBatchSize;
+	std::vector<char> mBatchData;	// mReceiveBatchSize slots of BATCH_SLOT_SIZE bytes
+	S32 mBatchSizes[MAX_RECEIVE_BATCH];
+	LLHost mBatchSenders[MAX_RECEIVE_BATCH];
+	LLHost mBatchInterfaces[MAX_RECEIVE_BATCH];
+	S32 mBatchCount;				// packets in the current batch
+	S32 mBatchNext;					// next one to hand out
+
+	U32 mBatchesReceived;
+	U32 mBatchPacketsReceived;
+	F64 mBatchSeconds;
+	// </FS>
+
 private:
 	BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, LLHost host);
+	S32  receiveFromBatch(S32 socket, char *datap); // <FS/> Batched receive
 };
 
 
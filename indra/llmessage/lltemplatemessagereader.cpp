@@ -438,6 +438,251 @@ inline void LLTemplateMessageReader::getString(const char *block, const char *va
 	outstr = s;
 }
 
+// <FS> Compiled message accessors
+void LLTemplateMessageReader::getData(const LLMessageSlot& slot, void *datap, S32 size, S32 blocknum, S32 max_size)
+{
+	if (!slot.isValid())
+	{
+		LL_ERRS() << "Invalid slot read from message " << getMessageName() << LL_ENDL;
+		return;
+	}
+
+	if (slot.mTemplate != mCurrentRMessageTemplate || mReceiveSize == -1)
+	{
+		// Not the message this slot was made for, the name lookup reports it
+		getData(slot.mBlockName, slot.mVarName, datap, size, blocknum, max_size);
+		return;
+	}
+
+	if (blocknum < 0 || blocknum >= mBlockCount[slot.mBlock])
+	{
+		LL_ERRS() << "Block " << slot.mBlockName << " #" << blocknum
+			<< " not in message " << mCurrentRMessageTemplate->mName << LL_ENDL;
+		return;
+	}
+
+	const FieldData& field = mFields[mBlockFirstField[slot.mBlock] + blocknum * slot.mNumVariables + slot.mVariable];
+
+	if (size && size != field.mSize)
+	{
+		LL_ERRS() << "Msg " << mCurrentRMessageTemplate->mName
+			<< " variable " << slot.mVarName
+			<< " is size " << field.mSize
+			<< " but copying into buffer of size " << size
+			<< LL_ENDL;
+		return;
+	}
+
+	if (field.mSize <= 0)
+	{
+		return;
+	}
+
+	const U8* fieldp = &mFieldBuffer[field.mOffset];
+	if (max_size >= field.mSize)
+	{
+		// Constant sizes let the compiler turn these into plain loads
+		switch (field.mSize)
+		{
+		case 1:
+			*((U8*)datap) = *fieldp;
+			break;
+		case 2:
+			memcpy(datap, fieldp, 2);
+			break;
+		case 4:
+			memcpy(datap, fieldp, 4);
+			break;
+		case 8:
+			memcpy(datap, fieldp, 8);
+			break;
+		case 12:
+			memcpy(datap, fieldp, 12);
+			break;
+		case 16:
+			memcpy(datap, fieldp, 16);
+			break;
+		default:
+			memcpy(datap, fieldp, field.mSize);
+			break;
+		}
+	}
+	else
+	{
+		LL_WARNS() << "Msg " << mCurrentRMessageTemplate->mName
+			<< " variable " << slot.mVarName
+			<< " is size " << field.mSize
+			<< " but truncated to max size of " << max_size
+			<< LL_ENDL;
+
+		memcpy(datap, fieldp, max_size);
+	}
+}
+
+S32 LLTemplateMessageReader::getNumberOfBlocks(const LLMessageSlot& slot)
+{
+	if (!slot.isValid() || slot.mTemplate != mCurrentRMessageTemplate || mReceiveSize == -1)
+	{
+		return getNumberOfBlocks(slot.mBlockName);
+	}
+	return mBlockCount[slot.mBlock];
+}
+
+S32 LLTemplateMessageReader::getSize(const LLMessageSlot& slot, S32 blocknum)
+{
+	if (!slot.isValid() || slot.mTemplate != mCurrentRMessageTemplate || mReceiveSize == -1)
+	{
+		return getSize(slot.mBlockName, blocknum, slot.mVarName);
+	}
+
+	if (blocknum < 0 || blocknum >= mBlockCount[slot.mBlock])
+	{	// don't crash
+		LL_INFOS() << "Block " << slot.mBlockName << " #" << blocknum << " not in message "
+			<< mCurrentRMessageTemplate->mName << LL_ENDL;
+		return LL_BLOCK_NOT_IN_MESSAGE;
+	}
+
+	return mFields[mBlockFirstField[slot.mBlock] + blocknum * slot.mNumVariables + slot.mVariable].mSize;
+}
+
+void LLTemplateMessageReader::getBinaryData(const LLMessageSlot& slot, void *datap, S32 size, S32 blocknum, S32 max_size)
+{
+	getData(slot, datap, size, blocknum, max_size);
+}
+
+void LLTemplateMessageReader::getS8(const LLMessageSlot& slot, S8 &u, S32 blocknum)
+{
+	getData(slot, &u, sizeof(S8), blocknum);
+}
+
+void LLTemplateMessageReader::getU8(const LLMessageSlot& slot, U8 &u, S32 blocknum)
+{
+	getData(slot, &u, sizeof(U8), blocknum);
+}
+
+void LLTemplateMessageReader::getBOOL(const LLMessageSlot& slot, BOOL &b, S32 blocknum)
+{
+	U8 value;
+	getData(slot, &value, sizeof(U8), blocknum);
+	b = (BOOL)value;
+}
+
+void LLTemplateMessageReader::getS16(const LLMessageSlot& slot, S16 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(S16), blocknum);
+}
+
+void LLTemplateMessageReader::getU16(const LLMessageSlot& slot, U16 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(U16), blocknum);
+}
+
+void LLTemplateMessageReader::getS32(const LLMessageSlot& slot, S32 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(S32), blocknum);
+}
+
+void LLTemplateMessageReader::getU32(const LLMessageSlot& slot, U32 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(U32), blocknum);
+}
+
+void LLTemplateMessageReader::getU64(const LLMessageSlot& slot, U64 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(U64), blocknum);
+}
+
+void LLTemplateMessageReader::getF32(const LLMessageSlot& slot, F32 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(F32), blocknum);
+
+	if( !llfinite(d) )
+	{
+		LL_WARNS() << "non-finite in getF32 " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		d = 0;
+	}
+}
+
+void LLTemplateMessageReader::getF64(const LLMessageSlot& slot, F64 &d, S32 blocknum)
+{
+	getData(slot, &d, sizeof(F64), blocknum);
+
+	if( !llfinite(d) )
+	{
+		LL_WARNS() << "non-finite in getF64 " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		d = 0;
+	}
+}
+
+void LLTemplateMessageReader::getVector3(const LLMessageSlot& slot, LLVector3 &v, S32 blocknum)
+{
+	getData(slot, &v.mV[0], sizeof(v.mV), blocknum);
+
+	if( !v.isFinite() )
+	{
+		LL_WARNS() << "non-finite in getVector3 " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		v.zeroVec();
+	}
+}
+
+void LLTemplateMessageReader::getVector4(const LLMessageSlot& slot, LLVector4 &v, S32 blocknum)
+{
+	getData(slot, &v.mV[0], sizeof(v.mV), blocknum);
+
+	if( !v.isFinite() )
+	{
+		LL_WARNS() << "non-finite in getVector4 " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		v.zeroVec();
+	}
+}
+
+void LLTemplateMessageReader::getVector3d(const LLMessageSlot& slot, LLVector3d &v, S32 blocknum)
+{
+	getData(slot, &v.mdV[0], sizeof(v.mdV), blocknum);
+
+	if( !v.isFinite() )
+	{
+		LL_WARNS() << "non-finite in getVector3d " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		v.zeroVec();
+	}
+}
+
+void LLTemplateMessageReader::getQuat(const LLMessageSlot& slot, LLQuaternion &q, S32 blocknum)
+{
+	LLVector3 vec;
+	getData(slot, &vec.mV[0], sizeof(vec.mV), blocknum);
+	if( vec.isFinite() )
+	{
+		q.unpackFromVector3( vec );
+	}
+	else
+	{
+		LL_WARNS() << "non-finite in getQuat " << slot.mBlockName << " " << slot.mVarName << LL_ENDL;
+		q.loadIdentity();
+	}
+}
+
+void LLTemplateMessageReader::getUUID(const LLMessageSlot& slot, LLUUID &u, S32 blocknum)
+{
+	getData(slot, &u.mData[0], sizeof(u.mData), blocknum);
+}
+
+void LLTemplateMessageReader::getString(const LLMessageSlot& slot, S32 buffer_size, char *s, S32 blocknum)
+{
+	s[0] = '\0';
+	getData(slot, s, 0, blocknum, buffer_size);
+	s[buffer_size - 1] = '\0';
+}
+
+void LLTemplateMessageReader::getString(const LLMessageSlot& slot, std::string& outstr, S32 blocknum)
+{
+	char s[MTUBYTES + 1]= {0}; // every element is initialized with 0
+	getData(slot, s, 0, blocknum, MTUBYTES);
+	s[MTUBYTES] = '\0';
+	outstr = s;
+}
+// </FS>
+
 //virtual 
 S32 LLTemplateMessageReader::getMessageSize() const
 {
@@ -537,6 +782,65 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 {
     LL_RECORD_BLOCK_TIME(FTM_PROCESS_MESSAGES);
 
+	// <FS> Compiled message accessors: decoding moved to decodeMessage()
+	if (!decodeMessage(buffer, sender))
+	{
+		return FALSE;
+	}
+	// </FS>
+
+	{
+		static LLTimer decode_timer;
+
+		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		{
+			decode_timer.reset();
+		}
+
+		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
+		{
+			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
+		}
+
+		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
+		{
+			F32 decode_time = decode_timer.getElapsedTimeF32();
+
+			if (gMessageSystem->getTimingCallback())
+			{
+				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
+								decode_time,
+								gMessageSystem->getTimingCallbackData());
+			}
+
+			if (LLMessageReader::getTimeDecodes())
+			{
+				mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
+
+				mCurrentRMessageTemplate->mTotalDecoded++;
+				mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
+
+				if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
+				{
+					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
+				}
+
+
+				if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
+				{
+					LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
+						mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
+						(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+// <FS> Compiled message accessors
+BOOL LLTemplateMessageReader::decodeMessage(const U8* buffer, const LLHost& sender)
+{
 	llassert( mReceiveSize >= 0 );
 	llassert( mCurrentRMessageTemplate);
 	llassert( !mCurrentRMessageData );
@@ -549,12 +853,21 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 
 	// create base working data set
 	mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
+
+	// <FS> Compiled message accessors
+	const size_t num_blocks = mCurrentRMessageTemplate->mMemberBlocks.size();
+	mFieldBuffer.clear();
+	mFields.clear();
+	mBlockFirstField.assign(num_blocks, 0);
+	mBlockCount.assign(num_blocks, 0);
+	S32 block_index = 0;
+	// </FS>
 	
 	// loop through the template building the data structure as we go
 	LLMessageTemplate::message_block_map_t::const_iterator iter;
 	for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
 		iter != mCurrentRMessageTemplate->mMemberBlocks.end();
-		++iter)
+		++iter, ++block_index) // <FS/> Compiled message accessors
 	{
 		LLMessageBlock* mbci = *iter;
 		U8	repeat_number;
@@ -597,6 +910,11 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 			return FALSE;
 		}
 
+		// <FS> Compiled message accessors
+		mBlockFirstField[block_index] = (S32)mFields.size();
+		mBlockCount[block_index] = repeat_number;
+		// </FS>
+
 		LLMsgBlkData* cur_data_block = NULL;
 
 		// now loop through the block
@@ -667,6 +985,7 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 					decode_pos += data_size;
 
 					cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
+					addField(&buffer[decode_pos], tsize, mvci.getType()); // <FS/> Compiled message accessors
 					decode_pos += tsize;
 				}
 				else
@@ -682,6 +1001,7 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 						std::vector<U8> data(size, 0);
 						cur_data_block->addData(mvci.getName(), &(data[0]), 
 												size, mvci.getType());
+						addField(&(data[0]), size, mvci.getType()); // <FS/> Compiled message accessors
 					}
 					else
 					{
@@ -689,6 +1009,7 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 												&buffer[decode_pos], 
 												mvci.getSize(), 
 												mvci.getType());
+						addField(&buffer[decode_pos], mvci.getSize(), mvci.getType()); // <FS/> Compiled message accessors
 					}
 					decode_pos += mvci.getSize();
 				}
@@ -703,54 +1024,23 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender
 		return FALSE;
 	}
 
-	{
-		static LLTimer decode_timer;
-
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
-		{
-			decode_timer.reset();
-		}
-
-		if( !mCurrentRMessageTemplate->callHandlerFunc(gMessageSystem) )
-		{
-			LL_WARNS() << "Message from " << sender << " with no handler function received: " << mCurrentRMessageTemplate->mName << LL_ENDL;
-		}
-
-		if(LLMessageReader::getTimeDecodes() || gMessageSystem->getTimingCallback())
-		{
-			F32 decode_time = decode_timer.getElapsedTimeF32();
-
-			if (gMessageSystem->getTimingCallback())
-			{
-				(gMessageSystem->getTimingCallback())(mCurrentRMessageTemplate->mName,
-								decode_time,
-								gMessageSystem->getTimingCallbackData());
-			}
-
-			if (LLMessageReader::getTimeDecodes())
-			{
-				mCurrentRMessageTemplate->mDecodeTimeThisFrame += decode_time;
-
-				mCurrentRMessageTemplate->mTotalDecoded++;
-				mCurrentRMessageTemplate->mTotalDecodeTime += decode_time;
-
-				if( mCurrentRMessageTemplate->mMaxDecodeTimePerMsg < decode_time )
-				{
-					mCurrentRMessageTemplate->mMaxDecodeTimePerMsg = decode_time;
-				}
+	return TRUE;
+}
 
+void LLTemplateMessageReader::addField(const void* data, S32 size, EMsgVariableType type)
+{
+	FieldData field;
+	field.mOffset = (S32)mFieldBuffer.size();
+	field.mSize = size;
+	mFields.push_back(field);
 
-				if(decode_time > LLMessageReader::getTimeDecodesSpamThreshold())
-				{
-					LL_DEBUGS() << "--------- Message " << mCurrentRMessageTemplate->mName << " decode took " << decode_time << " seconds. (" <<
-						mCurrentRMessageTemplate->mMaxDecodeTimePerMsg << " max, " <<
-						(mCurrentRMessageTemplate->mTotalDecodeTime / mCurrentRMessageTemplate->mTotalDecoded) << " avg)" << LL_ENDL;
-				}
-			}
-		}
+	if (size > 0)
+	{
+		mFieldBuffer.resize(field.mOffset + size);
+		htolememcpy(&mFieldBuffer[field.mOffset], data, type, size);
 	}
-	return TRUE;
 }
+// </FS>
 
 BOOL LLTemplateMessageReader::validateMessage(const U8* buffer, 
 											  S32 buffer_size, 
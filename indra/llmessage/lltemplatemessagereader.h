@@ -28,11 +28,14 @@
 #define LL_LLTEMPLATEMESSAGEREADER_H
 
 #include "llmessagereader.h"
+#include "llmsgvariabletype.h" // <FS/> Compiled message accessors
 
 #include <map>
+#include <vector> // <FS/> Compiled message accessors
 
 class LLMessageTemplate;
 class LLMsgData;
+class LLMessageSlot; // <FS/> Compiled message accessors
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -105,7 +108,39 @@ public:
 	bool isTrusted() const;
 	bool isBanned(bool trusted_source) const;
 	bool isUdpBanned() const;
-	
+
+	// <FS> Compiled message accessors
+	// Decodes a validated message without calling its handler, the get*
+	// methods can be used on it afterwards.
+	BOOL decodeMessage(const U8* buffer, const LLHost& sender);
+
+	// Same as the get* methods above, but the variable is found by the
+	// indices in the slot rather than by name. Slots of another message
+	// fall back to the name lookup.
+	void getBinaryData(const LLMessageSlot& slot, void *datap, S32 size,
+					   S32 blocknum = 0, S32 max_size = S32_MAX);
+	void getBOOL(const LLMessageSlot& slot, BOOL &data, S32 blocknum = 0);
+	void getS8(const LLMessageSlot& slot, S8 &data, S32 blocknum = 0);
+	void getU8(const LLMessageSlot& slot, U8 &data, S32 blocknum = 0);
+	void getS16(const LLMessageSlot& slot, S16 &data, S32 blocknum = 0);
+	void getU16(const LLMessageSlot& slot, U16 &data, S32 blocknum = 0);
+	void getS32(const LLMessageSlot& slot, S32 &data, S32 blocknum = 0);
+	void getF32(const LLMessageSlot& slot, F32 &data, S32 blocknum = 0);
+	void getU32(const LLMessageSlot& slot, U32 &data, S32 blocknum = 0);
+	void getU64(const LLMessageSlot& slot, U64 &data, S32 blocknum = 0);
+	void getF64(const LLMessageSlot& slot, F64 &data, S32 blocknum = 0);
+	void getVector3(const LLMessageSlot& slot, LLVector3 &vec, S32 blocknum = 0);
+	void getVector4(const LLMessageSlot& slot, LLVector4 &vec, S32 blocknum = 0);
+	void getVector3d(const LLMessageSlot& slot, LLVector3d &vec, S32 blocknum = 0);
+	void getQuat(const LLMessageSlot& slot, LLQuaternion &q, S32 blocknum = 0);
+	void getUUID(const LLMessageSlot& slot, LLUUID &uuid, S32 blocknum = 0);
+	void getString(const LLMessageSlot& slot, S32 buffer_size, char *buffer, S32 blocknum = 0);
+	void getString(const LLMessageSlot& slot, std::string& outstr, S32 blocknum = 0);
+
+	S32 getNumberOfBlocks(const LLMessageSlot& slot);
+	S32 getSize(const LLMessageSlot& slot, S32 blocknum = 0);
+	// </FS>
+
 private:
 
 	void getData(const char *blockname, const char *varname, void *datap, 
@@ -118,10 +153,31 @@ private:
 
 	BOOL decodeData(const U8* buffer, const LLHost& sender );
 
+	// <FS> Compiled message accessors
+	void getData(const LLMessageSlot& slot, void *datap, S32 size = 0,
+				 S32 blocknum = 0, S32 max_size = S32_MAX);
+	void addField(const void* data, S32 size, EMsgVariableType type);
+	// </FS>
+
 	S32	mReceiveSize;
 	LLMessageTemplate* mCurrentRMessageTemplate;
 	LLMsgData* mCurrentRMessageData;
 	message_template_number_map_t& mMessageNumbers;
+
+	// <FS> Compiled message accessors
+	// The decoded variables of the current message in template order, one
+	// per variable of every block instance, so a slot can find its data
+	// with a little arithmetic. The buffers are reused between messages.
+	struct FieldData
+	{
+		S32 mOffset; // into mFieldBuffer
+		S32 mSize;
+	};
+	std::vector<U8> mFieldBuffer;
+	std::vector<FieldData> mFields;
+	std::vector<S32> mBlockFirstField;	// per template block, index of its first field
+	std::vector<S32> mBlockCount;		// per template block, number of instances received
+	// </FS>
 };
 
 #endif // LL_LLTEMPLATEMESSAGEREADER_H
@@ -573,6 +573,9 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 
 			if(cdp && (acks > 0) && ((S32)(acks * sizeof(TPACKETID)) < (true_rcv_size)))
 			{
+				// <FS> Batched ack processing
+				const bool defer_acks = mPacketRing.getReceiveBatchSize() > 1;
+				// </FS>
 				TPACKETID packet_id;
 				U32 mem_id=0;
 				for(S32 i = 0; i < acks; ++i)
@@ -582,7 +585,17 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 					     sizeof(TPACKETID));
 					packet_id = ntohl(mem_id);
 					//LL_INFOS("Messaging") << "got ack: " << packet_id << LL_ENDL;
-					cdp->ackReliablePacket(packet_id);
+					// <FS> Batched ack processing
+					//cdp->ackReliablePacket(packet_id);
+					if (defer_acks)
+					{
+						mPendingAcks.push_back(std::make_pair(host, packet_id));
+					}
+					else
+					{
+						cdp->ackReliablePacket(packet_id);
+					}
+					// </FS>
 				}
 				if (!cdp->getUnackedPacketCount())
 				{
@@ -730,6 +743,14 @@ BOOL LLMessageSystem::checkMessages(LockMessageChecker&, S64 frame_count )
 		}
 	} while (!valid_packet && receive_size > 0);
 
+	// <FS> Batched ack processing
+	if (!receive_size)
+	{
+		// Socket drained, apply what this batch acked
+		applyPendingAcks();
+	}
+	// </FS>
+
 	F64Seconds mt_sec = getMessageTimeSeconds();
 	// Check to see if we need to print debug info
 	if ((mt_sec - mCircuitPrintTime) > mCircuitPrintFreq)
@@ -759,8 +780,48 @@ S32	LLMessageSystem::getReceiveBytes() const
 }
 
 
+// <FS> Batched ack processing
+void LLMessageSystem::applyPendingAcks()
+{
+	if (mPendingAcks.empty())
+	{
+		return;
+	}
+
+	LLCircuitData* cdp = NULL;
+	pending_ack_list_t::const_iterator it = mPendingAcks.begin();
+	for (LLHost host = it->first; it != mPendingAcks.end(); ++it)
+	{
+		if (it == mPendingAcks.begin() || it->first != host)
+		{
+			if (cdp && !cdp->getUnackedPacketCount())
+			{
+				mCircuitInfo.mUnackedCircuitMap.erase(cdp->mHost);
+			}
+			host = it->first;
+			// The circuit may have gone away since the packet came in
+			cdp = mCircuitInfo.findCircuit(host);
+		}
+		if (cdp)
+		{
+			cdp->ackReliablePacket(it->second);
+		}
+	}
+	if (cdp && !cdp->getUnackedPacketCount())
+	{
+		// Remove this circuit from the list of circuits with unacked packets
+		mCircuitInfo.mUnackedCircuitMap.erase(cdp->mHost);
+	}
+	mPendingAcks.clear();
+}
+// </FS>
+
 void LLMessageSystem::processAcks(LockMessageChecker&, F32 collect_time)
 {
+	// <FS> Batched ack processing, before anything gets resent
+	applyPendingAcks();
+	// </FS>
+
 	F64Seconds mt_sec = getMessageTimeSeconds();
 	{
 		gTransferManager.updateTransfers();
@@ -3970,6 +4031,262 @@ S32	LLMessageSystem::getSize(const char *blockname, S32 blocknum,
 					   LLMessageStringTable::getInstance()->getString(varname));
 }
 
+// <FS> Compiled message accessors
+LLMessageSlot LLMessageSystem::getMessageSlotFast(const char *msgname, const char *blockname, 
+												  const char *varname) const
+{
+	message_template_name_map_t::const_iterator iter = mMessageTemplates.find(msgname);
+	if (iter == mMessageTemplates.end())
+	{
+		LL_WARNS("Messaging") << "Unknown message " << (msgname ? msgname : "(null)") << LL_ENDL;
+		return LLMessageSlot();
+	}
+	return iter->second->getSlot(const_cast<char*>(blockname), const_cast<char*>(varname));
+}
+
+LLMessageSlot LLMessageSystem::getMessageSlot(const char *msgname, const char *blockname, 
+											  const char *varname) const
+{
+	return getMessageSlotFast(LLMessageStringTable::getInstance()->getString(msgname),
+							  LLMessageStringTable::getInstance()->getString(blockname),
+							  LLMessageStringTable::getInstance()->getString(varname));
+}
+
+void LLMessageSystem::getBinaryDataFast(const LLMessageSlot& slot, void *datap, S32 size, S32 blocknum, S32 max_size)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getBinaryData(slot, datap, size, blocknum, max_size);
+	}
+	else
+	{
+		mMessageReader->getBinaryData(slot.mBlockName, slot.mVarName, datap, size, blocknum, max_size);
+	}
+}
+
+void LLMessageSystem::getBOOLFast(const LLMessageSlot& slot, BOOL &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getBOOL(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getBOOL(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getS8Fast(const LLMessageSlot& slot, S8 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getS8(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getS8(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getU8Fast(const LLMessageSlot& slot, U8 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getU8(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getU8(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getS16Fast(const LLMessageSlot& slot, S16 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getS16(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getS16(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getU16Fast(const LLMessageSlot& slot, U16 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getU16(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getU16(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getS32Fast(const LLMessageSlot& slot, S32 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getS32(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getS32(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getF32Fast(const LLMessageSlot& slot, F32 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getF32(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getF32(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getU32Fast(const LLMessageSlot& slot, U32 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getU32(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getU32(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getU64Fast(const LLMessageSlot& slot, U64 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getU64(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getU64(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getF64Fast(const LLMessageSlot& slot, F64 &d, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getF64(slot, d, blocknum);
+	}
+	else
+	{
+		mMessageReader->getF64(slot.mBlockName, slot.mVarName, d, blocknum);
+	}
+}
+
+void LLMessageSystem::getVector3Fast(const LLMessageSlot& slot, LLVector3 &v, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getVector3(slot, v, blocknum);
+	}
+	else
+	{
+		mMessageReader->getVector3(slot.mBlockName, slot.mVarName, v, blocknum);
+	}
+}
+
+void LLMessageSystem::getVector4Fast(const LLMessageSlot& slot, LLVector4 &v, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getVector4(slot, v, blocknum);
+	}
+	else
+	{
+		mMessageReader->getVector4(slot.mBlockName, slot.mVarName, v, blocknum);
+	}
+}
+
+void LLMessageSystem::getVector3dFast(const LLMessageSlot& slot, LLVector3d &v, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getVector3d(slot, v, blocknum);
+	}
+	else
+	{
+		mMessageReader->getVector3d(slot.mBlockName, slot.mVarName, v, blocknum);
+	}
+}
+
+void LLMessageSystem::getQuatFast(const LLMessageSlot& slot, LLQuaternion &q, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getQuat(slot, q, blocknum);
+	}
+	else
+	{
+		mMessageReader->getQuat(slot.mBlockName, slot.mVarName, q, blocknum);
+	}
+}
+
+void LLMessageSystem::getUUIDFast(const LLMessageSlot& slot, LLUUID &u, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getUUID(slot, u, blocknum);
+	}
+	else
+	{
+		mMessageReader->getUUID(slot.mBlockName, slot.mVarName, u, blocknum);
+	}
+}
+
+void LLMessageSystem::getStringFast(const LLMessageSlot& slot, S32 buffer_size, char *s, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getString(slot, buffer_size, s, blocknum);
+	}
+	else
+	{
+		mMessageReader->getString(slot.mBlockName, slot.mVarName, buffer_size, s, blocknum);
+	}
+}
+
+void LLMessageSystem::getStringFast(const LLMessageSlot& slot, std::string& outstr, S32 blocknum)
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		mTemplateMessageReader->getString(slot, outstr, blocknum);
+	}
+	else
+	{
+		mMessageReader->getString(slot.mBlockName, slot.mVarName, outstr, blocknum);
+	}
+}
+
+S32 LLMessageSystem::getNumberOfBlocksFast(const LLMessageSlot& slot) const
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		return mTemplateMessageReader->getNumberOfBlocks(slot);
+	}
+	return mMessageReader->getNumberOfBlocks(slot.mBlockName);
+}
+
+S32 LLMessageSystem::getSizeFast(const LLMessageSlot& slot, S32 blocknum) const
+{
+	if (mMessageReader == mTemplateMessageReader)
+	{
+		return mTemplateMessageReader->getSize(slot, blocknum);
+	}
+	return mMessageReader->getSize(slot.mBlockName, blocknum, slot.mVarName);
+}
+// </FS>
+
 S32 LLMessageSystem::getReceiveSize() const
 {
 	return mMessageReader->getMessageSize();
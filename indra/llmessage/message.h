@@ -177,6 +177,7 @@ typedef void (*msg_exception_callback)(LLMessageSystem*,void*,EMessageException)
 class LLMsgData;
 class LLMsgBlkData;
 class LLMessageTemplate;
+class LLMessageSlot; // <FS/> Compiled message accessors
 
 class LLMessagePollInfo;
 class LLMessageBuilder;
@@ -638,6 +639,34 @@ public:
 	void getStringFast(	const char *block, const char *var, std::string& outstr, S32 blocknum = 0);
 	void	getString(	const char *block, const char *var, std::string& outstr, S32 blocknum = 0);
 
+	// <FS> Compiled message accessors
+	// Resolve a variable of a message to a slot once, when registering the
+	// handler, and the getters below read it by index instead of looking up
+	// the block and variable names every time. Messages that did not come
+	// through the template reader are still read by name.
+	LLMessageSlot getMessageSlotFast(const char *msgname, const char *blockname, const char *varname) const;
+	LLMessageSlot getMessageSlot(const char *msgname, const char *blockname, const char *varname) const;
+
+	void	getBinaryDataFast(const LLMessageSlot& slot, void *datap, S32 size, S32 blocknum = 0, S32 max_size = S32_MAX);
+	void	getBOOLFast(	const LLMessageSlot& slot, BOOL &data, S32 blocknum = 0);
+	void	getS8Fast(		const LLMessageSlot& slot, S8 &data, S32 blocknum = 0);
+	void	getU8Fast(		const LLMessageSlot& slot, U8 &data, S32 blocknum = 0);
+	void	getS16Fast(		const LLMessageSlot& slot, S16 &data, S32 blocknum = 0);
+	void	getU16Fast(		const LLMessageSlot& slot, U16 &data, S32 blocknum = 0);
+	void	getS32Fast(		const LLMessageSlot& slot, S32 &data, S32 blocknum = 0);
+	void	getF32Fast(		const LLMessageSlot& slot, F32 &data, S32 blocknum = 0);
+	void	getU32Fast(		const LLMessageSlot& slot, U32 &data, S32 blocknum = 0);
+	void	getU64Fast(		const LLMessageSlot& slot, U64 &data, S32 blocknum = 0);
+	void	getF64Fast(		const LLMessageSlot& slot, F64 &data, S32 blocknum = 0);
+	void	getVector3Fast(	const LLMessageSlot& slot, LLVector3 &vec, S32 blocknum = 0);
+	void	getVector4Fast(	const LLMessageSlot& slot, LLVector4 &vec, S32 blocknum = 0);
+	void	getVector3dFast(const LLMessageSlot& slot, LLVector3d &vec, S32 blocknum = 0);
+	void	getQuatFast(	const LLMessageSlot& slot, LLQuaternion &q, S32 blocknum = 0);
+	void	getUUIDFast(	const LLMessageSlot& slot, LLUUID &uuid, S32 blocknum = 0);
+	void	getStringFast(	const LLMessageSlot& slot, S32 buffer_size, char *buffer, S32 blocknum = 0);
+	void	getStringFast(	const LLMessageSlot& slot, std::string& outstr, S32 blocknum = 0);
+	// </FS>
+
 
 	// Utility functions to generate a replay-resistant digest check
 	// against the shared secret. The window specifies how much of a
@@ -704,6 +733,16 @@ private:
 	// related to sendDenyTrustedCircuit()
 	void	reallySendDenyTrustedCircuit(const LLHost &host);
 
+	// <FS> Batched ack processing
+	// With batched receive the acks appended to incoming packets are collected
+	// here and applied together once the socket has been drained, looking each
+	// circuit up once per run of packets from the same host.
+	typedef std::vector<std::pair<LLHost, TPACKETID> > pending_ack_list_t;
+	pending_ack_list_t mPendingAcks;
+
+	void	applyPendingAcks();
+	// </FS>
+
 public:
 	// Use this to establish trust to and from a host.  This blocks
 	// until trust has been established, and probably should only be
@@ -733,6 +772,10 @@ public:
 	S32		getSizeFast(const char *blockname, S32 blocknum, 
 						const char *varname) const; // size in bytes of data
 	S32		getSize(const char *blockname, S32 blocknum, const char *varname) const;
+	// <FS> Compiled message accessors
+	S32		getNumberOfBlocksFast(const LLMessageSlot& slot) const;
+	S32		getSizeFast(const LLMessageSlot& slot, S32 blocknum) const;
+	// </FS>
 
 	void	resetReceiveCounts();				// resets receive counts for all message types to 0
 	void	dumpReceiveCounts();				// dumps receive count for each message type to LL_INFOS()
@@ -112,6 +112,36 @@ U32 get_receiving_interface_ip(void)
 	return gsnReceivingIFAddr;
 }
 
+// <FS> Batched receive
+static S32 receive_packets_one_by_one(int hSocket, char* buffers, S32 buffer_size, S32 max_packets,
+									  S32* sizes, LLHost* senders, LLHost* interfaces)
+{
+	S32 count = 0;
+	while (count < max_packets)
+	{
+		S32 size = receive_packet(hSocket, buffers + count * buffer_size);
+		if (size <= 0)
+		{
+			break;
+		}
+		sizes[count] = size;
+		senders[count] = get_sender();
+		interfaces[count] = get_receiving_interface();
+		++count;
+	}
+	return count;
+}
+
+#if !LL_LINUX
+S32 receive_packets(int hSocket, char* buffers, S32 buffer_size, S32 max_packets,
+					S32* sizes, LLHost* senders, LLHost* interfaces)
+{
+	return receive_packets_one_by_one(hSocket, buffers, buffer_size, llmin(max_packets, MAX_RECEIVE_BATCH),
+									  sizes, senders, interfaces);
+}
+#endif
+// </FS>
+
 const char* u32_to_ip_string(U32 ip)
 {
 	static char buffer[MAXADDRSTR];	 /* Flawfinder: ignore */ 
@@ -598,6 +628,76 @@ int receive_packet(int hSocket, char * receiveBuffer)
 	return nRet;
 }
 
+// <FS> Batched receive
+#if LL_LINUX
+S32 receive_packets(int hSocket, char* buffers, S32 buffer_size, S32 max_packets,
+					S32* sizes, LLHost* senders, LLHost* interfaces)
+{
+	// Kernels older than 2.6.33 have no recvmmsg()
+	static bool sHaveRecvmmsg = true;
+
+	max_packets = llmin(max_packets, MAX_RECEIVE_BATCH);
+	if (!sHaveRecvmmsg)
+	{
+		return receive_packets_one_by_one(hSocket, buffers, buffer_size, max_packets, sizes, senders, interfaces);
+	}
+
+	struct mmsghdr msgs[MAX_RECEIVE_BATCH];
+	struct iovec iovs[MAX_RECEIVE_BATCH];
+	struct sockaddr_in addrs[MAX_RECEIVE_BATCH];
+	char cmsgs[MAX_RECEIVE_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+	memset(msgs, 0, sizeof(msgs[0]) * max_packets);
+	for (S32 i = 0; i < max_packets; ++i)
+	{
+		iovs[i].iov_base = buffers + i * buffer_size;
+		iovs[i].iov_len = buffer_size;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsgs[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+	}
+
+	int count = recvmmsg(hSocket, msgs, max_packets, MSG_DONTWAIT, NULL);
+	if (count <= 0)
+	{
+		if (count < 0 && errno == ENOSYS)
+		{
+			LL_WARNS() << "recvmmsg() not available, receiving one packet at a time" << LL_ENDL;
+			sHaveRecvmmsg = false;
+			return receive_packets_one_by_one(hSocket, buffers, buffer_size, max_packets, sizes, senders, interfaces);
+		}
+		return 0;
+	}
+
+	for (S32 i = 0; i < count; ++i)
+	{
+		U32 dstip = INVALID_HOST_IP_ADDRESS;
+		for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+		{
+			if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+			{
+				// Same choice as recvfrom_destip(), the specified address
+				dstip = ((in_pktinfo*)CMSG_DATA(cmsgptr))->ipi_spec_dst.s_addr;
+			}
+		}
+
+		sizes[i] = msgs[i].msg_len;
+		senders[i] = LLHost(addrs[i].sin_addr.s_addr, ntohs(addrs[i].sin_port));
+		interfaces[i] = LLHost(dstip, INVALID_PORT);
+	}
+
+	// Keep get_sender() and get_receiving_interface() in step with receive_packet()
+	stSrcAddr = addrs[count - 1];
+	gsnReceivingIFAddr = interfaces[count - 1].getAddress();
+
+	return count;
+}
+#endif
+// </FS>
+
 BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient, int nPort)
 {
 	int		ret;
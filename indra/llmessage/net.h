@@ -43,6 +43,19 @@ void	end_net(S32& socket_out);
 // returns size of packet or -1 in case of error
 S32		receive_packet(int hSocket, char * receiveBuffer);
 
+// <FS> Batched receive
+// Most packets receive_packets() reads in one call
+const S32	MAX_RECEIVE_BATCH = 64;
+
+// Reads up to max_packets (at most MAX_RECEIVE_BATCH) waiting datagrams. Packet i
+// lands at buffers + i * buffer_size, buffer_size being at least NET_BUFFER_SIZE,
+// and its size, sender and receiving interface go in sizes[i], senders[i] and
+// interfaces[i]. Returns the number of packets read, 0 if there were none.
+// One recvmmsg() call on Linux, one receive_packet() per packet elsewhere.
+S32		receive_packets(int hSocket, char* buffers, S32 buffer_size, S32 max_packets,
+						S32* sizes, LLHost* senders, LLHost* interfaces);
+// </FS>
+
 BOOL	send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);	// Returns TRUE on success.
 
 //void	get_sender(char * tmp);
@@ -0,0 +1,379 @@
+/**
+ * @file lltemplatemessagereader_test.cpp
+ * @brief Checks the slot accessors of LLTemplateMessageReader against the
+ * name based ones, and times both on object update packets.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+// Class to test
+#include "../lltemplatemessagereader.h"
+
+#include "../llmessagetemplate.h"
+#include "../llmessagetemplateparser.h"
+#include "llhost.h"
+#include "llpounceable.h"
+#include "lltimer.h"
+#include "lluuid.h"
+#include "v3math.h"
+#include "../test/lltut.h"
+
+#include "../llhost.cpp" // Needed for the sender
+#include "../net.cpp" // Needed by LLHost.
+#include "../llmessagereader.cpp"
+#include "../llmessagetemplate.cpp"
+#include "../llmessagetemplateparser.cpp"
+#include "../message_string_table.cpp"
+
+LLPounceable<LLMessageSystem*, LLPounceableStatic> gMessageSystem;
+
+// The packets are well formed, nothing should run off the end
+bool gRanOffEnd = false;
+BOOL LLMessageSystem::callExceptionFunc(EMessageException exception)
+{
+	gRanOffEnd = true;
+	return FALSE;
+}
+
+namespace
+{
+	// Same layout as in message_template.msg
+	const char* sTemplates =
+		"version 2.0\n"
+		"{\n"
+		"	ObjectUpdate High 12 Trusted Zerocoded\n"
+		"	{ RegionData Single { RegionHandle U64 } { TimeDilation U16 } }\n"
+		"	{\n"
+		"		ObjectData Variable\n"
+		"		{ ID U32 } { State U8 } { FullID LLUUID } { CRC U32 } { PCode U8 }\n"
+		"		{ Material U8 } { ClickAction U8 } { Scale LLVector3 } { ObjectData Variable 1 }\n"
+		"		{ ParentID U32 } { UpdateFlags U32 }\n"
+		"		{ PathCurve U8 } { ProfileCurve U8 } { PathBegin U16 } { PathEnd U16 }\n"
+		"		{ PathScaleX U8 } { PathScaleY U8 } { PathShearX U8 } { PathShearY U8 }\n"
+		"		{ PathTwist S8 } { PathTwistBegin S8 } { PathRadiusOffset S8 } { PathTaperX S8 }\n"
+		"		{ PathTaperY S8 } { PathRevolutions U8 } { PathSkew S8 }\n"
+		"		{ ProfileBegin U16 } { ProfileEnd U16 } { ProfileHollow U16 }\n"
+		"		{ TextureEntry Variable 2 } { TextureAnim Variable 1 }\n"
+		"		{ NameValue Variable 2 } { Data Variable 2 } { Text Variable 1 } { TextColor Fixed 4 }\n"
+		"		{ MediaURL Variable 1 } { PSBlock Variable 1 } { ExtraParams Variable 1 }\n"
+		"		{ Sound LLUUID } { OwnerID LLUUID } { Gain F32 } { Flags U8 } { Radius F32 }\n"
+		"		{ JointType U8 } { JointPivot LLVector3 } { JointAxisOrAnchor LLVector3 }\n"
+		"	}\n"
+		"}\n"
+		"{\n"
+		"	ImprovedTerseObjectUpdate High 15 Trusted Unencoded\n"
+		"	{ RegionData Single { RegionHandle U64 } { TimeDilation U16 } }\n"
+		"	{ ObjectData Variable { Data Variable 1 } { TextureEntry Variable 2 } }\n"
+		"}\n";
+
+	char* canonical(const char* name)
+	{
+		return LLMessageStringTable::getInstance()->getString(name);
+	}
+}
+
+namespace tut
+{
+	struct templatemessagereader_test
+	{
+		LLTemplateMessageReader::message_template_number_map_t mNumberMap;
+		LLMessageTemplate* mObjectUpdate;
+		LLMessageTemplate* mTerseUpdate;
+		LLTemplateMessageReader* mReader;
+		LLHost mSender;
+		U32 mSeed;
+
+		templatemessagereader_test()
+		:	mObjectUpdate(NULL),
+			mTerseUpdate(NULL),
+			mReader(NULL),
+			mSender("127.0.0.1:13000"),
+			mSeed(0x2468ace)
+		{
+			LLTemplateTokenizer tokens(sTemplates);
+			LLTemplateParser parser(tokens);
+			for (LLTemplateParser::message_iterator iter = parser.getMessagesBegin();
+				 iter != parser.getMessagesEnd(); ++iter)
+			{
+				mNumberMap[(*iter)->mMessageNumber] = *iter;
+			}
+			mObjectUpdate = mNumberMap[12];
+			mTerseUpdate = mNumberMap[15];
+			mReader = new LLTemplateMessageReader(mNumberMap);
+			gRanOffEnd = false;
+		}
+
+		~templatemessagereader_test()
+		{
+			delete mReader;
+			for (LLTemplateMessageReader::message_template_number_map_t::iterator iter = mNumberMap.begin();
+				 iter != mNumberMap.end(); ++iter)
+			{
+				delete iter->second;
+			}
+		}
+
+		U8 nextByte()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			// Keeps the floats finite, the getters would zero them otherwise
+			return (U8)((mSeed >> 16) & 0x3f);
+		}
+
+		// A high frequency packet for templatep with num_objects of each variable block
+		std::vector<U8> makePacket(const LLMessageTemplate* templatep, S32 num_objects)
+		{
+			std::vector<U8> packet(LL_PACKET_ID_SIZE, 0);
+			packet.push_back((U8)templatep->mMessageNumber);
+
+			for (LLMessageTemplate::message_block_map_t::const_iterator block_iter = templatep->mMemberBlocks.begin();
+				 block_iter != templatep->mMemberBlocks.end(); ++block_iter)
+			{
+				const LLMessageBlock* blockp = *block_iter;
+				S32 repeat = 1;
+				if (blockp->mType == MBT_VARIABLE)
+				{
+					repeat = num_objects;
+					packet.push_back((U8)repeat);
+				}
+				for (S32 i = 0; i < repeat; ++i)
+				{
+					for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = blockp->mMemberVariables.begin();
+						 var_iter != blockp->mMemberVariables.end(); ++var_iter)
+					{
+						const LLMessageVariable* varp = *var_iter;
+						S32 size = varp->getSize();
+						if (varp->getType() == MVT_VARIABLE)
+						{
+							// Roughly what prims send: a few dozen bytes, some empty
+							S32 length = (nextByte() & 1) ? 0 : 8 + nextByte();
+							packet.push_back((U8)length);
+							if (size == 2)
+							{
+								packet.push_back(0);
+							}
+							size = length;
+						}
+						for (S32 b = 0; b < size; ++b)
+						{
+							packet.push_back(nextByte());
+						}
+					}
+				}
+			}
+			return packet;
+		}
+
+		void decode(const std::vector<U8>& packet)
+		{
+			mReader->clearMessage();
+			ensure("validate", mReader->validateMessage(&packet[0], (S32)packet.size(), mSender, true));
+			ensure("decode", mReader->decodeMessage(&packet[0], mSender));
+			ensure("ran off the end", !gRanOffEnd);
+		}
+	};
+
+	typedef test_group<templatemessagereader_test> templatemessagereader_t;
+	typedef templatemessagereader_t::object templatemessagereader_object_t;
+	tut::templatemessagereader_t tut_templatemessagereader("LLTemplateMessageReader");
+
+	template<> template<>
+	void templatemessagereader_object_t::test<1>()
+	{
+		ensure("templates", mObjectUpdate && mTerseUpdate);
+
+		LLMessageSlot slot = mObjectUpdate->getSlot(canonical("ObjectData"), canonical("FullID"));
+		ensure("valid slot", slot.isValid());
+		ensure_equals("block index", slot.mBlock, 1);
+		ensure_equals("variable index", slot.mVariable, 2);
+		ensure_equals("variables per block", slot.mNumVariables, (S32)mObjectUpdate->getBlock(canonical("ObjectData"))->mMemberVariables.size());
+
+		ensure("unknown variable", !mObjectUpdate->getSlot(canonical("ObjectData"), canonical("NoSuchVariable")).isValid());
+		ensure("unknown block", !mObjectUpdate->getSlot(canonical("NoSuchBlock"), canonical("ID")).isValid());
+	}
+
+	template<> template<>
+	void templatemessagereader_object_t::test<2>()
+	{
+		// Every variable of every block must read the same by slot and by name
+		const LLMessageTemplate* templates[] = { mObjectUpdate, mTerseUpdate };
+		for (const LLMessageTemplate* templatep : templates)
+		{
+			std::vector<U8> packet = makePacket(templatep, 5);
+			decode(packet);
+
+			for (LLMessageTemplate::message_block_map_t::const_iterator block_iter = templatep->mMemberBlocks.begin();
+				 block_iter != templatep->mMemberBlocks.end(); ++block_iter)
+			{
+				char* blockname = (*block_iter)->mName;
+				for (LLMessageBlock::message_variable_map_t::const_iterator var_iter = (*block_iter)->mMemberVariables.begin();
+					 var_iter != (*block_iter)->mMemberVariables.end(); ++var_iter)
+				{
+					char* varname = (*var_iter)->getName();
+					LLMessageSlot slot = templatep->getSlot(blockname, varname);
+					std::string what = std::string(templatep->mName) + "." + blockname + "." + varname;
+
+					S32 blocks = mReader->getNumberOfBlocks(blockname);
+					ensure_equals(what + " blocks", mReader->getNumberOfBlocks(slot), blocks);
+					for (S32 i = 0; i < blocks; ++i)
+					{
+						S32 size = mReader->getSize(blockname, i, varname);
+						ensure_equals(what + " size", mReader->getSize(slot, i), size);
+
+						std::vector<U8> by_name(size + 1, 0xcd);
+						std::vector<U8> by_slot(size + 1, 0xcd);
+						mReader->getBinaryData(blockname, varname, &by_name[0], 0, i, size);
+						mReader->getBinaryData(slot, &by_slot[0], 0, i, size);
+						ensure(what + " data", by_name == by_slot);
+					}
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void templatemessagereader_object_t::test<3>()
+	{
+		// A slot of another message falls back to the names
+		std::vector<U8> packet = makePacket(mObjectUpdate, 2);
+		decode(packet);
+
+		LLMessageSlot terse_handle = mTerseUpdate->getSlot(canonical("RegionData"), canonical("RegionHandle"));
+		U64 by_name = 0;
+		U64 by_slot = 1;
+		mReader->getU64(canonical("RegionData"), canonical("RegionHandle"), by_name);
+		mReader->getU64(terse_handle, by_slot);
+		ensure_equals("region handle", by_slot, by_name);
+		ensure_equals("blocks", mReader->getNumberOfBlocks(mTerseUpdate->getSlot(canonical("ObjectData"), canonical("Data"))), 2);
+
+		LLVector3 scale_name;
+		LLVector3 scale_slot;
+		mReader->getVector3(canonical("ObjectData"), canonical("Scale"), scale_name, 1);
+		mReader->getVector3(mObjectUpdate->getSlot(canonical("ObjectData"), canonical("Scale")), scale_slot, 1);
+		ensure("scale", scale_name == scale_slot);
+	}
+
+	template<> template<>
+	void templatemessagereader_object_t::test<4>()
+	{
+		// Not a pass/fail test: replays object update packets through the
+		// reader, reads what the viewer's update handlers read by name and
+		// by slot, and reports the cost per packet.
+		const S32 num_packets = 200;
+		const S32 passes = 20;
+		std::vector<std::vector<U8> > packets;
+		for (S32 i = 0; i < num_packets; ++i)
+		{
+			packets.push_back(makePacket(mObjectUpdate, 4));
+			packets.push_back(makePacket(mTerseUpdate, 10));
+		}
+
+		char* region_data = canonical("RegionData");
+		char* object_data = canonical("ObjectData");
+		const char* full_names[] = { "ID", "FullID", "PCode", "CRC", "ParentID", "Sound", "OwnerID", "Gain", "Radius",
+									 "Flags", "Material", "ClickAction", "Scale", "ObjectData", "UpdateFlags", "State",
+									 "NameValue", "Data", "Text", "TextColor", "MediaURL", "ExtraParams", "TextureEntry" };
+		const char* terse_names[] = { "Data", "TextureEntry" };
+
+		// What a handler would set up once when it is registered
+		struct Reads
+		{
+			std::vector<char*> mNames;
+			std::vector<LLMessageSlot> mSlots;
+			LLMessageSlot mRegionHandle;
+		};
+		Reads full;
+		Reads terse;
+		for (const char* name : full_names)
+		{
+			full.mNames.push_back(canonical(name));
+			full.mSlots.push_back(mObjectUpdate->getSlot(object_data, canonical(name)));
+		}
+		for (const char* name : terse_names)
+		{
+			terse.mNames.push_back(canonical(name));
+			terse.mSlots.push_back(mTerseUpdate->getSlot(object_data, canonical(name)));
+		}
+		full.mRegionHandle = mObjectUpdate->getSlot(region_data, canonical("RegionHandle"));
+		terse.mRegionHandle = mTerseUpdate->getSlot(region_data, canonical("RegionHandle"));
+
+		U8 buffer[MTUBYTES];
+		U64 handle = 0;
+		U32 checksum_names = 0;
+		U32 checksum_slots = 0;
+		F64 decode_time = 0.0;
+		F64 name_time = 0.0;
+		F64 slot_time = 0.0;
+		LLTimer timer;
+
+		for (S32 pass = 0; pass < passes; ++pass)
+		{
+			for (size_t p = 0; p < packets.size(); ++p)
+			{
+				const Reads& reads = (p & 1) ? terse : full;
+
+				F64 start = timer.getElapsedTimeF64();
+				decode(packets[p]);
+				F64 decoded = timer.getElapsedTimeF64();
+
+				mReader->getU64(region_data, reads.mRegionHandle.mVarName, handle);
+				S32 blocks = mReader->getNumberOfBlocks(object_data);
+				for (S32 b = 0; b < blocks; ++b)
+				{
+					for (char* var : reads.mNames)
+					{
+						S32 size = mReader->getSize(object_data, b, var);
+						mReader->getBinaryData(object_data, var, buffer, 0, b, MTUBYTES);
+						checksum_names += size + (size > 0 ? buffer[0] : 0);
+					}
+				}
+				F64 named = timer.getElapsedTimeF64();
+
+				mReader->getU64(reads.mRegionHandle, handle);
+				blocks = mReader->getNumberOfBlocks(reads.mSlots[0]);
+				for (S32 b = 0; b < blocks; ++b)
+				{
+					for (const LLMessageSlot& slot : reads.mSlots)
+					{
+						S32 size = mReader->getSize(slot, b);
+						mReader->getBinaryData(slot, buffer, 0, b, MTUBYTES);
+						checksum_slots += size + (size > 0 ? buffer[0] : 0);
+					}
+				}
+				F64 slotted = timer.getElapsedTimeF64();
+
+				decode_time += decoded - start;
+				name_time += named - decoded;
+				slot_time += slotted - named;
+			}
+		}
+
+		ensure_equals("same data read", checksum_slots, checksum_names);
+
+		const F64 count = (F64)(passes * packets.size());
+		LL_INFOS("TemplateMessageReader") << "Per packet: decode " << decode_time * 1000000.0 / count
+										  << " us, reads by name " << name_time * 1000000.0 / count
+										  << " us, reads by slot " << slot_time * 1000000.0 / count << " us" << LL_ENDL;
+	}
+}
@@ -876,6 +876,7 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask, S32 usage)
 	mFinal(false),
 	mEmpty(true),
 	mMappable(false),
+	mThreadedFill(false), // <FS/> Threaded geometry fill
 	mFence(NULL)
 {
 	mMappable = (mUsage == GL_DYNAMIC_DRAW_ARB && !sDisableVBOMapping);
@@ -1785,6 +1786,27 @@ U8* LLVertexBuffer::mapIndexBuffer(S32 index, S32 count, bool map_range)
 	}
 }
 
+// <FS> Threaded geometry fill
+bool LLVertexBuffer::beginThreadedFill()
+{
+	for (S32 type = 0; type < TYPE_TEXTURE_INDEX; ++type)
+	{
+		if (hasDataType(type) && !mapVertexBuffer(type, 0, -1, false))
+		{
+			return false;
+		}
+	}
+
+	if (mNumIndices > 0 && !mapIndexBuffer(0, -1, false))
+	{
+		return false;
+	}
+
+	mThreadedFill = true;
+	return true;
+}
+// </FS>
+
 void LLVertexBuffer::unmapBuffer()
 {
 	if (!useVBOs())
@@ -1974,6 +1996,27 @@ template <class T,S32 type> struct VertexBufferStrider
 					strider_t& strider, 
 					S32 index, S32 count, bool map_range)
 	{
+		// <FS> Threaded geometry fill
+		if (vbo.isThreadedFill())
+		{
+			// Everything is mapped already, no GL calls from here
+			if (type == LLVertexBuffer::TYPE_INDEX)
+			{
+				strider = (T*)(vbo.getMappedIndices() + sizeof(U16)*index);
+				strider.setStride(0);
+				return true;
+			}
+			else if (vbo.hasDataType(type))
+			{
+				strider = (T*)(vbo.getMappedData() + vbo.getOffset(type) + LLVertexBuffer::sTypeSize[type]*index);
+				strider.setStride(LLVertexBuffer::sTypeSize[type]);
+				return true;
+			}
+			LL_ERRS() << "VertexBufferStrider could not find valid vertex data." << LL_ENDL;
+			return false;
+		}
+		// </FS>
+
 		if (type == LLVertexBuffer::TYPE_INDEX)
 		{
 			U8* ptr = vbo.mapIndexBuffer(index, count, map_range);
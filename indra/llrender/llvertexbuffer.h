@@ -244,6 +244,16 @@ public:
     void	setBufferFast(U32 data_mask); 	// calls setupVertexBufferFast(), assumes data_mask is not 0 among other assumptions
 
 	void flush(); //flush pending data to GL memory
+
+	// <FS> Threaded geometry fill
+	// Maps all vertex data and the indices as a whole on the main thread.
+	// Until endThreadedFill(), getXXXStrider() only computes pointers into
+	// that mapping and makes no GL calls, so one other thread at a time may
+	// fill the buffer. Call flush() on the main thread afterwards as usual.
+	bool beginThreadedFill();
+	void endThreadedFill()					{ mThreadedFill = false; }
+	bool isThreadedFill() const				{ return mThreadedFill; }
+	// </FS>
 	// allocate buffer
 	bool	allocateBuffer(S32 nverts, S32 nindices, bool create);
 	virtual bool resizeBuffer(S32 newnverts, S32 newnindices);
@@ -332,6 +342,7 @@ protected:
 	U32		mEmpty : 1;			// if true, client buffer is empty (or NULL). Old values have been discarded.	
 	
 	mutable bool	mMappable;     // if true, use memory mapping to upload data (otherwise doublebuffer and use glBufferSubData)
+	bool	mThreadedFill; // <FS/> if true, strider pointers come from the mapping made by beginThreadedFill()
 
 	S32		mOffsets[TYPE_MAX];
 
@@ -0,0 +1,76 @@
+/**
+ * @file fsavataranimationbatch.cpp
+ * @brief Avatar pose blends and skeleton updates on several threads.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsavataranimationbatch.h"
+
+#include "llparalleljobs.h"
+#include "llviewercontrol.h"
+#include "llvoavatar.h"
+
+namespace
+{
+	// With fewer avatars around posting to the pool costs more than it saves
+	const U32 MIN_BATCH_AVATARS = 4;
+}
+
+// static
+bool FSAvatarAnimationBatch::isEnabled(U32 avatar_count)
+{
+	static LLCachedControl<bool> parallel_animation(gSavedSettings, "FSParallelAvatarAnimation");
+	return parallel_animation && avatar_count >= MIN_BATCH_AVATARS;
+}
+
+void FSAvatarAnimationBatch::addAvatar(LLVOAvatar* avatar, LLAgent& agent, const F64& time)
+{
+	if (avatar->canBatchAnimationUpdate() && avatar->idleUpdateBatched(agent, time))
+	{
+		mAvatars.push_back(avatar);
+	}
+}
+
+U32 FSAvatarAnimationBatch::run()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	const U32 helper_avatars = LL::runParallelJobs((U32)mAvatars.size(), [this](U32 i)
+		{
+			mAvatars[i]->updateSkeletonBatched();
+		});
+
+	// Head offsets, footsteps and skinning flags, in the order the avatars
+	// were added.
+	for (LLVOAvatar* avatar : mAvatars)
+	{
+		avatar->finishSkeletonBatched();
+	}
+	mAvatars.clear();
+
+	return helper_avatars;
+}
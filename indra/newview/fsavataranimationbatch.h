@@ -0,0 +1,69 @@
+/**
+ * @file fsavataranimationbatch.h
+ * @brief Avatar pose blends and skeleton updates on several threads.
+ *
+ * @Description:
+ * LLVOAvatar::idleUpdate() evaluates the motions of an avatar, blends their
+ * joint states into its skeleton and updates the world matrices of all its
+ * joints, one avatar after another on the main thread. Evaluating motions
+ * reaches into visual params, the pipeline, asset loading and the network,
+ * but the blend and the skeleton update only touch the avatar's own joints.
+ * With the batch, every avatar first evaluates its motions on the main
+ * thread; their blends and skeleton updates then run together, one avatar
+ * per job, on the General thread pool and the main thread, and the main
+ * thread collects the results before the rest of the idle update.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_AVATARANIMATIONBATCH_H
+#define FS_AVATARANIMATIONBATCH_H
+
+#include "llpointer.h"
+
+#include <vector>
+
+class LLAgent;
+class LLVOAvatar;
+
+class FSAvatarAnimationBatch
+{
+public:
+	// Main thread. Whether LLViewerObjectList::updateObjects() should batch
+	// its avatars this frame.
+	static bool isEnabled(U32 avatar_count);
+
+	// Main thread. Runs the idle update of avatar up to and including its
+	// motions, unless the avatar has to stay on the plain idle update.
+	void addAvatar(LLVOAvatar* avatar, LLAgent& agent, const F64& time);
+
+	// Main thread. Blends the poses and updates the skeletons of all added
+	// avatars, then finishes their character updates. Returns the number
+	// of avatars updated off the main thread.
+	U32 run();
+
+private:
+	std::vector<LLPointer<LLVOAvatar> > mAvatars;
+};
+
+#endif // FS_AVATARANIMATIONBATCH_H
@@ -0,0 +1,214 @@
+/**
+ * @file fsgeometryfill.cpp
+ * @brief Vertex buffer filling of spatial group rebuilds on several threads.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsgeometryfill.h"
+
+#include "lldrawable.h"
+#include "llface.h"
+#include "llparalleljobs.h"
+#include "llviewercontrol.h"
+#include "llvovolume.h"
+
+#include <atomic>
+
+namespace
+{
+	// With fewer vertices to fill posting to the pool costs more than it saves
+	const U32 MIN_PARALLEL_VERTICES = 4096;
+
+	// Faces of one vertex buffer, filled in order by one thread
+	struct FillJob
+	{
+		LLFace* const*	mFaces;
+		U32				mFaceCount;
+	};
+
+	// What genDrawInfo() did for face. Any thread if the vertex buffer of
+	// face is in threaded fill and it is not an animated child, otherwise
+	// the main thread.
+	void fill_face(LLFace* face)
+	{
+		LLDrawable* drawablep = face->getDrawable();
+		LLVOVolume* vobj = drawablep->getVOVolume();
+		LLVolume* volume = vobj->getVolume();
+
+		if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+		{
+			vobj->updateRelativeXform(true);
+		}
+
+		if (!face->getGeometryVolume(*volume, face->getTEOffset(),
+			vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), face->getGeomIndex(), true))
+		{
+			LL_WARNS() << "Failed to get geometry for face!" << LL_ENDL;
+		}
+
+		if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+		{
+			vobj->updateRelativeXform(false);
+		}
+	}
+}
+
+FSGeometryFill::FSGeometryFill()
+:	mBatchStart(0)
+{
+}
+
+// static
+bool FSGeometryFill::isEnabled()
+{
+	static LLCachedControl<bool> parallel_rebuild(gSavedSettings, "FSParallelGeometryRebuild");
+	return parallel_rebuild && LLFace::canGetGeometryThreaded();
+}
+
+void FSGeometryFill::addFace(LLFace* face)
+{
+	// getGeometryVolume() clears it, and registerFace() right after
+	// genDrawInfo() handed the face over looks at it.
+	LLVOVolume* vobj = face->getDrawable()->getVOVolume();
+	if (face->isState(LLFace::TEXTURE_ANIM) && !vobj->mTexAnimMode)
+	{
+		face->clearState(LLFace::TEXTURE_ANIM);
+	}
+
+	mFaces.push_back(face);
+}
+
+void FSGeometryFill::addBuffer(LLVertexBuffer* buffer)
+{
+	Batch batch;
+	batch.mBuffer = buffer;
+	batch.mFirstFace = mBatchStart;
+	batch.mFaceCount = (U32)mFaces.size() - mBatchStart;
+	batch.mVertexCount = 0;
+	for (U32 i = batch.mFirstFace; i < (U32)mFaces.size(); ++i)
+	{
+		batch.mVertexCount += mFaces[i]->getGeomCount();
+	}
+	batch.mMainThread = mainThreadOnly(batch);
+
+	mBatches.push_back(batch);
+	mBatchStart = (U32)mFaces.size();
+}
+
+bool FSGeometryFill::mainThreadOnly(const Batch& batch) const
+{
+	for (U32 i = batch.mFirstFace; i < batch.mFirstFace + batch.mFaceCount; ++i)
+	{
+		// Animated children move their object while they are filled
+		if (mFaces[i]->getDrawable()->isState(LLDrawable::ANIMATED_CHILD))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FSGeometryFill::genTangents(const Batch& batch) const
+{
+	// The tangents getGeometryVolume() would create in the volume, which
+	// faces of other buffers may share.
+	const bool has_tangents = batch.mBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT);
+	for (U32 i = batch.mFirstFace; i < batch.mFirstFace + batch.mFaceCount; ++i)
+	{
+		LLVOVolume* vobj = mFaces[i]->getDrawable()->getVOVolume();
+		LLVolume* volume = vobj->getVolume();
+		const S32 te = mFaces[i]->getTEOffset();
+		if (te < 0 || te >= volume->getNumVolumeFaces())
+		{
+			continue;
+		}
+
+		const LLTextureEntry* tep = vobj->getTE(te);
+		if (has_tangents ||
+			(tep && (tep->getBumpmap() || tep->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)))
+		{
+			volume->genTangents(te);
+		}
+	}
+}
+
+U32 FSGeometryFill::run()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME;
+
+	std::vector<FillJob> jobs;
+	U32 parallel_vertices = 0;
+	for (Batch& batch : mBatches)
+	{
+		if (!batch.mMainThread)
+		{
+			genTangents(batch);
+			batch.mMainThread = !batch.mBuffer->beginThreadedFill();
+		}
+
+		if (batch.mMainThread)
+		{
+			for (U32 i = batch.mFirstFace; i < batch.mFirstFace + batch.mFaceCount; ++i)
+			{
+				fill_face(mFaces[i]);
+			}
+		}
+		else
+		{
+			FillJob job = { &mFaces[batch.mFirstFace], batch.mFaceCount };
+			jobs.push_back(job);
+			parallel_vertices += batch.mVertexCount;
+		}
+	}
+
+	std::atomic<U32> helper_faces(0);
+	LL::runParallelJobs((U32)jobs.size(), [&jobs, &helper_faces](U32 i)
+		{
+			const FillJob& job = jobs[i];
+			for (U32 j = 0; j < job.mFaceCount; ++j)
+			{
+				fill_face(job.mFaces[j]);
+			}
+			if (!on_main_thread())
+			{
+				helper_faces += job.mFaceCount;
+			}
+		},
+		parallel_vertices >= MIN_PARALLEL_VERTICES ? LL::PARALLEL_JOB_HELPERS : 0);
+
+	for (Batch& batch : mBatches)
+	{
+		batch.mBuffer->endThreadedFill();
+		batch.mBuffer->flush();
+	}
+
+	mFaces.clear();
+	mBatches.clear();
+	mBatchStart = 0;
+
+	return helper_faces;
+}
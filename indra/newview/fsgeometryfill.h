@@ -0,0 +1,84 @@
+/**
+ * @file fsgeometryfill.h
+ * @brief Vertex buffer filling of spatial group rebuilds on several threads.
+ *
+ * @Description:
+ * LLVolumeGeometryManager::genDrawInfo() lays out the render batches of a
+ * spatial group and copies the geometry of every face into its batch's
+ * vertex buffer, one face after another on the main thread. The copying
+ * only reads the volumes and writes the mapped (or client side) buffer, so
+ * it is collected here instead and run once the whole group is laid out,
+ * one vertex buffer per job, on the General thread pool and the main thread.
+ * Mapping the buffers and uploading them stays on the main thread.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_GEOMETRYFILL_H
+#define FS_GEOMETRYFILL_H
+
+#include "llpointer.h"
+#include "llvertexbuffer.h"
+
+#include <vector>
+
+class LLFace;
+
+class FSGeometryFill
+{
+public:
+	FSGeometryFill();
+
+	// Main thread. Whether genDrawInfo() should hand its faces over.
+	static bool isEnabled();
+
+	// Main thread. Takes over the getGeometryVolume() call for face, after
+	// its geometry index and vertex buffer are set.
+	void addFace(LLFace* face);
+	// Main thread. Ends the batch of the faces added since the last call;
+	// buffer is theirs and is flushed by run().
+	void addBuffer(LLVertexBuffer* buffer);
+
+	// Main thread. Fills the faces of all batches and flushes their buffers.
+	// Returns the number of faces filled off the main thread.
+	U32 run();
+
+private:
+	struct Batch
+	{
+		LLPointer<LLVertexBuffer>	mBuffer;
+		U32							mFirstFace;
+		U32							mFaceCount;
+		U32							mVertexCount;
+		bool						mMainThread;
+	};
+
+	bool mainThreadOnly(const Batch& batch) const;
+	void genTangents(const Batch& batch) const;
+
+	std::vector<LLFace*>	mFaces;
+	std::vector<Batch>		mBatches;
+	U32						mBatchStart;
+};
+
+#endif // FS_GEOMETRYFILL_H
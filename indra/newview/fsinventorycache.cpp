@@ -0,0 +1,467 @@
+/**
+ * @file fsinventorycache.cpp
+ * @brief Binary, memory mapped inventory cache file.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsinventorycache.h"
+
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "lltimer.h"
+#include "llviewerinventory.h"
+#include "workqueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace
+{
+	const U32 CACHE_MAGIC = 0x43495346; // "FSIC"
+	// 2: item asset type widened to hold AT_UNKNOWN
+	const U32 CACHE_FORMAT_VERSION = 2;
+	// Records turned into inventory objects by one claim of a thread
+	const U32 RECORDS_PER_CHUNK = 4096;
+	// Most General pool threads helping with one load
+	const U32 MAX_LOAD_HELPERS = 3;
+	const char GENERAL_QUEUE_NAME[] = "General";
+
+	struct CacheHeader
+	{
+		U32	mMagic;
+		U32	mFormatVersion;
+		S32	mInvCacheVersion;		// LLInventoryModel::sCurrentInvCacheVersion
+		U32	mCategoryCount;
+		U32	mItemCount;
+		U32	mStringTableSize;
+	};
+
+	// Strings are offset and length into the string table
+	struct CategoryRecord
+	{
+		LLUUID	mID;
+		LLUUID	mParentID;
+		LLUUID	mOwnerID;
+		S32		mVersion;
+		U32		mNameOffset;
+		U32		mNameLength;
+		S8		mType;
+		S8		mPreferredType;
+		U8		mPad[2];
+	};
+
+	struct ItemRecord
+	{
+		LLUUID	mID;
+		LLUUID	mParentID;
+		LLUUID	mAssetID;
+		LLUUID	mCreatorID;
+		LLUUID	mOwnerID;
+		LLUUID	mLastOwnerID;
+		LLUUID	mGroupID;
+		U32		mMaskBase;
+		U32		mMaskOwner;
+		U32		mMaskGroup;
+		U32		mMaskEveryone;
+		U32		mMaskNext;
+		U32		mFlags;
+		S32		mSalePrice;
+		S32		mCreationDate;
+		U32		mNameOffset;
+		U32		mNameLength;
+		U32		mDescOffset;
+		U32		mDescLength;
+		S16		mType;					// AT_NONE to AT_UNKNOWN
+		S8		mInventoryType;
+		S8		mSaleType;
+	};
+
+	// The records are read in place from the mapping
+	static_assert(sizeof(CacheHeader) == 24, "CacheHeader is part of the file format");
+	static_assert(sizeof(CategoryRecord) == 64, "CategoryRecord is part of the file format");
+	static_assert(sizeof(ItemRecord) == 164, "ItemRecord is part of the file format");
+
+	struct ChunkResult
+	{
+		LLInventoryModel::cat_array_t	mCategories;
+		LLInventoryModel::item_array_t	mItems;
+		uuid_vec_t						mCategoriesToUpdate;
+	};
+
+	// Shared by the main thread and its helpers. A helper that only starts
+	// after the load is over finds no chunk left and does not touch the
+	// mapping anymore.
+	struct LoadState
+	{
+		const CategoryRecord*		mCategories;
+		const ItemRecord*			mItems;
+		const char*					mStrings;
+		U32							mCategoryCount;
+		U32							mRecordCount;
+		U32							mStringTableSize;
+		U32							mChunkCount;
+		std::vector<ChunkResult>	mResults;
+		std::atomic<U32>			mNextChunk;
+		std::atomic<bool>			mCorrupt;
+
+		std::mutex					mDoneMutex;
+		std::condition_variable		mDoneCondition;
+		U32							mDoneChunks;
+	};
+
+	bool add_string(std::string& table, const std::string& str, U32& offset, U32& length)
+	{
+		if (table.size() + str.size() > U32_MAX)
+		{
+			return false;
+		}
+		offset = (U32)table.size();
+		length = (U32)str.size();
+		table.append(str);
+		return true;
+	}
+
+	bool get_string(const LoadState& state, U32 offset, U32 length, std::string& str)
+	{
+		if (offset > state.mStringTableSize || length > state.mStringTableSize - offset)
+		{
+			return false;
+		}
+		str.assign(state.mStrings + offset, length);
+		return true;
+	}
+
+	bool load_category(const LoadState& state, const CategoryRecord& record, ChunkResult& result)
+	{
+		std::string name;
+		if (!get_string(state, record.mNameOffset, record.mNameLength, name))
+		{
+			return false;
+		}
+
+		LLPointer<LLViewerInventoryCategory> cat =
+			new LLViewerInventoryCategory(record.mID, record.mParentID,
+										  (LLFolderType::EType)record.mPreferredType, name, record.mOwnerID);
+		cat->setType((LLAssetType::EType)record.mType);
+		cat->setVersion(record.mVersion);
+		result.mCategories.push_back(cat);
+		return true;
+	}
+
+	// As LLInventoryItem::fromLLSD() and LLInventoryModel::loadFromFile() do it
+	bool load_item(const LoadState& state, const ItemRecord& record, ChunkResult& result)
+	{
+		std::string name;
+		std::string desc;
+		if (!get_string(state, record.mNameOffset, record.mNameLength, name)
+			|| !get_string(state, record.mDescOffset, record.mDescLength, desc))
+		{
+			return false;
+		}
+
+		if (record.mID.isNull())
+		{
+			LL_WARNS("Inventory") << "Ignoring inventory with null item id: " << name << LL_ENDL;
+			return true;
+		}
+
+		LLAssetType::EType type = (LLAssetType::EType)record.mType;
+		if (type == LLAssetType::AT_UNKNOWN)
+		{
+			result.mCategoriesToUpdate.push_back(record.mParentID);
+			return true;
+		}
+
+		LLInventoryType::EType inv_type = (LLInventoryType::EType)record.mInventoryType;
+		if (LLInventoryType::IT_NONE == inv_type || !inventory_and_asset_types_match(inv_type, type))
+		{
+			inv_type = LLInventoryType::defaultForAssetType(type);
+		}
+
+		LLPermissions perm;
+		perm.init(record.mCreatorID, record.mOwnerID, record.mLastOwnerID, record.mGroupID);
+		perm.setMaskBase(record.mMaskBase);
+		perm.setMaskOwner(record.mMaskOwner);
+		perm.setMaskEveryone(record.mMaskEveryone);
+		perm.setMaskGroup(record.mMaskGroup);
+		perm.setMaskNext(record.mMaskNext);
+		perm.fix();
+
+		LLSaleInfo sale_info((LLSaleInfo::EForSale)record.mSaleType, record.mSalePrice);
+		result.mItems.push_back(new LLViewerInventoryItem(record.mID, record.mParentID, perm, record.mAssetID,
+														  type, inv_type, name, desc, sale_info,
+														  record.mFlags, record.mCreationDate));
+		return true;
+	}
+
+	void load_chunk(LoadState& state, U32 chunk)
+	{
+		ChunkResult& result = state.mResults[chunk];
+		const U32 first = chunk * RECORDS_PER_CHUNK;
+		const U32 last = llmin(first + RECORDS_PER_CHUNK, state.mRecordCount);
+		for (U32 index = first; index < last && !state.mCorrupt; ++index)
+		{
+			bool loaded = (index < state.mCategoryCount)
+				? load_category(state, state.mCategories[index], result)
+				: load_item(state, state.mItems[index - state.mCategoryCount], result);
+			if (!loaded)
+			{
+				state.mCorrupt = true;
+			}
+		}
+	}
+
+	// Any thread. Claims chunks until there are none left.
+	void run_chunks(LoadState& state)
+	{
+		for (U32 chunk = state.mNextChunk++; chunk < state.mChunkCount; chunk = state.mNextChunk++)
+		{
+			load_chunk(state, chunk);
+
+			std::lock_guard<std::mutex> lock(state.mDoneMutex);
+			if (++state.mDoneChunks == state.mChunkCount)
+			{
+				state.mDoneCondition.notify_all();
+			}
+		}
+	}
+}
+
+// static
+std::string FSInventoryCache::getFilename(const std::string& llsd_filename)
+{
+	static const std::string LLSD_EXTENSION(".llsd");
+	std::string filename(llsd_filename);
+	if (filename.size() > LLSD_EXTENSION.size()
+		&& !filename.compare(filename.size() - LLSD_EXTENSION.size(), LLSD_EXTENSION.size(), LLSD_EXTENSION))
+	{
+		filename.erase(filename.size() - LLSD_EXTENSION.size());
+	}
+	return filename + ".bin";
+}
+
+// static
+bool FSInventoryCache::load(const std::string& filename,
+							LLInventoryModel::cat_array_t& categories,
+							LLInventoryModel::item_array_t& items,
+							LLInventoryModel::changed_items_t& cats_to_update)
+{
+	if (!LLFile::isfile(filename))
+	{
+		return false;
+	}
+
+	LLTimer timer;
+	LLMappedFile file;
+	if (!file.open(filename, 0, false) || file.getSize() < sizeof(CacheHeader))
+	{
+		LL_WARNS() << "Unable to map inventory cache " << filename << LL_ENDL;
+		return false;
+	}
+
+	const U8* data = file.getData();
+	const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data);
+	if (header->mMagic != CACHE_MAGIC
+		|| header->mFormatVersion != CACHE_FORMAT_VERSION
+		|| header->mInvCacheVersion != LLInventoryModel::sCurrentInvCacheVersion)
+	{
+		LL_INFOS() << "Inventory cache " << filename << " is out of date" << LL_ENDL;
+		return false;
+	}
+
+	const U64 categories_size = (U64)header->mCategoryCount * sizeof(CategoryRecord);
+	const U64 items_size = (U64)header->mItemCount * sizeof(ItemRecord);
+	if ((U64)file.getSize() != sizeof(CacheHeader) + categories_size + items_size + header->mStringTableSize
+		|| (U64)header->mCategoryCount + header->mItemCount > U32_MAX - RECORDS_PER_CHUNK)
+	{
+		LL_WARNS() << "Inventory cache " << filename << " is damaged" << LL_ENDL;
+		return false;
+	}
+
+	std::shared_ptr<LoadState> state = std::make_shared<LoadState>();
+	state->mCategories = reinterpret_cast<const CategoryRecord*>(data + sizeof(CacheHeader));
+	state->mItems = reinterpret_cast<const ItemRecord*>(data + sizeof(CacheHeader) + categories_size);
+	state->mStrings = reinterpret_cast<const char*>(data + sizeof(CacheHeader) + categories_size + items_size);
+	state->mCategoryCount = header->mCategoryCount;
+	state->mRecordCount = header->mCategoryCount + header->mItemCount;
+	state->mStringTableSize = header->mStringTableSize;
+	state->mChunkCount = (state->mRecordCount + RECORDS_PER_CHUNK - 1) / RECORDS_PER_CHUNK;
+	state->mResults.resize(state->mChunkCount);
+	state->mNextChunk = 0;
+	state->mCorrupt = false;
+	state->mDoneChunks = 0;
+
+	// Whatever the General pool does not pick up right away, the main
+	// thread loads itself, so this never waits on a busy pool.
+	LL::WorkQueue::ptr_t queue = LL::WorkQueue::getInstance(GENERAL_QUEUE_NAME);
+	const U32 helpers = queue ? llmin(state->mChunkCount > 0 ? state->mChunkCount - 1 : 0, MAX_LOAD_HELPERS) : 0;
+	for (U32 i = 0; i < helpers; ++i)
+	{
+		if (!queue->tryPost([state]() { run_chunks(*state); }))
+		{
+			break;
+		}
+	}
+	run_chunks(*state);
+	{
+		std::unique_lock<std::mutex> lock(state->mDoneMutex);
+		state->mDoneCondition.wait(lock, [&state]() { return state->mDoneChunks == state->mChunkCount; });
+	}
+
+	// Release the objects here rather than on whichever thread drops the
+	// state last.
+	std::vector<ChunkResult> results;
+	results.swap(state->mResults);
+	if (state->mCorrupt)
+	{
+		LL_WARNS() << "Inventory cache " << filename << " is damaged" << LL_ENDL;
+		return false;
+	}
+
+	categories.reserve(categories.size() + header->mCategoryCount);
+	items.reserve(items.size() + header->mItemCount);
+	for (std::vector<ChunkResult>::iterator it = results.begin(); it != results.end(); ++it)
+	{
+		categories.insert(categories.end(), it->mCategories.begin(), it->mCategories.end());
+		items.insert(items.end(), it->mItems.begin(), it->mItems.end());
+		cats_to_update.insert(it->mCategoriesToUpdate.begin(), it->mCategoriesToUpdate.end());
+	}
+
+	LL_INFOS() << "Loaded " << header->mCategoryCount << " categories and " << header->mItemCount
+			   << " items from " << filename << " in " << timer.getElapsedTimeF32() * 1000.f << " ms" << LL_ENDL;
+	return true;
+}
+
+// static
+bool FSInventoryCache::save(const std::string& filename,
+							const LLInventoryModel::cat_array_t& categories,
+							const LLInventoryModel::item_array_t& items)
+{
+	std::vector<CategoryRecord> category_records;
+	std::vector<ItemRecord> item_records;
+	std::string strings;
+	category_records.reserve(categories.size());
+	item_records.reserve(items.size());
+
+	for (LLInventoryModel::cat_array_t::const_iterator it = categories.begin(); it != categories.end(); ++it)
+	{
+		const LLViewerInventoryCategory* cat = *it;
+		if (cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			continue;
+		}
+
+		CategoryRecord record = {};
+		record.mID = cat->getUUID();
+		record.mParentID = cat->getParentUUID();
+		record.mOwnerID = cat->getOwnerID();
+		record.mVersion = cat->getVersion();
+		record.mType = (S8)cat->getType();
+		record.mPreferredType = (S8)cat->getPreferredType();
+		if (!add_string(strings, cat->getName(), record.mNameOffset, record.mNameLength))
+		{
+			LL_WARNS() << "Inventory too large for " << filename << LL_ENDL;
+			return false;
+		}
+		category_records.push_back(record);
+	}
+
+	for (LLInventoryModel::item_array_t::const_iterator it = items.begin(); it != items.end(); ++it)
+	{
+		const LLViewerInventoryItem* item = *it;
+		const LLPermissions& perm = item->getPermissions();
+		const LLSaleInfo& sale_info = item->getSaleInfo();
+
+		ItemRecord record = {};
+		record.mID = item->getUUID();
+		record.mParentID = item->getParentUUID();
+		record.mAssetID = item->getAssetUUID();
+		record.mCreatorID = perm.getCreator();
+		record.mOwnerID = perm.getOwner();
+		record.mLastOwnerID = perm.getLastOwner();
+		record.mGroupID = perm.getGroup();
+		record.mMaskBase = perm.getMaskBase();
+		record.mMaskOwner = perm.getMaskOwner();
+		record.mMaskGroup = perm.getMaskGroup();
+		record.mMaskEveryone = perm.getMaskEveryone();
+		record.mMaskNext = perm.getMaskNextOwner();
+		record.mFlags = item->getFlags();
+		record.mSalePrice = sale_info.getSalePrice();
+		record.mCreationDate = (S32)item->getCreationDate();
+		record.mType = (S16)item->getType();
+		record.mInventoryType = (S8)item->getInventoryType();
+		record.mSaleType = (S8)sale_info.getSaleType();
+		if (!add_string(strings, item->getName(), record.mNameOffset, record.mNameLength)
+			|| !add_string(strings, item->getDescription(), record.mDescOffset, record.mDescLength))
+		{
+			LL_WARNS() << "Inventory too large for " << filename << LL_ENDL;
+			return false;
+		}
+		item_records.push_back(record);
+	}
+
+	CacheHeader header;
+	header.mMagic = CACHE_MAGIC;
+	header.mFormatVersion = CACHE_FORMAT_VERSION;
+	header.mInvCacheVersion = LLInventoryModel::sCurrentInvCacheVersion;
+	header.mCategoryCount = (U32)category_records.size();
+	header.mItemCount = (U32)item_records.size();
+	header.mStringTableSize = (U32)strings.size();
+
+	// Write next to the old file and swap it in, so a crash half way leaves
+	// the previous cache intact.
+	const std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		LL_WARNS() << "Failed to open file. Unable to save inventory to: " << temp_filename << LL_ENDL;
+		return false;
+	}
+	bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& (category_records.empty() || fwrite(&category_records[0], sizeof(CategoryRecord), category_records.size(), fp) == category_records.size())
+		&& (item_records.empty() || fwrite(&item_records[0], sizeof(ItemRecord), item_records.size(), fp) == item_records.size())
+		&& (strings.empty() || fwrite(strings.data(), 1, strings.size(), fp) == strings.size());
+	written = (fclose(fp) == 0) && written;
+
+#if LL_WINDOWS
+	// _wrename() does not replace an existing file
+	if (written)
+	{
+		LLFile::remove(filename, ENOENT);
+	}
+#endif
+	if (!written || LLFile::rename(temp_filename, filename) != 0)
+	{
+		LL_WARNS() << "Unable to save inventory to: " << filename << LL_ENDL;
+		LLFile::remove(temp_filename);
+		return false;
+	}
+
+	LL_INFOS() << "Inventory saved to " << filename << ": " << header.mCategoryCount << " categories, "
+			   << header.mItemCount << " items." << LL_ENDL;
+	return true;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file fsinventorycache.h
+ * @brief Binary, memory mapped inventory cache file.
+ *
+ * @Description:
+ * Replaces the gzipped LLSD notation inventory cache for the skeleton load
+ * at login. The file is a header, one fixed size record per category and
+ * per item, and a table with the names and descriptions they refer to. It
+ * is mapped read only and the records are turned into inventory objects in
+ * chunks, in parallel on the General thread pool and the main thread.
+ *
+ * The file is written in native byte order; it never leaves the machine
+ * that wrote it. A file with a different format or inventory cache version
+ * is ignored and LLInventoryModel falls back to the LLSD cache.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_INVENTORYCACHE_H
+#define FS_INVENTORYCACHE_H
+
+#include "llinventorymodel.h"
+
+class FSInventoryCache
+{
+	LOG_CLASS(FSInventoryCache);
+
+public:
+	// Binary cache file next to the LLSD cache file llsd_filename
+	static std::string getFilename(const std::string& llsd_filename);
+
+	// Same contract as LLInventoryModel::loadFromFile(): categories and
+	// items are appended, parents of items of unknown type are added to
+	// cats_to_update. Returns false if the file is missing, damaged or of
+	// another version; nothing is added then.
+	static bool load(const std::string& filename,
+					 LLInventoryModel::cat_array_t& categories,
+					 LLInventoryModel::item_array_t& items,
+					 LLInventoryModel::changed_items_t& cats_to_update);
+
+	// Same contract as LLInventoryModel::saveToFile(). Categories of
+	// unknown version are skipped.
+	static bool save(const std::string& filename,
+					 const LLInventoryModel::cat_array_t& categories,
+					 const LLInventoryModel::item_array_t& items);
+};
+
+#endif // FS_INVENTORYCACHE_H
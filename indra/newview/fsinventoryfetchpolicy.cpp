@@ -0,0 +1,55 @@
+/**
+ * @file fsinventoryfetchpolicy.cpp
+ * @brief Scheduling decisions of the pipelined background inventory fetch.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsinventoryfetchpolicy.h"
+
+const S32 FSInventoryFetchPolicy::MAX_WINDOW;
+const U32 FSInventoryFetchPolicy::MAX_BATCH_SIZE;
+
+FSInventoryFetchPolicy::FSInventoryFetchPolicy(U32 window, U32 batch_size)
+:	mWindow((S32)llclamp(window, 1U, (U32)MAX_WINDOW)),
+	mBatchSize(llclamp(batch_size, 1U, MAX_BATCH_SIZE))
+{
+}
+
+// static
+bool FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::EType preferred_type)
+{
+	switch (preferred_type)
+	{
+		case LLFolderType::FT_CURRENT_OUTFIT:
+		case LLFolderType::FT_MY_OUTFITS:
+		case LLFolderType::FT_OUTFIT:
+		case LLFolderType::FT_BODYPART:
+		case LLFolderType::FT_CLOTHING:
+			return true;
+		default:
+			return false;
+	}
+}
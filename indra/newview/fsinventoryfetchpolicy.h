@@ -0,0 +1,60 @@
+/**
+ * @file fsinventoryfetchpolicy.h
+ * @brief Scheduling decisions of the pipelined background inventory fetch.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_INVENTORYFETCHPOLICY_H
+#define FS_INVENTORYFETCHPOLICY_H
+
+#include "llfoldertype.h"
+
+// Used by LLInventoryModelBackgroundFetch when FSPipelinedInventoryFetch
+// is on. Kept apart from the fetcher so it can be tested on its own.
+class FSInventoryFetchPolicy
+{
+public:
+	// Window and batch size as read from FSInventoryFetchWindow and
+	// FSInventoryFetchBatchSize, clamped to what the fetch supports
+	FSInventoryFetchPolicy(U32 window, U32 batch_size);
+
+	S32 getWindow() const { return mWindow; }
+	U32 getBatchSize() const { return mBatchSize; }
+
+	// Whether another batch may be sent with fetches_in_flight requests
+	// still waiting for a response
+	bool canSend(S32 fetches_in_flight) const { return fetches_in_flight < mWindow; }
+
+	// Folders the outfit code will want soon, queued ahead of the rest
+	static bool isPriorityFolder(LLFolderType::EType preferred_type);
+
+	static const S32 MAX_WINDOW = 64;
+	static const U32 MAX_BATCH_SIZE = 100;
+
+private:
+	S32	mWindow;
+	U32	mBatchSize;
+};
+
+#endif // FS_INVENTORYFETCHPOLICY_H
@@ -0,0 +1,68 @@
+/**
+ * @file fsinventoryfilterchange.cpp
+ * @brief Classifies an edit of the inventory filter search string.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsinventoryfilterchange.h"
+
+// static
+FSInventoryFilterChange::EChange FSInventoryFilterChange::classify(const std::string& old_string, const std::string& new_string)
+{
+	// A plain substring search that contains the previous one can only
+	// match fewer items, wherever the characters were typed. Tokens ("+")
+	// and exact matches (quotes) keep to editing at the end.
+	static const std::string TOKEN_CHARS("+\"");
+	const bool plain_search = old_string.find_first_of(TOKEN_CHARS) == std::string::npos
+		&& new_string.find_first_of(TOKEN_CHARS) == std::string::npos;
+	if (plain_search)
+	{
+		if (old_string.find(new_string) != std::string::npos)
+		{
+			return LESS_RESTRICTIVE;
+		}
+		if (new_string.find(old_string) != std::string::npos)
+		{
+			return MORE_RESTRICTIVE;
+		}
+		return UNRELATED;
+	}
+
+	// hitting BACKSPACE, for example
+	if (old_string.size() >= new_string.size()
+		&& !old_string.compare(0, new_string.size(), new_string))
+	{
+		return LESS_RESTRICTIVE;
+	}
+
+	// appending new characters
+	if (old_string.size() < new_string.size()
+		&& !new_string.compare(0, old_string.size(), old_string))
+	{
+		return MORE_RESTRICTIVE;
+	}
+	return UNRELATED;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file fsinventoryfilterchange.h
+ * @brief Classifies an edit of the inventory filter search string.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_INVENTORYFILTERCHANGE_H
+#define FS_INVENTORYFILTERCHANGE_H
+
+// Used by LLInventoryFilter::setFilterSubString() to decide whether only
+// the items that passed before (more restrictive) or only those that
+// failed (less restrictive) have to be filtered again.
+class FSInventoryFilterChange
+{
+public:
+	enum EChange
+	{
+		LESS_RESTRICTIVE,
+		MORE_RESTRICTIVE,
+		UNRELATED
+	};
+
+	// Both strings are trimmed and upper case, as the filter keeps them
+	static EChange classify(const std::string& old_string, const std::string& new_string);
+};
+
+#endif // FS_INVENTORYFILTERCHANGE_H
@@ -0,0 +1,217 @@
+/**
+ * @file fsmeshfacecache.cpp
+ * @brief On-disk cache of decoded and optimized mesh LOD faces.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsmeshfacecache.h"
+
+#include "lldir.h"
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "llvolume.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/range/iterator_range.hpp>
+
+static const char MESH_FACE_CACHE_DIR[] = "meshfaces";
+static const char MESH_FACE_CACHE_EXT[] = ".faces";
+
+FSMeshFaceCache::FSMeshFaceCache(U64 max_bytes)
+:	mCacheDir(getCacheDir()),
+	mMaxBytes(max_bytes),
+	mTempCounter(0),
+	mHits(0),
+	mMisses(0)
+{
+	// Entries are spread over 16 sub directories by the first digit of the mesh id
+	LLFile::mkdir(mCacheDir);
+	const std::string& delim = gDirUtilp->getDirDelimiter();
+	for (const char* digit = "0123456789abcdef"; *digit; ++digit)
+	{
+		LLFile::mkdir(mCacheDir + delim + *digit);
+	}
+}
+
+std::string FSMeshFaceCache::getFilename(const LLVolumeParams& mesh_params, S32 lod) const
+{
+	const std::string id = mesh_params.getSculptID().asString();
+	return llformat("%s%s%c%s%s_%d_%d_%u%s", mCacheDir.c_str(), gDirUtilp->getDirDelimiter().c_str(), id[0], gDirUtilp->getDirDelimiter().c_str(),
+					id.c_str(), lod, mesh_params.getSculptType() & LL_SCULPT_FLAG_MASK, LLVolume::OPTIMIZED_FACES_VERSION, MESH_FACE_CACHE_EXT);
+}
+
+bool FSMeshFaceCache::hasFaces(const LLVolumeParams& mesh_params, S32 lod) const
+{
+	return LLFile::isfile(getFilename(mesh_params, lod));
+}
+
+bool FSMeshFaceCache::loadFaces(const LLVolumeParams& mesh_params, S32 lod, LLVolume* volume)
+{
+	const std::string filename = getFilename(mesh_params, lod);
+
+	bool success = false;
+	{
+		LLMappedFile file;
+		if (!file.open(filename, 0, false))
+		{
+			++mMisses;
+			return false;
+		}
+		success = volume->unpackOptimizedFaces(file.getData(), file.getSize());
+	}
+
+	if (!success)
+	{
+		LL_WARNS() << "Removing corrupt cache entry " << filename << LL_ENDL;
+		LLFile::remove(filename);
+		++mMisses;
+		return false;
+	}
+
+	// The modification time doubles as last access time for purge()
+	boost::system::error_code ec;
+#if LL_WINDOWS
+	boost::filesystem::last_write_time(utf8str_to_utf16str(filename), std::time(nullptr), ec);
+#else
+	boost::filesystem::last_write_time(filename, std::time(nullptr), ec);
+#endif
+
+	++mHits;
+	return true;
+}
+
+void FSMeshFaceCache::storeFaces(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume)
+{
+	std::vector<U8> data;
+	if (!volume->packOptimizedFaces(data))
+	{
+		return;
+	}
+
+	// Write to a temporary file first so a reader never maps a partial entry
+	const std::string filename = getFilename(mesh_params, lod);
+	const std::string temp_filename = llformat("%s.%u.tmp", filename.c_str(), (U32)++mTempCounter);
+
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+	if (!fp)
+	{
+		return;
+	}
+	bool written = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	written = (LLFile::close(fp) == 0) && written;
+
+	if (!written || LLFile::rename(temp_filename, filename, ENOENT) != 0)
+	{
+		// Out of disk space, or another thread stored the same entry first
+		LLFile::remove(temp_filename, ENOENT);
+	}
+}
+
+void FSMeshFaceCache::purge()
+{
+	typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
+	std::vector<file_info_t> file_info;
+
+	boost::system::error_code ec;
+#if LL_WINDOWS
+	std::wstring cache_path(utf8str_to_utf16str(mCacheDir));
+#else
+	std::string cache_path(mCacheDir);
+#endif
+	if (!boost::filesystem::is_directory(cache_path, ec) || ec.failed())
+	{
+		return;
+	}
+
+	const std::time_t stale_temp_time = std::time(nullptr) - 60 * 60;
+	for (auto& entry : boost::make_iterator_range(boost::filesystem::recursive_directory_iterator(cache_path, ec), {}))
+	{
+		if (ec.failed() || !boost::filesystem::is_regular_file(entry, ec) || ec.failed())
+		{
+			continue;
+		}
+
+		const uintmax_t file_size = boost::filesystem::file_size(entry, ec);
+		if (ec.failed())
+		{
+			continue;
+		}
+		const std::time_t file_time = boost::filesystem::last_write_time(entry, ec);
+		if (ec.failed())
+		{
+			continue;
+		}
+
+		if (entry.path().extension().string() != MESH_FACE_CACHE_EXT)
+		{
+			// Leftover of a crash during storeFaces()
+			if (file_time < stale_temp_time)
+			{
+				boost::filesystem::remove(entry.path(), ec);
+			}
+			continue;
+		}
+
+		file_info.push_back(file_info_t(file_time, { file_size, entry.path().string() }));
+	}
+
+	std::sort(file_info.begin(), file_info.end(), [](const file_info_t& x, const file_info_t& y)
+	{
+		return x.first > y.first;
+	});
+
+	uintmax_t total_bytes = 0;
+	U32 removed = 0;
+	for (const file_info_t& entry : file_info)
+	{
+		total_bytes += entry.second.first;
+		if (total_bytes > mMaxBytes)
+		{
+			boost::filesystem::remove(entry.second.second, ec);
+			++removed;
+		}
+	}
+
+	LL_INFOS() << "Mesh face cache holds " << file_info.size() - removed << " entries, removed " << removed
+			   << " to stay within " << mMaxBytes / (1024 * 1024) << " MB" << LL_ENDL;
+}
+
+// static
+std::string FSMeshFaceCache::getCacheDir()
+{
+	return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, MESH_FACE_CACHE_DIR);
+}
+
+// static
+void FSMeshFaceCache::clearCache()
+{
+	const std::string cache_dir = getCacheDir();
+	if (LLFile::isdir(cache_dir))
+	{
+		LL_INFOS() << "Clearing mesh face cache " << cache_dir << LL_ENDL;
+		gDirUtilp->deleteDirAndContents(cache_dir);
+	}
+}
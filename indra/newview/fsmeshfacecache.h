@@ -0,0 +1,89 @@
+/**
+ * @file fsmeshfacecache.h
+ * @brief On-disk cache of decoded and optimized mesh LOD faces.
+ *
+ * @Description:
+ * Loading a mesh LOD from the asset cache means inflating the zlib
+ * compressed LLSD, parsing it, decoding the quantized vertex streams and
+ * running the vertex cache optimizer over every face. This cache keeps the
+ * result of all that - the 16 byte aligned position, normal, texcoord,
+ * index and weight buffers of each LLVolumeFace - in one file per mesh,
+ * LOD and sculpt flags, so a mesh seen before is restored with a few
+ * memcpys from a memory-mapped file.
+ *
+ * Entries are keyed by the volume format version as well, so a format
+ * change just leaves the old files to be purged. The cache only holds
+ * derived data and may be thrown away at any time.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_MESHFACECACHE_H
+#define FS_MESHFACECACHE_H
+
+#include <atomic>
+
+class LLVolume;
+class LLVolumeParams;
+
+// All methods but the static ones may be called from any thread.
+class FSMeshFaceCache
+{
+	LOG_CLASS(FSMeshFaceCache);
+public:
+	FSMeshFaceCache(U64 max_bytes);
+
+	// Cheap check whether an entry exists, does not validate it.
+	bool hasFaces(const LLVolumeParams& mesh_params, S32 lod) const;
+
+	// Restores the faces of volume from the cache. A corrupt entry is
+	// removed and false returned.
+	bool loadFaces(const LLVolumeParams& mesh_params, S32 lod, LLVolume* volume);
+
+	// Writes the faces of a freshly unpacked volume to the cache.
+	void storeFaces(const LLVolumeParams& mesh_params, S32 lod, const LLVolume* volume);
+
+	// Removes the least recently used entries until the cache fits into
+	// its size budget. Walks the cache directory, so best not called on
+	// the main thread.
+	void purge();
+
+	U32 getHits() const		{ return mHits; }
+	U32 getMisses() const	{ return mMisses; }
+
+	static std::string getCacheDir();
+	// Deletes the whole cache; used when the viewer cache gets cleared.
+	static void clearCache();
+
+private:
+	std::string getFilename(const LLVolumeParams& mesh_params, S32 lod) const;
+
+private:
+	const std::string	mCacheDir;
+	const U64			mMaxBytes;
+	std::atomic<U32>	mTempCounter;
+	std::atomic<U32>	mHits;
+	std::atomic<U32>	mMisses;
+};
+
+#endif // FS_MESHFACECACHE_H
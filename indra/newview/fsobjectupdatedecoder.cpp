@@ -0,0 +1,433 @@
+/**
+ * @file fsobjectupdatedecoder.cpp
+ * @brief Stages object update messages and decodes them on a worker thread.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsobjectupdatedecoder.h"
+
+#include "lldatapacker.h"
+#include "llmessagetemplate.h"
+#include "lltimer.h"
+#include "llviewerobject.h"
+#include "llviewerobjectlist.h"
+#include "llviewerregion.h"
+#include "llviewerstatsrecorder.h"
+#include "llvoavatar.h"
+#include "llworld.h"
+#include "message.h"
+#include "object_flags.h"
+#include "threadpool.h"
+
+extern S32 gFullObjectUpdates;		// llviewerobjectlist.cpp
+void update_attached_sounds();		// llviewermessage.cpp
+
+static const char OBJECT_DECODE_QUEUE_NAME[] = "ObjectUpdateDecode";
+// Largest Data field of an ObjectUpdateCompressed block, as processObjectUpdate() reads it
+static const S32 MAX_OBJECT_DATA_SIZE = 2048;
+
+namespace
+{
+	// The ObjectData variables the staging callbacks copy
+	struct StagingSlots
+	{
+		LLMessageSlot mCompressedData;
+		LLMessageSlot mCompressedFlags;
+		LLMessageSlot mCachedID;
+		LLMessageSlot mCachedCRC;
+		LLMessageSlot mCachedFlags;
+	};
+	StagingSlots sSlots;
+	bool sSlotsValid = false;
+
+	void init_slots(LLMessageSystem* msg)
+	{
+		sSlots.mCompressedData = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCompressed, _PREHASH_ObjectData, _PREHASH_Data);
+		sSlots.mCompressedFlags = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCompressed, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+		sSlots.mCachedID = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCached, _PREHASH_ObjectData, _PREHASH_ID);
+		sSlots.mCachedCRC = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCached, _PREHASH_ObjectData, _PREHASH_CRC);
+		sSlots.mCachedFlags = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCached, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+		sSlotsValid = true;
+	}
+}
+
+FSObjectUpdateDecoder::Batch::Batch(bool compressed, U64 region_handle)
+:	mState(QUEUED),
+	mCompressed(compressed),
+	mRegionHandle(region_handle)
+{
+}
+
+FSObjectUpdateDecoder::FSObjectUpdateDecoder()
+:	mPool(NULL),
+	mApplying(false)
+{
+	memset(&mOffsets, 0, sizeof(mOffsets));
+}
+
+FSObjectUpdateDecoder::~FSObjectUpdateDecoder()
+{
+	cleanup();
+}
+
+void FSObjectUpdateDecoder::initThreads(U32 threads)
+{
+	if (mPool || !threads)
+	{
+		return;
+	}
+
+	// LLViewerObject::initVOClasses() has set up the layout by now
+	mOffsets.mID = LLViewerObject::getObjectDataOffset("ID");
+	mOffsets.mLocalID = LLViewerObject::getObjectDataOffset("LocalID");
+	mOffsets.mPCode = LLViewerObject::getObjectDataOffset("PCode");
+	mOffsets.mCRC = LLViewerObject::getObjectDataOffset("CRC");
+	mOffsets.mScale = LLViewerObject::getObjectDataOffset("Scale");
+	mOffsets.mPos = LLViewerObject::getObjectDataOffset("Pos");
+	mOffsets.mRot = LLViewerObject::getObjectDataOffset("Rot");
+	mOffsets.mSpecialCode = LLViewerObject::getObjectDataOffset("SpecialCode");
+	mOffsets.mParentID = LLViewerObject::getObjectDataOffset("ParentID");
+	if (mOffsets.mID < 0 || mOffsets.mParentID < 0)
+	{
+		LL_WARNS() << "Object data layout not initialized, not staging object updates" << LL_ENDL;
+		return;
+	}
+
+	LL_INFOS() << "Decoding object updates on " << threads << " thread(s)" << LL_ENDL;
+	mPool = new LL::ThreadPool(OBJECT_DECODE_QUEUE_NAME, threads, 4096);
+	mPool->start();
+}
+
+void FSObjectUpdateDecoder::cleanup()
+{
+	if (mPool)
+	{
+		mPool->close();
+		delete mPool;
+		mPool = NULL;
+	}
+	// The regions these were for are going away too
+	mBatches.clear();
+}
+
+bool FSObjectUpdateDecoder::stageCompressedUpdate(LLMessageSystem* msg)
+{
+	if (!mPool)
+	{
+		return false;
+	}
+	if (!sSlotsValid)
+	{
+		init_slots(msg);
+	}
+
+	S32 num_objects = msg->getNumberOfBlocksFast(_PREHASH_ObjectData);
+	for (S32 i = 0; i < num_objects; ++i)
+	{
+		U32 flags = 0;
+		msg->getU32Fast(sSlots.mCompressedFlags, flags, i);
+		if (flags & FLAGS_TEMPORARY_ON_REZ)
+		{
+			// Temporary objects bypass the object cache and are created from the
+			// message itself, so the whole message has to go the old way.
+			return false;
+		}
+	}
+
+	U64 region_handle = 0;
+	msg->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+
+	batch_ptr_t batch = std::make_shared<Batch>(true, region_handle);
+	batch->mObjects.resize(num_objects);
+	batch->mData.reserve(num_objects * 256);
+	for (S32 i = 0; i < num_objects; ++i)
+	{
+		DecodedObject& object = batch->mObjects[i];
+		msg->getU32Fast(sSlots.mCompressedFlags, object.mUpdateFlags, i);
+		object.mDataOffset = (S32)batch->mData.size();
+		object.mDataSize = llclamp(msg->getSizeFast(sSlots.mCompressedData, i), 0, MAX_OBJECT_DATA_SIZE);
+		batch->mData.resize(object.mDataOffset + object.mDataSize);
+		if (object.mDataSize > 0)
+		{
+			msg->getBinaryDataFast(sSlots.mCompressedData, &batch->mData[object.mDataOffset], object.mDataSize, i, object.mDataSize);
+		}
+	}
+	gFullObjectUpdates += num_objects;
+
+	queueBatch(batch);
+	return true;
+}
+
+bool FSObjectUpdateDecoder::stageCachedUpdate(LLMessageSystem* msg)
+{
+	if (!mPool)
+	{
+		return false;
+	}
+	if (!sSlotsValid)
+	{
+		init_slots(msg);
+	}
+
+	U64 region_handle = 0;
+	msg->getU64Fast(_PREHASH_RegionData, _PREHASH_RegionHandle, region_handle);
+
+	// Nothing to decode here, the probes only wait for their turn
+	batch_ptr_t batch = std::make_shared<Batch>(false, region_handle);
+	S32 num_objects = msg->getNumberOfBlocksFast(_PREHASH_ObjectData);
+	batch->mProbes.resize(num_objects);
+	for (S32 i = 0; i < num_objects; ++i)
+	{
+		CacheProbe& probe = batch->mProbes[i];
+		msg->getU32Fast(sSlots.mCachedID, probe.mLocalID, i);
+		msg->getU32Fast(sSlots.mCachedCRC, probe.mCRC, i);
+		msg->getU32Fast(sSlots.mCachedFlags, probe.mUpdateFlags, i);
+	}
+	gFullObjectUpdates += num_objects;
+	batch->mState = Batch::DONE;
+
+	mBatches.push_back(batch);
+	return true;
+}
+
+void FSObjectUpdateDecoder::queueBatch(const batch_ptr_t& batch)
+{
+	mBatches.push_back(batch);
+
+	// Holding only a weak reference, a batch dropped by cleanup() is not decoded
+	std::weak_ptr<Batch> weak_batch = batch;
+	bool posted = mPool->getQueue().tryPost([this, weak_batch]()
+		{
+			if (batch_ptr_t batch = weak_batch.lock())
+			{
+				claimAndDecode(*batch);
+			}
+		});
+	if (!posted)
+	{
+		// Queue full or closing, do it here
+		claimAndDecode(*batch);
+	}
+}
+
+bool FSObjectUpdateDecoder::claimAndDecode(Batch& batch) const
+{
+	S32 expected = Batch::QUEUED;
+	if (!batch.mState.compare_exchange_strong(expected, Batch::DECODING))
+	{
+		return false;
+	}
+	decode(batch, batch.mObjects);
+	batch.mState = Batch::DONE;
+	return true;
+}
+
+void FSObjectUpdateDecoder::decode(const Batch& batch, std::vector<DecodedObject>& objects) const
+{
+	LL_PROFILE_ZONE_SCOPED;
+
+	for (DecodedObject& object : objects)
+	{
+		object.mLocalID = 0;
+		object.mCRC = 0;
+		object.mPCode = 0;
+		object.mExtents.mParentID = 0;
+		if (!object.mDataSize)
+		{
+			// pcode 0, applyCompressed() skips it
+			continue;
+		}
+
+		// Same reads as processObjectUpdate(), cacheFullUpdate() and
+		// LLViewerObject::extractSpatialExtents(), without the name lookups
+		LLDataPackerBinaryBuffer dp(const_cast<U8*>(&batch.mData[object.mDataOffset]), object.mDataSize);
+		dp.shift(mOffsets.mID);
+		dp.unpackUUID(object.mFullID, "ID");
+		dp.shift(mOffsets.mLocalID);
+		dp.unpackU32(object.mLocalID, "LocalID");
+		dp.shift(mOffsets.mPCode);
+		dp.unpackU8(object.mPCode, "PCode");
+		dp.shift(mOffsets.mCRC);
+		dp.unpackU32(object.mCRC, "CRC");
+
+		U32 special_code = 0;
+		dp.shift(mOffsets.mSpecialCode);
+		dp.unpackU32(special_code, "SpecialCode");
+		if (special_code & 0x20)
+		{
+			S32 offset = mOffsets.mParentID;
+			if (!(special_code & 0x80))
+			{
+				// No Omega in front of it
+				offset -= sizeof(LLVector3);
+			}
+			dp.shift(offset);
+			dp.unpackU32(object.mExtents.mParentID, "ParentID");
+		}
+
+		dp.shift(mOffsets.mScale);
+		dp.unpackVector3(object.mExtents.mScale, "Scale");
+		dp.shift(mOffsets.mPos);
+		dp.unpackVector3(object.mExtents.mPos, "Pos");
+		LLVector3 rot;
+		dp.shift(mOffsets.mRot);
+		dp.unpackVector3(rot, "Rot");
+		object.mExtents.mRot.unpackFromVector3(rot);
+	}
+}
+
+void FSObjectUpdateDecoder::flush()
+{
+	if (mBatches.empty() || mApplying)
+	{
+		return;
+	}
+	LL_PROFILE_ZONE_SCOPED;
+
+	while (!mBatches.empty())
+	{
+		batch_ptr_t batch = mBatches.front();
+		mBatches.pop_front();
+		if (claimAndDecode(*batch) || batch->mState == Batch::DONE)
+		{
+			apply(*batch, batch->mObjects);
+			continue;
+		}
+
+		// A worker is decoding this one right now. Rather than wait for it,
+		// decode a copy here. Only the fields staged on this thread are read
+		// from mObjects, the worker is writing the others.
+		std::vector<DecodedObject> objects(batch->mObjects.size());
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			objects[i].mUpdateFlags = batch->mObjects[i].mUpdateFlags;
+			objects[i].mDataOffset = batch->mObjects[i].mDataOffset;
+			objects[i].mDataSize = batch->mObjects[i].mDataSize;
+		}
+		decode(*batch, objects);
+		apply(*batch, objects);
+	}
+}
+
+void FSObjectUpdateDecoder::applyReady(F32 max_time)
+{
+	if (mBatches.empty() || mApplying)
+	{
+		return;
+	}
+	LL_PROFILE_ZONE_SCOPED;
+
+	LLTimer timer;
+	do
+	{
+		batch_ptr_t batch = mBatches.front();
+		if (batch->mState != Batch::DONE)
+		{
+			// Keep the order, the rest waits for this one
+			break;
+		}
+		mBatches.pop_front();
+		apply(*batch, batch->mObjects);
+	}
+	while (!mBatches.empty() && timer.getElapsedTimeF32() < max_time);
+}
+
+void FSObjectUpdateDecoder::apply(const Batch& batch, const std::vector<DecodedObject>& objects)
+{
+	mApplying = true;
+
+	S32 old_num_objects = gObjectList.mNumNewObjects;
+	if (batch.mCompressed)
+	{
+		applyCompressed(batch, objects);
+	}
+	else
+	{
+		applyCached(batch);
+	}
+	if (old_num_objects != gObjectList.mNumNewObjects)
+	{
+		update_attached_sounds();
+	}
+
+	mApplying = false;
+}
+
+void FSObjectUpdateDecoder::applyCompressed(const Batch& batch, const std::vector<DecodedObject>& objects)
+{
+	LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(batch.mRegionHandle);
+	if (!regionp)
+	{
+		LL_WARNS() << "Object update from unknown region! " << batch.mRegionHandle << LL_ENDL;
+		return;
+	}
+
+	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+	for (const DecodedObject& object : objects)
+	{
+		if (object.mPCode == 0)
+		{
+			// object creation will fail, LLViewerObject::createObject()
+			LL_WARNS() << "Received object " << object.mFullID
+				<< " with 0 PCode. Local id: " << object.mLocalID
+				<< " Flags: " << object.mUpdateFlags
+				<< " Region: " << regionp->getName()
+				<< " Region id: " << regionp->getRegionID() << LL_ENDL;
+			recorder.objectUpdateFailure(object.mLocalID, OUT_FULL_COMPRESSED, 0);
+			continue;
+		}
+
+		//send to object cache
+		LLDataPackerBinaryBuffer dp(const_cast<U8*>(&batch.mData[object.mDataOffset]), object.mDataSize);
+		regionp->cacheFullUpdate(dp, object.mUpdateFlags, object.mLocalID, object.mCRC, &object.mExtents);
+	}
+
+	recorder.log(0.2f);
+	LLVOAvatar::cullAvatarsByPixelArea();
+}
+
+void FSObjectUpdateDecoder::applyCached(const Batch& batch)
+{
+	LLViewerRegion* regionp = LLWorld::getInstance()->getRegionFromHandle(batch.mRegionHandle);
+	if (!regionp)
+	{
+		LL_WARNS() << "Object update from unknown region! " << batch.mRegionHandle << LL_ENDL;
+		return;
+	}
+
+	LLViewerStatsRecorder& recorder = LLViewerStatsRecorder::instance();
+	for (const CacheProbe& probe : batch.mProbes)
+	{
+		// Lookup data packer and add this id to cache miss lists if necessary.
+		U8 cache_miss_type = LLViewerRegion::CACHE_MISS_TYPE_NONE;
+		if (!regionp->probeCache(probe.mLocalID, probe.mCRC, probe.mUpdateFlags, cache_miss_type))
+		{
+			// Cache Miss.
+			LL_DEBUGS("ObjectUpdate") << "cache miss for id " << probe.mLocalID << " crc " << probe.mCRC << " miss type " << (S32)cache_miss_type << LL_ENDL;
+			recorder.cacheMissEvent(probe.mLocalID, OUT_FULL_CACHED, cache_miss_type, sizeof(U32) * 2);
+		}
+	}
+}
@@ -0,0 +1,174 @@
+/**
+ * @file fsobjectupdatedecoder.h
+ * @brief Stages object update messages and decodes them on a worker thread.
+ *
+ * @Description:
+ * On region entry the simulator sends thousands of ObjectUpdateCompressed
+ * and ObjectUpdateCached messages in a burst. Instead of handling each one
+ * inside its message callback, the callbacks copy the ObjectData blocks into
+ * a batch and queue it. A worker thread unpacks the compressed object data
+ * headers (full and local id, pcode, CRC, parent id, position, scale and
+ * rotation), and the main thread later applies the decoded batches to the
+ * region object caches in the order they arrived, within a time budget per
+ * frame.
+ *
+ * Messages that need the object state to be current - full ObjectUpdates,
+ * terse updates, kills - call flush() first, which applies everything still
+ * queued. Batches no worker has finished yet are decoded on the main thread,
+ * so a flush never waits for the workers.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_OBJECTUPDATEDECODER_H
+#define FS_OBJECTUPDATEDECODER_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "llsingleton.h"
+#include "lluuid.h"
+#include "llquaternion.h"
+#include "v3math.h"
+
+class LLMessageSystem;
+
+namespace LL
+{
+	class ThreadPool;
+}
+
+// Where a packed object sits, as LLViewerObject::extractSpatialExtents() reads it
+struct FSObjectExtents
+{
+	U32				mParentID;
+	LLVector3		mPos;
+	LLVector3		mScale;
+	LLQuaternion	mRot;
+};
+
+// Everything but decode() is main thread only.
+class FSObjectUpdateDecoder : public LLSingleton<FSObjectUpdateDecoder>
+{
+	LLSINGLETON(FSObjectUpdateDecoder);
+	~FSObjectUpdateDecoder();
+	LOG_CLASS(FSObjectUpdateDecoder);
+
+public:
+	// One ObjectData block of an ObjectUpdateCompressed
+	struct DecodedObject
+	{
+		LLUUID			mFullID;
+		U32				mLocalID;
+		U32				mCRC;
+		U32				mUpdateFlags;
+		U8				mPCode;
+		FSObjectExtents	mExtents;
+		// The packed object data, extra parameters included, in Batch::mData
+		S32				mDataOffset;
+		S32				mDataSize;
+	};
+
+	// One ObjectData block of an ObjectUpdateCached
+	struct CacheProbe
+	{
+		U32				mLocalID;
+		U32				mCRC;
+		U32				mUpdateFlags;
+	};
+
+	// Starts the worker threads; 0 leaves staging off and the messages are
+	// handled in their callbacks as before.
+	void initThreads(U32 threads);
+	void cleanup();
+	bool isEnabled() const				{ return mPool != NULL; }
+
+	// Called from the message callbacks. Return false if the message was not
+	// staged; the caller then processes it right away.
+	bool stageCompressedUpdate(LLMessageSystem* msg);
+	bool stageCachedUpdate(LLMessageSystem* msg);
+
+	// Applies all staged batches in order. Call before handling anything
+	// that has to see the earlier updates. Never waits: a batch a worker is
+	// still decoding is decoded again here and the worker's result dropped.
+	void flush();
+	// Applies decoded batches from the front of the queue until max_time
+	// seconds are used up, at least one if there is one. Never waits.
+	void applyReady(F32 max_time);
+
+	size_t getQueuedBatches() const		{ return mBatches.size(); }
+
+private:
+	struct Batch
+	{
+		enum EState
+		{
+			QUEUED = 0,
+			DECODING,
+			DONE
+		};
+
+		Batch(bool compressed, U64 region_handle);
+
+		std::atomic<S32>			mState;
+		const bool					mCompressed;
+		const U64					mRegionHandle;
+		std::vector<U8>				mData;		// Data fields of compressed updates, back to back
+		std::vector<DecodedObject>	mObjects;
+		std::vector<CacheProbe>		mProbes;
+	};
+	typedef std::shared_ptr<Batch> batch_ptr_t;
+
+	// Offsets into the packed object data, from LLViewerObject
+	struct DataOffsets
+	{
+		S32 mID;
+		S32 mLocalID;
+		S32 mPCode;
+		S32 mCRC;
+		S32 mScale;
+		S32 mPos;
+		S32 mRot;
+		S32 mSpecialCode;
+		S32 mParentID;
+	};
+
+	void queueBatch(const batch_ptr_t& batch);
+	// Claims the batch for this thread and decodes it, false if someone else has it already.
+	bool claimAndDecode(Batch& batch) const;
+	// Any thread. Decodes the objects staged in batch into objects, which
+	// holds the same flags, offsets and sizes as batch.mObjects.
+	void decode(const Batch& batch, std::vector<DecodedObject>& objects) const;
+	void apply(const Batch& batch, const std::vector<DecodedObject>& objects);
+	void applyCompressed(const Batch& batch, const std::vector<DecodedObject>& objects);
+	void applyCached(const Batch& batch);
+
+private:
+	LL::ThreadPool*				mPool;
+	DataOffsets					mOffsets;
+	std::deque<batch_ptr_t>		mBatches;
+	bool						mApplying;
+};
+
+#endif // FS_OBJECTUPDATEDECODER_H
@@ -0,0 +1,115 @@
+/**
+ * @file fsoctreeprecull.cpp
+ * @brief Frustum checks of the region spatial partitions ahead of culling.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsoctreeprecull.h"
+
+#include "llparalleljobs.h"
+#include "llspatialpartition.h"
+
+namespace
+{
+	// Tree levels below the partition roots the main thread checks itself,
+	// to split the trees into subtrees of similar size for the threads
+	const U32 PRECULL_SPLIT_DEPTH = 2;
+	// With fewer subtrees posting to the pool costs more than it saves
+	const U32 MIN_PARALLEL_SUBTREES = 8;
+
+	// Subtree whose parent is partly in the frustum
+	struct Subtree
+	{
+		LLSpatialPartition*	mPartition;
+		const OctreeNode*	mNode;
+	};
+
+	struct PrecullState
+	{
+		LLCamera*				mCamera;
+		U32						mPass;
+		std::vector<Subtree>	mSubtrees;
+	};
+
+	// Main thread. Checks node and collects the subtrees left to check.
+	void split(PrecullState& state, LLSpatialPartition* part, const OctreeNode* node, S32 res, U32 depth)
+	{
+		if (part->precull(*state.mCamera, node, res, state.mPass, false) != 1)
+		{
+			return;
+		}
+
+		for (U32 i = 0; i < node->getChildCount(); i++)
+		{
+			if (depth < PRECULL_SPLIT_DEPTH)
+			{
+				split(state, part, node->getChild(i), 1, depth + 1);
+			}
+			else
+			{
+				Subtree subtree = { part, node->getChild(i) };
+				state.mSubtrees.push_back(subtree);
+			}
+		}
+	}
+}
+
+// static
+U32 FSOctreePrecull::run(LLCamera& camera, const std::vector<LLSpatialPartition*>& partitions)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+	static U32 sLastPass = 0;
+	if (++sLastPass == 0)
+	{
+		// 0 means no precull
+		sLastPass = 1;
+	}
+
+	PrecullState state;
+	state.mCamera = &camera;
+	state.mPass = sLastPass;
+
+	for (LLSpatialPartition* part : partitions)
+	{
+		// cull() does the same, this just has to happen before any thread
+		// looks at the bounds.
+		LLViewerOctreeGroup* root = (LLViewerOctreeGroup*)part->mOctree->getListener(0);
+		root->rebound();
+		split(state, part, part->mOctree, 0, 0);
+	}
+
+	const U32 count = (U32)state.mSubtrees.size();
+	LL::runParallelJobs(count, [&state](U32 i)
+		{
+			const Subtree& subtree = state.mSubtrees[i];
+			subtree.mPartition->precull(*state.mCamera, subtree.mNode, 1, state.mPass, true);
+		},
+		count >= MIN_PARALLEL_SUBTREES ? LL::PARALLEL_JOB_HELPERS : 0);
+
+	return state.mPass;
+}
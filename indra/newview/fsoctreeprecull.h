@@ -0,0 +1,53 @@
+/**
+ * @file fsoctreeprecull.h
+ * @brief Frustum checks of the region spatial partitions ahead of culling.
+ *
+ * @Description:
+ * LLPipeline::updateCull() culls the spatial partitions of all regions one
+ * after another on the main thread. Occlusion queries and the cull result
+ * have to stay there, but the frustum checks of the octree groups only read
+ * the trees and the camera. They are run here first, spread over the General
+ * thread pool and the main thread, and the cull picks up their results.
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_OCTREEPRECULL_H
+#define FS_OCTREEPRECULL_H
+
+#include <vector>
+
+class LLCamera;
+class LLSpatialPartition;
+
+class FSOctreePrecull
+{
+public:
+	// Main thread. Rebounds partitions and runs the frustum checks their
+	// cull() does for camera. Returns the cull pass to set
+	// LLViewerOctreeCull::sPrecullPass to while culling them with camera;
+	// nothing may move or change the partitions before that.
+	static U32 run(LLCamera& camera, const std::vector<LLSpatialPartition*>& partitions);
+};
+
+#endif // FS_OCTREEPRECULL_H
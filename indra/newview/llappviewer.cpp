@@ -287,6 +287,8 @@ using namespace LL;
 
 // #include "fstelemetry.h" // <FS:Beq> Tracy profiler support
 #include "fsperfstats.h" // <FS:Beq> performance stats support
+#include "fsmeshfacecache.h" // <FS/> Decoded mesh cache
+#include "fsobjectupdatedecoder.h" // <FS/> Staged object updates
 
 #if LL_LINUX && LL_GTK
 #include "glib.h"
@@ -5098,7 +5100,10 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
 	// Viewer object cache version, change if object update
 	// format changes. JC
-	const U32 INDRA_OBJECT_CACHE_VERSION = 15;
+	// <FS> Async object cache: region cache files have a header now
+	//const U32 INDRA_OBJECT_CACHE_VERSION = 15;
+	const U32 INDRA_OBJECT_CACHE_VERSION = 16;
+	// </FS>
 
 	return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -5131,6 +5136,7 @@ bool LLAppViewer::initCache()
     const uintmax_t disk_cache_size = disk_cache_mb * 1024ULL * 1024ULL;
     // </FS:Ansariel>
 	const bool enable_cache_debug_info = gSavedSettings.getBOOL("EnableDiskCacheDebugInfo");
+	const bool use_packed_disk_cache = gSavedSettings.getBOOL("FSDiskCachePackedStore"); // <FS> Packed asset store
 
 	bool texture_cache_mismatch = false;
     bool remove_vfs_files = false;
@@ -5208,7 +5214,10 @@ bool LLAppViewer::initCache()
 	// </FS:Ansariel>
 
     const std::string cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, cache_dir_name);
-    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
+    // <FS> Packed asset store
+    //LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
+    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, use_packed_disk_cache);
+    // </FS>
 
 	if (!read_only)
 	{
@@ -5232,11 +5241,7 @@ bool LLAppViewer::initCache()
 			// clear the new C++ file system based cache
 			LLDiskCache::getInstance()->clearCache();
 	}
-		else
-		{
-			// purge excessive files from the new file system based cache
-			LLDiskCache::getInstance()->purge();
-		}
+		// <FS/> In-memory LRU access index: LLPurgeDiskCacheThread::run() does the startup purge
 	}
 	LLAppViewer::getPurgeDiskCacheThread()->start();
 
@@ -5312,6 +5317,7 @@ void LLAppViewer::purgeCache()
 		gDirUtilp->deleteDirAndContents(browser_cache);
 	}
 	gDirUtilp->deleteFilesInDir(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, ""), "*");
+	FSMeshFaceCache::clearCache(); // <FS/> Decoded mesh cache
 }
 
 //purge cache immediately, do not wait until the next login.
@@ -6284,6 +6290,11 @@ void LLAppViewer::idleNetwork()
 #endif
 			}
 
+			// <FS> Staged object updates
+			static LLCachedControl<F32> apply_time(gSavedSettings, "FSObjectDecodeApplyTime");
+			FSObjectUpdateDecoder::instance().applyReady(apply_time);
+			// </FS>
+
 			// Handle per-frame message system processing.
 			lmc.processAcks(gSavedSettings.getF32("AckCollectTime"));
 		}
@@ -6433,6 +6444,13 @@ void LLAppViewer::disconnectViewer()
 	// Also writes cached agent settings to gSavedSettings
 	gAgent.cleanup();
 
+	// <FS> Staged object updates: drop what is queued before the regions go
+	if (FSObjectUpdateDecoder::instanceExists())
+	{
+		FSObjectUpdateDecoder::instance().cleanup();
+	}
+	// </FS>
+
 	// This is where we used to call gObjectList.destroy() and then delete gWorldp.
 	// Now we just ask the LLWorld singleton to cleanly shut down.
 	if(LLWorld::instanceExists())
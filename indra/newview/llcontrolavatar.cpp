@@ -379,6 +379,15 @@ void LLControlAvatar::idleUpdate(LLAgent &agent, const F64 &time)
     }
 }
 
+// <FS> Parallel avatar animation
+// virtual
+bool LLControlAvatar::canBatchAnimationUpdate() const
+{
+    // idleUpdate() only kills it this frame
+    return !mMarkedForDeath && LLVOAvatar::canBatchAnimationUpdate();
+}
+// </FS>
+
 bool LLControlAvatar::computeNeedsUpdate()
 {
 	computeUpdatePeriod();
@@ -57,6 +57,7 @@ public:
     void markForDeath();
 
     virtual void idleUpdate(LLAgent &agent, const F64 &time);
+	virtual bool canBatchAnimationUpdate() const; // <FS> Parallel avatar animation
 	virtual bool computeNeedsUpdate();
 	virtual bool updateCharacter(LLAgent &agent);
 
@@ -1335,6 +1335,25 @@ void push_for_transform(LLVertexBuffer* buff, U32 source_count, U32 dest_count)
 	}
 }
 
+// <FS> Parallel geometry rebuild
+namespace
+{
+	// Shared with canGetGeometryThreaded(), which creates it on the main thread
+	LLCachedControl<bool>& use_transform_feedback_control()
+	{
+		static LLCachedControl<bool> use_transform_feedback(gSavedSettings, "RenderUseTransformFeedback", false);
+		return use_transform_feedback;
+	}
+}
+
+// static
+bool LLFace::canGetGeometryThreaded()
+{
+	// The transform feedback path renders into the vertex buffer
+	return !use_transform_feedback_control();
+}
+// </FS>
+
 BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 							   const S32 &f,
 								const LLMatrix4& mat_vert_in, const LLMatrix3& mat_norm_in,
@@ -1608,7 +1627,10 @@ BOOL LLFace::getGeometryVolume(const LLVolume& volume,
         }
     }
 
-	static LLCachedControl<bool> use_transform_feedback(gSavedSettings, "RenderUseTransformFeedback", false);
+	// <FS> Parallel geometry rebuild
+	//static LLCachedControl<bool> use_transform_feedback(gSavedSettings, "RenderUseTransformFeedback", false);
+	LLCachedControl<bool>& use_transform_feedback = use_transform_feedback_control();
+	// </FS>
 
 #ifdef GL_TRANSFORM_FEEDBACK_BUFFER
 	if (use_transform_feedback &&
@@ -168,6 +168,11 @@ public:
 						const LLMatrix4& mat_vert, const LLMatrix3& mat_normal,
 						const U16 &index_offset,
 						bool force_rebuild = false);
+	// <FS> Parallel geometry rebuild
+	// Whether getGeometryVolume() may run off the main thread, for a face
+	// whose vertex buffer is in threaded fill. Main thread only.
+	static bool canGetGeometryThreaded();
+	// </FS>
 
 	// For avatar
 	U16			 getGeometryAvatar(
@@ -50,6 +50,7 @@
 
 // Firestorm includes
 #include "llappearancemgr.h" // needed to query whether we are in COF
+#include "fsinventoryfilterchange.h" // <FS/> Incremental inventory filter
 #ifdef OPENSIM
 #include "fsgridhandler.h" // <FS:Beq> need to check if in opensim
 #endif
@@ -87,7 +88,11 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 	mCurrentGeneration(0),
 	mFirstRequiredGeneration(0),
 	mFirstSuccessGeneration(0),
-	mSearchType(SEARCHTYPE_NAME)
+	mSearchType(SEARCHTYPE_NAME),
+	// <FS> Incremental inventory filter
+	mMatchOffsetItem(NULL),
+	mMatchOffset(std::string::npos)
+	// </FS>
 {
 	// copy mFilterOps into mDefaultFilterOps
 	markDefault();
@@ -97,6 +102,8 @@ LLInventoryFilter::LLInventoryFilter(const Params& p)
 
 bool LLInventoryFilter::check(const LLFolderViewModelItem* item) 
 {
+	mMatchOffsetItem = NULL; // <FS/> Incremental inventory filter
+
 	const LLFolderViewModelItemInventory* listener = dynamic_cast<const LLFolderViewModelItemInventory*>(item);
 
 	// If it's a folder and we're showing all folders, return automatically.
@@ -106,28 +113,35 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
 		return true;
 	}
 	
-	std::string desc = listener->getSearchableCreatorName();
+	// <FS> Incremental inventory filter: only build the string that is
+	// searched, and match names in place. Looking up the creator name of
+	// every item made each keystroke in the search box slow.
+	//std::string desc = listener->getSearchableCreatorName();
+	std::string searchable;
+	const std::string* desc_ptr = &searchable;
 	switch(mSearchType)
 	{
 		case SEARCHTYPE_CREATOR:
-			desc = listener->getSearchableCreatorName();
+			searchable = listener->getSearchableCreatorName();
 			break;
 		case SEARCHTYPE_DESCRIPTION:
-			desc = listener->getSearchableDescription();
+			searchable = listener->getSearchableDescription();
 			break;
 		case SEARCHTYPE_UUID:
-			desc = listener->getSearchableUUIDString();
+			searchable = listener->getSearchableUUIDString();
 			break;
 		// <FS:Ansariel> Allow searching by all
 		case SEARCHTYPE_ALL:
-			desc = listener->getSearchableAll();
+			searchable = listener->getSearchableAll();
 			break;
 		// </FS:Ansariel>
 		case SEARCHTYPE_NAME:
 		default:
-			desc = listener->getSearchableName();
+			desc_ptr = &listener->getSearchableName();
 			break;
 	}
+	const std::string& desc = *desc_ptr;
+	// </FS>
 
 	bool passed = true;
 	// <FS:Ansariel> Allow searching by all
@@ -164,7 +178,19 @@ bool LLInventoryFilter::check(const LLFolderViewModelItem* item)
 	}
 	else
 	{
-		passed = (mFilterSubString.size() ? desc.find(mFilterSubString) != std::string::npos : true);
+		// <FS> Incremental inventory filter
+		//passed = (mFilterSubString.size() ? desc.find(mFilterSubString) != std::string::npos : true);
+		if (mFilterSubString.size())
+		{
+			const std::string::size_type offset = desc.find(mFilterSubString);
+			passed = (offset != std::string::npos);
+			if (desc_ptr != &searchable)
+			{
+				mMatchOffsetItem = item;
+				mMatchOffset = offset;
+			}
+		}
+		// </FS>
 	}
 
 	passed = passed && checkAgainstFilterType(listener);
@@ -659,6 +685,13 @@ std::string::size_type LLInventoryFilter::getStringMatchOffset(LLFolderViewModel
 	if (mSearchType == SEARCHTYPE_NAME || mSearchType == SEARCHTYPE_ALL)
 	// </FS:Ansariel>
 	{
+		// <FS> Incremental inventory filter
+		if (item == mMatchOffsetItem)
+		{
+			mMatchOffsetItem = NULL;
+			return mMatchOffset;
+		}
+		// </FS>
 		return mFilterSubString.size() ? item->getSearchableName().find(mFilterSubString) : std::string::npos;
 	}
 	else
@@ -940,13 +973,19 @@ void LLInventoryFilter::setFilterSubString(const std::string& string)
 			}
 		}
 
-		// hitting BACKSPACE, for example
-		const BOOL less_restrictive = mFilterSubString.size() >= filter_sub_string_new.size()
-			&& !mFilterSubString.substr(0, filter_sub_string_new.size()).compare(filter_sub_string_new);
+		// <FS> Incremental inventory filter
+		//// hitting BACKSPACE, for example
+		//const BOOL less_restrictive = mFilterSubString.size() >= filter_sub_string_new.size()
+		//	&& !mFilterSubString.substr(0, filter_sub_string_new.size()).compare(filter_sub_string_new);
+
+		//// appending new characters
+		//const BOOL more_restrictive = mFilterSubString.size() < filter_sub_string_new.size()
+		//	&& !filter_sub_string_new.substr(0, mFilterSubString.size()).compare(mFilterSubString);
 
-		// appending new characters
-		const BOOL more_restrictive = mFilterSubString.size() < filter_sub_string_new.size()
-			&& !filter_sub_string_new.substr(0, mFilterSubString.size()).compare(mFilterSubString);
+		const FSInventoryFilterChange::EChange change = FSInventoryFilterChange::classify(mFilterSubString, filter_sub_string_new);
+		const BOOL less_restrictive = (change == FSInventoryFilterChange::LESS_RESTRICTIVE);
+		const BOOL more_restrictive = (change == FSInventoryFilterChange::MORE_RESTRICTIVE);
+		// </FS>
 
 		mFilterSubString = filter_sub_string_new;
 		if (exact_token_changed)
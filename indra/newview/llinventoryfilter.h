@@ -373,6 +373,13 @@ private:
 
 	std::vector<std::string> mFilterTokens;
 	std::string				 mExactToken;
+
+	// <FS> Incremental inventory filter
+	// Name match offset found by check(), for the getStringMatchOffset()
+	// call that follows it for the same item.
+	mutable const LLFolderViewModelItem*	mMatchOffsetItem;
+	mutable std::string::size_type			mMatchOffset;
+	// </FS>
 };
 
 #endif
@@ -82,6 +82,7 @@
 
 #include "aoengine.h"
 #include "fsfloaterwearablefavorites.h"
+#include "fsinventorycache.h"
 #include "fslslbridge.h"
 #ifdef OPENSIM
 #include "llviewernetwork.h"
@@ -224,7 +225,7 @@ LLInventoryModel gInventory;
 // Default constructor
 LLInventoryModel::LLInventoryModel()
 :   // These are now ordered, keep them that way.
-	mBacklinkMMap(),
+	mBacklinkMap(), // <FS/> Flat hash maps
 	mIsAgentInvUsable(false),
 	mRootFolderID(),
 	mLibraryRootFolderID(),
@@ -1148,15 +1149,29 @@ LLInventoryModel::item_array_t LLInventoryModel::collectLinksTo(const LLUUID& id
 	if (!obj || obj->getIsLinkType())
 		return items;
 	
-	std::pair<backlink_mmap_t::iterator, backlink_mmap_t::iterator> range = mBacklinkMMap.equal_range(id);
-	for (backlink_mmap_t::iterator it = range.first; it != range.second; ++it)
+	// <FS> Flat hash maps
+	//std::pair<backlink_mmap_t::iterator, backlink_mmap_t::iterator> range = mBacklinkMMap.equal_range(id);
+	//for (backlink_mmap_t::iterator it = range.first; it != range.second; ++it)
+	//{
+	//	LLViewerInventoryItem *item = getItem(it->second);
+	//	if (item)
+	//	{
+	//		items.push_back(item);
+	//	}
+	//}
+	backlink_map_t::const_iterator links = mBacklinkMap.find(id);
+	if (links != mBacklinkMap.end())
 	{
-		LLViewerInventoryItem *item = getItem(it->second);
-		if (item)
+		for (uuid_vec_t::const_iterator it = links->second.begin(); it != links->second.end(); ++it)
 		{
-			items.push_back(item);
+			LLViewerInventoryItem *item = getItem(*it);
+			if (item)
+			{
+				items.push_back(item);
+			}
 		}
 	}
+	// </FS>
 
 	return items;
 }
@@ -2141,9 +2156,25 @@ void LLInventoryModel::cache(
 		INCLUDE_TRASH,
 		can_cache);
 	std::string inventory_filename = getInvCacheAddres(agent_id);
-	saveToFile(inventory_filename, categories, items);
 	std::string gzip_filename(inventory_filename);
 	gzip_filename.append(".gz");
+	// <FS> Binary inventory cache
+	std::string binary_filename = FSInventoryCache::getFilename(inventory_filename);
+	static LLCachedControl<bool> binary_cache(gSavedSettings, "FSBinaryInventoryCache");
+	if (binary_cache)
+	{
+		if (FSInventoryCache::save(binary_filename, categories, items))
+		{
+			// An older LLSD cache would only ever be loaded if the binary one broke
+			LLFile::remove(gzip_filename, ENOENT);
+			return;
+		}
+		LL_WARNS(LOG_INV) << "Unable to save binary inventory cache, saving " << inventory_filename << LL_ENDL;
+	}
+	// Do not let an older binary cache shadow the one saved now
+	LLFile::remove(binary_filename, ENOENT);
+	// </FS>
+	saveToFile(inventory_filename, categories, items);
 	if(gzip_file(inventory_filename, gzip_filename))
 	{
 		LL_DEBUGS(LOG_INV) << "Successfully compressed " << inventory_filename << LL_ENDL;
@@ -2176,46 +2207,38 @@ void LLInventoryModel::addCategory(LLViewerInventoryCategory* category)
 	}
 }
 
+// <FS> Flat hash maps
 bool LLInventoryModel::hasBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id) const
 {
-	std::pair <backlink_mmap_t::const_iterator, backlink_mmap_t::const_iterator> range;
-	range = mBacklinkMMap.equal_range(target_id);
-	for (backlink_mmap_t::const_iterator it = range.first; it != range.second; ++it)
-	{
-		if (it->second == link_id)
-		{
-			return true;
-		}
-	}
-	return false;
+	backlink_map_t::const_iterator links = mBacklinkMap.find(target_id);
+	return links != mBacklinkMap.end()
+		&& std::find(links->second.begin(), links->second.end(), link_id) != links->second.end();
 }
 
 void LLInventoryModel::addBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id)
 {
-	if (!hasBacklinkInfo(link_id, target_id))
+	uuid_vec_t& links = mBacklinkMap[target_id];
+	if (std::find(links.begin(), links.end(), link_id) == links.end())
 	{
-		mBacklinkMMap.insert(std::make_pair(target_id, link_id));
+		links.push_back(link_id);
 	}
 }
 
 void LLInventoryModel::removeBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id)
 {
-	std::pair <backlink_mmap_t::iterator, backlink_mmap_t::iterator> range;
-	range = mBacklinkMMap.equal_range(target_id);
-	for (backlink_mmap_t::iterator it = range.first; it != range.second; )
+	backlink_map_t::iterator links = mBacklinkMap.find(target_id);
+	if (links == mBacklinkMap.end())
 	{
-		if (it->second == link_id)
-		{
-			backlink_mmap_t::iterator delete_it = it; // iterator will be invalidated by erase.
-			++it;
-			mBacklinkMMap.erase(delete_it);
-		}
-		else
-		{
-			++it;
-		}
+		return;
+	}
+	uuid_vec_t& link_ids = links->second;
+	link_ids.erase(std::remove(link_ids.begin(), link_ids.end(), link_id), link_ids.end());
+	if (link_ids.empty())
+	{
+		mBacklinkMap.erase(target_id);
 	}
 }
+// </FS>
 
 void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 {
@@ -2280,7 +2303,7 @@ void LLInventoryModel::empty()
 		mParentChildItemTree.end(),
 		DeletePairedPointer());
 	mParentChildItemTree.clear();
-	mBacklinkMMap.clear(); // forget all backlink information.
+	mBacklinkMap.clear(); // forget all backlink information. // <FS/> Flat hash maps
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
 	mLastItem = NULL;
@@ -2422,6 +2445,15 @@ bool LLInventoryModel::loadSkeleton(
 			LLFile::remove(inventory_filename);
 		}
 
+		// <FS> Binary inventory cache
+		std::string binary_filename = FSInventoryCache::getFilename(inventory_filename);
+		if (LLFile::isfile(binary_filename))
+		{
+			LL_INFOS("LLInventoryModel") << "Purging inventory cache file: " << binary_filename << LL_ENDL;
+			LLFile::remove(binary_filename);
+		}
+		// </FS>
+
 		inventory_filename.append(".gz");
 		if (LLFile::isfile(inventory_filename))
 		{
@@ -2441,6 +2473,15 @@ bool LLInventoryModel::loadSkeleton(
 			LLFile::remove(inventory_filename);
 		}
 
+		// <FS> Binary inventory cache
+		binary_filename = FSInventoryCache::getFilename(inventory_filename);
+		if (LLFile::isfile(binary_filename))
+		{
+			LL_INFOS("LLInventoryModel") << "Purging library cache file: " << binary_filename << LL_ENDL;
+			LLFile::remove(binary_filename);
+		}
+		// </FS>
+
 		inventory_filename.append(".gz");
 		if (LLFile::isfile(inventory_filename))
 		{
@@ -2499,6 +2540,7 @@ bool LLInventoryModel::loadSkeleton(
 	S32 cached_item_count = 0;
 	if(!temp_cats.empty())
 	{
+		mCategoryMap.reserve(mCategoryMap.size() + temp_cats.size()); // <FS/> Flat hash maps
 		update_map_t child_counts;
 		cat_array_t categories;
 		item_array_t items;
@@ -2509,26 +2551,58 @@ bool LLInventoryModel::loadSkeleton(
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+		// <FS> Binary inventory cache, the LLSD cache is the fallback
+		//LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+		//bool remove_inventory_file = false;
+		//if(fp)
+		//{
+		//	fclose(fp);
+		//	fp = NULL;
+		//	if(gunzip_file(gzip_filename, inventory_filename))
+		//	{
+		//		// we only want to remove the inventory file if it was
+		//		// gzipped before we loaded, and we successfully
+		//		// gunziped it.
+		//		remove_inventory_file = true;
+		//	}
+		//	else
+		//	{
+		//		LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+		//	}
+		//}
+		//bool is_cache_obsolete = false;
+		//if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
 		bool remove_inventory_file = false;
-		if(fp)
+		bool is_cache_obsolete = false;
+		bool cache_loaded = false;
+		static LLCachedControl<bool> binary_cache(gSavedSettings, "FSBinaryInventoryCache");
+		if (binary_cache)
 		{
-			fclose(fp);
-			fp = NULL;
-			if(gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
+			cache_loaded = FSInventoryCache::load(FSInventoryCache::getFilename(inventory_filename), categories, items, categories_to_update);
+		}
+		if (!cache_loaded)
+		{
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if(fp)
 			{
-				LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				fclose(fp);
+				fp = NULL;
+				if(gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
+				}
 			}
+			cache_loaded = loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+		if (cache_loaded)
+		// </FS>
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -2594,7 +2668,10 @@ bool LLInventoryModel::loadSkeleton(
 			S32 bad_link_count = 0;
 			S32 good_link_count = 0;
 			S32 recovered_link_count = 0;
-			cat_map_t::iterator unparented = mCategoryMap.end();
+			// <FS> Flat hash maps: no end() kept across inserts
+			//cat_map_t::iterator unparented = mCategoryMap.end();
+			mItemMap.reserve(mItemMap.size() + items.size());
+			// </FS>
 			for(item_array_t::const_iterator item_iter = items.begin();
 				item_iter != items.end();
 				++item_iter)
@@ -2602,7 +2679,10 @@ bool LLInventoryModel::loadSkeleton(
 				LLViewerInventoryItem *item = (*item_iter).get();
 				const cat_map_t::iterator cit = mCategoryMap.find(item->getParentUUID());
 				
-				if(cit != unparented)
+				// <FS> Flat hash maps
+				//if(cit != unparented)
+				if(cit != mCategoryMap.end())
+				// </FS>
 				{
 					const LLViewerInventoryCategory* cat = cit->second.get();
 					if(cat->getVersion() != NO_VERSION)
@@ -2750,6 +2830,10 @@ void LLInventoryModel::buildParentChildMap()
 	cat_array_t* catsp;
 	item_array_t* itemsp;
 	
+	// <FS> Flat hash maps
+	mParentChildCategoryTree.reserve(mCategoryMap.size() + 1);
+	mParentChildItemTree.reserve(mCategoryMap.size());
+	// </FS>
 	for(cat_map_t::iterator cit = mCategoryMap.begin(); cit != mCategoryMap.end(); ++cit)
 	{
 		LLViewerInventoryCategory* cat = cit->second;
@@ -4813,8 +4897,11 @@ LLPointer<LLInventoryValidationInfo> LLInventoryModel::validate() const
 			}
 
 			// Links should not have backlinks.
-			std::pair<backlink_mmap_t::const_iterator, backlink_mmap_t::const_iterator> range = mBacklinkMMap.equal_range(link_id);
-			if (range.first != range.second)
+			// <FS> Flat hash maps
+			//std::pair<backlink_mmap_t::const_iterator, backlink_mmap_t::const_iterator> range = mBacklinkMMap.equal_range(link_id);
+			//if (range.first != range.second)
+			if (mBacklinkMap.count(link_id))
+			// </FS>
 			{
 				LL_WARNS("Inventory") << "Link item " << item->getName() << " has backlinks!" << LL_ENDL;
 			}
@@ -4823,10 +4910,16 @@ LLPointer<LLInventoryValidationInfo> LLInventoryModel::validate() const
 		{
 			// Check the backlinks of a non-link item.
 			const LLUUID& target_id = item->getUUID();
-			std::pair<backlink_mmap_t::const_iterator, backlink_mmap_t::const_iterator> range = mBacklinkMMap.equal_range(target_id);
-			for (backlink_mmap_t::const_iterator it = range.first; it != range.second; ++it)
+			// <FS> Flat hash maps
+			//std::pair<backlink_mmap_t::const_iterator, backlink_mmap_t::const_iterator> range = mBacklinkMMap.equal_range(target_id);
+			//for (backlink_mmap_t::const_iterator it = range.first; it != range.second; ++it)
+			static const uuid_vec_t no_links;
+			backlink_map_t::const_iterator links = mBacklinkMap.find(target_id);
+			const uuid_vec_t& link_ids = (links != mBacklinkMap.end()) ? links->second : no_links;
+			for (uuid_vec_t::const_iterator it = link_ids.begin(); it != link_ids.end(); ++it)
+			// </FS>
 			{
-				const LLUUID& link_id = it->second;
+				const LLUUID& link_id = *it; // <FS/> Flat hash maps
 				LLViewerInventoryItem *link_item = getItem(link_id);
 				if (!link_item || !link_item->getIsLinkType())
 				{
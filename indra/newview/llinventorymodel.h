@@ -36,6 +36,7 @@
 #include "llfoldertype.h"
 #include "llframetimer.h"
 #include "lluuid.h"
+#include "lluuidflatmap.h" // <FS/> Flat hash maps
 #include "llpermissionsflags.h"
 #include "llviewerinventory.h"
 #include "llstring.h"
@@ -214,20 +215,35 @@ private:
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	// <FS> Flat hash maps. Lookups by id are what all of these are used
+	// for, with 100k+ entries on big accounts. The child arrays stay on the
+	// heap, so the pointers handed out by getDirectDescendentsOf() survive
+	// the tables growing.
+	//typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	//typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryItem> > item_map_t;
+	// </FS>
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
-	typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+	// <FS> Flat hash maps
+	//typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
+	//typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+	typedef LLUUIDFlatMap<cat_array_t*> parent_cat_map_t;
+	typedef LLUUIDFlatMap<item_array_t*> parent_item_map_t;
+	// </FS>
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
 
 	// Track links to items and categories. We do not store item or
 	// category pointers here, because broken links are also supported.
-	typedef std::multimap<LLUUID, LLUUID> backlink_mmap_t;
-	backlink_mmap_t mBacklinkMMap; // key = target_id: ID of item, values = link_ids: IDs of item or folder links referencing it.
+	// <FS> Flat hash maps
+	//typedef std::multimap<LLUUID, LLUUID> backlink_mmap_t;
+	//backlink_mmap_t mBacklinkMMap; // key = target_id: ID of item, values = link_ids: IDs of item or folder links referencing it.
+	typedef LLUUIDFlatMap<uuid_vec_t> backlink_map_t;
+	backlink_map_t mBacklinkMap; // key = target_id: ID of item, values = link_ids: IDs of item or folder links referencing it.
+	// </FS>
 	// For internal use only
 	bool hasBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id) const;
 	void addBacklinkInfo(const LLUUID& link_id, const LLUUID& target_id);
@@ -241,6 +257,7 @@ public:
 private:
 	static BOOL sFirstTimeInViewer2;
 	const static S32 sCurrentInvCacheVersion; // expected inventory cache version
+	friend class FSInventoryCache; // <FS/> Binary inventory cache
 
 /**                    Initialization/Setup
  **                                                                            **
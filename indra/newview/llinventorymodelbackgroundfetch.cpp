@@ -43,6 +43,14 @@
 #include "llcorehttputil.h"
 #include "llviewermenu.h"
 #include "llviewernetwork.h"
+#include "fsinventoryfetchpolicy.h" // <FS/> Pipelined inventory fetch
+
+// <FS> Pipelined inventory fetch
+static LLTrace::CountStatHandle<> sInventoryFoldersFetched("inventory_folders_fetched", "Inventory folders received by the background fetch");
+static LLTrace::SampleStatHandle<> sInventoryFetchQueueDepth("inventory_fetch_queue_depth", "Inventory folders and items waiting for the background fetch");
+static LLTrace::SampleStatHandle<> sInventoryFetchesInFlight("inventory_fetches_in_flight", "Background inventory fetch requests waiting for a response");
+static LLTrace::EventStatHandle<F64Seconds> sInventoryFetchLatency("inventory_fetch_latency", "Time from sending a background inventory folder request until its response");
+// </FS>
 
 // History (may be apocryphal)
 //
@@ -173,6 +181,7 @@ private:
 private:
 	LLSD mRequestSD;
 	const uuid_vec_t mRecursiveCatUUIDs; // hack for storing away which cat fetches are recursive
+	LLTimer mRequestTimer; // <FS/> Pipelined inventory fetch
 };
 
 
@@ -194,7 +203,12 @@ LLInventoryModelBackgroundFetch::LLInventoryModelBackgroundFetch():
 	mAllFoldersFetched(FALSE),
 	mRecursiveInventoryFetchStarted(FALSE),
 	mRecursiveLibraryFetchStarted(FALSE),
-	mMinTimeBetweenFetches(0.3f)
+	mMinTimeBetweenFetches(0.3f),
+	// <FS> Pipelined inventory fetch
+	mFetchStatsActive(false),
+	mFoldersFetched(0),
+	mItemsFetched(0)
+	// </FS>
 {}
 
 LLInventoryModelBackgroundFetch::~LLInventoryModelBackgroundFetch()
@@ -255,6 +269,28 @@ void LLInventoryModelBackgroundFetch::addRequestAtBack(const LLUUID & id, BOOL r
 	mFetchQueue.push_back(FetchQueueInfo(id, recursive, is_category));
 }
 
+// <FS> Pipelined inventory fetch
+void LLInventoryModelBackgroundFetch::addFolderRequest(const LLUUID & id, LLFolderType::EType preferred_type, BOOL recursive)
+{
+	static LLCachedControl<bool> pipelined_fetch(gSavedSettings, "FSPipelinedInventoryFetch", false);
+	if (pipelined_fetch && FSInventoryFetchPolicy::isPriorityFolder(preferred_type))
+	{
+		mFetchQueue.push_front(FetchQueueInfo(id, recursive));
+	}
+	else
+	{
+		mFetchQueue.push_back(FetchQueueInfo(id, recursive));
+	}
+}
+
+void LLInventoryModelBackgroundFetch::addFetchedFolders(S32 folders, S32 items)
+{
+	add(sInventoryFoldersFetched, folders);
+	mFoldersFetched += folders;
+	mItemsFetched += items;
+}
+// </FS>
+
 void LLInventoryModelBackgroundFetch::start(const LLUUID& id, BOOL recursive)
 {
 	LLViewerInventoryCategory * cat(gInventory.getCategory(id));
@@ -331,6 +367,17 @@ void LLInventoryModelBackgroundFetch::setAllFoldersFetched()
 	mFolderFetchActive = false;
 	mBackgroundFetchActive = false;
 	LL_INFOS(LOG_INV) << "Inventory background fetch completed" << LL_ENDL;
+
+	// <FS> Pipelined inventory fetch
+	if (mFetchStatsActive)
+	{
+		const F64 seconds = mFetchDuration.getElapsedTimeF64();
+		LL_INFOS(LOG_INV) << "Fetched " << mFoldersFetched << " folders and " << mItemsFetched << " items in "
+						  << seconds << " seconds (" << (seconds > 0.0 ? mFoldersFetched / seconds : 0.0)
+						  << " folders/s)" << LL_ENDL;
+		mFetchStatsActive = false;
+	}
+	// </FS>
 }
 
 void LLInventoryModelBackgroundFetch::backgroundFetchCB(void *)
@@ -564,12 +611,70 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 		// </FS:Ansariel>
 	}
 	
-	if ((mFetchCount > max_concurrent_fetches) ||
-		(mFetchTimer.getElapsedTimeF32() < mMinTimeBetweenFetches))
+	// <FS> Pipelined inventory fetch
+	//if ((mFetchCount > max_concurrent_fetches) ||
+	//	(mFetchTimer.getElapsedTimeF32() < mMinTimeBetweenFetches))
+	//{
+	//	return;
+	//}
+	static LLCachedControl<bool> pipelined_fetch(gSavedSettings, "FSPipelinedInventoryFetch", false);
+	bool sent = false;
+	if (pipelined_fetch)
 	{
-		return;
+		// Keep a window of requests queued on the inventory policy class
+		// instead of sending one small batch per pass, so folders found in one
+		// response are asked for while the others are still on their way.
+		// Folders already known from the cache are walked without a request,
+		// so bound the time spent on them per pass.
+		static LLCachedControl<U32> fetch_window(gSavedSettings, "FSInventoryFetchWindow", 16);
+		static LLCachedControl<U32> fetch_batch_size(gSavedSettings, "FSInventoryFetchBatchSize", 30);
+		static const F64 MAX_QUEUE_TIME = 0.005;
+		const FSInventoryFetchPolicy policy(fetch_window, fetch_batch_size);
+
+		LLTimer queue_timer;
+		while (policy.canSend(mFetchCount)
+			   && !mFetchQueue.empty()
+			   && queue_timer.getElapsedTimeF64() < MAX_QUEUE_TIME)
+		{
+			if (bulkFetchBatch(region, policy.getBatchSize()))
+			{
+				sent = true;
+			}
+		}
 	}
+	else
+	{
+		if ((mFetchCount > max_concurrent_fetches) ||
+			(mFetchTimer.getElapsedTimeF32() < mMinTimeBetweenFetches))
+		{
+			return;
+		}
+		sent = bulkFetchBatch(region, max_batch_size);
+	}
+
+	sample(sInventoryFetchQueueDepth, (F64)mFetchQueue.size());
+	sample(sInventoryFetchesInFlight, (F64)mFetchCount);
 
+	if (sent)
+	{
+		if (!mFetchStatsActive)
+		{
+			mFetchStatsActive = true;
+			mFetchDuration.reset();
+			mFoldersFetched = 0;
+			mItemsFetched = 0;
+		}
+		mFetchTimer.reset();
+	}
+	else if (isBulkFetchProcessingComplete())
+	{
+		setAllFoldersFetched();
+	}
+}
+
+bool LLInventoryModelBackgroundFetch::bulkFetchBatch(LLViewerRegion * region, U32 max_batch_size)
+{
+	// </FS>
 	U32 item_count(0);
 	U32 folder_count(0);
 
@@ -587,7 +692,11 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 	while (! mFetchQueue.empty() 
 			&& (item_count + folder_count) < max_batch_size)
 	{
-		const FetchQueueInfo & fetch_info(mFetchQueue.front());
+		// <FS> Pipelined inventory fetch: children may be queued at the front
+		//const FetchQueueInfo & fetch_info(mFetchQueue.front());
+		const FetchQueueInfo fetch_info(mFetchQueue.front());
+		mFetchQueue.pop_front();
+		// </FS>
 		if (fetch_info.mIsCategory)
 		{
 			const LLUUID & cat_id(fetch_info.mUUID);
@@ -641,7 +750,10 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 							 it != categories->end();
 							 ++it)
 						{
-							mFetchQueue.push_back(FetchQueueInfo((*it)->getUUID(), fetch_info.mRecursive));
+							// <FS> Pipelined inventory fetch
+							//mFetchQueue.push_back(FetchQueueInfo((*it)->getUUID(), fetch_info.mRecursive));
+							addFolderRequest((*it)->getUUID(), (*it)->getPreferredType(), fetch_info.mRecursive);
+							// </FS>
 						}
 					}
 				}
@@ -673,7 +785,7 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 			}
 		}
 
-		mFetchQueue.pop_front();
+		//mFetchQueue.pop_front(); // <FS/> Pipelined inventory fetch
 	}
 
 	// Issue HTTP POST requests to fetch folders and items
@@ -734,12 +846,16 @@ void LLInventoryModelBackgroundFetch::bulkFetch()
 			}
 		} // if (item_count)
 		
-		mFetchTimer.reset();
-	}
-	else if (isBulkFetchProcessingComplete())
-	{
-		setAllFoldersFetched();
+		// <FS> Pipelined inventory fetch
+		//mFetchTimer.reset();
+		return true;
 	}
+	//else if (isBulkFetchProcessingComplete())
+	//{
+	//	setAllFoldersFetched();
+	//}
+	return false;
+	// </FS>
 }
 
 bool LLInventoryModelBackgroundFetch::fetchQueueContainsNoDescendentsOf(const LLUUID & cat_id) const
@@ -765,6 +881,8 @@ namespace
 
 void BGFolderHttpHandler::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response)
 {
+	record(sInventoryFetchLatency, F64Seconds(mRequestTimer.getElapsedTimeF64())); // <FS/> Pipelined inventory fetch
+
 	do  	// Single-pass do-while used for common exit handling
 	{
 		LLCore::HttpStatus status(response->getStatus());
@@ -910,7 +1028,10 @@ void BGFolderHttpHandler::processData(LLSD & content, LLCore::HttpResponse * res
 				const bool recursive(getIsRecursive(tcategory->getUUID()));
 				if (recursive)
 				{
-					fetcher->addRequestAtBack(tcategory->getUUID(), recursive, true);
+					// <FS> Pipelined inventory fetch
+					//fetcher->addRequestAtBack(tcategory->getUUID(), recursive, true);
+					fetcher->addFolderRequest(tcategory->getUUID(), tcategory->getPreferredType(), recursive);
+					// </FS>
 				}
 				else if (! gInventory.isCategoryComplete(tcategory->getUUID()))
 				{
@@ -929,6 +1050,7 @@ void BGFolderHttpHandler::processData(LLSD & content, LLCore::HttpResponse * res
 				
 				gInventory.updateItem(titem);
 			}
+			fetcher->addFetchedFolders(1, items.size()); // <FS/> Pipelined inventory fetch
 
 			// Set version and descendentcount according to message.
 			LLViewerInventoryCategory * cat(gInventory.getCategory(parent_id));
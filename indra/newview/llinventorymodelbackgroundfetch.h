@@ -28,6 +28,10 @@
 #define LL_LLINVENTORYMODELBACKGROUNDFETCH_H
 
 #include "llsingleton.h"
+// <FS> Pipelined inventory fetch
+#include "llfoldertype.h"
+#include "lltimer.h"
+// </FS>
 #include "lluuid.h"
 #include "httpcommon.h"
 #include "httprequest.h"
@@ -35,6 +39,8 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 
+class LLViewerRegion; // <FS/> Pipelined inventory fetch
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Class LLInventoryModelBackgroundFetch
 //
@@ -71,8 +77,21 @@ public:
 	void addRequestAtFront(const LLUUID & id, BOOL recursive, bool is_category);
 	void addRequestAtBack(const LLUUID & id, BOOL recursive, bool is_category);
 
+	// <FS> Pipelined inventory fetch
+	// Queues a folder found by the recursive descent. With FSPipelinedInventoryFetch
+	// on, folders the outfit code will want soon go ahead of the rest.
+	void addFolderRequest(const LLUUID & id, LLFolderType::EType preferred_type, BOOL recursive);
+	// Called by the folder responses, for the fetch statistics
+	void addFetchedFolders(S32 folders, S32 items);
+	// </FS>
+
 protected:
 	void bulkFetch();
+	// <FS> Pipelined inventory fetch
+	// Sends one batch from the front of the queue, returns false when
+	// there was nothing to send.
+	bool bulkFetchBatch(LLViewerRegion * region, U32 max_batch_size);
+	// </FS>
 
 	void backgroundFetch();
 	static void backgroundFetchCB(void*); // background fetch idle function
@@ -90,6 +109,13 @@ private:
 
 	LLFrameTimer mFetchTimer;
 	F32 mMinTimeBetweenFetches;
+
+	// <FS> Pipelined inventory fetch
+	LLTimer mFetchDuration;
+	bool mFetchStatsActive;
+	S32 mFoldersFetched;
+	S32 mItemsFetched;
+	// </FS>
 	
 	// <FS:ND> For legacy inventory
 	BOOL mTimelyFetchPending;
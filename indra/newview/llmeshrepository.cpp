@@ -71,6 +71,8 @@
 #include "bufferstream.h"
 #include "llfasttimer.h"
 #include "llcorehttputil.h"
+#include "threadpool.h" // <FS/> Mesh decode pool
+#include "fsmeshfacecache.h" // <FS/> Decoded mesh cache
 #include "lltrans.h"
 #include "llstatusbar.h"
 #include "llinventorypanel.h"
@@ -115,6 +117,7 @@
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
 //   core     HTTP worker thread:  does the work but doesn't intrude here
+//   pool     0-N "MeshDecode" threads unpacking LODs and skin info (FSMeshDecodeThreads) <FS/> Mesh decode pool
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
 // Sequence of Operations
@@ -187,7 +190,10 @@
 //   the mutex, if any, covering the data and then a list of data
 //   access models each of which is a triplet of the following form:
 //
+// <FS> Mesh decode pool
 //     {ro, wo, rw}.{main, repo, any}.{mutex, none}
+//     {ro, wo, rw}.{main, repo, pool, any}.{mutex, none}
+// </FS>
 //     Type of access:  read-only, write-only, read-write.
 //     Accessing thread or 'any'
 //     Relevant mutex held during access (several may be held) or 'none'
@@ -225,7 +231,7 @@
 //     sHTTPErrorCount                 "
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
-//     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
+//     sCacheBytesRead                 atomic          rw.repo, rw.pool, ro.main          <FS/> Mesh decode pool
 //     sCacheBytesWritten              "
 //     sCacheReads                     "
 //     sCacheWrites                    "
@@ -253,14 +259,17 @@
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
 //     mMeshHeaderSize          mHeaderMutex  rw.repo.mHeaderMutex
 //     mSkinRequests            mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.pool.mMutex, rw.main.mMutex [5] (was:  [0])   <FS/> Mesh decode pool
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], rw.pool.mMutex, ro.main.none [5], rw.main.mMutex   <FS/> Mesh decode pool
+//     mLoadedQ                 mMutex        rw.repo.mMutex, rw.pool.mMutex, ro.main.none [5], rw.main.mMutex   <FS/> Mesh decode pool
+//     mLODCacheMissQ           mMutex        rw.pool.mMutex, ro.repo.none [3], rw.repo.mMutex   <FS/> Mesh decode pool
+//     mSkinCacheMissQ          mMutex        rw.pool.mMutex, ro.repo.none [3], rw.repo.mMutex   <FS/> Mesh decode pool
+//     mDecodesQueued           atomic        rw.repo, rw.pool, ro.main                          <FS/> Mesh decode pool
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -397,13 +406,21 @@ U32 LLMeshRepository::sHTTPErrorCount = 0;
 U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
-U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+// <FS> Mesh decode pool
+//U32 LLMeshRepository::sCacheBytesRead = 0;
+//U32 LLMeshRepository::sCacheBytesWritten = 0;
+std::atomic<U32> LLMeshRepository::sCacheBytesRead(0);
+std::atomic<U32> LLMeshRepository::sCacheBytesWritten(0);
+// </FS>
 U32 LLMeshRepository::sCacheBytesHeaders = 0;
 U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
-U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+// <FS> Mesh decode pool
+//U32 LLMeshRepository::sCacheReads = 0;
+//U32 LLMeshRepository::sCacheWrites = 0;
+std::atomic<U32> LLMeshRepository::sCacheReads(0);
+std::atomic<U32> LLMeshRepository::sCacheWrites(0);
+// </FS>
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 	
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);	// true -> gather cpu metrics
@@ -846,8 +863,31 @@ void log_upload_error(LLCore::HttpStatus status, const LLSD& content,
 	gMeshRepo.uploadError(args);
 }
 
+// <FS> Mesh decode pool
+static LLTrace::SampleStatHandle<> sMeshDecodeQueueDepth("mesh_decode_queue_depth", "Mesh LODs and skin infos waiting for a decode thread");
+static LLTrace::EventStatHandle<F64Milliseconds> sMeshLODDecodeTime("mesh_lod_decode_time", "Time to unpack the faces of one mesh LOD");
+static LLTrace::EventStatHandle<F64Seconds> sMeshFirstLODTime("mesh_first_lod_time", "Time from the first LOD request of a mesh until a LOD of it is loaded");
+
+// Write a block of a mesh asset fetched from the sim into its cache entry
+static void write_mesh_cache(const LLUUID& mesh_id, S32 offset, const U8* data, S32 size)
+{
+	LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+	if (file.getSize() >= offset+size)
+	{
+		file.seek(offset);
+		file.write(data, size);
+		LLMeshRepository::sCacheBytesWritten += size;
+		++LLMeshRepository::sCacheWrites;
+	}
+}
+// </FS>
+
 LLMeshRepoThread::LLMeshRepoThread()
 : LLThread("mesh repo"),
+  mDecodePool(NULL), // <FS/> Mesh decode pool
+  mDecodesQueued(0), // <FS/> Mesh decode pool
+  mFaceCache(NULL), // <FS/> Decoded mesh cache
   mHttpRequest(NULL),
   mHttpOptions(),
   mHttpLargeOptions(),
@@ -875,6 +915,29 @@ LLMeshRepoThread::LLMeshRepoThread()
 	mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
 	mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1); // <FS:Ansariel> [UDP Assets]
 	mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+	// <FS> Mesh decode pool
+	U32 decode_threads = gSavedSettings.getU32("FSMeshDecodeThreads");
+	if (decode_threads > 0)
+	{
+		// Big enough that posting never blocks the repo thread
+		mDecodePool = new LL::ThreadPool("MeshDecode", decode_threads, 1024 * 1024);
+		mDecodePool->start();
+		LL_INFOS(LOG_MESH) << "Decoding meshes on " << decode_threads << " threads" << LL_ENDL;
+	}
+	// </FS>
+
+	// <FS> Decoded mesh cache
+	if (gSavedSettings.getBOOL("FSMeshFaceCache"))
+	{
+		mFaceCache = new FSMeshFaceCache((U64)gSavedSettings.getU32("FSMeshFaceCacheSize") * 1024 * 1024);
+		FSMeshFaceCache* face_cache = mFaceCache;
+		if (!mDecodePool || !mDecodePool->getQueue().postIfOpen([face_cache]() { face_cache->purge(); }))
+		{
+			mFaceCache->purge();
+		}
+	}
+	// </FS>
 }
 
 
@@ -885,6 +948,24 @@ LLMeshRepoThread::~LLMeshRepoThread()
 					   << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
 					   << LL_ENDL;
 
+	// <FS> Mesh decode pool: done with the pool before the mutexes it uses go away
+	if (mDecodePool)
+	{
+		mDecodePool->close();
+		delete mDecodePool;
+		mDecodePool = NULL;
+	}
+	// </FS>
+
+	// <FS> Decoded mesh cache
+	if (mFaceCache)
+	{
+		LL_INFOS(LOG_MESH) << "Mesh face cache hits: " << mFaceCache->getHits() << ", misses: " << mFaceCache->getMisses() << LL_ENDL;
+		delete mFaceCache;
+		mFaceCache = NULL;
+	}
+	// </FS>
+
 	mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
@@ -946,6 +1027,13 @@ void LLMeshRepoThread::run()
 		// in relatively similar manners, remake code to simplify/unify the process,
 		// like processRequests(&requestQ, fetchFunction); which does same thing for each element
 
+        // <FS> Mesh decode pool
+        if (mHttpRequestSet.size() < sRequestHighWater)
+        {
+            processCacheMisses();
+        }
+        // </FS>
+
         if (!mLODReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
         {
             std::list<LODRequest> incomplete;
@@ -1377,7 +1465,10 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
 }
 
 
-bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
+// <FS> Mesh decode pool
+//bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
+bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool use_cache)
+// </FS>
 {
 	
 	if (!mHeaderMutex)
@@ -1409,7 +1500,10 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 		{
 			//check cache for mesh skin info
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			// <FS> Mesh decode pool
+			//if (file.getSize() >= offset+size)
+			if (use_cache && file.getSize() >= offset+size)
+			// </FS>
 			{
 				U8* buffer = new(std::nothrow) U8[size];
 				if (!buffer)
@@ -1431,6 +1525,13 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id)
 
 				if (!zero)
 				{ //attempt to parse
+					// <FS> Mesh decode pool
+					if (decodeSkinInfoAsync(mesh_id, std::vector<U8>(buffer, buffer + size), -1, 0))
+					{
+						delete[] buffer;
+						return true;
+					}
+					// </FS>
 					if (skinInfoReceived(mesh_id, buffer, size))
 					{						
 						delete[] buffer;
@@ -1795,7 +1896,10 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+// <FS> Mesh decode pool
+//bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool use_cache)
+// </FS>
 {
 	if (!mHeaderMutex)
 	{
@@ -1820,10 +1924,19 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 				
 		if (version <= MAX_MESH_VERSION && offset >= 0 && size > 0)
 		{
+			// <FS> Decoded mesh cache
+			if (use_cache && mFaceCache && loadCachedFacesAsync(mesh_params, lod, offset, size))
+			{
+				return true;
+			}
+			// </FS>
 
 			//check cache for mesh asset
 			LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
-			if (file.getSize() >= offset+size)
+			// <FS> Mesh decode pool
+			//if (file.getSize() >= offset+size)
+			if (use_cache && file.getSize() >= offset+size)
+			// </FS>
 			{
 				U8* buffer = new(std::nothrow) U8[size];
 				if (!buffer)
@@ -1847,6 +1960,13 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
 				if (!zero)
 				{ //attempt to parse
+					// <FS> Mesh decode pool
+					if (decodeMeshLODAsync(mesh_params, lod, std::vector<U8>(buffer, buffer + size), -1, 0))
+					{
+						delete[] buffer;
+						return true;
+					}
+					// </FS>
 					if (lodReceived(mesh_params, lod, buffer, size) == MESH_OK)
 					{
 						delete[] buffer;
@@ -1953,10 +2073,16 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
 		data_size = dsize;
 
-		boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
+		// <FS> Buffer parse
+		//boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
+		// </FS>
 		// </FS:Beq pp Rye> 
 
-		if (!LLSDSerialize::fromBinary(header, stream, data_size))
+		// <FS> Buffer parse
+		//if (!LLSDSerialize::fromBinary(header, stream, data_size))
+		size_t header_bytes = 0;
+		if (!LLSDSerialize::fromBinary(header, (const U8*)result_ptr, data_size, -1, &header_bytes))
+		// </FS>
 		{
 			LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
 							   << LL_ENDL;
@@ -1977,7 +2103,10 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 		// make sure there is at least one lod, function returns -1 and marks as 404 otherwise
 		else if (LLMeshRepository::getActualMeshLOD(header, 0) >= 0)
 		{
-			header_size += stream.tellg();
+			// <FS> Buffer parse
+			//header_size += stream.tellg();
+			header_size += (U32)header_bytes;
+			// </FS>
 		}
 	}
 	else
@@ -2023,6 +2152,7 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 		return MESH_NO_DATA;
 	}
 
+	LLTimer decode_timer; // <FS/> Mesh decode pool
 	LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
 	// <FS:Beq pp Rye> Reduce temporaries and copes in decoding mesh headers
 	// std::istringstream stream;
@@ -2043,7 +2173,16 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
 	{
 		if (volume->getNumFaces() > 0)
 		{
-			LoadedMesh mesh(volume, mesh_params, lod);
+			// <FS> Decoded mesh cache
+			if (mFaceCache)
+			{
+				mFaceCache->storeFaces(mesh_params, lod, volume);
+			}
+			// </FS>
+			// <FS> Mesh decode pool
+			//LoadedMesh mesh(volume, mesh_params, lod);
+			LoadedMesh mesh(volume, mesh_params, lod, F64Seconds(decode_timer.getElapsedTimeF64()));
+			// </FS>
 			{
 				LLMutexLock lock(mMutex);
 				mLoadedQ.push(mesh);
@@ -2105,6 +2244,222 @@ bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 dat
 	return true;
 }
 
+// <FS> Mesh decode pool
+bool LLMeshRepoThread::decodeMeshLODAsync(const LLVolumeParams& mesh_params, S32 lod, std::vector<U8>&& data, S32 cache_offset, S32 cache_size)
+{
+	if (!mDecodePool)
+	{
+		return false;
+	}
+
+	++mDecodesQueued;
+	bool posted = mDecodePool->getQueue().postIfOpen(
+		[this, mesh_params, lod, data = std::move(data), cache_offset, cache_size]() mutable
+		{
+			--mDecodesQueued;
+			S32 data_size = (S32)data.size();
+			EMeshProcessingResult result = lodReceived(mesh_params, lod, data.data(), data_size);
+			if (cache_offset < 0)
+			{
+				if (result != MESH_OK)
+				{
+					// Unusable cache entry, fetch from sim
+					LLMutexLock lock(mMutex);
+					mLODCacheMissQ.push(LODRequest(mesh_params, lod));
+				}
+			}
+			else if (result == MESH_OK)
+			{
+				// good fetch from sim, write to cache
+				write_mesh_cache(mesh_params.getSculptID(), cache_offset, data.data(), llmin(cache_size, data_size));
+			}
+			else
+			{
+				LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_params.getSculptID()
+								   << ", Reason: " << result
+								   << " LOD: " << lod
+								   << " Data size: " << data_size
+								   << " Not retrying."
+								   << LL_ENDL;
+				LLMutexLock lock(mMutex);
+				mUnavailableQ.push(LODRequest(mesh_params, lod));
+			}
+		});
+	if (!posted)
+	{
+		// Pool closed, the viewer is shutting down
+		--mDecodesQueued;
+	}
+	return true;
+}
+
+// <FS> Decoded mesh cache
+bool LLMeshRepoThread::loadCachedFacesAsync(const LLVolumeParams& mesh_params, S32 lod, S32 offset, S32 size)
+{
+	if (!mDecodePool || !mFaceCache->hasFaces(mesh_params, lod))
+	{
+		return false;
+	}
+
+	++mDecodesQueued;
+	bool posted = mDecodePool->getQueue().postIfOpen(
+		[this, mesh_params, lod, offset, size]()
+		{
+			--mDecodesQueued;
+
+			LLTimer decode_timer;
+			LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+			if (mFaceCache->loadFaces(mesh_params, lod, volume) && volume->getNumFaces() > 0)
+			{
+				LoadedMesh mesh(volume, mesh_params, lod, F64Seconds(decode_timer.getElapsedTimeF64()));
+				LLMutexLock lock(mMutex);
+				mLoadedQ.push(mesh);
+				// see lodReceived(), the last reference must go away under the lock
+				volume = NULL;
+				mesh.mVolume = NULL;
+				return;
+			}
+			volume = NULL;
+
+			// Unusable entry, it has been removed. Unpack the asset instead
+			// (which stores a fresh entry), or fetch it from the sim.
+			EMeshProcessingResult result = MESH_NO_DATA;
+			LLFileSystem file(mesh_params.getSculptID(), LLAssetType::AT_MESH);
+			if (file.getSize() >= offset + size)
+			{
+				std::vector<U8> buffer(size);
+				LLMeshRepository::sCacheBytesRead += size;
+				++LLMeshRepository::sCacheReads;
+				file.seek(offset);
+				file.read(buffer.data(), size);
+				result = lodReceived(mesh_params, lod, buffer.data(), size);
+			}
+			if (result != MESH_OK)
+			{
+				LLMutexLock lock(mMutex);
+				mLODCacheMissQ.push(LODRequest(mesh_params, lod));
+			}
+		});
+	if (!posted)
+	{
+		// Pool closed, the viewer is shutting down
+		--mDecodesQueued;
+	}
+	return true;
+}
+// </FS>
+
+bool LLMeshRepoThread::decodeSkinInfoAsync(const LLUUID& mesh_id, std::vector<U8>&& data, S32 cache_offset, S32 cache_size)
+{
+	if (!mDecodePool)
+	{
+		return false;
+	}
+
+	++mDecodesQueued;
+	bool posted = mDecodePool->getQueue().postIfOpen(
+		[this, mesh_id, data = std::move(data), cache_offset, cache_size]() mutable
+		{
+			--mDecodesQueued;
+			S32 data_size = (S32)data.size();
+			if (skinInfoReceived(mesh_id, data.data(), data_size))
+			{
+				if (cache_offset >= 0)
+				{
+					// good fetch from sim, write to cache
+					write_mesh_cache(mesh_id, cache_offset, data.data(), llmin(cache_size, data_size));
+				}
+			}
+			else if (cache_offset < 0)
+			{
+				// Unusable cache entry, fetch from sim
+				LLMutexLock lock(mMutex);
+				mSkinCacheMissQ.push(UUIDBasedRequest(mesh_id));
+			}
+			else
+			{
+				LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+								   << ", Unknown reason.  Not retrying."
+								   << LL_ENDL;
+			}
+		});
+	if (!posted)
+	{
+		--mDecodesQueued;
+	}
+	return true;
+}
+
+void LLMeshRepoThread::processCacheMisses()
+{
+	if (mLODCacheMissQ.empty() && mSkinCacheMissQ.empty())
+	{
+		return;
+	}
+
+	std::queue<LODRequest> lod_misses;
+	std::queue<UUIDBasedRequest> skin_misses;
+	{
+		LLMutexLock lock(mMutex);
+		lod_misses.swap(mLODCacheMissQ);
+		skin_misses.swap(mSkinCacheMissQ);
+	}
+
+	std::list<LODRequest> lod_incomplete;
+	while (!lod_misses.empty())
+	{
+		LODRequest req = lod_misses.front();
+		lod_misses.pop();
+		if (req.isDelayed())
+		{
+			lod_incomplete.push_back(req);
+		}
+		else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry(), false))
+		{
+			if (req.canRetry())
+			{
+				req.updateTime();
+				lod_incomplete.push_back(req);
+			}
+			else
+			{
+				LLMutexLock lock(mMutex);
+				mUnavailableQ.push(req);
+			}
+		}
+	}
+
+	std::list<UUIDBasedRequest> skin_incomplete;
+	while (!skin_misses.empty())
+	{
+		UUIDBasedRequest req = skin_misses.front();
+		skin_misses.pop();
+		if (req.isDelayed())
+		{
+			skin_incomplete.push_back(req);
+		}
+		else if (!fetchMeshSkinInfo(req.mId, false) && req.canRetry())
+		{
+			req.updateTime();
+			skin_incomplete.push_back(req);
+		}
+	}
+
+	if (!lod_incomplete.empty() || !skin_incomplete.empty())
+	{
+		LLMutexLock lock(mMutex);
+		for (const LODRequest& req : lod_incomplete)
+		{
+			mLODCacheMissQ.push(req);
+		}
+		for (const UUIDBasedRequest& req : skin_incomplete)
+		{
+			mSkinCacheMissQ.push(req);
+		}
+	}
+}
+// </FS>
+
 bool LLMeshRepoThread::decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD decomp;
@@ -2994,6 +3349,8 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 		return;
 	}
 
+	sample(sMeshDecodeQueueDepth, (F64)mDecodesQueued.load()); // <FS/> Mesh decode pool
+
 	while (!mLoadedQ.empty())
 	{
 		mMutex->lock();
@@ -3007,6 +3364,7 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 		mMutex->unlock();
 		
 		update_metrics = true;
+		record(sMeshLODDecodeTime, mesh.mDecodeTime); // <FS/> Mesh decode pool
 		if (mesh.mVolume->getNumVolumeFaces() > 0)
 		{
 			gMeshRepo.notifyMeshLoaded(mesh.mMeshParams, mesh.mVolume);
@@ -3436,6 +3794,13 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
 	if ((!MESH_LOD_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
 	{
+		// <FS> Mesh decode pool: unpacked and written to the cache there
+		if (gMeshRepo.mThread->mDecodePool && data_size > 0)
+		{
+			gMeshRepo.mThread->decodeMeshLODAsync(mMeshParams, mLOD, std::vector<U8>(data, data + data_size), mOffset, mRequestedBytes);
+			return;
+		}
+		// </FS>
 		EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
 		if (result == MESH_OK)
 		{
@@ -3501,6 +3866,16 @@ void LLMeshSkinInfoHandler::processFailure(LLCore::HttpStatus status)
 void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /* body_offset */,
 										U8 * data, S32 data_size)
 {
+	// <FS> Mesh decode pool: unpacked and written to the cache there
+	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
+		&& gMeshRepo.mThread->mDecodePool
+		&& data && data_size > 0)
+	{
+		gMeshRepo.mThread->decodeSkinInfoAsync(mMeshID, std::vector<U8>(data, data + data_size), mOffset, mRequestedBytes);
+		return;
+	}
+	// </FS>
+
 	if ((!MESH_SKIN_INFO_PROCESS_FAILED)
 		&& ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
 		&& gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size))
@@ -3761,6 +4136,7 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
 		{
 			//first request for this mesh
 			mLoadingMeshes[detail][mesh_params].insert(vobj->getID());
+			mFirstLODRequestTime.emplace(mesh_params.getSculptID(), F64Seconds(LLTimer::getTotalSeconds())); // <FS/> Mesh decode pool
 			mPendingRequests.push_back(LLMeshRepoThread::LODRequest(mesh_params, detail));
 			LLMeshRepository::sLODPending++;
 		}
@@ -4207,6 +4583,15 @@ void LLMeshRepository::notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVol
 		}
 		
 		mLoadingMeshes[detail].erase(mesh_params);
+
+		// <FS> Mesh decode pool
+		auto request_time = mFirstLODRequestTime.find(mesh_params.getSculptID());
+		if (request_time != mFirstLODRequestTime.end())
+		{
+			record(sMeshFirstLODTime, F64Seconds(LLTimer::getTotalSeconds()) - request_time->second);
+			mFirstLODRequestTime.erase(request_time);
+		}
+		// </FS>
 	}
 }
 
@@ -4236,6 +4621,18 @@ void LLMeshRepository::notifyMeshUnavailable(const LLVolumeParams& mesh_params,
 		}
 		
 		mLoadingMeshes[lod].erase(mesh_params);
+
+		// <FS> Mesh decode pool: stop waiting for a first LOD once none is loading any more
+		bool loading = false;
+		for (S32 i = 0; i < 4 && !loading; ++i)
+		{
+			loading = mLoadingMeshes[i].find(mesh_params) != mLoadingMeshes[i].end();
+		}
+		if (!loading)
+		{
+			mFirstLODRequestTime.erase(mesh_params.getSculptID());
+		}
+		// </FS>
 	}
 }
 
@@ -40,6 +40,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include <atomic> // <FS/> Mesh decode pool
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -51,6 +52,14 @@ class LLMutex;
 class LLCondition;
 class LLMeshRepository;
 
+// <FS> Mesh decode pool
+namespace LL
+{
+	class ThreadPool;
+}
+class FSMeshFaceCache;
+// </FS>
+
 typedef enum e_mesh_processing_result_enum
 {
     MESH_OK = 0,
@@ -274,9 +283,14 @@ public:
 		LLPointer<LLVolume> mVolume;
 		LLVolumeParams mMeshParams;
 		S32 mLOD;
-
-		LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod)
-			: mVolume(volume), mMeshParams(mesh_params), mLOD(lod)
+		F64Milliseconds mDecodeTime; // <FS/> Mesh decode pool
+
+		// <FS> Mesh decode pool
+		//LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod)
+		//	: mVolume(volume), mMeshParams(mesh_params), mLOD(lod)
+		LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod, F64Milliseconds decode_time = F64Milliseconds(0.0))
+			: mVolume(volume), mMeshParams(mesh_params), mLOD(lod), mDecodeTime(decode_time)
+		// </FS>
 		{
 		}
 
@@ -309,6 +323,24 @@ public:
 	//queue of successfully loaded meshes
 	std::queue<LoadedMesh> mLoadedQ;
 
+	// <FS> Mesh decode pool
+	// Unzipping and unpacking of LODs and skin info runs on this pool when
+	// FSMeshDecodeThreads > 0; the repo thread then only reads the cache and
+	// does the HTTP bookkeeping. NULL means decode on the repo thread.
+	LL::ThreadPool* mDecodePool;
+	// Decodes posted to the pool and not started yet
+	std::atomic<S32> mDecodesQueued;
+
+	//queues of cached LODs and skin infos the pool failed to decode, to be fetched from the sim instead
+	std::queue<LODRequest> mLODCacheMissQ;
+	std::queue<UUIDBasedRequest> mSkinCacheMissQ;
+	// </FS>
+
+	// <FS> Decoded mesh cache
+	// Unpacked and optimized LOD faces, NULL when FSMeshFaceCache is off
+	FSMeshFaceCache* mFaceCache;
+	// </FS>
+
 	//map of pending header requests and currently desired LODs
 	typedef std::map<LLVolumeParams, std::vector<S32> > pending_lod_map;
 	pending_lod_map mPendingLOD;
@@ -343,7 +375,10 @@ public:
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+	// <FS> Mesh decode pool
+	//bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool use_cache = true);
+	// </FS>
 	EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
 	EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -360,7 +395,10 @@ public:
 
 	//send request for skin info, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
-	bool fetchMeshSkinInfo(const LLUUID& mesh_id);
+	// <FS> Mesh decode pool
+	//bool fetchMeshSkinInfo(const LLUUID& mesh_id);
+	bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool use_cache = true);
+	// </FS>
 
 	//send request for decomposition, returns true if header info exists 
 	//  (should hold onto mesh_id and try again later if header info does not exist)
@@ -393,6 +431,29 @@ public:
 	// <FS:Ansariel> DAE export
 	LLUUID getCreatorFromHeader(const LLUUID& mesh_id);
 
+	// <FS> Mesh decode pool
+	// Hand a LOD or skin info to mDecodePool. Data from the sim is written to
+	// the cache at cache_offset (up to cache_size bytes) once it decodes, data
+	// read from the cache (cache_offset < 0) is fetched from the sim when it doesn't.
+	// Returns false when there is no pool and the caller should decode itself.
+	//
+	// Threads:  Repo thread only
+	bool decodeMeshLODAsync(const LLVolumeParams& mesh_params, S32 lod, std::vector<U8>&& data, S32 cache_offset, S32 cache_size);
+	bool decodeSkinInfoAsync(const LLUUID& mesh_id, std::vector<U8>&& data, S32 cache_offset, S32 cache_size);
+
+	// Mutex:  acquires mMutex
+	void processCacheMisses();
+	// </FS>
+
+	// <FS> Decoded mesh cache
+	// Restore a LOD from mFaceCache on the decode pool. Falls back to the
+	// asset cache at offset/size and then to the sim if the entry turns out
+	// to be unusable. Returns false when there is no pool or no entry.
+	//
+	// Threads:  Repo thread only
+	bool loadCachedFacesAsync(const LLVolumeParams& mesh_params, S32 lod, S32 offset, S32 size);
+	// </FS>
+
 private:
 	// Issue a GET request to a URL with 'Range' header using
 	// the correct policy class and other attributes.  If an invalid
@@ -570,13 +631,21 @@ public:
 	static U32 sHTTPErrorCount;					// Requests ending in error
 	static U32 sLODPending;
 	static U32 sLODProcessing;
-	static U32 sCacheBytesRead;
-	static U32 sCacheBytesWritten;
+	// <FS> Mesh decode pool: also updated by the decode threads
+	//static U32 sCacheBytesRead;
+	//static U32 sCacheBytesWritten;
+	static std::atomic<U32> sCacheBytesRead;
+	static std::atomic<U32> sCacheBytesWritten;
+	// </FS>
     static U32 sCacheBytesHeaders;
     static U32 sCacheBytesSkins;
     static U32 sCacheBytesDecomps;
-	static U32 sCacheReads;						
-	static U32 sCacheWrites;
+	// <FS> Mesh decode pool: also updated by the decode threads
+	//static U32 sCacheReads;						
+	//static U32 sCacheWrites;
+	static std::atomic<U32> sCacheReads;
+	static std::atomic<U32> sCacheWrites;
+	// </FS>
 	static U32 sMaxLockHoldoffs;				// Maximum sequential locking failures
 	
 	static LLDeadmanTimer sQuiescentTimer;		// Time-to-complete-mesh-downloads after significant events
@@ -637,6 +706,9 @@ public:
 	
 	typedef std::map<LLVolumeParams, std::set<LLUUID> > mesh_load_map;
 	mesh_load_map mLoadingMeshes[4];
+
+	// <FS> Mesh decode pool: when the first LOD of each loading mesh was asked for, main thread only
+	std::unordered_map<LLUUID, F64Seconds> mFirstLODRequestTime;
 	
 	// <FS:Ansariel> DAE export
 	LLUUID getCreatorFromHeader(const LLUUID& mesh_id);
@@ -33,6 +33,8 @@
 #include "llmeshrepository.h"
 #include "llvolume.h"
 #include "llrigginginfo.h"
+#include "llskinningkernels.h"
+#include "llparalleljobs.h"
 
 #define DEBUG_SKINNING  LL_DEBUG
 
@@ -469,4 +471,52 @@ namespace FSSkinningUtil
             final_mat.add(src);
         }
     }
+
+    namespace
+    {
+        // Most vertices of one job, so that one big face spreads over threads too
+        const U32 SKIN_JOB_VERTICES = 8192;
+        // With fewer vertices posting to the pool costs more than it saves
+        const U32 MIN_PARALLEL_VERTICES = 16384;
+    }
+
+    void addSkinJobs(std::vector<SkinJob>& jobs, S32 face, const LLVector4a* positions, const LLVector4a* weights, LLVector4a* out, U32 count)
+    {
+        for (U32 first = 0; first < count; first += SKIN_JOB_VERTICES)
+        {
+            SkinJob job;
+            job.mPositions = positions + first;
+            job.mWeights = weights + first;
+            job.mOut = out + first;
+            job.mCount = llmin(count - first, SKIN_JOB_VERTICES);
+            job.mFace = face;
+            jobs.push_back(job);
+        }
+    }
+
+    void runSkinJobs(std::vector<SkinJob>& jobs, const LLMatrix4a* mat, U32 joint_count)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+        const U32 count = (U32)jobs.size();
+        if (count == 0)
+        {
+            return;
+        }
+
+        U32 vertices = 0;
+        for (const SkinJob& job : jobs)
+        {
+            vertices += job.mCount;
+        }
+
+        static LLCachedControl<bool> parallel_skinning(gSavedSettings, "FSParallelSkinning");
+        LL::runParallelJobs(count, [&jobs, mat, joint_count](U32 i)
+            {
+                SkinJob& job = jobs[i];
+                LLSkinningKernels::skinPositions(job.mPositions, job.mWeights, job.mCount, mat, joint_count,
+                                                 job.mOut, job.mExtents);
+            },
+            (parallel_skinning && vertices >= MIN_PARALLEL_VERTICES) ? LL::PARALLEL_JOB_HELPERS : 0);
+    }
 }
@@ -32,6 +32,8 @@
 #include "llvector4a.h"
 #include "llmatrix4a.h"
 
+#include <vector>
+
 class LLVOAvatar;
 class LLMeshSkinInfo;
 class LLVolumeFace;
@@ -73,6 +75,23 @@ namespace LLSkinningUtil
 namespace FSSkinningUtil
 {
     void getPerVertexSkinMatrixSSE( LLVector4a const &weights, const LLMatrix4a* mat, bool handle_bad_scale, LLMatrix4a& final_mat, U32 max_joints );
+
+    // Stretch of the vertices of one face to skin with LLSkinningKernels
+    struct SkinJob
+    {
+        LLVector4a mExtents[2];
+        const LLVector4a* mPositions;
+        const LLVector4a* mWeights;
+        LLVector4a* mOut;
+        U32 mCount;
+        S32 mFace;
+    };
+
+    // Splits the count vertices of face into jobs.
+    void addSkinJobs(std::vector<SkinJob>& jobs, S32 face, const LLVector4a* positions, const LLVector4a* weights, LLVector4a* out, U32 count);
+    // Main thread. Skins jobs with the palette mat of joint_count joints,
+    // on the General thread pool as well when there are enough vertices.
+    void runSkinJobs(std::vector<SkinJob>& jobs, const LLMatrix4a* mat, U32 joint_count);
 }
 
 #endif
@@ -423,6 +423,7 @@ void LLSpatialGroup::shift(const LLVector4a &offset)
 	mObjectBounds[0].add(offset);
 	mObjectExtents[0].add(offset);
 	mObjectExtents[1].add(offset);
+	shiftChildBounds(offset); // <FS/> SoA frustum culling
 
 	if (!getSpatialPartition()->mRenderByGroup && 
 		getSpatialPartition()->mPartitionType != LLViewerRegion::PARTITION_TREE &&
@@ -1029,6 +1030,18 @@ public:
 		return res;
 	}
 
+	// <FS> SoA frustum culling
+	virtual bool frustumCheckChildren(const LLViewerOctreeGroup* group, S32* res)
+	{
+		if (!AABBInFrustumNoFarClipChildBounds(group, res))
+		{
+			return false;
+		}
+		AABBSphereIntersectChildExtents(group, res);
+		return true;
+	}
+	// </FS>
+
 	virtual void processGroup(LLViewerOctreeGroup* base_group)
 	{
 		LL_PROFILE_ZONE_SCOPED;
@@ -1058,6 +1071,13 @@ public:
 		S32 res = AABBInFrustumNoFarClipObjectBounds(group);
 		return res;
 	}
+
+	// <FS> SoA frustum culling
+	virtual bool frustumCheckChildren(const LLViewerOctreeGroup* group, S32* res)
+	{
+		return AABBInFrustumNoFarClipChildBounds(group, res);
+	}
+	// </FS>
 };
 
 class LLOctreeCullShadow : public LLOctreeCull
@@ -1075,6 +1095,13 @@ public:
 	{
 		return AABBInFrustumObjectBounds(group);
 	}
+
+	// <FS> SoA frustum culling
+	virtual bool frustumCheckChildren(const LLViewerOctreeGroup* group, S32* res)
+	{
+		return AABBInFrustumChildBounds(group, res);
+	}
+	// </FS>
 };
 
 class LLOctreeCullVisExtents: public LLOctreeCullShadow
@@ -1455,6 +1482,28 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 	return 0;
 }
 
+// <FS> Parallel cull
+S32 LLSpatialPartition::precull(LLCamera &camera, const OctreeNode* node, S32 res, U32 pass, bool recurse)
+{
+	// Same choice of culler as cull()
+	if (LLPipeline::sShadowRender)
+	{
+		LLOctreeCullShadow culler(&camera);
+		return culler.precull(node, res, pass, recurse);
+	}
+	else if (mInfiniteFarClip || !LLPipeline::sUseFarClip)
+	{
+		LLOctreeCullNoFarClip culler(&camera);
+		return culler.precull(node, res, pass, recurse);
+	}
+	else
+	{
+		LLOctreeCull culler(&camera);
+		return culler.precull(node, res, pass, recurse);
+	}
+}
+// </FS>
+
 void pushVerts(LLDrawInfo* params, U32 mask)
 {
 	LLRenderPass::applyModelMatrix(*params);
@@ -56,6 +56,7 @@ class LLSpatialPartition;
 class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
+class FSGeometryFill; // <FS/> Parallel geometry rebuild
 
 void pushVerts(LLFace* face, U32 mask);
 //<FS:BEQ> Make helper functions externally visible for use from viewerwindow
@@ -414,6 +415,11 @@ public:
 	BOOL visibleObjectsInFrustum(LLCamera& camera);
 	/*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
 	S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, BOOL for_select); // Cull on arbitrary frustum
+	// <FS> Parallel cull
+	// LLViewerOctreeCull::precull() with the culler cull() uses for camera.
+	// The tree has to be rebound already.
+	S32 precull(LLCamera &camera, const OctreeNode* node, S32 res, U32 pass, bool recurse);
+	// </FS>
 	
 	BOOL isVisible(const LLVector3& v);
 	bool isHUDPartition() ;
@@ -678,6 +684,12 @@ private:
 	static LLFace** sSpecFaces[2];
 	static LLFace** sNormSpecFaces[2];
 	static LLFace** sAlphaFaces[2];
+
+	// <FS> Parallel geometry rebuild
+	// Faces genDrawInfo() leaves for rebuildGeom() to fill, while sUseGeometryFill
+	static FSGeometryFill sGeometryFill;
+	static bool sUseGeometryFill;
+	// </FS>
 };
 
 //spatial partition that uses volume geometry manager (implemented in LLVOVolume.cpp)
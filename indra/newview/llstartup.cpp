@@ -240,6 +240,7 @@
 #include "fsfloatersearch.h"
 #include "fsfloaterwearablefavorites.h"
 #include "fslslbridge.h"
+#include "fsobjectupdatedecoder.h"
 #include "fsradar.h"
 #include "fsregistrarutils.h"
 #include "fsscriptlibrary.h"
@@ -897,6 +898,10 @@ bool idle_startup()
 				msg->mPacketRing.setUseOutThrottle(TRUE);
 				msg->mPacketRing.setOutBandwidth(outBandwidth);
 			}
+
+			// <FS> Batched UDP receive
+			msg->mPacketRing.setReceiveBatchSize(gSavedSettings.getU32("FSReceiveBatchSize"));
+			// </FS>
 		}
 
 		LL_INFOS("AppInit") << "Message System Initialized." << LL_ENDL;
@@ -1972,6 +1977,10 @@ bool idle_startup()
 		LLViewerObject::initVOClasses();
 		display_startup();
 
+		// <FS> Staged object updates, needs the object data layout from initVOClasses()
+		FSObjectUpdateDecoder::instance().initThreads(gSavedSettings.getU32("FSObjectDecodeThreads"));
+		// </FS>
+
 		// Initialize all our tools.  Must be done after saved settings loaded.
 		// NOTE: This also is where gToolMgr used to be instantiated before being turned into a singleton.
 		LLToolMgr::getInstance()->initTools();
@@ -3431,6 +3440,10 @@ void register_viewer_callbacks(LLMessageSystem* msg)
 	msg->setHandlerFunc("ObjectUpdateCompressed",				process_compressed_object_update );
 	msg->setHandlerFunc("ObjectUpdateCached",					process_cached_object_update );
 	msg->setHandlerFuncFast(_PREHASH_ImprovedTerseObjectUpdate, process_terse_object_update_improved );
+	// <FS> Compiled message accessors
+	LLViewerObject::initMessageSlots(msg);
+	LLViewerObjectList::initMessageSlots(msg);
+	// </FS>
 	msg->setHandlerFunc("SimStats",				process_sim_stats);
 	msg->setHandlerFuncFast(_PREHASH_HealthMessage,			process_health_message );
 	msg->setHandlerFuncFast(_PREHASH_EconomyData,				process_economy_data);
@@ -42,6 +42,7 @@
 // Cache organization:
 // cache/texture.entries
 //  Unordered array of Entry structs
+//  <FS> Memory-mapped, followed by a hash index on the texture UUID </FS>
 // cache/texture.cache
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
@@ -835,10 +836,22 @@ LLTextureCache::LLTextureCache(bool threaded)
 	  mHeaderMutex(),
 	  mListMutex(),
 	  mFastCacheMutex(),
-	  mHeaderAPRFile(NULL),
+	  //mHeaderAPRFile(NULL), // <FS/> Mapped entries table
 	  mReadOnly(TRUE), //do not allow to change the texture cache until setReadOnly() is called.
+	  // <FS> Mapped entries table
+	  mEntriesSequence(0),
+	  mEntriesWriteDepth(0),
+	  // </FS>
 	  mTexturesSizeTotal(0),
 	  mDoPurge(FALSE),
+	  // <FS> Incremental purge
+	  mPurgeState(PURGE_IDLE),
+	  mPurgeScanPos(0),
+	  mPurgeValidate(false),
+	  mPurgeValidateIdx(0),
+	  mPurgeTargetSize(0),
+	  mPurgeCount(0),
+	  // </FS>
 	  mFastCachep(NULL),
 	  mFastCachePoolp(NULL),
 	  mFastCachePadBuffer(NULL)
@@ -849,7 +862,13 @@ LLTextureCache::LLTextureCache(bool threaded)
 LLTextureCache::~LLTextureCache()
 {
 	clearDeleteList() ;
-	writeUpdatedEntries() ;
+	// <FS> Mapped entries table
+	//writeUpdatedEntries() ;
+	{
+		LLMutexLock lock(&mHeaderMutex);
+		closeEntriesFile();
+	}
+	// </FS>
 	delete mFastCachep;
 	delete mFastCachePoolp;
 	delete mHeaderAPRFilePoolp;
@@ -930,10 +949,14 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id) 
 {
-	LLMutexLock lock(&mHeaderMutex);
-	id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-	
-	return (iter != mHeaderIDMap.end()) ;
+	// <FS> Mapped entries table
+	//LLMutexLock lock(&mHeaderMutex);
+	//id_map_t::const_iterator iter = mHeaderIDMap.find(id);
+	//
+	//return (iter != mHeaderIDMap.end()) ;
+	Entry entry;
+	return lookupEntry(id, entry) >= 0;
+	// </FS>
 }
 
 //debug
@@ -978,7 +1001,10 @@ BOOL LLTextureCache::isInLocal(const LLUUID& id)
 //////////////////////////////////////////////////////////////////////////////
 
 //static
-F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+// <FS> Mapped entries table
+//F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.72f;
+// </FS>
 U32 LLTextureCache::sCacheMaxEntries = 1024 * 1024; //~1 million textures.
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 std::string LLTextureCache::sHeaderCacheEncoderVersion = LLImageJ2C::getEngineInfo();
@@ -1014,7 +1040,7 @@ void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 	if (!mReadOnly)
 	{
 		setDirNames(location);
-		llassert_always(mHeaderAPRFile == NULL);
+		//llassert_always(mHeaderAPRFile == NULL); // <FS/> Mapped entries table
 
 		//remove the legacy cache if exists
 		std::string texture_dir = mTexturesDirName ;
@@ -1093,7 +1119,10 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 		}
 	}
 	readHeaderCache();
-	purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	// <FS> Incremental purge: the work is done in slices from writeToCache()
+	//purgeTextures(true); // calc mTexturesSize and make some room in the texture cache if we need it
+	purgeTextures(true); // validate some entries and make some room in the texture cache if we need it
+	// </FS>
 
 	llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
 	openFastCache(true);
@@ -1102,48 +1131,118 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 }
 
 //----------------------------------------------------------------------------
-// mHeaderMutex must be locked for the following functions!
+// <FS> Mapped entries table
+//
+// texture.entries is mapped into memory and laid out as
+//  EntriesInfo header
+//  Entry[mMaxEntries], indexed like texture.cache and the fast cache
+//  U32[mIndexSize], an open-addressed hash index from UUID to entry index + 1
+// Free entries are chained through mBodySize, starting at mFreeHead.
+//
+// Writers hold mHeaderMutex and bracket every change with begin/endEntriesWrite(),
+// which makes mEntriesSequence odd for the duration. Readers in lookupEntry() probe
+// the table without the mutex and retry if the sequence changed underneath them.
+// The mapping is only created or moved in initCache() and purgeCache(), before the
+// cache is used by other threads.
+
+static const U32 TEXTURE_CACHE_INDEX_EMPTY = 0;
+static const U32 TEXTURE_CACHE_INDEX_DELETED = 0xffffffff;
+static const S32 TEXTURE_CACHE_LOOKUP_RETRIES = 4;
 
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
+//static
+size_t LLTextureCache::getEntriesFileSize(U32 max_entries, U32 index_size)
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-	mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags, mHeaderAPRFilePoolp);
-	if(offset > 0)
+	return sizeof(EntriesInfo) + (size_t)max_entries * sizeof(Entry) + (size_t)index_size * sizeof(U32);
+}
+
+//static
+U32 LLTextureCache::getIndexSizeFor(U32 max_entries)
+{
+	// At most half full, so probe sequences stay short
+	U32 index_size = 1024;
+	while (index_size < max_entries * 2)
 	{
-		mHeaderAPRFile->seek(APR_SET, offset);
+		index_size <<= 1;
 	}
-	return mHeaderAPRFile;
+	return index_size;
 }
 
-void LLTextureCache::closeHeaderEntriesFile()
+// mHeaderMutex must be locked for the following functions!
+
+bool LLTextureCache::openEntriesFile()
 {
-	if(!mHeaderAPRFile)
+	const bool writable = !mReadOnly;
+	if (!LLFile::isfile(mHeaderEntriesFileName) || !mEntriesFile.open(mHeaderEntriesFileName, 0, writable))
 	{
-		return ;
+		return false;
 	}
 
-	delete mHeaderAPRFile;
-	mHeaderAPRFile = NULL;
+	const EntriesInfo* info = getEntriesInfo();
+	if (mEntriesFile.getSize() < sizeof(EntriesInfo)
+		|| info->mVersion != sHeaderCacheVersion
+		|| info->mAdressSize != sHeaderCacheAddressSize
+		|| strncmp(info->mEncoderVersion, sHeaderCacheEncoderVersion.c_str(), sHeaderEncoderStringSize) != 0
+		|| info->mIndexSize < info->mMaxEntries
+		|| (info->mIndexSize & (info->mIndexSize - 1)) != 0
+		|| info->mEntries > info->mMaxEntries
+		|| mEntriesFile.getSize() < getEntriesFileSize(info->mMaxEntries, info->mIndexSize))
+	{
+		mEntriesFile.close();
+		return false;
+	}
+	return true;
 }
 
-void LLTextureCache::readEntriesHeader()
+bool LLTextureCache::createEntriesFile()
 {
-	// mHeaderEntriesInfo initializes to default values so safe not to read it
-	llassert_always(mHeaderAPRFile == NULL);
-	if (LLAPRFile::isExist(mHeaderEntriesFileName, mHeaderAPRFilePoolp))
+	llassert_always(!mReadOnly);
+	LLFile::remove(mHeaderEntriesFileName, ENOENT);
+
+	// A new file is zero filled, so all entries and index slots start out empty
+	const U32 index_size = getIndexSizeFor(sCacheMaxEntries);
+	if (!mEntriesFile.open(mHeaderEntriesFileName, sizeof(EntriesInfo), true)
+		|| !mEntriesFile.resize(getEntriesFileSize(sCacheMaxEntries, index_size)))
 	{
-		LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						  mHeaderAPRFilePoolp);
+		LL_WARNS("TextureCache") << "Unable to create " << mHeaderEntriesFileName << LL_ENDL;
+		mEntriesFile.close();
+		return false;
 	}
-	else //create an empty entries header.
+	setEntriesHeader(sCacheMaxEntries);
+	return true;
+}
+
+void LLTextureCache::closeEntriesFile()
+{
+	if (mEntriesFile.isWritable())
 	{
-		setEntriesHeader();
-		writeEntriesHeader() ;
+		EntriesInfo* info = getEntriesInfo();
+		info->mBodySizeTotal = mTexturesSizeTotal;
+		info->mDirty = 0;
+		mEntriesFile.flush();
 	}
+	mEntriesFile.close();
 }
 
-void LLTextureCache::setEntriesHeader()
+// Only called from initCache(), nobody else is using the table yet.
+// The caller rebuilds the index with recoverEntries().
+bool LLTextureCache::growEntriesFile(U32 max_entries)
+{
+	const U32 old_max_entries = getEntriesInfo()->mMaxEntries;
+	const U32 index_size = getIndexSizeFor(max_entries);
+	if (!mEntriesFile.resize(getEntriesFileSize(max_entries, index_size)))
+	{
+		return false;
+	}
+
+	EntriesInfo* info = getEntriesInfo();
+	info->mMaxEntries = max_entries;
+	info->mIndexSize = index_size;
+	// The new entries overlap the old index
+	std::fill_n(getEntryTable() + old_max_entries, max_entries - old_max_entries, Entry());
+	return true;
+}
+
+void LLTextureCache::setEntriesHeader(U32 max_entries)
 {
 	if (sHeaderEncoderStringSize < sHeaderCacheEncoderVersion.size() + 1)
 	{
@@ -1154,177 +1253,378 @@ void LLTextureCache::setEntriesHeader()
 		LL_ERRS() << "Version string doesn't fit in header" << LL_ENDL;
 	}
 
-	mHeaderEntriesInfo.mVersion = sHeaderCacheVersion;
-	mHeaderEntriesInfo.mAdressSize = sHeaderCacheAddressSize;
-	strcpy(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str());
-	mHeaderEntriesInfo.mEntries = 0;
+	EntriesInfo* info = getEntriesInfo();
+	*info = EntriesInfo();
+	info->mVersion = sHeaderCacheVersion;
+	info->mAdressSize = sHeaderCacheAddressSize;
+	strcpy(info->mEncoderVersion, sHeaderCacheEncoderVersion.c_str());
+	info->mEntries = 0;
+	info->mMaxEntries = max_entries;
+	info->mIndexSize = getIndexSizeFor(max_entries);
+	info->mDirty = 1;
+	mTexturesSizeTotal = 0;
 }
 
-void LLTextureCache::writeEntriesHeader()
+// Empties the table in place, so that lock-free readers never see the mapping go away.
+void LLTextureCache::resetEntries()
 {
-	llassert_always(mHeaderAPRFile == NULL);
-	if (!mReadOnly)
+	beginEntriesWrite();
+	EntriesInfo* info = getEntriesInfo();
+	std::fill_n(getEntryTable(), info->mMaxEntries, Entry());
+	memset(getEntryIndex(), 0, info->mIndexSize * sizeof(U32));
+	setEntriesHeader(info->mMaxEntries);
+	endEntriesWrite();
+}
+
+// Rebuilds everything that is derived from the entries after an unclean shutdown.
+void LLTextureCache::recoverEntries()
+{
+	LL_INFOS("TextureCache") << "Texture cache was not closed cleanly, rebuilding the entry index." << LL_ENDL;
+
+	beginEntriesWrite();
+	EntriesInfo* info = getEntriesInfo();
+	Entry* entries = getEntryTable();
+	memset(getEntryIndex(), 0, info->mIndexSize * sizeof(U32));
+	info->mIndexUsed = 0;
+	info->mUsedEntries = 0;
+	info->mFreeHead = 0;
+	mTexturesSizeTotal = 0;
+	for (S32 idx = (S32)info->mEntries - 1; idx >= 0; --idx)
 	{
-		LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-						   mHeaderAPRFilePoolp);
+		Entry& entry = entries[idx];
+		if (isValidEntry(entry) && findEntry(entry.mID) < 0)
+		{
+			insertIndex(entry.mID, idx);
+			++info->mUsedEntries;
+			mTexturesSizeTotal += entry.mBodySize;
+		}
+		else
+		{
+			entry.mImageSize = -1;
+			entry.mBodySize = info->mFreeHead;
+			info->mFreeHead = idx + 1;
+		}
 	}
+	endEntriesWrite();
 }
 
-//mHeaderMutex is locked before calling this.
-S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
+void LLTextureCache::beginEntriesWrite()
 {
-	S32 idx = -1;
-	
-	id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-	if (iter1 != mHeaderIDMap.end())
+	if (mEntriesWriteDepth++ == 0)
 	{
-		idx = iter1->second;
+		mEntriesSequence.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
 	}
+}
 
-	if (idx < 0)
+void LLTextureCache::endEntriesWrite()
+{
+	if (--mEntriesWriteDepth == 0)
 	{
-		if (create && !mReadOnly)
-		{
-			if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
-			{
-				// Add an entry to the end of the list
-				idx = mHeaderEntriesInfo.mEntries++;
+		mEntriesSequence.fetch_add(1, std::memory_order_release);
+	}
+}
 
-			}
-			else if (!mFreeList.empty())
-			{
-				idx = *(mFreeList.begin());
-				mFreeList.erase(mFreeList.begin());
-			}
-			else
-			{
-				// Look for a still valid entry in the LRU
-				for (std::set<LLUUID>::iterator iter2 = mLRU.begin(); iter2 != mLRU.end();)
-				{
-					std::set<LLUUID>::iterator curiter2 = iter2++;
-					LLUUID oldid = *curiter2;
-					// Erase entry from LRU regardless
-					mLRU.erase(curiter2);
-					// Look up entry and use it if it is valid
-					id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-					if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
-					{
-						idx = iter3->second;
-						removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
-						break;
-					}
-				}
-				// if (idx < 0) at this point, we will rebuild the LRU 
-				//  and retry if called from setHeaderCacheEntry(),
-				//  otherwise this shouldn't happen and will trigger an error
-			}
-			if (idx >= 0)
-			{
-				entry.mID = id ;
-				entry.mImageSize = -1 ; //mark it is a brand-new entry.					
-				entry.mBodySize = 0 ;
-			}
-		}
+S32 LLTextureCache::findEntry(const LLUUID& id) const
+{
+	if (!mEntriesFile.isOpen())
+	{
+		return -1;
 	}
-	else
+
+	const EntriesInfo* info = getEntriesInfo();
+	const U32 max_entries = info->mMaxEntries;
+	const U32 mask = info->mIndexSize - 1;
+	const U32* index = getEntryIndex();
+	const Entry* entries = getEntryTable();
+	U32 pos = (U32)FSUUIDHash()(id) & mask;
+	for (U32 probes = 0; probes <= mask; ++probes, pos = (pos + 1) & mask)
 	{
-		// Remove this entry from the LRU if it exists
-		mLRU.erase(id);
-		// Read the entry
-		idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-		if(iter != mUpdatedEntryMap.end())
+		const U32 slot = index[pos];
+		if (slot == TEXTURE_CACHE_INDEX_EMPTY)
 		{
-			entry = iter->second ;
+			break;
 		}
-		else
+		// Bounds check too: without the mutex, slot may be from a half finished change
+		if (slot != TEXTURE_CACHE_INDEX_DELETED && slot <= max_entries && entries[slot - 1].mID == id)
 		{
-			readEntryFromHeaderImmediately(idx, entry) ;
+			return (S32)(slot - 1);
 		}
-		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
+	}
+	return -1;
+}
+
+// Called without mHeaderMutex
+S32 LLTextureCache::lookupEntry(const LLUUID& id, Entry& entry)
+{
+	for (S32 tries = 0; tries < TEXTURE_CACHE_LOOKUP_RETRIES; ++tries)
+	{
+		const U32 sequence = mEntriesSequence.load(std::memory_order_acquire);
+		if (sequence & 1)
 		{
-			LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
+			continue; // a writer is busy
+		}
 
-			//erase this entry and the cached texture from the cache.
-			std::string tex_filename = getTextureFileName(id);
-			removeEntry(idx, entry, tex_filename) ;
-			mUpdatedEntryMap.erase(idx) ;
-			idx = -1 ;
+		S32 idx = findEntry(id);
+		if (idx >= 0)
+		{
+			entry = getEntryTable()[idx];
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (mEntriesSequence.load(std::memory_order_relaxed) == sequence)
+		{
+			return idx;
 		}
 	}
+
+	LLMutexLock lock(&mHeaderMutex);
+	S32 idx = findEntry(id);
+	if (idx >= 0)
+	{
+		entry = getEntryTable()[idx];
+	}
 	return idx;
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
-{	
-	LLAPRFile* aprfile ;
-	S32 bytes_written ;
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	if(write_header)
+void LLTextureCache::insertIndex(const LLUUID& id, S32 idx)
+{
+	EntriesInfo* info = getEntriesInfo();
+	if (info->mIndexUsed >= info->mIndexSize / 4 * 3)
 	{
-		aprfile = openHeaderEntriesFile(false, 0);		
-		bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
+		// Too many deleted slots
+		rebuildIndex();
+	}
+
+	const U32 mask = info->mIndexSize - 1;
+	U32* index = getEntryIndex();
+	const Entry* entries = getEntryTable();
+	U32 pos = (U32)FSUUIDHash()(id) & mask;
+	S32 deleted_pos = -1;
+	while (index[pos] != TEXTURE_CACHE_INDEX_EMPTY)
+	{
+		const U32 slot = index[pos];
+		if (slot == TEXTURE_CACHE_INDEX_DELETED)
 		{
-			clearCorruptedCache() ; //clear the cache.
-			idx = -1 ;//mark the idx invalid.
-			return ;
+			if (deleted_pos < 0)
+			{
+				deleted_pos = (S32)pos;
+			}
 		}
+		else if (entries[slot - 1].mID == id)
+		{
+			index[pos] = idx + 1;
+			return;
+		}
+		pos = (pos + 1) & mask;
+	}
 
-		mHeaderAPRFile->seek(APR_SET, offset);
+	if (deleted_pos >= 0)
+	{
+		index[deleted_pos] = idx + 1;
 	}
 	else
 	{
-		aprfile = openHeaderEntriesFile(false, offset);
+		index[pos] = idx + 1;
+		++info->mIndexUsed;
 	}
-	bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-	if(bytes_written != sizeof(Entry))
+}
+
+void LLTextureCache::eraseIndex(const LLUUID& id, S32 idx)
+{
+	const EntriesInfo* info = getEntriesInfo();
+	const U32 mask = info->mIndexSize - 1;
+	U32* index = getEntryIndex();
+	U32 pos = (U32)FSUUIDHash()(id) & mask;
+	while (index[pos] != TEXTURE_CACHE_INDEX_EMPTY)
 	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
+		if (index[pos] == (U32)(idx + 1))
+		{
+			index[pos] = TEXTURE_CACHE_INDEX_DELETED;
+			return;
+		}
+		pos = (pos + 1) & mask;
+	}
+}
 
-		return ;
+void LLTextureCache::rebuildIndex()
+{
+	beginEntriesWrite();
+	EntriesInfo* info = getEntriesInfo();
+	const Entry* entries = getEntryTable();
+	memset(getEntryIndex(), 0, info->mIndexSize * sizeof(U32));
+	info->mIndexUsed = 0;
+	for (U32 idx = 0; idx < info->mEntries; ++idx)
+	{
+		if (isValidEntry(entries[idx]))
+		{
+			insertIndex(entries[idx].mID, (S32)idx);
+		}
+	}
+	endEntriesWrite();
+}
+
+// Puts an entry on the free list. Does not touch the index or the body file.
+void LLTextureCache::freeEntry(S32 idx)
+{
+	Entry& entry = getEntryTable()[idx];
+	if (!isValidEntry(entry))
+	{
+		return; // already free, or taken by openAndReadEntry()
 	}
 
-	closeHeaderEntriesFile();
-	mUpdatedEntryMap.erase(idx) ;
+	beginEntriesWrite();
+	EntriesInfo* info = getEntriesInfo();
+	mTexturesSizeTotal -= entry.mBodySize;
+	--info->mUsedEntries;
+	entry.mImageSize = -1;
+	entry.mBodySize = info->mFreeHead;
+	info->mFreeHead = idx + 1;
+	endEntriesWrite();
 }
 
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
+// Collects the oldest TEXTURE_CACHE_LRU_SIZE of the entries to reuse once the table is full.
+void LLTextureCache::rebuildLRU()
 {
-	S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-	LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-	S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-	closeHeaderEntriesFile();
+	mLRU.clear();
+	if (!mEntriesFile.isOpen())
+	{
+		return;
+	}
 
-	if(bytes_read != sizeof(Entry))
+	const EntriesInfo* info = getEntriesInfo();
+	const Entry* entries = getEntryTable();
+	for (U32 idx = 0; idx < info->mEntries; ++idx)
 	{
-		clearCorruptedCache() ; //clear the cache.
-		idx = -1 ;//mark the idx invalid.
+		if (isValidEntry(entries[idx]))
+		{
+			mLRU.push_back(std::make_pair(entries[idx].mTime, (S32)idx));
+		}
+	}
+
+	const size_t lru_entries = llmax((size_t)1, (size_t)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE));
+	if (mLRU.size() > lru_entries)
+	{
+		std::nth_element(mLRU.begin(), mLRU.begin() + lru_entries, mLRU.end());
+		mLRU.resize(lru_entries);
 	}
+	std::sort(mLRU.begin(), mLRU.end(), std::greater<time_idx_t>());
 }
+// </FS>
 
 //mHeaderMutex is locked before calling this.
-//update an existing entry time stamp, delay writing.
-void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
+S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
 {
-	static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
+	// <FS> Mapped entries table
+	S32 idx = findEntry(id);
+
+	if (idx < 0)
+	{
+		if (create && !mReadOnly && mEntriesFile.isWritable())
+		{
+			EntriesInfo* info = getEntriesInfo();
+			Entry* entries = getEntryTable();
+			if (info->mUsedEntries < sCacheMaxEntries)
+			{
+				// Popping the free list rewrites mFreeHead and the taken entry,
+				// so readers in lookupEntry() have to see the write bracket.
+				beginEntriesWrite();
+				if (info->mFreeHead > 0 && info->mFreeHead <= info->mEntries
+					&& entries[info->mFreeHead - 1].mImageSize < 0)
+				{
+					// Take the first free entry
+					idx = (S32)info->mFreeHead - 1;
+					info->mFreeHead = (U32)llmax(0, entries[idx].mBodySize);
+					entries[idx].mBodySize = 0;
+				}
+				else if (info->mFreeHead > 0)
+				{
+					// Broken chain; the entries on it are lost until the next recoverEntries()
+					LL_WARNS("TextureCache") << "Texture cache free list corrupted." << LL_ENDL;
+					info->mFreeHead = 0;
+				}
+
+				if (idx < 0 && info->mEntries < info->mMaxEntries)
+				{
+					// Add an entry to the end of the list
+					idx = info->mEntries++;
+				}
+				endEntriesWrite();
+			}
 
-	if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+			// Look for a still valid entry in the LRU
+			while (idx < 0 && !mLRU.empty())
+			{
+				time_idx_t oldest = mLRU.back();
+				mLRU.pop_back();
+				// Skip entries that were used or replaced since the LRU was built
+				const Entry& old_entry = entries[oldest.second];
+				if (isValidEntry(old_entry) && old_entry.mTime == oldest.first)
+				{
+					idx = oldest.second;
+					removeCachedTexture(idx); //remove the existing cached texture to release the entry index.
+				}
+			}
+			// if (idx < 0) at this point, we will rebuild the LRU 
+			//  and retry if called from setHeaderCacheEntry(),
+			//  otherwise this shouldn't happen and will trigger an error
+
+			if (idx >= 0)
+			{
+				entry.mID = id ;
+				entry.mImageSize = -1 ; //mark it is a brand-new entry.					
+				entry.mBodySize = 0 ;
+			}
+		}
+	}
+	else
 	{
-		return ; //there are enough empty entry index space, no need to stamp time.
+		entry = getEntryTable()[idx];
+		if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
+		{
+			LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
+
+			//erase this entry and the cached texture from the cache.
+			std::string tex_filename = getTextureFileName(id);
+			if (!mReadOnly && mEntriesFile.isWritable())
+			{
+				removeEntry(idx, entry, tex_filename) ;
+			}
+			idx = -1 ;
+		}
 	}
+	return idx;
+	// </FS>
+}
+
+//mHeaderMutex is locked before calling this.
+//update an existing entry time stamp, delay writing.
+// <FS> Mapped entries table: called without mHeaderMutex, the time stamp is a single
+// store into the mapped entry and reaches the disk with the next flush.
+void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
+{
+	//static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
+	//
+	//if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+	//{
+	//	return ; //there are enough empty entry index space, no need to stamp time.
+	//}
 
 	if (idx >= 0)
 	{
-		if (!mReadOnly)
+		if (!mReadOnly && mEntriesFile.isWritable())
 		{
-			entry.mTime = time(NULL);			
-			mUpdatedEntryMap[idx] = entry ;
+			const U32 now = (U32)time(NULL);
+			if (entry.mTime != now)
+			{
+				entry.mTime = now;
+				// At worst this races with the entry being reused, which only skews its time stamp
+				reinterpret_cast<std::atomic<U32>*>(&getEntryTable()[idx].mTime)->store(now, std::memory_order_relaxed);
+			}
 		}
 	}
 }
+// </FS>
 
 //update an existing entry, write to header file immediately.
 bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
@@ -1341,11 +1641,28 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 
 		lockHeaders() ;
 
+		// <FS> Mapped entries table
+		if (!mEntriesFile.isWritable() || (entry.mImageSize >= 0 && getEntryTable()[idx].mID != entry.mID))
+		{
+			// The cache was purged or the entry was reused since it was read
+			unlockHeaders();
+			idx = -1;
+			return false;
+		}
+
+		beginEntriesWrite();
+		EntriesInfo* info = getEntriesInfo();
 		bool update_header = false ;
 		if(entry.mImageSize < 0) //is a brand-new entry
 		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = new_body_size ;
+			// Another writer may have created an entry for the same texture meanwhile
+			S32 old_idx = findEntry(entry.mID);
+			if (old_idx >= 0 && old_idx != idx)
+			{
+				eraseIndex(entry.mID, old_idx);
+				freeEntry(old_idx);
+			}
+			++info->mUsedEntries;
 			mTexturesSizeTotal += new_body_size ;
 			
 			// Update Header
@@ -1353,8 +1670,7 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 		}				
 		else if (entry.mBodySize != new_body_size)
 		{
-			//already in mHeaderIDMap.
-			mTexturesSizeMap[entry.mID] = new_body_size ;
+			//already in the index.
 			mTexturesSizeTotal -= entry.mBodySize ;
 			mTexturesSizeTotal += new_body_size ;
 		}
@@ -1362,12 +1678,18 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 		entry.mImageSize = new_image_size ; 
 		entry.mBodySize = new_body_size ;
 		
-		writeEntryToHeaderImmediately(idx, entry, update_header) ;
+		getEntryTable()[idx] = entry;
+		if (update_header)
+		{
+			insertIndex(entry.mID, idx);
+		}
+		endEntriesWrite();
 	
-		if (mTexturesSizeTotal > sCacheMaxTexturesSize)
+		if (mTexturesSizeTotal > sCacheMaxTexturesSize || info->mUsedEntries > sCacheMaxEntries)
 		{
 			purge = true;
 		}
+		// </FS>
 		
 		unlockHeaders() ;
 
@@ -1380,231 +1702,88 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 	return false ;
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
-{
-	U32 num_entries = mHeaderEntriesInfo.mEntries;
-
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-
-	LLAPRFile* aprfile = NULL; 
-	if(mUpdatedEntryMap.empty())
-	{
-		aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
-	}
-	else //update the header file first.
-	{
-		aprfile = openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		if(!aprfile)
-		{
-			return 0;
-		}
-		aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
-	}
-	for (U32 idx=0; idx<num_entries; idx++)
-	{
-		Entry entry;
-		S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-		if (bytes_read < sizeof(Entry))
-		{
-			LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-			closeHeaderEntriesFile();
-			purgeAllTextures(false);
-			return 0;
-		}
-		entries.push_back(entry);
-// 		LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
-		if(entry.mImageSize > entry.mBodySize)
-		{
-			mHeaderIDMap[entry.mID] = idx;
-			mTexturesSizeMap[entry.mID] = entry.mBodySize;
-			mTexturesSizeTotal += entry.mBodySize;
-		}
-		else
-		{
-			mFreeList.insert(idx);
-		}
-	}
-	closeHeaderEntriesFile();
-	return num_entries;
-}
-
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-	S32 num_entries = entries.size();
-	llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-	
-	if (!mReadOnly)
-	{
-		LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-		for (S32 idx=0; idx<num_entries; idx++)
-		{
-			S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-			if(bytes_written != sizeof(Entry))
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		closeHeaderEntriesFile();
-	}
-}
-
 void LLTextureCache::writeUpdatedEntries()
 {
 	lockHeaders() ;
-	if (!mReadOnly && !mUpdatedEntryMap.empty())
+	// <FS> Mapped entries table
+	if (!mReadOnly && mEntriesFile.isWritable())
 	{
-		openHeaderEntriesFile(false, 0);
-		updatedHeaderEntriesFile() ;
-		closeHeaderEntriesFile();
+		getEntriesInfo()->mBodySizeTotal = mTexturesSizeTotal;
+		mEntriesFile.flush();
 	}
+	// </FS>
 	unlockHeaders() ;
 }
 
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
-{
-	if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
-	{
-		//entriesInfo
-		mHeaderAPRFile->seek(APR_SET, 0);
-		S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-		if(bytes_written != sizeof(EntriesInfo))
-		{
-			clearCorruptedCache() ; //clear the cache.
-			return ;
-		}
-		
-		//write each updated entry
-		S32 entry_size = (S32)sizeof(Entry) ;
-		S32 prev_idx = -1 ;
-		S32 delta_idx ;
-		for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-		{
-			delta_idx = iter->first - prev_idx - 1;
-			prev_idx = iter->first ;
-			if(delta_idx)
-			{
-				mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-			}
-			
-			bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-			if(bytes_written != entry_size)
-			{
-				clearCorruptedCache() ; //clear the cache.
-				return ;
-			}
-		}
-		mUpdatedEntryMap.clear() ;
-	}
-}
 //----------------------------------------------------------------------------
 
 // Called from either the main thread or the worker thread
 void LLTextureCache::readHeaderCache()
 {
-	mHeaderMutex.lock();
+	// <FS> Mapped entries table: map texture.entries instead of reading it in full
+	LLMutexLock lock(&mHeaderMutex);
 
 	mLRU.clear(); // always clear the LRU
 
-	readEntriesHeader();
-	
-	if (mHeaderEntriesInfo.mVersion != sHeaderCacheVersion
-		|| mHeaderEntriesInfo.mAdressSize != sHeaderCacheAddressSize
-		|| strcmp(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str()) != 0)
+	closeEntriesFile();
+	if (!openEntriesFile())
 	{
 		if (!mReadOnly)
 		{
-			LL_INFOS() << "Texture Cache version mismatch, Purging." << LL_ENDL;
+			if (LLFile::isfile(mHeaderEntriesFileName))
+			{
+				LL_INFOS() << "Texture Cache version mismatch, Purging." << LL_ENDL;
+				purgeAllTextures(false);
+			}
+			createEntriesFile();
+		}
+		return;
+	}
+
+	EntriesInfo* info = getEntriesInfo();
+	if (mReadOnly)
+	{
+		if (info->mDirty)
+		{
+			// Can't rebuild a read only table
+			LL_WARNS("TextureCache") << "Texture cache was not closed cleanly, not using it while read only." << LL_ENDL;
+			mEntriesFile.close();
+			return;
+		}
+	}
+	else if (info->mMaxEntries < sCacheMaxEntries)
+	{
+		LL_INFOS("TextureCache") << "Growing texture cache entries from " << info->mMaxEntries << " to " << sCacheMaxEntries << LL_ENDL;
+		if (!growEntriesFile(sCacheMaxEntries))
+		{
+			mEntriesFile.close();
 			purgeAllTextures(false);
+			createEntriesFile();
+			return;
 		}
+		info = getEntriesInfo();
+		recoverEntries();
+	}
+	else if (info->mDirty)
+	{
+		recoverEntries();
 	}
 	else
 	{
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (num_entries)
-		{
-			U32 empty_entries = 0;
-			typedef std::pair<U32, S32> lru_data_t;
-			std::set<lru_data_t> lru;
-			std::set<U32> purge_list;
-			for (U32 i=0; i<num_entries; i++)
-			{
-				Entry& entry = entries[i];
-				if (entry.mImageSize <= 0)
-				{
-					// This will be in the Free List, don't put it in the LRU
-					++empty_entries;
-				}
-				else
-				{
-					lru.insert(std::make_pair(entry.mTime, i));
-					if (entry.mBodySize > 0)
-					{
-						if (entry.mBodySize > entry.mImageSize)
-						{
-							// Shouldn't happen, failsafe only
-							LL_WARNS() << "Bad entry: " << i << ": " << entry.mID << ": BodySize: " << entry.mBodySize << LL_ENDL;
-							purge_list.insert(i);
-						}
-					}
-				}
-			}
-			if (num_entries - empty_entries > sCacheMaxEntries)
-			{
-				// Special case: cache size was reduced, need to remove entries
-				U32 entries_to_purge = (num_entries - empty_entries) - sCacheMaxEntries;
-				LL_INFOS() << "Texture Cache Entries: " << num_entries << " Max: " << sCacheMaxEntries << " Empty: " << empty_entries << " Purging: " << entries_to_purge << LL_ENDL;
-				// We can exit the following loop with the given condition, since if we'd reach the end of the lru set we'd have:
-				// purge_list.size() = lru.size() = num_entries - empty_entries = entries_to_purge + sCacheMaxEntries >= entries_to_purge
-				// So, it's certain that iter will never reach lru.end() first.
-				std::set<lru_data_t>::iterator iter = lru.begin();
-				while (purge_list.size() < entries_to_purge)
-				{
-					purge_list.insert(iter->second);
-					++iter;
-				}
-			}
-
-			{
-				S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
-				for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
-				{
-					mLRU.insert(entries[iter->second].mID);
-// 					LL_INFOS() << "LRU: " << iter->first << " : " << iter->second << LL_ENDL;
-					if (--lru_entries <= 0)
-						break;
-				}
-			}
-			
-			if (purge_list.size() > 0)
-			{
-				LLTimer timer;
-				for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
-				{
-					std::string tex_filename = getTextureFileName(entries[*iter].mID);
-					removeEntry((S32)*iter, entries[*iter], tex_filename);
+		mTexturesSizeTotal = info->mBodySizeTotal;
+	}
+	// If the cache was made smaller, the table keeps its size and the purge
+	// started by initCache() drops the oldest entries.
 
-					//make sure that pruning entries doesn't take too much time
-					if (timer.getElapsedTimeF32() > TEXTURE_PRUNING_MAX_TIME)
-					{
-						break;
-					}
-				}
-				writeEntriesAndClose(entries);
-			}
-			else
-			{
-				//entries are not changed, nothing here.
-			}
-		}
+	if (!mReadOnly)
+	{
+		info->mDirty = 1;
+		mEntriesFile.flush();
 	}
-	mHeaderMutex.unlock();
+
+	LL_INFOS("TextureCache") << "Texture cache entries: " << info->mUsedEntries << " of " << info->mMaxEntries
+							 << " size: " << mTexturesSizeTotal / (1024 * 1024) << " MB" << LL_ENDL;
+	// </FS>
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1614,7 +1793,7 @@ void LLTextureCache::clearCorruptedCache()
 {
 	LL_WARNS() << "the texture cache is corrupted, need to be cleared." << LL_ENDL ;
 
-	closeHeaderEntriesFile();//close possible file handler
+	//closeHeaderEntriesFile();//close possible file handler // <FS/> Mapped entries table
 	purgeAllTextures(false) ; //clear the cache.
 
 	if (!mReadOnly) //regenerate the directory tree if not exists.
@@ -1636,6 +1815,13 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
 	if (!mReadOnly)
 	{
+		// <FS> Mapped entries table: when only the files are purged, the table is emptied in place below
+		if (purge_directories && mEntriesFile.isOpen()
+			&& LLStringUtil::startsWith(mEntriesFile.getFilename(), mTexturesDirName + gDirUtilp->getDirDelimiter()))
+		{
+			closeEntriesFile();
+		}
+		// </FS>
 // <FS:ND> Windows can be really slow deleting a huge texture cache.
 // In case of a full purge rename the directory and then purge this using a low priority background thread. 
 #if LL_WINDOWS
@@ -1675,7 +1861,18 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 		if (LLFile::isdir(mTexturesDirName))
 		{
 		// </FS:Ansariel>
-		gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
+		// <FS> Mapped entries table
+		//gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
+		if (mEntriesFile.isOpen())
+		{
+			LLFile::remove(mHeaderDataFileName, ENOENT);
+			LLFile::remove(mFastCacheFileName, ENOENT);
+		}
+		else
+		{
+			gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
+		}
+		// </FS>
 		if (purge_directories)
 		{
 			LLFile::rmdir(mTexturesDirName);
@@ -1685,20 +1882,35 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 		// </FS:Ansariel>
 		}
 	}
-	mHeaderIDMap.clear();
-	mTexturesSizeMap.clear();
+	// <FS> Mapped entries table
+	//mHeaderIDMap.clear();
+	//mTexturesSizeMap.clear();
+	//mTexturesSizeTotal = 0;
+	//mFreeList.clear();
+	//mTexturesSizeTotal = 0;
+	//mUpdatedEntryMap.clear();
+	//
+	//// Info with 0 entries
+	//setEntriesHeader();
+	//writeEntriesHeader();
 	mTexturesSizeTotal = 0;
-	mFreeList.clear();
-	mTexturesSizeTotal = 0;
-	mUpdatedEntryMap.clear();
-
-	// Info with 0 entries
-	setEntriesHeader();
-	writeEntriesHeader();
+	mLRU.clear();
+	mPurgeEntryList.clear();
+	mPurgeCandidates.clear();
+	mPurgeState = PURGE_IDLE;
+	if (!mReadOnly && mEntriesFile.isWritable())
+	{
+		resetEntries();
+	}
+	// </FS>
 
 	LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
 
+// <FS> Incremental purge
+// Each call does at most time_limit_sec worth of work: first a slice of the scan
+// that collects the entries, then removing the oldest entries until the cache is
+// under budget again.
 void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 {
 	if (mReadOnly)
@@ -1714,76 +1926,119 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 	// time_limit doesn't account for lock time
 	LLMutexLock lock(&mHeaderMutex);
 
-	if (mPurgeEntryList.empty())
+	if (!mEntriesFile.isWritable())
 	{
-		// Read the entries list and form list of textures to purge
-		std::vector<Entry> entries;
-		U32 num_entries = openAndReadEntries(entries);
-		if (!num_entries)
-		{
-			return; // nothing to purge
-		}
+		mPurgeState = PURGE_IDLE;
+		mDoPurge = FALSE;
+		return;
+	}
+
+	if (mPurgeState == PURGE_IDLE)
+	{
+		startPurge(false);
+	}
 
-		// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-		typedef std::set<std::pair<U32, S32> > time_idx_set_t;
-		std::set<std::pair<U32, S32> > time_idx_set;
-		for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-			iter1 != mTexturesSizeMap.end(); ++iter1)
+	LLTimer timer;
+	const EntriesInfo* info = getEntriesInfo();
+	const Entry* entries = getEntryTable();
+
+	if (mPurgeState == PURGE_SCAN)
+	{
+		const U32 num_entries = info->mEntries;
+		while (mPurgeScanPos < num_entries)
 		{
-			if (iter1->second > 0)
+			const S32 idx = (S32)mPurgeScanPos++;
+			const Entry& entry = entries[idx];
+			if (isValidEntry(entry))
 			{
-				id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-				if (iter2 != mHeaderIDMap.end())
-				{
-					S32 idx = iter2->second;
-					time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-				}
-				else
+				mPurgeCandidates.push_back(std::make_pair(entry.mTime, idx));
+
+				// make sure file exists and is the correct size
+				if (mPurgeValidate && entry.mID.mData[0] == mPurgeValidateIdx)
 				{
-					LL_ERRS("TextureCache") << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL;
+					std::string filename = getTextureFileName(entry.mID);
+					LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entry.mBodySize << LL_ENDL;
+					// mHeaderAPRFilePoolp because this is under header mutex
+					S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
+					if (bodysize != entry.mBodySize)
+					{
+						LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entry.mBodySize << filename << LL_ENDL;
+						mPurgeEntryList.push_back(std::make_pair(idx, entry));
+					}
 				}
 			}
+
+			if ((mPurgeScanPos & 0x3f) == 0 && timer.getElapsedTimeF32() > time_limit_sec)
+			{
+				return;
+			}
 		}
 
 		S64 cache_size = mTexturesSizeTotal;
-		S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
-		for (time_idx_set_t::iterator iter = time_idx_set.begin();
-			iter != time_idx_set.end(); ++iter)
+		mPurgeTargetSize = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
+		std::make_heap(mPurgeCandidates.begin(), mPurgeCandidates.end(), std::greater<time_idx_t>());
+		mPurgeState = PURGE_REMOVE;
+		LL_DEBUGS("TextureCache") << "Formed Purge list of " << mPurgeCandidates.size() << " entries" << LL_ENDL;
+	}
+
+	bool done = false;
+	while (!done && timer.getElapsedTimeF32() < time_limit_sec)
+	{
+		S32 idx = -1;
+		if (!mPurgeEntryList.empty())
 		{
-			S32 idx = iter->second;
-			if (cache_size >= purged_cache_size)
+			// Entries that failed validation go first
+			idx = mPurgeEntryList.back().first;
+			const LLUUID id = mPurgeEntryList.back().second.mID;
+			mPurgeEntryList.pop_back();
+			if (entries[idx].mID != id || !isValidEntry(entries[idx]))
 			{
-				cache_size -= entries[idx].mBodySize;
-				mPurgeEntryList.push_back(std::pair<S32, Entry>(idx, entries[idx]));
+				continue;
 			}
-			else
+		}
+		else
+		{
+			const bool over_size = mTexturesSizeTotal >= mPurgeTargetSize;
+			const bool over_count = info->mUsedEntries > sCacheMaxEntries;
+			if (mPurgeCandidates.empty() || (!over_size && !over_count))
 			{
+				done = true;
 				break;
 			}
-		}
-		LL_DEBUGS("TextureCache") << "Formed Purge list of " << mPurgeEntryList.size() << " entries" << LL_ENDL;
-	}
-	else
-	{
-		// Remove collected entried
-		LLTimer timer;
-		while (!mPurgeEntryList.empty() && timer.getElapsedTimeF32() < time_limit_sec)
-		{
-			S32 idx = mPurgeEntryList.back().first;
-			Entry entry = mPurgeEntryList.back().second;
-			mPurgeEntryList.pop_back();
-			// make sure record is still valid
-			id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-			if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
+
+			std::pop_heap(mPurgeCandidates.begin(), mPurgeCandidates.end(), std::greater<time_idx_t>());
+			const time_idx_t oldest = mPurgeCandidates.back();
+			mPurgeCandidates.pop_back();
+			// make sure record is still valid and was not used since the scan
+			const Entry& entry = entries[oldest.second];
+			if (!isValidEntry(entry) || entry.mTime != oldest.first || (!over_count && entry.mBodySize <= 0))
 			{
-				std::string tex_filename = getTextureFileName(entry.mID);
-				removeEntry(idx, entry, tex_filename);
-				writeEntryToHeaderImmediately(idx, entry);
+				continue;
 			}
+			idx = oldest.second;
 		}
+
+		Entry entry = entries[idx];
+		std::string filename = getTextureFileName(entry.mID);
+		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
+		removeEntry(idx, entry, filename);
+		++mPurgeCount;
+	}
+
+	if (done)
+	{
+		LL_INFOS("TextureCache") << "TEXTURE CACHE:"
+				<< " PURGED: " << mPurgeCount
+				<< " ENTRIES: " << info->mUsedEntries
+				<< " CACHE SIZE: " << mTexturesSizeTotal / (1024 * 1024) << " MB"
+				<< LL_ENDL;
+		time_idx_vector_t().swap(mPurgeCandidates);
+		mPurgeState = PURGE_IDLE;
+		mDoPurge = FALSE;
 	}
 }
 
+// Starts a purge pass; the work is done by purgeTexturesLazy().
 void LLTextureCache::purgeTextures(bool validate)
 {
 	if (mReadOnly)
@@ -1791,114 +2046,34 @@ void LLTextureCache::purgeTextures(bool validate)
 		return;
 	}
 
-	if (!mThreaded)
-	{
-		// *FIX:Mani - watchdog off.
-		LLAppViewer::instance()->pauseMainloopTimeout();
-	}
-	
 	LLMutexLock lock(&mHeaderMutex);
 
 	LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-	// Read the entries list
-	std::vector<Entry> entries;
-	U32 num_entries = openAndReadEntries(entries);
-	if (!num_entries)
-	{
-		return; // nothing to purge
-	}
-	
-	// Use mTexturesSizeMap to collect UUIDs of textures with bodies
-	typedef std::set<std::pair<U32,S32> > time_idx_set_t;
-	std::set<std::pair<U32,S32> > time_idx_set;
-	for (size_map_t::iterator iter1 = mTexturesSizeMap.begin();
-		 iter1 != mTexturesSizeMap.end(); ++iter1)
-	{
-		if (iter1->second > 0)
-		{
-			id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-			if (iter2 != mHeaderIDMap.end())
-			{
-				S32 idx = iter2->second;
-				time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
-// 				LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
-			}
-			else
-			{
-				LL_ERRS() << "mTexturesSizeMap / mHeaderIDMap corrupted." << LL_ENDL ;
-			}
-		}
-	}
-	
+	startPurge(validate);
+	mDoPurge = TRUE;
+}
+
+//mHeaderMutex is locked before calling this.
+void LLTextureCache::startPurge(bool validate)
+{
+	mPurgeState = PURGE_SCAN;
+	mPurgeScanPos = 0;
+	mPurgeCount = 0;
+	mPurgeCandidates.clear();
+	mPurgeEntryList.clear();
+
 	// Validate 1/256th of the files on startup
-	U32 validate_idx = 0;
+	mPurgeValidate = validate;
 	if (validate)
 	{
-		validate_idx = gSavedSettings.getU32("CacheValidateCounter");
-		U32 next_idx = (validate_idx + 1) % 256;
+		mPurgeValidateIdx = gSavedSettings.getU32("CacheValidateCounter");
+		U32 next_idx = (mPurgeValidateIdx + 1) % 256;
 		gSavedSettings.setU32("CacheValidateCounter", next_idx);
-		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << validate_idx << LL_ENDL;
-	}
-
-	S64 cache_size = mTexturesSizeTotal;
-	S64 purged_cache_size = (llmax(cache_size, sCacheMaxTexturesSize) * (S64)((1.f - TEXTURE_CACHE_PURGE_AMOUNT) * 100)) / 100;
-	S32 purge_count = 0;
-	for (time_idx_set_t::iterator iter = time_idx_set.begin();
-		 iter != time_idx_set.end(); ++iter)
-	{
-		S32 idx = iter->second;
-		bool purge_entry = false;		
-
-		if (cache_size >= purged_cache_size)
-		{
-			purge_entry = true;
-		}
-		else if (validate)
-		{
-			// make sure file exists and is the correct size
-			U32 uuididx = entries[idx].mID.mData[0];
-			if (uuididx == validate_idx)
-			{
-				std::string filename = getTextureFileName(entries[idx].mID);
-				LL_DEBUGS("TextureCache") << "Validating: " << filename << "Size: " << entries[idx].mBodySize << LL_ENDL;
-				// mHeaderAPRFilePoolp because this is under header mutex in main thread
-				S32 bodysize = LLAPRFile::size(filename, mHeaderAPRFilePoolp);
-				if (bodysize != entries[idx].mBodySize)
-				{
-					LL_WARNS("TextureCache") << "TEXTURE CACHE BODY HAS BAD SIZE: " << bodysize << " != " << entries[idx].mBodySize << filename << LL_ENDL;
-					purge_entry = true;
-				}
-			}
-		}
-		else
-		{
-			break;
-		}
-		
-		if (purge_entry)
-		{
-			purge_count++;
-            std::string filename = getTextureFileName(entries[idx].mID);
-	 		LL_DEBUGS("TextureCache") << "PURGING: " << filename << LL_ENDL;
-			cache_size -= entries[idx].mBodySize;
-			removeEntry(idx, entries[idx], filename) ;			
-		}
+		LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Validating: " << mPurgeValidateIdx << LL_ENDL;
 	}
-
-	LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
-
-	writeEntriesAndClose(entries);
-	
-	// *FIX:Mani - watchdog back on.
-	LLAppViewer::instance()->resumeMainloopTimeout();
-	
-	LL_INFOS("TextureCache") << "TEXTURE CACHE:"
-			<< " PURGED: " << purge_count
-			<< " ENTRIES: " << num_entries
-			<< " CACHE SIZE: " << mTexturesSizeTotal / (1024 * 1024) << " MB"
-			<< LL_ENDL;
 }
+// </FS>
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -1931,8 +2106,17 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 // Reads imagesize from the header, updates timestamp
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
-	LLMutexLock lock(&mHeaderMutex);	
-	S32 idx = openAndReadEntry(id, entry, false);
+	// <FS> Mapped entries table
+	//LLMutexLock lock(&mHeaderMutex);	
+	//S32 idx = openAndReadEntry(id, entry, false);
+	S32 idx = lookupEntry(id, entry);
+	if (idx >= 0 && !isValidEntry(entry))
+	{
+		// Let the locked path report and remove the corrupted entry
+		LLMutexLock lock(&mHeaderMutex);
+		idx = openAndReadEntry(id, entry, false);
+	}
+	// </FS>
 	if (idx >= 0)
 	{		
 		updateEntryTimeStamp(idx, entry); // updates time
@@ -1949,9 +2133,13 @@ S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imag
 
 	if(idx < 0) // retry once
 	{
-		readHeaderCache(); // We couldn't write an entry, so refresh the LRU
-
+		// <FS> Mapped entries table
+		//readHeaderCache(); // We couldn't write an entry, so refresh the LRU
+		//
+		//mHeaderMutex.lock();
 		mHeaderMutex.lock();
+		rebuildLRU(); // We couldn't write an entry, so refresh the LRU
+		// </FS>
 		idx = openAndReadEntry(id, entry, true);
 		mHeaderMutex.unlock();
 	}
@@ -2048,7 +2236,7 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id, U32 prio
 		// NOTE: Needs to be done on the control thread
 		//  (i.e. here)
 		purgeTexturesLazy(TEXTURE_LAZY_PURGE_TIME_LIMIT);
-		mDoPurge = !mPurgeEntryList.empty();
+		//mDoPurge = !mPurgeEntryList.empty(); // <FS/> Incremental purge, purgeTexturesLazy() clears it when done
 	}
 
 	// <FS:ND> There seems to be an edge case of KDU failing to decode images and then we end with null data here.
@@ -2074,14 +2262,20 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 {
 	U32 offset;
 	{
-		LLMutexLock lock(&mHeaderMutex);
-		id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-		if(iter == mHeaderIDMap.end())
+		// <FS> Mapped entries table
+		//LLMutexLock lock(&mHeaderMutex);
+		//id_map_t::const_iterator iter = mHeaderIDMap.find(id);
+		//if(iter == mHeaderIDMap.end())
+		Entry entry;
+		S32 idx = lookupEntry(id, entry);
+		if (idx < 0)
 		{
 			return NULL; //not in the cache
 		}
 
-		offset = iter->second;
+		//offset = iter->second;
+		offset = idx;
+		// </FS>
 	}
 	offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
@@ -2288,18 +2482,26 @@ void LLTextureCache::addCompleted(Responder* responder, bool success)
 //////////////////////////////////////////////////////////////////////////////
 
 //called after mHeaderMutex is locked.
-void LLTextureCache::removeCachedTexture(const LLUUID& id)
+// <FS> Mapped entries table: releases the entry at idx for reuse by the caller
+void LLTextureCache::removeCachedTexture(S32 idx)
 {
-	if(mTexturesSizeMap.find(id) != mTexturesSizeMap.end())
+	beginEntriesWrite();
+	Entry& entry = getEntryTable()[idx];
+	const LLUUID id = entry.mID;
+	if (isValidEntry(entry))
 	{
-		mTexturesSizeTotal -= mTexturesSizeMap[id] ;
-		mTexturesSizeMap.erase(id);
+		mTexturesSizeTotal -= entry.mBodySize;
+		--getEntriesInfo()->mUsedEntries;
 	}
-	mHeaderIDMap.erase(id);
+	eraseIndex(id, idx);
+	entry.mImageSize = -1;
+	entry.mBodySize = 0;
+	endEntriesWrite();
 	// We are inside header's mutex so mHeaderAPRFilePoolp is safe to use,
 	// but getLocalAPRFilePool() is not safe, it might be in use by worker
 	LLAPRFile::remove(getTextureFileName(id), mHeaderAPRFilePoolp);
 }
+// </FS>
 
 //called after mHeaderMutex is locked.
 void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
@@ -2322,13 +2524,22 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
 			  file_maybe_exists = false;
 		  }
 		}
-		mTexturesSizeTotal -= entry.mBodySize;
+		// <FS> Mapped entries table
+		//mTexturesSizeTotal -= entry.mBodySize;
+		//
+		//entry.mImageSize = -1;
+		//entry.mBodySize = 0;
+		//mHeaderIDMap.erase(entry.mID);
+		//mTexturesSizeMap.erase(entry.mID);		
+		//mFreeList.insert(idx);	
+		beginEntriesWrite();
+		eraseIndex(entry.mID, idx);
+		freeEntry(idx); // updates mTexturesSizeTotal
+		endEntriesWrite();
 
 		entry.mImageSize = -1;
 		entry.mBodySize = 0;
-		mHeaderIDMap.erase(entry.mID);
-		mTexturesSizeMap.erase(entry.mID);		
-		mFreeList.insert(idx);	
+		// </FS>
 	}
 
 	if (file_maybe_exists)
@@ -2351,7 +2562,7 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 		removeEntry(idx, entry, tex_filename) ;
 		if (idx >= 0)
 		{			
-			writeEntryToHeaderImmediately(idx, entry);					
+			//writeEntryToHeaderImmediately(idx, entry); // <FS/> Mapped entries table
 			ret = true;
 		}
 
@@ -34,6 +34,12 @@
 
 #include "llworkerthread.h"
 
+// <FS> Mapped entries table
+#include "llmappedfile.h"
+
+#include <atomic>
+// </FS>
+
 class LLImageFormatted;
 class LLTextureCacheWorker;
 class LLImageRaw;
@@ -54,11 +60,28 @@ private:
 	static const U32 sHeaderEncoderStringSize = 32;
 	struct EntriesInfo
 	{
-		EntriesInfo() : mVersion(0.f), mAdressSize(0), mEntries(0) { memset(mEncoderVersion, 0, sHeaderEncoderStringSize); }
+		// <FS> Memory-mapped texture cache entries table
+		//EntriesInfo() : mVersion(0.f), mAdressSize(0), mEntries(0) { memset(mEncoderVersion, 0, sHeaderEncoderStringSize); }
+		EntriesInfo() : mVersion(0.f), mAdressSize(0), mEntries(0),
+			mMaxEntries(0), mIndexSize(0), mIndexUsed(0), mUsedEntries(0), mFreeHead(0), mDirty(0), mReserved(0), mBodySizeTotal(0)
+		{
+			memset(mEncoderVersion, 0, sHeaderEncoderStringSize);
+		}
+		// </FS>
 		F32 mVersion;
 		U32 mAdressSize;
 		char mEncoderVersion[sHeaderEncoderStringSize];
 		U32 mEntries;
+		// <FS> Layout of the memory-mapped entries file, see lltexturecache.cpp
+		U32 mMaxEntries;	// number of Entry slots following the header
+		U32 mIndexSize;		// number of hash index slots following the entries, a power of two
+		U32 mIndexUsed;		// index slots that are in use or deleted
+		U32 mUsedEntries;	// entries that hold a texture
+		U32 mFreeHead;		// first free entry + 1, free entries are chained through mBodySize
+		U32 mDirty;			// set while the file is open for writing
+		U32 mReserved;
+		S64 mBodySizeTotal;	// only valid if the file was closed cleanly
+		// </FS>
 	};
 	struct Entry
 	{
@@ -144,7 +167,10 @@ public:
 	S32 getNumWrites() { return mWriters.size(); }
 	S64Bytes getUsage() { return S64Bytes(mTexturesSizeTotal); }
 	S64Bytes getMaxUsage() { return S64Bytes(sCacheMaxTexturesSize); }
-	U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+	// <FS> Mapped entries table
+	//U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+	U32 getEntries() { return mEntriesFile.isOpen() ? getEntriesInfo()->mEntries : 0; }
+	// </FS>
 	U32 getMaxEntries() { return sCacheMaxEntries; };
 	BOOL isInCache(const LLUUID& id) ;
 	BOOL isInLocal(const LLUUID& id) ; //not thread safe at the moment
@@ -165,24 +191,54 @@ private:
 	void purgeAllTextures(bool purge_directories);
 	void purgeTexturesLazy(F32 time_limit_sec);
 	void purgeTextures(bool validate);
-	LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
-	void closeHeaderEntriesFile();
-	void readEntriesHeader();
-	void setEntriesHeader();
-	void writeEntriesHeader();
+	// <FS> Mapped entries table
+	//LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
+	//void closeHeaderEntriesFile();
+	//void readEntriesHeader();
+	//void setEntriesHeader();
+	//void writeEntriesHeader();
+	bool openEntriesFile();
+	bool createEntriesFile();
+	void closeEntriesFile();
+	bool growEntriesFile(U32 max_entries);
+	void setEntriesHeader(U32 max_entries);
+	void resetEntries();
+	void recoverEntries();
+	EntriesInfo* getEntriesInfo() const { return (EntriesInfo*)mEntriesFile.getData(); }
+	Entry* getEntryTable() const { return (Entry*)(mEntriesFile.getData() + sizeof(EntriesInfo)); }
+	U32* getEntryIndex() const { return (U32*)(mEntriesFile.getData() + sizeof(EntriesInfo) + getEntriesInfo()->mMaxEntries * sizeof(Entry)); }
+	static size_t getEntriesFileSize(U32 max_entries, U32 index_size);
+	static U32 getIndexSizeFor(U32 max_entries);
+	static bool isValidEntry(const Entry& entry) { return entry.mImageSize > entry.mBodySize; }
+	// Probes the hash index. Can be called without mHeaderMutex, see lookupEntry().
+	S32 findEntry(const LLUUID& id) const;
+	// Reads an entry without taking mHeaderMutex unless a writer keeps getting in the way.
+	S32 lookupEntry(const LLUUID& id, Entry& entry);
+	// The following need mHeaderMutex and must be bracketed by begin/endEntriesWrite()
+	void insertIndex(const LLUUID& id, S32 idx);
+	void eraseIndex(const LLUUID& id, S32 idx);
+	void rebuildIndex();
+	void freeEntry(S32 idx);
+	void beginEntriesWrite();
+	void endEntriesWrite();
+	void rebuildLRU();
+	void startPurge(bool validate);
+	// </FS>
 	S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
 	bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
 	void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-	U32 openAndReadEntries(std::vector<Entry>& entries);
-	void writeEntriesAndClose(const std::vector<Entry>& entries);
-	void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
-	void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
+	// <FS> Mapped entries table
+	//U32 openAndReadEntries(std::vector<Entry>& entries);
+	//void writeEntriesAndClose(const std::vector<Entry>& entries);
+	//void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
+	//void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
+	// </FS>
 	void removeEntry(S32 idx, Entry& entry, std::string& filename);
-	void removeCachedTexture(const LLUUID& id) ;
+	void removeCachedTexture(S32 idx) ;
 	S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
 	S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
 	void writeUpdatedEntries() ;
-	void updatedHeaderEntriesFile() ;
+	//void updatedHeaderEntriesFile() ; // <FS/> Mapped entries table
 	void lockHeaders() { mHeaderMutex.lock(); }
 	void unlockHeaders() { mHeaderMutex.unlock(); }
 	
@@ -196,7 +252,7 @@ private:
 	LLMutex mHeaderMutex;
 	LLMutex mListMutex;
 	LLMutex mFastCacheMutex;
-	LLAPRFile* mHeaderAPRFile;
+	//LLAPRFile* mHeaderAPRFile; // <FS/> Mapped entries table
 	LLVolatileAPRPool* mFastCachePoolp;
 
 	// mLocalAPRFilePoolp is not thread safe and is meant only for workers
@@ -222,11 +278,19 @@ private:
 	std::string mHeaderEntriesFileName;
 	std::string mHeaderDataFileName;
 	std::string mFastCacheFileName;
-	EntriesInfo mHeaderEntriesInfo;
-	std::set<S32> mFreeList; // deleted entries
-	std::set<LLUUID> mLRU;
-	typedef std::map<LLUUID, S32> id_map_t;
-	id_map_t mHeaderIDMap;
+	// <FS> Mapped entries table
+	//EntriesInfo mHeaderEntriesInfo;
+	//std::set<S32> mFreeList; // deleted entries
+	//std::set<LLUUID> mLRU;
+	//typedef std::map<LLUUID, S32> id_map_t;
+	//id_map_t mHeaderIDMap;
+	LLMappedFile mEntriesFile; // header, entries and hash index
+	std::atomic<U32> mEntriesSequence; // odd while a writer changes the table
+	S32 mEntriesWriteDepth;
+	typedef std::pair<U32, S32> time_idx_t; // time stamp, entry index
+	typedef std::vector<time_idx_t> time_idx_vector_t;
+	time_idx_vector_t mLRU; // oldest entries, oldest last
+	// </FS>
 
 	LLAPRFile*   mFastCachep;
 	LLFrameTimer mFastCacheTimer;
@@ -234,16 +298,32 @@ private:
 
 	// BODIES (TEXTURES minus headers)
 	std::string mTexturesDirName;
-	typedef std::map<LLUUID,S32> size_map_t;
-	size_map_t mTexturesSizeMap;
+	//typedef std::map<LLUUID,S32> size_map_t; // <FS/> Mapped entries table
+	//size_map_t mTexturesSizeMap; // <FS/> Mapped entries table
 	S64 mTexturesSizeTotal;
 	LLAtomicBool mDoPurge;
 
-	typedef std::map<S32, Entry> idx_entry_map_t;
-	idx_entry_map_t mUpdatedEntryMap;
+	//typedef std::map<S32, Entry> idx_entry_map_t; // <FS/> Mapped entries table
+	//idx_entry_map_t mUpdatedEntryMap; // <FS/> Mapped entries table
 	typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
 	idx_entry_vector_t mPurgeEntryList;
 
+	// <FS> Incremental purge
+	enum EPurgeState
+	{
+		PURGE_IDLE,
+		PURGE_SCAN,		// collecting candidates, a slice of the table per call
+		PURGE_REMOVE	// removing the oldest candidates until under budget
+	};
+	EPurgeState mPurgeState;
+	U32 mPurgeScanPos;
+	bool mPurgeValidate;
+	U32 mPurgeValidateIdx;
+	S64 mPurgeTargetSize;
+	S32 mPurgeCount;
+	time_idx_vector_t mPurgeCandidates; // min-heap on time stamp
+	// </FS>
+
 	// Statics
 	static F32 sHeaderCacheVersion;
 	static U32 sHeaderCacheAddressSize;
@@ -74,6 +74,41 @@ LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheReadLatency("texture
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexDecodeLatency("texture_decode_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sCacheWriteLatency("texture_write_latency");
 LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sTexFetchLatency("texture_fetch_latency");
+// <FS> Lock-free fetcher command and completion queues
+LLTrace::SampleStatHandle<F32Seconds> LLTextureFetch::sMainThreadTime("texture_fetch_main_thread_time", "Time spent by the main thread in the texture fetcher API per frame");
+LLTrace::CountStatHandle<S32> LLTextureFetch::sPriorityCommands("texture_fetch_priority_commands", "Priority changes posted to the texture fetch thread");
+LLTrace::CountStatHandle<S32> LLTextureFetch::sCompletions("texture_fetch_completions", "Requests published as ready by the texture fetch thread");
+
+namespace
+{
+	// Accumulates the time the main thread spends in a fetcher API call.
+	class FetchMainThreadTimer
+	{
+	public:
+		FetchMainThreadTimer(U64& total)
+			: mTotal(total),
+			  mStart(LLTimer::getTotalTime())
+		{}
+
+		~FetchMainThreadTimer()
+		{
+			mTotal += LLTimer::getTotalTime() - mStart;
+		}
+
+	private:
+		U64& mTotal;
+		U64 mStart;
+	};
+
+	// How many cross-thread commands the fetch thread runs per pass.
+	const S32 MAX_COMMANDS_PER_PASS = 16;
+	const size_t PRIORITY_COMMAND_BATCH = 256;
+
+	// Requests not reported ready by the fetch thread are still fully
+	// checked this often as a safety net.
+	const F32 FETCH_POLL_INTERVAL = 1.f;
+}
+// </FS>
 
 LLTextureFetchTester* LLTextureFetch::sTesterp = NULL ;
 const std::string sTesterName("TextureFetchTester");
@@ -622,6 +657,10 @@ private:
 	std::string mGetReason;
 	LLAdaptiveRetryPolicy mFetchRetryPolicy;
 
+	// <FS> Lock-free fetcher command and completion queues
+	F32 mPostedPriority;		// Tmain, last priority posted to the fetch thread
+	LLFrameTimer mMainPollTimer;	// Tmain, time since the last full check in getRequestFinished()
+	// </FS>
 	
 	// Work Data
 	LLMutex mWorkMutex;
@@ -972,7 +1011,10 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
 	  mCacheReadCount(0U),
 	  mCacheWriteCount(0U),
 	  mResourceWaitCount(0U),
-	  mFetchRetryPolicy(10.0,3600.0,2.0,10)
+	  mFetchRetryPolicy(10.0,3600.0,2.0,10),
+	  // <FS> Lock-free fetcher command and completion queues
+	  mPostedPriority(priority)
+	  // </FS>
 {
 	mCanUseNET = mUrl.empty() ;
 	
@@ -1129,6 +1171,12 @@ void LLTextureFetchWorker::setImagePriority(F32 priority)
 		calcWorkPriority();
 		U32 work_priority = mWorkPriority | (getPriority() & LLWorkerThread::PRIORITY_HIGHBITS);
 		setPriority(work_priority);
+		// <FS> Work-stealing decode pool: a queued decode follows the texture
+		if (mDecodeHandle != 0 && mFetcher->mImageDecodeThread)
+		{
+			mFetcher->mImageDecodeThread->setDecodePriority(mDecodeHandle, LLWorkerThread::PRIORITY_NORMAL | mWorkPriority);
+		}
+		// </FS>
 	}
 }
 
@@ -1956,6 +2004,21 @@ bool LLTextureFetchWorker::doWork(S32 param)
 	
 	if (mState == DECODE_IMAGE_UPDATE)
 	{
+		// <FS> Work-stealing decode pool
+		// Drop the decode of a deleted request while it is still queued,
+		// instead of spending a decode thread on it. Anything else still
+		// decodes: a low priority can be transient, and the cache write of
+		// freshly downloaded data needs the decoded image.
+		if (!mDecoded && mDecodeHandle != 0 && mFetcher->mImageDecodeThread &&
+			getFlags(LLWorkerClass::WCF_DELETE_REQUESTED) &&
+			mFetcher->mImageDecodeThread->cancelDecode(mDecodeHandle))
+		{
+			LL_DEBUGS(LOG_TXT) << mID << " DECODE_IMAGE_UPDATE: decode cancelled, request deleted" << LL_ENDL;
+			mDecodeHandle = 0;
+			setState(DONE);
+			return true;
+		}
+		// </FS>
 		if (mDecoded)
 		{
 			if(mFetcher->getFetchDebugger() && !mInLocalCache)
@@ -2026,6 +2089,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		U32 cache_priority = mWorkPriority;
 		mWritten = FALSE;
 		setState(WAIT_ON_WRITE);
+		mFetcher->postCompletion(mID); // <FS/> Decoded data is readable from here on
 		++mCacheWriteCount;
 		CacheWriteResponder* responder = new CacheWriteResponder(mFetcher, mID);
         // This call might be under work mutex, but mRawImage is not nessesary safe here.
@@ -2199,7 +2263,19 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
 {
 	if (mDecodeHandle != 0)
 	{
-		mFetcher->mImageDecodeThread->abortRequest(mDecodeHandle, false);
+		// <FS> Work-stealing decode pool
+		// Pool requests are not known to LLQueuedThread, so abortRequest()
+		// can't reach them.
+		//mFetcher->mImageDecodeThread->abortRequest(mDecodeHandle, false);
+		if (mFetcher->mImageDecodeThread->usesDecodePool())
+		{
+			mFetcher->mImageDecodeThread->cancelDecode(mDecodeHandle);
+		}
+		else
+		{
+			mFetcher->mImageDecodeThread->abortRequest(mDecodeHandle, false);
+		}
+		// </FS>
 		mDecodeHandle = 0;
 	}
 	mFormattedImage = NULL;
@@ -2212,6 +2288,12 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
 // virtual
 void LLTextureFetchWorker::finishWork(S32 param, bool completed)
 {
+	// <FS> Lock-free fetcher command and completion queues
+	// Status is already set at this point, so checkWork() on the main
+	// thread sees the request as done once it picks this up.
+	mFetcher->postCompletion(mID);
+	// </FS>
+
 	// The following are required in case the work was aborted
 	if (mCacheReadHandle != LLTextureCache::nullHandle())
 	{
@@ -2643,7 +2725,8 @@ LLTextureFetch::LLTextureFetch(LLTextureCache* cache, LLImageDecodeThread* image
 	  mFetchSource(LLTextureFetch::FROM_ALL),
 	  mOriginFetchSource(LLTextureFetch::FROM_ALL),
 	  mFetcherLocked(FALSE),
-	  mTextureInfoMainThread(false)
+	  mTextureInfoMainThread(false),
+	  mMainThreadTime(0) // <FS/> Lock-free fetcher command and completion queues
 {
 	mMaxBandwidth = gSavedSettings.getF32("ThrottleBandwidthKBPS");
 	mTextureInfo.setLogging(true);
@@ -2697,12 +2780,19 @@ LLTextureFetch::~LLTextureFetch()
 {
 	clearDeleteList();
 
-	while (! mCommands.empty())
+	// <FS> Lock-free fetcher command and completion queues
+	//while (! mCommands.empty())
+	//{
+	//	TFRequest * req(mCommands.front());
+	//	mCommands.erase(mCommands.begin());
+	//	delete req;
+	//}
+	TFRequest * req(NULL);
+	while (mCommands.try_dequeue(req))
 	{
-		TFRequest * req(mCommands.front());
-		mCommands.erase(mCommands.begin());
 		delete req;
 	}
+	// </FS>
 
 	mHttpWaitResource.clear();
 	
@@ -2718,6 +2808,8 @@ LLTextureFetch::~LLTextureFetch()
 bool LLTextureFetch::createRequest(FTType f_type, const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
 								   S32 w, S32 h, S32 c, S32 desired_discard, bool needs_aux, bool can_use_http)
 {
+	FetchMainThreadTimer main_timer(mMainThreadTime); // <FS/> Lock-free fetcher command and completion queues
+
 	if(mFetcherLocked)
 	{
 		return false;
@@ -2731,7 +2823,10 @@ bool LLTextureFetch::createRequest(FTType f_type, const std::string& url, const
 	{
 		LL_DEBUGS("Avatar") << " requesting " << id << " " << w << "x" << h << " discard " << desired_discard << " type " << f_type << LL_ENDL;
 	}
-	LLTextureFetchWorker* worker = getWorker(id) ;
+	// <FS> Lock-free fetcher command and completion queues
+	//LLTextureFetchWorker* worker = getWorker(id) ;
+	LLTextureFetchWorker* worker = getWorkerMainThread(id);
+	// </FS>
 	if (worker)
 	{
 		if (worker->mHost != host)
@@ -2799,6 +2894,7 @@ bool LLTextureFetch::createRequest(FTType f_type, const std::string& url, const
 		worker->mActiveCount++;
 		worker->mNeedsAux = needs_aux;
 		worker->setImagePriority(priority);
+		worker->mPostedPriority = priority; // <FS/> Lock-free fetcher command and completion queues
 		worker->setDesiredDiscard(desired_discard, desired_size);
 		worker->setCanUseHTTP(can_use_http);
 
@@ -2892,9 +2988,24 @@ void LLTextureFetch::removeFromHTTPQueue(const LLUUID& id, S32Bytes received_siz
 // parallel changes in removeRequest().  They're functionally
 // identical with only argument variations.
 //
+// <FS> Lock-free fetcher command and completion queues
 // Threads:  T*
+// Threads:  Tmain
+// Called from LLViewerFetchedTexture.  Only the main thread erases from
+// mRequestMap (getWorkerMainThread() relies on that) and mReadyRequests is
+// main thread only.  Priority changes still in mPriorityCommands and ids
+// still in mCompletions for this worker are dropped once the fetch thread
+// and drainCompletions() no longer find it in mRequestMap.
+// </FS>
 void LLTextureFetch::deleteRequest(const LLUUID& id, bool cancel)
 {
+	// <FS> Lock-free fetcher command and completion queues
+	// Deletion stays synchronous: the worker must be out of mRequestMap
+	// before scheduleDelete() so no queued command can reach it later.
+	FetchMainThreadTimer main_timer(mMainThreadTime);
+	mReadyRequests.erase(id);
+	// </FS>
+
 	lockQueue();														// +Mfq
 	LLTextureFetchWorker* worker = getWorkerAfterLock(id);
 	if (worker)
@@ -2918,7 +3029,12 @@ void LLTextureFetch::deleteRequest(const LLUUID& id, bool cancel)
 // parallel changes in deleteRequest().  They're functionally
 // identical with only argument variations.
 //
+// <FS> Lock-free fetcher command and completion queues
 // Threads:  T*
+// Threads:  Tmain
+// Called from createRequest() on a host change and from deleteAllRequests()
+// at shutdown, with the same main thread only rules as deleteRequest().
+// </FS>
 void LLTextureFetch::removeRequest(LLTextureFetchWorker* worker, bool cancel)
 {
 	if(!worker)
@@ -2926,6 +3042,8 @@ void LLTextureFetch::removeRequest(LLTextureFetchWorker* worker, bool cancel)
 		return;
 	}
 
+	mReadyRequests.erase(worker->mID); // <FS/> Lock-free fetcher command and completion queues
+
 	lockQueue();														// +Mfq
 	size_t erased_1 = mRequestMap.erase(worker->mID);
 	unlockQueue();														// -Mfq
@@ -3007,20 +3125,73 @@ LLTextureFetchWorker* LLTextureFetch::getWorker(const LLUUID& id)
 	return getWorkerAfterLock(id);
 }																		// -Mfq
 
+// <FS> Lock-free fetcher command and completion queues
+// Threads:  Tmain
+LLTextureFetchWorker* LLTextureFetch::getWorkerMainThread(const LLUUID& id)
+{
+	// Only the main thread inserts into or erases from mRequestMap (and
+	// it takes Mfq to do so), so it can read it without the lock.  The
+	// single threaded fetcher runs everything on the main thread anyway.
+	return getWorkerAfterLock(id);
+}
+
+// Threads:  Tmain
+void LLTextureFetch::drainCompletions()
+{
+	LLUUID ids[64];
+	size_t count;
+	while ((count = mCompletions.try_dequeue_bulk(ids, LL_ARRAY_SIZE(ids))) > 0)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Late notifications for requests deleted in the meantime are dropped
+			if (getWorkerMainThread(ids[i]))
+			{
+				mReadyRequests.insert(ids[i]);
+			}
+		}
+		add(sCompletions, (S32)count);
+	}
+}
+// </FS>
+
 
 // Threads:  T*
 bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 										LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux,
 										LLCore::HttpStatus& last_http_get_status)
 {
+	// <FS> Lock-free fetcher command and completion queues
+	FetchMainThreadTimer main_timer(mMainThreadTime);
+	if (mCompletions.size_approx() > 0)
+	{
+		drainCompletions();
+	}
+	// </FS>
+
 	bool res = false;
-	LLTextureFetchWorker* worker = getWorker(id);
+	// <FS> Lock-free fetcher command and completion queues
+	//LLTextureFetchWorker* worker = getWorker(id);
+	LLTextureFetchWorker* worker = getWorkerMainThread(id);
+	// </FS>
 	if (worker)
 	{
+		// <FS> Lock-free fetcher command and completion queues
+		uuid_set_t::iterator ready_it = mReadyRequests.find(id);
+		// </FS>
 		if (worker->wasAborted())
 		{
 			res = true;
 		}
+		// <FS> Lock-free fetcher command and completion queues
+		// Nothing new to report until the fetch thread publishes this
+		// request, so skip checkWork() and its locks.
+		else if (worker->haveWork() && ready_it == mReadyRequests.end() &&
+				 worker->mMainPollTimer.getElapsedTimeF32() < FETCH_POLL_INTERVAL)
+		{
+			res = false;
+		}
+		// </FS>
 		else if (!worker->haveWork())
 		{
 			// Should only happen if we set mDebugPause...
@@ -3032,6 +3203,13 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 		}
 		else if (worker->checkWork())
 		{
+			// <FS> Lock-free fetcher command and completion queues
+			if (ready_it != mReadyRequests.end())
+			{
+				mReadyRequests.erase(ready_it);
+			}
+			worker->mMainPollTimer.reset();
+			// </FS>
 			F32 decode_time;
 			F32 fetch_time;
 			F32 cache_read_time;
@@ -3080,6 +3258,7 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 		}
 		else
 		{
+			worker->mMainPollTimer.reset(); // <FS/> Lock-free fetcher command and completion queues
 			worker->lockWorkMutex();									// +Mw
 			if ((worker->mDecodedDiscard >= 0) &&
 				(worker->mDecodedDiscard < discard_level || discard_level < 0) &&
@@ -3100,20 +3279,47 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 	return res;
 }
 
-// Threads:  T*
+// <FS> Lock-free fetcher command and completion queues
+//// Threads:  T*
+//bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
+//{
+//	bool res = false;
+//	LLTextureFetchWorker* worker = getWorker(id);
+//	if (worker)
+//	{
+//		worker->lockWorkMutex();										// +Mw
+//		worker->setImagePriority(priority);
+//		worker->unlockWorkMutex();										// -Mw
+//		res = true;
+//	}
+//	return res;
+//}
+
+// Threads:  Tmain
 bool LLTextureFetch::updateRequestPriority(const LLUUID& id, F32 priority)
 {
-	bool res = false;
-	LLTextureFetchWorker* worker = getWorker(id);
-	if (worker)
+	FetchMainThreadTimer main_timer(mMainThreadTime);
+
+	LLTextureFetchWorker* worker = getWorkerMainThread(id);
+	if (!worker)
 	{
-		worker->lockWorkMutex();										// +Mw
-		worker->setImagePriority(priority);
-		worker->unlockWorkMutex();										// -Mw
-		res = true;
+		return false;
 	}
-	return res;
+
+	// Same threshold setImagePriority() applies, so changes it would
+	// ignore anyway never cross the thread.  The fetch thread picks the
+	// queue up on its next pass; update() unpauses it every frame.
+	F32 delta = fabs(priority - worker->mPostedPriority);
+	if (delta > (worker->mPostedPriority * .05f))
+	{
+		worker->mPostedPriority = priority;
+		PriorityCommand cmd = { id, priority };
+		mPriorityCommands.enqueue(cmd);
+		add(sPriorityCommands, 1);
+	}
+	return true;
 }
+// </FS>
 
 // Replicates and expands upon the base class's
 // getPending() implementation.  getPending() and
@@ -3135,7 +3341,10 @@ S32 LLTextureFetch::getPending()
         LLMutexLock lock(&mQueueMutex);									// +Mfq
         
         res = mRequestQueue.size();
-        res += mCommands.size();
+        // <FS> Lock-free fetcher command and completion queues
+        //res += mCommands.size();
+        res += (S32)(mCommands.size_approx() + mPriorityCommands.size_approx());
+        // </FS>
     }																	// -Mfq
 	unlockData();														// -Ct
 	return res;
@@ -3154,12 +3363,15 @@ bool LLTextureFetch::runCondition()
 	//
 	// Changes here may need to be reflected in getPending().
 	
-	bool have_no_commands(false);
-	{
-		LLMutexLock lock(&mQueueMutex);									// +Mfq
-		
-		have_no_commands = mCommands.empty();
-	}																	// -Mfq
+	// <FS> Lock-free fetcher command and completion queues
+	//bool have_no_commands(false);
+	//{
+	//	LLMutexLock lock(&mQueueMutex);									// +Mfq
+	//	
+	//	have_no_commands = mCommands.empty();
+	//}																	// -Mfq
+	bool have_no_commands(mCommands.size_approx() == 0 && mPriorityCommands.size_approx() == 0);
+	// </FS>
 	
 	return ! (have_no_commands
 			  && (mRequestQueue.empty() && mIdleThread));		// From base class
@@ -3189,6 +3401,10 @@ void LLTextureFetch::commonUpdate()
 	
 	// Run a cross-thread command, if any.
 	cmdDoWork();
+
+	// <FS> Lock-free fetcher command and completion queues
+	cmdApplyPriorities();
+	// </FS>
 	
 	// Deliver all completion notifications
 	LLCore::HttpStatus status = mHttpRequest->update(0);
@@ -3219,6 +3435,12 @@ S32 LLTextureFetch::update(F32 max_time_ms)
 	}
 
 	S32 res = LLWorkerThread::update(max_time_ms);
+
+	// <FS> Lock-free fetcher command and completion queues
+	drainCompletions();
+	sample(sMainThreadTime, F32Seconds((F32)mMainThreadTime * 1.0e-6f));
+	mMainThreadTime = 0;
+	// </FS>
 	
 	if (!mDebugPause)
 	{
@@ -3718,7 +3940,10 @@ BOOL LLTextureFetch::isFromLocalCache(const LLUUID& id)
 {
 	BOOL from_cache = FALSE ;
 
-	LLTextureFetchWorker* worker = getWorker(id);
+	// <FS> Lock-free fetcher command and completion queues
+	//LLTextureFetchWorker* worker = getWorker(id);
+	LLTextureFetchWorker* worker = on_main_thread() ? getWorkerMainThread(id) : getWorker(id);
+	// </FS>
 	if (worker)
 	{
 		worker->lockWorkMutex();										// +Mw
@@ -3740,7 +3965,11 @@ S32 LLTextureFetch::getFetchState(const LLUUID& id, F32& data_progress_p, F32& r
 	F32 request_dtime = 999999.f;
 	U32 fetch_priority = 0;
 	
-	LLTextureFetchWorker* worker = getWorker(id);
+	// <FS> Lock-free fetcher command and completion queues
+	//LLTextureFetchWorker* worker = getWorker(id);
+	FetchMainThreadTimer main_timer(mMainThreadTime);
+	LLTextureFetchWorker* worker = getWorkerMainThread(id);
+	// </FS>
 	if (worker && worker->haveWork())
 	{
 		worker->lockWorkMutex();										// +Mw
@@ -4047,9 +4276,12 @@ void LLTextureFetch::commandDataBreak()
 // Threads:  T*
 void LLTextureFetch::cmdEnqueue(TFRequest * req)
 {
-	lockQueue();														// +Mfq
-	mCommands.push_back(req);
-	unlockQueue();														// -Mfq
+	// <FS> Lock-free fetcher command and completion queues
+	//lockQueue();														// +Mfq
+	//mCommands.push_back(req);
+	//unlockQueue();														// -Mfq
+	mCommands.enqueue(req);
+	// </FS>
 
 	unpause();
 }
@@ -4059,13 +4291,19 @@ LLTextureFetch::TFRequest * LLTextureFetch::cmdDequeue()
 {
 	TFRequest * ret = 0;
 	
-	lockQueue();														// +Mfq
-	if (! mCommands.empty())
+	// <FS> Lock-free fetcher command and completion queues
+	//lockQueue();														// +Mfq
+	//if (! mCommands.empty())
+	//{
+	//	ret = mCommands.front();
+	//	mCommands.erase(mCommands.begin());
+	//}
+	//unlockQueue();														// -Mfq
+	if (! mCommands.try_dequeue(ret))
 	{
-		ret = mCommands.front();
-		mCommands.erase(mCommands.begin());
+		ret = 0;
 	}
-	unlockQueue();														// -Mfq
+	// </FS>
 
 	return ret;
 }
@@ -4078,15 +4316,76 @@ void LLTextureFetch::cmdDoWork()
 		return;  // debug: don't do any work
 	}
 
-	TFRequest * req = cmdDequeue();
-	if (req)
+	// <FS> Lock-free fetcher command and completion queues
+	//TFRequest * req = cmdDequeue();
+	//if (req)
+	//{
+	//	// One request per pass should really be enough for this.
+	//	req->doWork(this);
+	//	delete req;
+	//}
+	// Dequeueing no longer contends with the main thread, so run a
+	// bounded batch per pass.
+	for (S32 i = 0; i < MAX_COMMANDS_PER_PASS; ++i)
 	{
-		// One request per pass should really be enough for this.
+		TFRequest * req = cmdDequeue();
+		if (!req)
+		{
+			break;
+		}
 		req->doWork(this);
 		delete req;
 	}
+	// </FS>
 }
 
+// <FS> Lock-free fetcher command and completion queues
+// Threads:  Ttf
+void LLTextureFetch::cmdApplyPriorities()
+{
+	if (mDebugPause)
+	{
+		return;  // debug: don't do any work
+	}
+
+	// Later commands for the same request replace earlier ones, including
+	// the ones still waiting from a previous pass.
+	PriorityCommand cmds[PRIORITY_COMMAND_BATCH];
+	size_t count;
+	while ((count = mPriorityCommands.try_dequeue_bulk(cmds, PRIORITY_COMMAND_BATCH)) > 0)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			mPendingPriorities[cmds[i].mID] = cmds[i].mPriority;
+		}
+	}
+	if (mPendingPriorities.empty())
+	{
+		return;
+	}
+
+	// Deletion happens on the main thread after the worker left
+	// mRequestMap, so holding Mfq keeps the worker alive.  Workers take Mfq
+	// while holding Mw, hence only try Mw and keep busy ones for later.
+	LLMutexLock lock(&mQueueMutex);										// +Mfq
+	for (pending_priority_map_t::iterator iter = mPendingPriorities.begin(); iter != mPendingPriorities.end(); )
+	{
+		LLTextureFetchWorker* worker = getWorkerAfterLock(iter->first);
+		if (worker && !worker->getFlags(LLWorkerClass::WCF_DELETE_REQUESTED))
+		{
+			if (!worker->mWorkMutex.trylock())							// +Mw
+			{
+				++iter;
+				continue;
+			}
+			worker->setImagePriority(iter->second);
+			worker->unlockWorkMutex();									// -Mw
+		}
+		iter = mPendingPriorities.erase(iter);
+	}
+}																		// -Mfq
+// </FS>
+
 //////////////////////////////////////////////////////////////////////////////
 
 // Private (anonymous) class methods implementing the command scheme.
@@ -42,6 +42,9 @@
 #include "httphandler.h"
 #include "lltrace.h"
 #include "llviewertexture.h"
+// <FS> Lock-free fetcher command and completion queues
+#include "concurrentqueue.h"
+// </FS>
 
 class LLViewerTexture;
 class LLTextureFetchWorker;
@@ -87,7 +90,10 @@ public:
 	// base class's deleteRequest() but is functionally quite
 	// different.
 	//
+	// <FS> Lock-free fetcher command and completion queues
 	// Threads:  T*
+	// Threads:  Tmain
+	// </FS>
 	void deleteRequest(const LLUUID& id, bool cancel);
 
 	void deleteAllRequests();
@@ -98,8 +104,12 @@ public:
 							LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux,
 							LLCore::HttpStatus& last_http_get_status);
 
+	// <FS> Priority changes are posted to the fetch thread without locking
 	// Threads:  T*
+	//bool updateRequestPriority(const LLUUID& id, F32 priority);
+	// Threads:  Tmain
 	bool updateRequestPriority(const LLUUID& id, F32 priority);
+	// </FS>
 
     // Threads:  T*
 	bool receiveImageHeader(const LLHost& host, const LLUUID& id, U8 codec, U16 packets, U32 totalbytes, U16 data_size, U8* data);
@@ -120,7 +130,10 @@ public:
 	//			request.  We should make these codes public if we're
 	//			going to return them as a status value.
 	//
-    // Threads:  T*
+    // <FS> Lock-free fetcher command and completion queues
+    //// Threads:  T*
+    // Threads:  Tmain
+    // </FS>
 	S32 getFetchState(const LLUUID& id, F32& decode_progress_p, F32& requested_priority_p,
 					  U32& fetch_priority_p, F32& fetch_dtime_p, F32& request_dtime_p, bool& can_use_http);
 
@@ -147,6 +160,12 @@ public:
 
 	// Threads:  T*
 	LLTextureFetchWorker* getWorker(const LLUUID& id);
+
+	// <FS> Lock-free lookup for the main thread.  mRequestMap is only ever
+	// modified on the main thread, so reads there need no lock.
+	// Threads:  Tmain
+	LLTextureFetchWorker* getWorkerMainThread(const LLUUID& id);
+	// </FS>
 	
 	// Threads:  T*
 	// Locks:  Mfq
@@ -301,6 +320,30 @@ private:
 	 * Threads:  Ttf
 	 */
 	void cmdDoWork();
+
+	// <FS> Lock-free fetcher command and completion queues
+	/**
+	 * Applies the priority changes posted by updateRequestPriority().
+	 *
+	 * Threads:  Ttf
+	 */
+	void cmdApplyPriorities();
+
+	/**
+	 * Publishes a request whose results may have changed so that the
+	 * main thread only checks the requests that need it.
+	 *
+	 * Threads:  Ttf
+	 */
+	void postCompletion(const LLUUID& id) { mCompletions.enqueue(id); }
+
+	/**
+	 * Moves the published completions into mReadyRequests.
+	 *
+	 * Threads:  Tmain
+	 */
+	void drainCompletions();
+	// </FS>
 	
 public:
 	LLUUID mDebugID;
@@ -316,9 +359,17 @@ public:
 	static LLTrace::SampleStatHandle<F32Seconds> sCacheWriteLatency;
     static LLTrace::SampleStatHandle<F32Seconds> sTexFetchLatency;
     static LLTrace::EventStatHandle<LLUnit<F32, LLUnits::Percent> > sCacheHitRate;
+	// <FS> Lock-free fetcher command and completion queues
+	static LLTrace::SampleStatHandle<F32Seconds> sMainThreadTime;
+	static LLTrace::CountStatHandle<S32>        sPriorityCommands;
+	static LLTrace::CountStatHandle<S32>        sCompletions;
+	// </FS>
 
 private:
-	LLMutex mQueueMutex;        //to protect mRequestMap and mCommands only
+	// <FS> mCommands no longer needs it
+	//LLMutex mQueueMutex;        //to protect mRequestMap and mCommands only
+	LLMutex mQueueMutex;        //to protect mRequestMap only (main thread writes, other threads read)
+	// </FS>
 	LLMutex mNetworkQueueMutex; //to protect mNetworkQueue, mHTTPTextureQueue and mCancelQueue.
 
 	LLTextureCache* mTextureCache;
@@ -326,7 +377,7 @@ private:
 	
 	// Map of all requests by UUID
 	typedef std::map<LLUUID,LLTextureFetchWorker*> map_t;
-	map_t mRequestMap;													// Mfq
+	map_t mRequestMap;													// Mfq (writes), Tmain (reads)
 
 	// Set of requests that require network data
 	typedef std::set<LLUUID> queue_t;
@@ -350,8 +401,33 @@ private:
 	// is logically tied to LLQueuedThread's list of
 	// QueuedRequest instances and so must be covered by the
 	// same locks.
-	typedef std::vector<TFRequest *> command_queue_t;
-	command_queue_t mCommands;											// Mfq
+	// <FS> Lock-free command queue.  Order is only kept per producer,
+	// which matches the old FIFO for commands from the main thread.
+	//typedef std::vector<TFRequest *> command_queue_t;
+	//command_queue_t mCommands;											// Mfq
+	typedef moodycamel::ConcurrentQueue<TFRequest *> command_queue_t;
+	command_queue_t mCommands;											// <none>
+
+	// Priority changes don't need a heap allocated TFRequest each.  Only
+	// the latest posted value per request is applied.
+	struct PriorityCommand
+	{
+		LLUUID	mID;
+		F32		mPriority;
+	};
+	moodycamel::ConcurrentQueue<PriorityCommand> mPriorityCommands;	// <none>
+	typedef std::map<LLUUID, F32> pending_priority_map_t;
+	pending_priority_map_t mPendingPriorities;							// Ttf
+
+	// Requests that reached WAIT_ON_WRITE or finished their work.  Filled
+	// by the fetch thread, drained into mReadyRequests by the main thread.
+	moodycamel::ConcurrentQueue<LLUUID> mCompletions;					// <none>
+	uuid_set_t mReadyRequests;											// Tmain
+
+	// Microseconds spent by the main thread inside the fetcher API
+	// since the last update().
+	U64 mMainThreadTime;												// Tmain
+	// </FS>
 
 	// If true, modifies some behaviors that help with QA tasks.
 	const bool mQAMode;
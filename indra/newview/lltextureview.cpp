@@ -760,7 +760,10 @@ void LLGLTexMemBar::draw()
 	text = llformat("Mesh: Reqs(Tot/Htp/Big): %u/%u/%u Rtr/Err: %u/%u Cread/Cwrite: %u/%u Low/At/High: %d/%d/%d",
 					LLMeshRepository::sMeshRequestCount, LLMeshRepository::sHTTPRequestCount, LLMeshRepository::sHTTPLargeRequestCount,
 					LLMeshRepository::sHTTPRetryCount, LLMeshRepository::sHTTPErrorCount,
-					LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
+					// <FS> Mesh decode pool: the counters are atomic now
+					//LLMeshRepository::sCacheReads, LLMeshRepository::sCacheWrites,
+					LLMeshRepository::sCacheReads.load(), LLMeshRepository::sCacheWrites.load(),
+					// </FS>
 					LLMeshRepoThread::sRequestLowWater, LLMeshRepoThread::sRequestWaterLevel, LLMeshRepoThread::sRequestHighWater);
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -31,6 +31,7 @@
 
 // Library includes
 #include "llwindow.h"	// getGamma()
+#include "llsdserialize.h" // <FS/> Arena allocation for parsed LLSD
 
 // <FS:Zi> Handle IME text input getting enabled or disabled
 #if LL_SDL2
@@ -1144,6 +1145,13 @@ void handleBandwidthChanged(const LLSD& newValue)
 }
 // </FS:Ansariel>
 
+// <FS> Arena allocation for parsed LLSD
+static void handleLLSDParseArenaChanged(const LLSD& newvalue)
+{
+	LLSDParser::setUseArena(newvalue.asBoolean());
+}
+// </FS>
+
 // <FS:Zi> Handle IME text input getting enabled or disabled
 #if LL_SDL2
 static bool handleSDL2IMEEnabledChanged(const LLSD& newvalue)
@@ -1445,6 +1453,11 @@ void settings_setup_listeners()
 	setting_setup_signal_listener(gSavedSettings, "FSTuningFPSStrategy", handleFPSTuningStrategyChanged);
 	// </FS:Beq>
 
+	// <FS> Arena allocation for parsed LLSD
+	setting_setup_signal_listener(gSavedSettings, "FSLLSDParseArena", handleLLSDParseArenaChanged);
+	LLSDParser::setUseArena(gSavedSettings.getBOOL("FSLLSDParseArena"));
+	// </FS>
+
 	// <FS:Zi> Handle IME text input getting enabled or disabled
 #if LL_SDL2
 	gSavedSettings.getControl("SDL2IMEEnabled")->getSignal()->connect(boost::bind(&handleSDL2IMEEnabledChanged, _2));
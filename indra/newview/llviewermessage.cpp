@@ -147,6 +147,7 @@
 #include "fskeywords.h" // <FS:PP> FIRE-10178: Keyword Alerts in group IM do not work unless the group is in the foreground
 #include "fslslbridge.h"
 #include "fsmoneytracker.h"
+#include "fsobjectupdatedecoder.h"
 #include "llattachmentsmgr.h"
 #include "lleconomy.h"
 #include "llfloaterbump.h"
@@ -4567,6 +4568,10 @@ void process_object_update(LLMessageSystem *mesgsys, void **user_data)
 		gObjectData += (U32Bytes)mesgsys->getReceiveSize();
 	}
 
+	// <FS> Staged object updates: apply the queued ones first
+	FSObjectUpdateDecoder::instance().flush();
+	// </FS>
+
 	// Update the object...
 	S32 old_num_objects = gObjectList.mNumNewObjects;
 	gObjectList.processObjectUpdate(mesgsys, user_data, OUT_FULL);
@@ -4588,6 +4593,15 @@ void process_compressed_object_update(LLMessageSystem *mesgsys, void **user_data
 		gObjectData += (U32Bytes)mesgsys->getReceiveSize();
 	}
 
+	// <FS> Staged object updates
+	FSObjectUpdateDecoder& decoder = FSObjectUpdateDecoder::instance();
+	if (decoder.stageCompressedUpdate(mesgsys))
+	{
+		return;
+	}
+	decoder.flush();
+	// </FS>
+
 	// Update the object...
 	S32 old_num_objects = gObjectList.mNumNewObjects;
 	gObjectList.processCompressedObjectUpdate(mesgsys, user_data, OUT_FULL_COMPRESSED);
@@ -4609,6 +4623,13 @@ void process_cached_object_update(LLMessageSystem *mesgsys, void **user_data)
 		gObjectData += (U32Bytes)mesgsys->getReceiveSize();
 	}
 
+	// <FS> Staged object updates
+	if (FSObjectUpdateDecoder::instance().stageCachedUpdate(mesgsys))
+	{
+		return;
+	}
+	// </FS>
+
 	// Update the object...
 	gObjectList.processCachedObjectUpdate(mesgsys, user_data, OUT_FULL_CACHED);
 }
@@ -4625,6 +4646,8 @@ void process_terse_object_update_improved(LLMessageSystem *mesgsys, void **user_
 		gObjectData += (U32Bytes)mesgsys->getReceiveSize();
 	}
 
+	FSObjectUpdateDecoder::instance().flush(); // <FS/> Staged object updates
+
 	S32 old_num_objects = gObjectList.mNumNewObjects;
 	gObjectList.processCompressedObjectUpdate(mesgsys, user_data, OUT_TERSE_IMPROVED);
 	if (old_num_objects != gObjectList.mNumNewObjects)
@@ -4637,6 +4660,8 @@ void process_kill_object(LLMessageSystem *mesgsys, void **user_data)
 {
     LL_PROFILE_ZONE_SCOPED;
 
+	FSObjectUpdateDecoder::instance().flush(); // <FS/> Staged object updates
+
 	LLUUID		id;
 
 	U32 ip = mesgsys->getSenderIP();
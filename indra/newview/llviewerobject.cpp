@@ -108,6 +108,7 @@
 #include "llcallstack.h"
 #include "llmeshrepository.h"
 #include "llgl.h"
+#include "llmessagetemplate.h" // <FS/> Compiled message accessors
 // [RLVa:KB] - Checked: 2011-05-22 (RLVa-1.3.1a)
 #include "rlvactions.h"
 #include "rlvcommon.h"
@@ -123,6 +124,36 @@
 
 //#define DEBUG_UPDATE_TYPE
 
+// <FS> Compiled message accessors
+namespace
+{
+	// The ObjectUpdate variables processUpdateMessage() reads for every full update
+	struct ObjectUpdateSlots
+	{
+		LLMessageSlot mCRC;
+		LLMessageSlot mParentID;
+		LLMessageSlot mSound;
+		LLMessageSlot mOwnerID;
+		LLMessageSlot mGain;
+		LLMessageSlot mRadius;
+		LLMessageSlot mFlags;
+		LLMessageSlot mMaterial;
+		LLMessageSlot mClickAction;
+		LLMessageSlot mScale;
+		LLMessageSlot mObjectData;
+		LLMessageSlot mUpdateFlags;
+		LLMessageSlot mState;
+		LLMessageSlot mNameValue;
+		LLMessageSlot mData;
+		LLMessageSlot mText;
+		LLMessageSlot mTextColor;
+		LLMessageSlot mMediaURL;
+		LLMessageSlot mExtraParams;
+	};
+	ObjectUpdateSlots sFullUpdate;
+}
+// </FS>
+
 BOOL		LLViewerObject::sVelocityInterpolate = TRUE;
 BOOL		LLViewerObject::sPingInterpolate = TRUE; 
 
@@ -615,6 +646,32 @@ void LLViewerObject::printNameValuePairs() const
 	}
 }
 
+// <FS> Compiled message accessors
+// static
+void LLViewerObject::initMessageSlots(LLMessageSystem* msg)
+{
+	sFullUpdate.mCRC = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_CRC);
+	sFullUpdate.mParentID = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_ParentID);
+	sFullUpdate.mSound = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Sound);
+	sFullUpdate.mOwnerID = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_OwnerID);
+	sFullUpdate.mGain = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Gain);
+	sFullUpdate.mRadius = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Radius);
+	sFullUpdate.mFlags = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Flags);
+	sFullUpdate.mMaterial = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Material);
+	sFullUpdate.mClickAction = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_ClickAction);
+	sFullUpdate.mScale = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Scale);
+	sFullUpdate.mObjectData = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_ObjectData);
+	sFullUpdate.mUpdateFlags = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+	sFullUpdate.mState = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_State);
+	sFullUpdate.mNameValue = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_NameValue);
+	sFullUpdate.mData = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Data);
+	sFullUpdate.mText = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_Text);
+	sFullUpdate.mTextColor = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_TextColor);
+	sFullUpdate.mMediaURL = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_MediaURL);
+	sFullUpdate.mExtraParams = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_ExtraParams);
+}
+// </FS>
+
 void LLViewerObject::initVOClasses()
 {
 	// Initialized shared class stuff first.
@@ -725,6 +782,15 @@ void LLViewerObject::unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::stri
 	dp->reset();
 }
 
+// <FS> Staged object updates
+//static
+S32 LLViewerObject::getObjectDataOffset(const std::string& name)
+{
+	std::map<std::string, U32>::const_iterator it = sObjectDataMap.find(name);
+	return it != sObjectDataMap.end() ? (S32)it->second : -1;
+}
+// </FS>
+
 //static 
 U32 LLViewerObject::unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id)
 {
@@ -1326,19 +1392,34 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				F32    cutoff;
 				U8     sound_flags;
 
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_CRC, crc, block_num);
-				mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_ParentID, parent_id, block_num);
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_Sound, audio_uuid, block_num );
+				// <FS> Compiled message accessors
+				//mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_CRC, crc, block_num);
+				//mesgsys->getU32Fast( _PREHASH_ObjectData, _PREHASH_ParentID, parent_id, block_num);
+				//mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_Sound, audio_uuid, block_num );
+				//// HACK: Owner id only valid if non-null sound id or particle system
+				//mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_OwnerID, owner_id, block_num );
+				//mesgsys->getF32Fast( _PREHASH_ObjectData, _PREHASH_Gain, gain, block_num );
+				//mesgsys->getF32Fast(  _PREHASH_ObjectData, _PREHASH_Radius, cutoff, block_num );
+				//mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Flags, sound_flags, block_num );
+				//mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Material, material, block_num );
+				//mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_ClickAction, click_action, block_num); 
+				//mesgsys->getVector3Fast(_PREHASH_ObjectData, _PREHASH_Scale, new_scale, block_num );
+				//length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
+				//mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+				mesgsys->getU32Fast(sFullUpdate.mCRC, crc, block_num);
+				mesgsys->getU32Fast(sFullUpdate.mParentID, parent_id, block_num);
+				mesgsys->getUUIDFast(sFullUpdate.mSound, audio_uuid, block_num);
 				// HACK: Owner id only valid if non-null sound id or particle system
-				mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_OwnerID, owner_id, block_num );
-				mesgsys->getF32Fast( _PREHASH_ObjectData, _PREHASH_Gain, gain, block_num );
-				mesgsys->getF32Fast(  _PREHASH_ObjectData, _PREHASH_Radius, cutoff, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Flags, sound_flags, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_Material, material, block_num );
-				mesgsys->getU8Fast(  _PREHASH_ObjectData, _PREHASH_ClickAction, click_action, block_num); 
-				mesgsys->getVector3Fast(_PREHASH_ObjectData, _PREHASH_Scale, new_scale, block_num );
-				length = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ObjectData);
-				mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+				mesgsys->getUUIDFast(sFullUpdate.mOwnerID, owner_id, block_num);
+				mesgsys->getF32Fast(sFullUpdate.mGain, gain, block_num);
+				mesgsys->getF32Fast(sFullUpdate.mRadius, cutoff, block_num);
+				mesgsys->getU8Fast(sFullUpdate.mFlags, sound_flags, block_num);
+				mesgsys->getU8Fast(sFullUpdate.mMaterial, material, block_num);
+				mesgsys->getU8Fast(sFullUpdate.mClickAction, click_action, block_num);
+				mesgsys->getVector3Fast(sFullUpdate.mScale, new_scale, block_num);
+				length = mesgsys->getSizeFast(sFullUpdate.mObjectData, block_num);
+				mesgsys->getBinaryDataFast(sFullUpdate.mObjectData, data, length, block_num, MAX_OBJECT_BINARY_DATA_SIZE);
+				// </FS>
 
 				mTotalCRC = crc;
                 // Might need to update mSourceMuted here to properly pick up new radius
@@ -1515,24 +1596,30 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				//
 
 				U32 flags;
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num);
+				//mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, block_num); // <FS/> Compiled message accessors
+				mesgsys->getU32Fast(sFullUpdate.mUpdateFlags, flags, block_num);
 				// clear all but local flags
 				mFlags &= FLAGS_LOCAL;
 				mFlags |= flags;
 
 				U8 state;
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_State, state, block_num );
+				//mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_State, state, block_num ); // <FS/> Compiled message accessors
+				mesgsys->getU8Fast(sFullUpdate.mState, state, block_num);
 				mAttachmentState = state;
 
 				// ...new objects that should come in selected need to be added to the selected list
 				mCreateSelected = ((flags & FLAGS_CREATE_SELECTED) != 0);
 
 				// Set all name value pairs
-				S32 nv_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_NameValue);
+				// <FS> Compiled message accessors
+				//S32 nv_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_NameValue);
+				S32 nv_size = mesgsys->getSizeFast(sFullUpdate.mNameValue, block_num);
+				// </FS>
 				if (nv_size > 0)
 				{
 					std::string name_value_list;
-					mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_NameValue, name_value_list, block_num);
+					//mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_NameValue, name_value_list, block_num); // <FS/> Compiled message accessors
+					mesgsys->getStringFast(sFullUpdate.mNameValue, name_value_list, block_num);
 					setNameValueList(name_value_list);
 				}
 
@@ -1543,7 +1630,8 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				// Check for appended generic data
-				S32 data_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Data);
+				//S32 data_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Data); // <FS/> Compiled message accessors
+				S32 data_size = mesgsys->getSizeFast(sFullUpdate.mData, block_num);
 				if (data_size <= 0)
 				{
 					mData = NULL;
@@ -1552,10 +1640,12 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				{
 					// ...has generic data
 					mData = new U8[data_size];
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, mData, data_size, block_num);
+					//mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, mData, data_size, block_num); // <FS/> Compiled message accessors
+					mesgsys->getBinaryDataFast(sFullUpdate.mData, mData, data_size, block_num);
 				}
 
-				S32 text_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Text);
+				//S32 text_size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_Text); // <FS/> Compiled message accessors
+				S32 text_size = mesgsys->getSizeFast(sFullUpdate.mText, block_num);
 				if (text_size > 1)
 				{
 					// Setup object text
@@ -1565,10 +1655,14 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 					}
 
 					std::string temp_string;
-					mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_Text, temp_string, block_num );
+					// <FS> Compiled message accessors
+					//mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_Text, temp_string, block_num );
+					mesgsys->getStringFast(sFullUpdate.mText, temp_string, block_num);
+					// </FS>
 					
 					LLColor4U coloru;
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_TextColor, coloru.mV, 4, block_num);
+					//mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_TextColor, coloru.mV, 4, block_num); // <FS/> Compiled message accessors
+					mesgsys->getBinaryDataFast(sFullUpdate.mTextColor, coloru.mV, 4, block_num);
 
 					// alpha was flipped so that it zero encoded better
 					coloru.mV[3] = 255 - coloru.mV[3];
@@ -1597,7 +1691,8 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				std::string media_url;
-				mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_MediaURL, media_url, block_num);
+				//mesgsys->getStringFast(_PREHASH_ObjectData, _PREHASH_MediaURL, media_url, block_num); // <FS/> Compiled message accessors
+				mesgsys->getStringFast(sFullUpdate.mMediaURL, media_url, block_num);
                 retval |= checkMediaURL(media_url);
                 
 				//
@@ -1613,11 +1708,13 @@ U32 LLViewerObject::processUpdateMessage(LLMessageSystem *mesgsys,
 				}
 
 				// Unpack extra parameters
-				S32 size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ExtraParams);
+				//S32 size = mesgsys->getSizeFast(_PREHASH_ObjectData, block_num, _PREHASH_ExtraParams); // <FS/> Compiled message accessors
+				S32 size = mesgsys->getSizeFast(sFullUpdate.mExtraParams, block_num);
 				if (size > 0)
 				{
 					U8 *buffer = new U8[size];
-					mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ExtraParams, buffer, size, block_num);
+					//mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_ExtraParams, buffer, size, block_num); // <FS/> Compiled message accessors
+					mesgsys->getBinaryDataFast(sFullUpdate.mExtraParams, buffer, size, block_num);
 					LLDataPackerBinaryBuffer dp(buffer, size);
 
 					U8 num_parameters;
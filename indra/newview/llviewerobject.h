@@ -144,6 +144,7 @@ public:
 
 	static void initVOClasses();
 	static void cleanupVOClasses();
+	static void initMessageSlots(LLMessageSystem* msg); // <FS/> Compiled message accessors
 
 	void			addNVPair(const std::string& data);
 	BOOL			removeNVPair(const std::string& name);
@@ -616,6 +617,10 @@ public:
 	static void unpackU32(LLDataPackerBinaryBuffer* dp, U32& value, std::string name);
 	static void unpackU8(LLDataPackerBinaryBuffer* dp, U8& value, std::string name);
 	static U32 unpackParentID(LLDataPackerBinaryBuffer* dp, U32& parent_id);
+	// <FS> Staged object updates
+	// Byte offset of a field in the packed object data, -1 if unknown
+	static S32 getObjectDataOffset(const std::string& name);
+	// </FS>
 
 public:
 	//counter-translation
@@ -29,6 +29,7 @@
 #include "llviewerobjectlist.h"
 
 #include "message.h"
+#include "llmessagetemplate.h" // <FS/> Compiled message accessors
 #include "llfasttimer.h"
 #include "llrender.h"
 #include "llwindow.h"		// decBusyCount()
@@ -91,6 +92,7 @@
 #include "llfloaterreg.h"
 
 #include "fsareasearch.h" // <FS:Cron> Added to provide the ability to update the impact costs in area search. </FS:Cron>
+#include "fsavataranimationbatch.h" // <FS/> Parallel avatar animation
 #include "llavataractions.h"
 
 extern F32 gMinObjectDistance;
@@ -105,6 +107,34 @@ LLViewerObjectList gObjectList;
 
 extern LLPipeline	gPipeline;
 
+// <FS> Compiled message accessors
+namespace
+{
+	// The ObjectData variables processObjectUpdate() reads for every object
+	struct ObjectListSlots
+	{
+		LLMessageSlot mFullID;			// ObjectUpdate
+		LLMessageSlot mLocalID;			// ObjectUpdate
+		LLMessageSlot mPCode;			// ObjectUpdate
+		LLMessageSlot mCompressedData;	// ObjectUpdateCompressed
+		LLMessageSlot mCompressedFlags;	// ObjectUpdateCompressed
+		LLMessageSlot mTerseData;		// ImprovedTerseObjectUpdate
+	};
+	ObjectListSlots sListSlots;
+}
+
+// static
+void LLViewerObjectList::initMessageSlots(LLMessageSystem* msg)
+{
+	sListSlots.mFullID = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_FullID);
+	sListSlots.mLocalID = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_ID);
+	sListSlots.mPCode = msg->getMessageSlotFast(_PREHASH_ObjectUpdate, _PREHASH_ObjectData, _PREHASH_PCode);
+	sListSlots.mCompressedData = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCompressed, _PREHASH_ObjectData, _PREHASH_Data);
+	sListSlots.mCompressedFlags = msg->getMessageSlotFast(_PREHASH_ObjectUpdateCompressed, _PREHASH_ObjectData, _PREHASH_UpdateFlags);
+	sListSlots.mTerseData = msg->getMessageSlotFast(_PREHASH_ImprovedTerseObjectUpdate, _PREHASH_ObjectData, _PREHASH_Data);
+}
+// </FS>
+
 // Statics for object lookup tables.
 U32						LLViewerObjectList::sSimulatorMachineIndex = 1; // Not zero deliberately, to speed up index check.
 std::map<U64, U32>		LLViewerObjectList::sIPAndPortToIndex;
@@ -531,15 +561,21 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 			S32							uncompressed_length = 2048;
 			compressed_dp.reset();
 
-			uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+			// <FS> Compiled message accessors
+			//uncompressed_length = mesgsys->getSizeFast(_PREHASH_ObjectData, i, _PREHASH_Data);
+			const LLMessageSlot& data_slot = (update_type == OUT_TERSE_IMPROVED) ? sListSlots.mTerseData : sListSlots.mCompressedData;
+			uncompressed_length = mesgsys->getSizeFast(data_slot, i);
             LL_DEBUGS("ObjectUpdate") << "got binary data from message to compressed_dpbuffer" << LL_ENDL;
-			mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
+			//mesgsys->getBinaryDataFast(_PREHASH_ObjectData, _PREHASH_Data, compressed_dpbuffer, 0, i, 2048);
+			mesgsys->getBinaryDataFast(data_slot, compressed_dpbuffer, 0, i, 2048);
+			// </FS>
 			compressed_dp.assignBuffer(compressed_dpbuffer, uncompressed_length);
 
 			if (update_type != OUT_TERSE_IMPROVED) // OUT_FULL_COMPRESSED only?
 			{
 				U32 flags = 0;
-				mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i);
+				//mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_UpdateFlags, flags, i); // <FS/> Compiled message accessors
+				mesgsys->getU32Fast(sListSlots.mCompressedFlags, flags, i);
 
 				compressed_dp.unpackUUID(fullid, "ID");
 				compressed_dp.unpackU32(local_id, "LocalID");
@@ -600,8 +636,12 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 		else // OUT_FULL only?
 		{
 			update_cache = true;
-			mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
-			mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			// <FS> Compiled message accessors
+			//mesgsys->getUUIDFast(_PREHASH_ObjectData, _PREHASH_FullID, fullid, i);
+			//mesgsys->getU32Fast(_PREHASH_ObjectData, _PREHASH_ID, local_id, i);
+			mesgsys->getUUIDFast(sListSlots.mFullID, fullid, i);
+			mesgsys->getU32Fast(sListSlots.mLocalID, local_id, i);
+			// </FS>
 			msg_size += sizeof(LLUUID);
 			msg_size += sizeof(U32);
 			LL_DEBUGS("ObjectUpdate") << "Full Update, obj " << local_id << ", global ID " << fullid << " from " << mesgsys->getSender() << LL_ENDL;
@@ -677,7 +717,8 @@ void LLViewerObjectList::processObjectUpdate(LLMessageSystem *mesgsys,
 					continue;
 				}
 
-				mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i);
+				//mesgsys->getU8Fast(_PREHASH_ObjectData, _PREHASH_PCode, pcode, i); // <FS/> Compiled message accessors
+				mesgsys->getU8Fast(sListSlots.mPCode, pcode, i);
 				msg_size += sizeof(U8);
 
 			}
@@ -1035,6 +1076,14 @@ void LLViewerObjectList::update(LLAgent &agent)
 				if (objectp->isAvatar())
 					mNumAvatars++;
 //</FS:Beq>
+				// <FS> Parallel avatar animation
+				// Nothing carries over from the last frame, whether or not
+				// the batch runs in this one
+				if (objectp->isAvatar())
+				{
+					((LLVOAvatar*)objectp)->resetAnimationBatch();
+				}
+				// </FS>
 			}
 			else
 			{	// There shouldn't be any NULL pointers in the list, but they have caused
@@ -1064,6 +1113,28 @@ void LLViewerObjectList::update(LLAgent &agent)
 	}
 	else
 	{
+		// <FS> Parallel avatar animation
+		// Avatars evaluate their motions first; their pose blends and skeleton
+		// updates then run together, and idleUpdate() below resumes after them.
+		if (FSAvatarAnimationBatch::isEnabled(mNumAvatars))
+		{
+			static FSAvatarAnimationBatch animation_batch;
+			for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
+				idle_iter != idle_end; idle_iter++)
+			{
+				objectp = *idle_iter;
+				if (objectp->isAvatar())
+				{
+					animation_batch.addAvatar((LLVOAvatar*)objectp, agent, frame_time);
+				}
+			}
+
+			LLTimer batch_timer;
+			record(LLStatViewer::AVATAR_SKELETON_THREADED, (F64)animation_batch.run());
+			record(LLStatViewer::AVATAR_SKELETON_BATCH_TIME, F64Seconds(batch_timer.getElapsedTimeF64()));
+		}
+		// </FS>
+
 		for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
 			idle_iter != idle_end; idle_iter++)
 		{
@@ -203,6 +203,12 @@ public:
 								const U32 port); // Requires knowledge of message system info!
 
 	static BOOL removeFromLocalIDTable(const LLViewerObject* objectp);
+
+	// <FS> Compiled message accessors
+	// Resolves the variables processObjectUpdate() reads, call once the message templates are loaded.
+	static void initMessageSlots(LLMessageSystem* msg);
+	// </FS>
+
 	// Used ONLY by the orphaned object code.
 	static U64 getIndex(const U32 local_id, const U32 ip, const U32 port);
 
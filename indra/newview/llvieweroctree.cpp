@@ -39,6 +39,7 @@
 //-----------------------------------------------------------------------------------
 U32 LLViewerOctreeEntryData::sCurVisible = 10; //reserve the low numbers for special use.
 BOOL LLViewerOctreeDebug::sInDebug = FALSE;
+U32 LLViewerOctreeCull::sPrecullPass = 0; // <FS/> Parallel cull
 
 static LLTrace::CountStatHandle<S32> sOcclusionQueries("occlusion_queries", "Number of occlusion queries executed"),
 									 sNumObjectsOccluded("occluded_objects", "Count of objects being occluded by a query"),
@@ -460,7 +461,13 @@ LLViewerOctreeGroup::~LLViewerOctreeGroup()
 LLViewerOctreeGroup::LLViewerOctreeGroup(OctreeNode* node)
 :	mOctreeNode(node),
 	mAnyVisible(0),
-	mState(CLEAN)
+	mState(CLEAN),
+	// <FS> Parallel cull
+	mPrecullPass(0),
+	mPrecullRes(-1),
+	mPrecullObjectsRes(-1),
+	// </FS>
+	mChildBoundsCount(0) // <FS/> SoA frustum culling
 {
 	LLVector4a tmp;
 	tmp.splat(0.f);
@@ -563,12 +570,14 @@ void LLViewerOctreeGroup::rebound()
 		mExtents[1] = group->mExtents[1];
 		
 		group->setState(SKIP_FRUSTUM_CHECK);
+		mChildBoundsCount = 0; // <FS/> SoA frustum culling
 	}
 	else if (mOctreeNode->getChildCount() == 0)
 	{ //copy object bounding box if this is a leaf
 		boundObjects(TRUE, mExtents[0], mExtents[1]);
 		mBounds[0] = mObjectBounds[0];
 		mBounds[1] = mObjectBounds[1];
+		mChildBoundsCount = 0; // <FS/> SoA frustum culling
 	}
 	else
 	{
@@ -600,6 +609,8 @@ void LLViewerOctreeGroup::rebound()
 		mBounds[0].mul(0.5f);
 		mBounds[1].setSub(newMax, newMin);
 		mBounds[1].mul(0.5f);
+
+		updateChildBounds(); // <FS/> SoA frustum culling
 	}
 	
 	clearState(DIRTY);
@@ -607,6 +618,58 @@ void LLViewerOctreeGroup::rebound()
 	return;
 }
 
+// <FS> SoA frustum culling
+void LLViewerOctreeGroup::updateChildBounds()
+{
+	const U32 count = mOctreeNode->getChildCount();
+	if (count > MAX_CHILD_BOUNDS)
+	{
+		mChildBoundsCount = 0;
+		return;
+	}
+
+	for (U32 batch = 0; batch < MAX_CHILD_BOUNDS / CHILD_BOUNDS_BATCH; batch++)
+	{
+		for (U32 i = 0; i < 2; i++)
+		{
+			for (U32 j = 0; j < 3; j++)
+			{
+				mChildBounds[batch][i][j].clear();
+			}
+		}
+	}
+
+	for (U32 c = 0; c < count; c++)
+	{
+		const LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) mOctreeNode->getChild(c)->getListener(0);
+		const U32 batch = c / CHILD_BOUNDS_BATCH;
+		const U32 lane = c % CHILD_BOUNDS_BATCH;
+		for (U32 i = 0; i < 2; i++)
+		{
+			for (U32 j = 0; j < 3; j++)
+			{
+				mChildBounds[batch][i][j].getF32ptr()[lane] = group->mBounds[i][j];
+			}
+		}
+	}
+
+	mChildBoundsCount = count;
+}
+
+void LLViewerOctreeGroup::shiftChildBounds(const LLVector4a& offset)
+{
+	LLVector4a lanes;
+	for (U32 batch = 0; batch < MAX_CHILD_BOUNDS / CHILD_BOUNDS_BATCH; batch++)
+	{
+		for (U32 j = 0; j < 3; j++)
+		{
+			lanes.splat(offset[j]);
+			mChildBounds[batch][0][j].add(lanes);
+		}
+	}
+}
+// </FS>
+
 //virtual 
 void LLViewerOctreeGroup::handleInsertion(const TreeNode* node, LLViewerOctreeEntry* obj)
 {
@@ -1374,7 +1437,10 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 	else
 	{
 		LL_PROFILE_ZONE_NAMED_CATEGORY_OCTREE("Check inside?");
-		mRes = frustumCheck(group);
+		// <FS> Parallel cull
+		//mRes = frustumCheck(group);
+		mRes = groupFrustumCheck(group);
+		// </FS>
 				
 		if (mRes)
 		{ //at least partially in, run on down
@@ -1385,6 +1451,132 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 		mRes = 0;
 	}
 }
+
+// <FS> Parallel cull
+// Mirrors traverse() and checkObjects(). A group with SKIP_FRUSTUM_CHECK is
+// the only child of its parent, so the result traverse() has in effect for
+// it is always the one of its parent, whichever siblings came before.
+S32 LLViewerOctreeCull::precull(const OctreeNode* n, S32 res, U32 pass, bool recurse)
+{
+	return precullNode(n, res, -1, pass, recurse);
+}
+
+S32 LLViewerOctreeCull::precullNode(const OctreeNode* n, S32 res, S32 group_res, U32 pass, bool recurse)
+{
+	LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getListener(0);
+
+	if (res != 2 && 
+		!(res && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
+	{
+		// <FS> SoA frustum culling
+		//res = group_res = frustumCheck(group);
+		res = group_res = group_res >= 0 ? group_res : frustumCheck(group);
+		// </FS>
+	}
+	else
+	{
+		group_res = -1;
+	}
+
+	S32 objects_res = -1;
+	if (res == 1 && n->getElementCount() > 0 && n->getChildCount() > 0)
+	{
+		objects_res = frustumCheckObjects(group);
+	}
+
+	group->mPrecullRes = (S8)group_res;
+	group->mPrecullObjectsRes = (S8)objects_res;
+	group->mPrecullPass = pass;
+
+	if (recurse && res == 1)
+	{
+		// <FS> SoA frustum culling
+		//for (U32 i = 0; i < n->getChildCount(); i++)
+		//{
+		//	precull(n->getChild(i), res, pass, true);
+		//}
+		S32 child_res[LLViewerOctreeGroup::MAX_CHILD_BOUNDS];
+		const bool checked = frustumCheckChildren(group, child_res);
+		for (U32 i = 0; i < n->getChildCount(); i++)
+		{
+			precullNode(n->getChild(i), res, checked ? child_res[i] : -1, pass, true);
+		}
+		// </FS>
+	}
+
+	return res;
+}
+
+S32 LLViewerOctreeCull::groupFrustumCheck(const LLViewerOctreeGroup* group)
+{
+	if (sPrecullPass && group->mPrecullPass == sPrecullPass && group->mPrecullRes >= 0)
+	{
+		return group->mPrecullRes;
+	}
+	return frustumCheck(group);
+}
+
+S32 LLViewerOctreeCull::objectsFrustumCheck(const LLViewerOctreeGroup* group)
+{
+	if (sPrecullPass && group->mPrecullPass == sPrecullPass && group->mPrecullObjectsRes >= 0)
+	{
+		return group->mPrecullObjectsRes;
+	}
+	return frustumCheckObjects(group);
+}
+// </FS>
+
+// <FS> SoA frustum culling
+//virtual
+bool LLViewerOctreeCull::frustumCheckChildren(const LLViewerOctreeGroup* group, S32* res)
+{
+	return false;
+}
+
+bool LLViewerOctreeCull::AABBInFrustumNoFarClipChildBounds(const LLViewerOctreeGroup* group, S32* res)
+{
+	const U32 count = group->mChildBoundsCount;
+	if (count == 0 || group->isDirty() || count != group->mOctreeNode->getChildCount())
+	{
+		return false;
+	}
+
+	for (U32 c = 0; c < count; c += LLViewerOctreeGroup::CHILD_BOUNDS_BATCH)
+	{
+		const U32 batch = c / LLViewerOctreeGroup::CHILD_BOUNDS_BATCH;
+		mCamera->AABBInFrustumNoFarClip4(group->mChildBounds[batch][0], group->mChildBounds[batch][1], res + c);
+	}
+	return true;
+}
+
+bool LLViewerOctreeCull::AABBInFrustumChildBounds(const LLViewerOctreeGroup* group, S32* res)
+{
+	const U32 count = group->mChildBoundsCount;
+	if (count == 0 || group->isDirty() || count != group->mOctreeNode->getChildCount())
+	{
+		return false;
+	}
+
+	for (U32 c = 0; c < count; c += LLViewerOctreeGroup::CHILD_BOUNDS_BATCH)
+	{
+		const U32 batch = c / LLViewerOctreeGroup::CHILD_BOUNDS_BATCH;
+		mCamera->AABBInFrustum4(group->mChildBounds[batch][0], group->mChildBounds[batch][1], res + c);
+	}
+	return true;
+}
+
+void LLViewerOctreeCull::AABBSphereIntersectChildExtents(const LLViewerOctreeGroup* group, S32* res)
+{
+	for (U32 c = 0; c < group->mOctreeNode->getChildCount(); c++)
+	{
+		if (res[c] != 0)
+		{
+			const LLViewerOctreeGroup* child = (LLViewerOctreeGroup*) group->mOctreeNode->getChild(c)->getListener(0);
+			res[c] = llmin(res[c], AABBSphereIntersectGroupExtents(child));
+		}
+	}
+}
+// </FS>
 	
 //------------------------------------------
 //agent space group culling
@@ -1492,7 +1684,10 @@ bool LLViewerOctreeCull::checkObjects(const OctreeNode* branch, const LLViewerOc
 	{
 		return true;
 	}
-	else if (mRes == 1 && !frustumCheckObjects(group)) //no objects in frustum
+	// <FS> Parallel cull
+	//else if (mRes == 1 && !frustumCheckObjects(group)) //no objects in frustum
+	else if (mRes == 1 && !objectsFrustumCheck(group)) //no objects in frustum
+	// </FS>
 	{
 		return false;
 	}
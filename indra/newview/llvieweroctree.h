@@ -197,6 +197,14 @@ public:
 		INVALID_STATE      = 0x00000010,
 	};
 
+	// <FS> SoA frustum culling
+	enum
+	{
+		CHILD_BOUNDS_BATCH = 4,  // children per LLCamera::AABBInFrustum4() call
+		MAX_CHILD_BOUNDS   = 8,
+	};
+	// </FS>
+
 public:
 	typedef OctreeNode::element_iter element_iter;
 	typedef OctreeNode::element_list element_list;
@@ -252,6 +260,10 @@ public:
 	
 protected:
 	void checkStates();
+	// <FS> SoA frustum culling
+	void updateChildBounds();
+	void shiftChildBounds(const LLVector4a& offset);
+	// </FS>
 private:
 	virtual bool boundObjects(BOOL empty, LLVector4a& minOut, LLVector4a& maxOut);			
 
@@ -264,9 +276,23 @@ protected:
 	LL_ALIGN_16(LLVector4a mExtents[2]);       // extents (min, max) of this node and all its children
 	LL_ALIGN_16(LLVector4a mObjectExtents[2]); // extents (min, max) of objects in this node	
 
+	// <FS> SoA frustum culling
+	// mBounds of the children, kept by rebound() for groups with more than one
+	// child: [batch][center, size][x, y, z], one child per vector lane.
+	LL_ALIGN_16(LLVector4a mChildBounds[MAX_CHILD_BOUNDS / CHILD_BOUNDS_BATCH][2][3]);
+	U32         mChildBoundsCount; // children in mChildBounds, 0 if not kept
+	// </FS>
+
 	S32         mAnyVisible; //latest visible to any camera
 	S32         mVisible[LLViewerCamera::NUM_CAMERAS];	
 
+	// <FS> Parallel cull
+	// Frustum check results LLViewerOctreeCull::precull() kept for one cull pass
+	U32         mPrecullPass;
+	S8          mPrecullRes;        // frustumCheck(), -1 if not run
+	S8          mPrecullObjectsRes; // frustumCheckObjects(), -1 if not run
+	// </FS>
+
 };//LL_ALIGN_POSTFIX(16);
 
 //octree group which has capability to support occlusion culling
@@ -373,6 +399,19 @@ public:
 	
 	virtual void traverse(const OctreeNode* n);
 
+	// <FS> Parallel cull
+	// Runs the frustum checks traverse() runs on n, res being the result in
+	// effect above n, and keeps them in the group for cull pass pass; with
+	// recurse set, for the whole subtree. Returns the result in effect for
+	// the children of n, they need checks only if it is 1.
+	// Only reads the tree and the camera, so separate subtrees can be
+	// preculled in parallel as long as nothing modifies them.
+	S32 precull(const OctreeNode* n, S32 res, U32 pass, bool recurse);
+
+	// Cull pass whose precull() results traverse() uses, 0 for none
+	static U32 sPrecullPass;
+	// </FS>
+
 protected:
 	virtual bool earlyFail(LLViewerOctreeGroup* group);	
 	
@@ -399,6 +438,25 @@ protected:
 	virtual S32 frustumCheck(const LLViewerOctreeGroup* group) = 0;
 	virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group) = 0;
 
+	// <FS> Parallel cull
+	// frustumCheck() and frustumCheckObjects(), or their precull() results
+	S32 groupFrustumCheck(const LLViewerOctreeGroup* group);
+	S32 objectsFrustumCheck(const LLViewerOctreeGroup* group);
+	// precull() with the result of the frustum check of n already known,
+	// or -1 if not
+	S32 precullNode(const OctreeNode* n, S32 res, S32 group_res, U32 pass, bool recurse);
+	// </FS>
+
+	// <FS> SoA frustum culling
+	// frustumCheck() of all children of group at once into res. Returns
+	// false if that takes checking the children one by one.
+	virtual bool frustumCheckChildren(const LLViewerOctreeGroup* group, S32* res);
+	// agent space child set cull, from the child bounds kept by the group
+	bool AABBInFrustumNoFarClipChildBounds(const LLViewerOctreeGroup* group, S32* res);
+	bool AABBInFrustumChildBounds(const LLViewerOctreeGroup* group, S32* res);
+	void AABBSphereIntersectChildExtents(const LLViewerOctreeGroup* group, S32* res);
+	// </FS>
+
 	bool checkProjectionArea(const LLVector4a& center, const LLVector4a& size, const LLVector3& shift, F32 pixel_threshold, F32 near_radius);
 	virtual bool checkObjects(const OctreeNode* branch, const LLViewerOctreeGroup* group);
 	virtual void preprocess(LLViewerOctreeGroup* group);
@@ -86,6 +86,7 @@
 #include <boost/regex.hpp>
 
 // Firestorm includes
+#include "fsobjectupdatedecoder.h"
 #include "lfsimfeaturehandler.h"
 #include "llviewermenu.h"
 #include "llviewernetwork.h"
@@ -645,6 +646,7 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
 	mViewerAssetUrl(""),
 	mCacheLoaded(FALSE),
 	mCacheDirty(FALSE),
+	mCacheLoadPending(false), // <FS/> Async object cache
 	mReleaseNotesRequested(FALSE),
 	mCapabilitiesState(CAPABILITIES_STATE_INIT),
 	mSimulatorFeaturesReceived(false),
@@ -833,6 +835,23 @@ void LLViewerRegion::loadObjectCache()
 
 	if(LLVOCache::instanceExists())
 	{
+		// <FS> Async object cache
+		const U64 handle = mHandle;
+		if (LLVOCache::getInstance()->readFromCacheAsync(mHandle, mImpl->mCacheID,
+				[handle](const LLUUID& cache_id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+				{
+					LLViewerRegion* regionp = LLWorld::instanceExists() ? LLWorld::getInstance()->getRegionFromHandle(handle) : NULL;
+					if (regionp)
+					{
+						regionp->objectCacheLoaded(cache_id, cache_entry_map);
+					}
+				}))
+		{
+			mCacheLoadPending = true;
+			return;
+		}
+		// </FS>
+
 		LLVOCache::getInstance()->readFromCache(mHandle, mImpl->mCacheID, mImpl->mCacheMap) ;
 		if (mImpl->mCacheMap.empty())
 		{
@@ -841,6 +860,26 @@ void LLViewerRegion::loadObjectCache()
 	}
 }
 
+// <FS> Async object cache
+void LLViewerRegion::objectCacheLoaded(const LLUUID& cache_id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+{
+	if (!mCacheLoadPending || cache_id != mImpl->mCacheID)
+	{
+		// Stale read for an earlier region at this handle
+		return;
+	}
+	mCacheLoadPending = false;
+
+	mImpl->mCacheMap.insert(cache_entry_map.begin(), cache_entry_map.end());
+	if (mImpl->mCacheMap.empty())
+	{
+		mCacheDirty = TRUE;
+	}
+
+	sendRegionHandshakeReply();
+}
+// </FS>
+
 
 void LLViewerRegion::saveObjectCache()
 {
@@ -2573,7 +2612,10 @@ void LLViewerRegion::findOrphans(U32 parent_id)
 	}
 }
 
-void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
+// <FS> Staged object updates
+//void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
+void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry, const FSObjectExtents* extents)
+// </FS>
 {
 	if(!sVOCacheCullingEnabled)
 	{
@@ -2630,7 +2672,21 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 	LLQuaternion rot;
 
 	//decode spatial info and parent info
-	U32 parent_id = LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot);
+	// <FS> Staged object updates
+	//U32 parent_id = LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot);
+	U32 parent_id;
+	if (extents)
+	{
+		parent_id = extents->mParentID;
+		pos = extents->mPos;
+		scale = extents->mScale;
+		rot = extents->mRot;
+	}
+	else
+	{
+		parent_id = LLViewerObject::extractSpatialExtents(entry->getDP(), pos, scale, rot);
+	}
+	// </FS>
 	
 	U32 old_parent_id = entry->getParentID();
 	bool same_old_parent = false;
@@ -2741,13 +2797,22 @@ void LLViewerRegion::decodeBoundingInfo(LLVOCacheEntry* entry)
 
 LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags)
 {
-	eCacheUpdateResult result;
+	//eCacheUpdateResult result; // <FS/> Staged object updates
 	U32 crc;
 	U32 local_id;
 
 	LLViewerObject::unpackU32(&dp, local_id, "LocalID");
 	LLViewerObject::unpackU32(&dp, crc, "CRC");
 
+	// <FS> Staged object updates
+	return cacheFullUpdate(dp, flags, local_id, crc, NULL);
+}
+
+LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, U32 local_id, U32 crc, const FSObjectExtents* extents)
+{
+	eCacheUpdateResult result;
+	// </FS>
+
 	LLVOCacheEntry* entry = getCacheEntry(local_id, false);
 
 	if (entry)
@@ -2772,7 +2837,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 			// Update the cache entry
 			entry->updateEntry(crc, dp);
 
-			decodeBoundingInfo(entry);
+			decodeBoundingInfo(entry, extents); // <FS/> Staged object updates
 
 			result = CACHE_UPDATE_CHANGED;
 		}		
@@ -2790,7 +2855,7 @@ LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerB
 		
 		mImpl->mCacheMap[local_id] = entry;
 		
-		decodeBoundingInfo(entry);
+		decodeBoundingInfo(entry, extents); // <FS/> Staged object updates
 	}
 	entry->setUpdateFlags(flags);
 
@@ -3189,10 +3254,27 @@ void LLViewerRegion::unpackRegionHandshake()
 	// off disk.
 	loadObjectCache();
 
+	// <FS> Async object cache: when the cache is read in the background the
+	// reply is sent by objectCacheLoaded(), the sim must not start sending
+	// objects before the cache entries are there to probe.
+	if (!mCacheLoadPending)
+	{
+		sendRegionHandshakeReply();
+	}
+}
+
+void LLViewerRegion::sendRegionHandshakeReply()
+{
+	LLMessageSystem* msg = gMessageSystem;
+	// </FS>
+
 	// After loading cache, signal that simulator can start
 	// sending data.
 	// TODO: Send all upstream viewer->sim handshake info here.
-	LLHost host = msg->getSender();
+	// <FS> Async object cache
+	//LLHost host = msg->getSender();
+	const LLHost& host = getHost();
+	// </FS>
 	msg->newMessage("RegionHandshakeReply");
 	msg->nextBlock("AgentData");
 	msg->addUUID("AgentID", gAgent.getID());
@@ -73,6 +73,7 @@ class LLViewerTexture;
 class LLViewerRegionImpl;
 class LLViewerOctreeGroup;
 class LLVOCachePartition;
+struct FSObjectExtents; // <FS/> Staged object updates
 
 class LLViewerRegion: public LLCapabilityProvider // implements this interface
 {
@@ -376,6 +377,10 @@ public:
 	// handle a full update message
 	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags);
 	eCacheUpdateResult cacheFullUpdate(LLViewerObject* objectp, LLDataPackerBinaryBuffer &dp, U32 flags);	
+	// <FS> Staged object updates
+	// Same as above, with the local id, CRC and extents already decoded by FSObjectUpdateDecoder
+	eCacheUpdateResult cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, U32 local_id, U32 crc, const FSObjectExtents* extents);
+	// </FS>
 	LLVOCacheEntry* getCacheEntryForOctree(U32 local_id);
 	LLVOCacheEntry* getCacheEntry(U32 local_id, bool valid = true);
 	bool probeCache(U32 local_id, U32 crc, U32 flags, U8 &cache_miss_type);
@@ -390,6 +395,10 @@ public:
 	void dumpCache();
 
 	void unpackRegionHandshake();
+	// <FS> Async object cache
+	void sendRegionHandshakeReply();
+	void objectCacheLoaded(const LLUUID& cache_id, std::map<U32, LLPointer<LLVOCacheEntry> >& cache_entry_map);
+	// </FS>
 
 	void calculateCenterGlobal();
 	void calculateCameraDistance();
@@ -441,7 +450,10 @@ private:
 	void updateVisibleEntries(F32 max_time); //update visible entries
 
 	void addCacheMiss(U32 id, LLViewerRegion::eCacheMissType miss_type);
-	void decodeBoundingInfo(LLVOCacheEntry* entry);
+	// <FS> Staged object updates
+	//void decodeBoundingInfo(LLVOCacheEntry* entry);
+	void decodeBoundingInfo(LLVOCacheEntry* entry, const FSObjectExtents* extents = NULL);
+	// </FS>
 	bool isNonCacheableObjectCreated(U32 local_id);	
 
 public:
@@ -564,6 +576,7 @@ private:
 	// a structure of size 2^14 = 16,000
 	BOOL									mCacheLoaded;
 	BOOL                                    mCacheDirty;
+	bool                                    mCacheLoadPending; // <FS/> Async object cache: waiting for the I/O pool, handshake reply not sent yet
 	BOOL	mAlive;					// can become false if circuit disconnects
 	BOOL	mSimulatorFeaturesReceived;
 	BOOL    mReleaseNotesRequested;
@@ -195,6 +195,21 @@ LLTrace::SampleStatHandle<F64Milliseconds >	FRAMETIME_JITTER("frametimejitter",
 LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SNAP("agentpositionsnap", "agent position corrections");
 
 LLTrace::EventStatHandle<>	LOADING_WEARABLES_LONG_DELAY("loadingwearableslongdelay", "Wearables took too long to load");
+
+// <FS> Batched UDP receive
+LLTrace::EventStatHandle<>	PACKETS_PER_RECEIVE_BATCH("packetsperreceivebatch", "Packets read per batched UDP receive");
+LLTrace::EventStatHandle<F64Milliseconds >	RECEIVE_BATCH_TIME("receivebatchtime", "Time spent in one batched UDP receive");
+// </FS>
+
+// <FS> Parallel geometry rebuild
+LLTrace::EventStatHandle<F64Milliseconds >	GROUP_REBUILD_TIME("grouprebuildtime", "Time spent rebuilding the geometry of one spatial group");
+LLTrace::EventStatHandle<>	GROUP_REBUILD_THREADED_FACES("grouprebuildthreadedfaces", "Faces of one spatial group rebuild filled off the main thread");
+// </FS>
+
+// <FS> Parallel avatar animation
+LLTrace::EventStatHandle<F64Milliseconds >	AVATAR_SKELETON_BATCH_TIME("avatarskeletonbatchtime", "Time spent blending the poses and updating the skeletons of the batched avatars");
+LLTrace::EventStatHandle<>	AVATAR_SKELETON_THREADED("avatarskeletonthreaded", "Avatar skeletons updated off the main thread in one frame");
+// </FS>
 	
 LLTrace::EventStatHandle<F64Milliseconds >	REGION_CROSSING_TIME("regioncrossingtime", "CROSSING_AVG"),
 																FRAME_STACKTIME("framestacktime", "FRAME_SECS"),
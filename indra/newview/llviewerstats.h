@@ -229,6 +229,21 @@ extern LLTrace::EventStatHandle<LLUnit<F64, LLUnits::Meters> > AGENT_POSITION_SN
 
 extern LLTrace::EventStatHandle<>	LOADING_WEARABLES_LONG_DELAY;
 
+// <FS> Batched UDP receive
+extern LLTrace::EventStatHandle<>	PACKETS_PER_RECEIVE_BATCH;
+extern LLTrace::EventStatHandle<F64Milliseconds >	RECEIVE_BATCH_TIME;
+// </FS>
+
+// <FS> Parallel geometry rebuild
+extern LLTrace::EventStatHandle<F64Milliseconds >	GROUP_REBUILD_TIME;
+extern LLTrace::EventStatHandle<>	GROUP_REBUILD_THREADED_FACES;
+// </FS>
+
+// <FS> Parallel avatar animation
+extern LLTrace::EventStatHandle<F64Milliseconds >	AVATAR_SKELETON_BATCH_TIME;
+extern LLTrace::EventStatHandle<>	AVATAR_SKELETON_THREADED;
+// </FS>
+
 extern LLTrace::EventStatHandle<F64Milliseconds >	REGION_CROSSING_TIME,
 														FRAME_STACKTIME,
 														UPDATE_STACKTIME,
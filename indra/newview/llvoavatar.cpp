@@ -695,6 +695,12 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mVisibilityRank(0),
 	mNeedsSkin(FALSE),
 	mLastSkinTime(0.f),
+	// <FS> Parallel avatar animation
+	mAnimationBatchState(ANIM_BATCH_NONE),
+	mAnimationBatchDetailed(false),
+	mDeferSkeletonUpdate(false),
+	mSkeletonUpdatePending(false),
+	// </FS>
 	mUpdatePeriod(1),
 	mOverallAppearance(AOA_INVISIBLE),
 	mVisualComplexityStale(true),
@@ -2697,10 +2703,38 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
 
+	// <FS> Parallel avatar animation
+	if (mAnimationBatchState != ANIM_BATCH_NONE)
+	{
+		// idleUpdateBatched() already ran the first half
+		const bool resume = (mAnimationBatchState == ANIM_BATCH_RESUME);
+		mAnimationBatchState = ANIM_BATCH_NONE;
+		if (resume && !isDead())
+		{
+			FSPerfStats::RecordAvatarTime T(getID(), FSPerfStats::StatType_t::RENDER_IDLE);
+			idleUpdateAfterCharacter(mAnimationBatchDetailed);
+		}
+		return;
+	}
+
+	if (!idleUpdateBeforeCharacter(agent, time))
+	{
+		return;
+	}
+
+	FSPerfStats::RecordAvatarTime T(getID(), FSPerfStats::StatType_t::RENDER_IDLE);
+	idleUpdateAfterCharacter(updateCharacter(agent));
+}
+
+// First half of idleUpdate(), false if idleUpdate() ends here
+bool LLVOAvatar::idleUpdateBeforeCharacter(LLAgent &agent, const F64 &time)
+{
+	// </FS>
 	if (isDead())
 	{
 		LL_INFOS() << "Warning!  Idle on dead avatar" << LL_ENDL;
-		return;
+		// <FS/> Parallel avatar animation
+		return false;
 	}
 	// <FS:Beq> record time and refresh "tooSlow" status
 	FSPerfStats::RecordAvatarTime T(getID(), FSPerfStats::StatType_t::RENDER_IDLE); // per avatar "idle" time.
@@ -2714,7 +2748,8 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
         {
             idleUpdateNameTag( mLastRootPos );
         }
-        return;
+        // <FS/> Parallel avatar animation
+        return false;
 	}
 
     // Update should be happening max once per frame.
@@ -2807,8 +2842,15 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
 	// animate the character
 	// store off last frame's root position to be consistent with camera position
 	mLastRootPos = mRoot->getWorldPosition();
-	BOOL detailed_update = updateCharacter(agent);
+	// <FS> Parallel avatar animation
+	//BOOL detailed_update = updateCharacter(agent);
+	return true;
+}
 
+// Second half of idleUpdate()
+void LLVOAvatar::idleUpdateAfterCharacter(bool detailed_update)
+{
+	// </FS>
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
 						 LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -2860,6 +2902,67 @@ void LLVOAvatar::idleUpdate(LLAgent &agent, const F64 &time)
     idleUpdateDebugInfo();
 }
 
+// <FS> Parallel avatar animation
+// virtual
+bool LLVOAvatar::canBatchAnimationUpdate() const
+{
+	return !isDead();
+}
+
+bool LLVOAvatar::idleUpdateBatched(LLAgent &agent, const F64 &time)
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	if (!idleUpdateBeforeCharacter(agent, time))
+	{
+		mAnimationBatchState = ANIM_BATCH_SKIPPED;
+		return false;
+	}
+
+	FSPerfStats::RecordAvatarTime T(getID(), FSPerfStats::StatType_t::RENDER_IDLE);
+	mDeferSkeletonUpdate = true;
+	mMotionController.setDeferPoseBlend(true);
+	mAnimationBatchDetailed = updateCharacter(agent);
+	mMotionController.setDeferPoseBlend(false);
+	mDeferSkeletonUpdate = false;
+
+	mAnimationBatchState = ANIM_BATCH_RESUME;
+	return mSkeletonUpdatePending;
+}
+
+void LLVOAvatar::updateSkeletonBatched()
+{
+	LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+	mMotionController.applyPendingPoseBlend();
+	mRoot->updateWorldMatrixChildren();
+}
+
+void LLVOAvatar::finishSkeletonBatched()
+{
+	mSkeletonUpdatePending = false;
+
+	// The rest of updateCharacter(). The eyes and feet already have the world
+	// positions these would otherwise have updated on demand.
+	updateHeadOffset();
+	updateFootstepSounds();
+
+	if (mAnimationBatchDetailed)
+	{
+		mNeedsSkin = TRUE;
+	}
+}
+
+void LLVOAvatar::resetAnimationBatch()
+{
+	// A state left from a frame that batched this avatar would make
+	// idleUpdate() skip its first half when the batch does not run.
+	mAnimationBatchState = ANIM_BATCH_NONE;
+	mDeferSkeletonUpdate = false;
+	mSkeletonUpdatePending = false;
+}
+// </FS>
+
 void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled)
 {
 	bool render_visualizer = voice_enabled;
@@ -5351,6 +5454,16 @@ bool LLVOAvatar::updateCharacter(LLAgent &agent)
 		}
 	}
 
+	// <FS> Parallel avatar animation
+	if (mDeferSkeletonUpdate)
+	{
+		// FSAvatarAnimationBatch blends the pose and updates the skeleton,
+		// finishSkeletonBatched() then does what is left below.
+		mSkeletonUpdatePending = true;
+		return visible;
+	}
+	// </FS>
+
 	// update head position
 	updateHeadOffset();
 
@@ -275,6 +275,16 @@ public:
 	virtual bool 	computeNeedsUpdate();
 	virtual bool 	updateCharacter(LLAgent &agent);
     void			updateFootstepSounds();
+	// <FS> Parallel avatar animation
+	// FSAvatarAnimationBatch splits idleUpdate() around updateCharacter(): the batched
+	// avatars evaluate their motions one after another, their pose blends and skeleton
+	// updates then run together on several threads, and idleUpdate() resumes after them.
+	virtual bool	canBatchAnimationUpdate() const;
+	bool			idleUpdateBatched(LLAgent &agent, const F64 &time); // true if updateSkeletonBatched() is due
+	void			updateSkeletonBatched(); // any thread, only touches this avatar's skeleton
+	void			finishSkeletonBatched();
+	void			resetAnimationBatch(); // start of every frame, before any of the above
+	// </FS>
     void			computeUpdatePeriod();
     void			updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
     void			updateTimeStep();
@@ -545,6 +555,22 @@ private:
 	BOOL 		mNeedsSkin; // avatar has been animated and verts have not been updated
 	F32			mLastSkinTime; //value of gFrameTimeSeconds at last skin update
 
+	// <FS> Parallel avatar animation
+	enum EAnimationBatchState
+	{
+		ANIM_BATCH_NONE,	// idleUpdate() runs as usual
+		ANIM_BATCH_SKIPPED,	// idleUpdateBatched() returned early, so does idleUpdate()
+		ANIM_BATCH_RESUME	// idleUpdate() resumes after updateCharacter()
+	};
+	bool		idleUpdateBeforeCharacter(LLAgent &agent, const F64 &time);
+	void		idleUpdateAfterCharacter(bool detailed_update);
+
+	EAnimationBatchState mAnimationBatchState;
+	bool		mAnimationBatchDetailed; // what updateCharacter() returned for the resumed idleUpdate()
+	bool		mDeferSkeletonUpdate; // updateCharacter() leaves the skeleton to the batch
+	bool		mSkeletonUpdatePending;
+	// </FS>
+
 	S32	 		mUpdatePeriod;
 	S32  		mNumInitFaces; //number of faces generated when creating the avatar drawable, does not inculde splitted faces due to long vertex buffer.
 
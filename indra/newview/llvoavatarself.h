@@ -136,6 +136,7 @@ public:
 	//--------------------------------------------------------------------
 public:
 	/*virtual*/ bool 	updateCharacter(LLAgent &agent);
+	/*virtual*/ bool	canBatchAnimationUpdate() const { return false; } // <FS> Parallel avatar animation: keep the agent's own avatar on the plain idleUpdate()
 	/*virtual*/ void 	idleUpdateTractorBeam();
 	bool				checkStuckAppearance();
 
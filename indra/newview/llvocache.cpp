@@ -35,6 +35,12 @@
 #include "pipeline.h"
 #include "llagentcamera.h"
 #include "llmemory.h"
+// <FS> Async object cache
+#include "llfile.h"
+#include "llmappedfile.h"
+#include "threadpool.h"
+#include "workqueue.h"
+// </FS>
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -99,7 +105,10 @@ LLVOCacheEntry::LLVOCacheEntry()
 	mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+// <FS> Async object cache
+//LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const U8*& data, const U8* end)
+// </FS>
 :	LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY), 
 	mBuffer(NULL),
 	mUpdateFlags(-1),
@@ -110,46 +119,78 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
 	mBSphereRadius(-1.0f)
 {
 	S32 size = -1;
-	BOOL success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
+	// <FS> Async object cache: parse from the file image in memory
+	//BOOL success;
+    //static U8 data_buffer[ENTRY_HEADER_SIZE];
+	//
+	//mDP.assignBuffer(mBuffer, 0);
+	//
+    //success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
+    //if (success)
+    //{
+        //memcpy(&mLocalID, data_buffer, sizeof(U32));
+        //memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
+        //memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
+        //memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
+        //memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
+        //memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
+	//
+		//// Corruption in the cache entries
+		//if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
+		//{
+			//// We've got a bogus size, skip reading it.
+			//// We won't bother seeking, because the rest of this file
+			//// is likely bogus, and will be tossed anyway.
+			//LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
+			//success = FALSE;
+		//}
+	//}
+	//if(success && size > 0)
+	//{
+		//mBuffer = new U8[size];
+		//success = check_read(apr_file, mBuffer, size);
+	//
+		//if(success)
+		//{
+			//mDP.assignBuffer(mBuffer, size);
+		//}
+		//else
+		//{
+			//delete[] mBuffer ;
+			//mBuffer = NULL ;
+		//}
+	//}
+	BOOL success = end - data >= ENTRY_HEADER_SIZE;
 
 	mDP.assignBuffer(mBuffer, 0);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
-    if (success)
-    {
-        memcpy(&mLocalID, data_buffer, sizeof(U32));
-        memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
-        memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
-        memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
-        memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
-        memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
+	if (success)
+	{
+		memcpy(&mLocalID, data, sizeof(U32));
+		memcpy(&mCRC, data + sizeof(U32), sizeof(U32));
+		memcpy(&mHitCount, data + (2 * sizeof(U32)), sizeof(S32));
+		memcpy(&mDupeCount, data + (3 * sizeof(U32)), sizeof(S32));
+		memcpy(&mCRCChangeCount, data + (4 * sizeof(U32)), sizeof(S32));
+		memcpy(&size, data + (5 * sizeof(U32)), sizeof(S32));
+		data += ENTRY_HEADER_SIZE;
 
 		// Corruption in the cache entries
-		if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
+		if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1) || (size > end - data))
 		{
 			// We've got a bogus size, skip reading it.
-			// We won't bother seeking, because the rest of this file
-			// is likely bogus, and will be tossed anyway.
+			// The rest of this file is likely bogus, and will be tossed anyway.
 			LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
 			success = FALSE;
 		}
 	}
-	if(success && size > 0)
+	if(success)
 	{
 		mBuffer = new U8[size];
-		success = check_read(apr_file, mBuffer, size);
-
-		if(success)
-		{
-			mDP.assignBuffer(mBuffer, size);
-		}
-		else
-		{
-			delete[] mBuffer ;
-			mBuffer = NULL ;
-		}
+		memcpy(mBuffer, data, size);
+		data += size;
+		mDP.assignBuffer(mBuffer, size);
 	}
+	// </FS>
 
 	if(!success)
 	{
@@ -356,6 +397,13 @@ S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
     return ENTRY_HEADER_SIZE + size;
 }
 
+// <FS> Async object cache
+S32 LLVOCacheEntry::getEntrySize() const
+{
+	return ENTRY_HEADER_SIZE + mDP.getBufferSize();
+}
+// </FS>
+
 //static 
 void LLVOCacheEntry::updateDebugSettings()
 {
@@ -1034,12 +1082,30 @@ const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
 
+// <FS> Async object cache
+// Region cache files start with this header, followed by mNumEntries
+// entries as written by LLVOCacheEntry::writeToBuffer(), mDataSize bytes in all.
+static const U32 OBJECT_CACHE_FILE_MAGIC = 0x434f5646; // "FVOC"
+static const U32 OBJECT_CACHE_FILE_VERSION = 1;
+static const char OBJECT_CACHE_QUEUE_NAME[] = "VOCacheIO";
+
+struct ObjectCacheFileHeader
+{
+	U32 mMagic;
+	U32 mVersion;
+	U8  mRegionID[UUID_BYTES];
+	S32 mNumEntries;
+	U32 mDataSize;
+};
+// </FS>
+
 
 LLVOCache::LLVOCache(bool read_only) :
 	mInitialized(false),
 	mReadOnly(read_only),
 	mNumEntries(0),
-	mCacheSize(1)
+	mCacheSize(1),
+	mIOPool(NULL) // <FS/> Async object cache
 {
 	mEnabled = gSavedSettings.getBOOL("ObjectCacheEnabled");
 	mLocalAPRFilePoolp = new LLVolatileAPRPool() ;
@@ -1047,6 +1113,15 @@ LLVOCache::LLVOCache(bool read_only) :
 
 LLVOCache::~LLVOCache()
 {
+	// <FS> Async object cache: let the pool finish its writes first
+	if (mIOPool)
+	{
+		mIOPool->close();
+		delete mIOPool;
+		mIOPool = NULL;
+	}
+	// </FS>
+
 	if(mEnabled)
 	{
 		writeCacheHeader();
@@ -1093,6 +1168,15 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
 
 	readCacheHeader();	
 
+	// <FS> Async object cache
+	U32 io_threads = gSavedSettings.getU32("FSObjectCacheThreads");
+	if (io_threads > 0 && !mIOPool)
+	{
+		mIOPool = new LL::ThreadPool(OBJECT_CACHE_QUEUE_NAME, io_threads, 1024);
+		mIOPool->start();
+	}
+	// </FS>
+
 	if( mMetaInfo.mVersion != cache_version
 		|| mMetaInfo.mAddressSize != expected_address) 
 	{
@@ -1149,6 +1233,13 @@ void LLVOCache::removeCache()
 		return ;
 	}
 
+	// <FS> Async object cache
+	{
+		LLMutexLock lock(&mPendingWritesMutex);
+		mPendingWrites.clear();
+	}
+	// </FS>
+
 	std::string mask = "*";
 	LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
 	gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask); 
@@ -1226,6 +1317,8 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 		return ;
 	}
 
+	cancelPendingWrite(entry->mHandle); // <FS/> Async object cache
+
 	std::string filename;
 	getObjectCacheFilename(entry->mHandle, filename);
 	LLAPRFile::remove(filename, mLocalAPRFilePoolp);
@@ -1394,56 +1487,214 @@ void LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		return ;
 	}
 
-	bool success = true ;
-	{
-		std::string filename;
-		LLUUID cache_id;
-		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
-	
-		success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+	// <FS> Async object cache
+	//bool success = true ;
+	//{
+		//std::string filename;
+		//LLUUID cache_id;
+		//getObjectCacheFilename(handle, filename);
+		//LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
+	//
+		//success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+	//
+		//if(success)
+		//{
+			//if(cache_id != id)
+			//{
+				//LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+				//success = false ;
+			//}
+	//
+			//if(success)
+			//{
+				//S32 num_entries;  // if removal was enabled during write num_entries might be wrong
+				//success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
+	//
+				//if(success)
+				//{
+					//for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
+					//{
+						//LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
+						//if (!entry->getLocalID())
+						//{
+							//LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+							//success = false ;
+							//break ;
+						//}
+						//cache_entry_map[entry->getLocalID()] = entry;
+					//}
+				//}
+			//}
+		//}
+	//}
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+	bool success = loadCacheFile(filename, handle, id, cache_entry_map);
+	// </FS>
 	
-		if(success)
-		{		
-			if(cache_id != id)
-			{
-				LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-				success = false ;
-			}
+	if(!success)
+	{
+		if(cache_entry_map.empty())
+		{
+			removeEntry(iter->second) ;
+		}
+	}
 
-			if(success)
-			{
-				S32 num_entries;  // if removal was enabled during write num_entries might be wrong
-				success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
+	return ;
+}
 	
-				if(success)
+// <FS> Async object cache
+bool LLVOCache::readFromCacheAsync(U64 handle, const LLUUID& id, read_callback_t callback)
+{
+	if (!mEnabled || !mIOPool)
+	{
+		return false;
+	}
+	llassert_always(mInitialized);
+
+	if (mHandleEntryMap.find(handle) == mHandleEntryMap.end()) //no cache
+	{
+		return false;
+	}
+
+	LL::WorkQueue::weak_t main_queue = LL::WorkQueue::getInstance("mainloop");
+	std::string filename;
+	getObjectCacheFilename(handle, filename);
+
+	return mIOPool->getQueue().postIfOpen(
+		[this, main_queue, filename, handle, id, callback]()
+		{
+			LLVOCacheEntry::vocache_entry_map_t cache_entry_map;
+			bool success = loadCacheFile(filename, handle, id, cache_entry_map);
+
+			// If the main loop is gone the entries simply die with this lambda
+			LL::WorkQueue::postMaybe(main_queue,
+				[handle, id, callback, success, cache_entry_map = std::move(cache_entry_map)]() mutable
 				{
-					for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
+					if (!success && cache_entry_map.empty() && LLVOCache::instanceExists())
 					{
-						LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-						if (!entry->getLocalID())
-						{
-							LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-							success = false ;
-							break ;
-						}
-						cache_entry_map[entry->getLocalID()] = entry;
+						LLVOCache::getInstance()->removeEntry(handle);
 					}
-				}
-			}
-		}		
+					callback(id, cache_entry_map);
+				});
+		});
+}
+
+//static
+bool LLVOCache::parseCacheBuffer(const U8* data, size_t size, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+{
+	ObjectCacheFileHeader header;
+	if (size < sizeof(ObjectCacheFileHeader))
+	{
+		return false;
 	}
-	
-	if(!success)
+	memcpy(&header, data, sizeof(ObjectCacheFileHeader));
+	if (header.mMagic != OBJECT_CACHE_FILE_MAGIC || header.mVersion != OBJECT_CACHE_FILE_VERSION)
 	{
-		if(cache_entry_map.empty())
+		LL_INFOS() << "Unknown object cache file format, discarding" << LL_ENDL;
+		return false;
+	}
+	if (memcmp(header.mRegionID, id.mData, UUID_BYTES) != 0)
+	{
+		LL_INFOS() << "Cache ID doesn't match for this region, discarding" << LL_ENDL;
+		return false;
+	}
+	if (header.mDataSize != size - sizeof(ObjectCacheFileHeader) || header.mNumEntries < 0)
+	{
+		LL_WARNS() << "Truncated object cache file, discarding" << LL_ENDL;
+		return false;
+	}
+
+	const U8* end = data + size;
+	data += sizeof(ObjectCacheFileHeader);
+	for (S32 i = 0; i < header.mNumEntries; i++)
+	{
+		LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(data, end);
+		if (!entry->getLocalID())
 		{
-			removeEntry(iter->second) ;
+			return false;
 		}
+		cache_entry_map[entry->getLocalID()] = entry;
 	}
+	return data == end;
+}
 
-	return ;
+bool LLVOCache::loadCacheFile(const std::string& filename, U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+{
+	bool success = false;
+
+	cache_buffer_t pending;
+	{
+		LLMutexLock lock(&mPendingWritesMutex);
+		std::map<U64, cache_buffer_t>::iterator iter = mPendingWrites.find(handle);
+		if (iter != mPendingWrites.end())
+		{
+			pending = iter->second;
+		}
+	}
+
+	if (pending)
+	{
+		// Written very recently and maybe not on disk yet
+		success = parseCacheBuffer(pending->data(), pending->size(), id, cache_entry_map);
+	}
+	else
+	{
+		LLMappedFile file;
+		if (file.open(filename, 0, false))
+		{
+			success = parseCacheBuffer(file.getData(), file.getSize(), id, cache_entry_map);
+		}
+	}
+
+	if (!success && !cache_entry_map.empty())
+	{
+		LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+	}
+	return success;
 }
+
+void LLVOCache::writeCacheFile(const std::string& filename, U64 handle, const cache_buffer_t& buffer)
+{
+	{
+		LLMutexLock lock(&mPendingWritesMutex);
+		std::map<U64, cache_buffer_t>::iterator iter = mPendingWrites.find(handle);
+		if (iter == mPendingWrites.end() || iter->second != buffer)
+		{
+			// Superseded by a newer write or removed meanwhile
+			return;
+		}
+	}
+
+	bool success = false;
+	LLFILE* fp = LLFile::fopen(filename, "wb");
+	if (fp)
+	{
+		success = fwrite(buffer->data(), 1, buffer->size(), fp) == buffer->size();
+		success = (LLFile::close(fp) == 0) && success;
+	}
+	if (!success)
+	{
+		// A partial file would be rejected by parseCacheBuffer() anyway, but
+		// without it the next read fails early and drops the header entry.
+		LL_WARNS() << "Failed to write object cache file " << filename << LL_ENDL;
+		LLFile::remove(filename, ENOENT);
+	}
+
+	LLMutexLock lock(&mPendingWritesMutex);
+	std::map<U64, cache_buffer_t>::iterator iter = mPendingWrites.find(handle);
+	if (iter != mPendingWrites.end() && iter->second == buffer)
+	{
+		mPendingWrites.erase(iter);
+	}
+}
+
+void LLVOCache::cancelPendingWrite(U64 handle)
+{
+	LLMutexLock lock(&mPendingWritesMutex);
+	mPendingWrites.erase(handle);
+}
+// </FS>
 	
 void LLVOCache::purgeEntries(U32 size)
 {
@@ -1515,64 +1766,120 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
 		return ; //nothing changed, no need to update.
 	}
 
-	//write to cache file
+	// <FS> Async object cache
+	////write to cache file
+	//bool success = true ;
+	//{
+		//std::string filename;
+		//getObjectCacheFilename(handle, filename);
+		//LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
+	//
+		//success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
+	//
+		//if(success)
+		//{
+			//S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
+			//success = check_write(&apr_file, &num_entries, sizeof(S32));
+            //if (success)
+            //{
+                //const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
+                //U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
+                //S32 size_in_buffer = 0;
+	//
+                //// This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
+                //for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
+                //{
+                    //if (!removal_enabled || iter->second->isValid())
+                    //{
+                        //S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
+	//
+                        //if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
+                        //{
+                            //size_in_buffer += size;
+                        //}
+                        //else
+                        //{
+                            //success = false;
+                            //break;
+                        //}
+	//
+                        //// Make sure we have space in buffer for next element
+                        //if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
+                        //{
+                            //success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
+                            //size_in_buffer = 0;
+                            //if (!success)
+                            //{
+                                //break;
+                            //}
+                        //}
+                    //}
+                //}
+	//
+                //if (success && size_in_buffer > 0)
+                //{
+                    //// final write
+                    //success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
+                    //size_in_buffer = 0;
+                //}
+            //}
+		//}
+	//}
+	// Build the file image here, the entries must not be touched off the
+	// main thread. Writing it out is left to the I/O pool.
+	std::shared_ptr<std::vector<U8> > buffer = std::make_shared<std::vector<U8> >();
+	size_t data_size = 0;
+	for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+	{
+		if (!removal_enabled || iter->second->isValid())
+		{
+			data_size += iter->second->getEntrySize();
+		}
+	}
+	buffer->resize(sizeof(ObjectCacheFileHeader) + data_size);
+
 	bool success = true ;
+	S32 num_entries = 0;
+	U8* data = buffer->data() + sizeof(ObjectCacheFileHeader);
+	for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
 	{
+		if (!removal_enabled || iter->second->isValid())
+		{
+			S32 size = iter->second->writeToBuffer(data);
+			if (size <= ENTRY_HEADER_SIZE) // body is minimum of 1
+			{
+				success = false;
+				break;
+			}
+			data += size;
+			++num_entries;
+		}
+	}
+
+	if (success)
+	{
+		ObjectCacheFileHeader header;
+		header.mMagic = OBJECT_CACHE_FILE_MAGIC;
+		header.mVersion = OBJECT_CACHE_FILE_VERSION;
+		memcpy(header.mRegionID, id.mData, UUID_BYTES);
+		header.mNumEntries = num_entries;
+		header.mDataSize = (U32)data_size;
+		memcpy(buffer->data(), &header, sizeof(ObjectCacheFileHeader));
+
 		std::string filename;
 		getObjectCacheFilename(handle, filename);
-		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
-	
-		success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
-	
-		if(success)
+		cache_buffer_t file_image(buffer);
+		{
+			LLMutexLock lock(&mPendingWritesMutex);
+			mPendingWrites[handle] = file_image;
+		}
+		if (!mIOPool || !mIOPool->getQueue().postIfOpen([this, filename, handle, file_image]() { writeCacheFile(filename, handle, file_image); }))
 		{
-			S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-			success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
-            {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    size_in_buffer = 0;
-                }
-            }
+			// No pool, or it has already been closed for shutdown
+			writeCacheFile(filename, handle, file_image);
 		}
 	}
+	// </FS>
 
 	if(!success)
 	{
@@ -32,6 +32,16 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+// <FS> Async object cache
+#include "llmutex.h"
+#include <functional>
+#include <memory>
+
+namespace LL
+{
+	class ThreadPool;
+}
+// </FS>
 
 //---------------------------------------------------------------------------
 // Cache entries
@@ -83,7 +93,11 @@ protected:
 	~LLVOCacheEntry();
 public:
 	LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-	LLVOCacheEntry(LLAPRFile* apr_file);
+	// <FS> Async object cache: entries are parsed from an in memory image of the cache file
+	//LLVOCacheEntry(LLAPRFile* apr_file);
+	// Reads one entry at data and advances data past it. On failure the local id is 0.
+	LLVOCacheEntry(const U8*& data, const U8* end);
+	// </FS>
 	LLVOCacheEntry();	
 
 	void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -107,6 +121,7 @@ public:
 
 	void dump() const;
 	S32 writeToBuffer(U8 *data_buffer) const;
+	S32 getEntrySize() const; // <FS/> Async object cache: bytes writeToBuffer() writes
 	LLDataPackerBinaryBuffer *getDP();
 	void recordHit();
 	void recordDupe() { mDupeCount++; }
@@ -222,6 +237,11 @@ private:
 //
 //Note: LLVOCache is not thread-safe
 //
+// <FS> Async object cache
+// Reading and writing the per region cache files is the exception: that
+// runs on a small thread pool (FSObjectCacheThreads). The header index and
+// everything else stays main thread only.
+// </FS>
 class LLVOCache : public LLParamSingleton<LLVOCache>
 {
 	LLSINGLETON(LLVOCache, bool read_only);
@@ -268,6 +288,15 @@ public:
 	void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache, bool removal_enabled);
 	void removeEntry(U64 handle) ;
 
+	// <FS> Async object cache
+	// Reads the cache file of a region on the I/O pool and hands the entries
+	// to callback on the main thread; they are empty when there was nothing
+	// usable. Returns false if nothing was posted, readFromCache() then does
+	// the work synchronously.
+	typedef std::function<void(const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)> read_callback_t;
+	bool readFromCacheAsync(U64 handle, const LLUUID& id, read_callback_t callback);
+	// </FS>
+
 	U32 getCacheEntries() { return mNumEntries; }
 	U32 getCacheEntriesMax() { return mCacheSize; }
 
@@ -283,6 +312,16 @@ private:
 	void removeEntry(HeaderEntryInfo* entry) ;
 	void purgeEntries(U32 size);
 	BOOL updateEntry(const HeaderEntryInfo* entry);
+
+	// <FS> Async object cache
+	typedef std::shared_ptr<const std::vector<U8> > cache_buffer_t;
+	// These may run on any thread.
+	static bool parseCacheBuffer(const U8* data, size_t size, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
+	bool loadCacheFile(const std::string& filename, U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
+	void writeCacheFile(const std::string& filename, U64 handle, const cache_buffer_t& buffer);
+	// Drops writes that have not started yet, e.g. for a removed entry.
+	void cancelPendingWrite(U64 handle);
+	// </FS>
 	
 private:
 	bool                 mEnabled;
@@ -296,6 +335,14 @@ private:
 	LLVolatileAPRPool*   mLocalAPRFilePoolp ; 	
 	header_entry_queue_t mHeaderEntryQueue;
 	handle_entry_map_t   mHandleEntryMap;	
+
+	// <FS> Async object cache
+	LL::ThreadPool*      mIOPool;
+	// Images of cache files posted to mIOPool and not yet on disk. Reads use
+	// these instead of the file, so they never see a stale or partial file.
+	LLMutex              mPendingWritesMutex;
+	std::map<U64, cache_buffer_t> mPendingWrites;
+	// </FS>
 };
 
 #endif
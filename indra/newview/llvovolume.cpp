@@ -94,6 +94,9 @@
 // [/RLVa:KB]
 #include "llviewernetwork.h"
 #include "fsperfstats.h" // <FS:Beq> performance stats support
+#include "fsgeometryfill.h" // <FS/> Parallel geometry rebuild
+#include "llskinningkernels.h" // <FS/> SIMD and threaded skinning
+#include "llviewerstats.h" // <FS/> Parallel geometry rebuild
 
 const F32 FORCE_SIMPLE_RENDER_AREA = 512.f;
 const F32 FORCE_CULL_AREA = 8.f;
@@ -5146,6 +5149,14 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
     const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
 
+    // <FS> SIMD and threaded skinning
+    // With the bind shape matrix in the palette every vertex is transformed
+    // once. Only the joints of the mesh are set, indices are clamped to them.
+    LLSkinningKernels::applyBindShapeMatrix(mat, maxJoints, bind_shape_matrix);
+    std::vector<FSSkinningUtil::SkinJob> skin_jobs;
+    bool has_box = false;
+    // </FS>
+
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
@@ -5182,97 +5193,169 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 
 			if (pos && dst_face.mExtents)
 			{
-                U32 max_joints = LLSkinningUtil::getMaxJointCount();
+                //U32 max_joints = LLSkinningUtil::getMaxJointCount(); // <FS/> SIMD and threaded skinning
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
 
-            #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
-                if (vol_face.mJointIndices) // fast path with preconditioned joint indices
+                // <FS> SIMD and threaded skinning
+                if (maxJoints > 0)
                 {
-                    LLMatrix4a src[4];
-                    U8* joint_indices_cursor = vol_face.mJointIndices;
-                    LLVector4a* just_weights = vol_face.mJustWeights;
-                    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        F32* w = just_weights[j].getF32ptr();
-                        LLSkinningUtil::getPerVertexSkinMatrixWithIndices(w, joint_indices_cursor, mat, final_mat, src);
-                        joint_indices_cursor += 4;
-
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
+                    FSSkinningUtil::addSkinJobs(skin_jobs, i, vol_face.mPositions, weight, pos, dst_face.mNumVertices);
                 }
-                else
-            #endif
+                else if (dst_face.mNumVertices > 0)
                 {
-				    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-				    {
-					    LLMatrix4a final_mat;
-                        // <FS:ND> Use the SSE2 version
-                        // LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
-                        FSSkinningUtil::getPerVertexSkinMatrixSSE(weight[j], mat, false, final_mat, max_joints);
-                        // </FS:ND>
-
-					    LLVector4a& v = vol_face.mPositions[j];
-					    LLVector4a t;
-					    LLVector4a dst;
-					    bind_shape_matrix.affineTransform(v, t);
-					    final_mat.affineTransform(t, dst);
-					    pos[j] = dst;
-				    }
-                }
-
-				//update bounding box
-				// VFExtents change
-				LLVector4a& min = dst_face.mExtents[0];
-				LLVector4a& max = dst_face.mExtents[1];
+                    // Nothing to skin with, but the extents are updated as before
+                    LLVector4a& min = dst_face.mExtents[0];
+                    LLVector4a& max = dst_face.mExtents[1];
+                    min = pos[0];
+                    max = pos[0];
+                    for (U32 j = 1; j < dst_face.mNumVertices; ++j)
+                    {
+                        min.setMin(min, pos[j]);
+                        max.setMax(max, pos[j]);
+                    }
+                    dst_face.mCenter->setAdd(min, max);
+                    dst_face.mCenter->mul(0.5f);
 
-				min = pos[0];
-				max = pos[1];
-                if (i==0)
-                {
-                    box_min = min;
-                    box_max = max;
+                    if (!has_box)
+                    {
+                        box_min = min;
+                        box_max = max;
+                        has_box = true;
+                    }
+                    else
+                    {
+                        box_min.setMin(min, box_min);
+                        box_max.setMax(max, box_max);
+                    }
                 }
 
-				for (U32 j = 1; j < dst_face.mNumVertices; ++j)
-				{
-					min.setMin(min, pos[j]);
-					max.setMax(max, pos[j]);
-				}
-
-                box_min.setMin(min,box_min);
-                box_max.setMax(max,box_max);
-
-				dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
-				dst_face.mCenter->mul(0.5f);
+//            #if USE_SEPARATE_JOINT_INDICES_AND_WEIGHTS
+//                if (vol_face.mJointIndices) // fast path with preconditioned joint indices
+//                {
+//                    LLMatrix4a src[4];
+//                    U8* joint_indices_cursor = vol_face.mJointIndices;
+//                    LLVector4a* just_weights = vol_face.mJustWeights;
+//                    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
+//				    {
+//					    LLMatrix4a final_mat;
+//                        F32* w = just_weights[j].getF32ptr();
+//                        LLSkinningUtil::getPerVertexSkinMatrixWithIndices(w, joint_indices_cursor, mat, final_mat, src);
+//                        joint_indices_cursor += 4;
+
+//					    LLVector4a& v = vol_face.mPositions[j];
+//					    LLVector4a t;
+//					    LLVector4a dst;
+//					    bind_shape_matrix.affineTransform(v, t);
+//					    final_mat.affineTransform(t, dst);
+//					    pos[j] = dst;
+//				    }
+//                }
+//                else
+//            #endif
+//                {
+//				    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
+//				    {
+//					    LLMatrix4a final_mat;
+//                        // <FS:ND> Use the SSE2 version
+//                        // LLSkinningUtil::getPerVertexSkinMatrix(weight[j].getF32ptr(), mat, false, final_mat, max_joints);
+//                        FSSkinningUtil::getPerVertexSkinMatrixSSE(weight[j], mat, false, final_mat, max_joints);
+//                        // </FS:ND>
+
+//					    LLVector4a& v = vol_face.mPositions[j];
+//					    LLVector4a t;
+//					    LLVector4a dst;
+//					    bind_shape_matrix.affineTransform(v, t);
+//					    final_mat.affineTransform(t, dst);
+//					    pos[j] = dst;
+//				    }
+//                }
+
+//				//update bounding box
+//				// VFExtents change
+//				LLVector4a& min = dst_face.mExtents[0];
+//				LLVector4a& max = dst_face.mExtents[1];
+
+//				min = pos[0];
+//				max = pos[1];
+//                if (i==0)
+//                {
+//                    box_min = min;
+//                    box_max = max;
+//                }
+
+//				for (U32 j = 1; j < dst_face.mNumVertices; ++j)
+//				{
+//					min.setMin(min, pos[j]);
+//					max.setMax(max, pos[j]);
+//				}
+
+//                box_min.setMin(min,box_min);
+//                box_max.setMax(max,box_max);
+
+//				dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
+//				dst_face.mCenter->mul(0.5f);
+                // </FS>
 
 			}
 
             if (rebuild_face_octrees)
 			{
                 dst_face.destroyOctree();
-				// <FS:ND> Create a debug log for octree insertions if requested.
-				static LLCachedControl<bool> debugOctree(gSavedSettings,"FSCreateOctreeLog");
-				bool _debugOT( debugOctree );
-				if( _debugOT )
-					nd::octree::debug::gOctreeDebug += 1;
-				// </FS:ND>
-
-                dst_face.createOctree();
-
-				// <FS:ND> Reset octree log
-				if( _debugOT )
-					nd::octree::debug::gOctreeDebug -= 1;
-				// </FS:ND>
+				// <FS> Lazy rigged face octrees
+				// The first raycast that gets to the face creates it again
+				//// <FS:ND> Create a debug log for octree insertions if requested.
+				//static LLCachedControl<bool> debugOctree(gSavedSettings,"FSCreateOctreeLog");
+				//bool _debugOT( debugOctree );
+				//if( _debugOT )
+				//	nd::octree::debug::gOctreeDebug += 1;
+				//// </FS:ND>
+
+                //dst_face.createOctree();
+
+				//// <FS:ND> Reset octree log
+				//if( _debugOT )
+				//	nd::octree::debug::gOctreeDebug -= 1;
+				//// </FS:ND>
+				// </FS>
 			}
 		}
 	}
+
+    // <FS> SIMD and threaded skinning
+    FSSkinningUtil::runSkinJobs(skin_jobs, mat, maxJoints);
+
+    // Face extents from those of their stretches, which are in face order
+    for (size_t j = 0; j < skin_jobs.size(); )
+    {
+        const S32 face = skin_jobs[j].mFace;
+        LLVector4a min = skin_jobs[j].mExtents[0];
+        LLVector4a max = skin_jobs[j].mExtents[1];
+        for (++j; j < skin_jobs.size() && skin_jobs[j].mFace == face; ++j)
+        {
+            min.setMin(min, skin_jobs[j].mExtents[0]);
+            max.setMax(max, skin_jobs[j].mExtents[1]);
+        }
+
+        LLVolumeFace& dst_face = mVolumeFaces[face];
+        dst_face.mExtents[0] = min;
+        dst_face.mExtents[1] = max;
+        dst_face.mCenter->setAdd(min, max);
+        dst_face.mCenter->mul(0.5f);
+
+        if (!has_box)
+        {
+            box_min = min;
+            box_max = max;
+            has_box = true;
+        }
+        else
+        {
+            box_min.setMin(min, box_min);
+            box_max.setMax(max, box_max);
+        }
+    }
+    // </FS>
     mExtraDebugText = llformat("rigged %d/%d - box (%f %f %f) (%f %f %f)",
                                rigged_face_count, rigged_vert_count,
                                box_min[0], box_min[1], box_min[2],
@@ -5387,6 +5470,10 @@ LLFace** LLVolumeGeometryManager::sNormFaces[2] = { NULL };
 LLFace** LLVolumeGeometryManager::sSpecFaces[2] = { NULL };
 LLFace** LLVolumeGeometryManager::sNormSpecFaces[2] = { NULL };
 LLFace** LLVolumeGeometryManager::sAlphaFaces[2] = { NULL };
+// <FS> Parallel geometry rebuild
+FSGeometryFill LLVolumeGeometryManager::sGeometryFill;
+bool LLVolumeGeometryManager::sUseGeometryFill = false;
+// </FS>
 
 LLVolumeGeometryManager::LLVolumeGeometryManager()
 	: LLGeometryManager()
@@ -5841,6 +5928,8 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 	}
 
 	group->mBuilt = 1.f;
+
+	LLTimer rebuild_timer; // <FS/> Parallel geometry rebuild
 	
 	LLSpatialBridge* bridge = group->getSpatialPartition()->asBridge();
     LLViewerObject *vobj = NULL;
@@ -6309,6 +6398,10 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 
 	U32 geometryBytes = 0;
 
+	// <FS> Parallel geometry rebuild
+	sUseGeometryFill = !LLPipeline::sDelayVBUpdate && FSGeometryFill::isEnabled();
+	// </FS>
+
     // generate render batches for static geometry
     U32 extra_mask = LLVertexBuffer::MAP_TEXTURE_INDEX;
     BOOL alpha_sort = TRUE;
@@ -6330,6 +6423,14 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 
 	group->mGeometryBytes = geometryBytes;
 
+	// <FS> Parallel geometry rebuild
+	if (sUseGeometryFill)
+	{
+		record(LLStatViewer::GROUP_REBUILD_THREADED_FACES, (F64)sGeometryFill.run());
+		sUseGeometryFill = false;
+	}
+	// </FS>
+
 	if (!LLPipeline::sDelayVBUpdate)
 	{
 		//drawables have been rebuilt, clear rebuild status
@@ -6352,6 +6453,7 @@ void LLVolumeGeometryManager::rebuildGeom(LLSpatialGroup* group)
 		group->setState(LLSpatialGroup::MESH_DIRTY | LLSpatialGroup::NEW_DRAWINFO);
 	}
 
+	record(LLStatViewer::GROUP_REBUILD_TIME, F64Seconds(rebuild_timer.getElapsedTimeF64())); // <FS/> Parallel geometry rebuild
 }
 
 void LLVolumeGeometryManager::rebuildMesh(LLSpatialGroup* group)
@@ -6866,6 +6968,13 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 				//for debugging, set last time face was updated vs moved
 				facep->updateRebuildFlags();
 
+				// <FS> Parallel geometry rebuild
+				if (sUseGeometryFill)
+				{ //rebuildGeom() copies face geometry into vertex buffer
+					sGeometryFill.addFace(facep);
+				}
+				else
+				// </FS>
 				if (!LLPipeline::sDelayVBUpdate)
 				{ //copy face geometry into vertex buffer
 					LLDrawable* drawablep = facep->getDrawable();
@@ -7185,7 +7294,13 @@ U32 LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFace
 			++face_iter;
 		}
 
-		if (buffer)
+		// <FS> Parallel geometry rebuild
+		if (buffer && sUseGeometryFill)
+		{ //rebuildGeom() fills and flushes buffer
+			sGeometryFill.addBuffer(buffer);
+		}
+		else if (buffer)
+		// </FS>
 		{
 			buffer->flush();
 		}
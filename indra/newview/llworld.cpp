@@ -1246,6 +1246,18 @@ void LLWorld::updateNetStats()
 	add(LLStatViewer::PACKETS_OUT, packets_out);
 	add(LLStatViewer::PACKETS_LOST, packets_lost);
 
+	// <FS> Batched UDP receive
+	U32 receive_batches = 0;
+	U32 batched_packets = 0;
+	F64 batch_seconds = 0.0;
+	gMessageSystem->mPacketRing.getAndResetBatchStats(receive_batches, batched_packets, batch_seconds);
+	if (receive_batches)
+	{
+		record(LLStatViewer::PACKETS_PER_RECEIVE_BATCH, (F64)batched_packets / (F64)receive_batches);
+		record(LLStatViewer::RECEIVE_BATCH_TIME, F64Seconds(batch_seconds / (F64)receive_batches));
+	}
+	// </FS>
+
 	F32 total_packets_in = LLViewerStats::instance().getRecording().getSum(LLStatViewer::PACKETS_IN);
 	if (total_packets_in > 0)
 	{
@@ -120,6 +120,7 @@
 #include "rlvlocks.h"
 // [/RLVa:KB]
 #include "exopostprocess.h" // <FS:CR> Import Vignette from Exodus
+#include "fsoctreeprecull.h" // <FS/> Parallel cull
 
 #include "llenvironment.h"
 
@@ -2565,6 +2566,28 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, LLPlane* pla
 		}
 		mCubeVB->setBuffer(LLVertexBuffer::MAP_VERTEX);
 	}
+
+	// <FS> Parallel cull
+	static LLCachedControl<bool> parallel_cull(gSavedSettings, "FSParallelOctreeCull");
+	if (parallel_cull)
+	{
+		std::vector<LLSpatialPartition*> partitions;
+		for (LLWorld::region_list_t::const_iterator iter = world.getRegionList().begin();
+			 iter != world.getRegionList().end(); ++iter)
+		{
+			LLViewerRegion* region = *iter;
+			for (U32 i = 0; i < LLViewerRegion::NUM_PARTITIONS; i++)
+			{
+				LLSpatialPartition* part = region->getSpatialPartition(i);
+				if (part && (!hud_attachments ? LLViewerRegion::PARTITION_BRIDGE == i || hasRenderType(part->mDrawableType) : hasRenderType(part->mDrawableType)))
+				{
+					partitions.push_back(part);
+				}
+			}
+		}
+		LLViewerOctreeCull::sPrecullPass = FSOctreePrecull::run(camera, partitions);
+	}
+	// </FS>
 	
 	for (LLWorld::region_list_t::const_iterator iter = world.getRegionList().begin(); // <FS:Ansariel> Factor out instance() call
 			iter != world.getRegionList().end(); ++iter)
@@ -2592,6 +2615,8 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result, LLPlane* pla
 		}
 	}
 
+	LLViewerOctreeCull::sPrecullPass = 0; // <FS/> Parallel cull
+
 	if (bound_shader)
 	{
 		gOcclusionCubeProgram.unbind();
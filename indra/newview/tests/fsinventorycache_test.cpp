@@ -0,0 +1,402 @@
+/**
+ * @file fsinventorycache_test.cpp
+ * @brief Test cases for the binary inventory cache file
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+// Dependencies
+#include "linden_common.h"
+#include "llevents.h"
+#include "llfile.h"
+#include "threadpool.h"
+#include "../llviewerinventory.h"
+// Class to test
+#include "../fsinventorycache.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include <vector>
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: Declarations required to link and run the class being tested
+// Notes:
+// * The viewer inventory classes only need to construct and hand back what
+//   LLInventoryItem and LLInventoryCategory store.
+
+namespace
+{
+	const S32 INV_CACHE_VERSION = 2;
+}
+
+const S32 LLInventoryModel::sCurrentInvCacheVersion = INV_CACHE_VERSION;
+
+LLViewerInventoryItem::LLViewerInventoryItem(const LLUUID& uuid, const LLUUID& parent_uuid, const LLPermissions& permissions,
+											 const LLUUID& asset_uuid, LLAssetType::EType type, LLInventoryType::EType inv_type,
+											 const std::string& name, const std::string& desc, const LLSaleInfo& sale_info,
+											 U32 flags, time_t creation_date_utc) :
+	LLInventoryItem(uuid, parent_uuid, permissions, asset_uuid, type, inv_type, name, desc, sale_info, flags, (S32)creation_date_utc),
+	mIsComplete(TRUE)
+{
+}
+LLViewerInventoryItem::~LLViewerInventoryItem() { }
+LLAssetType::EType LLViewerInventoryItem::getType() const { return LLInventoryItem::getType(); }
+const LLUUID& LLViewerInventoryItem::getAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const LLUUID& LLViewerInventoryItem::getProtectedAssetUUID() const { return LLInventoryItem::getAssetUUID(); }
+const std::string& LLViewerInventoryItem::getName() const { return LLInventoryItem::getName(); }
+S32 LLViewerInventoryItem::getSortField() const { return 0; }
+void LLViewerInventoryItem::getSLURL() { }
+const LLPermissions& LLViewerInventoryItem::getPermissions() const { return LLInventoryItem::getPermissions(); }
+const bool LLViewerInventoryItem::getIsFullPerm() const { return false; }
+const LLUUID& LLViewerInventoryItem::getCreatorUUID() const { return LLInventoryItem::getCreatorUUID(); }
+const std::string& LLViewerInventoryItem::getDescription() const { return LLInventoryItem::getDescription(); }
+const LLSaleInfo& LLViewerInventoryItem::getSaleInfo() const { return LLInventoryItem::getSaleInfo(); }
+LLInventoryType::EType LLViewerInventoryItem::getInventoryType() const { return LLInventoryItem::getInventoryType(); }
+bool LLViewerInventoryItem::isWearableType() const { return false; }
+LLWearableType::EType LLViewerInventoryItem::getWearableType() const { return LLWearableType::WT_INVALID; }
+bool LLViewerInventoryItem::isSettingsType() const { return false; }
+LLSettingsType::type_e LLViewerInventoryItem::getSettingsType() const { return LLSettingsType::ST_NONE; }
+U32 LLViewerInventoryItem::getFlags() const { return LLInventoryItem::getFlags(); }
+time_t LLViewerInventoryItem::getCreationDate() const { return LLInventoryItem::getCreationDate(); }
+U32 LLViewerInventoryItem::getCRC32() const { return 0; }
+void LLViewerInventoryItem::copyItem(const LLInventoryItem* other) { }
+void LLViewerInventoryItem::updateParentOnServer(BOOL restamp) const { }
+void LLViewerInventoryItem::updateServer(BOOL is_new) const { }
+void LLViewerInventoryItem::packMessage(LLMessageSystem* msg) const { }
+BOOL LLViewerInventoryItem::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { return FALSE; }
+BOOL LLViewerInventoryItem::unpackMessage(const LLSD& item) { return FALSE; }
+BOOL LLViewerInventoryItem::importLegacyStream(std::istream& input_stream) { return FALSE; }
+void LLViewerInventoryItem::setTransactionID(const LLTransactionID& transaction_id) { }
+
+LLViewerInventoryCategory::LLViewerInventoryCategory(const LLUUID& uuid, const LLUUID& parent_uuid, LLFolderType::EType pref,
+													 const std::string& name, const LLUUID& owner_id) :
+	LLInventoryCategory(uuid, parent_uuid, pref, name),
+	mOwnerID(owner_id),
+	mVersion(LLViewerInventoryCategory::VERSION_UNKNOWN),
+	mDescendentCount(LLViewerInventoryCategory::DESCENDENT_COUNT_UNKNOWN)
+{
+}
+LLViewerInventoryCategory::~LLViewerInventoryCategory() { }
+void LLViewerInventoryCategory::updateParentOnServer(BOOL restamp_children) const { }
+void LLViewerInventoryCategory::updateServer(BOOL is_new) const { }
+void LLViewerInventoryCategory::packMessage(LLMessageSystem* msg) const { }
+void LLViewerInventoryCategory::unpackMessage(LLMessageSystem* msg, const char* block, S32 block_num) { }
+BOOL LLViewerInventoryCategory::unpackMessage(const LLSD& category) { return FALSE; }
+S32 LLViewerInventoryCategory::getVersion() const { return mVersion; }
+void LLViewerInventoryCategory::setVersion(S32 version) { mVersion = version; }
+
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+	// Offsets into the file, see CacheHeader and CategoryRecord
+	const size_t OFFSET_MAGIC = 0;
+	const size_t OFFSET_FORMAT_VERSION = 4;
+	const size_t OFFSET_INV_CACHE_VERSION = 8;
+	const size_t OFFSET_CATEGORY_COUNT = 12;
+	const size_t OFFSET_FIRST_CATEGORY_NAME = 24 + 48 + 4;
+
+	struct inventory_cache_test
+	{
+		inventory_cache_test()
+		{
+			LLUUID id;
+			id.generate();
+			mFilename = std::string(LLFile::tmpdir()) + "fsinventorycache_test_" + id.asString() + ".bin";
+		}
+
+		~inventory_cache_test()
+		{
+			LLFile::remove(mFilename, ENOENT);
+			if (mPool)
+			{
+				mPool->close();
+				mPool.reset();
+				// The pool never unregisters its shutdown listener
+				LLEventPumps::instance().obtain("LLApp").stopListening("ThreadPool:General");
+			}
+		}
+
+		LLPointer<LLViewerInventoryCategory> makeCategory(const std::string& name, S32 version)
+		{
+			LLUUID id;
+			LLUUID parent_id;
+			id.generate();
+			parent_id.generate();
+			LLPointer<LLViewerInventoryCategory> cat =
+				new LLViewerInventoryCategory(id, parent_id, LLFolderType::FT_OBJECT, name, mOwnerID);
+			cat->setVersion(version);
+			return cat;
+		}
+
+		LLPointer<LLViewerInventoryItem> makeItem(const std::string& name, LLAssetType::EType type, LLInventoryType::EType inv_type)
+		{
+			LLUUID id;
+			LLUUID parent_id;
+			LLUUID asset_id;
+			LLUUID creator_id;
+			LLUUID last_owner_id;
+			LLUUID group_id;
+			id.generate();
+			parent_id.generate();
+			asset_id.generate();
+			creator_id.generate();
+			last_owner_id.generate();
+			group_id.generate();
+
+			LLPermissions perm;
+			perm.init(creator_id, mOwnerID, last_owner_id, group_id);
+			perm.initMasks(PERM_ALL, PERM_ALL, PERM_COPY, PERM_NONE, PERM_MOVE | PERM_TRANSFER);
+			LLSaleInfo sale_info(LLSaleInfo::FS_COPY, 42);
+			return new LLViewerInventoryItem(id, parent_id, perm, asset_id, type, inv_type, name, name + " description",
+											 sale_info, 0x12345, 1650000000);
+		}
+
+		// Patches a 32 bit field of the saved file
+		void patchFile(size_t offset, U32 value)
+		{
+			std::vector<U8> data = readFile();
+			ensure("patched field in file", offset + sizeof(U32) <= data.size());
+			memcpy(&data[offset], &value, sizeof(U32));
+			writeFile(data);
+		}
+
+		std::vector<U8> readFile()
+		{
+			std::vector<U8> data;
+			LLFILE* fp = LLFile::fopen(mFilename, "rb");
+			ensure("file opened", fp != NULL);
+			U8 buffer[4096];
+			size_t read;
+			while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+			{
+				data.insert(data.end(), buffer, buffer + read);
+			}
+			fclose(fp);
+			return data;
+		}
+
+		void writeFile(const std::vector<U8>& data)
+		{
+			LLFILE* fp = LLFile::fopen(mFilename, "wb");
+			ensure("file opened", fp != NULL);
+			ensure("file written", data.empty() || fwrite(&data[0], 1, data.size(), fp) == data.size());
+			fclose(fp);
+		}
+
+		// A damaged file loads nothing, not even part of the records
+		void ensureRejected(const std::string& msg)
+		{
+			LLInventoryModel::cat_array_t categories;
+			LLInventoryModel::item_array_t items;
+			LLInventoryModel::changed_items_t cats_to_update;
+			ensure(msg + " rejected", !FSInventoryCache::load(mFilename, categories, items, cats_to_update));
+			ensure(msg + " no categories", categories.empty());
+			ensure(msg + " no items", items.empty());
+			ensure(msg + " no categories to update", cats_to_update.empty());
+		}
+
+		std::string mFilename;
+		LLUUID mOwnerID;
+		LL::ThreadPool::ptr_t mPool;
+	};
+
+	typedef test_group<inventory_cache_test> inventory_cache_t;
+	typedef inventory_cache_t::object inventory_cache_object_t;
+	tut::inventory_cache_t tut_inventory_cache("FSInventoryCache");
+
+	template<> template<>
+	void inventory_cache_object_t::test<1>()
+	{
+		set_test_name("save and load round trip");
+
+		mOwnerID.generate();
+		LLInventoryModel::cat_array_t saved_categories;
+		saved_categories.push_back(makeCategory("Objects", 7));
+		saved_categories.push_back(makeCategory("Not fetched", LLViewerInventoryCategory::VERSION_UNKNOWN));
+		saved_categories.push_back(makeCategory("", LLViewerInventoryCategory::VERSION_INITIAL));
+
+		LLInventoryModel::item_array_t saved_items;
+		saved_items.push_back(makeItem("Box", LLAssetType::AT_OBJECT, LLInventoryType::IT_OBJECT));
+		saved_items.push_back(makeItem("Notecard \xC3\xA4", LLAssetType::AT_NOTECARD, LLInventoryType::IT_NOTECARD));
+		LLPointer<LLViewerInventoryItem> unknown = makeItem("Unknown", LLAssetType::AT_UNKNOWN, LLInventoryType::IT_NONE);
+		saved_items.push_back(unknown);
+
+		ensure("saved", FSInventoryCache::save(mFilename, saved_categories, saved_items));
+		ensure("no temp file left", !LLFile::isfile(mFilename + ".tmp"));
+
+		LLInventoryModel::cat_array_t categories;
+		LLInventoryModel::item_array_t items;
+		LLInventoryModel::changed_items_t cats_to_update;
+		ensure("loaded", FSInventoryCache::load(mFilename, categories, items, cats_to_update));
+
+		// The category of unknown version is not saved
+		ensure_equals("category count", categories.size(), (size_t)2);
+		const LLViewerInventoryCategory* const expected_categories[] = { saved_categories[0], saved_categories[2] };
+		for (size_t i = 0; i < categories.size(); ++i)
+		{
+			const LLViewerInventoryCategory* expected = expected_categories[i];
+			const LLViewerInventoryCategory* cat = categories[i];
+			ensure_equals("category id", cat->getUUID(), expected->getUUID());
+			ensure_equals("category parent", cat->getParentUUID(), expected->getParentUUID());
+			ensure_equals("category owner", cat->getOwnerID(), expected->getOwnerID());
+			ensure_equals("category name", cat->getName(), expected->getName());
+			ensure_equals("category version", cat->getVersion(), expected->getVersion());
+			ensure_equals("category type", cat->getType(), expected->getType());
+			ensure_equals("category preferred type", cat->getPreferredType(), expected->getPreferredType());
+		}
+
+		// The item of unknown type is not loaded, its folder needs a fetch
+		ensure_equals("item count", items.size(), (size_t)2);
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			const LLViewerInventoryItem* expected = saved_items[i];
+			const LLViewerInventoryItem* item = items[i];
+			ensure_equals("item id", item->getUUID(), expected->getUUID());
+			ensure_equals("item parent", item->getParentUUID(), expected->getParentUUID());
+			ensure_equals("item asset", item->getAssetUUID(), expected->getAssetUUID());
+			ensure_equals("item name", item->getName(), expected->getName());
+			ensure_equals("item description", item->getDescription(), expected->getDescription());
+			ensure_equals("item type", item->getType(), expected->getType());
+			ensure_equals("item inventory type", item->getInventoryType(), expected->getInventoryType());
+			ensure_equals("item flags", item->getFlags(), expected->getFlags());
+			ensure_equals("item creation date", item->getCreationDate(), expected->getCreationDate());
+			ensure("item permissions", item->getPermissions() == expected->getPermissions());
+			ensure("item sale info", item->getSaleInfo() == expected->getSaleInfo());
+			ensure("item complete", item->mIsComplete);
+		}
+		ensure_equals("categories to update", cats_to_update.size(), (size_t)1);
+		ensure("unknown item parent", cats_to_update.count(unknown->getParentUUID()) == 1);
+
+		// Saving over an existing cache replaces it
+		saved_items.pop_back();
+		ensure("saved again", FSInventoryCache::save(mFilename, saved_categories, saved_items));
+		items.clear();
+		cats_to_update.clear();
+		ensure("loaded again", FSInventoryCache::load(mFilename, categories, items, cats_to_update));
+		ensure_equals("categories appended", categories.size(), (size_t)4);
+		ensure_equals("item count again", items.size(), (size_t)2);
+		ensure("nothing to update", cats_to_update.empty());
+	}
+
+	template<> template<>
+	void inventory_cache_object_t::test<2>()
+	{
+		set_test_name("load split over the General pool keeps the record order");
+
+		mPool = std::make_shared<LL::ThreadPool>("General", 3);
+		mPool->start();
+
+		mOwnerID.generate();
+		LLInventoryModel::cat_array_t saved_categories;
+		for (S32 i = 0; i < 5000; ++i)
+		{
+			saved_categories.push_back(makeCategory(llformat("Folder %d", i), i + 1));
+		}
+		LLInventoryModel::item_array_t saved_items;
+		for (S32 i = 0; i < 7000; ++i)
+		{
+			saved_items.push_back(makeItem(llformat("Item %d", i), LLAssetType::AT_OBJECT, LLInventoryType::IT_OBJECT));
+		}
+		ensure("saved", FSInventoryCache::save(mFilename, saved_categories, saved_items));
+
+		LLInventoryModel::cat_array_t categories;
+		LLInventoryModel::item_array_t items;
+		LLInventoryModel::changed_items_t cats_to_update;
+		ensure("loaded", FSInventoryCache::load(mFilename, categories, items, cats_to_update));
+		ensure_equals("category count", categories.size(), saved_categories.size());
+		ensure_equals("item count", items.size(), saved_items.size());
+		for (size_t i = 0; i < categories.size(); ++i)
+		{
+			ensure_equals("category order", categories[i]->getUUID(), saved_categories[i]->getUUID());
+			ensure_equals("category name", categories[i]->getName(), saved_categories[i]->getName());
+		}
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			ensure_equals("item order", items[i]->getUUID(), saved_items[i]->getUUID());
+			ensure_equals("item name", items[i]->getName(), saved_items[i]->getName());
+		}
+	}
+
+	template<> template<>
+	void inventory_cache_object_t::test<3>()
+	{
+		set_test_name("damaged or outdated files are rejected");
+
+		ensureRejected("missing file");
+
+		mOwnerID.generate();
+		LLInventoryModel::cat_array_t saved_categories;
+		saved_categories.push_back(makeCategory("Objects", 7));
+		saved_categories.push_back(makeCategory("Textures", 3));
+		LLInventoryModel::item_array_t saved_items;
+		saved_items.push_back(makeItem("Box", LLAssetType::AT_OBJECT, LLInventoryType::IT_OBJECT));
+		ensure("saved", FSInventoryCache::save(mFilename, saved_categories, saved_items));
+		const std::vector<U8> good = readFile();
+
+		writeFile(std::vector<U8>(good.begin(), good.begin() + 12));
+		ensureRejected("short header");
+
+		writeFile(good);
+		patchFile(OFFSET_MAGIC, 0);
+		ensureRejected("magic");
+
+		writeFile(good);
+		// The previous format
+		patchFile(OFFSET_FORMAT_VERSION, 1);
+		ensureRejected("format version");
+
+		writeFile(good);
+		patchFile(OFFSET_INV_CACHE_VERSION, INV_CACHE_VERSION + 1);
+		ensureRejected("inventory cache version");
+
+		writeFile(std::vector<U8>(good.begin(), good.end() - 1));
+		ensureRejected("truncated");
+
+		std::vector<U8> longer(good);
+		longer.push_back(0);
+		writeFile(longer);
+		ensureRejected("trailing byte");
+
+		writeFile(good);
+		patchFile(OFFSET_CATEGORY_COUNT, 3);
+		ensureRejected("category count");
+
+		writeFile(good);
+		patchFile(OFFSET_FIRST_CATEGORY_NAME, 0xFFFFFFFF);
+		ensureRejected("name offset");
+
+		// The untouched file still loads
+		writeFile(good);
+		LLInventoryModel::cat_array_t categories;
+		LLInventoryModel::item_array_t items;
+		LLInventoryModel::changed_items_t cats_to_update;
+		ensure("good file loaded", FSInventoryCache::load(mFilename, categories, items, cats_to_update));
+		ensure_equals("good file categories", categories.size(), (size_t)2);
+		ensure_equals("good file items", items.size(), (size_t)1);
+	}
+}
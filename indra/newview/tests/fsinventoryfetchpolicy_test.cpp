@@ -0,0 +1,103 @@
+/**
+ * @file fsinventoryfetchpolicy_test.cpp
+ * @brief Test cases for the pipelined background inventory fetch scheduling
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+// Dependencies
+#include "linden_common.h"
+// Class to test
+#include "../fsinventoryfetchpolicy.h"
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+	struct fetch_policy_test
+	{
+	};
+
+	typedef test_group<fetch_policy_test> fetch_policy_t;
+	typedef fetch_policy_t::object fetch_policy_object_t;
+	tut::fetch_policy_t tut_fetch_policy("FSInventoryFetchPolicy");
+
+	template<> template<>
+	void fetch_policy_object_t::test<1>()
+	{
+		set_test_name("window and batch size are clamped");
+
+		FSInventoryFetchPolicy defaults(16, 30);
+		ensure_equals("default window", defaults.getWindow(), 16);
+		ensure_equals("default batch size", defaults.getBatchSize(), 30U);
+
+		// 0 would never send anything
+		FSInventoryFetchPolicy zero(0, 0);
+		ensure_equals("zero window", zero.getWindow(), 1);
+		ensure_equals("zero batch size", zero.getBatchSize(), 1U);
+
+		// Values that do not fit an S32 must not wrap to a negative window
+		FSInventoryFetchPolicy large(U32_MAX, U32_MAX);
+		ensure_equals("large window", large.getWindow(), FSInventoryFetchPolicy::MAX_WINDOW);
+		ensure_equals("large batch size", large.getBatchSize(), FSInventoryFetchPolicy::MAX_BATCH_SIZE);
+	}
+
+	template<> template<>
+	void fetch_policy_object_t::test<2>()
+	{
+		set_test_name("batches are sent until the window is full");
+
+		FSInventoryFetchPolicy policy(4, 30);
+		ensure("nothing in flight", policy.canSend(0));
+		ensure("window not full", policy.canSend(3));
+		ensure("window full", !policy.canSend(4));
+		ensure("window overfull", !policy.canSend(12));
+
+		// A window of one sends one batch at a time
+		FSInventoryFetchPolicy single(1, 30);
+		ensure("single in flight", !single.canSend(1));
+		ensure("single idle", single.canSend(0));
+	}
+
+	template<> template<>
+	void fetch_policy_object_t::test<3>()
+	{
+		set_test_name("outfit folders are fetched first");
+
+		ensure("current outfit", FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_CURRENT_OUTFIT));
+		ensure("my outfits", FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_MY_OUTFITS));
+		ensure("outfit", FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_OUTFIT));
+		ensure("body parts", FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_BODYPART));
+		ensure("clothing", FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_CLOTHING));
+
+		ensure("none", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_NONE));
+		ensure("objects", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_OBJECT));
+		ensure("textures", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_TEXTURE));
+		ensure("trash", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_TRASH));
+		ensure("root", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_ROOT_INVENTORY));
+		ensure("inbox", !FSInventoryFetchPolicy::isPriorityFolder(LLFolderType::FT_INBOX));
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ * @file fsinventoryfilterchange_test.cpp
+ * @brief Test cases for the classification of inventory filter string edits
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+// Dependencies
+#include "linden_common.h"
+// Class to test
+#include "../fsinventoryfilterchange.h"
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+	struct filter_change_test
+	{
+		void ensureChange(const std::string& old_string, const std::string& new_string, FSInventoryFilterChange::EChange expected)
+		{
+			ensure_equals("\"" + old_string + "\" -> \"" + new_string + "\"",
+						  (S32)FSInventoryFilterChange::classify(old_string, new_string), (S32)expected);
+		}
+	};
+
+	typedef test_group<filter_change_test> filter_change_t;
+	typedef filter_change_t::object filter_change_object_t;
+	tut::filter_change_t tut_filter_change("FSInventoryFilterChange");
+
+	template<> template<>
+	void filter_change_object_t::test<1>()
+	{
+		set_test_name("plain searches");
+
+		// Typing at the end, as before
+		ensureChange("", "H", FSInventoryFilterChange::MORE_RESTRICTIVE);
+		ensureChange("HA", "HAT", FSInventoryFilterChange::MORE_RESTRICTIVE);
+		ensureChange("HAT", "HA", FSInventoryFilterChange::LESS_RESTRICTIVE);
+		ensureChange("HAT", "", FSInventoryFilterChange::LESS_RESTRICTIVE);
+
+		// Typing or deleting anywhere else keeps the old string inside the new one
+		ensureChange("HAT", "RED HAT", FSInventoryFilterChange::MORE_RESTRICTIVE);
+		ensureChange("RED HAT", "ED HA", FSInventoryFilterChange::LESS_RESTRICTIVE);
+		ensureChange("RED HAT", "HAT", FSInventoryFilterChange::LESS_RESTRICTIVE);
+
+		// Nothing in common, or an edit inside the string
+		ensureChange("HAT", "SHOE", FSInventoryFilterChange::UNRELATED);
+		ensureChange("HAT", "HUT", FSInventoryFilterChange::UNRELATED);
+		ensureChange("RED HAT", "RED CAT", FSInventoryFilterChange::UNRELATED);
+		ensureChange("RD HAT", "RED HAT", FSInventoryFilterChange::UNRELATED);
+	}
+
+	template<> template<>
+	void filter_change_object_t::test<2>()
+	{
+		set_test_name("token and exact searches only follow edits at the end");
+
+		ensureChange("HAT+", "HAT+RED", FSInventoryFilterChange::MORE_RESTRICTIVE);
+		ensureChange("HAT+RED", "HAT+", FSInventoryFilterChange::LESS_RESTRICTIVE);
+		ensureChange("HAT", "HAT+RED", FSInventoryFilterChange::MORE_RESTRICTIVE);
+
+		// Edits before the end start the filter over
+		ensureChange("HAT", "RED+HAT", FSInventoryFilterChange::UNRELATED);
+		ensureChange("RED+HAT", "HAT", FSInventoryFilterChange::UNRELATED);
+		ensureChange("\"HAT\"", "\"RED HAT\"", FSInventoryFilterChange::UNRELATED);
+		ensureChange("\"RED HAT\"", "HAT", FSInventoryFilterChange::UNRELATED);
+		ensureChange("\"HAT", "\"HAT\"", FSInventoryFilterChange::MORE_RESTRICTIVE);
+	}
+}
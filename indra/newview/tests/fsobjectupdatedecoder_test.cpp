@@ -0,0 +1,380 @@
+/**
+ * @file fsobjectupdatedecoder_test.cpp
+ * @brief Test cases for the ordering of staged object updates
+ *
+ * $LicenseInfo:firstyear=2022&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2022, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+// Dependencies
+#include "linden_common.h"
+#include "lldatapacker.h"
+#include "llevents.h"
+#include "llmessagetemplate.h"
+#include "message.h"
+#include "workqueue.h"
+#include "../llviewerobject.h"
+#include "../llviewerobjectlist.h"
+#include "../llviewerregion.h"
+#include "../llviewerstatsrecorder.h"
+#include "../llvoavatar.h"
+#include "../llworld.h"
+// Class to test
+#include "../fsobjectupdatedecoder.h"
+// Tut header
+#include "../test/lltut.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: Declarations required to link and run the class being tested
+// Notes:
+// * The message system stubs serve one fake message, sMessage, set up by the tests.
+// * The region stubs record what reaches the object cache in sApplied, in order.
+// * LLViewerRegion and LLMessageSystem are never constructed here: the stubbed
+//   methods below don't touch the object they are called on.
+
+namespace
+{
+	// One ObjectData block of the fake ObjectUpdateCompressed or ObjectUpdateCached
+	struct FakeBlock
+	{
+		U32				mLocalID;
+		U32				mCRC;
+		U32				mFlags;
+		std::vector<U8>	mData;
+	};
+
+	struct FakeMessage
+	{
+		U64						mRegionHandle;
+		std::vector<FakeBlock>	mBlocks;
+	};
+	FakeMessage sMessage;
+	LLMessageSystem* const sMessageSystem = reinterpret_cast<LLMessageSystem*>(&sMessage);
+
+	// What the decoder applied, and the terse updates and kills the tests handled
+	// around it, in the order it happened: 'F' full update cached, 'C' cache probe,
+	// 'T' terse update, 'K' kill.
+	struct AppliedEntry
+	{
+		char	mType;
+		U32		mLocalID;
+	};
+	std::vector<AppliedEntry> sApplied;
+
+	char sRegion;
+	LLViewerRegion* const sRegionp = reinterpret_cast<LLViewerRegion*>(&sRegion);
+	const U64 REGION_HANDLE = 0x0000040000000400ull;
+
+	// Layout of the fake packed object data
+	const S32 OFFSET_ID = 0;
+	const S32 OFFSET_LOCAL_ID = 16;
+	const S32 OFFSET_PCODE = 20;
+	const S32 OFFSET_CRC = 21;
+	const S32 OFFSET_SPECIAL_CODE = 25;
+	const S32 OFFSET_PARENT_ID = 29;
+	const S32 OFFSET_SCALE = 33;
+	const S32 OFFSET_POS = 45;
+	const S32 OFFSET_ROT = 57;
+	const S32 OBJECT_DATA_SIZE = 69;
+}
+
+char const* const _PREHASH_ObjectUpdateCompressed = "ObjectUpdateCompressed";
+char const* const _PREHASH_ObjectUpdateCached = "ObjectUpdateCached";
+char const* const _PREHASH_ObjectData = "ObjectData";
+char const* const _PREHASH_RegionData = "RegionData";
+char const* const _PREHASH_RegionHandle = "RegionHandle";
+char const* const _PREHASH_Data = "Data";
+char const* const _PREHASH_UpdateFlags = "UpdateFlags";
+char const* const _PREHASH_ID = "ID";
+char const* const _PREHASH_CRC = "CRC";
+
+LLMessageSlot LLMessageSystem::getMessageSlotFast(const char *msgname, const char *blockname, const char *varname) const
+{
+	LLMessageSlot slot;
+	slot.mVarName = const_cast<char*>(varname);
+	return slot;
+}
+S32 LLMessageSystem::getNumberOfBlocksFast(const char *blockname) const { return (S32)sMessage.mBlocks.size(); }
+void LLMessageSystem::getU64Fast(const char *block, const char *var, U64 &data, S32 blocknum) { data = sMessage.mRegionHandle; }
+S32 LLMessageSystem::getSizeFast(const LLMessageSlot& slot, S32 blocknum) const { return (S32)sMessage.mBlocks[blocknum].mData.size(); }
+void LLMessageSystem::getU32Fast(const LLMessageSlot& slot, U32 &data, S32 blocknum)
+{
+	const FakeBlock& block = sMessage.mBlocks[blocknum];
+	data = slot.mVarName == _PREHASH_UpdateFlags ? block.mFlags : (slot.mVarName == _PREHASH_CRC ? block.mCRC : block.mLocalID);
+}
+void LLMessageSystem::getBinaryDataFast(const LLMessageSlot& slot, void *datap, S32 size, S32 blocknum, S32 max_size)
+{
+	memcpy(datap, sMessage.mBlocks[blocknum].mData.data(), llmin(size, max_size));
+}
+
+S32 LLViewerObject::getObjectDataOffset(const std::string& name)
+{
+	if (name == "ID") return OFFSET_ID;
+	if (name == "LocalID") return OFFSET_LOCAL_ID;
+	if (name == "PCode") return OFFSET_PCODE;
+	if (name == "CRC") return OFFSET_CRC;
+	if (name == "SpecialCode") return OFFSET_SPECIAL_CODE;
+	if (name == "ParentID") return OFFSET_PARENT_ID;
+	if (name == "Scale") return OFFSET_SCALE;
+	if (name == "Pos") return OFFSET_POS;
+	if (name == "Rot") return OFFSET_ROT;
+	return -1;
+}
+
+LLPatchVertexArray::LLPatchVertexArray() { }
+LLPatchVertexArray::~LLPatchVertexArray() { }
+LLWorld::LLWorld() { }
+LLViewerRegion* LLWorld::getRegionFromHandle(const U64 &handle) { return handle == REGION_HANDLE ? sRegionp : NULL; }
+
+LLViewerRegion::eCacheUpdateResult LLViewerRegion::cacheFullUpdate(LLDataPackerBinaryBuffer &dp, U32 flags, U32 local_id, U32 crc, const FSObjectExtents* extents)
+{
+	AppliedEntry entry = { 'F', local_id };
+	sApplied.push_back(entry);
+	return CACHE_UPDATE_ADDED;
+}
+const LLUUID& LLViewerRegion::getRegionID() const { return LLUUID::null; }
+bool LLViewerRegion::probeCache(U32 local_id, U32 crc, U32 flags, U8 &cache_miss_type)
+{
+	AppliedEntry entry = { 'C', local_id };
+	sApplied.push_back(entry);
+	return true;
+}
+
+LLViewerStatsRecorder::LLViewerStatsRecorder() { }
+LLViewerStatsRecorder::~LLViewerStatsRecorder() { }
+
+void LLVOAvatar::cullAvatarsByPixelArea() { }
+
+LLDebugBeacon::~LLDebugBeacon() { }
+LLViewerObjectList::LLViewerObjectList() { mNumNewObjects = 0; }
+LLViewerObjectList::~LLViewerObjectList() { }
+LLViewerObjectList gObjectList;
+S32 gFullObjectUpdates = 0;
+void update_attached_sounds() { }
+
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+namespace tut
+{
+	// Keeps the decode thread busy, so staged batches stay unclaimed until released
+	struct DecodeThreadGate
+	{
+		DecodeThreadGate() : mBlocked(0), mOpened(0) { }
+
+		void block()
+		{
+			U32 generation = mOpened + 1;
+			LL::WorkQueue::getInstance("ObjectUpdateDecode")->post([this, generation]()
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mBlocked = generation;
+					mCondition.notify_all();
+					mCondition.wait(lock, [this, generation]() { return mOpened >= generation; });
+				});
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this, generation]() { return mBlocked == generation; });
+		}
+
+		void open()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mOpened = mBlocked;
+			mCondition.notify_all();
+		}
+
+		std::mutex				mMutex;
+		std::condition_variable	mCondition;
+		U32						mBlocked;
+		U32						mOpened;
+	};
+
+	struct decoder_test
+	{
+		decoder_test()
+		{
+			if (!LLWorld::instanceExists())
+			{
+				LLWorld::createInstance();
+			}
+			sApplied.clear();
+			FSObjectUpdateDecoder::instance().initThreads(1);
+		}
+
+		~decoder_test()
+		{
+			mGate.open();
+			FSObjectUpdateDecoder::instance().cleanup();
+			// The pool never unregisters its shutdown listener, the next test's pool reuses the name
+			LLEventPumps::instance().obtain("LLApp").stopListening("ThreadPool:ObjectUpdateDecode");
+		}
+
+		// Stages an ObjectUpdateCompressed with one object per local id
+		void stageCompressed(const std::vector<U32>& local_ids)
+		{
+			sMessage.mRegionHandle = REGION_HANDLE;
+			sMessage.mBlocks.clear();
+			for (U32 local_id : local_ids)
+			{
+				FakeBlock block = { local_id, local_id * 3, 0 };
+				block.mData.resize(OBJECT_DATA_SIZE);
+				LLDataPackerBinaryBuffer dp(block.mData.data(), OBJECT_DATA_SIZE);
+				LLUUID id;
+				id.generate();
+				dp.shift(OFFSET_ID);
+				dp.packUUID(id, "ID");
+				dp.shift(OFFSET_LOCAL_ID);
+				dp.packU32(local_id, "LocalID");
+				dp.shift(OFFSET_PCODE);
+				dp.packU8(LL_PCODE_VOLUME, "PCode");
+				dp.shift(OFFSET_CRC);
+				dp.packU32(block.mCRC, "CRC");
+				dp.shift(OFFSET_SPECIAL_CODE);
+				dp.packU32(0, "SpecialCode");
+				dp.shift(OFFSET_SCALE);
+				dp.packVector3(LLVector3(1.f, 1.f, 1.f), "Scale");
+				dp.shift(OFFSET_POS);
+				dp.packVector3(LLVector3(128.f, 128.f, 20.f), "Pos");
+				dp.shift(OFFSET_ROT);
+				dp.packVector3(LLVector3::zero, "Rot");
+				sMessage.mBlocks.push_back(block);
+			}
+			ensure("compressed update staged", FSObjectUpdateDecoder::instance().stageCompressedUpdate(sMessageSystem));
+		}
+
+		// Stages an ObjectUpdateCached with one probe per local id
+		void stageCached(const std::vector<U32>& local_ids)
+		{
+			sMessage.mRegionHandle = REGION_HANDLE;
+			sMessage.mBlocks.clear();
+			for (U32 local_id : local_ids)
+			{
+				FakeBlock block = { local_id, local_id * 3, 0 };
+				sMessage.mBlocks.push_back(block);
+			}
+			ensure("cached update staged", FSObjectUpdateDecoder::instance().stageCachedUpdate(sMessageSystem));
+		}
+
+		// What process_terse_object_update_improved() and process_kill_object() do
+		// before they touch any object
+		void handleTerseUpdate(U32 local_id)
+		{
+			FSObjectUpdateDecoder::instance().flush();
+			AppliedEntry entry = { 'T', local_id };
+			sApplied.push_back(entry);
+		}
+
+		void handleKill(U32 local_id)
+		{
+			FSObjectUpdateDecoder::instance().flush();
+			AppliedEntry entry = { 'K', local_id };
+			sApplied.push_back(entry);
+		}
+
+		std::string appliedString() const
+		{
+			std::string res;
+			for (const AppliedEntry& entry : sApplied)
+			{
+				res += llformat("%c%u ", entry.mType, entry.mLocalID);
+			}
+			return res;
+		}
+
+		DecodeThreadGate mGate;
+	};
+
+	typedef test_group<decoder_test> decoder_t;
+	typedef decoder_t::object decoder_object_t;
+	tut::decoder_t tut_decoder("FSObjectUpdateDecoder");
+
+	template<> template<>
+	void decoder_object_t::test<1>()
+	{
+		// A terse update and a kill see every update staged before them, in
+		// arrival order, although the decode thread never got to them.
+		mGate.block();
+		stageCompressed({ 1, 2 });
+		stageCached({ 3 });
+		handleTerseUpdate(2);
+		stageCompressed({ 4 });
+		handleKill(1);
+		ensure_equals("applied in order", appliedString(), std::string("F1 F2 C3 T2 F4 K1 "));
+		ensure_equals("queue drained", FSObjectUpdateDecoder::instance().getQueuedBatches(), size_t(0));
+	}
+
+	template<> template<>
+	void decoder_object_t::test<2>()
+	{
+		// applyReady() stops at the first batch that is not decoded yet, even
+		// when the batches behind it are ready.
+		mGate.block();
+		stageCompressed({ 1 });
+		stageCached({ 2 });
+		FSObjectUpdateDecoder::instance().applyReady(1.f);
+		ensure_equals("nothing applied out of order", appliedString(), std::string(""));
+		ensure_equals("both still queued", FSObjectUpdateDecoder::instance().getQueuedBatches(), size_t(2));
+
+		handleKill(1);
+		ensure_equals("kill after the staged updates", appliedString(), std::string("F1 C2 K1 "));
+	}
+
+	template<> template<>
+	void decoder_object_t::test<3>()
+	{
+		// A batch big enough that the decode thread is usually still busy with it
+		// when the kill comes in. flush() does not wait for it, and the order
+		// holds all the same.
+		std::string expected;
+		U32 local_id = 1;
+		for (S32 round = 0; round < 20; ++round)
+		{
+			mGate.block();
+			std::vector<U32> local_ids;
+			for (S32 i = 0; i < 32768; ++i, ++local_id)
+			{
+				local_ids.push_back(local_id);
+				expected += llformat("F%u ", local_id);
+			}
+			stageCompressed(local_ids);
+			stageCached({ local_id });
+			expected += llformat("C%u ", local_id);
+
+			// Give the decode thread time to pick it up
+			mGate.open();
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+			handleKill(local_id);
+			expected += llformat("K%u ", local_id);
+			++local_id;
+		}
+		// Not ensure_equals(), the strings are megabytes long
+		ensure_equals("all applied", sApplied.size(), size_t(20 * 32770));
+		ensure("applied in order", appliedString() == expected);
+	}
+}